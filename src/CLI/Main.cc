@@ -0,0 +1,131 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <iostream>
+#include <string>
+#include <QCoreApplication>
+#include <QThread>
+#include <QThreadPool>
+
+#include "Core/Batch/BatchJob.h"
+#include "Core/Batch/BatchJobImporter.h"
+#include "Core/Project/ProjectImporter.h"
+#include "Core/Utils/Trace.h"
+#include "Core/Version.h"
+
+/**
+ * Headless batch processing of a degate project.
+ *
+ * Usage: degate-cli [--threads N] [--progress-interval MS] [--trace FILE] <project> <job-script>
+ *
+ * The job script is run on the project (@see degate::BatchJobImporter). Progress is
+ * written to stdout as one JSON object per line. Results are only saved, if the job
+ * contains a save stage.
+ */
+
+namespace
+{
+    void print_usage()
+    {
+        std::cerr << "Degate " << DEGATE_VERSION << " batch processing\n\n"
+                  << "Usage: degate-cli [options] <project> <job-script>\n\n"
+                  << "Options:\n"
+                  << "  --threads N              Number of worker threads (default: all cores).\n"
+                  << "  --progress-interval MS   Interval between progress reports (default: 1000).\n"
+                  << "  --trace FILE             Record a trace of the run into FILE (Chrome trace format).\n";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    int threads = QThread::idealThreadCount();
+    unsigned int progress_interval = 1000;
+    std::string project_path;
+    std::string job_path;
+    std::string trace_path;
+
+    try
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string arg(argv[i]);
+
+            if (arg == "--threads" && i + 1 < argc) threads = std::stoi(argv[++i]);
+            else if (arg == "--progress-interval" && i + 1 < argc) progress_interval = std::stoul(argv[++i]);
+            else if (arg == "--trace" && i + 1 < argc) trace_path = argv[++i];
+            else if (arg == "--help" || arg == "-h")
+            {
+                print_usage();
+                return EXIT_SUCCESS;
+            }
+            else if (project_path.empty()) project_path = arg;
+            else if (job_path.empty()) job_path = arg;
+            else
+            {
+                print_usage();
+                return EXIT_FAILURE;
+            }
+        }
+    }
+    catch (const std::exception&)
+    {
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    if (project_path.empty() || job_path.empty() || threads < 1)
+    {
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    QThreadPool::globalInstance()->setMaxThreadCount(threads);
+
+    if (!trace_path.empty()) degate::Trace::get_instance().set_enabled(true);
+
+    try
+    {
+        degate::BatchJobImporter job_importer;
+        degate::BatchJob_shptr job = job_importer.import(job_path);
+        job->set_progress_interval(progress_interval);
+
+        degate::ProjectImporter project_importer;
+        degate::Project_shptr project = project_importer.import_all(project_path);
+        if (project == nullptr)
+        {
+            std::cerr << "Can't load the project " << project_path << "." << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        const bool success = job->run(project, std::cout);
+
+        if (!trace_path.empty()) degate::Trace::get_instance().export_chrome_trace(trace_path);
+
+        return success ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
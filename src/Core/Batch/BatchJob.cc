@@ -0,0 +1,341 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/Batch/BatchJob.h"
+#include "Core/Matching/ViaMatching.h"
+#include "Core/Matching/WireMatching.h"
+#include "Core/Matching/TemplateMatching.h"
+#include "Core/LogicModel/LogicModelHelper.h"
+#include "Core/RuleCheck/RuleChecker.h"
+#include "Core/Generator/VerilogModuleGenerator.h"
+#include "Core/Project/ProjectExporter.h"
+#include "Core/Utils/DegateExceptions.h"
+#include "Core/Utils/DegateHelper.h"
+#include "Core/Utils/FileSystem.h"
+
+#include <set>
+#include <chrono>
+#include <future>
+#include <sstream>
+#include <fstream>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+
+using namespace degate;
+
+namespace
+{
+    /**
+     * Write a single JSON event line.
+     */
+    void write_event(std::ostream& out, std::string const& event, std::string const& members)
+    {
+        out << "{\"event\": " << json_string(event);
+        if (!members.empty()) out << ", " << members;
+        out << "}" << std::endl;
+    }
+
+    std::string stage_members(BatchStage const& stage, unsigned int index)
+    {
+        return "\"stage\": " + std::to_string(index) + ", \"type\": " + json_string(stage.get_type());
+    }
+
+    template <typename T>
+    T get_number(BatchStage const& stage, std::string const& name, T default_value)
+    {
+        if (!stage.has_parameter(name)) return default_value;
+
+        try
+        {
+            return boost::lexical_cast<T>(stage.get_parameter(name));
+        }
+        catch (boost::bad_lexical_cast const&)
+        {
+            throw DegateRuntimeException("Invalid value for parameter '" + name + "' of stage " + stage.get_type() + ".");
+        }
+    }
+
+    /**
+     * Make the layer of a stage the current layer and return it.
+     */
+    Layer_shptr select_layer(BatchStage const& stage, LogicModel_shptr lmodel)
+    {
+        if (stage.has_parameter("layer"))
+        {
+            const layer_position_t pos = get_number<layer_position_t>(stage, "layer", 0);
+            if (pos >= lmodel->get_num_layers())
+                throw DegateRuntimeException("There is no layer " + stage.get_parameter("layer") + ".");
+
+            lmodel->set_current_layer(pos);
+        }
+
+        Layer_shptr layer = lmodel->get_current_layer();
+        if (layer == nullptr) throw DegateRuntimeException("There is no current layer.");
+
+        return layer;
+    }
+
+    std::list<Gate::ORIENTATION> parse_orientations(BatchStage const& stage)
+    {
+        const std::string orientation = stage.get_parameter("orientations", "any");
+
+        if (orientation == "any")
+            return { Gate::ORIENTATION_NORMAL, Gate::ORIENTATION_FLIPPED_UP_DOWN,
+                     Gate::ORIENTATION_FLIPPED_LEFT_RIGHT, Gate::ORIENTATION_FLIPPED_BOTH };
+        else if (orientation == "normal") return { Gate::ORIENTATION_NORMAL };
+        else if (orientation == "flipped-left-right") return { Gate::ORIENTATION_FLIPPED_LEFT_RIGHT };
+        else if (orientation == "flipped-up-down") return { Gate::ORIENTATION_FLIPPED_UP_DOWN };
+        else if (orientation == "flipped-both") return { Gate::ORIENTATION_FLIPPED_BOTH };
+
+        throw DegateRuntimeException("Invalid orientation '" + orientation + "'.");
+    }
+
+    std::list<GateTemplate_shptr> parse_templates(BatchStage const& stage, GateLibrary_shptr glib)
+    {
+        std::list<GateTemplate_shptr> templates;
+        const std::string templates_str = stage.get_parameter("templates", "all");
+
+        if (templates_str == "all")
+        {
+            for (auto iter = glib->begin(); iter != glib->end(); ++iter) templates.push_back(iter->second);
+            return templates;
+        }
+
+        std::vector<std::string> ids;
+        boost::split(ids, templates_str, boost::is_any_of(", "), boost::token_compress_on);
+
+        for (auto const& id : ids)
+        {
+            if (id.empty()) continue;
+
+            try
+            {
+                templates.push_back(glib->get_template(boost::lexical_cast<object_id_t>(id)));
+            }
+            catch (boost::bad_lexical_cast const&)
+            {
+                throw DegateRuntimeException("Invalid gate template ID '" + id + "'.");
+            }
+        }
+
+        return templates;
+    }
+}
+
+BatchJob::BatchJob() : progress_interval(1000)
+{
+}
+
+bool BatchJob::is_valid_stage_type(std::string const& type)
+{
+    static const std::set<std::string> types = { "via-matching", "wire-matching", "template-matching",
+                                                 "autoconnect", "rule-check", "verilog-export", "save" };
+
+    return types.find(type) != types.end();
+}
+
+void BatchJob::add_stage(BatchStage const& stage)
+{
+    if (!is_valid_stage_type(stage.get_type()))
+        throw DegateRuntimeException("Unknown batch stage: " + stage.get_type());
+
+    stages.push_back(stage);
+}
+
+bool BatchJob::run(Project_shptr prj, std::ostream& out) const
+{
+    if (prj == nullptr) throw InvalidPointerException("Invalid pointer for parameter prj.");
+
+    write_event(out, "job-start", "\"project\": " + json_string(prj->get_project_directory()) +
+                                  ", \"stages\": " + std::to_string(stages.size()));
+
+    unsigned int index = 0;
+    for (auto const& stage : stages)
+    {
+        index++;
+        write_event(out, "stage-start", stage_members(stage, index));
+
+        const auto start = std::chrono::steady_clock::now();
+
+        try
+        {
+            std::string results = run_stage(stage, index, prj, out);
+
+            std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+            write_event(out, "stage-end", stage_members(stage, index) +
+                                          ", \"seconds\": " + std::to_string(seconds.count()) +
+                                          (results.empty() ? "" : ", " + results));
+        }
+        catch (std::exception const& e)
+        {
+            write_event(out, "error", stage_members(stage, index) + ", \"message\": " + json_string(e.what()));
+            write_event(out, "job-end", "\"success\": false");
+            return false;
+        }
+    }
+
+    write_event(out, "job-end", "\"success\": true");
+    return true;
+}
+
+void BatchJob::run_with_progress(std::function<void()> job, std::shared_ptr<ProgressControl> progress,
+                                 BatchStage const& stage, unsigned int index, std::ostream& out) const
+{
+    std::future<void> result = std::async(std::launch::async, job);
+
+    while (result.wait_for(std::chrono::milliseconds(progress_interval)) != std::future_status::ready)
+    {
+        std::ostringstream members;
+        members << stage_members(stage, index)
+                << ", \"progress\": " << progress->get_progress()
+                << ", \"time-passed\": " << progress->get_time_passed()
+                << ", \"time-left\": " << progress->get_time_left();
+
+        write_event(out, "progress", members.str());
+    }
+
+    // Rethrow exceptions of the job.
+    result.get();
+}
+
+std::string BatchJob::run_stage(BatchStage const& stage, unsigned int index, Project_shptr prj, std::ostream& out) const
+{
+    LogicModel_shptr lmodel = prj->get_logic_model();
+    if (lmodel == nullptr) throw DegateRuntimeException("The project has no logic model.");
+
+    const std::string& type = stage.get_type();
+
+    if (type == "via-matching")
+    {
+        select_layer(stage, lmodel);
+
+        auto matching = std::make_shared<ViaMatching>();
+        matching->set_diameter(get_number<unsigned int>(stage, "diameter", prj->get_default_via_diameter()));
+        matching->set_merge_n_vias(get_number<unsigned int>(stage, "merge-n-vias", 0));
+        matching->set_threshold_match(get_number<double>(stage, "threshold", 0.95));
+
+        run_with_progress([matching, prj]()
+                          {
+                              matching->init(prj->get_bounding_box(), prj);
+                              matching->run();
+                          }, matching, stage, index, out);
+    }
+    else if (type == "wire-matching")
+    {
+        select_layer(stage, lmodel);
+
+        auto matching = std::make_shared<WireMatching>();
+        matching->set_wire_diameter(get_number<unsigned int>(stage, "wire-diameter", 4));
+        matching->set_median_filter_width(get_number<unsigned int>(stage, "median-filter-width", 3));
+        matching->set_sigma(get_number<double>(stage, "sigma", 0.5));
+        matching->set_min_edge_magnitude(get_number<double>(stage, "min-edge-magnitude", 0.25));
+
+        run_with_progress([matching, prj]()
+                          {
+                              matching->init(prj->get_bounding_box(), prj);
+                              matching->run();
+                          }, matching, stage, index, out);
+    }
+    else if (type == "template-matching")
+    {
+        Layer_shptr layer = select_layer(stage, lmodel);
+
+        TemplateMatching_shptr matching;
+        const std::string mode = stage.get_parameter("mode", "normal");
+
+        if (mode == "normal") matching = std::make_shared<TemplateMatchingNormal>();
+        else if (mode == "rows") matching = std::make_shared<TemplateMatchingInRows>();
+        else if (mode == "cols") matching = std::make_shared<TemplateMatchingInCols>();
+        else throw DegateRuntimeException("Invalid template matching mode '" + mode + "'.");
+
+        std::list<GateTemplate_shptr> templates = parse_templates(stage, lmodel->get_gate_library());
+        if (templates.empty()) throw DegateRuntimeException("There is no gate template for template matching.");
+
+        matching->set_threshold_hc(get_number<double>(stage, "threshold-hc", 0.40));
+        matching->set_threshold_detection(get_number<double>(stage, "threshold-detection", 0.70));
+        matching->set_max_step_size(get_number<unsigned int>(stage, "max-step-size",
+                                                             std::max<length_t>(1, prj->get_lambda() >> 1u)));
+        matching->set_scaling_factor(get_number<unsigned int>(stage, "scaling-factor", 1));
+        matching->set_templates(templates);
+        matching->set_orientations(parse_orientations(stage));
+        matching->set_layers(layer, get_first_logic_layer(lmodel));
+
+        run_with_progress([matching, prj]()
+                          {
+                              matching->init(prj->get_bounding_box(), prj);
+                              matching->run();
+                          }, matching, stage, index, out);
+    }
+    else if (type == "autoconnect")
+    {
+        std::list<Layer_shptr> layers;
+
+        if (stage.has_parameter("layer")) layers.push_back(select_layer(stage, lmodel));
+        else
+            for (auto iter = lmodel->layers_begin(); iter != lmodel->layers_end(); ++iter)
+                layers.push_back(*iter);
+
+        for (auto& layer : layers)
+        {
+            autoconnect_objects(lmodel, layer, prj->get_bounding_box());
+            autoconnect_interlayer_objects(lmodel, layer, prj->get_bounding_box());
+        }
+    }
+    else if (type == "rule-check")
+    {
+        RuleChecker rule_checker;
+        rule_checker.run(lmodel);
+
+        unsigned int violations = 0;
+        for (auto& violation : rule_checker.get_rc_violations())
+            if (!prj->get_rcv_blacklist().contains(violation)) violations++;
+
+        return "\"violations\": " + std::to_string(violations);
+    }
+    else if (type == "verilog-export")
+    {
+        const std::string default_name = prj->get_name().empty() ? "design" : prj->get_name();
+        const std::string filename = join_pathes(prj->get_project_directory(),
+                                                 stage.get_parameter("output", default_name + ".v"));
+        const std::string tmp_filename = filename + ".tmp";
+
+        {
+            std::ofstream file(tmp_filename.c_str(), std::ios::trunc | std::ios::out);
+            if (!file.is_open()) throw InvalidPathException("Can't write to " + tmp_filename + ".");
+
+            VerilogModuleGenerator code_generator(lmodel->get_main_module());
+            code_generator.generate(file);
+
+            if (!file.good()) throw DegateRuntimeException("Can't write to " + tmp_filename + ".");
+        }
+
+        move_file(tmp_filename, filename);
+
+        return "\"output\": " + json_string(filename);
+    }
+    else if (type == "save")
+    {
+        ProjectExporter exporter;
+        exporter.export_atomic(prj->get_project_directory(), prj);
+    }
+
+    return "";
+}
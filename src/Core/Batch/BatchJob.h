@@ -0,0 +1,162 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __BATCHJOB_H__
+#define __BATCHJOB_H__
+
+#include "Globals.h"
+#include "Core/Project/Project.h"
+#include "Core/Utils/ProgressControl.h"
+
+#include <map>
+#include <list>
+#include <string>
+#include <memory>
+#include <ostream>
+#include <functional>
+
+namespace degate
+{
+    /**
+     * A single stage of a batch job, e.g. a via matching.
+     */
+    class BatchStage
+    {
+    public:
+
+        typedef std::map<std::string, std::string> parameter_map;
+
+    private:
+
+        std::string type;
+        parameter_map parameters;
+
+    public:
+
+        BatchStage(std::string const& type, parameter_map const& parameters = parameter_map()) :
+            type(type), parameters(parameters)
+        {
+        }
+
+        std::string const& get_type() const { return type; }
+        parameter_map const& get_parameters() const { return parameters; }
+
+        /**
+         * Check if a parameter is set.
+         */
+        bool has_parameter(std::string const& name) const
+        {
+            return parameters.find(name) != parameters.end();
+        }
+
+        /**
+         * Get a parameter.
+         * @return Returns the parameter or \p default_value, if the parameter is not set.
+         */
+        std::string get_parameter(std::string const& name, std::string const& default_value = "") const
+        {
+            auto found = parameters.find(name);
+            return found == parameters.end() ? default_value : found->second;
+        }
+    };
+
+
+    /**
+     * A batch job runs a list of processing stages on a project without user interaction.
+     *
+     * Supported stages are:
+     * - via-matching: parameters layer, diameter, merge-n-vias, threshold.
+     * - wire-matching: parameters layer, wire-diameter, median-filter-width, sigma, min-edge-magnitude.
+     * - template-matching: parameters layer, mode (normal, rows or cols), templates (all or
+     *   a comma separated list of template IDs), orientations (any, normal, flipped-left-right,
+     *   flipped-up-down or flipped-both), threshold-hc, threshold-detection, max-step-size,
+     *   scaling-factor.
+     * - autoconnect: parameter layer. Without layer, all layers are connected.
+     * - rule-check: runs all rule checks.
+     * - verilog-export: parameter output, relative to the project directory.
+     * - save: saves the project atomically.
+     *
+     * Matching stages work on the whole layer. If no layer is given, the current layer is used.
+     *
+     * Progress is written as one JSON object per line.
+     *
+     * @see BatchJobImporter
+     */
+    class BatchJob
+    {
+    public:
+
+        typedef std::list<BatchStage> stage_list;
+
+    private:
+
+        stage_list stages;
+        unsigned int progress_interval;
+
+    public:
+
+        BatchJob();
+
+        /**
+         * Append a stage.
+         * @exception DegateRuntimeException This exception is thrown, if the stage type is unknown.
+         */
+        void add_stage(BatchStage const& stage);
+
+        stage_list const& get_stages() const { return stages; }
+
+        /**
+         * Set the interval between progress reports in milliseconds.
+         */
+        void set_progress_interval(unsigned int progress_interval) { this->progress_interval = progress_interval; }
+
+        /**
+         * Run all stages. The job stops on the first stage, that fails.
+         * @param prj The project to work on.
+         * @param out The stream to write the progress to.
+         * @return Returns true, if all stages succeeded.
+         */
+        bool run(Project_shptr prj, std::ostream& out) const;
+
+        /**
+         * Check if a stage type is known.
+         */
+        static bool is_valid_stage_type(std::string const& type);
+
+    private:
+
+        /**
+         * Run a single stage.
+         * @return Returns a JSON object member list with the results (e.g. "\"violations\": 3"), that may be empty.
+         */
+        std::string run_stage(BatchStage const& stage, unsigned int index, Project_shptr prj, std::ostream& out) const;
+
+        /**
+         * Run a job in another thread and report the progress until it is finished.
+         */
+        void run_with_progress(std::function<void()> job, std::shared_ptr<ProgressControl> progress,
+                               BatchStage const& stage, unsigned int index, std::ostream& out) const;
+    };
+
+    typedef std::shared_ptr<BatchJob> BatchJob_shptr;
+}
+
+#endif
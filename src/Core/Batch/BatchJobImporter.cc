@@ -0,0 +1,84 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/Batch/BatchJobImporter.h"
+
+#include <iostream>
+
+using namespace degate;
+
+BatchJob_shptr BatchJobImporter::import(std::string const& filename)
+{
+    if (RET_IS_NOT_OK(check_file(filename)))
+    {
+        debug(TM, "Problem: file %s not found.", filename.c_str());
+        throw InvalidPathException("Can't load batch job from file.");
+    }
+
+    QFile file(QString::fromStdString(filename));
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        debug(TM, "Problem: can't open the file %s.", filename.c_str());
+        throw InvalidFileFormatException("The BatchJobImporter cannot load the job file. Can't open the file.");
+    }
+
+    const QByteArray content = file.readAll();
+    file.close();
+
+    return import_from_string(content.toStdString());
+}
+
+BatchJob_shptr BatchJobImporter::import_from_string(std::string const& content)
+{
+    QDomDocument parser;
+
+    if (!parser.setContent(QString::fromStdString(content)))
+    {
+        debug(TM, "Problem: can't parse the batch job.");
+        throw InvalidXMLException("The BatchJobImporter cannot parse the job.");
+    }
+
+    const QDomElement root_elem = parser.documentElement();
+    if (root_elem.isNull() || root_elem.tagName() != "batch-job")
+        throw InvalidXMLException("The batch job has no batch-job element.");
+
+    BatchJob_shptr job = std::make_shared<BatchJob>();
+    parse_stages(root_elem, job);
+
+    return job;
+}
+
+void BatchJobImporter::parse_stages(QDomElement const job_elem, BatchJob_shptr job)
+{
+    for (QDomElement e = job_elem.firstChildElement(); !e.isNull(); e = e.nextSiblingElement())
+    {
+        BatchStage::parameter_map parameters;
+
+        const QDomNamedNodeMap attributes = e.attributes();
+        for (int i = 0; i < attributes.count(); i++)
+        {
+            const QDomAttr attribute = attributes.item(i).toAttr();
+            parameters[attribute.name().toStdString()] = attribute.value().toStdString();
+        }
+
+        job->add_stage(BatchStage(e.tagName().toStdString(), parameters));
+    }
+}
@@ -0,0 +1,83 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __BATCHJOBIMPORTER_H__
+#define __BATCHJOBIMPORTER_H__
+
+#include "Globals.h"
+#include "Core/Batch/BatchJob.h"
+#include "Core/XML/XMLImporter.h"
+
+namespace degate
+{
+    /**
+     * The BatchJobImporter reads a batch job script.
+     *
+     * A job script lists the stages in the order they are run. Each element is a stage,
+     * its attributes are the stage parameters:
+     *
+     * @code
+     * <batch-job>
+     *   <via-matching layer="2" threshold="0.9"/>
+     *   <template-matching layer="0" templates="all" orientations="any"/>
+     *   <autoconnect/>
+     *   <rule-check/>
+     *   <verilog-export output="netlist.v"/>
+     *   <save/>
+     * </batch-job>
+     * @endcode
+     *
+     * @see BatchJob
+     */
+    class BatchJobImporter : public XMLImporter
+    {
+    private:
+
+        void parse_stages(QDomElement const job_elem, BatchJob_shptr job);
+
+    public:
+
+        BatchJobImporter()
+        {
+        }
+
+        ~BatchJobImporter()
+        {
+        }
+
+        /**
+         * Import a job script from a file.
+         * @exception InvalidPathException
+         * @exception InvalidXMLException
+         * @exception DegateRuntimeException This exception is thrown, if a stage is unknown.
+         */
+        BatchJob_shptr import(std::string const& filename);
+
+        /**
+         * Import a job script from a string.
+         * @exception InvalidXMLException
+         * @exception DegateRuntimeException This exception is thrown, if a stage is unknown.
+         */
+        BatchJob_shptr import_from_string(std::string const& content);
+    };
+}
+
+#endif
@@ -93,7 +93,7 @@ void LogicModelDOTExporter::export_data(std::string const& filename, LogicModel_
         {
             PlacedLogicModelObject_shptr o = (*iter).second;
 
-            if (Gate_shptr gate = std::dynamic_pointer_cast<Gate>(o))
+            if (Gate_shptr gate = object_kind_cast<Gate>(o))
             {
                 // check if the gate should be rendered
                 //if (accept_gate_for_output)
@@ -102,7 +102,7 @@ void LogicModelDOTExporter::export_data(std::string const& filename, LogicModel_
 
             else if (properties[ENABLE_VIAS])
             {
-                if (Via_shptr via = std::dynamic_pointer_cast<Via>(o))
+                if (Via_shptr via = object_kind_cast<Via>(o))
                     add_via(via);
             }
 
@@ -23,7 +23,14 @@
 #include "Core/Generator/VerilogModuleGenerator.h"
 #include <boost/format.hpp>
 #include <boost/foreach.hpp>
-#include <boost/algorithm/string/join.hpp>
+#include <boost/range/counting_range.hpp>
+#include <QThread>
+#include <QtConcurrent/QtConcurrent>
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <sstream>
 
 using namespace boost;
 using namespace degate;
@@ -51,33 +58,28 @@ VerilogModuleGenerator::~VerilogModuleGenerator()
 }
 
 
-std::string VerilogModuleGenerator::generate_common_code_for_gates(Module_shptr module,
-                                                                   std::set<GateTemplate_shptr>& already_dumped) const
+void VerilogModuleGenerator::write_gate_templates(std::ostream& os, Module_shptr module,
+                                                  std::set<GateTemplate_shptr>& already_dumped) const
 {
-    std::string common_code;
-
-    if (!no_gates)
+    for (Module::gate_collection::const_iterator iter = module->gates_begin();
+         iter != module->gates_end(); ++iter)
     {
-        for (Module::gate_collection::const_iterator iter = module->gates_begin();
-             iter != module->gates_end(); ++iter)
-        {
-            Gate_shptr gate = *iter;
+        Gate_shptr gate = *iter;
 
-            if (GateTemplate_shptr gtmpl = gate->get_gate_template())
+        if (GateTemplate_shptr gtmpl = gate->get_gate_template())
+        {
+            if (already_dumped.find(gtmpl) == already_dumped.end())
             {
-                if (already_dumped.find(gtmpl) == already_dumped.end())
+                try
+                {
+                    os << gtmpl->get_implementation(GateTemplate::VERILOG);
+                }
+                catch (CollectionLookupException const&)
                 {
-                    try
-                    {
-                        common_code += gtmpl->get_implementation(GateTemplate::VERILOG);
-                    }
-                    catch (CollectionLookupException const&)
-                    {
-                        // maybe we should pass the exception?
-                        common_code += "// Error: failed to lookup Verilog implementation for module " + gtmpl->get_name() + ".\n\n";
-                    }
-                    already_dumped.insert(gtmpl);
+                    // maybe we should pass the exception?
+                    os << "// Error: failed to lookup Verilog implementation for module " << gtmpl->get_name() << ".\n\n";
                 }
+                already_dumped.insert(gtmpl);
             }
         }
     }
@@ -86,39 +88,154 @@ std::string VerilogModuleGenerator::generate_common_code_for_gates(Module_shptr
     for (Module::module_collection::const_iterator iter = module->modules_begin();
          iter != module->modules_end(); ++iter)
     {
-        Module_shptr sub = *iter;
-        common_code += generate_common_code_for_gates(sub, already_dumped);
+        write_gate_templates(os, *iter, already_dumped);
+    }
+}
 
-        VerilogModuleGenerator codegen(sub, true);
-        common_code += codegen.generate();
+void VerilogModuleGenerator::collect_submodules(Module_shptr module, std::vector<Module_shptr>& submodules)
+{
+    for (Module::module_collection::const_iterator iter = module->modules_begin();
+         iter != module->modules_end(); ++iter)
+    {
+        collect_submodules(*iter, submodules);
+        submodules.push_back(*iter);
     }
+}
+
+void VerilogModuleGenerator::write_module_definitions(std::ostream& os, std::vector<Module_shptr> const& modules)
+{
+    // Module definitions are independent of each other, so a batch of them is generated
+    // in parallel. Only the current batch is kept in memory.
+    const size_t batch_size = static_cast<size_t>(std::max(QThread::idealThreadCount(), 1)) * 4;
+
+    for (size_t first = 0; first < modules.size(); first += batch_size)
+    {
+        const size_t count = std::min(batch_size, modules.size() - first);
+        std::vector<std::string> code(count);
+
+        std::exception_ptr error;
+        std::mutex error_mutex;
+
+        // Multi-threaded function
+        std::function<void(const size_t& i)> function = [&](const size_t& i)
+        {
+            try
+            {
+                VerilogModuleGenerator codegen(modules[first + i], true);
+
+                std::ostringstream module_os;
+                codegen.write_module_definition(module_os);
+                code[i] = module_os.str();
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error) error = std::current_exception();
+            }
+        };
+
+        // Start multithreading
+        const auto& it = boost::counting_range<size_t>(0, count);
+        QtConcurrent::blockingMap(it, function);
+
+        if (error) std::rethrow_exception(error);
+
+        for (auto& c : code) os << c;
+    }
+}
+
+void VerilogModuleGenerator::generate(std::ostream& os) const
+{
+    if (!no_gates)
+    {
+        std::set<GateTemplate_shptr> already_dumped;
+        write_gate_templates(os, mod, already_dumped);
+    }
+
+    std::vector<Module_shptr> submodules;
+    collect_submodules(mod, submodules);
+    write_module_definitions(os, submodules);
 
-    return common_code;
+    write_module_definition(os);
+}
+
+void VerilogModuleGenerator::write_module_definition(std::ostream& os) const
+{
+    os << generate_header()
+       << generate_module(entity_name, generate_port_list())
+       << generate_port_definition();
+
+    write_impl(os);
+
+    os << "\n\n"
+          "endmodule\n\n";
 }
 
 std::string VerilogModuleGenerator::generate_common() const
 {
-    std::set<GateTemplate_shptr> already_dumped;
-    return generate_common_code_for_gates(mod, already_dumped);
+    std::ostringstream os;
+
+    if (!no_gates)
+    {
+        std::set<GateTemplate_shptr> already_dumped;
+        write_gate_templates(os, mod, already_dumped);
+    }
+
+    std::vector<Module_shptr> submodules;
+    collect_submodules(mod, submodules);
+    write_module_definitions(os, submodules);
+
+    return os.str();
 }
 
 std::string VerilogModuleGenerator::generate_impl(std::string const& logic_class /* unused parameter */) const
 {
-    std::string impl;
-    std::string wire_definitions;
+    std::ostringstream os;
+    write_impl(os);
+    return os.str();
+}
+
+/**
+ * Write the port connections of a placed gate or sub-module.
+ */
+static void write_placement(std::ostream& os,
+                            std::string const& type_name,
+                            std::string const& instance_name,
+                            std::vector<std::pair<std::string, std::string>> const& ports)
+{
+    os << "  " << type_name << " " << instance_name << " (\n";
+
+    for (size_t i = 0; i < ports.size(); i++)
+    {
+        if (i > 0) os << ",\n";
+        os << "    ." << ports[i].first << " (" << ports[i].second << ")";
+    }
 
+    os << " );\n\n";
+}
+
+void VerilogModuleGenerator::write_impl(std::ostream& os) const
+{
     unsigned int wire_counter = 0;
 
     typedef std::map<object_id_t /* net */, std::string> net_names_table;
     net_names_table nets;
 
+    // Reverse lookup table for module ports, built once instead of searching the
+    // module ports for every gate port.
+    std::map<GatePort_shptr, std::string> module_port_names;
+    for (Module::port_collection::const_iterator iter = mod->ports_begin();
+         iter != mod->ports_end(); ++iter)
+    {
+        module_port_names.insert(std::make_pair(iter->second, iter->first));
+    }
+
 
     // generate signal names
     for (Module::gate_collection::const_iterator iter = mod->gates_begin();
          iter != mod->gates_end(); ++iter)
     {
         Gate_shptr gate = *iter;
-        GateTemplate_shptr gate_tmpl = gate->get_gate_template();
         for (Gate::port_const_iterator p_iter = gate->ports_begin(); p_iter != gate->ports_end(); ++p_iter)
         {
             const GatePort_shptr gport = *p_iter;
@@ -127,10 +244,10 @@ std::string VerilogModuleGenerator::generate_impl(std::string const& logic_class
                 const Net_shptr net = gport->get_net();
 
                 // first, check if the gate port is directly adjacent to a module port
-                boost::optional<std::string> is_module_port = mod->lookup_module_port_name(gport);
-                if (is_module_port)
+                auto is_module_port = module_port_names.find(gport);
+                if (is_module_port != module_port_names.end())
                 {
-                    nets[net->get_object_id()] = *is_module_port;
+                    nets[net->get_object_id()] = is_module_port->second;
                 }
                 else if (nets.find(net->get_object_id()) == nets.end())
                 {
@@ -147,7 +264,6 @@ std::string VerilogModuleGenerator::generate_impl(std::string const& logic_class
          iter != mod->modules_end(); ++iter)
     {
         Module_shptr sub = *iter;
-        std::list<std::string> ports;
 
         // iterate over its module ports
         for (Module::port_collection::const_iterator p_iter = sub->ports_begin();
@@ -167,14 +283,24 @@ std::string VerilogModuleGenerator::generate_impl(std::string const& logic_class
 
 
     // genereate wire definitions
+    bool first_wire = true;
     BOOST_FOREACH(net_names_table::value_type const& v, nets)
     {
         if (!mod->exists_module_port_name(v.second))
-            wire_definitions += "  wire " + v.second + ";\n";
+        {
+            if (first_wire) os << "  // net definitions\n";
+            first_wire = false;
+
+            os << "  wire " << v.second << ";\n";
+        }
     }
 
+    os << "\n"
+          "  // sub-modules\n\n";
+
 
     // place single standard cells
+    std::vector<std::pair<std::string, std::string>> ports;
 
     for (Module::gate_collection::const_iterator iter = mod->gates_begin();
          iter != mod->gates_end(); ++iter)
@@ -182,7 +308,7 @@ std::string VerilogModuleGenerator::generate_impl(std::string const& logic_class
         Gate_shptr gate = *iter;
         GateTemplate_shptr gate_tmpl = gate->get_gate_template();
 
-        std::list<std::string> ports;
+        ports.clear();
 
         for (Gate::port_const_iterator p_iter = gate->ports_begin(); p_iter != gate->ports_end(); ++p_iter)
         {
@@ -196,22 +322,14 @@ std::string VerilogModuleGenerator::generate_impl(std::string const& logic_class
                 std::string port_name = generate_identifier(tmpl_port->get_name());
                 std::transform(port_name.begin(), port_name.end(), port_name.begin(), ::tolower);
 
-                boost::format f("    .%1% (%2%)");
-                f % port_name
-                    % nets[net->get_object_id()];
-                ports.push_back(f.str());
+                ports.push_back(std::make_pair(port_name, nets[net->get_object_id()]));
             }
         }
 
-
-        boost::format gate_placement("  %1% %2% (\n"
-            "%3% );\n\n");
-        gate_placement
-            % generate_identifier(gate_tmpl->get_name(), "dg_")
-            % generate_identifier(gate->get_name())
-            % boost::algorithm::join(ports, ",\n");
-
-        impl += gate_placement.str();
+        write_placement(os,
+                        generate_identifier(gate_tmpl->get_name(), "dg_"),
+                        generate_identifier(gate->get_name()),
+                        ports);
     }
 
 
@@ -220,7 +338,8 @@ std::string VerilogModuleGenerator::generate_impl(std::string const& logic_class
          iter != mod->modules_end(); ++iter)
     {
         Module_shptr sub = *iter;
-        std::list<std::string> ports;
+
+        ports.clear();
 
         // iterate over its module ports
         for (Module::port_collection::const_iterator p_iter = sub->ports_begin();
@@ -233,29 +352,13 @@ std::string VerilogModuleGenerator::generate_impl(std::string const& logic_class
             {
                 const Net_shptr net = gport->get_net();
 
-                boost::format f("    .%1% (%2%)");
-                f % submod_port_name
-                    % nets[net->get_object_id()];
-                ports.push_back(f.str());
+                ports.push_back(std::make_pair(submod_port_name, nets[net->get_object_id()]));
             }
         }
 
-
-        boost::format gate_placement("  %1% %2% (\n"
-            "%3% );\n\n");
-        gate_placement
-            % generate_identifier(sub->get_entity_name() != "" ? sub->get_entity_name() : sub->get_name(), "dg_")
-            % generate_identifier(sub->get_name())
-            % boost::algorithm::join(ports, ",\n");
-
-        impl += gate_placement.str();
+        write_placement(os,
+                        generate_identifier(sub->get_entity_name() != "" ? sub->get_entity_name() : sub->get_name(), "dg_"),
+                        generate_identifier(sub->get_name()),
+                        ports);
     }
-
-
-    // place sub-modules
-    return
-        (wire_definitions != "" ? "  // net definitions\n" : "") +
-        wire_definitions + "\n" +
-        "  // sub-modules\n\n" +
-        impl;
 }
@@ -23,6 +23,9 @@
 #define __VERILOGMODULEGENERATOR_H__
 
 #include <memory>
+#include <ostream>
+#include <set>
+#include <vector>
 
 #include "Core/Generator/VerilogCodeTemplateGenerator.h"
 #include "Core/LogicModel/Gate/GateTemplate.h"
@@ -30,6 +33,14 @@
 
 namespace degate
 {
+    /**
+     * Generates a structural Verilog netlist for a module and its sub-modules.
+     *
+     * For large hierarchies use generate(std::ostream&). It writes each module
+     * definition exactly once and directly into the stream. The definitions of
+     * sub-modules are generated in parallel, in batches, so that only a batch
+     * of module definitions is held in memory at a time.
+     */
     class VerilogModuleGenerator : public VerilogCodeTemplateGenerator
     {
     private:
@@ -43,6 +54,15 @@ namespace degate
 
         virtual ~VerilogModuleGenerator();
 
+        using VerilogCodeTemplateGenerator::generate;
+
+        /**
+         * Write the netlist into \p os: the gate template implementations, the
+         * definitions of all sub-modules (each once, children first) and finally the
+         * module itself.
+         */
+        void generate(std::ostream& os) const;
+
     protected:
 
         virtual std::string generate_common() const;
@@ -51,8 +71,32 @@ namespace degate
 
     private:
 
-        std::string generate_common_code_for_gates(Module_shptr module,
-                                                   std::set<GateTemplate_shptr>& already_dumped) const;
+        /**
+         * Write the Verilog implementations of all gate templates used in \p module
+         * and its sub-modules. Each template is written once.
+         */
+        void write_gate_templates(std::ostream& os, Module_shptr module,
+                                  std::set<GateTemplate_shptr>& already_dumped) const;
+
+        /**
+         * Collect all sub-modules of \p module, children before their parents.
+         */
+        static void collect_submodules(Module_shptr module, std::vector<Module_shptr>& submodules);
+
+        /**
+         * Write the definitions of \p modules in this order.
+         */
+        static void write_module_definitions(std::ostream& os, std::vector<Module_shptr> const& modules);
+
+        /**
+         * Write the definition of this module only, without the sub-module definitions.
+         */
+        void write_module_definition(std::ostream& os) const;
+
+        /**
+         * Write the wire definitions and the placement of gates and sub-modules.
+         */
+        void write_impl(std::ostream& os) const;
     };
 }
 
@@ -0,0 +1,233 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __BLOCKACCESSPOLICY_H__
+#define __BLOCKACCESSPOLICY_H__
+
+#include <memory>
+#include <vector>
+#include <functional>
+
+#include <boost/range/counting_range.hpp>
+#include <QtConcurrent/QtConcurrent>
+
+/**
+ * Width and height of the blocks, that images are processed in parallel with.
+ * Tile images use their tile size instead.
+ */
+#define IMAGE_BLOCK_SIZE 256
+
+namespace degate
+{
+    template <class PixelPolicy, template <class _PixelPolicy> class StoragePolicy>
+    class Image;
+
+    template <class PixelPolicy>
+    class StoragePolicy_Tile;
+
+    /**
+     * Policy class for reading and writing rectangular image regions.
+     *
+     * Unlike get_pixel() and set_pixel() on tile images, this can be used from several
+     * threads at once, as long as the threads write disjoint regions.
+     * Images with memory or file storage are accessed pixel by pixel.
+     */
+    template <typename ImageType>
+    struct BlockAccessPolicy
+    {
+        typedef typename ImageType::pixel_type pixel_type;
+
+        /**
+         * Get the block size, that regions should be aligned to.
+         */
+        static inline unsigned int get_block_size(std::shared_ptr<ImageType>)
+        {
+            return IMAGE_BLOCK_SIZE;
+        }
+
+        /**
+         * Read the region [min_x, max_x) x [min_y, max_y) row by row into \p out.
+         */
+        static void read(std::shared_ptr<ImageType> img,
+                         unsigned int min_x, unsigned int max_x,
+                         unsigned int min_y, unsigned int max_y,
+                         pixel_type* out)
+        {
+            for (unsigned int y = min_y; y < max_y; y++)
+                for (unsigned int x = min_x; x < max_x; x++)
+                    *out++ = img->get_pixel(x, y);
+        }
+
+        /**
+         * Call \p function for each pixel of the region [min_x, max_x) x [min_y, max_y),
+         * row by row. Nothing is allocated.
+         */
+        template <typename Function>
+        static void visit(std::shared_ptr<ImageType> img,
+                          unsigned int min_x, unsigned int max_x,
+                          unsigned int min_y, unsigned int max_y,
+                          Function function)
+        {
+            for (unsigned int y = min_y; y < max_y; y++)
+                for (unsigned int x = min_x; x < max_x; x++)
+                    function(img->get_pixel(x, y));
+        }
+
+        /**
+         * Write the region [min_x, max_x) x [min_y, max_y) row by row from \p in.
+         */
+        static void write(std::shared_ptr<ImageType> img,
+                          unsigned int min_x, unsigned int max_x,
+                          unsigned int min_y, unsigned int max_y,
+                          pixel_type const* in)
+        {
+            for (unsigned int y = min_y; y < max_y; y++)
+                for (unsigned int x = min_x; x < max_x; x++)
+                    img->set_pixel(x, y, *in++);
+        }
+    };
+
+    /**
+     * Policy class for reading and writing regions of tile images.
+     * Each tile is fetched once per region with fetch_tile(). The working tile, that
+     * get_pixel() and set_pixel() use, is not touched.
+     */
+    template <class PixelPolicy>
+    struct BlockAccessPolicy<Image<PixelPolicy, StoragePolicy_Tile>>
+    {
+        typedef Image<PixelPolicy, StoragePolicy_Tile> ImageType;
+        typedef typename ImageType::pixel_type pixel_type;
+
+        static inline unsigned int get_block_size(std::shared_ptr<ImageType> img)
+        {
+            return img->get_tile_size();
+        }
+
+        static void read(std::shared_ptr<ImageType> img,
+                         unsigned int min_x, unsigned int max_x,
+                         unsigned int min_y, unsigned int max_y,
+                         pixel_type* out)
+        {
+            process(img, min_x, max_x, min_y, max_y,
+                    [out](typename ImageType::MemoryMap_shptr const& tile, unsigned int tx, unsigned int ty, std::size_t i)
+                    {
+                        out[i] = tile->get(tx, ty);
+                    });
+        }
+
+        static void write(std::shared_ptr<ImageType> img,
+                          unsigned int min_x, unsigned int max_x,
+                          unsigned int min_y, unsigned int max_y,
+                          pixel_type const* in)
+        {
+            process(img, min_x, max_x, min_y, max_y,
+                    [in](typename ImageType::MemoryMap_shptr const& tile, unsigned int tx, unsigned int ty, std::size_t i)
+                    {
+                        tile->set(tx, ty, in[i]);
+                    });
+        }
+
+        /**
+         * Call \p function for each pixel of the region. The order is tile by tile.
+         * Nothing is allocated.
+         */
+        template <typename Function>
+        static void visit(std::shared_ptr<ImageType> img,
+                          unsigned int min_x, unsigned int max_x,
+                          unsigned int min_y, unsigned int max_y,
+                          Function function)
+        {
+            process(img, min_x, max_x, min_y, max_y,
+                    [&function](typename ImageType::MemoryMap_shptr const& tile, unsigned int tx, unsigned int ty, std::size_t)
+                    {
+                        function(tile->get(tx, ty));
+                    });
+        }
+
+    private:
+
+        template <typename Function>
+        static void process(std::shared_ptr<ImageType> img,
+                            unsigned int min_x, unsigned int max_x,
+                            unsigned int min_y, unsigned int max_y,
+                            Function function)
+        {
+            const unsigned int tile_size = img->get_tile_size(), offset_bitmask = tile_size - 1;
+            const std::size_t row_length = max_x - min_x;
+
+            for (unsigned int tile_y = min_y & ~offset_bitmask; tile_y < max_y; tile_y += tile_size)
+                for (unsigned int tile_x = min_x & ~offset_bitmask; tile_x < max_x; tile_x += tile_size)
+                {
+                    auto tile = img->fetch_tile(tile_x, tile_y);
+
+                    const unsigned int
+                        from_x = std::max(min_x, tile_x), to_x = std::min(max_x, tile_x + tile_size),
+                        from_y = std::max(min_y, tile_y), to_y = std::min(max_y, tile_y + tile_size);
+
+                    for (unsigned int y = from_y; y < to_y; y++)
+                        for (unsigned int x = from_x; x < to_x; x++)
+                            function(tile, x & offset_bitmask, y & offset_bitmask,
+                                     (y - min_y) * row_length + (x - min_x));
+                }
+        }
+    };
+
+
+    /**
+     * Call a function for each block of an image region. Blocks are processed in parallel.
+     * @param img The image, that determines the block size.
+     * @param min_x, max_x, min_y, max_y The region. Blocks are clipped to it.
+     * @param function The function is called with the clipped block
+     *   (min_x, max_x, min_y, max_y). Calls for different blocks may run concurrently.
+     */
+    template <typename ImageType>
+    void for_each_block(std::shared_ptr<ImageType> img,
+                        unsigned int min_x, unsigned int max_x,
+                        unsigned int min_y, unsigned int max_y,
+                        std::function<void(unsigned int, unsigned int, unsigned int, unsigned int)> const& function)
+    {
+        if (min_x >= max_x || min_y >= max_y) return;
+
+        const unsigned int block_size = BlockAccessPolicy<ImageType>::get_block_size(img);
+        const unsigned int
+            first_block_x = min_x / block_size, blocks_x = (max_x - 1) / block_size - first_block_x + 1,
+            first_block_y = min_y / block_size, blocks_y = (max_y - 1) / block_size - first_block_y + 1;
+
+        std::function<void(const unsigned int& i)> block_function = [&](const unsigned int& i)
+        {
+            const unsigned int
+                block_min_x = (first_block_x + i % blocks_x) * block_size,
+                block_min_y = (first_block_y + i / blocks_x) * block_size;
+
+            function(std::max(block_min_x, min_x), std::min(block_min_x + block_size, max_x),
+                     std::max(block_min_y, min_y), std::min(block_min_y + block_size, max_y));
+        };
+
+        if (blocks_x * blocks_y == 1) block_function(0);
+        else
+        {
+            const auto& it = boost::counting_range<unsigned int>(0, blocks_x * blocks_y);
+            QtConcurrent::blockingMap(it, block_function);
+        }
+    }
+}
+
+#endif
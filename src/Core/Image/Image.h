@@ -289,6 +289,10 @@ namespace degate
     typedef Image<PixelPolicy_RGBA, StoragePolicy_Tile> BackgroundImage;
     typedef std::shared_ptr<BackgroundImage> BackgroundImage_shptr;
 
+    // Single-channel backgrounds (e.g. SEM images) are stored with one byte per pixel.
+    typedef Image<PixelPolicy_GS_BYTE, StoragePolicy_Tile> GreyscaleBackgroundImage;
+    typedef std::shared_ptr<GreyscaleBackgroundImage> GreyscaleBackgroundImage_shptr;
+
 
     typedef Image<PixelPolicy_RGBA, StoragePolicy_TempFile> TempImage_RGBA;
     typedef Image<PixelPolicy_GS_DOUBLE, StoragePolicy_TempFile> TempImage_GS_DOUBLE;
@@ -0,0 +1,357 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __IMAGEACCUMULATOR_H__
+#define __IMAGEACCUMULATOR_H__
+
+#include "Core/Image/Image.h"
+#include "Core/Utils/DegateExceptions.h"
+
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+/**
+ * Number of histogram bins per channel, used by the robust merge modes.
+ */
+#define IMAGE_ACCUMULATOR_BINS 64
+
+namespace degate
+{
+    /**
+     * Merge a stream of equally sized images into a single image.
+     *
+     * Images are folded into per pixel running sums as they are added, so the memory
+     * usage does not depend on the number of merged images. Adding images is thread safe.
+     *
+     * Besides the mean, a per pixel median or trimmed mean can be calculated. For these
+     * robust modes each pixel keeps a histogram with IMAGE_ACCUMULATOR_BINS bins for the
+     * red, green and blue channel. Results are interpolated within a bin. The alpha
+     * channel is always averaged.
+     */
+    template <typename ImageType>
+    class ImageAccumulator
+    {
+    public:
+
+        enum MERGE_MODE
+        {
+            MERGE_MEAN = 0,
+            MERGE_MEDIAN = 1,
+            MERGE_TRIMMED_MEAN = 2
+        };
+
+    private:
+
+        const unsigned int width, height;
+        const MERGE_MODE mode;
+        const double trim;
+
+        unsigned int count;
+        std::vector<double> sums;
+        std::vector<unsigned int> histograms;
+
+        mutable std::mutex mutex;
+
+        /**
+         * Get the median or trimmed mean of a channel from the histogram of a pixel.
+         */
+        double get_histogram_value(std::size_t pixel, unsigned int channel) const
+        {
+            const unsigned int* hist = &histograms[(pixel * 3 + channel) * IMAGE_ACCUMULATOR_BINS];
+            const double bin_width = 256.0 / IMAGE_ACCUMULATOR_BINS;
+
+            if (mode == MERGE_MEDIAN)
+            {
+                const double target = count / 2.0;
+                double seen = 0;
+
+                for (unsigned int i = 0; i < IMAGE_ACCUMULATOR_BINS; i++)
+                {
+                    if (hist[i] > 0 && seen + hist[i] >= target)
+                        return bin_width * (i + (target - seen) / hist[i]);
+
+                    seen += hist[i];
+                }
+
+                return 255;
+            }
+
+            // Sum the part of each bin that lies within [low, high), assuming values are
+            // distributed uniformly within a bin.
+            const double low = count * trim, high = count * (1.0 - trim);
+            double seen = 0, sum = 0, used = 0;
+
+            for (unsigned int i = 0; i < IMAGE_ACCUMULATOR_BINS && seen < high; i++)
+            {
+                const double from = std::max(seen, low), to = std::min(seen + hist[i], high);
+
+                if (to > from)
+                {
+                    const double bin_start = bin_width * (i + (from - seen) / hist[i]);
+                    const double bin_end = bin_width * (i + (to - seen) / hist[i]);
+
+                    sum += (to - from) * (bin_start + bin_end) / 2.0;
+                    used += to - from;
+                }
+
+                seen += hist[i];
+            }
+
+            return used > 0 ? sum / used : 0;
+        }
+
+        static inline unsigned char to_channel(double v)
+        {
+            return static_cast<unsigned char>(std::max(0L, std::min(255L, lround(v))));
+        }
+
+    public:
+
+        /**
+         * Create an accumulator.
+         * @param width The width of the merged images.
+         * @param height The height of the merged images.
+         * @param mode How pixels are merged.
+         * @param trim For MERGE_TRIMMED_MEAN, the fraction of values, that is ignored on
+         *   each end of the distribution.
+         * @exception DegateRuntimeException This exception is thrown, if \p trim is
+         *   not in [0, 0.5).
+         */
+        ImageAccumulator(unsigned int width,
+                         unsigned int height,
+                         MERGE_MODE mode = MERGE_MEAN,
+                         double trim = 0.2) :
+            width(width),
+            height(height),
+            mode(mode),
+            trim(trim),
+            count(0),
+            sums(4 * static_cast<std::size_t>(width) * static_cast<std::size_t>(height), 0)
+        {
+            if (trim < 0 || trim >= 0.5)
+                throw DegateRuntimeException("Invalid trim fraction for ImageAccumulator.");
+
+            if (mode != MERGE_MEAN)
+                histograms.resize(3 * static_cast<std::size_t>(width) * static_cast<std::size_t>(height) *
+                                  IMAGE_ACCUMULATOR_BINS, 0);
+        }
+
+        /**
+         * Add an image.
+         * @exception InvalidPointerException This exception is thrown, if \p img is invalid.
+         * @exception DegateRuntimeException This exception is thrown, if the image size
+         *   differs from the accumulator size.
+         */
+        void add(std::shared_ptr<ImageType> img)
+        {
+            add(img, 0, 0);
+        }
+
+        /**
+         * Add an image, that is shifted by a sub-pixel offset. The accumulated pixel (x, y)
+         * is sampled from \p img at (x + \p dx, y + \p dy) with bilinear interpolation.
+         * Samples beyond the image border are clamped to the border.
+         * @see estimate_image_shift()
+         */
+        void add(std::shared_ptr<ImageType> img, double dx, double dy)
+        {
+            if (img == nullptr) throw InvalidPointerException("Invalid image pointer for ImageAccumulator::add().");
+            if (img->get_width() != width || img->get_height() != height)
+                throw DegateRuntimeException("ImageAccumulator::add() failed, because images differ in size.");
+
+            // Sample outside of the lock, only the fold into the sums is serialized.
+            std::vector<double> samples(4 * static_cast<std::size_t>(width) * static_cast<std::size_t>(height));
+
+            for (unsigned int y = 0; y < height; y++)
+                for (unsigned int x = 0; x < width; x++)
+                {
+                    double* s = &samples[4 * (static_cast<std::size_t>(y) * width + x)];
+
+                    if (dx == 0 && dy == 0)
+                    {
+                        color_t pix = img->template get_pixel_as<color_t>(x, y);
+                        s[0] = MASK_R(pix);
+                        s[1] = MASK_G(pix);
+                        s[2] = MASK_B(pix);
+                        s[3] = MASK_A(pix);
+                        continue;
+                    }
+
+                    const double sx = std::max(0.0, std::min<double>(width - 1, x + dx));
+                    const double sy = std::max(0.0, std::min<double>(height - 1, y + dy));
+                    const auto x0 = static_cast<unsigned int>(sx), y0 = static_cast<unsigned int>(sy);
+                    const unsigned int x1 = std::min(x0 + 1, width - 1), y1 = std::min(y0 + 1, height - 1);
+                    const double fx = sx - x0, fy = sy - y0;
+
+                    const color_t p00 = img->template get_pixel_as<color_t>(x0, y0);
+                    const color_t p10 = img->template get_pixel_as<color_t>(x1, y0);
+                    const color_t p01 = img->template get_pixel_as<color_t>(x0, y1);
+                    const color_t p11 = img->template get_pixel_as<color_t>(x1, y1);
+
+#define IMAGE_ACCUMULATOR_LERP(MASK) \
+    ((1 - fy) * ((1 - fx) * MASK(p00) + fx * MASK(p10)) + fy * ((1 - fx) * MASK(p01) + fx * MASK(p11)))
+
+                    s[0] = IMAGE_ACCUMULATOR_LERP(MASK_R);
+                    s[1] = IMAGE_ACCUMULATOR_LERP(MASK_G);
+                    s[2] = IMAGE_ACCUMULATOR_LERP(MASK_B);
+                    s[3] = IMAGE_ACCUMULATOR_LERP(MASK_A);
+
+#undef IMAGE_ACCUMULATOR_LERP
+                }
+
+            std::lock_guard<std::mutex> lock(mutex);
+
+            for (std::size_t i = 0; i < samples.size(); i++)
+                sums[i] += samples[i];
+
+            if (mode != MERGE_MEAN)
+            {
+                for (std::size_t pixel = 0; pixel < samples.size() / 4; pixel++)
+                    for (unsigned int channel = 0; channel < 3; channel++)
+                    {
+                        auto bin = static_cast<unsigned int>(samples[4 * pixel + channel] * IMAGE_ACCUMULATOR_BINS / 256.0);
+                        histograms[(pixel * 3 + channel) * IMAGE_ACCUMULATOR_BINS +
+                                   std::min(bin, IMAGE_ACCUMULATOR_BINS - 1u)]++;
+                    }
+            }
+
+            count++;
+        }
+
+        /**
+         * Get the number of added images.
+         */
+        unsigned int get_count() const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return count;
+        }
+
+        /**
+         * Get the merged image.
+         * @return Returns the merged image or a nullptr pointer, if no image was added.
+         */
+        std::shared_ptr<ImageType> get_image() const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            std::shared_ptr<ImageType> new_img;
+            if (count == 0) return new_img;
+
+            new_img = std::make_shared<ImageType>(width, height);
+
+            for (unsigned int y = 0; y < height; y++)
+                for (unsigned int x = 0; x < width; x++)
+                {
+                    const std::size_t pixel = static_cast<std::size_t>(y) * width + x;
+                    const double* s = &sums[4 * pixel];
+                    double c[4] = { s[0] / count, s[1] / count, s[2] / count, s[3] / count };
+
+                    if (mode != MERGE_MEAN)
+                        for (unsigned int channel = 0; channel < 3; channel++)
+                            c[channel] = get_histogram_value(pixel, channel);
+
+                    color_t pix = MERGE_CHANNELS(static_cast<color_t>(to_channel(c[0])),
+                                                 static_cast<color_t>(to_channel(c[1])),
+                                                 static_cast<color_t>(to_channel(c[2])),
+                                                 static_cast<color_t>(to_channel(c[3])));
+                    new_img->set_pixel_as(x, y, pix);
+                }
+
+            return new_img;
+        }
+    };
+
+    typedef ImageAccumulator<GateTemplateImage> GateTemplateImageAccumulator;
+
+
+    /**
+     * Estimate the sub-pixel shift between two equally sized images.
+     *
+     * Integer shifts up to \p radius pixels are compared by the mean squared greyscale
+     * difference. The best shift is refined with a parabola fit through its neighbours.
+     * @param reference The reference image.
+     * @param img The image to align.
+     * @param radius The maximum shift in pixels.
+     * @param dx Set to the x offset, that must be added to reference coordinates to get
+     *   the matching position in \p img.
+     * @param dy Set to the y offset.
+     * @see ImageAccumulator::add()
+     */
+    template <typename ImageType>
+    void estimate_image_shift(std::shared_ptr<ImageType> reference,
+                              std::shared_ptr<ImageType> img,
+                              unsigned int radius,
+                              double& dx, double& dy)
+    {
+        if (reference == nullptr || img == nullptr)
+            throw InvalidPointerException("Invalid image pointer for estimate_image_shift().");
+
+        dx = dy = 0;
+
+        const unsigned int w = std::min(reference->get_width(), img->get_width());
+        const unsigned int h = std::min(reference->get_height(), img->get_height());
+        if (radius == 0 || w <= 2 * radius || h <= 2 * radius) return;
+
+        const int r = static_cast<int>(radius), size = 2 * r + 1;
+        std::vector<double> error(static_cast<std::size_t>(size * size), 0);
+
+        for (int sy = -r; sy <= r; sy++)
+            for (int sx = -r; sx <= r; sx++)
+            {
+                double sum = 0;
+
+                for (unsigned int y = radius; y < h - radius; y++)
+                    for (unsigned int x = radius; x < w - radius; x++)
+                    {
+                        double d = static_cast<double>(reference->template get_pixel_as<gs_byte_pixel_t>(x, y)) -
+                                   img->template get_pixel_as<gs_byte_pixel_t>(x + sx, y + sy);
+                        sum += d * d;
+                    }
+
+                error[(sy + r) * size + sx + r] = sum;
+            }
+
+        std::size_t best = std::min_element(error.begin(), error.end()) - error.begin();
+        const int bx = static_cast<int>(best % size) - r, by = static_cast<int>(best / size) - r;
+
+        // Vertex of the parabola through the error at -1, 0 and +1.
+        auto refine = [](double left, double center, double right)
+        {
+            double denom = left - 2 * center + right;
+            return denom > 0 ? std::max(-0.5, std::min(0.5, (left - right) / (2 * denom))) : 0.0;
+        };
+
+        dx = bx;
+        dy = by;
+
+        if (bx > -r && bx < r)
+            dx += refine(error[(by + r) * size + bx + r - 1], error[best], error[(by + r) * size + bx + r + 1]);
+        if (by > -r && by < r)
+            dy += refine(error[(by + r - 1) * size + bx + r], error[best], error[(by + r + 1) * size + bx + r]);
+    }
+}
+
+#endif
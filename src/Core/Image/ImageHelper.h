@@ -28,6 +28,7 @@
 #include "Core/Image/StoragePolicies.h"
 #include "Core/Image/Image.h"
 #include "Core/Image/ImageReader.h"
+#include "Core/Image/ImageAccumulator.h"
 
 #include <set>
 #include <boost/foreach.hpp>
@@ -151,49 +152,17 @@ namespace degate
     template <typename ImageType>
     std::shared_ptr<ImageType> merge_images(std::list<std::shared_ptr<ImageType>> const& images)
     {
-        std::shared_ptr<ImageType> new_img;
-        if (images.empty()) return new_img;
+        if (images.empty()) return std::shared_ptr<ImageType>();
 
         const std::shared_ptr<ImageType> img = images.front();
-
-        unsigned int w = img->get_width(), h = img->get_height();
-        std::vector<double> i_tmp(4 * static_cast<std::size_t>(w) * static_cast<std::size_t>(h));
+        ImageAccumulator<ImageType> accumulator(img->get_width(), img->get_height());
 
         BOOST_FOREACH(const std::shared_ptr<ImageType> i, images)
         {
-            // verify that all images have the same dimensions
-            if (w != i->get_width() || h != i->get_height())
-                throw DegateRuntimeException("merge_images() failed, because images differ in size.");
-
-            for (unsigned int y = 0; y < h; y++)
-                for (unsigned int x = 0; x < w; x++)
-                {
-                    color_t pix = i->template get_pixel_as<color_t>(x, y);
-                    unsigned int offs = 4 * (y * w + x);
-                    i_tmp[offs] += MASK_R(pix);
-                    i_tmp[offs + 1] += MASK_G(pix);
-                    i_tmp[offs + 2] += MASK_B(pix);
-                    i_tmp[offs + 3] += MASK_A(pix);
-                }
+            accumulator.add(i);
         }
 
-        const double elems = images.size();
-
-        new_img = std::shared_ptr<ImageType>(new GateTemplateImage(w, h));
-        assert(new_img != nullptr);
-
-        for (unsigned int y = 0; y < h; y++)
-            for (unsigned int x = 0; x < w; x++)
-            {
-                unsigned int offs = 4 * (y * w + x);
-                color_t pix = MERGE_CHANNELS(lround(i_tmp[offs] / elems),
-                                             lround(i_tmp[offs+1] / elems),
-                                             lround(i_tmp[offs+2] / elems),
-                                             lround(i_tmp[offs+3] / elems));
-                new_img->set_pixel(x, y, pix);
-            }
-
-        return new_img;
+        return accumulator.get_image();
     }
 }
 
@@ -31,12 +31,15 @@
 #include "Core/Utils/TypeTraits.h"
 #include "Core/Image/StoragePolicies.h"
 #include "Core/Image/PixelPolicies.h"
+#include "Core/Image/TIFFReader.h"
 #include "Core/Utils/FileSystem.h"
 
 namespace degate
 {
     /**
      * Image reader class.
+     * TIFF images are read with the native TIFFReader, if possible. All other
+     * images are read with QImageReader.
      */
     template <class ImageType>
     class ImageReader
@@ -44,6 +47,7 @@ namespace degate
     private:
 
         QImageReader* image_reader = nullptr;
+        TIFFReader_shptr tiff_reader;
         std::string filename;
         unsigned int width, height;
 
@@ -98,6 +102,24 @@ namespace degate
          */
         bool read()
         {
+            if (TIFFReader::is_tiff(get_filename()))
+            {
+                try
+                {
+                    tiff_reader = std::make_shared<TIFFReader>(get_filename());
+
+                    width = tiff_reader->get_width();
+                    height = tiff_reader->get_height();
+
+                    return true;
+                }
+                catch (DegateRuntimeException const& e)
+                {
+                    debug(TM, "Can't read %s natively (%s), using QImageReader.", get_filename().c_str(), e.what());
+                    tiff_reader.reset();
+                }
+            }
+
             image_reader = new QImageReader(get_filename().c_str());
 
             // If the image is a multi-page/multi-res, we take the page with the biggest resolution.
@@ -151,12 +173,27 @@ namespace degate
          */
         bool get_image(std::shared_ptr<ImageType> img)
         {
-            if (image_reader == nullptr) return false;
+            if (image_reader == nullptr && tiff_reader == nullptr) return false;
             if (img == nullptr) return false;
 
             if (img->get_width() < width || img->get_height() < height)
                 return false;
 
+            if (tiff_reader != nullptr)
+            {
+                try
+                {
+                    read_tiff<ImageType>(*tiff_reader, img);
+                }
+                catch (DegateRuntimeException const& e)
+                {
+                    debug(TM, "can't read %s: %s\n", get_filename().c_str(), e.what());
+                    return false;
+                }
+
+                return true;
+            }
+
             debug(TM, "Reading image with size: %d x %d", get_width(), get_height());
 
             QImage image;
@@ -24,6 +24,22 @@
 
 #include "Core/Primitive/BoundingBox.h"
 #include "Core/Image/Manipulation/ImageManipulation.h"
+#include "Core/Image/BlockAccessPolicy.h"
+
+#include <array>
+#include <map>
+#include <mutex>
+#include <limits>
+#include <vector>
+#include <cstdint>
+
+#include <boost/range/counting_range.hpp>
+#include <QtConcurrent/QtConcurrent>
+
+/**
+ * Regions with fewer pixels are processed serially by calculate_statistics().
+ */
+#define STATISTICS_MIN_PARALLEL_PIXELS (128 * 128)
 
 namespace degate
 {
@@ -32,53 +48,375 @@ namespace degate
     inline PixelTypeDst get_pixel_as(typename std::shared_ptr<ImageTypeSrc> img,
                                      unsigned int x, unsigned int y);
 
+    template <typename PixelTypeDst, typename PixelTypeSrc>
+    inline PixelTypeDst convert_pixel(PixelTypeSrc p);
+
     /**
-     * Get the minimum pixel value of a single channel image.
+     * Statistics over the pixels of an image region: count, mean, variance, minimum,
+     * maximum and a histogram of the pixel values converted to gs_byte_pixel_t.
+     * Multi-channel pixels are converted to greyscale.
+     *
+     * Values are accumulated with Welford's algorithm. Statistics of disjoint regions
+     * can be merged without loss of precision.
+     *
+     * @see calculate_statistics()
      */
-    template <typename ImageType>
-    typename ImageType::pixel_type get_minimum(std::shared_ptr<ImageType> img)
+    class RegionStatistics
     {
-        assert_is_single_channel_image<ImageType>();
-        typename ImageType::pixel_type minimum = img->get_pixel(0, 0);
+    public:
+
+        typedef std::array<uint64_t, 256> histogram_type;
+
+    private:
+
+        uint64_t count = 0;
+        double mean = 0;
+        double m2 = 0; // sum of squared differences from the mean
+        double minimum = std::numeric_limits<double>::max();
+        double maximum = std::numeric_limits<double>::lowest();
+        histogram_type histogram = histogram_type();
+
+    public:
+
+        /**
+         * Add a value.
+         * @param v The pixel value.
+         * @param bin The histogram bin for the value.
+         */
+        inline void add(double v, gs_byte_pixel_t bin)
+        {
+            count++;
+            double delta = v - mean;
+            mean += delta / count;
+            m2 += delta * (v - mean);
+
+            if (v < minimum) minimum = v;
+            if (v > maximum) maximum = v;
 
-        for (unsigned int y = 0; y < img->get_height(); y++)
-            for (unsigned int x = 0; x < img->get_width(); x++)
+            histogram[bin]++;
+        }
+
+        /**
+         * Merge the statistics of another, disjoint region into this.
+         */
+        void merge(RegionStatistics const& other)
+        {
+            if (other.count == 0) return;
+            if (count == 0)
             {
-                typename ImageType::pixel_type p = img->get_pixel(x, y);
-                if (p < minimum) minimum = p;
+                *this = other;
+                return;
             }
-        return minimum;
+
+            const double n = static_cast<double>(count + other.count);
+            const double delta = other.mean - mean;
+
+            mean += delta * other.count / n;
+            m2 += other.m2 + delta * delta * (static_cast<double>(count) * other.count / n);
+            count += other.count;
+
+            minimum = std::min(minimum, other.minimum);
+            maximum = std::max(maximum, other.maximum);
+
+            for (unsigned int i = 0; i < histogram.size(); i++)
+                histogram[i] += other.histogram[i];
+        }
+
+        uint64_t get_count() const { return count; }
+        double get_mean() const { return mean; }
+
+        /**
+         * Get the population variance.
+         */
+        double get_variance() const { return count > 0 ? m2 / count : 0; }
+        double get_stddev() const { return sqrt(get_variance()); }
+
+        double get_minimum() const { return minimum; }
+        double get_maximum() const { return maximum; }
+
+        histogram_type const& get_histogram() const { return histogram; }
+    };
+
+
+    /**
+     * Add the pixels of an image region to statistics.
+     */
+    template <typename ImageType>
+    void add_region_to_statistics(std::shared_ptr<ImageType> img,
+                                  unsigned int min_x, unsigned int max_x,
+                                  unsigned int min_y, unsigned int max_y,
+                                  RegionStatistics& stats)
+    {
+        typedef typename ImageType::pixel_type pixel_type;
+
+        BlockAccessPolicy<ImageType>::visit(img, min_x, max_x, min_y, max_y, [&stats](pixel_type p)
+        {
+            stats.add(convert_pixel<gs_double_pixel_t, pixel_type>(p),
+                      convert_pixel<gs_byte_pixel_t, pixel_type>(p));
+        });
     }
 
+
+    template <typename ImageType>
+    class ImageStatisticsCache;
+
+    template <typename ImageType>
+    RegionStatistics calculate_statistics(std::shared_ptr<ImageType> img,
+                                          unsigned int start_x, unsigned int start_y,
+                                          unsigned int width, unsigned int height,
+                                          ImageStatisticsCache<ImageType>* cache = nullptr);
+
+
     /**
-     * Get the maximum pixel value of a single channel image.
+     * Cache for the statistics of the blocks of an image.
+     *
+     * Statistics of blocks, that are completely covered by a query, are kept. Repeated
+     * queries only read the partially covered blocks at the region border. The cache does
+     * not notice changes of the image: call invalidate() after modifying it.
      */
     template <typename ImageType>
-    typename ImageType::pixel_type get_maximum(std::shared_ptr<ImageType> img)
+    class ImageStatisticsCache
     {
-        assert_is_single_channel_image<ImageType>();
-        typename ImageType::pixel_type maximum = img->get_pixel(0, 0);
+    private:
+
+        std::shared_ptr<ImageType> img;
+        std::map<std::pair<unsigned int, unsigned int>, RegionStatistics> blocks;
+        mutable std::mutex mutex;
+
+    public:
+
+        /**
+         * Create a cache for an image.
+         * @exception InvalidPointerException This exception is thrown, if \p img is invalid.
+         */
+        ImageStatisticsCache(std::shared_ptr<ImageType> img) : img(img)
+        {
+            if (img == nullptr) throw InvalidPointerException("Invalid image pointer for ImageStatisticsCache.");
+        }
+
+        std::shared_ptr<ImageType> get_image() const { return img; }
+
+        /**
+         * Get the cached statistics of a block.
+         * @return Returns false, if the block is not cached.
+         */
+        bool lookup(unsigned int block_x, unsigned int block_y, RegionStatistics& stats) const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            auto found = blocks.find(std::make_pair(block_x, block_y));
+            if (found == blocks.end()) return false;
+
+            stats = found->second;
+            return true;
+        }
+
+        /**
+         * Cache the statistics of a block.
+         */
+        void store(unsigned int block_x, unsigned int block_y, RegionStatistics const& stats)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            blocks[std::make_pair(block_x, block_y)] = stats;
+        }
+
+        /**
+         * Get the statistics of the whole image.
+         */
+        RegionStatistics get_statistics()
+        {
+            return calculate_statistics<ImageType>(img, 0, 0, img->get_width(), img->get_height(), this);
+        }
+
+        /**
+         * Get the statistics of an image region.
+         * @see calculate_statistics()
+         */
+        RegionStatistics get_statistics(unsigned int start_x, unsigned int start_y,
+                                        unsigned int width, unsigned int height)
+        {
+            return calculate_statistics<ImageType>(img, start_x, start_y, width, height, this);
+        }
+
+        /**
+         * Forget all cached statistics.
+         */
+        void invalidate()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            blocks.clear();
+        }
+
+        /**
+         * Forget the cached statistics of all blocks, that intersect with a region.
+         */
+        void invalidate(BoundingBox const& bounding_box)
+        {
+            const unsigned int block_size = BlockAccessPolicy<ImageType>::get_block_size(img);
+            const unsigned int
+                min_x = static_cast<unsigned int>(std::max(0.f, bounding_box.get_min_x())) / block_size,
+                max_x = static_cast<unsigned int>(std::max(0.f, bounding_box.get_max_x())) / block_size,
+                min_y = static_cast<unsigned int>(std::max(0.f, bounding_box.get_min_y())) / block_size,
+                max_y = static_cast<unsigned int>(std::max(0.f, bounding_box.get_max_y())) / block_size;
+
+            std::lock_guard<std::mutex> lock(mutex);
+
+            for (auto iter = blocks.begin(); iter != blocks.end();)
+            {
+                if (iter->first.first >= min_x && iter->first.first <= max_x &&
+                    iter->first.second >= min_y && iter->first.second <= max_y)
+                    iter = blocks.erase(iter);
+                else ++iter;
+            }
+        }
+    };
+
+
+    /**
+     * Calculate statistics of an image region in a single pass.
+     *
+     * The region is split into blocks, which are processed in parallel. Block results
+     * are merged pairwise. Regions smaller than STATISTICS_MIN_PARALLEL_PIXELS are
+     * processed serially.
+     *
+     * @param img The image.
+     * @param start_x The left border of the region.
+     * @param start_y The upper border of the region.
+     * @param width The width of the region. The region is clipped to the image.
+     * @param height The height of the region.
+     * @param cache If not nullptr, statistics of completely covered blocks are taken from
+     *   and stored in this cache.
+     * @exception DegateRuntimeException This exception is thrown, if the region is empty.
+     */
+    template <typename ImageType>
+    RegionStatistics calculate_statistics(std::shared_ptr<ImageType> img,
+                                          unsigned int start_x, unsigned int start_y,
+                                          unsigned int width, unsigned int height,
+                                          ImageStatisticsCache<ImageType>* cache)
+    {
+        if (img == nullptr) throw InvalidPointerException("Invalid image pointer for calculate_statistics().");
+
+        const unsigned int
+            end_x = std::min(img->get_width(), start_x + width),
+            end_y = std::min(img->get_height(), start_y + height);
 
-        for (unsigned int y = 0; y < img->get_height(); y++)
-            for (unsigned int x = 0; x < img->get_width(); x++)
+        if (start_x >= end_x || start_y >= end_y)
+            throw DegateRuntimeException("Can't calculate statistics for an empty image region.");
+
+        const unsigned int block_size = BlockAccessPolicy<ImageType>::get_block_size(img);
+        const unsigned int
+            first_block_x = start_x / block_size, last_block_x = (end_x - 1) / block_size,
+            first_block_y = start_y / block_size, last_block_y = (end_y - 1) / block_size,
+            blocks_x = last_block_x - first_block_x + 1,
+            blocks_y = last_block_y - first_block_y + 1;
+
+        auto process_block = [&](unsigned int i, RegionStatistics& stats)
+        {
+            const unsigned int block_x = first_block_x + i % blocks_x, block_y = first_block_y + i / blocks_x;
+            const unsigned int
+                block_min_x = block_x * block_size,
+                block_min_y = block_y * block_size,
+                block_max_x = std::min(block_min_x + block_size, img->get_width()),
+                block_max_y = std::min(block_min_y + block_size, img->get_height());
+
+            const unsigned int
+                min_x = std::max(block_min_x, start_x), max_x = std::min(block_max_x, end_x),
+                min_y = std::max(block_min_y, start_y), max_y = std::min(block_max_y, end_y);
+
+            // Only blocks, that are completely covered, are cached.
+            const bool complete = min_x == block_min_x && max_x == block_max_x &&
+                                  min_y == block_min_y && max_y == block_max_y;
+
+            if (complete && cache != nullptr && cache->lookup(block_x, block_y, stats)) return;
+
+            add_region_to_statistics<ImageType>(img, min_x, max_x, min_y, max_y, stats);
+
+            if (complete && cache != nullptr) cache->store(block_x, block_y, stats);
+        };
+
+        // Small regions, like matching windows, are processed serially without allocations.
+        if (static_cast<uint64_t>(end_x - start_x) * (end_y - start_y) < STATISTICS_MIN_PARALLEL_PIXELS ||
+            blocks_x * blocks_y == 1)
+        {
+            RegionStatistics stats;
+            for (unsigned int i = 0; i < blocks_x * blocks_y; i++)
             {
-                typename ImageType::pixel_type p = img->get_pixel(x, y);
-                if (p > maximum) maximum = p;
+                RegionStatistics block_stats;
+                process_block(i, block_stats);
+                stats.merge(block_stats);
             }
-        return maximum;
+
+            return stats;
+        }
+
+        std::vector<RegionStatistics> results(static_cast<std::size_t>(blocks_x) * blocks_y);
+
+        std::function<void(const unsigned int& i)> function = [&](const unsigned int& i)
+        {
+            process_block(i, results[i]);
+        };
+
+        const auto& it = boost::counting_range<unsigned int>(0, static_cast<unsigned int>(results.size()));
+        QtConcurrent::blockingMap(it, function);
+
+        // pairwise merge
+        for (std::size_t step = 1; step < results.size(); step *= 2)
+            for (std::size_t i = 0; i + step < results.size(); i += 2 * step)
+                results[i].merge(results[i + step]);
+
+        return results[0];
+    }
+
+    /**
+     * Calculate statistics of a whole image in a single pass.
+     * @see calculate_statistics()
+     */
+    template <typename ImageType>
+    RegionStatistics calculate_statistics(std::shared_ptr<ImageType> img)
+    {
+        if (img == nullptr) throw InvalidPointerException("Invalid image pointer for calculate_statistics().");
+        return calculate_statistics<ImageType>(img, 0, 0, img->get_width(), img->get_height());
     }
 
+    /**
+     * Calculate statistics of the image region within a bounding box.
+     * @see calculate_statistics()
+     */
+    template <typename ImageType>
+    RegionStatistics calculate_statistics(std::shared_ptr<ImageType> img, BoundingBox const& bounding_box)
+    {
+        const unsigned int
+            min_x = static_cast<unsigned int>(std::max(0.f, std::floor(bounding_box.get_min_x()))),
+            min_y = static_cast<unsigned int>(std::max(0.f, std::floor(bounding_box.get_min_y()))),
+            max_x = static_cast<unsigned int>(std::max(0.f, std::ceil(bounding_box.get_max_x()))),
+            max_y = static_cast<unsigned int>(std::max(0.f, std::ceil(bounding_box.get_max_y())));
+
+        return calculate_statistics<ImageType>(img, min_x, min_y,
+                                               max_x > min_x ? max_x - min_x : 0,
+                                               max_y > min_y ? max_y - min_y : 0);
+    }
 
     /**
-     * Calculate the average pixel value of a single channel image.
-     * If the input image is a multi-channel image, data will be converted on-the-fly.
+     * Get the minimum pixel value of a single channel image.
      */
     template <typename ImageType>
-    double average(std::shared_ptr<ImageType> img)
+    typename ImageType::pixel_type get_minimum(std::shared_ptr<ImageType> img)
     {
-        return average(img, 0, 0, img->get_width(), img->get_height());
+        assert_is_single_channel_image<ImageType>();
+        return static_cast<typename ImageType::pixel_type>(calculate_statistics<ImageType>(img).get_minimum());
+    }
+
+    /**
+     * Get the maximum pixel value of a single channel image.
+     */
+    template <typename ImageType>
+    typename ImageType::pixel_type get_maximum(std::shared_ptr<ImageType> img)
+    {
+        assert_is_single_channel_image<ImageType>();
+        return static_cast<typename ImageType::pixel_type>(calculate_statistics<ImageType>(img).get_maximum());
     }
 
+
     /**
      * Calculate the average pixel value of a single channel image.
      * If the input image is a multi-channel image, data will be converted on-the-fly.
@@ -89,22 +427,24 @@ namespace degate
                    unsigned int start_x, unsigned int start_y,
                    unsigned int width, unsigned int height)
     {
-        double sum = 0;
-
         if (height == 0 || width == 0) throw DegateRuntimeException("Can't calculate average for an image.");
 
-        for (unsigned int y = start_y; y < height; y++)
-            for (unsigned int x = start_x; x < width; x++)
-            {
-                sum += img->template get_pixel_as<double>(x, y);
-            }
-
-        return sum / (double)(height * width);
+        return calculate_statistics<ImageType>(img, start_x, start_y, width, height).get_mean();
     }
 
     /**
      * Calculate the average pixel value of a single channel image.
      * If the input image is a multi-channel image, data will be converted on-the-fly.
+     */
+    template <typename ImageType>
+    double average(std::shared_ptr<ImageType> img)
+    {
+        return average(img, 0, 0, img->get_width(), img->get_height());
+    }
+
+    /**
+     * Calculate the average pixel value and the standard deviation of a single channel image.
+     * If the input image is a multi-channel image, data will be converted on-the-fly.
      * @exception DegateRuntimeException This exception is thrown, if the image area is 0.
      */
     template <typename ImageType>
@@ -113,28 +453,13 @@ namespace degate
                             unsigned int width, unsigned int height,
                             double* avg, double* stddev)
     {
-        double sum = 0;
-
         if (height == 0 || width == 0)
             throw DegateRuntimeException("Can't calculate average for an image.");
 
-        for (unsigned int y = start_y; y < start_y + height; y++)
-            for (unsigned int x = start_x; x < start_x + width; x++)
-            {
-                sum += img->template get_pixel_as<gs_double_pixel_t>(x, y);
-            }
-
-        *avg = sum / (double)(height * width);
-
-        sum = 0;
-
-        for (unsigned int y = start_y; y < start_y + height; y++)
-            for (unsigned int x = start_x; x < start_x + width; x++)
-            {
-                sum += pow(*avg - img->template get_pixel_as<gs_double_pixel_t>(x, y), 2);
-            }
+        RegionStatistics stats = calculate_statistics<ImageType>(img, start_x, start_y, width, height);
 
-        *stddev = sqrt(sum / (double)(height * width));
+        *avg = stats.get_mean();
+        *stddev = stats.get_stddev();
     }
 }
 
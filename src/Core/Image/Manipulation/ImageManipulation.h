@@ -464,8 +464,9 @@ namespace degate
     {
         assert_is_single_channel_image<ImageTypeSrc>();
 
-        typename ImageTypeSrc::pixel_type src_min = get_minimum<ImageTypeSrc>(src);
-        typename ImageTypeSrc::pixel_type src_max = get_maximum<ImageTypeSrc>(src);
+        RegionStatistics stats = calculate_statistics<ImageTypeSrc>(src);
+        auto src_min = static_cast<typename ImageTypeSrc::pixel_type>(stats.get_minimum());
+        auto src_max = static_cast<typename ImageTypeSrc::pixel_type>(stats.get_maximum());
 
         if (src_max - src_min == 0) return;
 
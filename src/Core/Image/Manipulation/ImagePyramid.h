@@ -0,0 +1,281 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __IMAGEPYRAMID_H__
+#define __IMAGEPYRAMID_H__
+
+#include "Core/Image/BlockAccessPolicy.h"
+
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+/**
+ * Number of pyramid levels, that are calculated from one source block in a single pass.
+ */
+#define IMAGE_PYRAMID_LEVELS_PER_PASS 2
+
+namespace degate
+{
+    /**
+     * Average four RGBA pixels channel by channel.
+     *
+     * The even and odd channels are summed in 16 bit lanes of a 32 bit integer (SWAR), so
+     * that loops over rows can be auto-vectorized. Like scale_down_by_2(), the averages are
+     * truncated.
+     */
+    inline rgba_pixel_t average_rgba_pixels(rgba_pixel_t p1, rgba_pixel_t p2, rgba_pixel_t p3, rgba_pixel_t p4)
+    {
+        const uint32_t mask = 0x00ff00ff;
+
+        const uint32_t even = (p1 & mask) + (p2 & mask) + (p3 & mask) + (p4 & mask);
+        const uint32_t odd = ((p1 >> 8) & mask) + ((p2 >> 8) & mask) + ((p3 >> 8) & mask) + ((p4 >> 8) & mask);
+
+        return ((even >> 2) & mask) | (((odd >> 2) & mask) << 8);
+    }
+
+    /**
+     * Scale down a block of RGBA pixels by factor 2.
+     * @param src The source block with \p src_width pixels per row.
+     * @param dst The destination block with \p dst_width x \p dst_height pixels. The
+     *   source block must have at least twice the width and the height.
+     */
+    inline void scale_down_block_by_2(rgba_pixel_t const* src, unsigned int src_width,
+                                      rgba_pixel_t* dst, unsigned int dst_width, unsigned int dst_height)
+    {
+        for (unsigned int y = 0; y < dst_height; y++)
+        {
+            rgba_pixel_t const* row1 = src + static_cast<std::size_t>(2 * y) * src_width;
+            rgba_pixel_t const* row2 = row1 + src_width;
+            rgba_pixel_t* out = dst + static_cast<std::size_t>(y) * dst_width;
+
+            for (unsigned int x = 0; x < dst_width; x++)
+                out[x] = average_rgba_pixels(row1[2 * x], row1[2 * x + 1], row2[2 * x], row2[2 * x + 1]);
+        }
+    }
+
+    /**
+     * Scale down a block of greyscale pixels by factor 2.
+     * @see scale_down_block_by_2()
+     */
+    inline void scale_down_block_by_2(gs_byte_pixel_t const* src, unsigned int src_width,
+                                      gs_byte_pixel_t* dst, unsigned int dst_width, unsigned int dst_height)
+    {
+        for (unsigned int y = 0; y < dst_height; y++)
+        {
+            gs_byte_pixel_t const* row1 = src + static_cast<std::size_t>(2 * y) * src_width;
+            gs_byte_pixel_t const* row2 = row1 + src_width;
+            gs_byte_pixel_t* out = dst + static_cast<std::size_t>(y) * dst_width;
+
+            for (unsigned int x = 0; x < dst_width; x++)
+                out[x] = static_cast<gs_byte_pixel_t>((row1[2 * x] + row1[2 * x + 1] + row2[2 * x] + row2[2 * x + 1]) >> 2);
+        }
+    }
+
+    /**
+     * The pixel type, in which build_image_pyramid() averages the pixels of an image.
+     * Greyscale images are averaged directly, all other images are averaged as RGBA.
+     */
+    template <typename PixelType>
+    struct pyramid_pixel
+    {
+        typedef rgba_pixel_t type;
+    };
+
+    template <>
+    struct pyramid_pixel<gs_byte_pixel_t>
+    {
+        typedef gs_byte_pixel_t type;
+    };
+
+    /**
+     * Build the levels of an image pyramid in parallel.
+     *
+     * Each level is half the size of the previous one (rounded down) and is calculated
+     * like with scale_down_by_2(). The source level is split into blocks of the tile
+     * size of the first scaled level. A task reads one block and calculates
+     * IMAGE_PYRAMID_LEVELS_PER_PASS levels from it in memory. The block of the last of
+     * these levels is part of a block for the next pass. The task, that finishes this
+     * block last, continues with the next pass, so that a block is processed as soon as
+     * its source is complete, while it is still in the cache.
+     *
+     * @param levels The levels of the pyramid. The first entry is the source image, that
+     *   is not modified.
+     * @param min_x, max_x, min_y, max_y The region of the source image, that changed.
+     *   Only the scaled pixels depending on this region are updated.
+     */
+    template <typename ImageType>
+    void build_image_pyramid(std::vector<std::shared_ptr<ImageType>> const& levels,
+                             unsigned int min_x, unsigned int max_x,
+                             unsigned int min_y, unsigned int max_y)
+    {
+        typedef typename ImageType::pixel_type pixel_type;
+        typedef typename pyramid_pixel<pixel_type>::type work_pixel_type;
+
+        if (levels.size() < 2) return;
+
+        max_x = std::min(max_x, levels[0]->get_width());
+        max_y = std::min(max_y, levels[0]->get_height());
+        if (min_x >= max_x || min_y >= max_y) return;
+
+        const unsigned int block_size = BlockAccessPolicy<ImageType>::get_block_size(levels[1]);
+
+        unsigned int levels_per_pass = IMAGE_PYRAMID_LEVELS_PER_PASS;
+        while (levels_per_pass > 1 && (block_size >> levels_per_pass) == 0) levels_per_pass--;
+
+        const unsigned int last_level = static_cast<unsigned int>(levels.size()) - 1;
+        const unsigned int passes = (last_level + levels_per_pass - 1) / levels_per_pass;
+
+        // The blocks per pass. The parent of a block is at (x >> levels_per_pass, y >> levels_per_pass).
+        struct pass_blocks
+        {
+            unsigned int min_x, max_x, min_y, max_y;
+            std::vector<std::atomic<unsigned int>> pending_children;
+
+            inline unsigned int get_width() const { return max_x - min_x + 1; }
+        };
+
+        std::vector<std::unique_ptr<pass_blocks>> blocks(passes);
+
+        for (unsigned int pass = 0; pass < passes; pass++)
+        {
+            blocks[pass].reset(new pass_blocks);
+            pass_blocks& b = *blocks[pass];
+
+            if (pass == 0)
+            {
+                b.min_x = min_x / block_size;
+                b.max_x = (max_x - 1) / block_size;
+                b.min_y = min_y / block_size;
+                b.max_y = (max_y - 1) / block_size;
+            }
+            else
+            {
+                pass_blocks const& children = *blocks[pass - 1];
+                b.min_x = children.min_x >> levels_per_pass;
+                b.max_x = children.max_x >> levels_per_pass;
+                b.min_y = children.min_y >> levels_per_pass;
+                b.max_y = children.max_y >> levels_per_pass;
+
+                std::vector<std::atomic<unsigned int>> pending(static_cast<std::size_t>(b.get_width()) *
+                                                               (b.max_y - b.min_y + 1));
+                b.pending_children.swap(pending);
+                for (auto& p : b.pending_children) p.store(0);
+
+                for (unsigned int y = children.min_y; y <= children.max_y; y++)
+                    for (unsigned int x = children.min_x; x <= children.max_x; x++)
+                        b.pending_children[((y >> levels_per_pass) - b.min_y) * b.get_width() +
+                                           (x >> levels_per_pass) - b.min_x]++;
+            }
+        }
+
+        std::function<void(unsigned int, unsigned int, unsigned int)> process_block =
+            [&](unsigned int pass, unsigned int block_x, unsigned int block_y)
+        {
+            const unsigned int src_level = pass * levels_per_pass;
+
+            // The block in the coordinates of the source level.
+            unsigned int
+                src_min_x = block_x * block_size,
+                src_min_y = block_y * block_size,
+                src_max_x = std::min(src_min_x + block_size, levels[src_level]->get_width()),
+                src_max_y = std::min(src_min_y + block_size, levels[src_level]->get_height());
+
+            if (src_min_x < src_max_x && src_min_y < src_max_y)
+            {
+                std::vector<pixel_type> pixels(static_cast<std::size_t>(src_max_x - src_min_x) * (src_max_y - src_min_y));
+                BlockAccessPolicy<ImageType>::read(levels[src_level], src_min_x, src_max_x, src_min_y, src_max_y,
+                                                   pixels.data());
+
+                std::vector<work_pixel_type> src(pixels.size());
+                for (std::size_t i = 0; i < pixels.size(); i++)
+                    src[i] = convert_pixel<work_pixel_type, pixel_type>(pixels[i]);
+
+                std::vector<work_pixel_type> dst;
+
+                for (unsigned int level = src_level + 1;
+                     level <= std::min(src_level + levels_per_pass, last_level); level++)
+                {
+                    const unsigned int
+                        dst_min_x = src_min_x / 2,
+                        dst_min_y = src_min_y / 2,
+                        dst_max_x = std::min(src_max_x / 2, levels[level]->get_width()),
+                        dst_max_y = std::min(src_max_y / 2, levels[level]->get_height());
+
+                    if (dst_min_x >= dst_max_x || dst_min_y >= dst_max_y) break;
+
+                    dst.resize(static_cast<std::size_t>(dst_max_x - dst_min_x) * (dst_max_y - dst_min_y));
+                    scale_down_block_by_2(src.data(), src_max_x - src_min_x,
+                                          dst.data(), dst_max_x - dst_min_x, dst_max_y - dst_min_y);
+
+                    pixels.resize(dst.size());
+                    for (std::size_t i = 0; i < dst.size(); i++)
+                        pixels[i] = convert_pixel<pixel_type, work_pixel_type>(dst[i]);
+
+                    BlockAccessPolicy<ImageType>::write(levels[level], dst_min_x, dst_max_x, dst_min_y, dst_max_y,
+                                                        pixels.data());
+
+                    src.swap(dst);
+                    src_min_x = dst_min_x;
+                    src_min_y = dst_min_y;
+                    src_max_x = dst_max_x;
+                    src_max_y = dst_max_y;
+                }
+            }
+
+            // The last child of a block continues with it.
+            if (pass + 1 < passes)
+            {
+                pass_blocks& parents = *blocks[pass + 1];
+                const unsigned int parent_x = block_x >> levels_per_pass, parent_y = block_y >> levels_per_pass;
+
+                if (--parents.pending_children[(parent_y - parents.min_y) * parents.get_width() +
+                                               parent_x - parents.min_x] == 0)
+                    process_block(pass + 1, parent_x, parent_y);
+            }
+        };
+
+        pass_blocks const& first = *blocks[0];
+
+        std::function<void(const unsigned int& i)> function = [&](const unsigned int& i)
+        {
+            process_block(0, first.min_x + i % first.get_width(), first.min_y + i / first.get_width());
+        };
+
+        const auto& it = boost::counting_range<unsigned int>(0, first.get_width() * (first.max_y - first.min_y + 1));
+        QtConcurrent::blockingMap(it, function);
+    }
+
+    /**
+     * Build all levels of an image pyramid in parallel.
+     * @see build_image_pyramid()
+     */
+    template <typename ImageType>
+    void build_image_pyramid(std::vector<std::shared_ptr<ImageType>> const& levels)
+    {
+        if (levels.empty()) return;
+
+        build_image_pyramid<ImageType>(levels, 0, levels[0]->get_width(), 0, levels[0]->get_height());
+    }
+}
+
+#endif
@@ -22,6 +22,12 @@
 #ifndef __MORPHOLOGICALFILTER_H__
 #define __MORPHOLOGICALFILTER_H__
 
+#include "Core/Image/BlockAccessPolicy.h"
+
+#include <limits>
+#include <vector>
+#include <algorithm>
+
 namespace degate
 {
     /**
@@ -57,8 +63,115 @@ namespace degate
     };
 
 
+    /**
+     * Filter an image by the number of non-zero pixels in a square kernel.
+     *
+     * This calculates the same as filter_image() with ErodeImagePolicy or
+     * DilateImagePolicy, but counts with sliding window sums in O(1) per pixel.
+     * The image is processed in blocks in parallel. Each block reads a halo of
+     * the kernel size around it.
+     *
+     * @param erode If true, a pixel is set to 0 if there are at most \p threshold
+     *   non-zero pixels in the kernel. If false, a pixel is set to 1 if there are
+     *   at least \p threshold non-zero pixels. Other pixels are copied.
+     * @exception DegateRuntimeException This exception is thrown, if the kernel is
+     *   to small, if the images are to small or if \p dst and \p src are the same image.
+     */
+    template <typename ImageTypeDst, typename ImageTypeSrc>
+    void count_filter_image(std::shared_ptr<ImageTypeDst> dst,
+                            std::shared_ptr<ImageTypeSrc> src,
+                            unsigned int kernel_width,
+                            unsigned int threshold,
+                            bool erode)
+    {
+        typedef typename ImageTypeSrc::pixel_type src_pixel_type;
+        typedef typename ImageTypeDst::pixel_type dst_pixel_type;
+
+        if (kernel_width <= 1)
+            throw DegateRuntimeException("Error in count_filter_image(). Kernel width is to small.");
+
+        if (static_cast<void*>(dst.get()) == static_cast<void*>(src.get()))
+            throw DegateRuntimeException("Error in count_filter_image(). Source and destination must differ.");
+
+        unsigned int width = std::min(src->get_width(), dst->get_width());
+        unsigned int height = std::min(src->get_height(), dst->get_height());
+
+        if (width < kernel_width || height < kernel_width)
+            throw DegateRuntimeException("Error in count_filter_image(). One of the images is to small.");
+
+        const unsigned int kernel_center = kernel_width / 2;
+
+        // the same output region as filter_image()
+        width -= (kernel_width - kernel_center);
+        height -= (kernel_width - kernel_center);
+
+        for_each_block<ImageTypeDst>(dst, kernel_center, width, kernel_center, height,
+                                     [&](unsigned int min_x, unsigned int max_x, unsigned int min_y, unsigned int max_y)
+        {
+            // block with halo
+            const unsigned int
+                in_min_x = min_x - kernel_center, in_max_x = max_x - kernel_center + kernel_width,
+                in_min_y = min_y - kernel_center, in_max_y = max_y - kernel_center + kernel_width,
+                in_w = in_max_x - in_min_x, in_h = in_max_y - in_min_y,
+                out_w = max_x - min_x, out_h = max_y - min_y;
+
+            std::vector<src_pixel_type> in(static_cast<std::size_t>(in_w) * in_h);
+            BlockAccessPolicy<ImageTypeSrc>::read(src, in_min_x, in_max_x, in_min_y, in_max_y, in.data());
+
+            // horizontal sums of non-zero pixels
+            std::vector<unsigned int> row_counts(static_cast<std::size_t>(out_w) * in_h);
+            for (unsigned int y = 0; y < in_h; y++)
+            {
+                const src_pixel_type* row = &in[static_cast<std::size_t>(y) * in_w];
+                unsigned int* counts = &row_counts[static_cast<std::size_t>(y) * out_w];
+
+                unsigned int count = 0;
+                for (unsigned int x = 0; x < kernel_width; x++)
+                    if (row[x] > 0) count++;
+
+                counts[0] = count;
+                for (unsigned int x = 1; x < out_w; x++)
+                {
+                    if (row[x - 1] > 0) count--;
+                    if (row[x + kernel_width - 1] > 0) count++;
+                    counts[x] = count;
+                }
+            }
+
+            // vertical sums of the horizontal sums
+            std::vector<dst_pixel_type> out(static_cast<std::size_t>(out_w) * out_h);
+            std::vector<unsigned int> column_counts(out_w, 0);
+
+            for (unsigned int y = 0; y < kernel_width; y++)
+                for (unsigned int x = 0; x < out_w; x++)
+                    column_counts[x] += row_counts[static_cast<std::size_t>(y) * out_w + x];
+
+            for (unsigned int y = 0; y < out_h; y++)
+            {
+                if (y > 0)
+                    for (unsigned int x = 0; x < out_w; x++)
+                        column_counts[x] += row_counts[static_cast<std::size_t>(y + kernel_width - 1) * out_w + x] -
+                                            row_counts[static_cast<std::size_t>(y - 1) * out_w + x];
+
+                for (unsigned int x = 0; x < out_w; x++)
+                {
+                    src_pixel_type p = in[static_cast<std::size_t>(y + kernel_center) * in_w + x + kernel_center];
+
+                    if (erode) p = column_counts[x] <= threshold ? 0 : p;
+                    else p = column_counts[x] >= threshold ? 1 : p;
+
+                    out[static_cast<std::size_t>(y) * out_w + x] = convert_pixel<dst_pixel_type, src_pixel_type>(p);
+                }
+            }
+
+            BlockAccessPolicy<ImageTypeDst>::write(dst, min_x, max_x, min_y, max_y, out.data());
+        });
+    }
+
+
     /**
      * Filter an image with an erosion filter.
+     * @see count_filter_image()
      */
     template <typename ImageTypeDst, typename ImageTypeSrc>
     void erode_image(std::shared_ptr<ImageTypeDst> dst,
@@ -66,9 +179,7 @@ namespace degate
                      unsigned int kernel_width = 3,
                      unsigned int erosion_threshold = 3)
     {
-        filter_image<ImageTypeDst, ImageTypeSrc,
-                     ErodeImagePolicy<ImageTypeSrc, typename ImageTypeSrc::pixel_type>>
-            (dst, src, kernel_width, erosion_threshold);
+        count_filter_image<ImageTypeDst, ImageTypeSrc>(dst, src, kernel_width, erosion_threshold, true);
     }
 
 
@@ -105,7 +216,8 @@ namespace degate
 
 
     /**
-     * Filter an image with an erosion filter.
+     * Filter an image with a dilation filter.
+     * @see count_filter_image()
      */
     template <typename ImageTypeDst, typename ImageTypeSrc>
     void dilate_image(std::shared_ptr<ImageTypeDst> dst,
@@ -113,14 +225,166 @@ namespace degate
                       unsigned int kernel_width = 3,
                       unsigned int dilation_threshold = 3)
     {
-        filter_image<ImageTypeDst, ImageTypeSrc,
-                     DilateImagePolicy<ImageTypeSrc, typename ImageTypeSrc::pixel_type>>
-            (dst, src, kernel_width, dilation_threshold);
+        count_filter_image<ImageTypeDst, ImageTypeSrc>(dst, src, kernel_width, dilation_threshold, false);
     }
 
 
     /**
-     * Morphological open.
+     * Calculate the minimum or maximum of all windows of length \p k in a sequence
+     * with the van Herk/Gil-Werman algorithm, that needs three comparisons per element
+     * independent of \p k.
+     * @param in The input sequence with \p n elements and a distance of \p in_stride.
+     * @param out The output sequence with n - k + 1 elements and a distance of \p out_stride.
+     * @param prefix, suffix Buffers with at least \p n elements.
+     */
+    template <typename T, typename Compare>
+    void van_herk_gil_werman(T const* in, std::size_t in_stride, std::size_t n, unsigned int k,
+                             T* out, std::size_t out_stride,
+                             T* prefix, T* suffix, Compare compare)
+    {
+        if (n < k) return;
+
+        auto select = [&compare](T a, T b) { return compare(a, b) ? a : b; };
+
+        for (std::size_t block = 0; block < n; block += k)
+        {
+            const std::size_t end = std::min(block + k, n);
+
+            prefix[block] = in[block * in_stride];
+            for (std::size_t i = block + 1; i < end; i++)
+                prefix[i] = select(prefix[i - 1], in[i * in_stride]);
+
+            suffix[end - 1] = in[(end - 1) * in_stride];
+            for (std::size_t i = end - 1; i > block; i--)
+                suffix[i - 1] = select(suffix[i], in[(i - 1) * in_stride]);
+        }
+
+        for (std::size_t i = 0; i + k <= n; i++)
+            out[i * out_stride] = select(suffix[i], prefix[i + k - 1]);
+    }
+
+    /**
+     * Filter a single channel image with the minimum or maximum over a rectangular
+     * structuring element in O(1) per pixel.
+     *
+     * The element is centered like in filter_image(). Near the image border only the part
+     * of the element within the image is considered. The image is processed in blocks in
+     * parallel, each reading a halo of the element size around it.
+     *
+     * @param compare Returns true, if the first value is selected.
+     * @exception DegateRuntimeException This exception is thrown, if \p dst and \p src
+     *   are the same image.
+     */
+    template <typename ImageTypeDst, typename ImageTypeSrc, typename Compare>
+    void rank_filter_image(std::shared_ptr<ImageTypeDst> dst,
+                           std::shared_ptr<ImageTypeSrc> src,
+                           unsigned int kernel_width,
+                           unsigned int kernel_height,
+                           typename ImageTypeSrc::pixel_type identity,
+                           Compare compare)
+    {
+        typedef typename ImageTypeSrc::pixel_type src_pixel_type;
+        typedef typename ImageTypeDst::pixel_type dst_pixel_type;
+
+        assert_is_single_channel_image<ImageTypeSrc>();
+
+        if (static_cast<void*>(dst.get()) == static_cast<void*>(src.get()))
+            throw DegateRuntimeException("Error in rank_filter_image(). Source and destination must differ.");
+
+        kernel_width = std::max(kernel_width, 1u);
+        kernel_height = std::max(kernel_height, 1u);
+
+        const unsigned int width = std::min(src->get_width(), dst->get_width());
+        const unsigned int height = std::min(src->get_height(), dst->get_height());
+        const unsigned int center_x = kernel_width / 2, center_y = kernel_height / 2;
+
+        for_each_block<ImageTypeDst>(dst, 0, width, 0, height,
+                                     [&](unsigned int min_x, unsigned int max_x, unsigned int min_y, unsigned int max_y)
+        {
+            // The block with halo is padded with the identity, where it exceeds the image.
+            const int
+                pad_min_x = static_cast<int>(min_x) - static_cast<int>(center_x),
+                pad_min_y = static_cast<int>(min_y) - static_cast<int>(center_y);
+            const unsigned int
+                out_w = max_x - min_x, out_h = max_y - min_y,
+                in_w = out_w + kernel_width - 1, in_h = out_h + kernel_height - 1,
+                read_min_x = static_cast<unsigned int>(std::max(pad_min_x, 0)),
+                read_min_y = static_cast<unsigned int>(std::max(pad_min_y, 0)),
+                read_max_x = std::min(static_cast<unsigned int>(pad_min_x + in_w), width),
+                read_max_y = std::min(static_cast<unsigned int>(pad_min_y + in_h), height),
+                read_w = read_max_x - read_min_x;
+
+            std::vector<src_pixel_type> read((read_max_x - read_min_x) * static_cast<std::size_t>(read_max_y - read_min_y));
+            BlockAccessPolicy<ImageTypeSrc>::read(src, read_min_x, read_max_x, read_min_y, read_max_y, read.data());
+
+            std::vector<src_pixel_type> in(static_cast<std::size_t>(in_w) * in_h, identity);
+            for (unsigned int y = read_min_y; y < read_max_y; y++)
+                std::copy_n(&read[static_cast<std::size_t>(y - read_min_y) * read_w], read_w,
+                            &in[static_cast<std::size_t>(y - pad_min_y) * in_w + (read_min_x - pad_min_x)]);
+
+            std::vector<src_pixel_type> prefix(std::max(in_w, in_h)), suffix(std::max(in_w, in_h));
+
+            // horizontal pass
+            std::vector<src_pixel_type> rows(static_cast<std::size_t>(out_w) * in_h);
+            for (unsigned int y = 0; y < in_h; y++)
+                van_herk_gil_werman(&in[static_cast<std::size_t>(y) * in_w], 1, in_w, kernel_width,
+                                    &rows[static_cast<std::size_t>(y) * out_w], 1,
+                                    prefix.data(), suffix.data(), compare);
+
+            // vertical pass
+            std::vector<src_pixel_type> columns(static_cast<std::size_t>(out_w) * out_h);
+            for (unsigned int x = 0; x < out_w; x++)
+                van_herk_gil_werman(&rows[x], out_w, in_h, kernel_height,
+                                    &columns[x], out_w,
+                                    prefix.data(), suffix.data(), compare);
+
+            std::vector<dst_pixel_type> out(columns.size());
+            for (std::size_t i = 0; i < columns.size(); i++)
+                out[i] = convert_pixel<dst_pixel_type, src_pixel_type>(columns[i]);
+
+            BlockAccessPolicy<ImageTypeDst>::write(dst, min_x, max_x, min_y, max_y, out.data());
+        });
+    }
+
+    /**
+     * Erode a single channel image with a rectangular structuring element. Each pixel
+     * is set to the minimum within the element.
+     * @see rank_filter_image()
+     */
+    template <typename ImageTypeDst, typename ImageTypeSrc>
+    void erode_image_rect(std::shared_ptr<ImageTypeDst> dst,
+                          std::shared_ptr<ImageTypeSrc> src,
+                          unsigned int kernel_width = 3,
+                          unsigned int kernel_height = 3)
+    {
+        typedef typename ImageTypeSrc::pixel_type pixel_type;
+
+        rank_filter_image<ImageTypeDst, ImageTypeSrc>(dst, src, kernel_width, kernel_height,
+                                                      std::numeric_limits<pixel_type>::max(),
+                                                      [](pixel_type a, pixel_type b) { return a < b; });
+    }
+
+    /**
+     * Dilate a single channel image with a rectangular structuring element. Each pixel
+     * is set to the maximum within the element.
+     * @see rank_filter_image()
+     */
+    template <typename ImageTypeDst, typename ImageTypeSrc>
+    void dilate_image_rect(std::shared_ptr<ImageTypeDst> dst,
+                           std::shared_ptr<ImageTypeSrc> src,
+                           unsigned int kernel_width = 3,
+                           unsigned int kernel_height = 3)
+    {
+        typedef typename ImageTypeSrc::pixel_type pixel_type;
+
+        rank_filter_image<ImageTypeDst, ImageTypeSrc>(dst, src, kernel_width, kernel_height,
+                                                      std::numeric_limits<pixel_type>::lowest(),
+                                                      [](pixel_type a, pixel_type b) { return a > b; });
+    }
+
+
+    /**
+     * Morphological open: an erosion followed by a dilation of the eroded image.
      */
     template <typename ImageTypeDst, typename ImageTypeSrc>
     void morphological_open(std::shared_ptr<ImageTypeDst> dst,
@@ -129,18 +393,17 @@ namespace degate
                             unsigned int threshold_dilate = 1,
                             unsigned int threshold_erode = 3)
     {
-        filter_image<ImageTypeDst, ImageTypeSrc,
-                     ErodeImagePolicy<ImageTypeSrc, typename ImageTypeSrc::pixel_type>>(
-            dst, src, kernel_width, threshold_erode);
+        std::shared_ptr<ImageTypeDst> tmp = std::make_shared<ImageTypeDst>(dst->get_width(), dst->get_height());
+        copy_image<ImageTypeDst, ImageTypeSrc>(tmp, src);
 
-        filter_image<ImageTypeDst, ImageTypeSrc,
-                     DilateImagePolicy<ImageTypeSrc, typename ImageTypeSrc::pixel_type>>(
-            dst, src, kernel_width, threshold_dilate);
+        erode_image<ImageTypeDst, ImageTypeSrc>(tmp, src, kernel_width, threshold_erode);
+        copy_image<ImageTypeDst, ImageTypeDst>(dst, tmp);
+        dilate_image<ImageTypeDst, ImageTypeDst>(dst, tmp, kernel_width, threshold_dilate);
     }
 
 
     /**
-     * Morphological close.
+     * Morphological close: a dilation followed by an erosion of the dilated image.
      */
     template <typename ImageTypeDst, typename ImageTypeSrc>
     void morphological_close(std::shared_ptr<ImageTypeDst> dst,
@@ -149,106 +412,179 @@ namespace degate
                              unsigned int threshold_dilate = 1,
                              unsigned int threshold_erode = 3)
     {
-        filter_image<ImageTypeDst, ImageTypeSrc,
-                     DilateImagePolicy<ImageTypeSrc, typename ImageTypeSrc::pixel_type>>(
-            dst, src, kernel_width, threshold_dilate);
+        std::shared_ptr<ImageTypeDst> tmp = std::make_shared<ImageTypeDst>(dst->get_width(), dst->get_height());
+        copy_image<ImageTypeDst, ImageTypeSrc>(tmp, src);
 
-        filter_image<ImageTypeDst, ImageTypeSrc,
-                     ErodeImagePolicy<ImageTypeSrc, typename ImageTypeSrc::pixel_type>>(
-            dst, src, kernel_width, threshold_erode);
+        dilate_image<ImageTypeDst, ImageTypeSrc>(tmp, src, kernel_width, threshold_dilate);
+        copy_image<ImageTypeDst, ImageTypeDst>(dst, tmp);
+        erode_image<ImageTypeDst, ImageTypeDst>(dst, tmp, kernel_width, threshold_erode);
     }
 
 
     /**
-     * Helper function for the Zhang-Suen-Thinning.
-     * @param img The image.
+     * Check the Zhang-Suen deletion condition for a pixel of a binary image.
+     * @param img The image with one byte per pixel. Bit 0 is set for foreground pixels.
      * @param condition_switch If true, the first condition set is checked. If false,
      *   the second condition set is checked.
      */
+    inline bool zhang_suen_deletable(unsigned char const* img, std::size_t width,
+                                     std::size_t x, std::size_t y, bool condition_switch)
+    {
+        auto pixel = [&](std::size_t _x, std::size_t _y) -> unsigned int { return img[_y * width + _x] & 1; };
+
+        unsigned int
+            p2 = pixel(x, y - 1),
+            p3 = pixel(x + 1, y - 1),
+            p4 = pixel(x + 1, y),
+            p5 = pixel(x + 1, y + 1),
+            p6 = pixel(x, y + 1),
+            p7 = pixel(x - 1, y + 1),
+            p8 = pixel(x - 1, y),
+            p9 = pixel(x - 1, y - 1);
+
+        unsigned int connectivity =
+            (p2 == 0 && p3 == 1 ? 1 : 0) +
+            (p3 == 0 && p4 == 1 ? 1 : 0) +
+            (p4 == 0 && p5 == 1 ? 1 : 0) +
+            (p5 == 0 && p6 == 1 ? 1 : 0) +
+            (p6 == 0 && p7 == 1 ? 1 : 0) +
+            (p7 == 0 && p8 == 1 ? 1 : 0) +
+            (p8 == 0 && p9 == 1 ? 1 : 0) +
+            (p9 == 0 && p2 == 1 ? 1 : 0);
+
+        unsigned int non_zero_neighbors = p2 + p3 + p4 + p5 + p6 + p7 + p8 + p9;
+
+        if (non_zero_neighbors < 2 || non_zero_neighbors > 6 || connectivity != 1) return false;
+
+        if (condition_switch) return p2 * p4 * p6 == 0 && p4 * p6 * p8 == 0;
+        else return p2 * p4 * p8 == 0 && p2 * p6 * p8 == 0;
+    }
+
+    /**
+     * Zhang-Suen-Thinning of an image.
+     *
+     * Pixel values evaluate to 1 if they are > 0. Thinned pixels are set to 0.
+     * The image is read into a binary buffer and written back block-parallel. Each
+     * sub-iteration marks the deletable pixels in parallel and deletes them at once.
+     * Only pixels, whose neighbourhood changed since they were last checked, are
+     * checked again.
+     */
     template <typename ImageType>
-    bool zhang_suen_thinning_iteration(std::shared_ptr<ImageType> img,
-                                       bool condition_switch)
+    void thinning(std::shared_ptr<ImageType> img)
     {
+        typedef typename ImageType::pixel_type pixel_type;
+
         assert_is_single_channel_image<ImageType>();
 
-        bool running = false;
-        unsigned int x, y;
+        const std::size_t width = img->get_width(), height = img->get_height();
+        if (width < 3 || height < 3) return;
+
+        // Bit 0: foreground, bit 1 and 2: pending for the first or second condition set.
+        const unsigned char FOREGROUND = 1;
+        std::vector<unsigned char> binary(width * height, 0);
 
-        for (y = 1; y < img->get_height() - 1; y++)
+        for_each_block<ImageType>(img, 0, width, 0, height,
+                                  [&](unsigned int min_x, unsigned int max_x, unsigned int min_y, unsigned int max_y)
         {
-            for (x = 1; x < img->get_width() - 1; x++)
-            {
-                unsigned int
-                    p1 = img->get_pixel(x, y) > 0 ? 1 : 0;
+            std::vector<pixel_type> pixels(static_cast<std::size_t>(max_x - min_x) * (max_y - min_y));
+            BlockAccessPolicy<ImageType>::read(img, min_x, max_x, min_y, max_y, pixels.data());
+
+            auto p = pixels.begin();
+            for (unsigned int y = min_y; y < max_y; y++)
+                for (unsigned int x = min_x; x < max_x; x++, ++p)
+                    binary[y * width + x] = *p > 0 ? FOREGROUND : 0;
+        });
 
-                if (p1 > 0)
+        std::vector<std::size_t> pending[2];
+
+        auto enqueue = [&](std::size_t i)
+        {
+            for (unsigned int s = 0; s < 2; s++)
+            {
+                const unsigned char flag = 2 << s;
+                if ((binary[i] & flag) == 0)
                 {
-                    unsigned int
-                        p2 = img->get_pixel(x, y - 1) > 0 ? 1 : 0,
-                        p3 = img->get_pixel(x + 1, y - 1) > 0 ? 1 : 0,
-                        p4 = img->get_pixel(x + 1, y) > 0 ? 1 : 0,
-                        p5 = img->get_pixel(x + 1, y + 1) > 0 ? 1 : 0,
-                        p6 = img->get_pixel(x, y + 1) > 0 ? 1 : 0,
-                        p7 = img->get_pixel(x - 1, y + 1) > 0 ? 1 : 0,
-                        p8 = img->get_pixel(x - 1, y) > 0 ? 1 : 0,
-                        p9 = img->get_pixel(x - 1, y - 1) > 0 ? 1 : 0;
-
-                    unsigned int connectivity =
-                        (p2 == 0 && p3 == 1 ? 1 : 0) +
-                        (p3 == 0 && p4 == 1 ? 1 : 0) +
-                        (p4 == 0 && p5 == 1 ? 1 : 0) +
-                        (p5 == 0 && p6 == 1 ? 1 : 0) +
-                        (p6 == 0 && p7 == 1 ? 1 : 0) +
-                        (p7 == 0 && p8 == 1 ? 1 : 0) +
-                        (p8 == 0 && p9 == 1 ? 1 : 0) +
-                        (p9 == 0 && p2 == 1 ? 1 : 0);
-
-                    unsigned int non_zero_neighbors = p2 + p3 + p4 + p5 + p6 + p7 + p8 + p9;
-
-
-                    if (2 <= non_zero_neighbors && non_zero_neighbors <= 6 &&
-                        connectivity == 1)
-                    {
-                        if (condition_switch == true)
-                        {
-                            if (p2 * p4 * p6 == 0 && p4 * p6 * p8 == 0)
-                            {
-                                img->set_pixel(x, y, 0);
-                                running = true;
-                            }
-                        }
-                        else
-                        {
-                            if (p2 * p4 * p8 == 0 && p2 * p6 * p8 == 0)
-                            {
-                                img->set_pixel(x, y, 0);
-                                running = true;
-                            }
-                        }
-                    }
+                    binary[i] |= flag;
+                    pending[s].push_back(i);
                 }
             }
-        }
+        };
 
-        return running;
-    }
+        // Only foreground pixels with a background neighbour can be deleted.
+        for (std::size_t y = 1; y < height - 1; y++)
+            for (std::size_t x = 1; x < width - 1; x++)
+            {
+                const std::size_t i = y * width + x;
+                if ((binary[i] & FOREGROUND) == 0) continue;
 
-    /**
-     * Zhang-Suen-Thinning of an image.
-     */
-    template <typename ImageType>
-    void thinning(std::shared_ptr<ImageType> img)
-    {
-        assert_is_single_channel_image<ImageType>();
+                bool border = false;
+                for (int dy = -1; dy <= 1 && !border; dy++)
+                    for (int dx = -1; dx <= 1 && !border; dx++)
+                        if ((binary[i + dy * width + dx] & FOREGROUND) == 0) border = true;
 
-        bool running = true;
+                if (border) enqueue(i);
+            }
+
+        const unsigned int chunk_size = 4096;
 
-        do
+        for (unsigned int s = 0; !pending[0].empty() || !pending[1].empty(); s = 1 - s)
         {
-            running = zhang_suen_thinning_iteration(img, true);
-            running = zhang_suen_thinning_iteration(img, false);
+            std::vector<std::size_t> candidates;
+            candidates.swap(pending[s]);
+            for (std::size_t i : candidates) binary[i] &= ~(2 << s);
+
+            // Mark in parallel. The buffer is not modified meanwhile.
+            const unsigned int chunks = static_cast<unsigned int>((candidates.size() + chunk_size - 1) / chunk_size);
+            std::vector<std::vector<std::size_t>> deletions(chunks);
+
+            std::function<void(const unsigned int& c)> function = [&](const unsigned int& c)
+            {
+                const std::size_t end = std::min(candidates.size(), static_cast<std::size_t>(c + 1) * chunk_size);
+                for (std::size_t n = static_cast<std::size_t>(c) * chunk_size; n < end; n++)
+                {
+                    const std::size_t i = candidates[n];
+                    if ((binary[i] & FOREGROUND) &&
+                        zhang_suen_deletable(binary.data(), width, i % width, i / width, s == 0))
+                        deletions[c].push_back(i);
+                }
+            };
+
+            const auto& it = boost::counting_range<unsigned int>(0, chunks);
+            QtConcurrent::blockingMap(it, function);
+
+            // Delete and revisit the neighbourhood.
+            for (auto const& chunk : deletions)
+                for (std::size_t i : chunk) binary[i] &= ~FOREGROUND;
+
+            for (auto const& chunk : deletions)
+                for (std::size_t i : chunk)
+                {
+                    const std::size_t x = i % width, y = i / width;
+                    for (std::size_t ny = std::max<std::size_t>(y - 1, 1); ny <= std::min(y + 1, height - 2); ny++)
+                        for (std::size_t nx = std::max<std::size_t>(x - 1, 1); nx <= std::min(x + 1, width - 2); nx++)
+                            if (binary[ny * width + nx] & FOREGROUND) enqueue(ny * width + nx);
+                }
         }
-        while (running);
+
+        // Write back the deleted pixels.
+        for_each_block<ImageType>(img, 0, width, 0, height,
+                                  [&](unsigned int min_x, unsigned int max_x, unsigned int min_y, unsigned int max_y)
+        {
+            std::vector<pixel_type> pixels(static_cast<std::size_t>(max_x - min_x) * (max_y - min_y));
+            BlockAccessPolicy<ImageType>::read(img, min_x, max_x, min_y, max_y, pixels.data());
+
+            bool changed = false;
+            auto p = pixels.begin();
+            for (unsigned int y = min_y; y < max_y; y++)
+                for (unsigned int x = min_x; x < max_x; x++, ++p)
+                    if (*p > 0 && (binary[y * width + x] & FOREGROUND) == 0)
+                    {
+                        *p = 0;
+                        changed = true;
+                    }
+
+            if (changed) BlockAccessPolicy<ImageType>::write(img, min_x, max_x, min_y, max_y, pixels.data());
+        });
     }
 }
 #endif
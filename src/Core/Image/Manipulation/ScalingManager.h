@@ -23,8 +23,11 @@
 #define __SCALINGMANAGER_H__
 
 #include "Core/Image/Image.h"
+#include "Core/Image/Manipulation/ImagePyramid.h"
 
 #include <map>
+#include <cmath>
+#include <vector>
 #include <cassert>
 #include <algorithm>
 
@@ -127,18 +130,25 @@ namespace degate
          * Create the scaled images.
          * Created prescaled images that have the same peristence state as the
          * master image. The files are written into the directory, where the
-         * master image is stored.
+         * master image is stored. Scaled images, that already exist, are reused.
+         * Missing ones are built in parallel.
          * @throw InvalidPathException This exception is thrown, if the
          *   \p directory (ctor param) doesn't exists.
+         * @see build_image_pyramid()
          */
         void create_scalings()
         {
             if (!(file_exists(base_directory) && is_directory(base_directory)))
                 throw InvalidPathException("The directory for prescaled images must exist. but it is not there.");
 
-            std::shared_ptr<ImageType> last_img = images[1];
-            unsigned int w = last_img->get_width();
-            unsigned int h = last_img->get_height();
+            std::vector<std::shared_ptr<ImageType>> levels;
+            levels.push_back(images[1]);
+
+            // The first level, that must be built.
+            unsigned int first_missing = 0;
+
+            unsigned int w = images[1]->get_width();
+            unsigned int h = images[1]->get_height();
 
             for (int i = 2; ((h > min_size) || (w > min_size)) &&
                  (i < (1 << 24)); // max 24 scaling levels
@@ -158,21 +168,25 @@ namespace degate
                     debug(TM, "yes");
                     create_directory(dir_path);
 
-                    std::shared_ptr<ImageType> new_img(new ImageType(w, h, dir_path,
-                                                                     images[1]->is_persistent()));
-
-                    scale_down_by_2<ImageType, ImageType>(new_img, last_img);
-                    last_img = new_img;
+                    if (first_missing == 0) first_missing = static_cast<unsigned int>(levels.size());
                 }
-                else
-                {
-                    debug(TM, "no");
-                    std::shared_ptr<ImageType> new_img(new ImageType(w, h, dir_path,
-                                                                     images[1]->is_persistent()));
+                else debug(TM, "no");
 
-                    last_img = new_img;
-                }
-                images[i] = last_img;
+                std::shared_ptr<ImageType> new_img(new ImageType(w, h, dir_path,
+                                                                 images[1]->is_persistent()));
+
+                levels.push_back(new_img);
+                images[i] = new_img;
+            }
+
+            if (first_missing > 0)
+            {
+                levels[first_missing - 1]->set_access_pattern(TileContainer::ACCESS_SEQUENTIAL);
+
+                build_image_pyramid<ImageType>(std::vector<std::shared_ptr<ImageType>>(levels.begin() + first_missing - 1,
+                                                                                       levels.end()));
+
+                levels[first_missing - 1]->set_access_pattern(TileContainer::ACCESS_NORMAL);
             }
         }
 
@@ -213,6 +227,11 @@ namespace degate
      * A typedef for scaling managers that handle background images.
      */
     typedef std::shared_ptr<ScalingManager<BackgroundImage>> ScalingManager_shptr;
+
+    /**
+     * A typedef for scaling managers that handle greyscale background images.
+     */
+    typedef std::shared_ptr<ScalingManager<GreyscaleBackgroundImage>> GreyscaleScalingManager_shptr;
 }
 
 #endif
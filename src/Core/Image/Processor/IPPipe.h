@@ -25,11 +25,16 @@
 #include <string>
 #include "Core/Image/Processor/ImageProcessorBase.h"
 #include "Core/Utils/ProgressControl.h"
+#include "Core/Utils/Trace.h"
 
 namespace degate
 {
     /**
      * Represents an image processing pipe for multiple image processors.
+     *
+     * The processors are sub progresses of the pipe, each with the same share. So the
+     * progress of the pipe follows the processors and canceling the pipe cancels the
+     * running processor.
      */
     class IPPipe : public ProgressControl
     {
@@ -89,8 +94,18 @@ namespace degate
         {
             assert(img_in != nullptr);
 
+            TRACE_SCOPE_CATEGORY("pipe", "pipe");
+
             ImageBase_shptr last_img = img_in;
 
+            reset_progress();
+
+            for (auto& ip : processor_list)
+            {
+                ip->reset_progress();
+                add_sub_progress(ip, 1.0 / static_cast<double>(processor_list.size()));
+            }
+
             // iterate over list
             for (processor_list_type::iterator iter = processor_list.begin();
                  iter != processor_list.end(); ++iter)
@@ -98,8 +113,14 @@ namespace degate
                 ImageProcessorBase_shptr ip = *iter;
 
                 assert(last_img != nullptr);
-                last_img = ip->run(last_img);
+                {
+                    TraceScope trace_scope(ip->get_name().c_str(), "pipe");
+                    last_img = ip->run(last_img);
+                }
                 assert(last_img != nullptr);
+
+                // Processors, that don't report progress, count when finished.
+                ip->set_progress(1.0);
             }
 
             return last_img;
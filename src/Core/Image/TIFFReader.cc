@@ -0,0 +1,778 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "Core/Image/TIFFReader.h"
+#include "Core/Utils/DegateExceptions.h"
+#include "Core/Utils/FileSystem.h"
+
+#include <map>
+#include <limits>
+#include <cstring>
+#include <fstream>
+#include <boost/format.hpp>
+
+#include <QByteArray>
+
+using namespace degate;
+
+#define TIFF_TAG_NEW_SUBFILE_TYPE 254
+#define TIFF_TAG_IMAGE_WIDTH 256
+#define TIFF_TAG_IMAGE_LENGTH 257
+#define TIFF_TAG_BITS_PER_SAMPLE 258
+#define TIFF_TAG_COMPRESSION 259
+#define TIFF_TAG_PHOTOMETRIC 262
+#define TIFF_TAG_STRIP_OFFSETS 273
+#define TIFF_TAG_SAMPLES_PER_PIXEL 277
+#define TIFF_TAG_ROWS_PER_STRIP 278
+#define TIFF_TAG_STRIP_BYTE_COUNTS 279
+#define TIFF_TAG_PLANAR_CONFIG 284
+#define TIFF_TAG_PREDICTOR 317
+#define TIFF_TAG_TILE_WIDTH 322
+#define TIFF_TAG_TILE_LENGTH 323
+#define TIFF_TAG_TILE_OFFSETS 324
+#define TIFF_TAG_TILE_BYTE_COUNTS 325
+#define TIFF_TAG_EXTRA_SAMPLES 338
+#define TIFF_TAG_SAMPLE_FORMAT 339
+
+#define TIFF_COMPRESSION_NONE 1
+#define TIFF_COMPRESSION_LZW 5
+#define TIFF_COMPRESSION_DEFLATE 8
+#define TIFF_COMPRESSION_DEFLATE_OLD 32946
+#define TIFF_COMPRESSION_PACKBITS 32773
+
+#define TIFF_PHOTOMETRIC_WHITE_IS_ZERO 0
+#define TIFF_PHOTOMETRIC_BLACK_IS_ZERO 1
+#define TIFF_PHOTOMETRIC_RGB 2
+
+// Maximum number of images in a file, that are looked at.
+#define TIFF_MAX_PAGES 1024
+
+namespace
+{
+    typedef std::map<uint16_t, std::vector<uint64_t>> tiff_fields;
+
+    /**
+     * Helper to read numbers with the byte order of a TIFF file.
+     */
+    class tiff_stream
+    {
+    private:
+
+        std::ifstream file;
+        bool big_endian;
+
+    public:
+
+        tiff_stream(std::string const& filename) : file(filename.c_str(), std::ios::in | std::ios::binary), big_endian(false)
+        {
+        }
+
+        bool is_open() const { return file.is_open(); }
+
+        void set_big_endian(bool big_endian) { this->big_endian = big_endian; }
+
+        void seek(uint64_t offset)
+        {
+            file.clear();
+            file.seekg(static_cast<std::streamoff>(offset));
+            if (!file) throw DegateRuntimeException("Can't seek in TIFF file.");
+        }
+
+        void read(void* buf, std::size_t size)
+        {
+            file.read(static_cast<char*>(buf), static_cast<std::streamsize>(size));
+            if (static_cast<std::size_t>(file.gcount()) != size) throw DegateRuntimeException("Unexpected end of TIFF file.");
+        }
+
+        uint64_t decode(uint8_t const* data, unsigned int size) const
+        {
+            uint64_t v = 0;
+            for (unsigned int i = 0; i < size; i++)
+                v |= static_cast<uint64_t>(data[big_endian ? size - 1 - i : i]) << (8 * i);
+            return v;
+        }
+
+        uint64_t read_uint(unsigned int size)
+        {
+            uint8_t data[8];
+            read(data, size);
+            return decode(data, size);
+        }
+    };
+
+    /**
+     * Get the size of a field value type in bytes. Types, that are not needed, have size 0.
+     */
+    unsigned int get_type_size(uint16_t type)
+    {
+        switch (type)
+        {
+        case 1: // BYTE
+        case 7: // UNDEFINED
+            return 1;
+        case 3: // SHORT
+            return 2;
+        case 4: // LONG
+        case 13: // IFD
+            return 4;
+        case 16: // LONG8
+        case 18: // IFD8
+            return 8;
+        default:
+            return 0;
+        }
+    }
+
+    /**
+     * Read an image file directory.
+     * @return Returns the offset of the next directory.
+     */
+    uint64_t read_directory(tiff_stream& file, bool big_tiff, uint64_t offset, tiff_fields& fields)
+    {
+        const unsigned int offset_size = big_tiff ? 8 : 4;
+
+        file.seek(offset);
+        const uint64_t count = file.read_uint(big_tiff ? 8 : 2);
+        if (count > 4096) throw DegateRuntimeException("Invalid TIFF directory.");
+
+        std::vector<uint8_t> entries(static_cast<std::size_t>(count) * (4 + 2 * offset_size));
+        file.read(entries.data(), entries.size());
+        const uint64_t next = file.read_uint(offset_size);
+
+        for (uint64_t i = 0; i < count; i++)
+        {
+            uint8_t const* entry = entries.data() + i * (4 + 2 * offset_size);
+
+            const uint16_t tag = static_cast<uint16_t>(file.decode(entry, 2));
+            const uint16_t type = static_cast<uint16_t>(file.decode(entry + 2, 2));
+            const uint64_t value_count = file.decode(entry + 4, offset_size);
+            uint8_t const* value = entry + 4 + offset_size;
+
+            const unsigned int type_size = get_type_size(type);
+            if (type_size == 0 || value_count == 0) continue;
+            if (value_count > (1u << 28)) throw DegateRuntimeException("Invalid TIFF directory entry.");
+
+            std::vector<uint8_t> data(static_cast<std::size_t>(value_count) * type_size);
+
+            if (data.size() <= offset_size) std::memcpy(data.data(), value, data.size());
+            else
+            {
+                file.seek(file.decode(value, offset_size));
+                file.read(data.data(), data.size());
+            }
+
+            std::vector<uint64_t>& values = fields[tag];
+            values.resize(static_cast<std::size_t>(value_count));
+
+            for (std::size_t j = 0; j < values.size(); j++)
+                values[j] = file.decode(data.data() + j * type_size, type_size);
+        }
+
+        return next;
+    }
+
+    uint64_t get_field(tiff_fields const& fields, uint16_t tag, uint64_t default_value)
+    {
+        auto iter = fields.find(tag);
+        if (iter == fields.end() || iter->second.empty()) return default_value;
+        return iter->second[0];
+    }
+
+    std::vector<uint64_t> const& get_array(tiff_fields const& fields, uint16_t tag)
+    {
+        static const std::vector<uint64_t> empty;
+
+        auto iter = fields.find(tag);
+        return iter == fields.end() ? empty : iter->second;
+    }
+
+    /**
+     * Decode TIFF LZW data (codes with 9 to 12 bits, most significant bit first).
+     */
+    void decode_lzw(std::vector<uint8_t> const& in, std::vector<uint8_t>& out, std::size_t expected_size)
+    {
+        const unsigned int clear_code = 256, eoi_code = 257, first_code = 258, max_codes = 4096;
+
+        if (in.size() >= 2 && in[0] == 0 && (in[1] & 1))
+            throw DegateRuntimeException("Old-style TIFF LZW compression is not supported.");
+
+        std::vector<uint16_t> prefix(max_codes);
+        std::vector<uint16_t> length(max_codes);
+        std::vector<uint8_t> suffix(max_codes);
+        std::vector<uint8_t> first(max_codes);
+
+        for (unsigned int i = 0; i < 256; i++)
+        {
+            prefix[i] = 0;
+            length[i] = 1;
+            suffix[i] = static_cast<uint8_t>(i);
+            first[i] = static_cast<uint8_t>(i);
+        }
+
+        out.clear();
+        out.reserve(expected_size);
+
+        unsigned int next = first_code, width = 9;
+        int old = -1;
+
+        uint32_t bit_buffer = 0;
+        unsigned int bit_count = 0;
+        std::size_t pos = 0;
+
+        auto write_string = [&](unsigned int code)
+        {
+            const std::size_t start = out.size();
+            out.resize(start + length[code]);
+
+            for (std::size_t i = start + length[code]; i > start; i--)
+            {
+                out[i - 1] = suffix[code];
+                code = prefix[code];
+            }
+        };
+
+        while (out.size() < expected_size)
+        {
+            while (bit_count < width && pos < in.size())
+            {
+                bit_buffer = (bit_buffer << 8) | in[pos++];
+                bit_count += 8;
+            }
+            if (bit_count < width) break;
+
+            const unsigned int code = (bit_buffer >> (bit_count - width)) & ((1u << width) - 1);
+            bit_count -= width;
+
+            if (code == eoi_code) break;
+
+            if (code == clear_code)
+            {
+                next = first_code;
+                width = 9;
+                old = -1;
+                continue;
+            }
+
+            if (old == -1)
+            {
+                if (code >= 256) throw DegateRuntimeException("Invalid TIFF LZW data.");
+                write_string(code);
+                old = static_cast<int>(code);
+                continue;
+            }
+
+            if (code > next || (code == next && next >= max_codes))
+                throw DegateRuntimeException("Invalid TIFF LZW data.");
+
+            if (next < max_codes)
+            {
+                prefix[next] = static_cast<uint16_t>(old);
+                first[next] = first[old];
+                length[next] = static_cast<uint16_t>(length[old] + 1);
+                suffix[next] = code < next ? first[code] : first[old];
+            }
+
+            write_string(code);
+
+            if (next < max_codes) next++;
+            if (next >= (1u << width) - 1 && width < 12) width++;
+
+            old = static_cast<int>(code);
+        }
+    }
+
+    void decode_packbits(std::vector<uint8_t> const& in, std::vector<uint8_t>& out, std::size_t expected_size)
+    {
+        out.clear();
+        out.reserve(expected_size);
+
+        for (std::size_t pos = 0; pos < in.size() && out.size() < expected_size;)
+        {
+            const int n = static_cast<int8_t>(in[pos++]);
+
+            if (n >= 0)
+            {
+                const std::size_t count = std::min<std::size_t>(n + 1, in.size() - pos);
+                out.insert(out.end(), in.begin() + pos, in.begin() + pos + count);
+                pos += count;
+            }
+            else if (n != -128 && pos < in.size())
+            {
+                out.insert(out.end(), static_cast<std::size_t>(1 - n), in[pos++]);
+            }
+        }
+    }
+}
+
+
+TIFFReader::TIFFReader(std::string const& filename) :
+    filename(filename),
+    big_endian(false),
+    width(0),
+    height(0),
+    bits_per_sample(8),
+    samples_per_pixel(1),
+    compression(TIFF_COMPRESSION_NONE),
+    photometric(TIFF_PHOTOMETRIC_BLACK_IS_ZERO),
+    predictor(1),
+    has_alpha(false),
+    tiled(false)
+{
+    parse();
+}
+
+bool TIFFReader::is_tiff(std::string const& filename)
+{
+    std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!file.is_open()) return false;
+
+    unsigned char header[4];
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (file.gcount() != sizeof(header)) return false;
+
+    if (header[0] == 'I' && header[1] == 'I') return header[3] == 0 && (header[2] == 42 || header[2] == 43);
+    if (header[0] == 'M' && header[1] == 'M') return header[2] == 0 && (header[3] == 42 || header[3] == 43);
+
+    return false;
+}
+
+bool TIFFReader::is_supported(std::string const& filename)
+{
+    if (!is_tiff(filename)) return false;
+
+    try
+    {
+        TIFFReader reader(filename);
+        return true;
+    }
+    catch (DegateRuntimeException const& e)
+    {
+        debug(TM, "The TIFF file %s can't be read natively: %s", filename.c_str(), e.what());
+        return false;
+    }
+}
+
+void TIFFReader::parse()
+{
+    tiff_stream file(filename);
+    if (!file.is_open()) throw DegateRuntimeException("Can't open file " + filename);
+
+    uint8_t header[4];
+    file.read(header, sizeof(header));
+
+    if (header[0] == 'M' && header[1] == 'M') big_endian = true;
+    else if (header[0] != 'I' || header[1] != 'I') throw DegateRuntimeException(filename + " is not a TIFF file.");
+
+    file.set_big_endian(big_endian);
+
+    const uint64_t version = file.decode(header + 2, 2);
+    if (version != 42 && version != 43) throw DegateRuntimeException(filename + " is not a TIFF file.");
+
+    const bool big_tiff = version == 43;
+    if (big_tiff)
+    {
+        // Offset size (8) and a reserved word.
+        if (file.read_uint(2) != 8 || file.read_uint(2) != 0) throw DegateRuntimeException("Invalid BigTIFF header.");
+    }
+
+    // Look at all images and keep the largest one.
+    tiff_fields fields;
+    uint64_t best_size = 0;
+
+    uint64_t offset = file.read_uint(big_tiff ? 8 : 4);
+    for (unsigned int page = 0; offset != 0 && page < TIFF_MAX_PAGES; page++)
+    {
+        tiff_fields page_fields;
+        offset = read_directory(file, big_tiff, offset, page_fields);
+
+        const uint64_t size = get_field(page_fields, TIFF_TAG_IMAGE_WIDTH, 0) * get_field(page_fields, TIFF_TAG_IMAGE_LENGTH, 0);
+        if (size > best_size)
+        {
+            best_size = size;
+            fields.swap(page_fields);
+        }
+    }
+
+    if (best_size == 0) throw DegateRuntimeException("The TIFF file has no image.");
+
+    const uint64_t w = get_field(fields, TIFF_TAG_IMAGE_WIDTH, 0);
+    const uint64_t h = get_field(fields, TIFF_TAG_IMAGE_LENGTH, 0);
+    if (w > std::numeric_limits<int>::max() || h > std::numeric_limits<int>::max())
+        throw DegateRuntimeException("The TIFF image is too large.");
+
+    width = static_cast<unsigned int>(w);
+    height = static_cast<unsigned int>(h);
+
+    samples_per_pixel = static_cast<unsigned int>(get_field(fields, TIFF_TAG_SAMPLES_PER_PIXEL, 1));
+    compression = static_cast<unsigned int>(get_field(fields, TIFF_TAG_COMPRESSION, TIFF_COMPRESSION_NONE));
+    photometric = static_cast<unsigned int>(get_field(fields, TIFF_TAG_PHOTOMETRIC, TIFF_PHOTOMETRIC_BLACK_IS_ZERO));
+    predictor = static_cast<unsigned int>(get_field(fields, TIFF_TAG_PREDICTOR, 1));
+
+    std::vector<uint64_t> const& bits = get_array(fields, TIFF_TAG_BITS_PER_SAMPLE);
+    bits_per_sample = bits.empty() ? 1 : static_cast<unsigned int>(bits[0]);
+    for (uint64_t b : bits)
+        if (b != bits_per_sample) throw DegateRuntimeException("TIFF images with different sample sizes are not supported.");
+
+    if (bits_per_sample != 8 && bits_per_sample != 16)
+        throw DegateRuntimeException(boost::str(boost::format("TIFF images with %1% bit samples are not supported.") % bits_per_sample));
+
+    if (get_field(fields, TIFF_TAG_SAMPLE_FORMAT, 1) != 1)
+        throw DegateRuntimeException("Only TIFF images with unsigned integer samples are supported.");
+
+    if (compression != TIFF_COMPRESSION_NONE && compression != TIFF_COMPRESSION_LZW &&
+        compression != TIFF_COMPRESSION_DEFLATE && compression != TIFF_COMPRESSION_DEFLATE_OLD &&
+        compression != TIFF_COMPRESSION_PACKBITS)
+        throw DegateRuntimeException(boost::str(boost::format("TIFF compression %1% is not supported.") % compression));
+
+    if (predictor != 1 && predictor != 2)
+        throw DegateRuntimeException("Only the horizontal TIFF predictor is supported.");
+
+    const unsigned int color_samples = photometric == TIFF_PHOTOMETRIC_RGB ? 3 : 1;
+
+    if (photometric != TIFF_PHOTOMETRIC_WHITE_IS_ZERO && photometric != TIFF_PHOTOMETRIC_BLACK_IS_ZERO &&
+        photometric != TIFF_PHOTOMETRIC_RGB)
+        throw DegateRuntimeException("Only greyscale and RGB TIFF images are supported.");
+
+    if (samples_per_pixel < color_samples || samples_per_pixel > color_samples + 1)
+        throw DegateRuntimeException("Unsupported number of samples per pixel in TIFF image.");
+
+    if (samples_per_pixel > 1 && get_field(fields, TIFF_TAG_PLANAR_CONFIG, 1) != 1)
+        throw DegateRuntimeException("TIFF images with separate planes are not supported.");
+
+    // An extra sample is only used, if it is marked as (associated or unassociated) alpha.
+    const uint64_t extra_sample = get_field(fields, TIFF_TAG_EXTRA_SAMPLES, 0);
+    has_alpha = samples_per_pixel > color_samples && (extra_sample == 1 || extra_sample == 2);
+
+    const uint64_t pixel_bytes = samples_per_pixel * bits_per_sample / 8;
+
+    tiled = fields.count(TIFF_TAG_TILE_WIDTH) > 0;
+
+    if (tiled)
+    {
+        const unsigned int tile_width = static_cast<unsigned int>(get_field(fields, TIFF_TAG_TILE_WIDTH, 0));
+        const unsigned int tile_height = static_cast<unsigned int>(get_field(fields, TIFF_TAG_TILE_LENGTH, 0));
+        if (tile_width == 0 || tile_height == 0) throw DegateRuntimeException("Invalid TIFF tile size.");
+
+        if (compression != TIFF_COMPRESSION_NONE &&
+            static_cast<uint64_t>(tile_width) * tile_height > TIFF_MAX_COMPRESSED_CHUNK_PIXELS)
+            throw DegateRuntimeException(boost::str(boost::format("The compressed TIFF tiles of %1% x %2% pixels are too large.")
+                                                    % tile_width % tile_height));
+
+        const unsigned int tiles_x = (width + tile_width - 1) / tile_width;
+        const unsigned int tiles_y = (height + tile_height - 1) / tile_height;
+
+        std::vector<uint64_t> const& offsets = get_array(fields, TIFF_TAG_TILE_OFFSETS);
+        std::vector<uint64_t> const& byte_counts = get_array(fields, TIFF_TAG_TILE_BYTE_COUNTS);
+
+        if (offsets.size() < static_cast<std::size_t>(tiles_x) * tiles_y || byte_counts.size() < offsets.size())
+            throw DegateRuntimeException("Invalid TIFF tile table.");
+
+        for (unsigned int i = 0; i < tiles_x * tiles_y; i++)
+        {
+            chunk c;
+            c.min_x = (i % tiles_x) * tile_width;
+            c.min_y = (i / tiles_x) * tile_height;
+            c.width = std::min(tile_width, width - c.min_x);
+            c.height = std::min(tile_height, height - c.min_y);
+            c.encoded_width = tile_width;
+            c.encoded_height = tile_height;
+            c.offset = offsets[i];
+            c.byte_count = byte_counts[i];
+
+            chunks.push_back(c);
+        }
+    }
+    else
+    {
+        uint64_t rows_per_strip = get_field(fields, TIFF_TAG_ROWS_PER_STRIP, height);
+        if (rows_per_strip == 0 || rows_per_strip > height) rows_per_strip = height;
+
+        const unsigned int strips = static_cast<unsigned int>((height + rows_per_strip - 1) / rows_per_strip);
+
+        std::vector<uint64_t> const& offsets = get_array(fields, TIFF_TAG_STRIP_OFFSETS);
+        std::vector<uint64_t> const& byte_counts = get_array(fields, TIFF_TAG_STRIP_BYTE_COUNTS);
+
+        if (offsets.size() < strips || byte_counts.size() < offsets.size())
+            throw DegateRuntimeException("Invalid TIFF strip table.");
+
+        // Uncompressed strips can be split at any row (the predictor works row by row). Large
+        // strips are split, so that the memory usage stays low even for images stored in a
+        // single strip. Compressed strips are decoded as a whole.
+        const unsigned int split_rows = compression == TIFF_COMPRESSION_NONE ?
+                                        std::max(1u, TIFF_MAX_CHUNK_PIXELS / width) :
+                                        static_cast<unsigned int>(rows_per_strip);
+
+        if (compression != TIFF_COMPRESSION_NONE &&
+            static_cast<uint64_t>(width) * rows_per_strip > TIFF_MAX_COMPRESSED_CHUNK_PIXELS)
+            throw DegateRuntimeException(boost::str(boost::format("The compressed TIFF strips of %1% x %2% pixels are too large. "
+                                                                  "Save the image with smaller strips or with tiles.")
+                                                    % width % rows_per_strip));
+
+        for (unsigned int i = 0; i < strips; i++)
+        {
+            const unsigned int strip_y = static_cast<unsigned int>(i * rows_per_strip);
+            const unsigned int strip_rows = static_cast<unsigned int>(std::min<uint64_t>(rows_per_strip, height - strip_y));
+
+            for (unsigned int row = 0; row < strip_rows; row += split_rows)
+            {
+                chunk c;
+                c.min_x = 0;
+                c.min_y = strip_y + row;
+                c.width = width;
+                c.height = std::min(split_rows, strip_rows - row);
+                c.encoded_width = width;
+                c.encoded_height = c.height;
+
+                if (c.height == strip_rows)
+                {
+                    c.offset = offsets[i];
+                    c.byte_count = byte_counts[i];
+                }
+                else
+                {
+                    const uint64_t skip = static_cast<uint64_t>(row) * width * pixel_bytes;
+                    c.offset = offsets[i] + skip;
+                    c.byte_count = byte_counts[i] > skip ?
+                                   std::min<uint64_t>(byte_counts[i] - skip, static_cast<uint64_t>(c.height) * width * pixel_bytes) : 0;
+                }
+
+                chunks.push_back(c);
+            }
+        }
+    }
+
+    debug(TM, "TIFF image %s: %d x %d, %d x %d bit, compression %d, %d %s",
+          filename.c_str(), width, height, samples_per_pixel, bits_per_sample, compression,
+          chunks.size(), tiled ? "tiles" : "strips");
+}
+
+std::size_t TIFFReader::get_chunk_memory(unsigned int index) const
+{
+    chunk const& c = chunks.at(index);
+
+    const std::size_t decoded = static_cast<std::size_t>(c.encoded_width) * c.encoded_height *
+                                samples_per_pixel * bits_per_sample / 8;
+    const std::size_t pixels = static_cast<std::size_t>(c.width) * c.height * sizeof(rgba_pixel_t);
+
+    // Encoded data, decoded samples, RGBA pixels and converted pixels.
+    return static_cast<std::size_t>(c.byte_count) + decoded + 2 * pixels;
+}
+
+void TIFFReader::decompress(std::vector<uint8_t> const& in, std::vector<uint8_t>& out) const
+{
+    const std::size_t expected_size = out.size();
+
+    switch (compression)
+    {
+    case TIFF_COMPRESSION_NONE:
+        out = in;
+        break;
+
+    case TIFF_COMPRESSION_LZW:
+        decode_lzw(in, out, expected_size);
+        break;
+
+    case TIFF_COMPRESSION_PACKBITS:
+        decode_packbits(in, out, expected_size);
+        break;
+
+    case TIFF_COMPRESSION_DEFLATE:
+    case TIFF_COMPRESSION_DEFLATE_OLD:
+        {
+            if (expected_size > static_cast<std::size_t>(std::numeric_limits<int>::max()) ||
+                in.size() + 4 > static_cast<std::size_t>(std::numeric_limits<int>::max()))
+                throw DegateRuntimeException("TIFF chunk is too large.");
+
+            // qUncompress() expects the uncompressed size in front of the zlib stream.
+            std::vector<uint8_t> data(in.size() + 4);
+            data[0] = static_cast<uint8_t>(expected_size >> 24);
+            data[1] = static_cast<uint8_t>(expected_size >> 16);
+            data[2] = static_cast<uint8_t>(expected_size >> 8);
+            data[3] = static_cast<uint8_t>(expected_size);
+            if (!in.empty()) std::memcpy(data.data() + 4, in.data(), in.size());
+
+            QByteArray result = qUncompress(data.data(), static_cast<int>(data.size()));
+            if (result.isEmpty()) throw DegateRuntimeException("Invalid TIFF Deflate data.");
+
+            out.assign(result.constData(), result.constData() + result.size());
+        }
+        break;
+
+    default:
+        throw DegateRuntimeException("Unsupported TIFF compression.");
+    }
+
+    if (out.size() != expected_size)
+    {
+        if (out.size() < expected_size)
+            debug(TM, "TIFF chunk is %d bytes too short.", expected_size - out.size());
+
+        out.resize(expected_size, 0);
+    }
+}
+
+void TIFFReader::undo_predictor(std::vector<uint8_t>& data, chunk const& c) const
+{
+    const std::size_t row_samples = static_cast<std::size_t>(c.encoded_width) * samples_per_pixel;
+
+    for (unsigned int y = 0; y < c.encoded_height; y++)
+    {
+        if (bits_per_sample == 8)
+        {
+            uint8_t* row = data.data() + y * row_samples;
+            for (std::size_t i = samples_per_pixel; i < row_samples; i++)
+                row[i] = static_cast<uint8_t>(row[i] + row[i - samples_per_pixel]);
+        }
+        else
+        {
+            // The samples are already in host byte order.
+            uint16_t* row = reinterpret_cast<uint16_t*>(data.data()) + y * row_samples;
+            for (std::size_t i = samples_per_pixel; i < row_samples; i++)
+                row[i] = static_cast<uint16_t>(row[i] + row[i - samples_per_pixel]);
+        }
+    }
+}
+
+void TIFFReader::decode_chunk(chunk const& c, std::vector<uint8_t>& data) const
+{
+    std::vector<uint8_t> encoded(static_cast<std::size_t>(c.byte_count));
+    if (!encoded.empty())
+    {
+        tiff_stream file(filename);
+        if (!file.is_open()) throw DegateRuntimeException("Can't open file " + filename);
+
+        file.seek(c.offset);
+        file.read(encoded.data(), encoded.size());
+    }
+
+    data.resize(static_cast<std::size_t>(c.encoded_width) * c.encoded_height *
+                samples_per_pixel * bits_per_sample / 8);
+    decompress(encoded, data);
+
+    if (bits_per_sample == 16)
+    {
+        const uint16_t probe = 1;
+        const bool host_big_endian = *reinterpret_cast<const uint8_t*>(&probe) == 0;
+
+        if (host_big_endian != big_endian)
+            for (std::size_t i = 0; i + 1 < data.size(); i += 2) std::swap(data[i], data[i + 1]);
+    }
+
+    if (predictor == 2) undo_predictor(data, c);
+}
+
+void TIFFReader::read_chunk(unsigned int index, std::vector<rgba_pixel_t>& pixels) const
+{
+    chunk const& c = chunks.at(index);
+
+    std::vector<uint8_t> data;
+    decode_chunk(c, data);
+
+    pixels.resize(static_cast<std::size_t>(c.width) * c.height);
+
+    const unsigned int spp = samples_per_pixel;
+    const bool rgb = photometric == TIFF_PHOTOMETRIC_RGB;
+    const bool invert = photometric == TIFF_PHOTOMETRIC_WHITE_IS_ZERO;
+    const unsigned int alpha_sample = rgb ? 3 : 1;
+
+    uint16_t const* samples16 = reinterpret_cast<uint16_t const*>(data.data());
+    uint8_t const* samples8 = data.data();
+
+    for (unsigned int y = 0; y < c.height; y++)
+    {
+        rgba_pixel_t* out = pixels.data() + static_cast<std::size_t>(y) * c.width;
+        const std::size_t row_start = static_cast<std::size_t>(y) * c.encoded_width * spp;
+
+        if (bits_per_sample == 8)
+        {
+            uint8_t const* s = samples8 + row_start;
+
+            for (unsigned int x = 0; x < c.width; x++, s += spp)
+            {
+                const unsigned int a = has_alpha ? s[alpha_sample] : 255;
+
+                if (rgb) out[x] = MERGE_CHANNELS(s[0], s[1], s[2], a);
+                else
+                {
+                    const unsigned int v = invert ? 255 - s[0] : s[0];
+                    out[x] = MERGE_CHANNELS(v, v, v, a);
+                }
+            }
+        }
+        else
+        {
+            uint16_t const* s = samples16 + row_start;
+
+            for (unsigned int x = 0; x < c.width; x++, s += spp)
+            {
+                const unsigned int a = has_alpha ? s[alpha_sample] >> 8 : 255;
+
+                if (rgb) out[x] = MERGE_CHANNELS(s[0] >> 8u, s[1] >> 8u, s[2] >> 8u, a);
+                else
+                {
+                    const unsigned int v = (invert ? 0xffff - s[0] : s[0]) >> 8;
+                    out[x] = MERGE_CHANNELS(v, v, v, a);
+                }
+            }
+        }
+    }
+}
+
+void TIFFReader::read_chunk(unsigned int index, std::vector<gs_byte_pixel_t>& pixels) const
+{
+    if (!is_greyscale()) throw DegateLogicException("The TIFF image is not a greyscale image.");
+
+    chunk const& c = chunks.at(index);
+
+    std::vector<uint8_t> data;
+    decode_chunk(c, data);
+
+    pixels.resize(static_cast<std::size_t>(c.width) * c.height);
+
+    const bool invert = photometric == TIFF_PHOTOMETRIC_WHITE_IS_ZERO;
+
+    uint16_t const* samples16 = reinterpret_cast<uint16_t const*>(data.data());
+    uint8_t const* samples8 = data.data();
+
+    for (unsigned int y = 0; y < c.height; y++)
+    {
+        gs_byte_pixel_t* out = pixels.data() + static_cast<std::size_t>(y) * c.width;
+        const std::size_t row_start = static_cast<std::size_t>(y) * c.encoded_width;
+
+        if (bits_per_sample == 8)
+        {
+            uint8_t const* s = samples8 + row_start;
+
+            if (invert)
+                for (unsigned int x = 0; x < c.width; x++) out[x] = static_cast<gs_byte_pixel_t>(255 - s[x]);
+            else
+                std::memcpy(out, s, c.width);
+        }
+        else
+        {
+            uint16_t const* s = samples16 + row_start;
+
+            for (unsigned int x = 0; x < c.width; x++)
+                out[x] = static_cast<gs_byte_pixel_t>((invert ? 0xffff - s[x] : s[x]) >> 8);
+        }
+    }
+}
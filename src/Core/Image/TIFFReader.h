@@ -0,0 +1,327 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef __TIFFREADER_H__
+#define __TIFFREADER_H__
+
+#include "Globals.h"
+#include "Core/Image/Image.h"
+#include "Core/Image/BlockAccessPolicy.h"
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <functional>
+#include <boost/utility.hpp>
+#include <boost/range/counting_range.hpp>
+#include <QThread>
+#include <QtConcurrent/QtConcurrent>
+
+/**
+ * Maximum number of pixels of a chunk, that uncompressed strips are split into.
+ */
+#define TIFF_MAX_CHUNK_PIXELS (4 * 1024 * 1024)
+
+/**
+ * Maximum number of pixels of a compressed strip or tile. Compressed chunks can't be
+ * split and are decoded as a whole, larger ones are rejected.
+ */
+#define TIFF_MAX_COMPRESSED_CHUNK_PIXELS (64 * 1024 * 1024)
+
+namespace degate
+{
+    /**
+     * Native reader for TIFF and BigTIFF images.
+     *
+     * The image data is read strip by strip or tile by tile (chunks) and each chunk
+     * is converted to RGBA pixels directly from its samples. Greyscale images can be
+     * read into greyscale pixels instead. Chunks can be read from
+     * several threads at once, so an image never has to be decoded as a whole.
+     *
+     * Supported are images with 8 or 16 bit unsigned samples: greyscale (with or
+     * without alpha) and RGB (with or without alpha), stored contiguously in strips
+     * or tiles. Supported compressions are none, LZW, Deflate and PackBits, with or
+     * without horizontal predictor. Other images are rejected and can be read with
+     * QImageReader instead. So are images with compressed strips or tiles of more than
+     * TIFF_MAX_COMPRESSED_CHUNK_PIXELS pixels.
+     *
+     * If the file holds several images (pages), the largest one is read.
+     *
+     * @see read_tiff()
+     */
+    class TIFFReader : boost::noncopyable
+    {
+    public:
+
+        /**
+         * A strip or a tile of the image.
+         */
+        struct chunk
+        {
+            // The region of the image, that is covered by the chunk (clipped to the image).
+            unsigned int min_x, min_y, width, height;
+
+            // The size of the encoded data. Tiles are always stored with the full tile size.
+            unsigned int encoded_width, encoded_height;
+
+            uint64_t offset;
+            uint64_t byte_count;
+        };
+
+    private:
+
+        std::string filename;
+        bool big_endian;
+
+        unsigned int width;
+        unsigned int height;
+        unsigned int bits_per_sample;
+        unsigned int samples_per_pixel;
+        unsigned int compression;
+        unsigned int photometric;
+        unsigned int predictor;
+        bool has_alpha;
+        bool tiled;
+
+        std::vector<chunk> chunks;
+
+    private:
+
+        void parse();
+
+        void decompress(std::vector<uint8_t> const& in, std::vector<uint8_t>& out) const;
+        void undo_predictor(std::vector<uint8_t>& data, chunk const& c) const;
+
+        /**
+         * Read, decompress and unpredict the samples of a chunk. 16 bit samples are
+         * in host byte order afterwards.
+         */
+        void decode_chunk(chunk const& c, std::vector<uint8_t>& data) const;
+
+    public:
+
+        /**
+         * Open a TIFF file and read its directory.
+         * @exception DegateRuntimeException This exception is thrown, if the file cannot be
+         *   read, is not a TIFF file or uses a feature, that is not supported.
+         */
+        explicit TIFFReader(std::string const& filename);
+
+        /**
+         * Check if a file starts with a TIFF or BigTIFF signature.
+         */
+        static bool is_tiff(std::string const& filename);
+
+        /**
+         * Check if a file can be read by this reader.
+         */
+        static bool is_supported(std::string const& filename);
+
+        std::string const& get_filename() const { return filename; }
+
+        unsigned int get_width() const { return width; }
+        unsigned int get_height() const { return height; }
+
+        unsigned int get_bits_per_sample() const { return bits_per_sample; }
+        unsigned int get_samples_per_pixel() const { return samples_per_pixel; }
+
+        /**
+         * Check if the image is stored in tiles. Otherwise it is stored in strips.
+         */
+        bool is_tiled() const { return tiled; }
+
+        /**
+         * Check if the image has a single grey channel without alpha.
+         */
+        bool is_greyscale() const { return samples_per_pixel == 1; }
+
+        std::vector<chunk> const& get_chunks() const { return chunks; }
+
+        /**
+         * Get the memory, that is needed to read a chunk.
+         */
+        std::size_t get_chunk_memory(unsigned int index) const;
+
+        /**
+         * Read a chunk and convert it into RGBA pixels. This method can be called
+         * from several threads at once.
+         * @param index The chunk number.
+         * @param pixels The pixels of the chunk region row by row.
+         * @exception DegateRuntimeException This exception is thrown, if the data
+         *   cannot be read or decoded.
+         */
+        void read_chunk(unsigned int index, std::vector<rgba_pixel_t>& pixels) const;
+
+        /**
+         * Read a chunk of a greyscale image into greyscale pixels, without an RGBA conversion.
+         * This method can be called from several threads at once.
+         * @exception DegateLogicException This exception is thrown, if the image is not
+         *   a greyscale image (@see is_greyscale()).
+         * @exception DegateRuntimeException This exception is thrown, if the data
+         *   cannot be read or decoded.
+         */
+        void read_chunk(unsigned int index, std::vector<gs_byte_pixel_t>& pixels) const;
+    };
+
+    typedef std::shared_ptr<TIFFReader> TIFFReader_shptr;
+
+
+    /**
+     * Write the pixels of a chunk into an image.
+     */
+    template <typename ImageType, typename PixelType>
+    void write_tiff_chunk(std::shared_ptr<ImageType> img,
+                          TIFFReader::chunk const& c,
+                          std::vector<PixelType> const& pixels)
+    {
+        typedef typename ImageType::pixel_type pixel_type;
+
+        if (c.min_x >= img->get_width() || c.min_y >= img->get_height()) return;
+
+        const unsigned int max_x = std::min(c.min_x + c.width, img->get_width());
+        const unsigned int max_y = std::min(c.min_y + c.height, img->get_height());
+        const unsigned int w = max_x - c.min_x;
+
+        std::vector<pixel_type> converted(static_cast<std::size_t>(w) * (max_y - c.min_y));
+
+        for (unsigned int y = 0; y < max_y - c.min_y; y++)
+            for (unsigned int x = 0; x < w; x++)
+                converted[static_cast<std::size_t>(y) * w + x] =
+                    convert_pixel<pixel_type, PixelType>(pixels[static_cast<std::size_t>(y) * c.width + x]);
+
+        BlockAccessPolicy<ImageType>::write(img, c.min_x, max_x, c.min_y, max_y, converted.data());
+    }
+
+    /**
+     * Specialisation for images with the pixel type of the chunk, where pixels can be
+     * written without conversion.
+     */
+    template <class PixelPolicy, template <class _PixelPolicy> class StoragePolicy, typename PixelType>
+    void write_tiff_chunk(std::shared_ptr<Image<PixelPolicy, StoragePolicy>> img,
+                          TIFFReader::chunk const& c,
+                          std::vector<PixelType> const& pixels,
+                          typename std::enable_if<std::is_same<typename PixelPolicy::pixel_type, PixelType>::value>::type* = nullptr)
+    {
+        typedef Image<PixelPolicy, StoragePolicy> ImageType;
+
+        if (c.min_x >= img->get_width() || c.min_y >= img->get_height()) return;
+
+        const unsigned int max_x = std::min(c.min_x + c.width, img->get_width());
+        const unsigned int max_y = std::min(c.min_y + c.height, img->get_height());
+
+        if (max_x - c.min_x == c.width)
+        {
+            BlockAccessPolicy<ImageType>::write(img, c.min_x, max_x, c.min_y, max_y, pixels.data());
+            return;
+        }
+
+        // The chunk is clipped by the image.
+        for (unsigned int y = c.min_y; y < max_y; y++)
+            BlockAccessPolicy<ImageType>::write(img, c.min_x, max_x, y, y + 1,
+                                                pixels.data() + static_cast<std::size_t>(y - c.min_y) * c.width);
+    }
+
+    /**
+     * Read a TIFF image into a degate image. The chunks are read in parallel.
+     * Only as many chunks are read at once, as fit into \p memory_limit, so the
+     * memory usage does not depend on the image size.
+     * @param reader The opened TIFF file.
+     * @param img The image. Chunks outside of the image are clipped.
+     * @param memory_limit The memory in bytes, that may be used for reading.
+     * @param progress If not nullptr, it is called with the progress (from 0 to 1)
+     *   after each chunk.
+     * @exception DegateRuntimeException This exception is thrown, if a chunk cannot be read.
+     */
+    template <typename ImageType>
+    void read_tiff(TIFFReader const& reader,
+                   std::shared_ptr<ImageType> img,
+                   std::size_t memory_limit = 256 * 1024 * 1024,
+                   std::function<void(double)> const& progress = nullptr)
+    {
+        std::vector<TIFFReader::chunk> const& chunks = reader.get_chunks();
+        if (chunks.empty()) return;
+
+        std::size_t chunk_memory = 1;
+        for (unsigned int i = 0; i < chunks.size(); i++)
+            chunk_memory = std::max(chunk_memory, reader.get_chunk_memory(i));
+
+        // Each worker reads one chunk at a time. Workers take the chunks in file order.
+        const unsigned int workers = static_cast<unsigned int>(
+            std::max<std::size_t>(1, std::min<std::size_t>({static_cast<std::size_t>(std::max(1, QThread::idealThreadCount())),
+                                                             memory_limit / chunk_memory,
+                                                             chunks.size()})));
+
+        std::atomic<unsigned int> next_chunk(0);
+        std::atomic<unsigned int> done(0);
+        std::atomic<bool> failed(false);
+        std::string error;
+        std::mutex error_mutex;
+
+        // Greyscale files are read into greyscale images without an RGBA conversion.
+        const bool read_greyscale = std::is_same<typename ImageType::pixel_type, gs_byte_pixel_t>::value &&
+                                    reader.is_greyscale();
+
+        std::function<void(const unsigned int& i)> function = [&](const unsigned int&)
+        {
+            std::vector<rgba_pixel_t> pixels;
+            std::vector<gs_byte_pixel_t> grey_pixels;
+
+            for (unsigned int i = next_chunk++; i < chunks.size() && !failed; i = next_chunk++)
+            {
+                try
+                {
+                    if (read_greyscale)
+                    {
+                        reader.read_chunk(i, grey_pixels);
+                        write_tiff_chunk(img, chunks[i], grey_pixels);
+                    }
+                    else
+                    {
+                        reader.read_chunk(i, pixels);
+                        write_tiff_chunk(img, chunks[i], pixels);
+                    }
+                }
+                catch (std::exception const& e)
+                {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if (!failed) error = e.what();
+                    failed = true;
+                }
+
+                const unsigned int n = ++done;
+                if (progress) progress(static_cast<double>(n) / chunks.size());
+            }
+        };
+
+        debug(TM, "Read %d chunks of %s with %d workers.", chunks.size(), reader.get_filename().c_str(), workers);
+
+        const auto& it = boost::counting_range<unsigned int>(0, workers);
+        QtConcurrent::blockingMap(it, function);
+
+        if (failed) throw DegateRuntimeException(error);
+    }
+}
+
+#endif
@@ -23,8 +23,10 @@
 #define __TILECACHE_H__
 
 #include "Core/Utils/MemoryMap.h"
+#include "Core/Image/TileContainer.h"
 #include "Core/Utils/FileSystem.h"
 #include "Core/Configuration.h"
+#include "Core/Utils/Trace.h"
 
 #include <string>
 #include <map>
@@ -37,6 +39,8 @@
 #include <chrono>
 
 #include <mutex>
+#include <vector>
+#include <algorithm>
 
 /**
  * Minimum size (in Mb) of the cache.
@@ -80,10 +84,26 @@ namespace degate
     class TileCacheBase
     {
     public:
-        virtual void cleanup_cache() = 0;
+
+        /**
+         * Remove the oldest entry from the cache, if the cache is not used by another thread.
+         * This is called by the GlobalTileCache with its lock held, so it must not call back
+         * into the GlobalTileCache.
+         * @return Returns the amount of released memory (in bytes). Zero, if the cache is busy or empty.
+         */
+        virtual uint_fast64_t try_cleanup_cache() = 0;
+
         virtual void print() const = 0;
     };
 
+    /**
+     * The memory budget shared by all tile caches.
+     *
+     * Tile caches can be used from several threads, so the budget is protected by its own lock.
+     * If the budget is exhausted, the oldest tile of the least recently used cache is evicted.
+     * The victim cache is only try-locked while the global lock is held, so a thread holding a
+     * cache lock and waiting for the global lock can never deadlock with an eviction.
+     */
     class GlobalTileCache : public SingletonBase<GlobalTileCache>
     {
         friend class SingletonBase<GlobalTileCache>;
@@ -98,6 +118,8 @@ namespace degate
 
         cache_t cache;
 
+        mutable std::mutex mutex;
+
     private:
 
         GlobalTileCache() : allocated_memory(0)
@@ -108,37 +130,88 @@ namespace degate
                 max_cache_memory = Configuration::get_max_tile_cache_size() * uint_fast64_t(1024) * uint_fast64_t(1024);
         }
 
-        void remove_oldest()
+        /**
+         * Evict a tile from the least recently used cache, that is not busy.
+         * The global lock must be held.
+         * @return Returns true, if memory was released.
+         */
+        bool remove_oldest()
         {
-            struct timespec now;
-            GET_CLOCK(now);
-
-            TileCacheBase* oldest = nullptr;
+            std::vector<std::pair<struct timespec, TileCacheBase*>> victims;
+            victims.reserve(cache.size());
 
             for (cache_t::iterator iter = cache.begin(); iter != cache.end(); ++iter)
+                victims.push_back(std::make_pair(iter->second.first, iter->first));
+
+            std::sort(victims.begin(), victims.end(), [](std::pair<struct timespec, TileCacheBase*> const& a,
+                                                         std::pair<struct timespec, TileCacheBase*> const& b)
+            {
+                return a.first < b.first;
+            });
+
+            for (auto const& victim : victims)
             {
-                cache_entry_t& entry = iter->second;
-                if (entry.first < now)
+#ifdef TILECACHE_DEBUG
+    debug(TM, "Will call cleanup on %p", victim.second);
+#endif
+                uint_fast64_t released = victim.second->try_cleanup_cache();
+
+                if (released > 0)
                 {
-                    now.tv_sec = entry.first.tv_sec;
-                    now.tv_nsec = entry.first.tv_nsec;
-                    oldest = iter->first;
+                    release(victim.second, released);
+                    return true;
                 }
             }
 
-            if (oldest)
-            {
 #ifdef TILECACHE_DEBUG
-    debug(TM, "Will call cleanup on %p", oldest);
+    debug(TM, "there is nothing to free.");
+    print_table();
 #endif
-                oldest->cleanup_cache();
+            return false;
+        }
+
+        /**
+         * Update the accounting of released memory. The global lock must be held.
+         */
+        void release(TileCacheBase* requestor, uint_fast64_t amount)
+        {
+            cache_t::iterator found = cache.find(requestor);
+
+            if (found == cache.end())
+            {
+                debug(TM, "Unknown memory should be released.");
+                print_table();
+                assert(1==0);
             }
             else
             {
+                cache_entry_t& entry = found->second;
+
+                if (entry.second >= amount)
+                {
+                    entry.second -= amount;
+                    assert(allocated_memory >= amount);
+                    if (allocated_memory >= amount) allocated_memory -= amount;
+                    else
+                    {
+                        debug(TM, "More mem to release than available.");
+                        print_table();
+                        assert(1==0);
+                    }
+                }
+                else
+                {
+                    print_table();
+                    assert(entry.second >= amount); // will break
+                }
+
+                if (entry.second == 0)
+                {
 #ifdef TILECACHE_DEBUG
-    debug(TM, "there is nothing to free.");
-    print_table();
+      debug(TM, "Memory completely released. Remove entry from global cache.");
 #endif
+                    cache.erase(found);
+                }
             }
         }
 
@@ -167,94 +240,68 @@ namespace degate
             std::cout << "\n";
         }
 
+        /**
+         * Reserve memory for a tile of \p requestor. Old tiles are evicted until the
+         * amount fits into the budget. If all other caches are busy, the budget is
+         * exceeded temporarily, the next requests will evict again.
+         * @return Returns true, if the memory fits into the budget.
+         */
         bool request_cache_memory(TileCacheBase* requestor, uint_fast64_t amount)
         {
+            std::lock_guard<std::mutex> lock(mutex);
+
 #ifdef TILECACHE_DEBUG
       debug(TM, "Local cache %p requests %d bytes.", requestor, amount);
 #endif
+            bool fits = true;
+
             while (allocated_memory + amount > max_cache_memory)
             {
 #ifdef TILECACHE_DEBUG
     debug(TM, "Try to free memory");
 #endif
-                remove_oldest();
-            }
-
-            if (allocated_memory + amount <= max_cache_memory)
-            {
-                struct timespec now;
-                GET_CLOCK(now);
-
-                cache_t::iterator found = cache.find(requestor);
-                if (found == cache.end())
-                {
-                    cache[requestor] = std::make_pair(now, amount);
-                }
-                else
+                if (!remove_oldest())
                 {
-                    cache_entry_t& entry = found->second;
-                    entry.first.tv_sec = now.tv_sec;
-                    entry.first.tv_nsec = now.tv_nsec;
-                    entry.second += amount;
+                    debug(TM, "Can't free memory, the tile cache exceeds its budget.");
+                    fits = false;
+                    break;
                 }
-
-                allocated_memory += amount;
-#ifdef TILECACHE_DEBUG
-    print_table();
-#endif
-                return true;
             }
 
-            debug(TM, "Can't free memory.");
-
-            print_table();
-            return false;
-        }
-
-        void release_cache_memory(TileCacheBase* requestor, uint_fast64_t amount)
-        {
-#ifdef TILECACHE_DEBUG
-      debug(TM, "Local cache %p releases %d bytes.", requestor, amount);
-#endif
+            struct timespec now;
+            GET_CLOCK(now);
 
             cache_t::iterator found = cache.find(requestor);
-
             if (found == cache.end())
             {
-                debug(TM, "Unknown memory should be released.");
-                print_table();
-                assert(1==0);
+                cache[requestor] = std::make_pair(now, amount);
             }
             else
             {
                 cache_entry_t& entry = found->second;
+                entry.first.tv_sec = now.tv_sec;
+                entry.first.tv_nsec = now.tv_nsec;
+                entry.second += amount;
+            }
 
-                if (entry.second >= amount)
-                {
-                    entry.second -= amount;
-                    assert(allocated_memory >= amount);
-                    if (allocated_memory >= amount) allocated_memory -= amount;
-                    else
-                    {
-                        debug(TM, "More mem to release than available.");
-                        print_table();
-                        assert(1==0);
-                    }
-                }
-                else
-                {
-                    print_table();
-                    assert(entry.second >= amount); // will break
-                }
+            allocated_memory += amount;
+#ifdef TILECACHE_DEBUG
+    print_table();
+#endif
+            return fits;
+        }
+
+        /**
+         * Give back memory reserved by \p requestor.
+         */
+        void release_cache_memory(TileCacheBase* requestor, uint_fast64_t amount)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
 
-                if (entry.second == 0)
-                {
 #ifdef TILECACHE_DEBUG
-      debug(TM, "Memory completely released. Remove entry from global cache.");
+      debug(TM, "Local cache %p releases %d bytes.", requestor, amount);
 #endif
-                    cache.erase(found);
-                }
-            }
+            release(requestor, amount);
         }
 
         inline uint_fast64_t get_max_cache_memory() const
@@ -264,11 +311,13 @@ namespace degate
 
         inline uint_fast64_t get_allocated_memory() const
         {
+            std::lock_guard<std::mutex> lock(mutex);
             return allocated_memory;
         }
 
         inline bool is_full(uint_fast64_t amount) const
         {
+            std::lock_guard<std::mutex> lock(mutex);
             return allocated_memory + amount > max_cache_memory;
         }
     };
@@ -284,6 +333,10 @@ namespace degate
      * requirement is around
      * \p _min_cache_tiles*sizeof(PixelPolicy::pixel_type)*(2^_tile_width_exp)^2 ,
      * where \p sizeof(PixelPolicy::pixel_type) is the size of a pixel.
+     *
+     * If the tiles are stored in a TileContainer, tiles are views into the
+     * container mapping. They are not cached, because the operating system
+     * manages the memory of the mapping.
      */
     template <class PixelPolicy>
     class TileCache : public TileCacheBase
@@ -302,12 +355,16 @@ namespace degate
 
         cache_type cache;
 
+        // If set, all tiles are stored in this container instead of separate files.
+        TileContainer_shptr container;
+
         // Used for caching the working tile.
         mutable MemoryMap_shptr current_tile;
         mutable unsigned curr_tile_num_x;
         mutable unsigned curr_tile_num_y;
 
-        std::mutex mutex;
+        // Recursive, the GlobalTileCache may evict a tile of this cache while this cache requests memory.
+        std::recursive_mutex mutex;
 
 
     public:
@@ -338,10 +395,10 @@ namespace degate
 
         void release_memory()
         {
+            std::lock_guard<std::recursive_mutex> lock(mutex);
+
             if (cache.size() > 0)
             {
-                std::lock_guard<std::mutex> lock(mutex);
-
                 GlobalTileCache& gtc = GlobalTileCache::get_instance();
                 gtc.release_cache_memory(this, cache.size() * get_image_size());
                 current_tile.reset();
@@ -349,6 +406,22 @@ namespace degate
             }
         }
 
+        /**
+         * Store the tiles in a container instead of separate files.
+         */
+        void set_container(TileContainer_shptr container)
+        {
+            std::lock_guard<std::recursive_mutex> lock(mutex);
+
+            current_tile.reset();
+            this->container = container;
+        }
+
+        TileContainer_shptr get_container() const
+        {
+            return container;
+        }
+
         void print() const override
         {
             for (typename cache_type::const_iterator iter = cache.begin();
@@ -402,14 +475,30 @@ namespace degate
                     //if (y >= tile_num_min_y && y <= tile_num_max_y && x >= tile_num_min_x && x <= tile_num_max_x)
                         //continue;
 
-                    load_tile(x, y);
+                    if (container != nullptr) container->prefetch(x, y);
+                    else load_tile(x, y);
                 }
             }
         }
 
-        inline void load_tile(unsigned int x, unsigned int y, bool update_current = false)
+        inline MemoryMap_shptr load_tile(unsigned int x, unsigned int y, bool update_current = false)
         {
-            std::lock_guard<std::mutex> lock(mutex);
+            if (container != nullptr)
+            {
+                TRACE_COUNT("tile-container-fetch", 1);
+                MemoryMap_shptr mem = load_container_tile(x, y);
+
+                if (update_current)
+                {
+                    current_tile = mem;
+                    curr_tile_num_x = x;
+                    curr_tile_num_y = y;
+                }
+
+                return mem;
+            }
+
+            std::lock_guard<std::recursive_mutex> lock(mutex);
 
             // create a file name from tile number
             char filename[PATH_MAX];
@@ -420,14 +509,28 @@ namespace degate
 
             if (iter == cache.end())
             {
+                TRACE_COUNT("tile-cache-miss", 1);
+
                 GlobalTileCache& gtc = GlobalTileCache::get_instance();
 
-                bool ok = gtc.request_cache_memory(this, get_image_size());
-                assert(ok == true);
+                gtc.request_cache_memory(this, get_image_size());
+
                 struct timespec now{};
                 GET_CLOCK(now);
 
-                cache[filename] = std::make_pair(load(filename), now);
+                // Give back the reserved memory, if the tile cannot be loaded.
+                MemoryMap_shptr mem;
+                try
+                {
+                    mem = load(filename);
+                }
+                catch (...)
+                {
+                    gtc.release_cache_memory(this, get_image_size());
+                    throw;
+                }
+
+                cache[filename] = std::make_pair(mem, now);
 
                 //debug(TM, "Cache size : %d/%d", gtc.get_allocated_memory(), gtc.get_max_cache_memory());
 
@@ -435,13 +538,17 @@ namespace degate
                 gtc.print_table();
                 #endif
             }
+            else
+            {
+                TRACE_COUNT("tile-cache-hit", 1);
+            }
 
             // Get current time
             struct timespec now{};
             GET_CLOCK(now);
 
             // Update entry
-            auto entry = cache[filename];
+            auto& entry = cache[filename];
             entry.second = now;
 
             if (update_current)
@@ -450,6 +557,21 @@ namespace degate
                 curr_tile_num_x = x;
                 curr_tile_num_y = y;
             }
+
+            return entry.first;
+        }
+
+        /**
+         * Get a tile without changing the working tile. If the tile is not in the cache, the tile is loaded.
+         * Unlike get_tile(), this can be used from another thread.
+         *
+         * @param x Absolut pixel coordinate.
+         * @param y Absolut pixel coordinate.
+         * @return Returns a shared pointer to a MemoryMap object.
+         */
+        inline MemoryMap_shptr fetch_tile(unsigned int x, unsigned int y)
+        {
+            return load_tile(x >> tile_width_exp, y >> tile_width_exp);
         }
 
         /**
@@ -478,11 +600,13 @@ namespace degate
     protected:
 
         /**
-         * Remove the oldest entry from the cache.
+         * Remove the oldest entry from the cache, unless another thread uses the cache.
+         * @see TileCacheBase::try_cleanup_cache()
          */
-        void cleanup_cache() override
+        uint_fast64_t try_cleanup_cache() override
         {
-            if (cache.size() == 0) return;
+            std::unique_lock<std::recursive_mutex> lock(mutex, std::try_to_lock);
+            if (!lock.owns_lock() || cache.size() == 0) return 0;
 
             struct timespec oldest_clock_val;
             GET_CLOCK(oldest_clock_val);
@@ -504,11 +628,11 @@ namespace degate
             assert(oldest != cache.end());
             (*oldest).second.first.reset(); // explicit reset of smart pointer
             cache.erase(oldest);
+            TRACE_COUNT("tile-cache-eviction", 1);
 #ifdef TILECACHE_DEBUG
       debug(TM, "local cache: %d entries after remove\n", cache.size());
 #endif
-            GlobalTileCache& gtc = GlobalTileCache::get_instance();
-            gtc.release_cache_memory(this, get_image_size());
+            return get_image_size();
         }
 
 
@@ -539,6 +663,25 @@ namespace degate
 
             return mem;
         }
+
+        /**
+         * Get a view of a tile in the container.
+         * Tiles outside of the container are backed by heap memory and are not stored.
+         */
+        MemoryMap_shptr load_container_tile(unsigned int x, unsigned int y) const
+        {
+            typedef typename PixelPolicy::pixel_type pixel_type;
+
+            pixel_type* tile = static_cast<pixel_type*>(container->get_tile(x, y));
+
+            if (tile == nullptr)
+            {
+                debug(TM, "Tile %d/%d is outside of the tile container %s", x, y, container->get_filename().c_str());
+                return std::make_shared<MemoryMap<pixel_type>>(1 << tile_width_exp, 1 << tile_width_exp);
+            }
+
+            return std::make_shared<MemoryMap<pixel_type>>(1 << tile_width_exp, 1 << tile_width_exp, tile, container);
+        }
     }; // end of class TileCache
 }
 
@@ -0,0 +1,290 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/Image/TileContainer.h"
+#include "Core/Utils/DegateExceptions.h"
+#include "Core/Utils/FileSystem.h"
+
+#include <cstring>
+#include <boost/format.hpp>
+
+#if defined(SYS_WINDOWS)
+#define NOMINMAX
+#include <Windows.h>
+#include <winioctl.h>
+#elif defined(SYS_UNIX)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#error "Unknown architecture"
+#endif
+
+using namespace degate;
+
+#define TILE_CONTAINER_MAGIC "DGTC"
+#define TILE_CONTAINER_FORMAT 1
+#define TILE_CONTAINER_ALIGNMENT 4096
+
+namespace
+{
+    /**
+     * The header at the start of a container file. It is followed by the tile offset table.
+     */
+    struct container_header
+    {
+        char magic[4];
+        uint32_t format;
+        uint32_t tile_width_exp;
+        uint32_t pixel_size;
+        uint32_t tiles_x;
+        uint32_t tiles_y;
+        uint64_t data_offset;
+    };
+}
+
+TileContainer::TileContainer(std::string const& filename,
+                             unsigned int tiles_x, unsigned int tiles_y,
+                             unsigned int tile_width_exp, unsigned int pixel_size) :
+    filename(filename),
+    tiles_x(tiles_x),
+    tiles_y(tiles_y),
+    tile_width_exp(tile_width_exp),
+    pixel_size(pixel_size),
+    tile_bytes((std::size_t(1) << (2 * tile_width_exp)) * pixel_size),
+    file_size(0),
+#ifdef SYS_WINDOWS
+    file(nullptr),
+    mem_file(nullptr),
+#else
+    file(-1),
+#endif
+    mem_view(nullptr),
+    offsets(nullptr)
+{
+    if (tiles_x == 0 || tiles_y == 0)
+        throw DegateRuntimeException("A tile container needs at least one tile.");
+
+    const std::size_t tiles = static_cast<std::size_t>(tiles_x) * tiles_y;
+    const std::size_t table_end = sizeof(container_header) + tiles * sizeof(uint64_t);
+    const std::size_t data_offset = (table_end + TILE_CONTAINER_ALIGNMENT - 1) / TILE_CONTAINER_ALIGNMENT * TILE_CONTAINER_ALIGNMENT;
+
+    file_size = data_offset + tiles * tile_bytes;
+
+    map();
+
+    container_header* header = reinterpret_cast<container_header*>(mem_view);
+    uint64_t* table = reinterpret_cast<uint64_t*>(mem_view + sizeof(container_header));
+
+    // A new container is all zeros. A crash before its initialization finished leaves it
+    // without magic as well, so it is initialized again.
+    static const char no_magic[sizeof(header->magic)] = {};
+
+    if (std::memcmp(header->magic, no_magic, sizeof(header->magic)) == 0)
+    {
+        for (std::size_t i = 0; i < tiles; i++)
+            table[i] = data_offset + i * tile_bytes;
+
+        header->format = TILE_CONTAINER_FORMAT;
+        header->tile_width_exp = tile_width_exp;
+        header->pixel_size = pixel_size;
+        header->tiles_x = tiles_x;
+        header->tiles_y = tiles_y;
+        header->data_offset = data_offset;
+
+        // The magic comes last and marks the container as initialized.
+        std::memcpy(header->magic, TILE_CONTAINER_MAGIC, sizeof(header->magic));
+    }
+    else if (std::memcmp(header->magic, TILE_CONTAINER_MAGIC, sizeof(header->magic)) != 0 ||
+             header->format != TILE_CONTAINER_FORMAT ||
+             header->tile_width_exp != tile_width_exp ||
+             header->pixel_size != pixel_size ||
+             header->tiles_x != tiles_x ||
+             header->tiles_y != tiles_y)
+    {
+        unmap();
+        throw DegateRuntimeException(boost::str(boost::format("The tile container %1% has another layout.") % filename));
+    }
+    else
+    {
+        for (std::size_t i = 0; i < tiles; i++)
+            if (table[i] + tile_bytes > file_size)
+            {
+                unmap();
+                throw DegateRuntimeException(boost::str(boost::format("The tile container %1% is corrupted.") % filename));
+            }
+    }
+
+    offsets = table;
+}
+
+TileContainer::~TileContainer()
+{
+    unmap();
+}
+
+void TileContainer::map()
+{
+#ifdef SYS_WINDOWS
+
+    file = CreateFileA(filename.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                       OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        file = nullptr;
+        throw DegateRuntimeException(boost::str(boost::format("Can't open the tile container %1%.") % filename));
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size))
+    {
+        unmap();
+        throw DegateRuntimeException(boost::str(boost::format("Can't open the tile container %1%.") % filename));
+    }
+
+    if (size.QuadPart == 0)
+    {
+        DWORD bytes_returned = 0;
+        DeviceIoControl(file, FSCTL_SET_SPARSE, nullptr, 0, nullptr, 0, &bytes_returned, nullptr);
+
+        size.QuadPart = static_cast<LONGLONG>(file_size);
+        if (!SetFilePointerEx(file, size, nullptr, FILE_BEGIN) || !SetEndOfFile(file))
+        {
+            unmap();
+            throw DegateRuntimeException(boost::str(boost::format("Can't resize the tile container %1%.") % filename));
+        }
+    }
+    else if (static_cast<std::size_t>(size.QuadPart) < file_size)
+    {
+        unmap();
+        throw DegateRuntimeException(boost::str(boost::format("The tile container %1% is truncated.") % filename));
+    }
+
+    mem_file = CreateFileMapping(file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+    if (mem_file != nullptr) mem_view = static_cast<uint8_t*>(MapViewOfFile(mem_file, FILE_MAP_ALL_ACCESS, 0, 0, file_size));
+
+#else
+
+    file = open(filename.c_str(), O_RDWR | O_CREAT, 0600);
+    if (file == -1)
+        throw DegateRuntimeException(boost::str(boost::format("Can't open the tile container %1%.") % filename));
+
+    struct stat inf;
+    if (fstat(file, &inf) != 0)
+    {
+        unmap();
+        throw DegateRuntimeException(boost::str(boost::format("Can't open the tile container %1%.") % filename));
+    }
+
+    if (inf.st_size == 0)
+    {
+        // Truncating creates a sparse file.
+        if (ftruncate(file, static_cast<off_t>(file_size)) != 0)
+        {
+            unmap();
+            throw DegateRuntimeException(boost::str(boost::format("Can't resize the tile container %1%.") % filename));
+        }
+    }
+    else if (static_cast<std::size_t>(inf.st_size) < file_size)
+    {
+        unmap();
+        throw DegateRuntimeException(boost::str(boost::format("The tile container %1% is truncated.") % filename));
+    }
+
+    void* view = mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    if (view != MAP_FAILED) mem_view = static_cast<uint8_t*>(view);
+
+#endif
+
+    if (mem_view == nullptr)
+    {
+        unmap();
+        throw DegateRuntimeException(boost::str(boost::format("Can't map the tile container %1%.") % filename));
+    }
+}
+
+void TileContainer::unmap()
+{
+#ifdef SYS_WINDOWS
+
+    if (mem_view != nullptr) UnmapViewOfFile(mem_view);
+    if (mem_file != nullptr) CloseHandle(mem_file);
+    if (file != nullptr) CloseHandle(file);
+
+    mem_file = nullptr;
+    file = nullptr;
+
+#else
+
+    if (mem_view != nullptr) munmap(mem_view, file_size);
+    if (file != -1) close(file);
+
+    file = -1;
+
+#endif
+
+    mem_view = nullptr;
+    offsets = nullptr;
+}
+
+void TileContainer::set_access_pattern(ACCESS_PATTERN pattern)
+{
+#ifdef SYS_UNIX
+    int advice = MADV_NORMAL;
+    if (pattern == ACCESS_SEQUENTIAL) advice = MADV_SEQUENTIAL;
+    else if (pattern == ACCESS_RANDOM) advice = MADV_RANDOM;
+
+    if (madvise(mem_view, file_size, advice) != 0)
+        debug(TM, "madvise() failed for the tile container %s", filename.c_str());
+#endif
+}
+
+void TileContainer::prefetch(unsigned int x, unsigned int y) const
+{
+#ifdef SYS_UNIX
+    uint8_t* tile = static_cast<uint8_t*>(get_tile(x, y));
+    if (tile == nullptr) return;
+
+    // madvise() needs a page aligned address.
+    const std::size_t page_offset = static_cast<std::size_t>(tile - mem_view) % TILE_CONTAINER_ALIGNMENT;
+    madvise(tile - page_offset, tile_bytes + page_offset, MADV_WILLNEED);
+#endif
+}
+
+void TileContainer::flush()
+{
+#ifdef SYS_WINDOWS
+    FlushViewOfFile(mem_view, 0);
+#else
+    msync(mem_view, file_size, MS_SYNC);
+#endif
+}
+
+bool TileContainer::has_tile_files(std::string const& directory)
+{
+    if (!file_exists(directory)) return false;
+
+    for (auto const& name : read_directory(directory))
+        if (get_file_suffix(name) == "dat") return true;
+
+    return false;
+}
@@ -0,0 +1,158 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __TILECONTAINER_H__
+#define __TILECONTAINER_H__
+
+#include "Prerequisites.h"
+#include "Globals.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <boost/utility.hpp>
+
+/**
+ * Name of the file, that holds all tiles of a tile based image.
+ */
+#define TILE_CONTAINER_FILENAME "tiles.dtc"
+
+namespace degate
+{
+    /**
+     * A single file, that holds all tiles of a tile based image.
+     *
+     * The file starts with a header and a table with the file offset of each tile,
+     * followed by the tile data. The file is created as sparse file with its full
+     * size, so untouched tiles do not occupy disk space. The whole file is mapped
+     * into memory once, so looking up a tile is a table access.
+     *
+     * Images, that are stored with one file per tile, are still supported by the
+     * TileCache.
+     *
+     * @see TileCache
+     */
+    class TileContainer : boost::noncopyable
+    {
+    public:
+
+        /**
+         * Access pattern hints for the operating system.
+         */
+        enum ACCESS_PATTERN
+        {
+            ACCESS_NORMAL = 0,
+            ACCESS_SEQUENTIAL = 1,
+            ACCESS_RANDOM = 2
+        };
+
+    private:
+
+        std::string filename;
+
+        unsigned int tiles_x;
+        unsigned int tiles_y;
+        unsigned int tile_width_exp;
+        unsigned int pixel_size;
+
+        std::size_t tile_bytes;
+        std::size_t file_size;
+
+#ifdef SYS_WINDOWS
+        void* file;
+        void* mem_file;
+#else
+        int file;
+#endif
+
+        uint8_t* mem_view;
+        uint64_t const* offsets;
+
+    private:
+
+        /**
+         * Open and map the container file. An empty file is resized to the container size.
+         */
+        void map();
+        void unmap();
+
+    public:
+
+        /**
+         * Open a tile container. If the file does not exist, it is created.
+         * @param filename The container file.
+         * @param tiles_x, tiles_y The number of tiles in each direction.
+         * @param tile_width_exp The width (and height) of a tile as exponent to the base 2.
+         * @param pixel_size The size of a pixel in bytes.
+         * @exception DegateRuntimeException This exception is thrown, if the file cannot be
+         *   created or mapped, or if an existing file has another layout.
+         */
+        TileContainer(std::string const& filename,
+                      unsigned int tiles_x, unsigned int tiles_y,
+                      unsigned int tile_width_exp, unsigned int pixel_size);
+
+        /**
+         * Unmap and close the container. Changes are written back.
+         */
+        ~TileContainer();
+
+        /**
+         * Get the memory of a tile.
+         * @param x, y The tile number.
+         * @return Returns a pointer into the mapped file or nullptr, if the tile number
+         *   is outside of the container.
+         */
+        inline void* get_tile(unsigned int x, unsigned int y) const
+        {
+            if (x >= tiles_x || y >= tiles_y) return nullptr;
+            return mem_view + offsets[static_cast<std::size_t>(y) * tiles_x + x];
+        }
+
+        /**
+         * Tell the operating system how the tiles will be accessed.
+         */
+        void set_access_pattern(ACCESS_PATTERN pattern);
+
+        /**
+         * Ask the operating system to read a tile ahead.
+         */
+        void prefetch(unsigned int x, unsigned int y) const;
+
+        /**
+         * Write changed tiles back to the file.
+         */
+        void flush();
+
+        std::string const& get_filename() const { return filename; }
+        unsigned int get_tiles_x() const { return tiles_x; }
+        unsigned int get_tiles_y() const { return tiles_y; }
+
+        /**
+         * Check if a directory holds tiles in separate files.
+         */
+        static bool has_tile_files(std::string const& directory);
+    };
+
+    typedef std::shared_ptr<TileContainer> TileContainer_shptr;
+}
+
+#endif
@@ -118,7 +118,15 @@ namespace degate
             if (!file_exists(directory)) create_directory(directory);
 
             double temp_tile_size = 1 << tile_width_exp;
-            tiles_number = static_cast<unsigned>(ceil(static_cast<double>(width) / temp_tile_size)) * static_cast<unsigned>(ceil(static_cast<double>(height) / temp_tile_size));
+            unsigned int tiles_x = static_cast<unsigned>(ceil(static_cast<double>(width) / temp_tile_size));
+            unsigned int tiles_y = static_cast<unsigned>(ceil(static_cast<double>(height) / temp_tile_size));
+            tiles_number = tiles_x * tiles_y;
+
+            // Images with one file per tile are kept as they are. All others use a single container file.
+            if (tiles_number > 0 && !TileContainer::has_tile_files(directory))
+                tile_cache.set_container(std::make_shared<TileContainer>(join_pathes(directory, TILE_CONTAINER_FILENAME),
+                                                                         tiles_x, tiles_y, tile_width_exp,
+                                                                         sizeof(typename PixelPolicy::pixel_type)));
         }
 
         /**
@@ -127,7 +135,11 @@ namespace degate
         virtual ~StoragePolicy_Tile()
         {
             tile_cache.release_memory();
-            if (persistent == false) remove_directory(directory);
+            if (persistent == false)
+            {
+                tile_cache.set_container(nullptr);
+                remove_directory(directory);
+            }
         }
 
         inline unsigned int get_tiles_number() const
@@ -182,6 +194,16 @@ namespace degate
             return tile_cache.get_tile(src_x, src_y)->data();
         }
 
+        /**
+         * Get the image tile that has its upper left corner at x,y. The tile stays valid as long as the
+         * returned pointer is held, even if it is removed from the cache. Unlike data(), this can be
+         * used from another thread.
+         */
+        MemoryMap_shptr fetch_tile(unsigned int src_x, unsigned int src_y)
+        {
+            return tile_cache.fetch_tile(src_x, src_y);
+        }
+
         /**
          * Cache the tile around a rectangle.
          *
@@ -201,6 +223,16 @@ namespace degate
             tile_cache.cache_around(min_x, max_x, min_y, max_y, width, height, radius);
         }
 
+        /**
+         * Tell the operating system how the image will be accessed. This only has an
+         * effect, if the tiles are stored in a TileContainer.
+         */
+        void set_access_pattern(TileContainer::ACCESS_PATTERN pattern)
+        {
+            TileContainer_shptr container = tile_cache.get_container();
+            if (container != nullptr) container->set_access_pattern(pattern);
+        }
+
         /**
          * Release the cache memory.
          */
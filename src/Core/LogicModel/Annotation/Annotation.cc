@@ -28,13 +28,14 @@ using namespace degate;
 
 Annotation::Annotation(float min_x, float max_x, float min_y, float max_y,
                        class_id_t class_id) :
-        Rectangle(min_x, max_x, min_y, max_y), class_id(class_id)
+        Rectangle(min_x, max_x, min_y, max_y), PlacedLogicModelObject(kind_tag), class_id(class_id)
 {
 }
 
 Annotation::Annotation(BoundingBox const& bbox, class_id_t class_id) :
     Rectangle(bbox.get_min_x(), bbox.get_max_x(),
               bbox.get_min_y(), bbox.get_max_y()),
+    PlacedLogicModelObject(kind_tag),
     class_id(class_id)
 {
 }
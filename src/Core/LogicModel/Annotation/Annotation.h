@@ -62,6 +62,13 @@ namespace degate
     {
     Q_DECLARE_TR_FUNCTIONS(degate::Annotation)
 
+    public:
+
+        /**
+         * The kind of all objects of this class.
+         */
+        static const OBJECT_KIND kind_tag = KIND_ANNOTATION;
+
     public:
 
         typedef unsigned int class_id_t;
@@ -31,7 +31,8 @@
 
 using namespace degate;
 
-ConnectedLogicModelObject::ConnectedLogicModelObject()
+ConnectedLogicModelObject::ConnectedLogicModelObject(OBJECT_KIND kind) :
+    PlacedLogicModelObject(kind)
 {
 }
 
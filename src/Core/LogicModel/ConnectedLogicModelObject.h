@@ -43,8 +43,9 @@ namespace degate
 
         /**
          * Construct an object.
+         * @param kind The kind of the object.
          */
-        ConnectedLogicModelObject();
+        explicit ConnectedLogicModelObject(OBJECT_KIND kind = KIND_UNDEFINED);
 
 
         /**
@@ -80,6 +81,18 @@ namespace degate
          */
         virtual bool is_connected() const;
     };
+
+    /**
+     * Cast a placed object to a ConnectedLogicModelObject by its kind tag.
+     * @see PlacedLogicModelObject::is_connectable()
+     */
+    template <>
+    inline std::shared_ptr<ConnectedLogicModelObject>
+    object_kind_cast<ConnectedLogicModelObject>(std::shared_ptr<PlacedLogicModelObject> const& o)
+    {
+        if (o == nullptr || !o->is_connectable()) return nullptr;
+        return std::static_pointer_cast<ConnectedLogicModelObject>(o);
+    }
 }
 
 #endif
@@ -0,0 +1,328 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/LogicModel/CoverageMap.h"
+#include "Core/Image/Image.h"
+
+#include <cmath>
+#include <algorithm>
+#include <cassert>
+
+using namespace degate;
+
+CoverageMap::CoverageMap(unsigned int width, unsigned int height, unsigned int min_cell_size, unsigned int max_cells) :
+    width(std::max(width, 1u)),
+    height(std::max(height, 1u))
+{
+    assert(max_cells > 0);
+
+    base_cell_size = 1;
+    while (base_cell_size < min_cell_size ||
+           (this->width + base_cell_size - 1) / base_cell_size > max_cells ||
+           (this->height + base_cell_size - 1) / base_cell_size > max_cells)
+        base_cell_size *= 2;
+
+    // Create levels until a level fits in one cell.
+    for (unsigned int scaling = 1;; scaling *= 2)
+    {
+        Level level;
+        level.scaling = scaling;
+        level.cell_size = base_cell_size * scaling;
+        level.width = (this->width + level.cell_size - 1) / level.cell_size;
+        level.height = (this->height + level.cell_size - 1) / level.cell_size;
+        level.cells.resize(level.width * level.height);
+        level.dirty = true;
+        level.dirty_min_x = level.dirty_min_y = 0;
+        level.dirty_max_x = level.width - 1;
+        level.dirty_max_y = level.height - 1;
+
+        levels.push_back(level);
+
+        if (level.width == 1 && level.height == 1)
+            break;
+    }
+}
+
+void CoverageMap::accumulate(Level& level, float min_x, float max_x, float min_y, float max_y, color_t color, float sign)
+{
+    const float cell_size = static_cast<float>(level.cell_size);
+
+    min_x = std::max(min_x, 0.0f);
+    min_y = std::max(min_y, 0.0f);
+    max_x = std::min(max_x, static_cast<float>(width));
+    max_y = std::min(max_y, static_cast<float>(height));
+
+    if (max_x <= min_x || max_y <= min_y)
+        return;
+
+    const unsigned int first_x = std::min(static_cast<unsigned int>(min_x / cell_size), level.width - 1);
+    const unsigned int last_x = std::min(static_cast<unsigned int>(std::ceil(max_x / cell_size)) - 1, level.width - 1);
+    const unsigned int first_y = std::min(static_cast<unsigned int>(min_y / cell_size), level.height - 1);
+    const unsigned int last_y = std::min(static_cast<unsigned int>(std::ceil(max_y / cell_size)) - 1, level.height - 1);
+
+    const float red = MASK_R(color), green = MASK_G(color), blue = MASK_B(color), alpha = MASK_A(color);
+
+    for (unsigned int y = first_y; y <= last_y; y++)
+    {
+        const float overlap_y = std::min(max_y, (y + 1) * cell_size) - std::max(min_y, y * cell_size);
+
+        for (unsigned int x = first_x; x <= last_x; x++)
+        {
+            const float overlap_x = std::min(max_x, (x + 1) * cell_size) - std::max(min_x, x * cell_size);
+            const float area = sign * overlap_x * overlap_y;
+
+            Cell& cell = level.cells[y * level.width + x];
+            cell.coverage = std::max(cell.coverage + area, 0.0f);
+            cell.red = std::max(cell.red + red * area, 0.0f);
+            cell.green = std::max(cell.green + green * area, 0.0f);
+            cell.blue = std::max(cell.blue + blue * area, 0.0f);
+            cell.alpha = std::max(cell.alpha + alpha * area, 0.0f);
+        }
+    }
+}
+
+void CoverageMap::accumulate_segment(Level& level, Entry const& entry, float sign)
+{
+    const float cell_size = static_cast<float>(level.cell_size);
+    const float radius = entry.diameter / 2.0f;
+
+    const float dx = entry.to_x - entry.from_x;
+    const float dy = entry.to_y - entry.from_y;
+    const float length = std::sqrt(dx * dx + dy * dy);
+
+    // Walk along the major axis: u is the major coordinate, v the minor one.
+    const bool horizontal = std::fabs(dx) >= std::fabs(dy);
+    const float du = horizontal ? dx : dy;
+    const float dv = horizontal ? dy : dx;
+    const float from_u = horizontal ? entry.from_x : entry.from_y;
+    const float from_v = horizontal ? entry.from_y : entry.from_x;
+
+    // Extension of the ends along the major axis, and half thickness along the minor axis.
+    const float extension = radius * std::fabs(du) / length;
+    const float half_thickness = radius * length / std::fabs(du);
+    const float slope = dv / du;
+
+    const float start = std::min(from_u, from_u + du) - extension;
+    const float end = std::max(from_u, from_u + du) + extension;
+
+    float u = start;
+    while (u < end)
+    {
+        const float next = std::min(end, (std::floor(u / cell_size) + 1) * cell_size);
+        const float v = from_v + slope * ((u + next) / 2 - from_u);
+
+        if (horizontal)
+            accumulate(level, u, next, v - half_thickness, v + half_thickness, entry.color, sign);
+        else
+            accumulate(level, v - half_thickness, v + half_thickness, u, next, entry.color, sign);
+
+        u = next;
+    }
+}
+
+void CoverageMap::rasterize(Level& level, Entry const& entry, float sign)
+{
+    const float cell_size = static_cast<float>(level.cell_size);
+
+    // Degenerated boxes (e.g. points) still cover one pixel.
+    BoundingBox const& box = entry.box;
+    const float min_x = std::max(box.get_min_x(), 0.0f);
+    const float min_y = std::max(box.get_min_y(), 0.0f);
+    const float max_x = std::min(std::max(box.get_max_x(), min_x + 1), static_cast<float>(width));
+    const float max_y = std::min(std::max(box.get_max_y(), min_y + 1), static_cast<float>(height));
+
+    if (max_x <= min_x || max_y <= min_y)
+        return;
+
+    if (entry.segment)
+        accumulate_segment(level, entry, sign);
+    else
+        accumulate(level, min_x, max_x, min_y, max_y, entry.color, sign);
+
+    const unsigned int first_x = std::min(static_cast<unsigned int>(min_x / cell_size), level.width - 1);
+    const unsigned int last_x = std::min(static_cast<unsigned int>((max_x - 1) / cell_size), level.width - 1);
+    const unsigned int first_y = std::min(static_cast<unsigned int>(min_y / cell_size), level.height - 1);
+    const unsigned int last_y = std::min(static_cast<unsigned int>((max_y - 1) / cell_size), level.height - 1);
+
+    const unsigned int center_x = std::min(static_cast<unsigned int>((min_x + max_x) / 2 / cell_size), level.width - 1);
+    const unsigned int center_y = std::min(static_cast<unsigned int>((min_y + max_y) / 2 / cell_size), level.height - 1);
+
+    Cell& center = level.cells[center_y * level.width + center_x];
+    if (sign > 0) center.count++;
+    else if (center.count > 0) center.count--;
+
+    if (level.dirty)
+    {
+        level.dirty_min_x = std::min(level.dirty_min_x, first_x);
+        level.dirty_max_x = std::max(level.dirty_max_x, last_x);
+        level.dirty_min_y = std::min(level.dirty_min_y, first_y);
+        level.dirty_max_y = std::max(level.dirty_max_y, last_y);
+    }
+    else
+    {
+        level.dirty = true;
+        level.dirty_min_x = first_x;
+        level.dirty_max_x = last_x;
+        level.dirty_min_y = first_y;
+        level.dirty_max_y = last_y;
+    }
+}
+
+void CoverageMap::insert(object_id_t id, Entry const& entry)
+{
+    remove(id);
+
+    for (auto& level : levels)
+        rasterize(level, entry, 1);
+
+    entries[id] = entry;
+}
+
+void CoverageMap::insert(object_id_t id, BoundingBox const& box, color_t color)
+{
+    Entry entry;
+    entry.box = box;
+    entry.color = color;
+    entry.segment = false;
+    entry.from_x = entry.from_y = entry.to_x = entry.to_y = entry.diameter = 0;
+
+    insert(id, entry);
+}
+
+void CoverageMap::insert_segment(object_id_t id, float from_x, float from_y, float to_x, float to_y, float diameter, color_t color)
+{
+    const float radius = diameter / 2.0f;
+
+    Entry entry;
+    entry.box = BoundingBox(std::min(from_x, to_x) - radius, std::max(from_x, to_x) + radius,
+                            std::min(from_y, to_y) - radius, std::max(from_y, to_y) + radius);
+    entry.color = color;
+    entry.from_x = from_x;
+    entry.from_y = from_y;
+    entry.to_x = to_x;
+    entry.to_y = to_y;
+    entry.diameter = diameter;
+
+    // Points and segments without thickness are stored as boxes.
+    entry.segment = diameter > 0 && (from_x != to_x || from_y != to_y);
+
+    insert(id, entry);
+}
+
+void CoverageMap::remove(object_id_t id)
+{
+    auto iter = entries.find(id);
+    if (iter == entries.end())
+        return;
+
+    for (auto& level : levels)
+        rasterize(level, iter->second, -1);
+
+    entries.erase(iter);
+}
+
+bool CoverageMap::contains(object_id_t id) const
+{
+    return entries.find(id) != entries.end();
+}
+
+void CoverageMap::clear()
+{
+    entries.clear();
+
+    for (auto& level : levels)
+    {
+        std::fill(level.cells.begin(), level.cells.end(), Cell());
+
+        level.dirty = true;
+        level.dirty_min_x = level.dirty_min_y = 0;
+        level.dirty_max_x = level.width - 1;
+        level.dirty_max_y = level.height - 1;
+    }
+}
+
+unsigned int CoverageMap::get_objects_count() const
+{
+    return static_cast<unsigned int>(entries.size());
+}
+
+unsigned int CoverageMap::get_width() const
+{
+    return width;
+}
+
+unsigned int CoverageMap::get_height() const
+{
+    return height;
+}
+
+unsigned int CoverageMap::get_levels_count() const
+{
+    return static_cast<unsigned int>(levels.size());
+}
+
+CoverageMap::Level const& CoverageMap::get_level(unsigned int index) const
+{
+    assert(index < levels.size());
+    return levels[index];
+}
+
+unsigned int CoverageMap::get_level_index(double scaling) const
+{
+    unsigned int index = 0;
+
+    while (index + 1 < levels.size() && levels[index + 1].cell_size <= scaling)
+        index++;
+
+    return index;
+}
+
+color_t CoverageMap::get_cell_color(unsigned int index, unsigned int x, unsigned int y) const
+{
+    Level const& level = get_level(index);
+    assert(x < level.width && y < level.height);
+
+    Cell const& cell = level.cells[y * level.width + x];
+
+    if (cell.coverage <= 0)
+        return 0;
+
+    const float area = static_cast<float>(level.cell_size) * static_cast<float>(level.cell_size);
+    const float fraction = std::min(cell.coverage / area, 1.0f);
+
+    const unsigned int red = std::min(static_cast<unsigned int>(cell.red / cell.coverage + 0.5f), 255u);
+    const unsigned int green = std::min(static_cast<unsigned int>(cell.green / cell.coverage + 0.5f), 255u);
+    const unsigned int blue = std::min(static_cast<unsigned int>(cell.blue / cell.coverage + 0.5f), 255u);
+    const unsigned int alpha = std::min(static_cast<unsigned int>(cell.alpha / cell.coverage * fraction + 0.5f), 255u);
+
+    return MERGE_CHANNELS(red, green, blue, alpha);
+}
+
+unsigned int CoverageMap::get_base_cell_size() const
+{
+    return base_cell_size;
+}
+
+void CoverageMap::clear_dirty(unsigned int index)
+{
+    assert(index < levels.size());
+    levels[index].dirty = false;
+}
@@ -0,0 +1,229 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __COVERAGEMAP_H__
+#define __COVERAGEMAP_H__
+
+#include "Globals.h"
+#include "Core/Primitive/BoundingBox.h"
+
+#include <map>
+#include <vector>
+#include <memory>
+
+namespace degate
+{
+    /**
+     * Level of detail rasters of the objects of a layer.
+     *
+     * The layer area is split into cells. For every cell the map stores how much of it is covered
+     * by objects, how many objects are centered in it and the mean color of the objects covering it.
+     * This is all a renderer needs to draw a zoomed out view, where many objects fall within one pixel.
+     *
+     * There is one raster per level. Like the prescaled background images of a layer (@see ScalingManager),
+     * level i is scaled down by a factor of 2^i: a cell of level i covers base_cell_size * 2^i pixels. Every
+     * level is updated directly when an object is inserted or removed, so changing one object only touches
+     * a few cells per level. The touched area of each level is tracked, for partial uploads.
+     *
+     * Objects are either axis aligned boxes or thick line segments (wires). A segment only covers the cells
+     * along its path, not its whole bounding box.
+     */
+    class CoverageMap
+    {
+    public:
+
+        /**
+         * The data of a cell. Colors are summed up weighted by the covered area.
+         */
+        struct Cell
+        {
+            float coverage = 0;
+            float red = 0;
+            float green = 0;
+            float blue = 0;
+            float alpha = 0;
+            unsigned int count = 0;
+        };
+
+        /**
+         * A raster.
+         */
+        struct Level
+        {
+            unsigned int scaling;
+            unsigned int cell_size;
+            unsigned int width;
+            unsigned int height;
+            std::vector<Cell> cells;
+
+            // Touched cells since the last clear_dirty() call (min/max are inclusive).
+            bool dirty;
+            unsigned int dirty_min_x, dirty_max_x, dirty_min_y, dirty_max_y;
+        };
+
+    private:
+
+        struct Entry
+        {
+            BoundingBox box;
+            color_t color;
+
+            // Thick line segment (if segment is set), box is its extent.
+            bool segment;
+            float from_x, from_y, to_x, to_y;
+            float diameter;
+        };
+
+        unsigned int width, height;
+        unsigned int base_cell_size;
+
+        std::vector<Level> levels;
+        std::map<object_id_t, Entry> entries;
+
+        /**
+         * Add (sign = 1) or remove (sign = -1) an object from a level.
+         */
+        void rasterize(Level& level, Entry const& entry, float sign);
+
+        /**
+         * Add (sign = 1) or remove (sign = -1) the covered area of a box to the cells of a level.
+         */
+        void accumulate(Level& level, float min_x, float max_x, float min_y, float max_y, color_t color, float sign);
+
+        /**
+         * Add (sign = 1) or remove (sign = -1) the covered area of a thick segment to the cells of a level.
+         * The segment is cut into slices at the cell borders (along its major axis). Each slice is a
+         * parallelogram, accumulated as a box with the same area, centered on the segment.
+         */
+        void accumulate_segment(Level& level, Entry const& entry, float sign);
+
+        /**
+         * Store an entry, replacing the object with the same ID.
+         */
+        void insert(object_id_t id, Entry const& entry);
+
+    public:
+
+        /**
+         * Create an empty coverage map.
+         *
+         * @param width : the width of the layer.
+         * @param height : the height of the layer.
+         * @param min_cell_size : the minimal edge length of a cell of the first level (in pixels). The real
+         *   size is a power of two, big enough to keep the first level under \p max_cells cells per edge.
+         * @param max_cells : the maximal number of cells per edge of the first level.
+         */
+        CoverageMap(unsigned int width, unsigned int height, unsigned int min_cell_size = 8, unsigned int max_cells = 1024);
+
+        /**
+         * Add an object.
+         *
+         * @param id : the object ID. If an object with this ID is already stored, it is replaced.
+         * @param box : the area covered by the object.
+         * @param color : the color of the object.
+         */
+        void insert(object_id_t id, BoundingBox const& box, color_t color);
+
+        /**
+         * Add a thick line segment (e.g. a wire). The segment is extended by half its diameter at both
+         * ends, like a drawn wire.
+         *
+         * @param id : the object ID. If an object with this ID is already stored, it is replaced.
+         * @param from_x : the x-coordinate of the start point.
+         * @param from_y : the y-coordinate of the start point.
+         * @param to_x : the x-coordinate of the end point.
+         * @param to_y : the y-coordinate of the end point.
+         * @param diameter : the thickness of the segment.
+         * @param color : the color of the object.
+         */
+        void insert_segment(object_id_t id, float from_x, float from_y, float to_x, float to_y, float diameter, color_t color);
+
+        /**
+         * Remove an object. Nothing happens if there is no object with this ID.
+         */
+        void remove(object_id_t id);
+
+        /**
+         * Check if an object is stored.
+         */
+        bool contains(object_id_t id) const;
+
+        /**
+         * Remove all objects.
+         */
+        void clear();
+
+        /**
+         * Get the number of stored objects.
+         */
+        unsigned int get_objects_count() const;
+
+        /**
+         * Get the width of the covered area (in pixels).
+         */
+        unsigned int get_width() const;
+
+        /**
+         * Get the height of the covered area (in pixels).
+         */
+        unsigned int get_height() const;
+
+        /**
+         * Get the number of levels.
+         */
+        unsigned int get_levels_count() const;
+
+        /**
+         * Get a level by its index.
+         */
+        Level const& get_level(unsigned int index) const;
+
+        /**
+         * Get the index of the best level for a scaling (pixels per screen pixel). This is the
+         * coarsest level, whose cells are not bigger than one screen pixel.
+         */
+        unsigned int get_level_index(double scaling) const;
+
+        /**
+         * Get the color of a cell: the mean color of the objects covering it. The alpha channel
+         * is scaled by the covered fraction of the cell.
+         *
+         * @param index : the level index.
+         * @param x : the cell column.
+         * @param y : the cell row.
+         */
+        color_t get_cell_color(unsigned int index, unsigned int x, unsigned int y) const;
+
+        /**
+         * Get the edge length of a first level cell (in pixels).
+         */
+        unsigned int get_base_cell_size() const;
+
+        /**
+         * Forget the touched area of a level.
+         */
+        void clear_dirty(unsigned int index);
+    };
+
+    typedef std::shared_ptr<CoverageMap> CoverageMap_shptr;
+}
+
+#endif
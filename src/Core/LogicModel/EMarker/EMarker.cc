@@ -27,7 +27,7 @@
 using namespace degate;
 
 EMarker::EMarker(float x, float y, diameter_t diameter, bool is_module_port) :
-    Circle(x, y, diameter), module_port(is_module_port)
+    Circle(x, y, diameter), ConnectedLogicModelObject(kind_tag), module_port(is_module_port)
 {
 }
 
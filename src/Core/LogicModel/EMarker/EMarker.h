@@ -46,7 +46,14 @@ namespace degate
 
     public:
 
-        explicit EMarker()
+        /**
+         * The kind of all objects of this class.
+         */
+        static const OBJECT_KIND kind_tag = KIND_EMARKER;
+
+    public:
+
+        explicit EMarker() : ConnectedLogicModelObject(kind_tag)
         {
         };
 
@@ -72,10 +72,10 @@ void AutoNameGates::rename_gates(std::vector<unsigned int> const& histogram, std
                          orientation == ALONG_COLS ? 0 : i,
                          orientation == ALONG_COLS ? layer->get_height() - 1 : i);
 
-        for (Layer::qt_region_iterator iter = layer->region_begin(bbox); iter != layer->region_end(); ++iter)
+        for (Layer::qt_region_iterator iter = layer->region_begin(PlacedLogicModelObject::KIND_GATE, bbox);
+             iter != layer->region_end(); ++iter)
         {
-            if (Gate_shptr gate = std::dynamic_pointer_cast<Gate>(*iter))
-                gate_list.push_back(gate);
+            gate_list.push_back(std::static_pointer_cast<Gate>(*iter));
         }
 
         // sort gate list according to their min_x or min_y
@@ -90,6 +90,7 @@ void AutoNameGates::rename_gates(std::vector<unsigned int> const& histogram, std
             boost::format f("%1%.%2%");
             f % row_num % col_num;
             gate->set_name(f.str());
+            lmodel->get_journal()->record_object(gate->get_object_id());
 
             // next row or col
             if (orientation == ALONG_ROWS)
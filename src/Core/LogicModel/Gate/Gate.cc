@@ -29,6 +29,7 @@ using namespace degate;
 Gate::Gate(float min_x, float max_x, float min_y, float max_y,
            ORIENTATION orientation) :
     Rectangle(min_x, max_x, min_y, max_y),
+    PlacedLogicModelObject(kind_tag),
     orientation(orientation),
     template_type_id(0)
 {
@@ -38,6 +39,7 @@ Gate::Gate(BoundingBox const& bounding_box,
            ORIENTATION orientation):
     Rectangle(bounding_box.get_min_x(), bounding_box.get_max_x(),
               bounding_box.get_min_y(), bounding_box.get_max_y()),
+    PlacedLogicModelObject(kind_tag),
     orientation(orientation),
     template_type_id(0)
 {
@@ -46,6 +46,13 @@ namespace degate
     {
     Q_DECLARE_TR_FUNCTIONS(degate::Gate)
 
+    public:
+
+        /**
+         * The kind of all objects of this class.
+         */
+        static const OBJECT_KIND kind_tag = KIND_GATE;
+
     public:
 
         enum ORIENTATION
@@ -24,6 +24,8 @@
 #include "Core/Image/ImageHelper.h"
 #include "Core/Utils/DegateHelper.h"
 #include "Core/LogicModel/Gate/GateTemplate.h"
+#include "Core/Matching/PreparedTemplateCache.h"
+#include "Core/Utils/Trace.h"
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -43,6 +45,8 @@ using namespace degate;
 
 void GateLibraryExporter::export_data(std::string const& filename, GateLibrary_shptr gate_lib)
 {
+    TRACE_SCOPE_CATEGORY("gate-library/export", "io");
+
     if (gate_lib == nullptr) throw InvalidPointerException("Gate library pointer is nullptr.");
 
     std::string directory = get_basedir(filename);
@@ -155,6 +159,26 @@ void GateLibraryExporter::add_images(QDomDocument& doc,
         images_elem.appendChild(img_elem);
     }
 
+    // export images prepared for template matching
+    PreparedTemplateCache_shptr prepared_templates = gate_tmpl->get_prepared_templates();
+
+    object_id_t new_oid = oid_rewriter->get_new_object_id(gate_tmpl->get_object_id());
+    boost::format fmter("%1%_prepared.dat");
+    fmter % new_oid;
+    std::string filename(fmter.str());
+
+    if (prepared_templates->size() > 0)
+    {
+        images_elem.setAttribute("prepared-templates", QString::fromStdString(filename));
+
+        prepared_templates->save(join_pathes(directory, filename));
+    }
+    else if (file_exists(join_pathes(directory, filename)))
+    {
+        // All entries were dropped, e.g. because the images changed.
+        remove_file(join_pathes(directory, filename));
+    }
+
     gate_elem.appendChild(images_elem);
 }
 
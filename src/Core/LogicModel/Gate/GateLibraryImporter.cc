@@ -22,6 +22,8 @@
 #include "Core/LogicModel/Gate/GateLibraryImporter.h"
 #include "Core/Image/ImageHelper.h"
 #include "Core/LogicModel/Gate/GateTemplate.h"
+#include "Core/Matching/PreparedTemplateCache.h"
+#include "Core/Utils/Trace.h"
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -45,6 +47,8 @@ using namespace degate;
 
 GateLibrary_shptr GateLibraryImporter::import(std::string const& filename)
 {
+    TRACE_SCOPE_CATEGORY("gate-library/import", "io");
+
     if (RET_IS_NOT_OK(check_file(filename)))
     {
         debug(TM, "Problem: file %s not found.", filename.c_str());
@@ -187,6 +191,23 @@ void GateLibraryImporter::parse_template_images_element(QDomElement const templa
             gate_tmpl->set_image(layer_type, img);
         }
     }
+
+    // The prepared templates are only a cache. Entries of images, that changed since, are dropped.
+    const std::string prepared_file(template_images_element.attribute("prepared-templates").toStdString());
+    if (!prepared_file.empty())
+    {
+        PreparedTemplateCache_shptr prepared_templates = gate_tmpl->get_prepared_templates();
+
+        if (prepared_templates->load(join_pathes(directory, prepared_file)))
+        {
+            std::set<GateTemplate::image_version_t> versions;
+            for (GateTemplate::image_iterator iter = gate_tmpl->images_begin(); iter != gate_tmpl->images_end(); ++iter)
+                versions.insert(gate_tmpl->get_image_version(iter->first));
+
+            prepared_templates->retain(versions);
+        }
+        else debug(TM, "Can't load prepared templates from %s.", prepared_file.c_str());
+    }
 }
 
 void GateLibraryImporter::parse_template_implementations_element(QDomElement const implementations_element,
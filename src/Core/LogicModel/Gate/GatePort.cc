@@ -44,6 +44,7 @@ GatePort::GatePort(std::shared_ptr<Gate> gate,
            gate->get_min_y() +
            gate->get_relative_y_position_within_gate(gate_template_port->get_y()),
            diameter),
+    ConnectedLogicModelObject(kind_tag),
     gate(gate),
     gate_template_port(gate_template_port),
     template_port_id(gate_template_port->get_object_id())
@@ -53,6 +54,7 @@ GatePort::GatePort(std::shared_ptr<Gate> gate,
 
 GatePort::GatePort(std::shared_ptr<Gate> gate, unsigned int diameter) :
     Circle(0, 0, diameter),
+    ConnectedLogicModelObject(kind_tag),
     gate(gate),
     template_port_id(0)
 {
@@ -45,6 +45,13 @@ namespace degate
     {
     Q_DECLARE_TR_FUNCTIONS(degate::GatePort)
 
+    public:
+
+        /**
+         * The kind of all objects of this class.
+         */
+        static const OBJECT_KIND kind_tag = KIND_GATE_PORT;
+
     private:
 
         std::weak_ptr<Gate> gate;
@@ -54,7 +61,7 @@ namespace degate
     public:
 
 
-        explicit GatePort()
+        explicit GatePort() : ConnectedLogicModelObject(kind_tag)
         {
         };
 
@@ -21,6 +21,7 @@
  */
 
 #include "Core/LogicModel/Gate/GateTemplate.h"
+#include "Core/Matching/PreparedTemplateCache.h"
 
 using namespace degate;
 
@@ -36,17 +37,20 @@ void GateTemplate::decrement_reference_counter()
 
 
 GateTemplate::GateTemplate(float min_x, float max_x, float min_y, float max_y) :
-        bounding_box(min_x, max_x, min_y, max_y), reference_counter(0)
+        bounding_box(min_x, max_x, min_y, max_y), reference_counter(0),
+        prepared_templates(std::make_shared<PreparedTemplateCache>())
 {
 }
 
 GateTemplate::GateTemplate(float width, float height) :
-    bounding_box(0, width, 0, height), reference_counter(0)
+    bounding_box(0, width, 0, height), reference_counter(0),
+    prepared_templates(std::make_shared<PreparedTemplateCache>())
 {
 }
 
 GateTemplate::GateTemplate() :
-    bounding_box(0, 0, 0, 0), reference_counter(0)
+    bounding_box(0, 0, 0, 0), reference_counter(0),
+    prepared_templates(std::make_shared<PreparedTemplateCache>())
 {
 }
 
@@ -62,6 +66,7 @@ DeepCopyable_shptr GateTemplate::clone_shallow() const
     clone->reference_counter = reference_counter;
     clone->implementations = implementations;
     clone->logic_class = logic_class;
+    clone->prepared_templates = prepared_templates;
     return clone;
 }
 
@@ -81,6 +86,7 @@ void GateTemplate::clone_deep_into(DeepCopyable_shptr dest, oldnew_t* oldnew) co
 
     // images
     clone->images = images;
+    clone->image_versions = image_versions;
 
     ColoredObject::clone_deep_into(dest, oldnew);
     LogicModelObjectBase::clone_deep_into(dest, oldnew);
@@ -117,6 +123,12 @@ void GateTemplate::set_image(Layer::LAYER_TYPE layer_type, GateTemplateImage_shp
     if (img == nullptr) throw InvalidPointerException("Invalid pointer for image.");
     debug(TM, "set image for template.");
     images[layer_type] = img;
+    image_versions[layer_type] = PreparedTemplateCache::get_image_version(img);
+
+    // Drop prepared templates of replaced images.
+    std::set<image_version_t> versions;
+    for (auto const& version : image_versions) versions.insert(version.second);
+    prepared_templates->retain(versions);
 }
 
 
@@ -133,6 +145,19 @@ bool GateTemplate::has_image(Layer::LAYER_TYPE layer_type) const
     return images.find(layer_type) != images.end();
 }
 
+GateTemplate::image_version_t GateTemplate::get_image_version(Layer::LAYER_TYPE layer_type) const
+{
+    auto found = image_versions.find(layer_type);
+    if (found == image_versions.end())
+        throw CollectionLookupException("Can't find reference image.");
+    else return found->second;
+}
+
+PreparedTemplateCache_shptr GateTemplate::get_prepared_templates() const
+{
+    return prepared_templates;
+}
+
 void GateTemplate::add_template_port(GateTemplatePort_shptr template_port)
 {
     if (!template_port->has_valid_object_id())
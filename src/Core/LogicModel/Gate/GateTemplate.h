@@ -26,10 +26,10 @@
 #include "Core/LogicModel/Layer.h"
 #include "Core/Image/Image.h"
 #include "Core/LogicModel/Gate/GateTemplatePort.h"
-
 #include <set>
 #include <memory>
 #include <map>
+#include <cstdint>
 
 namespace degate
 {
@@ -61,6 +61,11 @@ namespace degate
         typedef std::map<Layer::LAYER_TYPE, GateTemplateImage_shptr> image_collection;
         typedef image_collection::iterator image_iterator;
 
+        /**
+         * Version of a reference image, a hash over its content (@see PreparedTemplateCache).
+         */
+        typedef uint64_t image_version_t;
+
     private:
 
         BoundingBox bounding_box;
@@ -70,6 +75,8 @@ namespace degate
 
         implementation_collection implementations;
         image_collection images;
+        std::map<Layer::LAYER_TYPE, image_version_t> image_versions;
+        PreparedTemplateCache_shptr prepared_templates;
 
         std::string logic_class = "undefined"; // e.g. nand, xor, flipflop, buffer, oai
 
@@ -174,6 +181,19 @@ namespace degate
          */
         virtual bool has_image(Layer::LAYER_TYPE layer_type) const;
 
+        /**
+         * Get the version of a reference image. The version changes, if another image
+         * is set with set_image().
+         * @exception CollectionLookupException Throws this exception, if there is no image.
+         */
+        virtual image_version_t get_image_version(Layer::LAYER_TYPE layer_type) const;
+
+        /**
+         * Get the cache of reference images, that are prepared for template matching.
+         * Clones of a template share the cache.
+         */
+        virtual PreparedTemplateCache_shptr get_prepared_templates() const;
+
         /**
          * Add a template port to a gate template.
          * This is an isolated function. The port is just added to the gate template.
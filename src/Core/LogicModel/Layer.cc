@@ -21,11 +21,13 @@
  */
 
 #include "Core/LogicModel/Layer.h"
+#include "Core/LogicModel/PickIndex.h"
 #include "Core/LogicModel/Gate/Gate.h"
 #include "Core/LogicModel/Via/Via.h"
 
 
 #include <memory>
+#include <limits>
 
 
 using namespace degate;
@@ -40,22 +42,27 @@ void Layer::add_object(std::shared_ptr<PlacedLogicModelObject> o)
         throw DegateLogicException(fmter.str());
     }
 
-    if (RET_IS_NOT_OK(quadtree.insert(o)))
+    if (RET_IS_NOT_OK(quadtree.insert(o)) ||
+        RET_IS_NOT_OK(get_kind_quadtree(o->get_object_kind()).insert(o)))
     {
         debug(TM, "Failed to insert object into quadtree.");
         throw DegateRuntimeException("Failed to insert object into quadtree.");
     }
+    pick_index->insert(o);
     objects[o->get_object_id()] = o;
 }
 
 void Layer::remove_object(std::shared_ptr<PlacedLogicModelObject> o)
 {
-    if (RET_IS_NOT_OK(quadtree.remove(o)))
+    if (RET_IS_NOT_OK(quadtree.remove(o)) ||
+        RET_IS_NOT_OK(get_kind_quadtree(o->get_object_kind()).remove(o)))
     {
         debug(TM, "Failed to remove object from quadtree.");
         throw std::runtime_error("Failed to remove object from quadtree.");
     }
 
+    pick_index->remove(o->get_object_id());
+
     objects.erase(o->get_object_id());
 }
 
@@ -71,13 +78,29 @@ std::shared_ptr<PlacedLogicModelObject> Layer::get_object(object_id_t object_id)
     return (*iter).second;
 }
 
+QuadTree<Layer::quadtree_element_type>& Layer::get_kind_quadtree(PlacedLogicModelObject::OBJECT_KIND kind)
+{
+    assert(kind < PlacedLogicModelObject::KIND_COUNT);
+    return *kind_quadtrees[kind];
+}
+
+void Layer::init_kind_quadtrees()
+{
+    for (auto& tree : kind_quadtrees)
+        tree.reset(new QuadTree<quadtree_element_type>(quadtree.get_bounding_box(), 100));
+
+    pick_index.reset(new PickIndex());
+}
+
 Layer::Layer(BoundingBox const& bbox, Layer::LAYER_TYPE layer_type) :
     quadtree(bbox, 100),
     layer_type(layer_type),
     layer_pos(0),
+    image_format(IMAGE_FORMAT_RGBA),
     enabled(true),
     layer_id(0)
 {
+    init_kind_quadtrees();
 }
 
 Layer::Layer(BoundingBox const& bbox, Layer::LAYER_TYPE layer_type,
@@ -85,9 +108,11 @@ Layer::Layer(BoundingBox const& bbox, Layer::LAYER_TYPE layer_type,
     quadtree(bbox, 100),
     layer_type(layer_type),
     layer_pos(0),
+    image_format(IMAGE_FORMAT_RGBA),
     enabled(true),
     layer_id(0)
 {
+    init_kind_quadtrees();
     set_image(img);
 }
 
@@ -106,7 +131,9 @@ DeepCopyable_shptr Layer::clone_shallow() const
     clone->enabled = enabled;
     clone->description = description;
     clone->layer_id = layer_id;
+    clone->image_format = image_format;
     clone->scaling_manager = scaling_manager;
+    clone->gs_scaling_manager = gs_scaling_manager;
     return clone;
 }
 
@@ -119,7 +146,10 @@ void Layer::clone_deep_into(DeepCopyable_shptr dest, oldnew_t* oldnew) const
     quadtree.get_all_elements(quadtree_elems);
     std::for_each(quadtree_elems.begin(), quadtree_elems.end(), [=,&clone](const quadtree_element_type& t)
     {
-        clone->quadtree.insert(std::dynamic_pointer_cast<PlacedLogicModelObject>(t->clone_deep(oldnew)));
+        auto object = std::dynamic_pointer_cast<PlacedLogicModelObject>(t->clone_deep(oldnew));
+        clone->quadtree.insert(object);
+        clone->get_kind_quadtree(object->get_object_kind()).insert(object);
+        clone->pick_index->insert(object);
     });
 
     // objects
@@ -222,6 +252,28 @@ Layer::qt_region_iterator Layer::region_end()
     return quadtree.region_iter_end();
 }
 
+Layer::object_iterator Layer::objects_begin(PlacedLogicModelObject::OBJECT_KIND kind)
+{
+    return get_kind_quadtree(kind).region_iter_begin();
+}
+
+Layer::qt_region_iterator Layer::region_begin(PlacedLogicModelObject::OBJECT_KIND kind,
+                                              int min_x, int max_x, int min_y, int max_y)
+{
+    return get_kind_quadtree(kind).region_iter_begin(min_x, max_x, min_y, max_y);
+}
+
+Layer::qt_region_iterator Layer::region_begin(PlacedLogicModelObject::OBJECT_KIND kind, BoundingBox const& bbox)
+{
+    return get_kind_quadtree(kind).region_iter_begin(bbox);
+}
+
+unsigned int Layer::get_object_count(PlacedLogicModelObject::OBJECT_KIND kind) const
+{
+    assert(kind < PlacedLogicModelObject::KIND_COUNT);
+    return kind_quadtrees[kind]->total_size();
+}
+
 void Layer::set_image(BackgroundImage_shptr img)
 {
     scaling_manager =
@@ -229,6 +281,45 @@ void Layer::set_image(BackgroundImage_shptr img)
         (img, img->get_directory());
 
     scaling_manager->create_scalings();
+
+    gs_scaling_manager.reset();
+    image_format = IMAGE_FORMAT_RGBA;
+}
+
+void Layer::set_image(GreyscaleBackgroundImage_shptr img)
+{
+    gs_scaling_manager =
+        std::make_shared<ScalingManager<GreyscaleBackgroundImage>>
+        (img, img->get_directory());
+
+    gs_scaling_manager->create_scalings();
+
+    scaling_manager.reset();
+    image_format = IMAGE_FORMAT_GS_BYTE;
+}
+
+Layer::IMAGE_FORMAT Layer::get_image_format() const
+{
+    return image_format;
+}
+
+const std::string Layer::get_image_format_as_string(IMAGE_FORMAT image_format)
+{
+    switch (image_format)
+    {
+    case IMAGE_FORMAT_GS_BYTE:
+        return std::string("gs-byte");
+    case IMAGE_FORMAT_RGBA:
+    default:
+        return std::string("rgba");
+    }
+}
+
+Layer::IMAGE_FORMAT Layer::get_image_format_from_string(std::string const& image_format_str)
+{
+    if (image_format_str == "rgba") return Layer::IMAGE_FORMAT_RGBA;
+    else if (image_format_str == "gs-byte") return Layer::IMAGE_FORMAT_GS_BYTE;
+    else throw DegateRuntimeException("Can't parse image format.");
 }
 
 BackgroundImage_shptr Layer::get_image()
@@ -238,28 +329,43 @@ BackgroundImage_shptr Layer::get_image()
         ScalingManager<BackgroundImage>::image_map_element p = scaling_manager->get_image(1);
         return p.second;
     }
+    else if (gs_scaling_manager != nullptr)
+        throw DegateLogicException("The background image is a greyscale image.");
     else throw DegateLogicException("You have to set the background image first.");
 }
 
+GreyscaleBackgroundImage_shptr Layer::get_greyscale_image()
+{
+    if (gs_scaling_manager != nullptr)
+    {
+        ScalingManager<GreyscaleBackgroundImage>::image_map_element p = gs_scaling_manager->get_image(1);
+        return p.second;
+    }
+    else throw DegateLogicException("You have to set a greyscale background image first.");
+}
+
 std::string Layer::get_image_filename() const
 {
-    if (scaling_manager == nullptr)
+    if (scaling_manager == nullptr && gs_scaling_manager == nullptr)
         throw DegateLogicException("There is no scaling manager.");
+
+    if (scaling_manager != nullptr)
+    {
+        const ScalingManager<BackgroundImage>::image_map_element p = scaling_manager->get_image(1);
+        if (p.second != nullptr) return p.second->get_directory();
+    }
     else
     {
-        const ScalingManager<BackgroundImage>::image_map_element p =
-            scaling_manager->get_image(1);
-
-        if (p.second != nullptr)
-            return p.second->get_directory();
-        else
-            throw DegateLogicException("The scaling manager failed to return an image pointer.");
+        const ScalingManager<GreyscaleBackgroundImage>::image_map_element p = gs_scaling_manager->get_image(1);
+        if (p.second != nullptr) return p.second->get_directory();
     }
+
+    throw DegateLogicException("The scaling manager failed to return an image pointer.");
 }
 
 bool Layer::has_background_image() const
 {
-    return scaling_manager != nullptr;
+    return scaling_manager != nullptr || gs_scaling_manager != nullptr;
 }
 
 void Layer::unset_image()
@@ -267,15 +373,23 @@ void Layer::unset_image()
     if (!has_background_image())
         return;
 
-    if (scaling_manager == nullptr) throw DegateLogicException("There is no scaling manager.");
-
     // Release (cache) memory
-    auto images = scaling_manager->get_images();
-    for (auto& image : images)
-        image.second->release_memory();
+    if (scaling_manager != nullptr)
+    {
+        for (auto& image : scaling_manager->get_images())
+            image.second->release_memory();
+    }
+
+    if (gs_scaling_manager != nullptr)
+    {
+        for (auto& image : gs_scaling_manager->get_images())
+            image.second->release_memory();
+    }
 
     std::string img_dir = get_image_filename();
     scaling_manager.reset();
+    gs_scaling_manager.reset();
+    image_format = IMAGE_FORMAT_RGBA;
 
     debug(TM, "remove directory: %s", img_dir.c_str());
     remove_directory(img_dir);
@@ -286,6 +400,19 @@ ScalingManager_shptr Layer::get_scaling_manager()
     return scaling_manager;
 }
 
+GreyscaleScalingManager_shptr Layer::get_greyscale_scaling_manager()
+{
+    return gs_scaling_manager;
+}
+
+std::list<double> Layer::get_zoom_steps() const
+{
+    if (scaling_manager != nullptr) return scaling_manager->get_zoom_steps();
+    if (gs_scaling_manager != nullptr) return gs_scaling_manager->get_zoom_steps();
+
+    return std::list<double>();
+}
+
 void Layer::print(std::ostream& os)
 {
     os
@@ -295,6 +422,7 @@ void Layer::print(std::ostream& os)
         << "Layer type           : " << get_layer_type_as_string() << std::endl
         << "Has background image : " << (has_background_image() ? "true" : "false") << std::endl
         << "Background image     : " << (has_background_image() ? get_image_filename() : "none") << std::endl
+        << "Image format         : " << get_image_format_as_string(image_format) << std::endl
         << std::endl;
 
     quadtree.print(os);
@@ -302,94 +430,26 @@ void Layer::print(std::ostream& os)
 
 void Layer::notify_shape_change(object_id_t object_id, const BoundingBox& old_bb)
 {
-    quadtree.notify_shape_change(get_object(object_id), old_bb);
+    PlacedLogicModelObject_shptr object = get_object(object_id);
+
+    quadtree.notify_shape_change(object, old_bb);
+    get_kind_quadtree(object->get_object_kind()).notify_shape_change(object, old_bb);
+    pick_index->insert(object);
 }
 
 
-enum class PlacedLogicModelObjectType
-{
-    NONE,
-    GATE_PORT,
-    VIA,
-    EMARKER,
-    GATE,
-    ANNOTATION,
-    WIRE
-};
-
 PlacedLogicModelObject_shptr Layer::get_object_at_position(float x, float y, float max_distance, bool ignore_annotations, bool ignore_gates, bool ignore_ports, bool ignore_emarkers, bool ignore_vias, bool ignore_wires)
 {
-    PlacedLogicModelObject_shptr object = nullptr;
-    auto type = PlacedLogicModelObjectType::NONE;
-
-    for (qt_region_iterator iter = quadtree.region_iter_begin(static_cast<int>(std::floor(x - max_distance)),
-                                                              static_cast<int>(std::ceil(x + max_distance)),
-                                                              static_cast<int>(std::floor(y - max_distance)),
-                                                              static_cast<int>(std::ceil(y + max_distance)));
-         iter != quadtree.region_iter_end(); ++iter)
-    {
-        if ((*iter)->in_shape(x, y, max_distance))
-        {
-            if (std::dynamic_pointer_cast<GatePort>((*iter)) != nullptr && !ignore_ports)
-            {
-                object = (*iter);
-                type = PlacedLogicModelObjectType::GATE_PORT;
-            }
-            else if (std::dynamic_pointer_cast<Via>((*iter)) != nullptr && !ignore_vias)
-            {
-                if (type == PlacedLogicModelObjectType::GATE_PORT)
-                    continue;
-
-                object = (*iter);
-                type = PlacedLogicModelObjectType::VIA;
-            }
-            else if (std::dynamic_pointer_cast<EMarker>((*iter)) != nullptr && !ignore_emarkers)
-            {
-                if (type == PlacedLogicModelObjectType::GATE_PORT ||
-                    type == PlacedLogicModelObjectType::VIA)
-                    continue;
-
-                object = (*iter);
-                type = PlacedLogicModelObjectType::EMARKER;
-            }
-            else if (std::dynamic_pointer_cast<Gate>((*iter)) != nullptr && !ignore_gates)
-            {
-                if (type == PlacedLogicModelObjectType::GATE_PORT ||
-                    type == PlacedLogicModelObjectType::VIA ||
-                    type == PlacedLogicModelObjectType::EMARKER)
-                    continue;
-
-                object = (*iter);
-                type = PlacedLogicModelObjectType::GATE;
-            }
-            else if (std::dynamic_pointer_cast<Annotation>((*iter)) != nullptr && !ignore_annotations)
-            {
-                if (type == PlacedLogicModelObjectType::GATE_PORT ||
-                    type == PlacedLogicModelObjectType::VIA ||
-                    type == PlacedLogicModelObjectType::EMARKER ||
-                    type == PlacedLogicModelObjectType::GATE)
-                    continue;
-
-                object = (*iter);
-                type = PlacedLogicModelObjectType::ANNOTATION;
-            }
-            else if (std::dynamic_pointer_cast<Wire>((*iter)) != nullptr && !ignore_wires)
-            {
-                if (type == PlacedLogicModelObjectType::GATE_PORT ||
-                    type == PlacedLogicModelObjectType::VIA ||
-                    type == PlacedLogicModelObjectType::EMARKER ||
-                    type == PlacedLogicModelObjectType::GATE ||
-                    type == PlacedLogicModelObjectType::ANNOTATION)
-                    continue;
-
-                object = (*iter);
-                type = PlacedLogicModelObjectType::WIRE;
-            }
-
-        }
-    }
+    PickIndex::kind_mask ignored;
+    ignored[PlacedLogicModelObject::KIND_UNDEFINED] = true;
+    ignored[PlacedLogicModelObject::KIND_GATE] = ignore_gates;
+    ignored[PlacedLogicModelObject::KIND_GATE_PORT] = ignore_ports;
+    ignored[PlacedLogicModelObject::KIND_VIA] = ignore_vias;
+    ignored[PlacedLogicModelObject::KIND_EMARKER] = ignore_emarkers;
+    ignored[PlacedLogicModelObject::KIND_WIRE] = ignore_wires;
+    ignored[PlacedLogicModelObject::KIND_ANNOTATION] = ignore_annotations;
 
-    return object;
+    return pick_index->pick(x, y, max_distance, ignored);
 }
 
 unsigned int Layer::get_distance_to_gate_boundary(unsigned int x, unsigned int y,
@@ -397,10 +457,10 @@ unsigned int Layer::get_distance_to_gate_boundary(unsigned int x, unsigned int y
                                                   unsigned int width,
                                                   unsigned int height)
 {
-    for (Layer::qt_region_iterator iter = quadtree.region_iter_begin(x, x + width, y, y + height);
-         iter != quadtree.region_iter_end(); ++iter)
+    for (Layer::qt_region_iterator iter = region_begin(PlacedLogicModelObject::KIND_GATE, x, x + width, y, y + height);
+         iter != region_end(); ++iter)
     {
-        if (Gate_shptr gate = std::dynamic_pointer_cast<Gate>(*iter))
+        if (Gate_shptr gate = object_kind_cast<Gate>(*iter))
         {
             if (query_horizontal_distance)
             {
@@ -33,12 +33,21 @@
 #include "Core/Image/Manipulation/ScalingManager.h"
 
 #include <set>
+#include <memory>
 #include <stdexcept>
 
 namespace degate
 {
+    class PickIndex;
+
     /**
      * Representation of a chip layer.
+     *
+     * Placed objects are kept in a quadtree for all objects and in one quadtree per
+     * object kind (@see PlacedLogicModelObject::OBJECT_KIND). Queries, that only need
+     * objects of one kind (e.g. all vias in a region), use the per-kind quadtree and
+     * skip all other objects. Picking objects at a position uses a separate index
+     * (@see PickIndex).
      */
     class Layer : public DeepCopyable
     {
@@ -57,6 +66,15 @@ namespace degate
             TRANSISTOR = 3
         };
 
+        /**
+         * Enums to declare the pixel format of the background image of a layer.
+         */
+        enum IMAGE_FORMAT
+        {
+            IMAGE_FORMAT_RGBA = 0,
+            IMAGE_FORMAT_GS_BYTE = 1
+        };
+
         typedef std::shared_ptr<PlacedLogicModelObject> quadtree_element_type;
 
         typedef RegionIterator<quadtree_element_type> qt_region_iterator;
@@ -66,11 +84,19 @@ namespace degate
 
         QuadTree<quadtree_element_type> quadtree;
 
+        // per-kind sub-indexes, indexed by PlacedLogicModelObject::OBJECT_KIND
+        std::unique_ptr<QuadTree<quadtree_element_type>> kind_quadtrees[PlacedLogicModelObject::KIND_COUNT];
+
+        std::unique_ptr<PickIndex> pick_index;
+
         LAYER_TYPE layer_type;
 
         layer_position_t layer_pos;
 
+        IMAGE_FORMAT image_format;
+
         std::shared_ptr<ScalingManager<BackgroundImage>> scaling_manager;
+        std::shared_ptr<ScalingManager<GreyscaleBackgroundImage>> gs_scaling_manager;
 
         // store shared pointers to objects, that belong to the layer
         typedef std::map<object_id_t, PlacedLogicModelObject_shptr> object_collection;
@@ -111,6 +137,16 @@ namespace degate
          */
         std::shared_ptr<PlacedLogicModelObject> get_object(object_id_t object_id);
 
+        /**
+         * Get the quadtree for objects of kind \p kind.
+         */
+        QuadTree<quadtree_element_type>& get_kind_quadtree(PlacedLogicModelObject::OBJECT_KIND kind);
+
+        /**
+         * Create the per-kind quadtrees and the pick index.
+         */
+        void init_kind_quadtrees();
+
     public:
 
 
@@ -212,11 +248,35 @@ namespace degate
          */
         qt_region_iterator region_begin(BoundingBox const& bbox);
 
+        /**
+         * Get an iterator to iterate over all placed objects of kind \p kind.
+         * Use objects_end() as end marker.
+         */
+        object_iterator objects_begin(PlacedLogicModelObject::OBJECT_KIND kind);
+
+        /**
+         * Get an iterator to iterate over the objects of kind \p kind in a region.
+         * Use region_end() as end marker.
+         */
+        qt_region_iterator region_begin(PlacedLogicModelObject::OBJECT_KIND kind,
+                                        int min_x, int max_x, int min_y, int max_y);
+
+        /**
+         * Get an iterator to iterate over the objects of kind \p kind in a region.
+         * Use region_end() as end marker.
+         */
+        qt_region_iterator region_begin(PlacedLogicModelObject::OBJECT_KIND kind, BoundingBox const& bbox);
+
         /**
          * Get an end marker for region iteration.
          */
         qt_region_iterator region_end();
 
+        /**
+         * Get the number of placed objects of kind \p kind.
+         */
+        unsigned int get_object_count(PlacedLogicModelObject::OBJECT_KIND kind) const;
+
 
         /**
          * Set the background image for a layer.
@@ -227,16 +287,48 @@ namespace degate
          */
         void set_image(BackgroundImage_shptr img);
 
+        /**
+         * Set a greyscale background image for a layer.
+         * The image and its prescaled versions are stored with one byte per pixel.
+         * @see set_image()
+         */
+        void set_image(GreyscaleBackgroundImage_shptr img);
+
+        /**
+         * Get the pixel format of the background image.
+         */
+        IMAGE_FORMAT get_image_format() const;
+
+        /**
+         * Get an image format as string, e.g. "gs-byte" for Layer::IMAGE_FORMAT_GS_BYTE .
+         */
+        static const std::string get_image_format_as_string(IMAGE_FORMAT image_format);
+
+        /**
+         * Parse an image format indicating string.
+         * @exception DegateRuntimeException This exception is thrown if the string
+         *   cannot be parsed.
+         */
+        static IMAGE_FORMAT get_image_format_from_string(std::string const& image_format_str);
+
 
         /**
          * Get the background image.
          * @return Returns a shared pointer to the background image.
-         * @exception DegateLogicException If you did not set the background image, then this
-         *   exception is thrown.
+         * @exception DegateLogicException If you did not set the background image or if
+         *   the background image is a greyscale image, then this exception is thrown.
          * @see set_image()
          */
         BackgroundImage_shptr get_image();
 
+        /**
+         * Get the greyscale background image.
+         * @exception DegateLogicException If you did not set a greyscale background image,
+         *   then this exception is thrown.
+         * @see get_image_format()
+         */
+        GreyscaleBackgroundImage_shptr get_greyscale_image();
+
         /**
          * Get the directory name for the image, that represents the
          * background image of the layer.
@@ -266,11 +358,26 @@ namespace degate
          * From the scaling mananger you will get the image.
          * @return Returns a shared pointer to the  scaling manager object.
          *   The pointer can be a nullptr pointer. This is the case if you did not
-         *   initialized it via set_image()
+         *   initialized it via set_image() or if the background image is a greyscale image.
          * @see set_image()
+         * @see get_greyscale_scaling_manager()
          */
         ScalingManager_shptr get_scaling_manager();
 
+        /**
+         * Get the scaling manager of a greyscale background image.
+         * @return Returns a shared pointer to the scaling manager object or a null pointer,
+         *   if the layer has no greyscale background image.
+         * @see get_scaling_manager()
+         */
+        GreyscaleScalingManager_shptr get_greyscale_scaling_manager();
+
+        /**
+         * Get the zoom steps of the background image, regardless of its pixel format.
+         * @see ScalingManager::get_zoom_steps()
+         */
+        std::list<double> get_zoom_steps() const;
+
         /**
          * Print the layer.
          */
@@ -278,7 +385,7 @@ namespace degate
 
         /**
          * Notify the layer that a shape of a logic model object changed.
-         * This will adjust the quadtree.
+         * This will adjust the quadtrees and the pick index.
          *
          * It will use the old bounding box to remove the object and the actual one (the new one) to insert it back.
          *
@@ -298,6 +405,8 @@ namespace degate
          * there is a port it will be returned, if not and if there is a gate
          * it will be returned and if there is no port and no gate and an
          * annotation then it will be returned.
+         * The lookup uses the pick index of the layer, its time does not depend
+         * on the number of objects around the position (@see PickIndex).
          * @param x The x-position.
          * @param y The y-position.
          * @param max_distance It is possible to check for objects, which are
@@ -326,6 +435,7 @@ namespace degate
 
         /**
          * Check for placed objects in a region of type given by template param.
+         * The type must declare a kind_tag (@see PlacedLogicModelObject::OBJECT_KIND).
          * @return Returns true, if there is a an object of the specified type in the region.
          *   Else it returns false.
          */
@@ -333,15 +443,7 @@ namespace degate
         bool exists_type_in_region(unsigned int min_x, unsigned int max_x,
                                    unsigned int min_y, unsigned int max_y)
         {
-            for (Layer::qt_region_iterator iter = quadtree.region_iter_begin(min_x, max_x, min_y, max_y);
-                 iter != quadtree.region_iter_end(); ++iter)
-            {
-                if (std::dynamic_pointer_cast<LogicModelObjectType>(*iter) != nullptr)
-                {
-                    return true;
-                }
-            }
-            return false;
+            return region_begin(LogicModelObjectType::kind_tag, min_x, max_x, min_y, max_y) != region_end();
         }
 
 
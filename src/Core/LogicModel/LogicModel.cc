@@ -52,7 +52,7 @@ void LogicModel::print(std::ostream& os)
         << endl
         << "--------------------------------[ Logic model ]--------------------------------" << endl;
 
-    for (object_collection::iterator iter = objects.begin(); iter != objects.end(); ++iter)
+    for (object_collection::const_iterator iter = objects.begin(); iter != objects.end(); ++iter)
     {
         os << "\t+ Object: "
             << (*iter).second->get_object_type_name() << " "
@@ -112,7 +112,8 @@ object_id_t LogicModel::get_new_object_id()
 LogicModel::LogicModel(unsigned int width, unsigned int height, unsigned int layers) :
     bounding_box(static_cast<float>(width), static_cast<float>(height)),
     main_module(new Module("main_module", "", true)),
-    object_id_counter(0)
+    object_id_counter(0),
+    journal(new LogicModelJournal())
 {
     gate_library = std::make_shared<GateLibrary>();
 
@@ -141,6 +142,7 @@ DeepCopyable_shptr LogicModel::clone_shallow() const
     clone->nets.clear();
     clone->objects.clear();
     clone->main_module.reset();
+    clone->journal = std::make_shared<LogicModelJournal>();
     return clone;
 }
 
@@ -220,7 +222,7 @@ unsigned int LogicModel::get_height() const
 
 PlacedLogicModelObject_shptr LogicModel::get_object(object_id_t object_id)
 {
-    object_collection::iterator found = objects.find(object_id);
+    object_collection::const_iterator found = objects.find(object_id);
 
     if (found == objects.end())
     {
@@ -368,6 +370,8 @@ void LogicModel::add_object(int layer_pos, PlacedLogicModelObject_shptr o)
         layer->add_object(o);
     }
     assert(objects.find(object_id) != objects.end());
+
+    journal->record_object(object_id);
 }
 
 
@@ -396,8 +400,7 @@ void LogicModel::remove_remote_object(object_id_t remote_id)
                 debug(TM, "Removed object with remote ID %llu and local ID = %llu from lmodel.", remote_id, local_id);
                 remove_object(plo, false);
 
-                object_collection::iterator found = objects.find(local_id);
-                assert(found == objects.end());
+                assert(objects.find(local_id) == objects.end());
 
                 return;
             }
@@ -420,7 +423,11 @@ void LogicModel::remove_object(PlacedLogicModelObject_shptr o, bool add_to_remov
         {
             Net_shptr net = clmo->get_net();
             clmo->remove_net();
-            if (net != nullptr && net->size() == 0) remove_net(net);
+            if (net != nullptr)
+            {
+                journal->record_net(net->get_object_id());
+                if (net->size() == 0) remove_net(net);
+            }
         }
 
         if (Gate_shptr gate = std::dynamic_pointer_cast<Gate>(o))
@@ -447,6 +454,8 @@ void LogicModel::remove_object(PlacedLogicModelObject_shptr o, bool add_to_remov
         layer->remove_object(o);
     }
     objects.erase(o->get_object_id());
+
+    journal->record_object(o->get_object_id());
 }
 
 void LogicModel::remove_object(PlacedLogicModelObject_shptr o)
@@ -461,6 +470,7 @@ void LogicModel::add_gate_template(GateTemplate_shptr tmpl)
     {
         if (!tmpl->has_valid_object_id()) tmpl->set_object_id(get_new_object_id());
         gate_library->add_template(tmpl);
+        journal->record_gate_template(tmpl->get_object_id());
         //update_gate_ports(tmpl);
 
         // XXX iterate over gates and check tmpl-id -> update
@@ -480,6 +490,7 @@ void LogicModel::remove_gate_template(GateTemplate_shptr tmpl)
     {
         remove_gates_by_template_type(tmpl);
         gate_library->remove_template(tmpl);
+        journal->record_gate_template(tmpl->get_object_id());
     }
 }
 
@@ -487,7 +498,7 @@ void LogicModel::remove_template_references(GateTemplate_shptr tmpl)
 {
     if (gate_library == nullptr)
         throw DegateLogicException("You can't remove a gate template, if there is no gate library.");
-    for (gate_collection::iterator iter = gates_begin();
+    for (gate_collection::const_iterator iter = gates.begin();
          iter != gates.end(); ++iter)
     {
         Gate_shptr gate = (*iter).second;
@@ -526,6 +537,7 @@ void LogicModel::add_template_port_to_gate_template(GateTemplate_shptr gate_temp
                                                     GateTemplatePort_shptr template_port)
 {
     gate_template->add_template_port(template_port);
+    journal->record_gate_template(gate_template->get_object_id());
     update_ports(gate_template);
 }
 
@@ -533,6 +545,7 @@ void LogicModel::remove_template_port_from_gate_template(GateTemplate_shptr gate
                                                          GateTemplatePort_shptr template_port)
 {
     gate_template->remove_template_port(template_port);
+    journal->record_gate_template(gate_template->get_object_id());
     update_ports(gate_template);
 }
 
@@ -545,6 +558,9 @@ void LogicModel::update_ports(Gate_shptr gate)
 
     debug(TM, "update ports on gate %llu", gate->get_object_id());
 
+    // Callers run this after editing a gate, so the gate state is journaled here.
+    journal->record_object(gate->get_object_id());
+
     // in a first iteration over all template ports from the corresponding template
     // we check if there are gate ports to add
     if (gate->has_template())
@@ -570,6 +586,8 @@ void LogicModel::update_ports(Gate_shptr gate)
 
                 assert(gate->get_layer() != nullptr);
                 add_object(gate->get_layer()->get_layer_pos(), new_gate_port);
+
+                main_module->register_gate_port(new_gate_port);
             }
         }
     }
@@ -630,6 +648,7 @@ void LogicModel::update_ports(Gate_shptr gate)
     {
         debug(TM, "remove real port:");
         (*iter)->print();
+        main_module->unregister_gate_port(*iter);
         gate->remove_port(*iter);
         remove_object(*iter);
     }
@@ -640,8 +659,11 @@ void LogicModel::update_ports(GateTemplate_shptr gate_template)
     if (gate_template == nullptr)
         throw InvalidPointerException("Invalid parameter for update_ports()");
 
+    // Callers run this after editing a template, so the template state is journaled here.
+    journal->record_gate_template(gate_template->get_object_id());
+
     // iterate over all gates ...
-    for (gate_collection::iterator g_iter = gates.begin();
+    for (gate_collection::const_iterator g_iter = gates.begin();
          g_iter != gates.end(); ++g_iter)
     {
         Gate_shptr gate = (*g_iter).second;
@@ -729,6 +751,9 @@ void LogicModel::set_layers(layer_collection layers)
 
     // set new layers
     this->layers = layers;
+
+    // Objects store their layer position, so a reordering can't be journaled.
+    journal->require_checkpoint();
 }
 
 void LogicModel::remove_layer(layer_position_t pos)
@@ -754,6 +779,8 @@ void LogicModel::remove_layer(Layer_shptr layer)
     // Remove layer container.
     layers.erase(remove(layers.begin(), layers.end(), layer),
                  layers.end());
+
+    journal->require_checkpoint();
 }
 
 void LogicModel::set_current_layer(layer_position_t pos)
@@ -792,18 +819,20 @@ void LogicModel::add_net(Net_shptr net)
         throw DegateRuntimeException(f.str());
     }
     nets[net->get_object_id()] = net;
+    journal->record_net(net->get_object_id());
 }
 
 
 Net_shptr LogicModel::get_net(object_id_t net_id)
 {
-    if (nets.find(net_id) == nets.end())
+    net_collection::const_iterator found = nets.find(net_id);
+    if (found == nets.end())
     {
         boost::format f("Failed to get net with OID %1%, because it is not registered in the set of nets.");
         f % net_id;
         throw CollectionLookupException(f.str());
     }
-    return nets[net_id];
+    return found->second;
 }
 
 void LogicModel::remove_net(Net_shptr net)
@@ -824,14 +853,16 @@ void LogicModel::remove_net(Net_shptr net)
             object_id_t oid = *(net->begin());
 
             // logic check: this object should be known
-            if (objects.find(oid) == objects.end()) throw CollectionLookupException();
+            object_collection::const_iterator found = objects.find(oid);
+            if (found == objects.end()) throw CollectionLookupException();
 
             // the logic model object should be connectable
             if (ConnectedLogicModelObject_shptr o =
-                std::dynamic_pointer_cast<ConnectedLogicModelObject>(objects[oid]))
+                std::dynamic_pointer_cast<ConnectedLogicModelObject>(found->second))
             {
                 // unconnect object from net and net from object
                 o->remove_net();
+                journal->record_object(oid);
             }
             else
                 throw DegateLogicException("Can't dynamic cast to a shared ptr of "
@@ -844,6 +875,8 @@ void LogicModel::remove_net(Net_shptr net)
         //nets[net->get_object_id()].reset();
         size_t n = nets.erase(net->get_object_id());
         assert(n == 1);
+
+        journal->record_net(net->get_object_id());
     }
 }
 
@@ -922,6 +955,7 @@ void LogicModel::set_main_module(Module_shptr main_module)
 {
     this->main_module = main_module;
     main_module->set_main_module(); // set the root-node-state
+    journal->record_module_change();
 }
 
 void LogicModel::reset_removed_remote_objetcs_list()
@@ -955,3 +989,8 @@ void LogicModel::set_default_gate_port_diameter(diameter_t port_diameter)
 {
     this->port_diameter = port_diameter;
 }
+
+LogicModelJournal_shptr LogicModel::get_journal()
+{
+    return journal;
+}
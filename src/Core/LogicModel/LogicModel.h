@@ -40,6 +40,7 @@
 #include "Core/LogicModel/Gate/GateLibrary.h"
 #include "Core/LogicModel/Annotation/Annotation.h"
 #include "Core/LogicModel/Module.h"
+#include "Core/LogicModel/LogicModelJournal.h"
 
 #include <memory>
 #include <set>
@@ -112,6 +113,11 @@ namespace degate
 
         diameter_t port_diameter = 5;
 
+        /**
+         * Changes since the last save.
+         */
+        LogicModelJournal_shptr journal;
+
     private:
 
         /**
@@ -565,7 +571,7 @@ namespace degate
 
         /**
          * Compare ports of all gates that reference a given template
-         * and update them.
+         * and update them. The template is journaled as changed.
          */
         void update_ports(GateTemplate_shptr gate_template);
 
@@ -596,6 +602,13 @@ namespace degate
          * Set default gate port diameter.
          */
         void set_default_gate_port_diameter(diameter_t port_diameter);
+
+        /**
+         * Get the journal, that records changes since the last save.
+         * Changes made through the logic model are recorded automatically. If you change
+         * an object in place (e.g. rename or move it), record it on your own.
+         */
+        LogicModelJournal_shptr get_journal();
     };
 }
 
@@ -20,6 +20,7 @@
  */
 
 #include "LogicModelExporter.h"
+#include "Core/Utils/Trace.h"
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -31,6 +32,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <list>
+#include <set>
 #include <memory>
 
 using namespace std;
@@ -38,6 +40,8 @@ using namespace degate;
 
 void LogicModelExporter::export_data(std::string const& filename, LogicModel_shptr lmodel)
 {
+    TRACE_SCOPE_CATEGORY("logic-model/export", "io");
+
     if (lmodel == nullptr) throw InvalidPointerException("Logic model pointer is nullptr.");
 
     try
@@ -50,6 +54,10 @@ void LogicModelExporter::export_data(std::string const& filename, LogicModel_shp
         QDomElement root_elem = doc.createElement("logic-model");
         assert(!root_elem.isNull());
 
+        root_elem.setAttribute("journal-generation",
+                               QString::fromStdString(number_to_string<unsigned long long>(
+                                   lmodel->get_journal()->get_generation())));
+
         QDomElement gates_elem = doc.createElement("gates");
         if (gates_elem.isNull()) throw(std::runtime_error("Failed to create node."));
 
@@ -75,29 +83,30 @@ void LogicModelExporter::export_data(std::string const& filename, LogicModel_shp
                 continue;
 
             Layer_shptr layer = *layer_iter;
+            layer_position_t layer_pos = layer->get_layer_pos();
 
-            for (Layer::object_iterator iter = layer->objects_begin();
-                 iter != layer->objects_end(); ++iter)
-            {
-                layer_position_t layer_pos = layer->get_layer_pos();
+            // Iterate over the per-kind indexes, so objects need not be classified.
+            // Gate ports are written with their gates.
 
-                PlacedLogicModelObject_shptr o = (*iter);
-
-                if (Gate_shptr gate = std::dynamic_pointer_cast<Gate>(o))
-                    add_gate(doc, gates_elem, gate, layer_pos);
+            for (Layer::object_iterator iter = layer->objects_begin(PlacedLogicModelObject::KIND_GATE);
+                 iter != layer->objects_end(); ++iter)
+                add_gate(doc, gates_elem, std::static_pointer_cast<Gate>(*iter), layer_pos);
 
-                else if (Via_shptr via = std::dynamic_pointer_cast<Via>(o))
-                    add_via(doc, vias_elem, via, layer_pos);
+            for (Layer::object_iterator iter = layer->objects_begin(PlacedLogicModelObject::KIND_VIA);
+                 iter != layer->objects_end(); ++iter)
+                add_via(doc, vias_elem, std::static_pointer_cast<Via>(*iter), layer_pos);
 
-                else if (EMarker_shptr emarker = std::dynamic_pointer_cast<EMarker>(o))
-                    add_emarker(doc, emarkers_elem, emarker, layer_pos);
+            for (Layer::object_iterator iter = layer->objects_begin(PlacedLogicModelObject::KIND_EMARKER);
+                 iter != layer->objects_end(); ++iter)
+                add_emarker(doc, emarkers_elem, std::static_pointer_cast<EMarker>(*iter), layer_pos);
 
-                else if (Wire_shptr wire = std::dynamic_pointer_cast<Wire>(o))
-                    add_wire(doc, wires_elem, wire, layer_pos);
+            for (Layer::object_iterator iter = layer->objects_begin(PlacedLogicModelObject::KIND_WIRE);
+                 iter != layer->objects_end(); ++iter)
+                add_wire(doc, wires_elem, std::static_pointer_cast<Wire>(*iter), layer_pos);
 
-                else if (Annotation_shptr annotation = std::dynamic_pointer_cast<Annotation>(o))
-                    add_annotation(doc, annotations_elem, annotation, layer_pos);
-            }
+            for (Layer::object_iterator iter = layer->objects_begin(PlacedLogicModelObject::KIND_ANNOTATION);
+                 iter != layer->objects_end(); ++iter)
+                add_annotation(doc, annotations_elem, std::static_pointer_cast<Annotation>(*iter), layer_pos);
         }
 
         add_nets(doc, nets_elem, lmodel);
@@ -147,33 +156,278 @@ void LogicModelExporter::add_nets(QDomDocument& doc, QDomElement& nets_elem, Log
     for (LogicModel::net_collection::iterator net_iter = lmodel->nets_begin();
          net_iter != lmodel->nets_end(); ++net_iter)
     {
-        QDomElement net_elem = doc.createElement("net");
+        add_net(doc, nets_elem, lmodel, net_iter->second);
+    }
+}
+
+void LogicModelExporter::add_net(QDomDocument& doc, QDomElement& nets_elem, LogicModel_shptr lmodel, Net_shptr net)
+{
+    QDomElement net_elem = doc.createElement("net");
+
+    assert(net != nullptr);
+
+    object_id_t old_net_id = net->get_object_id();
+    assert(old_net_id != 0);
+    object_id_t new_net_id = oid_rewriter->get_new_object_id(old_net_id);
+
+    net_elem.setAttribute("id", QString::fromStdString(number_to_string<object_id_t>(new_net_id)));
+
+    for (Net::connection_iterator conn_iter = net->begin();
+         conn_iter != net->end(); ++conn_iter)
+    {
+        object_id_t oid = *conn_iter;
+
+        QDomElement conn_elem = doc.createElement("connection");
+        conn_elem.setAttribute("object-id",
+                               QString::fromStdString(
+                                   number_to_string<object_id_t>(oid_rewriter->get_new_object_id(oid))));
+        net_elem.appendChild(conn_elem);
+    }
 
-        Net_shptr net = net_iter->second;
-        assert(net != nullptr);
+    nets_elem.appendChild(net_elem);
+}
 
-        object_id_t old_net_id = net->get_object_id();
-        assert(old_net_id != 0);
-        object_id_t new_net_id = oid_rewriter->get_new_object_id(old_net_id);
+void LogicModelExporter::add_object(QDomDocument& doc, QDomElement& root_elem, PlacedLogicModelObject_shptr o)
+{
+    // Objects are grouped the same way as in lmodel.xml, so that the importer can parse them.
+    QString container;
+    switch (o->get_object_kind())
+    {
+    case PlacedLogicModelObject::KIND_GATE:
+        container = "gates";
+        break;
+    case PlacedLogicModelObject::KIND_VIA:
+        container = "vias";
+        break;
+    case PlacedLogicModelObject::KIND_EMARKER:
+        container = "emarkers";
+        break;
+    case PlacedLogicModelObject::KIND_WIRE:
+        container = "wires";
+        break;
+    case PlacedLogicModelObject::KIND_ANNOTATION:
+        container = "annotations";
+        break;
+    default:
+        return;
+    }
 
-        net_elem.setAttribute("id", QString::fromStdString(number_to_string<object_id_t>(new_net_id)));
+    QDomElement container_elem = root_elem.firstChildElement(container);
+    if (container_elem.isNull())
+    {
+        container_elem = doc.createElement(container);
+        if (container_elem.isNull()) throw(std::runtime_error("Failed to create node."));
+        root_elem.appendChild(container_elem);
+    }
 
-        for (Net::connection_iterator conn_iter = net->begin();
-             conn_iter != net->end(); ++conn_iter)
+    layer_position_t layer_pos = o->get_layer()->get_layer_pos();
+
+    switch (o->get_object_kind())
+    {
+    case PlacedLogicModelObject::KIND_GATE:
+        add_gate(doc, container_elem, std::static_pointer_cast<Gate>(o), layer_pos);
+        break;
+    case PlacedLogicModelObject::KIND_VIA:
+        add_via(doc, container_elem, std::static_pointer_cast<Via>(o), layer_pos);
+        break;
+    case PlacedLogicModelObject::KIND_EMARKER:
+        add_emarker(doc, container_elem, std::static_pointer_cast<EMarker>(o), layer_pos);
+        break;
+    case PlacedLogicModelObject::KIND_WIRE:
+        add_wire(doc, container_elem, std::static_pointer_cast<Wire>(o), layer_pos);
+        break;
+    case PlacedLogicModelObject::KIND_ANNOTATION:
+        add_annotation(doc, container_elem, std::static_pointer_cast<Annotation>(o), layer_pos);
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * Find the module, that directly contains a gate.
+ * @return Returns the module or a null pointer.
+ */
+static Module_shptr find_owning_module(Module_shptr module, Gate_shptr gate)
+{
+    for (Module::gate_collection::const_iterator g_iter = module->gates_begin();
+         g_iter != module->gates_end(); ++g_iter)
+    {
+        if (*g_iter == gate) return module;
+    }
+
+    for (Module::module_collection::const_iterator m_iter = module->modules_begin();
+         m_iter != module->modules_end(); ++m_iter)
+    {
+        Module_shptr found = find_owning_module(*m_iter, gate);
+        if (found != nullptr) return found;
+    }
+
+    return nullptr;
+}
+
+void LogicModelExporter::export_journal_entry(std::string const& filename, LogicModel_shptr lmodel)
+{
+    TRACE_SCOPE_CATEGORY("logic-model/export-journal-entry", "io");
+
+    if (lmodel == nullptr) throw InvalidPointerException("Logic model pointer is nullptr.");
+
+    LogicModelJournal_shptr journal = lmodel->get_journal();
+
+    try
+    {
+        QDomDocument doc;
+
+        QDomElement root_elem = doc.createElement("journal-entry");
+        assert(!root_elem.isNull());
+
+        root_elem.setAttribute("generation",
+                               QString::fromStdString(number_to_string<unsigned long long>(
+                                   journal->get_generation())));
+
+        QDomElement removed_objects_elem = doc.createElement("removed-objects");
+        QDomElement removed_nets_elem = doc.createElement("removed-nets");
+        QDomElement nets_elem = doc.createElement("nets");
+        QDomElement cells_elem = doc.createElement("cells");
+        QDomElement templates_elem = doc.createElement("gate-templates");
+        if (removed_objects_elem.isNull() ||
+            removed_nets_elem.isNull() ||
+            nets_elem.isNull() ||
+            cells_elem.isNull() ||
+            templates_elem.isNull())
+            throw(std::runtime_error("Failed to create node."));
+
+        std::set<object_id_t> written_objects;
+        std::set<object_id_t> dirty_nets(journal->get_nets().begin(), journal->get_nets().end());
+        bool write_modules = journal->has_module_changes();
+
+        for (object_id_t oid : journal->get_objects())
+        {
+            PlacedLogicModelObject_shptr o;
+            try
+            {
+                o = lmodel->get_object(oid);
+            }
+            catch (CollectionLookupException const&)
+            {
+                QDomElement removed_elem = doc.createElement("object");
+                removed_elem.setAttribute("id", QString::fromStdString(
+                                              number_to_string<object_id_t>(oid_rewriter->get_new_object_id(oid))));
+                removed_objects_elem.appendChild(removed_elem);
+                continue;
+            }
+
+            // Gate ports are stored within their gate.
+            if (GatePort_shptr port = object_kind_cast<GatePort>(o))
+                o = port->get_gate();
+
+            if (o == nullptr || written_objects.find(o->get_object_id()) != written_objects.end())
+                continue;
+
+            written_objects.insert(o->get_object_id());
+            add_object(doc, root_elem, o);
+
+            // Replacing an object disconnects it, therefore its net is written as well.
+            if (ConnectedLogicModelObject_shptr clmo = object_kind_cast<ConnectedLogicModelObject>(o))
+            {
+                if (clmo->get_net() != nullptr) dirty_nets.insert(clmo->get_net()->get_object_id());
+            }
+
+            if (Gate_shptr gate = object_kind_cast<Gate>(o))
+            {
+                for (Gate::port_iterator iter = gate->ports_begin(); iter != gate->ports_end(); ++iter)
+                {
+                    if ((*iter)->get_net() != nullptr) dirty_nets.insert((*iter)->get_net()->get_object_id());
+                }
+
+                // Remember the module membership, if the module hierarchy is not written anyway.
+                // A module without an object ID can only be restored with the whole hierarchy.
+                Module_shptr owner = find_owning_module(lmodel->get_main_module(), gate);
+                if (owner != nullptr && !owner->has_valid_object_id())
+                    write_modules = true;
+                else if (!write_modules && owner != nullptr)
+                {
+                    QDomElement cell_elem = doc.createElement("cell");
+                    cell_elem.setAttribute("object-id", QString::fromStdString(
+                                               number_to_string<object_id_t>(
+                                                   oid_rewriter->get_new_object_id(gate->get_object_id()))));
+                    cell_elem.setAttribute("module-id", QString::fromStdString(
+                                               number_to_string<object_id_t>(
+                                                   oid_rewriter->get_new_object_id(owner->get_object_id()))));
+                    cells_elem.appendChild(cell_elem);
+                }
+            }
+        }
+
+        for (object_id_t net_id : dirty_nets)
+        {
+            Net_shptr net;
+            try
+            {
+                net = lmodel->get_net(net_id);
+            }
+            catch (CollectionLookupException const&)
+            {
+            }
+
+            if (net != nullptr && net->size() > 0)
+                add_net(doc, nets_elem, lmodel, net);
+            else
+            {
+                QDomElement removed_elem = doc.createElement("net");
+                removed_elem.setAttribute("id", QString::fromStdString(
+                                              number_to_string<object_id_t>(oid_rewriter->get_new_object_id(net_id))));
+                removed_nets_elem.appendChild(removed_elem);
+            }
+        }
+
+        // Gate templates live in gate_library.xml, which is rewritten if there are template changes.
+        for (object_id_t tmpl_id : journal->get_gate_templates())
         {
-            object_id_t oid = *conn_iter;
+            QDomElement tmpl_elem = doc.createElement("gate-template");
+            tmpl_elem.setAttribute("id", QString::fromStdString(
+                                       number_to_string<object_id_t>(oid_rewriter->get_new_object_id(tmpl_id))));
+            templates_elem.appendChild(tmpl_elem);
+        }
+
+        root_elem.appendChild(removed_objects_elem);
+        root_elem.appendChild(removed_nets_elem);
+        root_elem.appendChild(nets_elem);
+        root_elem.appendChild(cells_elem);
+        root_elem.appendChild(templates_elem);
 
-            const ConnectedLogicModelObject_shptr conn_obj =
-                std::dynamic_pointer_cast<ConnectedLogicModelObject>(lmodel->get_object(oid));
+        if (write_modules)
+        {
+            QDomElement modules_elem = doc.createElement("modules");
+            if (modules_elem.isNull()) throw(std::runtime_error("Failed to create node."));
 
-            QDomElement conn_elem = doc.createElement("connection");
-            conn_elem.setAttribute("object-id",
-                                   QString::fromStdString(
-                                       number_to_string<object_id_t>(oid_rewriter->get_new_object_id(oid))));
-            net_elem.appendChild(conn_elem);
+            add_module(doc, modules_elem, lmodel, lmodel->get_main_module());
+            root_elem.appendChild(modules_elem);
         }
 
-        nets_elem.appendChild(net_elem);
+        doc.appendChild(root_elem);
+
+        QFile file(QString::fromStdString(filename));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Append))
+        {
+            throw InvalidPathException("Can't open journal file.");
+        }
+
+        // One entry per line. A partially written line is ignored on replay and forces a full
+        // checkpoint on the next save.
+        QTextStream stream(&file);
+        stream.setCodec("UTF-8");
+        stream << doc.toString(-1) << "\n";
+        stream.flush();
+
+        file.close();
+
+        journal->entry_written();
+    }
+    catch (const std::exception& ex)
+    {
+        std::cout << "Exception caught: " << ex.what() << std::endl;
+        throw;
     }
 }
 
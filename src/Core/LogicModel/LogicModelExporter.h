@@ -55,6 +55,10 @@ namespace degate
 
         void add_module(QDomDocument& doc, QDomElement& modules_elem, LogicModel_shptr lmodel, Module_shptr module);
 
+        void add_object(QDomDocument& doc, QDomElement& root_elem, PlacedLogicModelObject_shptr o);
+
+        void add_net(QDomDocument& doc, QDomElement& nets_elem, LogicModel_shptr lmodel, Net_shptr net);
+
         ObjectIDRewriter_shptr oid_rewriter;
 
     public:
@@ -67,6 +71,22 @@ namespace degate
         }
 
         void export_data(std::string const& filename, LogicModel_shptr lmodel);
+
+        /**
+         * Append the changes recorded in the logic model journal to a journal file.
+         *
+         * An entry is a single line that contains a complete XML document. Objects and nets
+         * are written with their full state, in the same format as in lmodel.xml. The
+         * journal is cleared afterwards.
+         *
+         * The object ID rewriter must be in pass-through mode, because the entries
+         * refer to the object IDs from the last checkpoint.
+         *
+         * @exception InvalidPathException
+         * @exception InvalidPointerException
+         * @see LogicModelJournal
+         */
+        void export_journal_entry(std::string const& filename, LogicModel_shptr lmodel);
     };
 }
 
@@ -29,6 +29,9 @@
 #include <boost/foreach.hpp>
 #include <boost/range/counting_range.hpp>
 
+#include <atomic>
+#include <mutex>
+
 #include <QMutex>
 #include <QtConcurrent/QtConcurrent>
 
@@ -198,6 +201,8 @@ void degate::grab_template_images(LogicModel_shptr lmodel,
         // set as master image
         gate_template->set_image(layer->get_layer_type(), tmpl_img);
     }
+
+    lmodel->get_journal()->record_gate_template(gate_template->get_object_id());
 }
 
 
@@ -230,14 +235,17 @@ void degate::load_background_image(Layer_shptr layer,
 }
 
 
+/**
+ * Convert a tile of a loaded image part into a tile of the background image.
+ */
 void load_tile(const QRgb* rba_data,
                unsigned int tile_size,
                unsigned int tile_index,
-               const std::string& path,
                QSize local_size,
                unsigned int global_tile_x,
                unsigned int global_tile_y,
-               unsigned int tile_count_x)
+               unsigned int tile_count_x,
+               const BackgroundImage_shptr& image)
 {
     unsigned int local_tile_x = tile_index % tile_count_x;
     unsigned int local_tile_y = tile_index / tile_count_x;
@@ -246,11 +254,10 @@ void load_tile(const QRgb* rba_data,
     unsigned int tile_x = global_tile_x + local_tile_x;
     unsigned int tile_y = global_tile_y + local_tile_y;
 
-    // Create a file name from tile number.
-    char filename[PATH_MAX];
-    snprintf(filename, sizeof(filename), "%d_%d.dat", tile_x, tile_y);
+    // The tile is written into the image storage directly (e.g. its tile container).
+    BackgroundImage::MemoryMap_shptr tile = image->fetch_tile(tile_x * tile_size, tile_y * tile_size);
 
-    auto data = new BackgroundImage::pixel_type[tile_size * tile_size];
+    auto data = tile->data();
     memset(data,
            0,
            static_cast<std::size_t>(tile_size) *
@@ -278,119 +285,6 @@ void load_tile(const QRgb* rba_data,
             data[(y - min_y) * tile_size + (x - min_x)] = MERGE_CHANNELS(qRed(rgb), qGreen(rgb), qBlue(rgb), qAlpha(rgb));
         }
     }
-
-    assert(!file_exists(path + "/" + filename));
-
-    auto file = std::fstream(path + "/" + filename, std::ios::out | std::ios::binary);
-
-    file.write(reinterpret_cast<const char*>(&data[0]),
-               static_cast<std::size_t>(tile_size) *
-               static_cast<std::size_t>(tile_size) *
-               sizeof(BackgroundImage::pixel_type));
-
-    file.close();
-
-    delete[] data;
-}
-
-
-void create_scaled_background_image(const std::string& dir, const BackgroundImage_shptr& bg_image, QSize scaled_size, unsigned int tile_image_size, QImageReader& reader)
-{
-    QSize read_size{0, 0};
-
-    // Start image conversion and loading
-    while (true)
-    {
-        QSize reading_size{static_cast<int>(tile_image_size), static_cast<int>(tile_image_size)};
-
-        // Check width
-        if (reading_size.width() + read_size.width() > scaled_size.width())
-            reading_size.setWidth(scaled_size.width() - read_size.width());
-
-        // Check height
-        if (reading_size.height() + read_size.height() > scaled_size.height())
-            reading_size.setHeight(scaled_size.height() - read_size.height());
-
-        reader.device()->seek(0);
-
-        QImageReader current_reader(reader.device(), reader.format());
-
-        QRect rect(read_size.width(), read_size.height(), reading_size.width(), reading_size.height());
-
-        current_reader.setScaledSize(scaled_size);
-        current_reader.setScaledClipRect(rect);
-
-        QImage img = current_reader.read();
-        if (img.isNull())
-        {
-            debug(TM, "can't create %s (can't read image)\n", bg_image->get_directory().c_str());
-        }
-
-        // Convert to good format
-        if (img.format() != QImage::Format_ARGB32 && img.format() != QImage::Format_RGB32)
-        {
-            img = img.convertToFormat(QImage::Format_ARGB32);
-        }
-
-        //////////////////// Process start ///////////////////////////
-
-        unsigned int global_tile_x = static_cast<unsigned int>(read_size.width()) >> bg_image->get_tile_width_exp();
-        unsigned int global_tile_y = static_cast<unsigned int>(read_size.height()) >> bg_image->get_tile_width_exp();
-
-        auto tile_count_x = static_cast<unsigned int>(std::ceil(static_cast<double>(reading_size.width()) / static_cast<double>(bg_image->get_tile_size())));
-        auto tile_count_y = static_cast<unsigned int>(std::ceil(static_cast<double>(reading_size.height()) / static_cast<double>(bg_image->get_tile_size())));
-
-        const auto *rgb_data = reinterpret_cast<const QRgb*>(&img.constBits()[0]);
-
-        // Multi-threaded function
-        std::function<void(const unsigned int& y)> function = [&rgb_data, &bg_image, &dir, &reading_size, &global_tile_x, &global_tile_y, &tile_count_x](const unsigned int& i)
-        {
-            load_tile(rgb_data, bg_image->get_tile_size(), i, dir, reading_size, global_tile_x, global_tile_y, tile_count_x);
-        };
-
-        // Start multithreading
-        const auto& it = boost::counting_range<unsigned int>(0, tile_count_x * tile_count_y);
-        QtConcurrent::blockingMap(it, function);
-
-        /////////////////////////////////////////////////////////////
-
-        read_size.setWidth(read_size.width() + reading_size.width());
-
-        if (read_size.width() >= scaled_size.width())
-        {
-            read_size.setWidth(0);
-            read_size.setHeight(read_size.height() + reading_size.height());
-        }
-
-        debug(TM, "New scaled image loading step.");
-
-        if (read_size.height() >= scaled_size.height())
-            break;
-    }
-}
-
-
-void create_scaled_background_images(const BackgroundImage_shptr& bg_image, unsigned int tile_image_size, QImageReader& reader, QSize default_size)
-{
-    auto w = static_cast<unsigned int>(default_size.width());
-    auto h = static_cast<unsigned int>(default_size.height());
-    unsigned int min_size = bg_image->get_tile_size();
-
-    for (int i = 2; ((h > min_size) || (w > min_size)) && (i < static_cast<int>(1u << 24u)); i *= 2) // max 24 scaling levels
-    {
-        w >>= 1u;
-        h >>= 1u;
-
-        // create a new image
-        char dir_name[PATH_MAX];
-        snprintf(dir_name, sizeof(dir_name), "scaling_%d.dimg", i);
-        std::string dir_path = join_pathes(bg_image->get_directory(), std::string(dir_name));
-        create_directory(dir_path);
-
-        reader.device()->seek(0);
-
-        create_scaled_background_image(dir_path, bg_image, QSize(static_cast<int>(w), static_cast<int>(h)), tile_image_size, reader);
-    }
 }
 
 
@@ -416,6 +310,42 @@ void degate::load_new_background_image(Layer_shptr layer, std::string const& pro
     if (layer->has_background_image())
         layer->unset_image();
 
+    // TIFF images are read natively, chunk by chunk. The prescaled images are built from the
+    // master image afterwards (@see ScalingManager::create_scalings()).
+    TIFFReader_shptr tiff_reader;
+
+    if (TIFFReader::is_tiff(image_file))
+    {
+        try
+        {
+            tiff_reader = std::make_shared<TIFFReader>(image_file);
+        }
+        catch (DegateRuntimeException const& e)
+        {
+            debug(TM, "Can't read %s natively (%s), using QImageReader.", image_file.c_str(), e.what());
+        }
+    }
+
+    // Single-channel scans are stored as greyscale images, with one byte per pixel.
+    if (tiff_reader != nullptr && tiff_reader->is_greyscale())
+    {
+        debug(TM, "Create greyscale background image in %s", dir.c_str());
+        GreyscaleBackgroundImage_shptr gs_image =
+            std::make_shared<GreyscaleBackgroundImage>(static_cast<unsigned int>(layer->get_width()),
+                                                       static_cast<unsigned int>(layer->get_height()),
+                                                       dir);
+
+        gs_image->set_access_pattern(TileContainer::ACCESS_SEQUENTIAL);
+        read_tiff<GreyscaleBackgroundImage>(*tiff_reader, gs_image, static_cast<std::size_t>(loading_cache_size) * 1024 * 1024);
+        gs_image->set_access_pattern(TileContainer::ACCESS_NORMAL);
+
+        debug(TM, "Set image to layer.");
+        layer->set_image(gs_image);
+        debug(TM, "Done.");
+
+        return;
+    }
+
     // Create background image
     debug(TM, "Create background image in %s", dir.c_str());
     BackgroundImage_shptr bg_image = std::make_shared<BackgroundImage>(static_cast<unsigned int>(layer->get_width()),
@@ -432,6 +362,19 @@ void degate::load_new_background_image(Layer_shptr layer, std::string const& pro
 
     //////////////// Convert new image to Degate internal format.
 
+    if (tiff_reader != nullptr)
+    {
+        bg_image->set_access_pattern(TileContainer::ACCESS_SEQUENTIAL);
+        read_tiff<BackgroundImage>(*tiff_reader, bg_image, static_cast<std::size_t>(loading_cache_size) * 1024 * 1024);
+        bg_image->set_access_pattern(TileContainer::ACCESS_NORMAL);
+
+        debug(TM, "Set image to layer.");
+        layer->set_image(bg_image);
+        debug(TM, "Done.");
+
+        return;
+    }
+
     // Create reader
     QImageReader reader(image_file.c_str());
 
@@ -507,9 +450,9 @@ void degate::load_new_background_image(Layer_shptr layer, std::string const& pro
         const auto *rgb_data = reinterpret_cast<const QRgb*>(&img.constBits()[0]);
 
         // Multi-threaded function
-        std::function<void(const unsigned int& y)> function = [&rgb_data, &bg_image, &dir, &reading_size, &global_tile_x, &global_tile_y, &tile_count_x](const unsigned int& i)
+        std::function<void(const unsigned int& y)> function = [&rgb_data, &bg_image, &reading_size, &global_tile_x, &global_tile_y, &tile_count_x](const unsigned int& i)
         {
-            load_tile(rgb_data, bg_image->get_tile_size(), i, dir, reading_size, global_tile_x, global_tile_y, tile_count_x);
+            load_tile(rgb_data, bg_image->get_tile_size(), i, reading_size, global_tile_x, global_tile_y, tile_count_x, bg_image);
         };
 
         // Start multithreading
@@ -534,12 +477,7 @@ void degate::load_new_background_image(Layer_shptr layer, std::string const& pro
 
     ///////////////
 
-    debug(TM, "Create scaled images.");
-    create_scaled_background_images(bg_image, tile_image_size, reader, size);
-    debug(TM, "Finished creating scaled images.");
-
-    ///////////////
-
+    // The prescaled images are built from the master image (@see ScalingManager::create_scalings()).
     debug(TM, "Set image to layer.");
     layer->set_image(bg_image);
     debug(TM, "Done.");
@@ -752,10 +690,13 @@ void degate::apply_port_color_settings(LogicModel_shptr lmodel, PortColorManager
                 GateTemplatePort_shptr tmpl_port = port->get_template_port();
 
                 std::string port_name = tmpl_port->get_name();
-                if (pcm->has_color_definition(port_name))
+                if (pcm->has_color_definition(port_name) &&
+                    (tmpl_port->get_frame_color() != pcm->get_frame_color(port_name) ||
+                     tmpl_port->get_fill_color() != pcm->get_fill_color(port_name)))
                 {
                     tmpl_port->set_frame_color(pcm->get_frame_color(port_name));
                     tmpl_port->set_fill_color(pcm->get_fill_color(port_name));
+                    lmodel->get_journal()->record_gate_template(gate->get_template_type_id());
                 }
             }
         }
@@ -763,49 +704,161 @@ void degate::apply_port_color_settings(LogicModel_shptr lmodel, PortColorManager
 }
 
 
+/**
+ * Grab the image of a gate and flip it into template orientation.
+ * Unlike grab_image(), this can be used from several threads at once, because the
+ * background image is read with fetch_tile() instead of the shared working tile.
+ */
+template <typename BGImageType>
+static GateTemplateImage_shptr grab_gate_image(std::shared_ptr<BGImageType> bg_image, Gate_shptr gate)
+{
+    BoundingBox const& bb = gate->get_bounding_box();
+
+    GateTemplateImage_shptr img = std::make_shared<GateTemplateImage>(bb.get_width(), bb.get_height());
+
+    const unsigned int min_x = bb.get_min_x(), min_y = bb.get_min_y();
+    const unsigned int w = std::min(img->get_width(), bg_image->get_width() > min_x ? bg_image->get_width() - min_x : 0);
+    const unsigned int h = std::min(img->get_height(), bg_image->get_height() > min_y ? bg_image->get_height() - min_y : 0);
+    const unsigned int offset_bitmask = bg_image->get_tile_size() - 1;
+
+    for (unsigned int y = 0; y < h; y++)
+    {
+        typename BGImageType::MemoryMap_shptr tile;
+
+        for (unsigned int x = 0; x < w; x++)
+        {
+            if (tile == nullptr || ((min_x + x) & offset_bitmask) == 0)
+                tile = bg_image->fetch_tile(min_x + x, min_y + y);
+
+            img->template set_pixel_as<typename BGImageType::pixel_type>
+                (x, y, tile->get((min_x + x) & offset_bitmask, (min_y + y) & offset_bitmask));
+        }
+    }
+
+    switch (gate->get_orientation())
+    {
+    case Gate::ORIENTATION_FLIPPED_UP_DOWN:
+        flip_up_down<GateTemplateImage>(img);
+        break;
+    case Gate::ORIENTATION_FLIPPED_LEFT_RIGHT:
+        flip_left_right<GateTemplateImage>(img);
+        break;
+    case Gate::ORIENTATION_FLIPPED_BOTH:
+        flip_up_down<GateTemplateImage>(img);
+        flip_left_right<GateTemplateImage>(img);
+        break;
+    default:
+        // do nothing
+        break;
+    }
+
+    return img;
+}
+
 void degate::merge_gate_images(LogicModel_shptr lmodel,
                                Layer_shptr layer,
                                GateTemplate_shptr tmpl,
-                               std::list<Gate_shptr> const& gates)
+                               std::list<Gate_shptr> const& gates,
+                               GateTemplateImageAccumulator::MERGE_MODE mode,
+                               unsigned int align_radius)
 {
     if (gates.empty()) return;
 
-    std::list<GateTemplateImage_shptr> images;
+    // Greyscale backgrounds are read directly, only the gate images are converted.
+    std::function<GateTemplateImage_shptr(Gate_shptr)> grab;
+    if (layer->get_image_format() == Layer::IMAGE_FORMAT_GS_BYTE)
+    {
+        GreyscaleBackgroundImage_shptr bg_image = layer->get_greyscale_image();
+        if (bg_image == nullptr) throw DegateLogicException("The layer has no background image");
 
-    BOOST_FOREACH(const Gate_shptr g, gates)
+        grab = [bg_image](Gate_shptr gate) { return grab_gate_image<GreyscaleBackgroundImage>(bg_image, gate); };
+    }
+    else
     {
-        GateTemplateImage_shptr tmpl_img =
-            grab_image<GateTemplateImage>(lmodel, layer, g->get_bounding_box());
-        assert(tmpl_img != nullptr);
+        BackgroundImage_shptr bg_image = layer->get_image();
+        if (bg_image == nullptr) throw DegateLogicException("The layer has no background image");
 
-        // flip
-        switch (g->get_orientation())
+        grab = [bg_image](Gate_shptr gate) { return grab_gate_image<BackgroundImage>(bg_image, gate); };
+    }
+
+    const std::vector<Gate_shptr> instances(gates.begin(), gates.end());
+    BoundingBox const& bb = instances.front()->get_bounding_box();
+
+    // Without alignment a single pass is enough. Otherwise the first pass calculates the
+    // mean, that is used as reference to align the instances in the second pass.
+    GateTemplateImageAccumulator mean(bb.get_width(), bb.get_height(),
+                                      align_radius == 0 ? mode : GateTemplateImageAccumulator::MERGE_MEAN);
+
+    // Exceptions must not leave the workers, they are rethrown after the map.
+    std::atomic<bool> failed(false);
+    std::string error;
+    std::mutex error_mutex;
+
+    auto fail = [&](std::exception const& e)
+    {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!failed) error = e.what();
+        failed = true;
+    };
+
+    std::function<void(const unsigned int& i)> function = [&](const unsigned int& i)
+    {
+        if (failed) return;
+
+        try
         {
-        case Gate::ORIENTATION_FLIPPED_UP_DOWN:
-            flip_up_down<GateTemplateImage>(tmpl_img);
-            break;
-        case Gate::ORIENTATION_FLIPPED_LEFT_RIGHT:
-            flip_left_right<GateTemplateImage>(tmpl_img);
-            break;
-        case Gate::ORIENTATION_FLIPPED_BOTH:
-            flip_up_down<GateTemplateImage>(tmpl_img);
-            flip_left_right<GateTemplateImage>(tmpl_img);
-            break;
-        default:
-            // do nothing
-            break;
+            mean.add(grab(instances[i]));
         }
+        catch (std::exception const& e)
+        {
+            fail(e);
+        }
+    };
 
-        images.push_back(tmpl_img);
-    }
+    const auto& it = boost::counting_range<unsigned int>(0, static_cast<unsigned int>(instances.size()));
+    QtConcurrent::blockingMap(it, function);
 
-    GateTemplateImage_shptr merged_img = merge_images<GateTemplateImage>(images);
+    if (failed) throw DegateRuntimeException(error);
+
+    GateTemplateImage_shptr merged_img = mean.get_image();
+
+    if (align_radius > 0)
+    {
+        GateTemplateImageAccumulator aligned(bb.get_width(), bb.get_height(), mode);
+
+        function = [&](const unsigned int& i)
+        {
+            if (failed) return;
+
+            try
+            {
+                GateTemplateImage_shptr img = grab(instances[i]);
+
+                double dx, dy;
+                estimate_image_shift<GateTemplateImage>(merged_img, img, align_radius, dx, dy);
+                aligned.add(img, dx, dy);
+            }
+            catch (std::exception const& e)
+            {
+                fail(e);
+            }
+        };
+
+        QtConcurrent::blockingMap(it, function);
+
+        if (failed) throw DegateRuntimeException(error);
+
+        merged_img = aligned.get_image();
+    }
 
     tmpl->set_image(layer->get_layer_type(), merged_img);
+    lmodel->get_journal()->record_gate_template(tmpl->get_object_id());
 }
 
 void degate::merge_gate_images(LogicModel_shptr lmodel,
-                               ObjectSet gates)
+                               ObjectSet gates,
+                               GateTemplateImageAccumulator::MERGE_MODE mode,
+                               unsigned int align_radius)
 {
     /*
      * Classify gates by their standard cell object ID.
@@ -815,7 +868,7 @@ void degate::merge_gate_images(LogicModel_shptr lmodel,
 
     BOOST_FOREACH(PlacedLogicModelObject_shptr plo, gates)
     {
-        if (Gate_shptr gate = std::dynamic_pointer_cast<Gate>(plo))
+        if (Gate_shptr gate = object_kind_cast<Gate>(plo))
         {
             GateTemplate_shptr tmpl = gate->get_gate_template();
             if (tmpl) // ignore gates, that have no standard cell
@@ -837,7 +890,7 @@ void degate::merge_gate_images(LogicModel_shptr lmodel,
             Gate_shptr g = iter->second.front();
             assert(g != nullptr);
 
-            merge_gate_images(lmodel, layer, g->get_gate_template(), iter->second);
+            merge_gate_images(lmodel, layer, g->get_gate_template(), iter->second, mode, align_radius);
         }
     }
 }
@@ -849,8 +902,7 @@ void degate::remove_entire_net(LogicModel_shptr lmodel, Net_shptr net)
     {
         PlacedLogicModelObject_shptr plo = lmodel->get_object(oid);
         assert(plo != nullptr);
-        if (ConnectedLogicModelObject_shptr clmo =
-            std::dynamic_pointer_cast<ConnectedLogicModelObject>(plo))
+        if (ConnectedLogicModelObject_shptr clmo = object_kind_cast<ConnectedLogicModelObject>(plo))
             clmo->remove_net();
     }
 
@@ -880,7 +932,7 @@ void degate::autoconnect_objects(LogicModel_shptr lmodel, Layer_shptr layer,
     {
         ConnectedLogicModelObject_shptr clmo1;
 
-        if ((clmo1 = std::dynamic_pointer_cast<ConnectedLogicModelObject>(*iter)) != nullptr)
+        if ((clmo1 = object_kind_cast<ConnectedLogicModelObject>(*iter)) != nullptr)
         {
             BoundingBox const& bb = clmo1->get_bounding_box();
 
@@ -891,14 +943,12 @@ void degate::autoconnect_objects(LogicModel_shptr lmodel, Layer_shptr layer,
                  siter != layer->region_end(); ++siter)
             {
                 ConnectedLogicModelObject_shptr clmo2;
-                if ((clmo2 =
-                    std::dynamic_pointer_cast<ConnectedLogicModelObject>(*siter)) != nullptr)
+                if ((clmo2 = object_kind_cast<ConnectedLogicModelObject>(*siter)) != nullptr)
                 {
                     if ((clmo1->get_net() == nullptr ||
                             clmo2->get_net() == nullptr ||
                             clmo1->get_net() != clmo2->get_net()) && // excludes identical objects, too
-                        check_object_tangency(std::dynamic_pointer_cast<PlacedLogicModelObject>(clmo1),
-                                              std::dynamic_pointer_cast<PlacedLogicModelObject>(clmo2)))
+                        check_object_tangency(*iter, *siter))
 
                         connect_objects(lmodel, clmo1, clmo2);
                 }
@@ -916,10 +966,10 @@ void autoconnect_interlayer_objects_via_via(LogicModel_shptr lmodel,
 {
     Via_shptr v2;
 
-    for (Layer::qt_region_iterator siter = adjacent_layer->region_begin(search_bbox);
+    for (Layer::qt_region_iterator siter = adjacent_layer->region_begin(PlacedLogicModelObject::KIND_VIA, search_bbox);
          siter != adjacent_layer->region_end(); ++siter)
     {
-        if ((v2 = std::dynamic_pointer_cast<Via>(*siter)) != nullptr)
+        if ((v2 = object_kind_cast<Via>(*siter)) != nullptr)
         {
             if ((v1->get_net() == nullptr || v2->get_net() == nullptr ||
                     v1->get_net() != v2->get_net()) &&
@@ -942,10 +992,10 @@ void autoconnect_interlayer_objects_via_gport(LogicModel_shptr lmodel,
 {
     GatePort_shptr v2;
 
-    for (Layer::qt_region_iterator siter = adjacent_layer->region_begin(search_bbox);
+    for (Layer::qt_region_iterator siter = adjacent_layer->region_begin(PlacedLogicModelObject::KIND_GATE_PORT, search_bbox);
          siter != adjacent_layer->region_end(); ++siter)
     {
-        if ((v2 = std::dynamic_pointer_cast<GatePort>(*siter)) != nullptr)
+        if ((v2 = object_kind_cast<GatePort>(*siter)) != nullptr)
         {
             if ((v1->get_net() == nullptr || v2->get_net() == nullptr ||
                     v1->get_net() != v2->get_net()) &&
@@ -972,11 +1022,11 @@ void degate::autoconnect_interlayer_objects(LogicModel_shptr lmodel,
 
     Via_shptr v1;
 
-    // iterate over objects
-    for (Layer::qt_region_iterator iter = layer->region_begin(search_bbox);
+    // iterate over vias
+    for (Layer::qt_region_iterator iter = layer->region_begin(PlacedLogicModelObject::KIND_VIA, search_bbox);
          iter != layer->region_end(); ++iter)
     {
-        if ((v1 = std::dynamic_pointer_cast<Via>(*iter)) != nullptr)
+        if ((v1 = object_kind_cast<Via>(*iter)) != nullptr)
         {
             BoundingBox const& bb = v1->get_bounding_box();
 
@@ -91,10 +91,20 @@ namespace degate
         std::shared_ptr<ImageType> new_img(new ImageType(bounding_box.get_width(),
                                                          bounding_box.get_height()));
 
-        BackgroundImage_shptr bg_image = layer->get_image();
-        if (bg_image == nullptr) throw DegateLogicException("The layer has no background image");
+        if (layer->get_image_format() == Layer::IMAGE_FORMAT_GS_BYTE)
+        {
+            GreyscaleBackgroundImage_shptr bg_image = layer->get_greyscale_image();
+            if (bg_image == nullptr) throw DegateLogicException("The layer has no background image");
+
+            extract_partial_image<ImageType, GreyscaleBackgroundImage>(new_img, bg_image, bounding_box);
+        }
+        else
+        {
+            BackgroundImage_shptr bg_image = layer->get_image();
+            if (bg_image == nullptr) throw DegateLogicException("The layer has no background image");
 
-        extract_partial_image<ImageType, BackgroundImage>(new_img, bg_image, bounding_box);
+            extract_partial_image<ImageType, BackgroundImage>(new_img, bg_image, bounding_box);
+        }
 
         //save_image<ImageType>("/tmp/zzz.tif", new_img);
 
@@ -102,19 +112,31 @@ namespace degate
     }
 
     /**
-     * Merge images.
+     * Merge the images of gate instances and set the result as master image of a gate template.
+     * Instances are grabbed, flipped into template orientation and folded into running sums
+     * in parallel, so the memory usage does not depend on the number of instances.
+     * @param mode How the pixels of the instances are merged.
+     * @param align_radius If not zero, each instance is aligned with sub-pixel accuracy
+     *   against the mean of all instances, searching shifts up to this radius. This
+     *   needs a second pass over the instances.
+     * @see GateTemplateImageAccumulator
      */
     void merge_gate_images(LogicModel_shptr lmodel,
                            Layer_shptr layer,
-                           GateTemplate_shptr tmpl, std::list<Gate_shptr> const& gates);
+                           GateTemplate_shptr tmpl, std::list<Gate_shptr> const& gates,
+                           GateTemplateImageAccumulator::MERGE_MODE mode = GateTemplateImageAccumulator::MERGE_MEAN,
+                           unsigned int align_radius = 0);
 
     /**
      * Merge images.
      * @param lmodel
      * @param gates A set of objects. It can contain non-gate types too.
+     * @see merge_gate_images()
      */
     void merge_gate_images(LogicModel_shptr lmodel,
-                           ObjectSet gates);
+                           ObjectSet gates,
+                           GateTemplateImageAccumulator::MERGE_MODE mode = GateTemplateImageAccumulator::MERGE_MEAN,
+                           unsigned int align_radius = 0);
 
     /**
      * Extract a partial image from the background images for several layers
@@ -206,7 +228,10 @@ namespace degate
 
         // check nets: remove them from the logic model if they are not in use
         for (std::set<Net_shptr>::iterator iter = nets.begin(); iter != nets.end(); ++iter)
+        {
             if ((*iter)->size() == 0) lmodel->remove_net(*iter);
+            else lmodel->get_journal()->record_net((*iter)->get_object_id());
+        }
     }
 
 
@@ -227,6 +252,12 @@ namespace degate
     /**
      * Connect objects.
      *
+     * Nets are merged like sets in a disjoint-set forest with union by size: the largest
+     * net involved survives and only the members of the smaller nets are moved into it.
+     * Connecting an object to a huge net (e.g. clock or power) therefore costs time
+     * proportional to the smaller side only. A new net is only created, if none of the
+     * objects is connected yet.
+     *
      * Unused nets are removed from the logic model.
      *
      * @exception DegateRuntimeException This exception is thrown if one of the objects
@@ -255,19 +286,31 @@ namespace degate
         }
 
 
-        // collect objects we want to join
-        std::set<ConnectedLogicModelObject_shptr> objects;
+        // find the representative: the largest net survives the union
+        Net_shptr target;
+        for (std::set<Net_shptr>::iterator iter = nets.begin(); iter != nets.end(); ++iter)
+        {
+            if (target == nullptr || (*iter)->size() > target->size()) target = *iter;
+        }
 
-        for (InputIterator it = first; it != last; ++it)
+        bool new_net = false;
+        if (target == nullptr)
         {
-            objects.insert(std::dynamic_pointer_cast<ConnectedLogicModelObject>(*it));
+            target = Net_shptr(new Net());
+            new_net = true;
         }
 
+
+        // move the members of the smaller nets
         for (std::set<Net_shptr>::iterator iter = nets.begin(); iter != nets.end(); ++iter)
         {
             Net_shptr net = *iter;
+            if (net == target) continue;
+
+            // set_net() removes the object from the net, so copy the members first
+            std::vector<object_id_t> members(net->begin(), net->end());
 
-            for (Net::connection_iterator ci = net->begin(); ci != net->end(); ++ci)
+            for (std::vector<object_id_t>::iterator ci = members.begin(); ci != members.end(); ++ci)
             {
                 PlacedLogicModelObject_shptr plo = lmodel->get_object(*ci);
 
@@ -275,30 +318,25 @@ namespace degate
                     std::dynamic_pointer_cast<ConnectedLogicModelObject>(plo);
 
                 assert(clo != nullptr);
-                objects.insert(clo);
+                clo->set_net(target);
             }
-        }
-
-
-        Net_shptr new_net(new Net());
 
-        // set new net
-        for (std::set<ConnectedLogicModelObject_shptr>::iterator iter = objects.begin();
-             iter != objects.end(); ++iter)
-        {
-            ConnectedLogicModelObject_shptr clo = *iter;
-            clo->set_net(new_net);
+            assert(net->size() == 0);
+            lmodel->remove_net(net);
         }
 
 
-        // remove nets from the logic model
-        for (std::set<Net_shptr>::iterator iter = nets.begin(); iter != nets.end(); ++iter)
+        // join the objects themselves
+        for (InputIterator it = first; it != last; ++it)
         {
-            assert((*iter)->size() == 0);
-            lmodel->remove_net(*iter);
+            ConnectedLogicModelObject_shptr clo =
+                std::dynamic_pointer_cast<ConnectedLogicModelObject>(*it);
+
+            if (clo->get_net() != target) clo->set_net(target);
         }
 
-        lmodel->add_net(new_net);
+        if (new_net) lmodel->add_net(target);
+        else lmodel->get_journal()->record_net(target->get_object_id());
     }
 
 
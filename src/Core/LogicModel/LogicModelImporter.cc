@@ -21,6 +21,7 @@
 
 #include "Core/LogicModel/LogicModelImporter.h"
 #include "Core/LogicModel/Annotation/SubProjectAnnotation.h"
+#include "Core/Utils/Trace.h"
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -31,6 +32,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <list>
+#include <fstream>
 
 #include <boost/format.hpp>
 #include <boost/foreach.hpp>
@@ -42,6 +44,8 @@ using namespace degate;
 void LogicModelImporter::import_into(LogicModel_shptr lmodel,
                                      std::string const& filename)
 {
+    TRACE_SCOPE_CATEGORY("logic-model/import", "io");
+
     if (RET_IS_NOT_OK(check_file(filename)))
     {
         debug(TM, "Problem: file %s not found.", filename.c_str());
@@ -100,6 +104,9 @@ LogicModel_shptr LogicModelImporter::import(std::string const& filename)
 void LogicModelImporter::parse_logic_model_element(QDomElement const lm_elem,
                                                    LogicModel_shptr lmodel)
 {
+    lmodel->get_journal()->set_generation(
+        parse_number<unsigned long long>(lm_elem, "journal-generation", 0ULL));
+
     const QDomElement gates_elem = get_dom_twig(lm_elem, "gates");
     if (!gates_elem.isNull()) parse_gates_element(gates_elem, lmodel);
 
@@ -556,3 +563,212 @@ std::list<Module_shptr> LogicModelImporter::parse_modules_element(QDomElement co
 
     return modules;
 }
+
+unsigned int LogicModelImporter::replay_journal(LogicModel_shptr lmodel, std::string const& filename, bool& complete)
+{
+    TRACE_SCOPE_CATEGORY("logic-model/replay-journal", "io");
+
+    if (lmodel == nullptr) throw InvalidPointerException("Got a nullptr pointer in LogicModelImporter::replay_journal()");
+
+    complete = true;
+
+    if (RET_IS_NOT_OK(check_file(filename)))
+        return 0;
+
+    std::ifstream file(filename.c_str());
+    if (!file)
+    {
+        debug(TM, "Problem: can't open the journal file %s.", filename.c_str());
+        throw InvalidFileFormatException("The LogicModelImporter cannot load the journal file. Can't open the file.");
+    }
+
+    lmodel->set_gate_library(gate_library);
+
+    unsigned int replayed = 0;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.empty())
+            continue;
+
+        // Every entry is terminated by a newline. Without it, the write of the entry was interrupted.
+        if (file.eof())
+            complete = false;
+
+        QDomDocument parser;
+        if (!parser.setContent(QString::fromStdString(line)))
+        {
+            debug(TM, "Stop journal replay, there is an incomplete entry in %s.", filename.c_str());
+            complete = false;
+            break;
+        }
+
+        const QDomElement entry_elem = parser.documentElement();
+        assert(!entry_elem.isNull());
+
+        if (parse_number<unsigned long long>(entry_elem, "generation", 0ULL) != lmodel->get_journal()->get_generation())
+        {
+            debug(TM, "Skip journal entry from another checkpoint.");
+            continue;
+        }
+
+        parse_journal_entry_element(entry_elem, lmodel);
+        replayed++;
+    }
+
+    debug(TM, "Replayed %d journal entries.", replayed);
+
+    return replayed;
+}
+
+void LogicModelImporter::remove_journaled_objects(QDomElement const container_element,
+                                                  std::string const& tag_name,
+                                                  LogicModel_shptr lmodel)
+{
+    const QDomNodeList object_list = container_element.elementsByTagName(QString::fromStdString(tag_name));
+    for (int i = 0; i < object_list.count(); i++)
+    {
+        QDomElement object_elem = object_list.at(i).toElement();
+        if (!object_elem.isNull())
+        {
+            object_id_t object_id = parse_number<object_id_t>(object_elem, "id");
+
+            try
+            {
+                // Gate ports are removed together with their gate.
+                PlacedLogicModelObject_shptr o = lmodel->get_object(object_id);
+                if (std::dynamic_pointer_cast<GatePort>(o) == nullptr)
+                    lmodel->remove_object(o);
+            }
+            catch (CollectionLookupException const&)
+            {
+                // the object was never saved in the checkpoint
+            }
+        }
+    }
+}
+
+/**
+ * Lookup a module in the module hierarchy by its object ID.
+ * @return Returns the module or a null pointer.
+ */
+static Module_shptr find_module_by_id(Module_shptr module, object_id_t module_id)
+{
+    if (module->get_object_id() == module_id) return module;
+
+    for (Module::module_collection::const_iterator m_iter = module->modules_begin();
+         m_iter != module->modules_end(); ++m_iter)
+    {
+        Module_shptr found = find_module_by_id(*m_iter, module_id);
+        if (found != nullptr) return found;
+    }
+
+    return nullptr;
+}
+
+void LogicModelImporter::parse_journal_entry_element(QDomElement const entry_elem,
+                                                     LogicModel_shptr lmodel)
+{
+    // removed objects
+    const QDomElement removed_objects_elem = get_dom_twig(entry_elem, "removed-objects");
+    if (!removed_objects_elem.isNull())
+        remove_journaled_objects(removed_objects_elem, "object", lmodel);
+
+    // changed objects are replaced
+    static const char* const containers[][2] = {
+        {"gates", "gate"}, {"vias", "via"}, {"emarkers", "emarker"}, {"wires", "wire"}, {"annotations", "annotation"}
+    };
+
+    for (auto const& c : containers)
+    {
+        const QDomElement elem = get_dom_twig(entry_elem, c[0]);
+        if (!elem.isNull()) remove_journaled_objects(elem, c[1], lmodel);
+    }
+
+    gates.clear();
+
+    const QDomElement gates_elem = get_dom_twig(entry_elem, "gates");
+    if (!gates_elem.isNull()) parse_gates_element(gates_elem, lmodel);
+
+    const QDomElement vias_elem = get_dom_twig(entry_elem, "vias");
+    if (!vias_elem.isNull()) parse_vias_element(vias_elem, lmodel);
+
+    const QDomElement emarkers_elem = get_dom_twig(entry_elem, "emarkers");
+    if (!emarkers_elem.isNull()) parse_emarkers_element(emarkers_elem, lmodel);
+
+    const QDomElement wires_elem = get_dom_twig(entry_elem, "wires");
+    if (!wires_elem.isNull()) parse_wires_element(wires_elem, lmodel);
+
+    const QDomElement annotations_elem = get_dom_twig(entry_elem, "annotations");
+    if (!annotations_elem.isNull()) parse_annotations_element(annotations_elem, lmodel);
+
+    // removed and changed nets
+    const QDomElement removed_nets_elem = get_dom_twig(entry_elem, "removed-nets");
+    const QDomElement nets_elem = get_dom_twig(entry_elem, "nets");
+
+    for (QDomElement const& elem : {removed_nets_elem, nets_elem})
+    {
+        if (elem.isNull())
+            continue;
+
+        const QDomNodeList net_list = elem.elementsByTagName("net");
+        for (int i = 0; i < net_list.count(); i++)
+        {
+            QDomElement net_elem = net_list.at(i).toElement();
+            if (net_elem.isNull())
+                continue;
+
+            object_id_t net_id = parse_number<object_id_t>(net_elem, "id");
+
+            try
+            {
+                lmodel->remove_net(lmodel->get_net(net_id));
+            }
+            catch (CollectionLookupException const&)
+            {
+                // the net was never saved in the checkpoint or was already removed with its objects
+            }
+        }
+    }
+
+    if (!nets_elem.isNull()) parse_nets_element(nets_elem, lmodel);
+
+    // module membership of replaced gates
+    const QDomElement modules_elem = get_dom_twig(entry_elem, "modules");
+    if (!modules_elem.isNull())
+    {
+        std::list<Module_shptr> mods = parse_modules_element(modules_elem, lmodel);
+
+        assert(mods.size() == 1);
+
+        lmodel->set_main_module(mods.front());
+    }
+    else
+    {
+        const QDomElement cells_elem = get_dom_twig(entry_elem, "cells");
+        if (!cells_elem.isNull())
+        {
+            Module_shptr main_module = lmodel->get_main_module();
+
+            const QDomNodeList cell_list = cells_elem.elementsByTagName("cell");
+            for (int i = 0; i < cell_list.count(); i++)
+            {
+                QDomElement cell_elem = cell_list.at(i).toElement();
+                if (cell_elem.isNull())
+                    continue;
+
+                object_id_t cell_id = parse_number<object_id_t>(cell_elem, "object-id");
+                object_id_t module_id = parse_number<object_id_t>(cell_elem, "module-id");
+
+                Gate_shptr gate = std::dynamic_pointer_cast<Gate>(lmodel->get_object(cell_id));
+                Module_shptr module = find_module_by_id(main_module, module_id);
+
+                if (gate != nullptr && module != nullptr && module != main_module)
+                {
+                    main_module->remove_gate(gate);
+                    module->add_gate(gate, /* autodetect module ports = */ false);
+                }
+            }
+        }
+    }
+}
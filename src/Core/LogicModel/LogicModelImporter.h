@@ -65,6 +65,17 @@ namespace degate
         std::list<Module_shptr> parse_modules_element(QDomElement const modules_element,
                                                       LogicModel_shptr lmodel);
 
+        void parse_journal_entry_element(QDomElement const entry_element,
+                                         LogicModel_shptr lmodel);
+
+        /**
+         * Remove all objects from the logic model, that are listed in a container element
+         * of a journal entry. This is done before the objects are parsed again.
+         */
+        void remove_journaled_objects(QDomElement const container_element,
+                                      std::string const& tag_name,
+                                      LogicModel_shptr lmodel);
+
     public:
 
         /**
@@ -111,6 +122,18 @@ namespace degate
          * Import a logic model that is stored in a XML file into an existing logic model.
          */
         void import_into(LogicModel_shptr lmodel, std::string const& filename);
+
+        /**
+         * Replay a journal file on top of a logic model, that was loaded from the matching checkpoint.
+         * Entries from another checkpoint generation are skipped. Replay stops at the first entry,
+         * that can't be parsed (e.g. a partially written entry after a crash).
+         * @param complete Is set to false, if the journal ends with an incomplete or unterminated
+         *              entry. New entries must not be appended to such a journal, because they
+         *              would continue the broken line.
+         * @return Returns the number of replayed entries.
+         * @see LogicModelExporter::export_journal_entry()
+         */
+        unsigned int replay_journal(LogicModel_shptr lmodel, std::string const& filename, bool& complete);
     };
 }
 
@@ -0,0 +1,206 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/LogicModel/LogicModelJournal.h"
+
+using namespace degate;
+
+LogicModelJournal::LogicModelJournal() :
+    modules_changed(false),
+    checkpoint_required(true),
+    generation(0),
+    entry_count(0),
+    compaction_threshold(100)
+{
+}
+
+LogicModelJournal::~LogicModelJournal()
+{
+}
+
+std::vector<LogicModelJournal::journal_shptr> LogicModelJournal::get_attached()
+{
+    std::vector<journal_shptr> journals;
+
+    for (auto iter = attached.begin(); iter != attached.end();)
+    {
+        if (journal_shptr journal = iter->lock())
+        {
+            journals.push_back(journal);
+            ++iter;
+        }
+        else iter = attached.erase(iter);
+    }
+
+    return journals;
+}
+
+void LogicModelJournal::attach(journal_shptr journal)
+{
+    if (journal == nullptr || journal.get() == this) return;
+
+    detach(journal);
+    attached.push_back(journal);
+}
+
+void LogicModelJournal::detach(journal_shptr journal)
+{
+    for (auto iter = attached.begin(); iter != attached.end();)
+    {
+        journal_shptr j = iter->lock();
+        if (j == nullptr || j == journal) iter = attached.erase(iter);
+        else ++iter;
+    }
+}
+
+void LogicModelJournal::record_object(object_id_t oid)
+{
+    if (oid != 0) objects.insert(oid);
+    if (attached.empty()) return;
+
+    for (auto& journal : get_attached()) journal->record_object(oid);
+}
+
+void LogicModelJournal::record_net(object_id_t oid)
+{
+    if (oid != 0) nets.insert(oid);
+    if (attached.empty()) return;
+
+    for (auto& journal : get_attached()) journal->record_net(oid);
+}
+
+void LogicModelJournal::record_gate_template(object_id_t oid)
+{
+    if (oid != 0) gate_templates.insert(oid);
+    if (attached.empty()) return;
+
+    for (auto& journal : get_attached()) journal->record_gate_template(oid);
+}
+
+void LogicModelJournal::record_module_change()
+{
+    modules_changed = true;
+    if (attached.empty()) return;
+
+    for (auto& journal : get_attached()) journal->record_module_change();
+}
+
+void LogicModelJournal::require_checkpoint()
+{
+    checkpoint_required = true;
+    if (attached.empty()) return;
+
+    for (auto& journal : get_attached()) journal->require_checkpoint();
+}
+
+bool LogicModelJournal::is_checkpoint_required() const
+{
+    return checkpoint_required;
+}
+
+bool LogicModelJournal::has_changes() const
+{
+    return !objects.empty() || !nets.empty() || !gate_templates.empty() || modules_changed;
+}
+
+bool LogicModelJournal::needs_checkpoint(std::string const& lmodel_file) const
+{
+    return checkpoint_required ||
+           checkpoint_file != lmodel_file ||
+           entry_count >= compaction_threshold;
+}
+
+void LogicModelJournal::begin_checkpoint()
+{
+    generation++;
+}
+
+void LogicModelJournal::set_checkpoint(std::string const& lmodel_file)
+{
+    clear();
+    checkpoint_file = lmodel_file;
+    checkpoint_required = false;
+    entry_count = 0;
+}
+
+void LogicModelJournal::entry_written()
+{
+    clear();
+    entry_count++;
+}
+
+void LogicModelJournal::clear()
+{
+    objects.clear();
+    nets.clear();
+    gate_templates.clear();
+    modules_changed = false;
+}
+
+LogicModelJournal::id_collection const& LogicModelJournal::get_objects() const
+{
+    return objects;
+}
+
+LogicModelJournal::id_collection const& LogicModelJournal::get_nets() const
+{
+    return nets;
+}
+
+LogicModelJournal::id_collection const& LogicModelJournal::get_gate_templates() const
+{
+    return gate_templates;
+}
+
+bool LogicModelJournal::has_module_changes() const
+{
+    return modules_changed;
+}
+
+void LogicModelJournal::set_generation(unsigned long long generation)
+{
+    this->generation = generation;
+}
+
+unsigned long long LogicModelJournal::get_generation() const
+{
+    return generation;
+}
+
+void LogicModelJournal::set_entry_count(unsigned int entry_count)
+{
+    this->entry_count = entry_count;
+}
+
+unsigned int LogicModelJournal::get_entry_count() const
+{
+    return entry_count;
+}
+
+void LogicModelJournal::set_compaction_threshold(unsigned int compaction_threshold)
+{
+    this->compaction_threshold = compaction_threshold;
+}
+
+unsigned int LogicModelJournal::get_compaction_threshold() const
+{
+    return compaction_threshold;
+}
@@ -0,0 +1,191 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __LOGICMODELJOURNAL_H__
+#define __LOGICMODELJOURNAL_H__
+
+#include "Globals.h"
+
+#include <set>
+#include <list>
+#include <vector>
+#include <string>
+#include <memory>
+
+namespace degate
+{
+    /**
+     * Bookkeeping for journaled (incremental) saves of a logic model.
+     *
+     * The journal remembers which objects, nets and gate templates were touched since the
+     * last save. It does not keep any object state: when a journal entry is written, each
+     * touched ID is resolved against the logic model. If the object still exists its full
+     * state is written, otherwise a removal is written. Touching an ID several times
+     * therefore costs nothing.
+     *
+     * Journal entries are appended to a file next to the last full checkpoint (lmodel.xml).
+     * Both carry a generation number, so entries from an older checkpoint are never replayed.
+     *
+     * Other consumers, that need to know what changed (e.g. incremental rule checks), can
+     * attach their own journal. All recorded changes are forwarded to it.
+     *
+     * @see LogicModelExporter::export_journal_entry()
+     * @see LogicModelImporter::replay_journal()
+     * @see ProjectExporter::export_incremental()
+     */
+    class LogicModelJournal
+    {
+    public:
+
+        typedef std::set<object_id_t> id_collection;
+        typedef std::shared_ptr<LogicModelJournal> journal_shptr;
+
+    private:
+
+        id_collection objects;
+        id_collection nets;
+        id_collection gate_templates;
+        bool modules_changed;
+        bool checkpoint_required;
+
+        unsigned long long generation;
+        unsigned int entry_count;
+        unsigned int compaction_threshold;
+
+        std::string checkpoint_file;
+
+        std::list<std::weak_ptr<LogicModelJournal>> attached;
+
+        /**
+         * Get the attached journals, that are still alive.
+         */
+        std::vector<journal_shptr> get_attached();
+
+    public:
+
+        /**
+         * Create an empty journal. A new journal requires a full checkpoint.
+         */
+        LogicModelJournal();
+
+        /**
+         * The destructor.
+         */
+        virtual ~LogicModelJournal();
+
+        /**
+         * Remember that an object was added, changed or removed.
+         */
+        void record_object(object_id_t oid);
+
+        /**
+         * Remember that a net was created, changed or removed.
+         */
+        void record_net(object_id_t oid);
+
+        /**
+         * Remember that a gate template was created, changed or removed.
+         */
+        void record_gate_template(object_id_t oid);
+
+        /**
+         * Remember that the module hierarchy was changed.
+         */
+        void record_module_change();
+
+        /**
+         * Request a full checkpoint on next save. Use this for changes, that cannot be
+         * expressed as journal entries (e.g. reordering layers).
+         */
+        void require_checkpoint();
+
+        /**
+         * Forward all changes recorded from now on to \p journal as well.
+         * The journal is only weakly referenced. It is detached, when it is destroyed.
+         */
+        void attach(journal_shptr journal);
+
+        /**
+         * Stop forwarding changes to \p journal.
+         */
+        void detach(journal_shptr journal);
+
+        /**
+         * Check if a full checkpoint was requested.
+         * @see require_checkpoint()
+         */
+        bool is_checkpoint_required() const;
+
+        /**
+         * Check if there are changes, that are not journaled yet.
+         */
+        bool has_changes() const;
+
+        /**
+         * Check if the next save must write a full checkpoint into \p lmodel_file.
+         * This is the case if there is no checkpoint in this file, if a checkpoint was
+         * requested or if the number of journal entries reached the compaction threshold.
+         */
+        bool needs_checkpoint(std::string const& lmodel_file) const;
+
+        /**
+         * Start a new checkpoint generation. Call this before writing a full checkpoint.
+         */
+        void begin_checkpoint();
+
+        /**
+         * Mark a full checkpoint as written. This forgets all recorded changes.
+         */
+        void set_checkpoint(std::string const& lmodel_file);
+
+        /**
+         * Mark a journal entry as written. This forgets all recorded changes.
+         */
+        void entry_written();
+
+        /**
+         * Forget all recorded changes.
+         */
+        void clear();
+
+        id_collection const& get_objects() const;
+        id_collection const& get_nets() const;
+        id_collection const& get_gate_templates() const;
+        bool has_module_changes() const;
+
+        void set_generation(unsigned long long generation);
+        unsigned long long get_generation() const;
+
+        void set_entry_count(unsigned int entry_count);
+        unsigned int get_entry_count() const;
+
+        /**
+         * Set the number of journal entries after that the journal is compacted into
+         * a full checkpoint.
+         */
+        void set_compaction_threshold(unsigned int compaction_threshold);
+        unsigned int get_compaction_threshold() const;
+    };
+
+    typedef std::shared_ptr<LogicModelJournal> LogicModelJournal_shptr;
+}
+
+#endif
@@ -25,6 +25,7 @@
 #include <boost/algorithm/string.hpp>
 
 #include <iterator>
+#include <unordered_set>
 
 using namespace degate;
 
@@ -33,13 +34,19 @@ Module::Module(std::string const& module_name,
                std::string const& entity_name,
                bool is_root) :
     entity_name(entity_name),
-    is_root(is_root)
+    is_root(is_root),
+    parent(nullptr)
 {
     set_name(module_name);
 }
 
 Module::~Module()
 {
+    for (auto& module : modules)
+    {
+        if (module->parent == this)
+            module->parent = nullptr;
+    }
 }
 
 DeepCopyable_shptr Module::clone_shallow() const
@@ -72,6 +79,8 @@ void Module::clone_deep_into(DeepCopyable_shptr dest, oldnew_t* oldnew) const
         clone->ports[v.first] = std::dynamic_pointer_cast<GatePort>(v.second->clone_deep(oldnew));
     });
 
+    clone->rebuild_gate_port_index();
+
     LogicModelObjectBase::clone_deep_into(dest, oldnew);
 }
 
@@ -103,6 +112,10 @@ void Module::add_gate(Gate_shptr gate, bool detect_ports)
         throw InvalidPointerException("Invalid pointer passed to add_gate().");
 
     gates.insert(gate);
+
+    for (auto p_iter = gate->ports_begin(); p_iter != gate->ports_end(); ++p_iter)
+        index_gate_port(*p_iter);
+
     if (!is_root && detect_ports) determine_module_ports();
 }
 
@@ -116,6 +129,10 @@ bool Module::remove_gate(Gate_shptr gate)
     if (g_iter != gates.end())
     {
         gates.erase(g_iter);
+
+        for (auto p_iter = gate->ports_begin(); p_iter != gate->ports_end(); ++p_iter)
+            unindex_gate_port((*p_iter)->get_object_id());
+
         if (!is_root) determine_module_ports();
         return true;
     }
@@ -139,6 +156,10 @@ void Module::add_module(Module_shptr module)
         throw InvalidPointerException("Invalid pointer passed to add_modue().");
 
     modules.push_back(module);
+    module->parent = this;
+
+    for (auto& e : module->gate_ports)
+        index_gate_port(e.second.first, e.second.second);
 }
 
 
@@ -156,6 +177,12 @@ bool Module::remove_module(Module_shptr module)
         {
             child->move_gates_recursive(this);
             modules.erase(iter);
+
+            // The moved gates are indexed again by add_gate().
+            for (auto& e : child->gate_ports)
+                unindex_gate_port(e.first, e.second.second);
+
+            child->parent = nullptr;
             return true;
         }
         else if ((*iter)->remove_module(module) == true)
@@ -165,6 +192,102 @@ bool Module::remove_module(Module_shptr module)
     return false;
 }
 
+void Module::index_gate_port(GatePort_shptr gate_port, unsigned int count)
+{
+    assert(gate_port != nullptr);
+
+    if (!gate_port->has_valid_object_id())
+        return;
+
+    for (Module* module = this; module != nullptr; module = module->parent)
+    {
+        auto& entry = module->gate_ports[gate_port->get_object_id()];
+        entry.first = gate_port;
+        entry.second += count;
+    }
+}
+
+void Module::unindex_gate_port(object_id_t oid, unsigned int count)
+{
+    if (oid == 0)
+        return;
+
+    for (Module* module = this; module != nullptr; module = module->parent)
+    {
+        auto iter = module->gate_ports.find(oid);
+        if (iter == module->gate_ports.end())
+            continue;
+
+        if (iter->second.second <= count)
+            module->gate_ports.erase(iter);
+        else
+            iter->second.second -= count;
+    }
+}
+
+void Module::rebuild_gate_port_index()
+{
+    // Sub-modules are cloned (and indexed) before their parent.
+    gate_ports.clear();
+
+    for (auto& gate : gates)
+    {
+        for (auto p_iter = gate->ports_begin(); p_iter != gate->ports_end(); ++p_iter)
+        {
+            if (!(*p_iter)->has_valid_object_id())
+                continue;
+
+            auto& entry = gate_ports[(*p_iter)->get_object_id()];
+            entry.first = *p_iter;
+            entry.second++;
+        }
+    }
+
+    for (auto& module : modules)
+    {
+        module->parent = this;
+
+        for (auto& e : module->gate_ports)
+        {
+            auto& entry = gate_ports[e.first];
+            entry.first = e.second.first;
+            entry.second += e.second.second;
+        }
+    }
+}
+
+Module* Module::lookup_gate_owner(Gate_shptr gate)
+{
+    if (gates.find(gate) != gates.end())
+        return this;
+
+    for (auto& module : modules)
+    {
+        if (Module* owner = module->lookup_gate_owner(gate))
+            return owner;
+    }
+
+    return nullptr;
+}
+
+void Module::register_gate_port(GatePort_shptr gate_port)
+{
+    if (gate_port == nullptr)
+        throw InvalidPointerException("Invalid pointer passed to register_gate_port().");
+
+    if (Module* owner = lookup_gate_owner(gate_port->get_gate()))
+        owner->index_gate_port(gate_port);
+}
+
+void Module::unregister_gate_port(GatePort_shptr gate_port)
+{
+    if (gate_port == nullptr)
+        throw InvalidPointerException("Invalid pointer passed to unregister_gate_port().");
+
+    if (Module* owner = lookup_gate_owner(gate_port->get_gate()))
+        owner->unindex_gate_port(gate_port->get_object_id());
+}
+
 void Module::remove_port(std::string module_port_name)
 {
     ports.erase(module_port_name);
@@ -178,7 +301,7 @@ void Module::move_gates_recursive(Module* dst_mod)
     for (gate_collection::iterator g_iter = gates_begin();
          g_iter != gates_end(); ++g_iter)
     {
-        std::cout << "Add gate " << (*g_iter)->get_name() << " to module " << dst_mod->get_name() << std::endl;
+        debug(TM, "Add gate %s to module %s", (*g_iter)->get_name().c_str(), dst_mod->get_name().c_str());
 
         dst_mod->add_gate(*g_iter);
     }
@@ -264,59 +387,58 @@ void Module::automove_gates()
 }
 
 
-bool Module::net_completely_internal(Net_shptr net) const
+void Module::determine_module_ports()
 {
-    for (Net::connection_iterator c_iter = net->begin(); c_iter != net->end(); ++c_iter)
+    if (is_main_module())
     {
-        object_id_t oid = *c_iter;
-        GatePort_shptr gport = lookup_gate_port_recursive(oid);
-        if (gport == nullptr)
-        {
-            // external entity
-            return false;
-        }
+        throw std::logic_error("determine_module_ports() is not suited for main modules. See determine_module_ports_for_root().");
     }
-    return true;
-}
 
-bool Module::net_feeded_internally(Net_shptr net) const
-{
-    for (Net::connection_iterator c_iter = net->begin(); c_iter != net->end(); ++c_iter)
+    /*
+     * State of a net, computed once per net with the gate port index:
+     * - external: the net has a connection to an object outside this module.
+     * - feeded_internally: the net is driven by an out-port of this module (or a sub-module).
+     */
+    struct NetState
     {
-        object_id_t oid = *c_iter;
-        GatePort_shptr gport = lookup_gate_port_recursive(oid);
-
-        if (gport != nullptr)
-        {
-            // internal entity
-            GateTemplatePort_shptr tmpl_port = gport->get_template_port();
-            if (tmpl_port->is_outport()) return true;
-        }
-    }
-    return false;
-}
+        bool external = false;
+        bool feeded_internally = false;
+    };
 
+    std::unordered_map<Net*, NetState> net_states;
 
-std::string gate_port_already_named(degate::Module::port_collection const& ports, degate::GatePort_shptr gate_port)
-{
-    for (Module::port_collection::const_iterator iter = ports.begin(); iter != ports.end(); ++iter)
+    auto get_net_state = [&](Net_shptr const& net) -> NetState const&
     {
-        if (iter->second == gate_port) return iter->first;
-    }
-    return "";
-}
+        auto found = net_states.find(net.get());
+        if (found != net_states.end())
+            return found->second;
 
+        NetState& state = net_states[net.get()];
+        for (Net::connection_iterator c_iter = net->begin(); c_iter != net->end(); ++c_iter)
+        {
+            auto entry = gate_ports.find(*c_iter);
+            if (entry == gate_ports.end())
+            {
+                state.external = true;
+            }
+            else if (!state.feeded_internally)
+            {
+                GateTemplatePort_shptr tmpl_port = entry->second.first->get_template_port();
+                state.feeded_internally = tmpl_port != nullptr && tmpl_port->is_outport();
+            }
+        }
 
-void Module::determine_module_ports()
-{
-    if (is_main_module())
-    {
-        throw std::logic_error("determine_module_ports() is not suited for main modules. See determine_module_ports_for_root().");
-    }
+        return state;
+    };
+
+    // Reverse lookup of the current port names, to keep them.
+    std::unordered_map<GatePort*, std::string> port_names;
+    for (auto& p : ports)
+        port_names.insert({p.second.get(), p.first});
 
     int pnum = 0;
     port_collection new_ports;
-    std::set<Net_shptr> known_net;
+    std::unordered_set<Net*> known_net;
 
     for (auto g_iter = gates_begin(); g_iter != gates_end(); ++g_iter)
     {
@@ -329,71 +451,60 @@ void Module::determine_module_ports()
             assert(gate_port != nullptr);
 
             Net_shptr net = gate_port->get_net();
-            std::cout << "Check net for object gate port " << gate_port->get_descriptive_identifier() << "?\n";
 
             // To process only 1 time a net.
-            bool net_already_processed = known_net.find(net) != known_net.end();
-            if ((net != nullptr) && !net_already_processed && !net_completely_internal(net))
-            {
-                bool is_a_port = false;
+            if (net == nullptr || known_net.find(net.get()) != known_net.end())
+                continue;
 
-                for (Net::connection_iterator c_iter = net->begin(); c_iter != net->end() && !is_a_port; ++c_iter)
-                {
-                    object_id_t oid = *c_iter;
+            NetState const& state = get_net_state(net);
 
-                    if (!exists_gate_port_recursive(oid))
-                    {
-                        // Outbound connection
+            // Completely internal net.
+            if (!state.external)
+                continue;
 
-                        // Now we check, whether the connection is feeded by an outside entity or feeded
-                        // from this module.
-                        // Problem: We can't see the object outside this module, because we only have an
-                        // object ID and no logic model object to look up the object ID. Therefore we have
-                        // to derive the state of feeding from the objects we have in this or any sub-module.
-                        // If we see only in-ports in the net, the module port must be driven by an outside
-                        // port.
+            // Outbound connection
 
-                        GateTemplatePort_shptr tmpl_port = gate_port->get_template_port();
-                        assert(tmpl_port != nullptr); // If a gate has no standard cell type, the gate cannot have a port
+            // Now we check, whether the connection is feeded by an outside entity or feeded
+            // from this module.
+            // Problem: We can't see the object outside this module, because we only have an
+            // object ID and no logic model object to look up the object ID. Therefore we have
+            // to derive the state of feeding from the objects we have in this or any sub-module.
+            // If we see only in-ports in the net, the module port must be driven by an outside
+            // port.
 
-                        if (net_feeded_internally(net) && tmpl_port->is_inport())
-                        {
-                            std::cout << "  Net feeded internally, but port is inport. Will check where the net is driven.\n";
-                        }
-                        else
-                        {
-                            std::string mod_port_name = gate_port_already_named(ports, gate_port);
-                            if (mod_port_name == "")
-                            {
-                                // Generate a new port name and check if the port name is already in use
-                                do
-                                {
-                                    pnum++;
-                                    boost::format f("p%1%");
-                                    f % pnum;
-                                    mod_port_name = f.str();
-                                }
-                                while (ports.find(mod_port_name) != ports.end());
-                            }
-
-                            std::cout << "  New module port: " << gate_port->get_descriptive_identifier() << " == " << mod_port_name << "\n";
-                            new_ports[mod_port_name] = gate_port;
+            GateTemplatePort_shptr tmpl_port = gate_port->get_template_port();
+            assert(tmpl_port != nullptr); // If a gate has no standard cell type, the gate cannot have a port
 
-                            is_a_port = true;
-                            std::cout << "  Set net as known net: " << net->get_descriptive_identifier() << "\n";
-                            known_net.insert(net);
-                        }
-                    }
-                }
+            if (state.feeded_internally && tmpl_port->is_inport())
+            {
+                debug(TM, "Net feeded internally, but port is inport. Will check where the net is driven.");
+                continue;
             }
-            else if (net == nullptr)
+
+            std::string mod_port_name;
+
+            auto name = port_names.find(gate_port.get());
+            if (name != port_names.end())
             {
-                std::cout << "  Will not check net -- no net.\n";
+                mod_port_name = name->second;
             }
-            else if (net_already_processed)
+            else
             {
-                std::cout << "  Will not check net -- already processed " << net->get_descriptive_identifier() << ".\n";
+                // Generate a new port name and check if the port name is already in use
+                do
+                {
+                    pnum++;
+                    boost::format f("p%1%");
+                    f % pnum;
+                    mod_port_name = f.str();
+                }
+                while (ports.find(mod_port_name) != ports.end());
             }
+
+            debug(TM, "New module port: %s == %s", gate_port->get_descriptive_identifier().c_str(), mod_port_name.c_str());
+            new_ports[mod_port_name] = gate_port;
+
+            known_net.insert(net.get());
         }
     }
 
@@ -407,9 +518,7 @@ void Module::determine_module_ports()
             GatePort_shptr gate_port = p.second;
             Net_shptr net = gate_port->get_net();
 
-            bool net_already_processed = known_net.find(net) != known_net.end();
-
-            if (net != nullptr && !net_already_processed && !net_completely_internal(net))
+            if (net != nullptr && known_net.find(net.get()) == known_net.end() && get_net_state(net).external)
             {
                 // outbound connection
                 new_ports[mod_port_name] = gate_port;
@@ -442,21 +551,11 @@ GatePort_shptr Module::lookup_gate_port_recursive(object_id_t oid) const
 {
     assert(oid != 0);
 
-    for (gate_collection::const_iterator g_iter = gates.begin();
-         g_iter != gates.end(); ++g_iter)
-    {
-        Gate_shptr gate = *g_iter;
-
-        for (Gate::port_const_iterator p_iter = gate->ports_begin();
-             p_iter != gate->ports_end(); ++p_iter)
-            if ((*p_iter)->get_object_id() == oid) return *p_iter;
-    }
-
-    for (module_collection::const_iterator iter = modules.begin();
-         iter != modules.end(); ++iter)
-        if (GatePort_shptr gport = (*iter)->lookup_gate_port_recursive(oid)) return gport;
+    auto found = gate_ports.find(oid);
+    if (found == gate_ports.end())
+        return GatePort_shptr();
 
-    return GatePort_shptr();
+    return found->second.first;
 }
 
 
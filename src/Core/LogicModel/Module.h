@@ -25,6 +25,7 @@
 
 #include <map>
 #include <memory>
+#include <unordered_map>
 
 #include "Core/LogicModel/LogicModelObjectBase.h"
 #include "Core/LogicModel/LogicModel.h"
@@ -53,6 +54,12 @@ namespace degate
         typedef std::map<std::string, /* port name */
                          GatePort_shptr> port_collection;
 
+        /**
+         * Index of all gate ports in a module and its sub-modules, by object ID.
+         * The counter is the number of modules in the hierarchy that hold the gate.
+         */
+        typedef std::unordered_map<object_id_t, std::pair<GatePort_shptr, unsigned int>> gate_port_index;
+
     private:
 
         module_collection modules;
@@ -62,8 +69,31 @@ namespace degate
         std::string entity_name; // name of a type
         bool is_root;
 
+        Module* parent;
+        gate_port_index gate_ports;
+
     private:
 
+        /**
+         * Add gate ports to the index of this module and of all parent modules.
+         */
+        void index_gate_port(GatePort_shptr gate_port, unsigned int count = 1);
+
+        /**
+         * Remove gate ports from the index of this module and of all parent modules.
+         */
+        void unindex_gate_port(object_id_t oid, unsigned int count = 1);
+
+        /**
+         * Rebuild the gate port index of this module and of all sub-modules (e.g. after a deep copy).
+         */
+        void rebuild_gate_port_index();
+
+        /**
+         * Get the module, that directly holds a gate.
+         */
+        Module* lookup_gate_owner(Gate_shptr gate);
+
         /**
          * @throw InvalidPointerException This exception is thrown if the parameter is a nullptr pointer.
          */
@@ -74,6 +104,7 @@ namespace degate
         /**
          * Check if there is a gate is the current module or any child module
          * that has a gate port with the object ID \p oid .
+         * This is a lookup in the gate port index.
          */
         bool exists_gate_port_recursive(object_id_t oid) const;
         GatePort_shptr lookup_gate_port_recursive(object_id_t oid) const;
@@ -81,9 +112,6 @@ namespace degate
 
         void add_module_port(std::string const& module_port_name, GatePort_shptr adjacent_gate_port);
 
-        bool net_feeded_internally(Net_shptr net) const;
-        bool net_completely_internal(Net_shptr net) const;
-
     public:
 
         /**
@@ -166,6 +194,20 @@ namespace degate
         bool remove_module(Module_shptr module);
 
 
+        /**
+         * Add a new gate port to the index of the module hierarchy. Call this if a port was
+         * added to a gate, that is already in a module (@see LogicModel::update_ports()).
+         * It is ignored if the gate is not in this module or any sub-module.
+         */
+        void register_gate_port(GatePort_shptr gate_port);
+
+        /**
+         * Remove a gate port from the index of the module hierarchy. Call this before a port
+         * is removed from a gate, that is in a module (@see LogicModel::update_ports()).
+         */
+        void unregister_gate_port(GatePort_shptr gate_port);
+
+
         /**
          * Remove a module port from the module.
          * This is not recursive.
@@ -192,6 +234,8 @@ namespace degate
 
         /**
          * Determine ports of a module.
+         * This is a single pass over the nets of the gate ports of this module,
+         * each net is checked once against the gate port index.
          */
         void determine_module_ports();
 
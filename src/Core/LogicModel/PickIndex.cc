@@ -0,0 +1,244 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/LogicModel/PickIndex.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+using namespace degate;
+
+PickIndex::PickIndex(unsigned int base_cell_size) :
+    base_cell_size(std::max(base_cell_size, 1u)),
+    sequence(0)
+{
+}
+
+unsigned int PickIndex::get_level_index(BoundingBox const& box)
+{
+    const float size = std::max(box.get_width(), box.get_height());
+
+    unsigned int index = 0;
+    unsigned int cell_size = base_cell_size;
+
+    // The last level takes everything bigger.
+    while (static_cast<float>(cell_size) < size && cell_size <= (1u << 30))
+    {
+        cell_size *= 2;
+        index++;
+    }
+
+    while (levels.size() <= index)
+    {
+        Level level;
+        level.cell_size = base_cell_size << levels.size();
+        levels.push_back(level);
+    }
+
+    return index;
+}
+
+unsigned long long PickIndex::get_cell_key(int x, int y)
+{
+    return (static_cast<unsigned long long>(static_cast<unsigned int>(x)) << 32) | static_cast<unsigned int>(y);
+}
+
+void PickIndex::get_cell_range(Level const& level, float min_x, float max_x, float min_y, float max_y,
+                               int& first_x, int& last_x, int& first_y, int& last_y)
+{
+    const float cell_size = static_cast<float>(level.cell_size);
+
+    first_x = static_cast<int>(std::floor(min_x / cell_size));
+    last_x = static_cast<int>(std::floor(max_x / cell_size));
+    first_y = static_cast<int>(std::floor(min_y / cell_size));
+    last_y = static_cast<int>(std::floor(max_y / cell_size));
+}
+
+void PickIndex::insert(PlacedLogicModelObject_shptr object)
+{
+    assert(object != nullptr);
+
+    const object_id_t id = object->get_object_id();
+    assert(id != 0);
+
+    remove(id);
+
+    BoundingBox const& box = object->get_bounding_box();
+    const unsigned int index = get_level_index(box);
+    Level& level = levels[index];
+
+    CellEntry entry;
+    entry.kind = object->get_object_kind();
+    entry.priority = get_pick_priority(entry.kind);
+    entry.sequence = ++sequence;
+    entry.box = box;
+    entry.object = object;
+
+    int first_x, last_x, first_y, last_y;
+    get_cell_range(level, box.get_min_x(), box.get_max_x(), box.get_min_y(), box.get_max_y(),
+                   first_x, last_x, first_y, last_y);
+
+    for (int y = first_y; y <= last_y; y++)
+    {
+        for (int x = first_x; x <= last_x; x++)
+        {
+            Cell& cell = level.cells[get_cell_key(x, y)];
+
+            // The new entry has the highest sequence number, so it goes first among its priority.
+            auto pos = std::find_if(cell.begin(), cell.end(), [&](CellEntry const& e)
+            {
+                return e.priority >= entry.priority;
+            });
+
+            cell.insert(pos, entry);
+        }
+    }
+
+    entries[id] = Entry{index, box};
+}
+
+void PickIndex::remove(object_id_t id)
+{
+    auto iter = entries.find(id);
+    if (iter == entries.end())
+        return;
+
+    Level& level = levels[iter->second.level];
+    BoundingBox const& box = iter->second.box;
+
+    int first_x, last_x, first_y, last_y;
+    get_cell_range(level, box.get_min_x(), box.get_max_x(), box.get_min_y(), box.get_max_y(),
+                   first_x, last_x, first_y, last_y);
+
+    for (int y = first_y; y <= last_y; y++)
+    {
+        for (int x = first_x; x <= last_x; x++)
+        {
+            auto cell = level.cells.find(get_cell_key(x, y));
+            if (cell == level.cells.end())
+                continue;
+
+            cell->second.erase(std::remove_if(cell->second.begin(), cell->second.end(), [id](CellEntry const& e)
+            {
+                return e.object->get_object_id() == id;
+            }), cell->second.end());
+
+            if (cell->second.empty())
+                level.cells.erase(cell);
+        }
+    }
+
+    entries.erase(iter);
+}
+
+bool PickIndex::contains(object_id_t id) const
+{
+    return entries.find(id) != entries.end();
+}
+
+void PickIndex::clear()
+{
+    entries.clear();
+    levels.clear();
+}
+
+unsigned int PickIndex::get_objects_count() const
+{
+    return static_cast<unsigned int>(entries.size());
+}
+
+unsigned int PickIndex::get_levels_count() const
+{
+    return static_cast<unsigned int>(levels.size());
+}
+
+PlacedLogicModelObject_shptr PickIndex::pick(float x, float y, float max_distance, kind_mask const& ignored) const
+{
+    const BoundingBox region(x - max_distance, x + max_distance, y - max_distance, y + max_distance);
+
+    CellEntry const* best = nullptr;
+
+    for (auto const& level : levels)
+    {
+        if (level.cells.empty())
+            continue;
+
+        int first_x, last_x, first_y, last_y;
+        get_cell_range(level, region.get_min_x(), region.get_max_x(), region.get_min_y(), region.get_max_y(),
+                       first_x, last_x, first_y, last_y);
+
+        for (int cell_y = first_y; cell_y <= last_y; cell_y++)
+        {
+            for (int cell_x = first_x; cell_x <= last_x; cell_x++)
+            {
+                auto cell = level.cells.find(get_cell_key(cell_x, cell_y));
+                if (cell == level.cells.end())
+                    continue;
+
+                // Entries are sorted, the first hit is the best of the cell.
+                for (auto const& e : cell->second)
+                {
+                    if (best != nullptr &&
+                        (e.priority > best->priority ||
+                         (e.priority == best->priority && e.sequence <= best->sequence)))
+                        break;
+
+                    if (ignored[e.kind])
+                        continue;
+
+                    if (!e.box.intersects(region))
+                        continue;
+
+                    if (e.object->in_shape(x, y, max_distance))
+                    {
+                        best = &e;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    return best != nullptr ? best->object : nullptr;
+}
+
+unsigned int PickIndex::get_pick_priority(PlacedLogicModelObject::OBJECT_KIND kind)
+{
+    switch (kind)
+    {
+    case PlacedLogicModelObject::KIND_GATE_PORT:
+        return 0;
+    case PlacedLogicModelObject::KIND_VIA:
+        return 1;
+    case PlacedLogicModelObject::KIND_EMARKER:
+        return 2;
+    case PlacedLogicModelObject::KIND_GATE:
+        return 3;
+    case PlacedLogicModelObject::KIND_ANNOTATION:
+        return 4;
+    case PlacedLogicModelObject::KIND_WIRE:
+        return 5;
+    default:
+        return std::numeric_limits<unsigned int>::max();
+    }
+}
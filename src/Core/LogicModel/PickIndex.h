@@ -0,0 +1,174 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __PICKINDEX_H__
+#define __PICKINDEX_H__
+
+#include "Globals.h"
+#include "Core/LogicModel/PlacedLogicModelObject.h"
+#include "Core/Primitive/BoundingBox.h"
+
+#include <map>
+#include <vector>
+#include <bitset>
+#include <memory>
+#include <unordered_map>
+
+namespace degate
+{
+    /**
+     * Spatial index to find the object under the mouse cursor.
+     *
+     * The index is a hierarchy of coarse grids. Level i uses cells of base_cell_size * 2^i pixels.
+     * Every object is stored in the first level, whose cells are at least as big as the object, so
+     * it is referenced by at most 2x2 cells. The entries of a cell are kept sorted by pick priority
+     * (@see get_pick_priority()), the most recently inserted object first for equal priorities.
+     *
+     * A pick only looks at the few cells around the position (one or two per edge and level) and
+     * stops scanning a cell as soon as the priority is worse than the best hit. The exact shape test
+     * of an object is done last, after checking its kind and its bounding box. The pick time is
+     * bounded by the number of objects stored in these cells, not by the number of objects in a
+     * zoomed out view.
+     *
+     * Cells are only allocated when they hold objects, inserting, moving or removing an object only
+     * touches its own cells.
+     */
+    class PickIndex
+    {
+    public:
+
+        /**
+         * Kinds of objects that a pick ignores, indexed by PlacedLogicModelObject::OBJECT_KIND.
+         */
+        typedef std::bitset<PlacedLogicModelObject::KIND_COUNT> kind_mask;
+
+    private:
+
+        struct CellEntry
+        {
+            unsigned int priority;
+            unsigned long long sequence;
+            PlacedLogicModelObject::OBJECT_KIND kind;
+            BoundingBox box;
+            PlacedLogicModelObject_shptr object;
+        };
+
+        typedef std::vector<CellEntry> Cell;
+
+        struct Level
+        {
+            unsigned int cell_size;
+            std::unordered_map<unsigned long long, Cell> cells;
+        };
+
+        struct Entry
+        {
+            unsigned int level;
+            BoundingBox box;
+        };
+
+        unsigned int base_cell_size;
+        unsigned long long sequence;
+
+        std::vector<Level> levels;
+        std::map<object_id_t, Entry> entries;
+
+        /**
+         * Get the index of the level, that stores an object with bounding box \p box.
+         * Missing levels are created.
+         */
+        unsigned int get_level_index(BoundingBox const& box);
+
+        /**
+         * Get the key of a cell.
+         */
+        static unsigned long long get_cell_key(int x, int y);
+
+        /**
+         * Get the range of cells (inclusive) that a box touches on a level.
+         */
+        static void get_cell_range(Level const& level, float min_x, float max_x, float min_y, float max_y,
+                                   int& first_x, int& last_x, int& first_y, int& last_y);
+
+    public:
+
+        /**
+         * Create an empty index.
+         *
+         * @param base_cell_size : the edge length of a cell of the first level (in pixels).
+         */
+        explicit PickIndex(unsigned int base_cell_size = 32);
+
+        /**
+         * Add an object. If the object is already stored, it is updated (e.g. after a shape change).
+         * The object must have a valid object ID.
+         */
+        void insert(PlacedLogicModelObject_shptr object);
+
+        /**
+         * Remove an object. Nothing happens if there is no object with this ID.
+         */
+        void remove(object_id_t id);
+
+        /**
+         * Check if an object is stored.
+         */
+        bool contains(object_id_t id) const;
+
+        /**
+         * Remove all objects.
+         */
+        void clear();
+
+        /**
+         * Get the number of stored objects.
+         */
+        unsigned int get_objects_count() const;
+
+        /**
+         * Get the number of levels.
+         */
+        unsigned int get_levels_count() const;
+
+        /**
+         * Get the object with the best pick priority at a position.
+         *
+         * @param x : the x-position.
+         * @param y : the y-position.
+         * @param max_distance : the allowed distance of the position to the shape of an object.
+         * @param ignored : the kinds of objects that are not considered.
+         * @return Returns the object or nullptr if there is no object at the position.
+         *
+         * @see Layer::get_object_at_position()
+         */
+        PlacedLogicModelObject_shptr pick(float x, float y, float max_distance = 0,
+                                          kind_mask const& ignored = kind_mask()) const;
+
+        /**
+         * Get the pick priority of an object kind. Lower values are preferred.
+         */
+        static unsigned int get_pick_priority(PlacedLogicModelObject::OBJECT_KIND kind);
+    };
+
+    typedef std::shared_ptr<PickIndex> PickIndex_shptr;
+}
+
+#endif
@@ -29,7 +29,9 @@
 
 using namespace degate;
 
-PlacedLogicModelObject::PlacedLogicModelObject() : highlight_state(HLIGHTSTATE_NOT)
+PlacedLogicModelObject::PlacedLogicModelObject(OBJECT_KIND kind) :
+    highlight_state(HLIGHTSTATE_NOT),
+    object_kind(static_cast<uint8_t>(kind))
 {
 }
 
@@ -27,7 +27,6 @@
 
 #include "Globals.h"
 #include "Core/LogicModel/LogicModelObjectBase.h"
-#include "Core/LogicModel/Layer.h"
 #include "Core/Primitive/BoundingBox.h"
 #include "Core/Primitive/ColoredObject.h"
 #include "Core/Primitive/AbstractShape.h"
@@ -56,9 +55,28 @@ namespace degate
             HLIGHTSTATE_ADJACENT = 2
         };
 
+        /**
+         * The kind of a placed object. It is set on construction and allows to
+         * classify objects without RTTI (@see object_kind_cast()).
+         * Each concrete class declares its kind as static member kind_tag.
+         */
+        enum OBJECT_KIND
+        {
+            KIND_UNDEFINED = 0,
+            KIND_GATE = 1,
+            KIND_GATE_PORT = 2,
+            KIND_VIA = 3,
+            KIND_EMARKER = 4,
+            KIND_WIRE = 5,
+            KIND_ANNOTATION = 6,
+
+            KIND_COUNT
+        };
+
     private:
 
         HIGHLIGHTING_STATE highlight_state;
+        uint8_t object_kind;
         std::weak_ptr<Layer> layer;
         unsigned index;
 
@@ -77,8 +95,9 @@ namespace degate
 
         /**
          * The constructor.
+         * @param kind The kind of the object.
          */
-        PlacedLogicModelObject();
+        explicit PlacedLogicModelObject(OBJECT_KIND kind = KIND_UNDEFINED);
 
         /**
          * The destructor.
@@ -87,6 +106,32 @@ namespace degate
 
         void clone_deep_into(DeepCopyable_shptr destination, oldnew_t* oldnew) const override;
 
+        /**
+         * Get the kind of the object.
+         */
+        inline OBJECT_KIND get_object_kind() const
+        {
+            return static_cast<OBJECT_KIND>(object_kind);
+        }
+
+        /**
+         * Check if the object is of kind \p kind. This is much cheaper than a
+         * dynamic_pointer_cast, if only the type is of interest.
+         */
+        inline bool is_of_kind(OBJECT_KIND kind) const
+        {
+            return object_kind == kind;
+        }
+
+        /**
+         * Check if the object is a ConnectedLogicModelObject (gate port, via, emarker or wire).
+         */
+        inline bool is_connectable() const
+        {
+            return object_kind == KIND_GATE_PORT || object_kind == KIND_VIA ||
+                   object_kind == KIND_EMARKER || object_kind == KIND_WIRE;
+        }
+
         /**
          * A placed object is highlightable. You can ask for its
          * state with this method.
@@ -137,6 +182,18 @@ namespace degate
         }
     };
 
+    /**
+     * Cast a placed object to the concrete class \p LogicModelObjectType, by checking
+     * the kind tag instead of RTTI. The class must declare a kind_tag.
+     * @return Returns the casted pointer or nullptr, if the object is of another kind.
+     */
+    template <typename LogicModelObjectType>
+    inline std::shared_ptr<LogicModelObjectType> object_kind_cast(std::shared_ptr<PlacedLogicModelObject> const& o)
+    {
+        if (o == nullptr || !o->is_of_kind(LogicModelObjectType::kind_tag)) return nullptr;
+        return std::static_pointer_cast<LogicModelObjectType>(o);
+    }
+
     static inline uint32_t highlight_color(uint32_t col)
     {
         uint8_t r = MASK_R(col);
@@ -163,4 +220,7 @@ namespace degate
     }
 }
 
+// The layer needs the complete object type (for the object kinds).
+#include "Core/LogicModel/Layer.h"
+
 #endif
@@ -28,6 +28,7 @@ using namespace degate;
 
 Via::Via(float x, float y, diameter_t diameter, Via::DIRECTION direction) :
     Circle(x, y, diameter),
+    ConnectedLogicModelObject(kind_tag),
     direction(direction)
 {
 }
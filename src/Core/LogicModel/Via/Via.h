@@ -45,6 +45,13 @@ namespace degate
     {
     Q_DECLARE_TR_FUNCTIONS(degate::Via)
 
+    public:
+
+        /**
+         * The kind of all objects of this class.
+         */
+        static const OBJECT_KIND kind_tag = KIND_VIA;
+
     public:
 
         /**
@@ -67,7 +74,7 @@ namespace degate
 
     public:
 
-        explicit Via()
+        explicit Via() : ConnectedLogicModelObject(kind_tag)
         {
         };
 
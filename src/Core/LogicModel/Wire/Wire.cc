@@ -34,12 +34,14 @@
 using namespace degate;
 
 Wire::Wire(float from_x, float from_y, float to_x, float to_y, unsigned int diameter) :
-    Line(from_x, from_y, to_x, to_y, diameter)
+    Line(from_x, from_y, to_x, to_y, diameter),
+    ConnectedLogicModelObject(kind_tag)
 {
 }
 
 Wire::Wire(Line line) :
-    Line(line)
+    Line(line),
+    ConnectedLogicModelObject(kind_tag)
 {
 
 }
@@ -40,6 +40,13 @@ namespace degate
     {
     Q_DECLARE_TR_FUNCTIONS(degate::Wire)
 
+    public:
+
+        /**
+         * The kind of all objects of this class.
+         */
+        static const OBJECT_KIND kind_tag = KIND_WIRE;
+
     public:
 
         /**
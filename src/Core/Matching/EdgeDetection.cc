@@ -55,11 +55,7 @@ unsigned int EdgeDetection::get_border() const
 
 void EdgeDetection::setup_pipe()
 {
-    debug(TM, "will extract background image (%d, %d) (%d, %d)", min_x, min_y, max_x, max_y);
-    std::shared_ptr<IPCopy<TileImage_RGBA, TileImage_GS_DOUBLE>> copy_rgba_to_gs
-        (new IPCopy<TileImage_RGBA, TileImage_GS_DOUBLE>(min_x, max_x, min_y, max_y));
-
-    pipe.add(copy_rgba_to_gs);
+    // The background region is extracted in run_edge_detection(), that knows the pixel format.
 
     if (median_filter_width > 0)
     {
@@ -116,7 +112,24 @@ bool EdgeDetection::has_directory() const
 
 void EdgeDetection::run_edge_detection(ImageBase_shptr in)
 {
-    ImageBase_shptr out = pipe.run(in);
+    debug(TM, "will extract background image (%d, %d) (%d, %d)", min_x, min_y, max_x, max_y);
+
+    // Greyscale backgrounds are copied as they are, without an RGBA conversion.
+    ImageBase_shptr region;
+    if (std::dynamic_pointer_cast<TileImage_GS_BYTE>(in) != nullptr)
+    {
+        std::shared_ptr<IPCopy<TileImage_GS_BYTE, TileImage_GS_DOUBLE>> copy_gs
+            (new IPCopy<TileImage_GS_BYTE, TileImage_GS_DOUBLE>(min_x, max_x, min_y, max_y));
+        region = copy_gs->run(in);
+    }
+    else
+    {
+        std::shared_ptr<IPCopy<TileImage_RGBA, TileImage_GS_DOUBLE>> copy_rgba_to_gs
+            (new IPCopy<TileImage_RGBA, TileImage_GS_DOUBLE>(min_x, max_x, min_y, max_y));
+        region = copy_rgba_to_gs->run(in);
+    }
+
+    ImageBase_shptr out = pipe.run(region);
     assert(out != nullptr);
 
     std::shared_ptr<SobelYOperator> sobel_y(new SobelYOperator());
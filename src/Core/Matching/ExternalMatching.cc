@@ -23,15 +23,25 @@
 #include "Core/Matching/ExternalMatching.h"
 #include "Core/Primitive/BoundingBox.h"
 #include "Core/Utils/DegateHelper.h"
+#include "Core/Utils/Trace.h"
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <sstream>
+
+#include <QProcess>
 
 
 using namespace degate;
 
-ExternalMatching::ExternalMatching()
+ExternalMatching::ExternalMatching() :
+    exit_code(0),
+    protocol(PROTOCOL_RESULT_FILE),
+    image_transfer(IMAGE_MAPPED_REGION),
+    worker_count(1),
+    partition_overlap(0)
 {
 }
 
@@ -50,11 +60,18 @@ void ExternalMatching::init(BoundingBox const& bounding_box, Project_shptr proje
     if (layer == nullptr) throw DegateRuntimeException("No current layer in project.");
 
 
-    ScalingManager_shptr sm = layer->get_scaling_manager();
-    assert(sm != nullptr);
-
-    img = sm->get_image(1).second;
-    assert(img != nullptr);
+    if (layer->get_image_format() == Layer::IMAGE_FORMAT_GS_BYTE)
+    {
+        img.reset();
+        gs_img = layer->get_greyscale_image();
+        assert(gs_img != nullptr);
+    }
+    else
+    {
+        gs_img.reset();
+        img = layer->get_image();
+        assert(img != nullptr);
+    }
 }
 
 
@@ -68,7 +85,64 @@ std::string ExternalMatching::get_command() const
     return cmd;
 }
 
+void ExternalMatching::set_protocol(PROTOCOL protocol)
+{
+    this->protocol = protocol;
+}
+
+ExternalMatching::PROTOCOL ExternalMatching::get_protocol() const
+{
+    return protocol;
+}
+
+void ExternalMatching::set_image_transfer(IMAGE_TRANSFER image_transfer)
+{
+    this->image_transfer = image_transfer;
+}
+
+ExternalMatching::IMAGE_TRANSFER ExternalMatching::get_image_transfer() const
+{
+    return image_transfer;
+}
+
+void ExternalMatching::set_worker_count(unsigned int worker_count)
+{
+    this->worker_count = std::max(1u, worker_count);
+}
+
+unsigned int ExternalMatching::get_worker_count() const
+{
+    return worker_count;
+}
+
+void ExternalMatching::set_partition_overlap(unsigned int partition_overlap)
+{
+    this->partition_overlap = partition_overlap;
+}
+
+unsigned int ExternalMatching::get_partition_overlap() const
+{
+    return partition_overlap;
+}
+
+int ExternalMatching::get_exit_code() const
+{
+    return exit_code;
+}
+
 void ExternalMatching::run()
+{
+    TRACE_SCOPE("external-matching");
+
+    reset_progress();
+
+    if (protocol == PROTOCOL_STREAM) run_stream();
+    else run_result_file();
+
+    set_progress(1.0);
+}
+
+void ExternalMatching::run_result_file()
 {
     // create a temp dir
     std::string dir = create_temp_directory();
@@ -80,7 +154,8 @@ void ExternalMatching::run()
     std::string results_file = dir;
     results_file.append("/results.dat");
 
-    save_part_of_image(image_file, img, bounding_box);
+    if (gs_img != nullptr) save_part_of_image(image_file, gs_img, bounding_box);
+    else save_part_of_image(image_file, img, bounding_box);
 
     boost::format f("%1% --image %2% --results %3% "
         "--start-x %4% --start-y %5% --width %6% --height %7%");
@@ -112,6 +187,338 @@ void ExternalMatching::run()
     remove_directory(dir);
 }
 
+/**
+ * The state of a single program instance of the stream protocol.
+ */
+struct stream_worker
+{
+    QProcess process;
+
+    // The part of the region, the worker is responsible for ...
+    BoundingBox partition;
+
+    // ... and the part it actually gets to see.
+    BoundingBox region;
+
+    // Depending on the pixel format of the layer, one of them is used.
+    std::shared_ptr<MemoryMap<rgba_pixel_t>> region_map;
+    std::shared_ptr<MemoryMap<gs_byte_pixel_t>> gs_region_map;
+    std::string region_file;
+
+    std::string buffer;
+    ProgressControl_shptr progress;
+    bool finished = false;
+};
+
+/**
+ * The workers and the temp directory of a stream protocol run. Workers, that still run,
+ * are killed and the directory is removed, however the run ends.
+ */
+struct stream_session
+{
+    std::vector<std::shared_ptr<stream_worker>> workers;
+    std::string dir;
+
+    ~stream_session()
+    {
+        for (auto& w : workers)
+        {
+            if (w->process.state() != QProcess::NotRunning)
+            {
+                w->process.kill();
+                w->process.waitForFinished();
+            }
+        }
+
+        // Unmap the region files before they are removed.
+        workers.clear();
+
+        if (!dir.empty()) remove_directory(dir);
+    }
+};
+
+/**
+ * Check if a coordinate is inside the stripe of a worker. The last stripe includes its lower border.
+ */
+static bool in_partition(BoundingBox const& partition, BoundingBox const& region, float x, float y)
+{
+    return x >= partition.get_min_x() && x <= partition.get_max_x() &&
+           y >= partition.get_min_y() &&
+           (y < partition.get_max_y() || (y == region.get_max_y() && partition.get_max_y() == region.get_max_y()));
+}
+
+void ExternalMatching::run_stream()
+{
+    std::vector<std::string> tokens = tokenize(cmd);
+    if (tokens.empty()) throw DegateRuntimeException("No external command set.");
+
+    if (bounding_box.get_width() < 1 || bounding_box.get_height() < 1) return;
+
+    QStringList arguments;
+    for (unsigned int i = 1; i < tokens.size(); i++) arguments << QString::fromStdString(tokens[i]);
+
+    std::vector<BoundingBox> partitions = partition_region(bounding_box, worker_count);
+
+    stream_session session;
+    std::vector<std::shared_ptr<stream_worker>>& workers = session.workers;
+
+    session.dir = create_temp_directory();
+    std::string const& dir = session.dir;
+    assert(is_directory(dir));
+
+    exit_code = 0;
+
+    // Greyscale layers are passed with one byte per pixel.
+    const std::size_t pixel_size = gs_img != nullptr ? sizeof(gs_byte_pixel_t) : sizeof(rgba_pixel_t);
+    const std::string image_directory = gs_img != nullptr ? gs_img->get_directory() : img->get_directory();
+
+    for (unsigned int i = 0; i < partitions.size(); i++)
+    {
+        auto worker = std::make_shared<stream_worker>();
+        worker->partition = partitions[i];
+        worker->region = BoundingBox(bounding_box.get_min_x(),
+                                     bounding_box.get_max_x(),
+                                     std::max(bounding_box.get_min_y(),
+                                              partitions[i].get_min_y() - static_cast<float>(partition_overlap)),
+                                     std::min(bounding_box.get_max_y(),
+                                              partitions[i].get_max_y() + static_cast<float>(partition_overlap)));
+        worker->progress = create_sub_progress(1.0 / partitions.size());
+
+        const int x = static_cast<int>(worker->region.get_min_x());
+        const int y = static_cast<int>(worker->region.get_min_y());
+        const unsigned int width = static_cast<unsigned int>(worker->region.get_width());
+        const unsigned int height = static_cast<unsigned int>(worker->region.get_height());
+
+        std::ostringstream meta;
+        meta << "protocol 1\n"
+             << "worker " << i << "\n"
+             << "workers " << partitions.size() << "\n"
+             << "region " << x << " " << y << " " << width << " " << height << "\n";
+
+        if (image_transfer == IMAGE_MAPPED_REGION)
+        {
+            // The plugin maps the same file. Nothing is encoded and the pages are shared.
+            // The file is removed together with the temp directory.
+            worker->region_file = join_pathes(dir, "region_" + std::to_string(i) + ".raw");
+            if (gs_img != nullptr)
+            {
+                worker->gs_region_map = std::make_shared<MemoryMap<gs_byte_pixel_t>>(width, height,
+                                                                                     MAP_STORAGE_TYPE_PERSISTENT_FILE,
+                                                                                     worker->region_file);
+                copy_region(gs_img, worker->region, *worker->gs_region_map);
+            }
+            else
+            {
+                worker->region_map = std::make_shared<MemoryMap<rgba_pixel_t>>(width, height,
+                                                                               MAP_STORAGE_TYPE_PERSISTENT_FILE,
+                                                                               worker->region_file);
+                copy_region(img, worker->region, *worker->region_map);
+            }
+
+            meta << "image-mode mapped-region\n"
+                 << "image-file " << worker->region_file << "\n"
+                 << "image-stride " << width * pixel_size << "\n";
+        }
+        else
+        {
+            // The tiles are read from where they are stored. The tile files are mapped shared,
+            // so the plugin sees the same data as the tile cache.
+            std::string container = join_pathes(image_directory, TILE_CONTAINER_FILENAME);
+
+            meta << "image-mode tile-directory\n"
+                 << "image-directory " << image_directory << "\n";
+
+            if (gs_img != nullptr)
+                meta << "image-size " << gs_img->get_width() << " " << gs_img->get_height() << "\n"
+                     << "tile-size " << gs_img->get_tile_size() << "\n";
+            else
+                meta << "image-size " << img->get_width() << " " << img->get_height() << "\n"
+                     << "tile-size " << img->get_tile_size() << "\n";
+
+            if (file_exists(container)) meta << "tile-storage container " << container << "\n";
+            else meta << "tile-storage files\n";
+        }
+
+        meta << "pixel-format " << (gs_img != nullptr ? "grey8" : "rgba8") << "\n"
+             << "end\n";
+
+        debug(TM, "start external command: %s (worker %d)", cmd.c_str(), i);
+
+        worker->process.setProgram(QString::fromStdString(tokens[0]));
+        worker->process.setArguments(arguments);
+        worker->process.start();
+
+        if (!worker->process.waitForStarted())
+            throw DegateRuntimeException("Can't start external command: " + tokens[0]);
+
+        const std::string meta_str = meta.str();
+        worker->process.write(meta_str.c_str(), static_cast<long long>(meta_str.size()));
+        worker->process.closeWriteChannel();
+
+        workers.push_back(worker);
+    }
+
+    unsigned int running = static_cast<unsigned int>(workers.size());
+
+    while (running > 0)
+    {
+        // The session kills the remaining workers.
+        if (is_canceled()) break;
+
+        for (auto& w : workers)
+        {
+            if (w->finished) continue;
+
+            const bool stopped = w->process.state() == QProcess::NotRunning;
+
+            if (!stopped) w->process.waitForReadyRead(10);
+
+            QByteArray data = w->process.readAllStandardOutput();
+            w->buffer.append(data.constData(), static_cast<std::size_t>(data.size()));
+
+            std::size_t pos = 0;
+            for (; pos + RECORD_SIZE <= w->buffer.size(); pos += RECORD_SIZE)
+            {
+                stream_record record = decode_record(w->buffer.data() + pos);
+
+                if (record.type == RECORD_PROGRESS)
+                {
+                    w->progress->set_progress(std::min(1.0, std::max(0.0, record.values[0] / 1e6)));
+                    continue;
+                }
+
+                if (record.type != RECORD_WIRE && record.type != RECORD_VIA)
+                {
+                    debug(TM, "skip external command record of unknown type %d", record.type);
+                    continue;
+                }
+
+                PlacedLogicModelObject_shptr plo = create_object(record);
+                BoundingBox const& bb = plo->get_bounding_box();
+
+                // Objects in the overlap are reported by both neighbours.
+                if (in_partition(w->partition, bounding_box, bb.get_center_x(), bb.get_center_y()))
+                    lmodel->add_object(layer, plo);
+            }
+            w->buffer.erase(0, pos);
+
+            if (stopped)
+            {
+                w->finished = true;
+                w->progress->set_progress(1.0);
+                running--;
+
+                if (!w->buffer.empty())
+                    debug(TM, "external command left %d bytes of an incomplete record", w->buffer.size());
+
+                int code = w->process.exitStatus() == QProcess::NormalExit ? w->process.exitCode() : -1;
+                if (code != 0)
+                {
+                    debug(TM, "external command failed with exit code %d", code);
+                    if (exit_code == 0) exit_code = code;
+                }
+            }
+        }
+    }
+}
+
+template <typename ImageType>
+void ExternalMatching::copy_region(std::shared_ptr<ImageType> img, BoundingBox const& region,
+                                   MemoryMap<typename ImageType::pixel_type>& dst) const
+{
+    typedef typename ImageType::pixel_type pixel_type;
+
+    const unsigned int min_x = static_cast<unsigned int>(region.get_min_x());
+    const unsigned int min_y = static_cast<unsigned int>(region.get_min_y());
+    const unsigned int width = std::min(static_cast<unsigned int>(region.get_width()),
+                                        img->get_width() > min_x ? img->get_width() - min_x : 0);
+    const unsigned int height = std::min(static_cast<unsigned int>(region.get_height()),
+                                         img->get_height() > min_y ? img->get_height() - min_y : 0);
+
+    const unsigned int tile_size = img->get_tile_size();
+    const unsigned int offset_bitmask = tile_size - 1;
+
+    dst.clear();
+
+    for (unsigned int y = 0; y < height; y++)
+    {
+        pixel_type* dst_row = dst.data() + static_cast<std::size_t>(y) * dst.get_width();
+
+        // Copy the row tile by tile.
+        for (unsigned int x = 0; x < width;)
+        {
+            const unsigned int src_x = min_x + x, src_y = min_y + y;
+            const unsigned int n = std::min(width - x, tile_size - (src_x & offset_bitmask));
+
+            typename ImageType::MemoryMap_shptr tile = img->fetch_tile(src_x, src_y);
+            const pixel_type* src = tile->data() +
+                                      static_cast<std::size_t>(src_y & offset_bitmask) * tile_size +
+                                      (src_x & offset_bitmask);
+
+            std::memcpy(dst_row + x, src, n * sizeof(pixel_type));
+            x += n;
+        }
+    }
+}
+
+std::vector<BoundingBox> ExternalMatching::partition_region(BoundingBox const& region, unsigned int count)
+{
+    const unsigned int height = static_cast<unsigned int>(region.get_height());
+    count = std::max(1u, std::min(count, std::max(1u, height)));
+
+    std::vector<BoundingBox> partitions;
+
+    float min_y = region.get_min_y();
+    for (unsigned int i = 0; i < count; i++)
+    {
+        // Distribute the remainder over the first stripes.
+        const unsigned int h = height / count + (i < height % count ? 1 : 0);
+        const float max_y = i + 1 == count ? region.get_max_y() : min_y + h;
+
+        partitions.push_back(BoundingBox(region.get_min_x(), region.get_max_x(), min_y, max_y));
+        min_y = max_y;
+    }
+
+    return partitions;
+}
+
+ExternalMatching::stream_record ExternalMatching::decode_record(const char* data)
+{
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+
+    uint32_t words[6];
+    for (unsigned int i = 0; i < 6; i++)
+    {
+        words[i] = static_cast<uint32_t>(bytes[4 * i]) |
+                   static_cast<uint32_t>(bytes[4 * i + 1]) << 8 |
+                   static_cast<uint32_t>(bytes[4 * i + 2]) << 16 |
+                   static_cast<uint32_t>(bytes[4 * i + 3]) << 24;
+    }
+
+    stream_record record;
+    record.type = words[0];
+    for (unsigned int i = 0; i < 5; i++) std::memcpy(&record.values[i], &words[i + 1], sizeof(int32_t));
+
+    return record;
+}
+
+PlacedLogicModelObject_shptr ExternalMatching::create_object(stream_record const& record)
+{
+    const int32_t* v = record.values;
+
+    switch (record.type)
+    {
+    case RECORD_WIRE:
+        return std::make_shared<Wire>(v[0], v[1], v[2], v[3], static_cast<diameter_t>(v[4]));
+    case RECORD_VIA:
+        return std::make_shared<Via>(v[0], v[1], static_cast<diameter_t>(v[2]),
+                                     v[3] == 1 ? Via::DIRECTION_UP :
+                                     v[3] == 2 ? Via::DIRECTION_DOWN : Via::DIRECTION_UNDEFINED);
+    default:
+        throw DegateRuntimeException("Can't decode record of type " + std::to_string(record.type));
+    }
+}
+
 std::list<PlacedLogicModelObject_shptr> ExternalMatching::parse_file(std::string const& filename) const
 {
     std::list<PlacedLogicModelObject_shptr> list;
@@ -26,14 +26,22 @@
 #include "Core/Project/Project.h"
 #include "Core/Matching/TemplateMatching.h"
 
+#include <vector>
+#include <cstdint>
+
 namespace degate
 {
     /**
      * Run an external program, that analyzes images.
-     * The program extracts wires and vias and writes
-     * the results into a file. The file is parsed
-     * bu this class and the object are added into
-     * the logic model.
+     * The program extracts wires and vias and reports them back. The
+     * objects are added into the logic model. There are two protocols.
+     *
+     * PROTOCOL_RESULT_FILE (default):
+     *
+     * The region is written into a tiff image and the program is called
+     * with the parameters --image, --results, --start-x, --start-y, --width
+     * and --height. The program writes the results into a file, that is
+     * parsed by this class.
      *
      * Here is a brief decription of the result file:
      *
@@ -52,21 +60,124 @@ namespace degate
      * The direction is either "up" or "down"
      *
      * Strings are case sensitive.
+     *
+     * PROTOCOL_STREAM:
+     *
+     * The image is not encoded. Depending on the image transfer mode, the program
+     * gets either a file with the raw pixels of its region, that it can map into
+     * memory (IMAGE_MAPPED_REGION), or the tile directory of the background image
+     * (IMAGE_TILE_DIRECTORY). The region is split into horizontal stripes and one
+     * program instance (worker) is started per stripe.
+     *
+     * Each worker gets its metadata as text lines on stdin. The list is terminated
+     * by a line "end" and stdin is closed afterwards:
+     *
+     *   protocol 1
+     *   worker <index>
+     *   workers <count>
+     *   region <x> <y> <width> <height>
+     *   image-mode mapped-region | tile-directory
+     *
+     * For a mapped region:
+     *
+     *   image-file <path>
+     *   image-stride <bytes per row>
+     *   pixel-format rgba8 | grey8
+     *
+     * The pixels of the region are stored row by row with 4 bytes per pixel in
+     * the order red, green, blue, alpha. Greyscale layers (grey8) are stored with
+     * one byte per pixel.
+     *
+     * For a tile directory:
+     *
+     *   image-directory <path>
+     *   image-size <width> <height>
+     *   tile-size <pixels>
+     *   tile-storage container <file> | files
+     *   pixel-format rgba8 | grey8
+     *
+     * A container is a single file (@see TileContainer). Otherwise each tile is
+     * stored in a file named "<tile x>_<tile y>.dat".
+     *
+     * The worker streams its results to stdout as binary records of RECORD_SIZE
+     * bytes: an unsigned 32 bit record type, followed by five signed 32 bit values,
+     * all in little endian byte order. Coordinates are absolute image coordinates.
+     *
+     *   RECORD_WIRE:     x1 y1 x2 y2 diameter
+     *   RECORD_VIA:      x y diameter direction (1 = up, 2 = down) unused
+     *   RECORD_PROGRESS: progress of the worker in millionths, 4 x unused
+     *
+     * Records of other types are skipped.
+     *
+     * Objects are added to the logic model as soon as their records arrive.
+     * Stripes may overlap (@see set_partition_overlap()). An object is only kept
+     * from the worker, whose own stripe holds the center of the object.
      */
     class ExternalMatching : public Matching
     {
+    public:
+
+        enum PROTOCOL
+        {
+            PROTOCOL_RESULT_FILE = 0,
+            PROTOCOL_STREAM = 1
+        };
+
+        enum IMAGE_TRANSFER
+        {
+            IMAGE_MAPPED_REGION = 0,
+            IMAGE_TILE_DIRECTORY = 1
+        };
+
+        enum RECORD_TYPE
+        {
+            RECORD_WIRE = 1,
+            RECORD_VIA = 2,
+            RECORD_PROGRESS = 3
+        };
+
+        /**
+         * The size of a binary result record in bytes.
+         */
+        static const unsigned int RECORD_SIZE = 24;
+
+        /**
+         * A decoded result record of the stream protocol.
+         */
+        struct stream_record
+        {
+            uint32_t type;
+            int32_t values[5];
+        };
+
     private:
 
         Layer_shptr layer;
         LogicModel_shptr lmodel;
         BackgroundImage_shptr img;
+        GreyscaleBackgroundImage_shptr gs_img;
         BoundingBox bounding_box;
 
         std::string cmd;
         int exit_code;
 
+        PROTOCOL protocol;
+        IMAGE_TRANSFER image_transfer;
+        unsigned int worker_count;
+        unsigned int partition_overlap;
+
     private:
 
+        void run_result_file();
+        void run_stream();
+
+        /**
+         * Copy a region of the background image \p img into a memory map.
+         */
+        template <typename ImageType>
+        void copy_region(std::shared_ptr<ImageType> img, BoundingBox const& region,
+                         MemoryMap<typename ImageType::pixel_type>& dst) const;
+
         std::list<PlacedLogicModelObject_shptr> parse_file(std::string const& filename) const;
 
         /**
@@ -95,6 +206,59 @@ namespace degate
 
         void set_command(std::string const& cmd);
         std::string get_command() const;
+
+        /**
+         * Set the protocol, that is used to talk with the external program.
+         */
+        void set_protocol(PROTOCOL protocol);
+        PROTOCOL get_protocol() const;
+
+        /**
+         * Set how the image is handed over to the external program. This is only
+         * used with PROTOCOL_STREAM.
+         */
+        void set_image_transfer(IMAGE_TRANSFER image_transfer);
+        IMAGE_TRANSFER get_image_transfer() const;
+
+        /**
+         * Set the number of program instances, that work on parts of the region in
+         * parallel. This is only used with PROTOCOL_STREAM.
+         */
+        void set_worker_count(unsigned int worker_count);
+        unsigned int get_worker_count() const;
+
+        /**
+         * Set the number of pixel rows, by which the stripe of a worker is extended
+         * into the stripes of its neighbours, so that objects on a stripe border are
+         * seen completely.
+         */
+        void set_partition_overlap(unsigned int partition_overlap);
+        unsigned int get_partition_overlap() const;
+
+        /**
+         * Get the exit code of the last program run. If several workers were run,
+         * the first non zero exit code is returned.
+         */
+        int get_exit_code() const;
+
+        /**
+         * Split a region into horizontal stripes of nearly equal height.
+         * @return Returns at most \p count stripes, that cover the region without overlap.
+         */
+        static std::vector<BoundingBox> partition_region(BoundingBox const& region, unsigned int count);
+
+        /**
+         * Decode a binary result record.
+         * @param data Points to at least RECORD_SIZE bytes.
+         */
+        static stream_record decode_record(const char* data);
+
+        /**
+         * Create the logic model object, that is described by a wire or via record.
+         * @exception DegateRuntimeException This exception is thrown, if the record
+         *   does not describe an object.
+         */
+        static PlacedLogicModelObject_shptr create_object(stream_record const& record);
     };
 
     typedef std::shared_ptr<ExternalMatching> ExternalMatching_shptr;
@@ -0,0 +1,242 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/Matching/PreparedTemplateCache.h"
+#include "Core/Utils/DegateExceptions.h"
+
+#include <fstream>
+#include <vector>
+
+using namespace degate;
+
+#define PREPARED_TEMPLATE_CACHE_MAGIC "DGPT"
+#define PREPARED_TEMPLATE_CACHE_FORMAT 1
+
+namespace
+{
+    template <typename T>
+    void write_value(std::ofstream& file, T const& value)
+    {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    bool read_value(std::ifstream& file, T& value)
+    {
+        return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+
+    template <typename ImageType>
+    void write_image(std::ofstream& file, std::shared_ptr<ImageType> img)
+    {
+        write_value<uint32_t>(file, img->get_width());
+        write_value<uint32_t>(file, img->get_height());
+
+        std::vector<typename ImageType::pixel_type> pixels(img->get_width() * img->get_height());
+        for (unsigned int y = 0; y < img->get_height(); y++)
+            for (unsigned int x = 0; x < img->get_width(); x++)
+                pixels[y * img->get_width() + x] = img->get_pixel(x, y);
+
+        file.write(reinterpret_cast<const char*>(pixels.data()),
+                   pixels.size() * sizeof(typename ImageType::pixel_type));
+    }
+
+    template <typename ImageType>
+    std::shared_ptr<ImageType> read_image(std::ifstream& file)
+    {
+        uint32_t width, height;
+        if (!read_value(file, width) || !read_value(file, height) || width == 0 || height == 0 ||
+            width > 0x10000 || height > 0x10000)
+            return nullptr;
+
+        std::vector<typename ImageType::pixel_type> pixels(static_cast<std::size_t>(width) * height);
+        if (!file.read(reinterpret_cast<char*>(pixels.data()), pixels.size() * sizeof(typename ImageType::pixel_type)))
+            return nullptr;
+
+        auto img = std::make_shared<ImageType>(width, height);
+        for (unsigned int y = 0; y < height; y++)
+            for (unsigned int x = 0; x < width; x++)
+                img->set_pixel(x, y, pixels[y * width + x]);
+
+        return img;
+    }
+}
+
+PreparedTemplateCache::image_version_t PreparedTemplateCache::get_image_version(GateTemplateImage_shptr img)
+{
+    if (img == nullptr) throw InvalidPointerException("Invalid image pointer for get_image_version().");
+
+    // FNV-1a over the image size and all pixels.
+    image_version_t hash = 14695981039346656037ULL;
+    auto add = [&hash](uint32_t v)
+    {
+        for (unsigned int i = 0; i < 4; i++, v >>= 8)
+        {
+            hash ^= v & 0xff;
+            hash *= 1099511628211ULL;
+        }
+    };
+
+    add(img->get_width());
+    add(img->get_height());
+
+    for (unsigned int y = 0; y < img->get_height(); y++)
+        for (unsigned int x = 0; x < img->get_width(); x++)
+            add(img->get_pixel(x, y));
+
+    return hash;
+}
+
+PreparedTemplate_shptr PreparedTemplateCache::get(image_version_t version,
+                                                  int orientation,
+                                                  unsigned int scaling_factor) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto found = entries.find(key_type(version, orientation, scaling_factor));
+    return found == entries.end() ? nullptr : found->second;
+}
+
+void PreparedTemplateCache::insert(image_version_t version,
+                                   int orientation,
+                                   unsigned int scaling_factor,
+                                   PreparedTemplate_shptr prep)
+{
+    if (prep == nullptr ||
+        prep->tmpl_img_normal == nullptr || prep->tmpl_img_scaled == nullptr ||
+        prep->zero_mean_template_normal == nullptr || prep->zero_mean_template_scaled == nullptr)
+        throw InvalidPointerException("Invalid prepared template for PreparedTemplateCache::insert().");
+
+    std::lock_guard<std::mutex> lock(mutex);
+    entries[key_type(version, orientation, scaling_factor)] = prep;
+    modified = true;
+}
+
+void PreparedTemplateCache::retain(std::set<image_version_t> const& versions)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (auto iter = entries.begin(); iter != entries.end();)
+    {
+        if (versions.find(std::get<0>(iter->first)) == versions.end())
+        {
+            iter = entries.erase(iter);
+            modified = true;
+        }
+        else ++iter;
+    }
+}
+
+void PreparedTemplateCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!entries.empty()) modified = true;
+    entries.clear();
+}
+
+unsigned int PreparedTemplateCache::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return static_cast<unsigned int>(entries.size());
+}
+
+bool PreparedTemplateCache::is_modified() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return modified;
+}
+
+void PreparedTemplateCache::save(std::string const& filename)
+{
+    std::ofstream file(filename.c_str(), std::ios::binary | std::ios::trunc);
+    if (!file) throw InvalidPathException("Can't write prepared template cache file.");
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    file.write(PREPARED_TEMPLATE_CACHE_MAGIC, 4);
+    write_value<uint32_t>(file, PREPARED_TEMPLATE_CACHE_FORMAT);
+    write_value<uint32_t>(file, static_cast<uint32_t>(entries.size()));
+
+    for (auto const& entry : entries)
+    {
+        write_value<uint64_t>(file, std::get<0>(entry.first));
+        write_value<int32_t>(file, std::get<1>(entry.first));
+        write_value<uint32_t>(file, std::get<2>(entry.first));
+
+        PreparedTemplate_shptr prep = entry.second;
+        write_value<double>(file, prep->sum_over_zero_mean_template_normal);
+        write_value<double>(file, prep->sum_over_zero_mean_template_scaled);
+        write_image(file, prep->tmpl_img_normal);
+        write_image(file, prep->tmpl_img_scaled);
+        write_image(file, prep->zero_mean_template_normal);
+        write_image(file, prep->zero_mean_template_scaled);
+    }
+
+    if (!file) throw InvalidPathException("Can't write prepared template cache file.");
+
+    modified = false;
+}
+
+bool PreparedTemplateCache::load(std::string const& filename)
+{
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    if (!file) return false;
+
+    char magic[4];
+    uint32_t format, count;
+    if (!file.read(magic, 4) || std::string(magic, 4) != PREPARED_TEMPLATE_CACHE_MAGIC ||
+        !read_value(file, format) || format != PREPARED_TEMPLATE_CACHE_FORMAT ||
+        !read_value(file, count))
+        return false;
+
+    // Read everything first, so that a truncated file does not leave a partial cache.
+    std::map<key_type, PreparedTemplate_shptr> loaded;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint64_t version;
+        int32_t orientation;
+        uint32_t scaling_factor;
+        auto prep = std::make_shared<PreparedTemplate>();
+
+        if (!read_value(file, version) || !read_value(file, orientation) || !read_value(file, scaling_factor) ||
+            !read_value(file, prep->sum_over_zero_mean_template_normal) ||
+            !read_value(file, prep->sum_over_zero_mean_template_scaled))
+            return false;
+
+        prep->tmpl_img_normal = read_image<TempImage_GS_BYTE>(file);
+        prep->tmpl_img_scaled = read_image<TempImage_GS_BYTE>(file);
+        prep->zero_mean_template_normal = read_image<TempImage_GS_DOUBLE>(file);
+        prep->zero_mean_template_scaled = read_image<TempImage_GS_DOUBLE>(file);
+
+        if (prep->tmpl_img_normal == nullptr || prep->tmpl_img_scaled == nullptr ||
+            prep->zero_mean_template_normal == nullptr || prep->zero_mean_template_scaled == nullptr)
+            return false;
+
+        loaded[key_type(version, orientation, scaling_factor)] = prep;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.insert(loaded.begin(), loaded.end());
+    modified = false;
+
+    return true;
+}
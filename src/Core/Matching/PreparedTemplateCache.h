@@ -0,0 +1,145 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __PREPAREDTEMPLATECACHE_H__
+#define __PREPAREDTEMPLATECACHE_H__
+
+#include "Core/Image/Image.h"
+#include "Core/LogicModel/Gate/GateTemplate.h"
+
+#include <map>
+#include <set>
+#include <tuple>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <cstdint>
+
+namespace degate
+{
+    /**
+     * A gate template image, that is prepared for template matching: greyscale versions
+     * of the oriented image in normal and scaled size, and zero-mean versions of both.
+     */
+    struct PreparedTemplate
+    {
+        TempImage_GS_BYTE_shptr tmpl_img_normal;
+        TempImage_GS_BYTE_shptr tmpl_img_scaled;
+
+        TempImage_GS_DOUBLE_shptr zero_mean_template_normal;
+        TempImage_GS_DOUBLE_shptr zero_mean_template_scaled;
+
+        double sum_over_zero_mean_template_normal = 0;
+        double sum_over_zero_mean_template_scaled = 0;
+    };
+
+    typedef std::shared_ptr<PreparedTemplate> PreparedTemplate_shptr;
+
+    /**
+     * Cache for prepared gate template images.
+     *
+     * Entries are keyed by the version of the template image, which is a hash over its
+     * content, the orientation and the scaling factor. Entries of images, that were
+     * replaced, are never hit again and can be dropped with retain(). Because keys do not
+     * depend on the template, a cache can be shared between clones of a template.
+     *
+     * The cache can be saved next to the template images of a gate library, so that
+     * repeated matching runs skip the preparation entirely. A cache file is only a hint:
+     * a missing or broken file is ignored.
+     *
+     * @see TemplateMatching
+     * @see GateTemplate::get_prepared_templates()
+     */
+    class PreparedTemplateCache
+    {
+    public:
+
+        typedef GateTemplate::image_version_t image_version_t;
+
+    private:
+
+        typedef std::tuple<image_version_t, int, unsigned int> key_type;
+
+        std::map<key_type, PreparedTemplate_shptr> entries;
+        bool modified = false;
+        mutable std::mutex mutex;
+
+    public:
+
+        /**
+         * Calculate the version of an image from its content.
+         */
+        static image_version_t get_image_version(GateTemplateImage_shptr img);
+
+        /**
+         * Get a prepared template.
+         * @param version The version of the template image.
+         * @param orientation The orientation (Gate::ORIENTATION) of the prepared template.
+         * @param scaling_factor The scaling factor of the scaled images.
+         * @return Returns the prepared template or a nullptr pointer, if it is not cached.
+         */
+        PreparedTemplate_shptr get(image_version_t version, int orientation, unsigned int scaling_factor) const;
+
+        /**
+         * Add a prepared template. An existing entry is replaced.
+         * @exception InvalidPointerException This exception is thrown, if \p prep or one of
+         *   its images is invalid.
+         */
+        void insert(image_version_t version, int orientation, unsigned int scaling_factor,
+                    PreparedTemplate_shptr prep);
+
+        /**
+         * Drop all entries, that do not belong to one of the image versions in \p versions.
+         */
+        void retain(std::set<image_version_t> const& versions);
+
+        /**
+         * Drop all entries.
+         */
+        void clear();
+
+        /**
+         * Get the number of cached entries.
+         */
+        unsigned int size() const;
+
+        /**
+         * Check if entries were added or dropped since the cache was saved or loaded.
+         */
+        bool is_modified() const;
+
+        /**
+         * Write all entries into a file.
+         * @exception InvalidPathException This exception is thrown, if the file cannot be written.
+         */
+        void save(std::string const& filename);
+
+        /**
+         * Read entries from a file, that was written by save().
+         * @return Returns false, if the file does not exist or is not a valid cache file.
+         *   In that case the cache is left unchanged.
+         */
+        bool load(std::string const& filename);
+    };
+
+}
+
+#endif
@@ -27,6 +27,7 @@
 #include "Core/Image/ImageHelper.h"
 #include "Core/Image/Manipulation/MedianFilter.h"
 #include "Core/Utils/DegateHelper.h"
+#include "Core/Utils/Trace.h"
 
 #include <memory>
 
@@ -93,6 +94,8 @@ void TemplateMatching::precalc_sum_tables(TileImage_GS_BYTE_shptr img,
 
 void TemplateMatching::init(BoundingBox const& bounding_box, Project_shptr project)
 {
+    TRACE_SCOPE_CATEGORY("template-matching/init", "matching");
+
     assert(project != nullptr);
 
     this->project = project;
@@ -105,10 +108,11 @@ void TemplateMatching::init(BoundingBox const& bounding_box, Project_shptr proje
     if (this->bounding_box.get_max_y() + 1 > static_cast<int>(project->get_height()))
         this->bounding_box.set_max_y(LENGTH_TO_MAX(project->get_height()));
 
-    ScalingManager_shptr sm = layer_matching->get_scaling_manager();
-
     debug(TM, "Prepare background.");
-    prepare_background_images(sm, bounding_box, get_scaling_factor());
+    if (layer_matching->get_image_format() == Layer::IMAGE_FORMAT_GS_BYTE)
+        prepare_background_images(layer_matching->get_greyscale_scaling_manager(), bounding_box, get_scaling_factor());
+    else
+        prepare_background_images(layer_matching->get_scaling_manager(), bounding_box, get_scaling_factor());
     debug(TM, "Prepare sum tabes.");
     prepare_sum_tables(gs_img_normal, gs_img_scaled);
 }
@@ -123,21 +127,24 @@ BoundingBox TemplateMatching::get_scaled_bounding_box(BoundingBox const& boundin
                        lrint(bounding_box.get_max_y() / scale_down));
 }
 
-void TemplateMatching::prepare_background_images(ScalingManager_shptr sm,
+template <typename ImageType>
+void TemplateMatching::prepare_background_images(std::shared_ptr<ScalingManager<ImageType>> sm,
                                                  BoundingBox const& bounding_box,
                                                  unsigned int scaling_factor)
 {
+    assert(sm != nullptr);
+
     // Get the normal background image and the scaled background image
-    // These images are in RGBA format.
-    const ScalingManager<BackgroundImage>::image_map_element i1 = sm->get_image(1);
-    const ScalingManager<BackgroundImage>::image_map_element i2 = sm->get_image(scaling_factor);
+    // These images are in RGBA or in greyscale format.
+    const typename ScalingManager<ImageType>::image_map_element i1 = sm->get_image(1);
+    const typename ScalingManager<ImageType>::image_map_element i2 = sm->get_image(scaling_factor);
 
     assert(i1.second != nullptr);
     assert(i2.second != nullptr);
     assert(i2.first == get_scaling_factor());
 
-    BackgroundImage_shptr img_normal = i1.second;
-    BackgroundImage_shptr img_scaled = i2.second;
+    std::shared_ptr<ImageType> img_normal = i1.second;
+    std::shared_ptr<ImageType> img_scaled = i2.second;
 
     // Create a greyscaled image for the normal
     // unscaled background image and the scaled version.
@@ -252,6 +259,8 @@ void TemplateMatching::set_orientations(std::list<Gate::ORIENTATION> tmpl_orient
 
 void TemplateMatching::run()
 {
+    TRACE_SCOPE_CATEGORY("template-matching/run", "matching");
+
     if (is_canceled()) return;
 
     debug(TM, "run template matching");
@@ -302,10 +311,10 @@ void TemplateMatching::run()
 
     BOOST_FOREACH(match_found const& m, matches)
     {
-        std::cout << "Try to insert gate of type " << m.tmpl->get_name() << " with corr="
-            << m.correlation << " at " << m.x << "," << m.y << std::endl;
+        debug(TM, "Try to insert gate of type %s with corr=%f at %d,%d",
+              m.tmpl->get_name().c_str(), m.correlation, m.x, m.y);
         if (add_gate(m.x, m.y, m.tmpl, m.orientation, m.correlation, m.t_hc))
-            std::cout << "\tInserted gate of type " << m.tmpl->get_name() << std::endl;
+            debug(TM, "Inserted gate of type %s", m.tmpl->get_name().c_str());
     }
 
     reset_progress();
@@ -335,6 +344,8 @@ double TemplateMatching::subtract_mean(TempImage_GS_BYTE_shptr img,
 TemplateMatching::prepared_template TemplateMatching::prepare_template(GateTemplate_shptr tmpl,
                                                                        Gate::ORIENTATION orientation)
 {
+    TRACE_SCOPE_CATEGORY("template-matching/prepare-template", "matching");
+
     prepared_template prep;
 
     assert(layer_matching->get_layer_type() != Layer::UNDEFINED);
@@ -343,6 +354,16 @@ TemplateMatching::prepared_template TemplateMatching::prepare_template(GateTempl
     prep.gate_template = tmpl;
     prep.orientation = orientation;
 
+    // lookup the prepared template in the cache
+    PreparedTemplateCache_shptr cache = tmpl->get_prepared_templates();
+    const PreparedTemplateCache::image_version_t version = tmpl->get_image_version(layer_matching->get_layer_type());
+
+    if (PreparedTemplate_shptr cached = cache->get(version, orientation, get_scaling_factor()))
+    {
+        static_cast<PreparedTemplate&>(prep) = *cached;
+        return prep;
+    }
+
     // get image from template
     GateTemplateImage_shptr tmpl_img_orig = tmpl->get_image(layer_matching->get_layer_type());
 
@@ -410,6 +431,8 @@ TemplateMatching::prepared_template TemplateMatching::prepare_template(GateTempl
     assert(prep.sum_over_zero_mean_template_normal > 0);
     assert(prep.sum_over_zero_mean_template_scaled > 0);
 
+    cache->insert(version, orientation, get_scaling_factor(), std::make_shared<PreparedTemplate>(prep));
+
     return prep;
 }
 
@@ -472,6 +495,8 @@ std::list<TemplateMatching::match_found>
 TemplateMatching::match_single_template(struct prepared_template& tmpl,
                                         double threshold_hc, double threshold_detection)
 {
+    TRACE_SCOPE_CATEGORY("template-matching/match-single-template", "matching");
+
     debug(TM, "match_single_template(): start iterating over background image");
     search_state state;
     //memset(&state, 0, sizeof(search_state));
@@ -482,9 +507,12 @@ TemplateMatching::match_single_template(struct prepared_template& tmpl,
     std::list<match_found> matches;
 
     double max_corr_for_search = -1;
+    uint_fast64_t positions = 0;
 
     do
     {
+        positions++;
+
         // works on unscaled, but cropped image
 
         double corr_val = calc_single_xcorr(gs_img_scaled,
@@ -527,8 +555,8 @@ TemplateMatching::match_single_template(struct prepared_template& tmpl,
     }
     while (get_next_pos(&state, tmpl) && !is_canceled());
 
-    std::cout << "The maximum correlation value for the current template and orientation is " << max_corr_for_search <<
-        std::endl;
+    debug(TM, "The maximum correlation value for the current template and orientation is %f", max_corr_for_search);
+    TRACE_COUNT("template-matching/positions", positions);
 
     return matches;
 }
@@ -26,6 +26,7 @@
 #include "Core/Project/Project.h"
 #include "Core/LogicModel/Layer.h"
 #include "Core/Utils/ProgressControl.h"
+#include "Core/Matching/PreparedTemplateCache.h"
 
 namespace degate
 {
@@ -66,20 +67,8 @@ namespace degate
     {
     protected:
 
-        struct prepared_template
+        struct prepared_template : public PreparedTemplate
         {
-            TempImage_GS_BYTE_shptr tmpl_img_normal;
-            TempImage_GS_BYTE_shptr tmpl_img_scaled;
-
-            //TempImage_GS_BYTE_shptr zero_mean_template_normal; // GS_DOUBLE?
-            //TempImage_GS_BYTE_shptr zero_mean_template_scaled;
-
-            TempImage_GS_DOUBLE_shptr zero_mean_template_normal; // GS_DOUBLE?
-            TempImage_GS_DOUBLE_shptr zero_mean_template_scaled;
-
-            double sum_over_zero_mean_template_normal;
-            double sum_over_zero_mean_template_scaled;
-
             Gate::ORIENTATION orientation;
             GateTemplate_shptr gate_template;
         };
@@ -159,10 +148,20 @@ namespace degate
         BoundingBox get_scaled_bounding_box(BoundingBox const& bounding_box,
                                             double scale_down) const;
 
-        void prepare_background_images(ScalingManager_shptr sm,
+        /**
+         * Extract the matching region from the normal and the scaled background image.
+         * Greyscale backgrounds are copied as they are, RGBA backgrounds are converted.
+         */
+        template <typename ImageType>
+        void prepare_background_images(std::shared_ptr<ScalingManager<ImageType>> sm,
                                        BoundingBox const& bounding_box,
                                        unsigned int scaling_factor);
 
+        /**
+         * Prepare a template image for matching. Prepared images are cached in the
+         * template, keyed by image version, orientation and scaling factor.
+         * @see GateTemplate::get_prepared_templates()
+         */
         struct prepared_template prepare_template(GateTemplate_shptr tmpl,
                                                   Gate::ORIENTATION orientation);
 
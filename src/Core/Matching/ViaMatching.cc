@@ -20,12 +20,15 @@
  */
 
 #include "Core/Image/Manipulation/MedianFilter.h"
+#include "Core/Image/BlockAccessPolicy.h"
 #include "Core/LogicModel/LogicModelHelper.h"
 #include "Core/Matching/EdgeDetection.h"
 #include "Core/Matching/ViaMatching.h"
 #include "Core/Primitive/BoundingBox.h"
+#include "Core/Utils/Trace.h"
 #include <boost/foreach.hpp>
 #include <memory>
+#include <vector>
 
 
 using namespace degate;
@@ -38,6 +41,8 @@ ViaMatching::ViaMatching() :
 
 void ViaMatching::init(BoundingBox const& bounding_box, Project_shptr project)
 {
+    TRACE_SCOPE_CATEGORY("via-matching/init", "matching");
+
     this->bounding_box = bounding_box;
 
     if (project == nullptr)
@@ -51,11 +56,18 @@ void ViaMatching::init(BoundingBox const& bounding_box, Project_shptr project)
         throw DegateRuntimeException("No current layer in project.");
 
 
-    ScalingManager_shptr sm = layer->get_scaling_manager();
-    assert(sm != nullptr);
-
-    img = sm->get_image(1).second;
-    assert(img != nullptr);
+    if (layer->get_image_format() == Layer::IMAGE_FORMAT_GS_BYTE)
+    {
+        img.reset();
+        gs_img = layer->get_greyscale_image();
+        assert(gs_img != nullptr);
+    }
+    else
+    {
+        gs_img.reset();
+        img = layer->get_image();
+        assert(img != nullptr);
+    }
 
     reset_progress();
 }
@@ -88,6 +100,8 @@ unsigned int ViaMatching::get_merge_n_vias() const
 
 void ViaMatching::run()
 {
+    TRACE_SCOPE_CATEGORY("via-matching/run", "matching");
+
     if (via_diameter == 0) throw DegateLogicException("Parameter via diameter was not set.");
 
     unsigned int max_r = 0;
@@ -177,33 +191,41 @@ void ViaMatching::run()
     if (substeps > 0) set_progress_step_size(1.0 / (substeps * (bounding_box.get_height() - max_r * 2)));
 
     // run via matching
-    if (via_up_gs) scan(bounding_box, img, via_up_gs, Via::DIRECTION_UP);
-    if (via_down_gs) scan(bounding_box, img, via_down_gs, Via::DIRECTION_DOWN);
+    // greyscale backgrounds are scanned without converting pixels
+    if (gs_img != nullptr)
+    {
+        if (via_up_gs) scan(bounding_box, gs_img, via_up_gs, Via::DIRECTION_UP);
+        if (via_down_gs) scan(bounding_box, gs_img, via_down_gs, Via::DIRECTION_DOWN);
+    }
+    else
+    {
+        if (via_up_gs) scan(bounding_box, img, via_up_gs, Via::DIRECTION_UP);
+        if (via_down_gs) scan(bounding_box, img, via_down_gs, Via::DIRECTION_DOWN);
+    }
 }
 
-template <class BGImageType, class TemplateImageType>
-double calc_xcorr(unsigned int start_x, unsigned int start_y,
-                  std::shared_ptr<BGImageType> bg_img, double f_avg, double sigma_f,
-                  std::shared_ptr<TemplateImageType> tmpl_img, double t_avg, double sigma_t)
+/**
+ * Calculate the normalized cross correlation of the template and the background window,
+ * whose left column is \p window_x in the background \p rows.
+ */
+double calc_xcorr(std::vector<double const*> const& rows, unsigned int window_x,
+                  double f_avg, double sigma_f,
+                  std::vector<double> const& tmpl, unsigned int tmpl_width,
+                  double t_avg, double sigma_t)
 {
     double sum = 0;
-    double n = tmpl_img->get_width() * tmpl_img->get_height();
+    double n = tmpl.size();
 
-    for (unsigned int y = 0; y < tmpl_img->get_height(); y++)
+    for (unsigned int y = 0; y < rows.size(); y++)
     {
-        for (unsigned int x = 0; x < tmpl_img->get_width(); x++)
-        {
-            double f_xy = bg_img->template get_pixel_as<double>(start_x + x, start_y + y);
-            double t_xy = tmpl_img->template get_pixel_as<double>(x, y);
+        double const* f = rows[y] + window_x;
+        double const* t = tmpl.data() + y * tmpl_width;
 
-            sum += (f_xy - f_avg) * (t_xy - t_avg) / (sigma_f * sigma_t); // extract commons
-        }
+        for (unsigned int x = 0; x < tmpl_width; x++)
+            sum += (f[x] - f_avg) * (t[x] - t_avg);
     }
 
-    sum *= 1 / (n - 1);
-
-
-    return sum;
+    return sum / (sigma_f * sigma_t * (n - 1));
 }
 
 
@@ -233,21 +255,34 @@ bool ViaMatching::add_via(unsigned int x, unsigned int y,
     return false;
 }
 
-void ViaMatching::scan(BoundingBox const& bbox, BackgroundImage_shptr bg_img,
+template <typename BGImageType>
+void ViaMatching::scan(BoundingBox const& bbox, std::shared_ptr<BGImageType> bg_img,
                        MemoryImage_GS_BYTE_shptr tmpl_img, Via::DIRECTION direction)
 {
     std::list<match_found> matches;
 
+    typedef typename BGImageType::pixel_type pixel_type;
+
     debug(TM, "run scanning");
-    double f_avg, sigma_f;
     double t_avg, sigma_t;
     average_and_stddev(tmpl_img, 0, 0,
                        tmpl_img->get_width(), tmpl_img->get_height(),
                        &t_avg, &sigma_t);
 
+    const unsigned int tmpl_w = tmpl_img->get_width(), tmpl_h = tmpl_img->get_height();
+    const double n = tmpl_w * tmpl_h;
+
+    std::vector<double> tmpl(tmpl_w * tmpl_h);
+    for (unsigned int y = 0; y < tmpl_h; y++)
+        for (unsigned int x = 0; x < tmpl_w; x++)
+            tmpl[y * tmpl_w + x] = tmpl_img->template get_pixel_as<double>(x, y);
+
     assert(bbox.get_max_x() >= 0);
     assert(bbox.get_max_y() >= 0);
 
+    const int min_x = std::max(0, static_cast<int>(bbox.get_min_x()));
+    const int min_y = std::max(0, static_cast<int>(bbox.get_min_y()));
+
     int max_x = static_cast<unsigned int>(bbox.get_max_x()) > tmpl_img->get_width()
                     ? bbox.get_max_x() - tmpl_img->get_width()
                     : bbox.get_min_x();
@@ -255,17 +290,67 @@ void ViaMatching::scan(BoundingBox const& bbox, BackgroundImage_shptr bg_img,
                     ? bbox.get_max_y() - tmpl_img->get_height()
                     : bbox.get_min_y();
 
-    for (int y = bbox.get_min_y(); y < max_y; y++)
+    // windows must be within the background image
+    max_x = std::min(max_x, static_cast<int>(bg_img->get_width()) - static_cast<int>(tmpl_w) + 1);
+    max_y = std::min(max_y, static_cast<int>(bg_img->get_height()) - static_cast<int>(tmpl_h) + 1);
+
+    // The rows under the current windows are kept in a ring buffer, so each background
+    // row is read and converted once. Window sums are taken from prefix sums of the column sums.
+    const unsigned int band_w = max_x > min_x ? max_x - min_x + tmpl_w - 1 : 0;
+
+    std::vector<double> band(static_cast<std::size_t>(band_w) * tmpl_h);
+    std::vector<pixel_type> row_pixels(band_w);
+    std::vector<double const*> rows(tmpl_h);
+    std::vector<double> sum(band_w + 1, 0), sum_sq(band_w + 1, 0);
+
+    auto read_row = [&](unsigned int row)
+    {
+        BlockAccessPolicy<BGImageType>::read(bg_img, min_x, min_x + band_w, row, row + 1, row_pixels.data());
+
+        double* dst = band.data() + static_cast<std::size_t>(row % tmpl_h) * band_w;
+        for (unsigned int x = 0; x < band_w; x++)
+            dst[x] = convert_pixel<gs_double_pixel_t, pixel_type>(row_pixels[x]);
+    };
+
+    for (int y = min_y; y < max_y; y++)
     {
-        for (int x = bbox.get_min_x(); x < max_x; x++)
+        if (band_w > 0)
+        {
+            if (y == min_y)
+                for (unsigned int row = y; row < y + tmpl_h; row++) read_row(row);
+            else read_row(y + tmpl_h - 1);
+
+            for (unsigned int i = 0; i < tmpl_h; i++)
+                rows[i] = band.data() + static_cast<std::size_t>((y + i) % tmpl_h) * band_w;
+
+            for (unsigned int x = 0; x < band_w; x++)
+            {
+                double column_sum = 0, column_sum_sq = 0;
+                for (unsigned int i = 0; i < tmpl_h; i++)
+                {
+                    column_sum += rows[i][x];
+                    column_sum_sq += rows[i][x] * rows[i][x];
+                }
+
+                sum[x + 1] = sum[x] + column_sum;
+                sum_sq[x + 1] = sum_sq[x] + column_sum_sq;
+            }
+        }
+
+        for (int x = min_x; x < max_x; x++)
         {
-            average_and_stddev(bg_img, x, y,
-                               tmpl_img->get_width(), tmpl_img->get_height(),
-                               &f_avg, &sigma_f);
+            const unsigned int window_x = x - min_x;
+
+            // population mean and standard deviation of the window, like average_and_stddev()
+            const double f_avg = (sum[window_x + tmpl_w] - sum[window_x]) / n;
+            const double variance = (sum_sq[window_x + tmpl_w] - sum_sq[window_x]) / n - f_avg * f_avg;
+
+            // the correlation is undefined for uniform windows
+            if (variance < 1e-9) continue;
+
+            const double sigma_f = sqrt(variance);
 
-            double xcorr = calc_xcorr(x, y,
-                                      bg_img, f_avg, sigma_f,
-                                      tmpl_img, t_avg, sigma_t);
+            double xcorr = calc_xcorr(rows, window_x, f_avg, sigma_f, tmpl, tmpl_w, t_avg, sigma_t);
 
             if (xcorr > threshold_match)
             {
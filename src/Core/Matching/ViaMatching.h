@@ -39,6 +39,7 @@ namespace degate
         double threshold_match;
         unsigned int via_diameter, merge_n_vias;
         BackgroundImage_shptr img;
+        GreyscaleBackgroundImage_shptr gs_img;
 
         BoundingBox bounding_box;
 
@@ -79,7 +80,8 @@ namespace degate
         void set_diameter(unsigned int diameter);
 
     private:
-        void scan(BoundingBox const& bbox, BackgroundImage_shptr bg_img,
+        template <typename BGImageType>
+        void scan(BoundingBox const& bbox, std::shared_ptr<BGImageType> bg_img,
                   MemoryImage_GS_BYTE_shptr tmpl_img, Via::DIRECTION direction);
 
         bool add_via(unsigned int x, unsigned int y,
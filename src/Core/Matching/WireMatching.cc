@@ -25,6 +25,7 @@
 #include "Core/Matching/CannyEdgeDetection.h"
 #include "Core/Matching/BinaryLineDetection.h"
 #include "Core/Primitive/BoundingBox.h"
+#include "Core/Utils/Trace.h"
 #include "Core/Matching/LineSegmentExtraction.h"
 #include "Core/Image/Manipulation/MedianFilter.h"
 #include <boost/foreach.hpp>
@@ -42,6 +43,8 @@ WireMatching::WireMatching() :
 
 void WireMatching::init(BoundingBox const& bounding_box, Project_shptr project)
 {
+    TRACE_SCOPE_CATEGORY("wire-matching/init", "matching");
+
     this->bounding_box = bounding_box;
 
     if (project == nullptr)
@@ -54,10 +57,10 @@ void WireMatching::init(BoundingBox const& bounding_box, Project_shptr project)
     if (layer == nullptr) throw DegateRuntimeException("No current layer in project.");
 
 
-    ScalingManager_shptr sm = layer->get_scaling_manager();
-    assert(sm != nullptr);
-
-    img = sm->get_image(1).second;
+    if (layer->get_image_format() == Layer::IMAGE_FORMAT_GS_BYTE)
+        img = layer->get_greyscale_image();
+    else
+        img = layer->get_image();
     assert(img != nullptr);
 }
 
@@ -84,6 +87,8 @@ void WireMatching::set_min_edge_magnitude(double min_edge_magnitude)
 
 void WireMatching::run()
 {
+    TRACE_SCOPE_CATEGORY("wire-matching/run", "matching");
+
     auto directory = create_temp_directory();
 
     ZeroCrossingEdgeDetection ed(bounding_box.get_min_x(),
@@ -36,7 +36,7 @@ namespace degate
         LogicModel_shptr lmodel;
         unsigned int wire_diameter, median_filter_width;
         double sigma, min_edge_magnitude;
-        BackgroundImage_shptr img;
+        ImageBase_shptr img; // the RGBA or greyscale background image
 
         BoundingBox bounding_box;
 
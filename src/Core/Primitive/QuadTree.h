@@ -373,7 +373,8 @@ namespace degate
         std::vector<T> objects;
         tree->get_all_elements(objects);
 
-        // Clear all subtrees
+        // Clear the node and all subtrees
+        tree->children.clear();
         tree->subtree_nodes.clear();
 
         // Reinsert all objects
@@ -25,8 +25,10 @@
 #include "Core/Utils/ObjectIDRewriter.h"
 #include "Core/LogicModel/LogicModelExporter.h"
 #include "Core/LogicModel/Gate/GateLibraryExporter.h"
+#include "Core/Matching/PreparedTemplateCache.h"
 #include "Core/RuleCheck/RCVBlacklistExporter.h"
 #include "Core/Version.h"
+#include "Core/Utils/Trace.h"
 
 #include <cerrno>
 #include <iostream>
@@ -44,6 +46,8 @@ void ProjectExporter::export_all(std::string const& project_directory, const Pro
                                  std::string const& gatelib_file,
                                  std::string const& rcbl_file)
 {
+    TRACE_SCOPE_CATEGORY("project/export-all", "io");
+
     if (!is_directory(project_directory))
     {
         throw InvalidPathException("The path where the project should be exported to is not a directory.");
@@ -76,8 +80,125 @@ void ProjectExporter::export_all(std::string const& project_directory, const Pro
     }
 }
 
+void ProjectExporter::export_incremental(std::string const& project_directory, const Project_shptr& prj,
+                                         std::string const& project_file,
+                                         std::string const& lmodel_file,
+                                         std::string const& journal_file,
+                                         std::string const& gatelib_file,
+                                         std::string const& rcbl_file)
+{
+    TRACE_SCOPE_CATEGORY("project/export-incremental", "io");
+
+    if (!is_directory(project_directory))
+    {
+        throw InvalidPathException("The path where the project should be exported to is not a directory.");
+    }
+
+    if (prj == nullptr) throw InvalidPointerException("Project pointer is nullptr.");
+
+    LogicModel_shptr lmodel = prj->get_logic_model();
+    if (lmodel == nullptr)
+    {
+        export_all(project_directory, prj, false, project_file, lmodel_file, gatelib_file, rcbl_file);
+        return;
+    }
+
+    LogicModelJournal_shptr journal = lmodel->get_journal();
+    string lm_filename(join_pathes(project_directory, lmodel_file));
+    string journal_filename(join_pathes(project_directory, journal_file));
+
+    if (!file_exists(lm_filename) || journal->needs_checkpoint(get_realpath(lm_filename)))
+    {
+        debug(TM, "Write a full checkpoint of the logic model.");
+
+        journal->begin_checkpoint();
+        export_all(project_directory, prj, false, project_file, lmodel_file, gatelib_file, rcbl_file);
+
+        // The new checkpoint has a new generation, so a stale journal would be skipped anyway.
+        if (file_exists(journal_filename)) remove_file(journal_filename);
+
+        journal->set_checkpoint(get_realpath(lm_filename));
+        return;
+    }
+
+    ObjectIDRewriter_shptr oid_rewriter(new ObjectIDRewriter(false));
+
+    export_data(join_pathes(project_directory, project_file), prj);
+
+    RCVBlacklistExporter rcv_exporter(oid_rewriter);
+    rcv_exporter.export_data(join_pathes(project_directory, rcbl_file), prj->get_rcv_blacklist());
+
+    // Template matching adds prepared templates without touching the journal. They are
+    // saved with the gate library, so a changed cache needs a new gate library as well.
+    GateLibrary_shptr glib = lmodel->get_gate_library();
+    bool prepared_templates_modified = false;
+
+    if (glib != nullptr)
+    {
+        for (auto const& entry : *glib)
+        {
+            if (entry.second->get_prepared_templates()->is_modified())
+                prepared_templates_modified = true;
+        }
+    }
+
+    if (glib != nullptr && (!journal->get_gate_templates().empty() || prepared_templates_modified))
+    {
+        GateLibraryExporter gl_exporter(oid_rewriter);
+        gl_exporter.export_data(join_pathes(project_directory, gatelib_file), glib);
+    }
+
+    if (journal->has_changes())
+    {
+        LogicModelExporter lm_exporter(oid_rewriter);
+        lm_exporter.export_journal_entry(journal_filename, lmodel);
+    }
+}
+
+void ProjectExporter::export_atomic(std::string const& project_directory, const Project_shptr& prj,
+                                    std::string const& project_file,
+                                    std::string const& lmodel_file,
+                                    std::string const& journal_file,
+                                    std::string const& gatelib_file,
+                                    std::string const& rcbl_file)
+{
+    TRACE_SCOPE_CATEGORY("project/export-atomic", "io");
+
+    if (!is_directory(project_directory))
+    {
+        throw InvalidPathException("The path where the project should be exported to is not a directory.");
+    }
+
+    if (prj == nullptr) throw InvalidPointerException("Project pointer is nullptr.");
+
+    const std::string suffix(".tmp");
+    const std::list<std::string> files = { project_file, lmodel_file, gatelib_file, rcbl_file };
+
+    LogicModel_shptr lmodel = prj->get_logic_model();
+    if (lmodel != nullptr) lmodel->get_journal()->begin_checkpoint();
+
+    export_all(project_directory, prj, false,
+               project_file + suffix, lmodel_file + suffix, gatelib_file + suffix, rcbl_file + suffix);
+
+    for (auto const& file : files)
+    {
+        const std::string tmp_filename(join_pathes(project_directory, file + suffix));
+        if (file_exists(tmp_filename)) move_file(tmp_filename, join_pathes(project_directory, file));
+    }
+
+    if (lmodel != nullptr)
+    {
+        const std::string journal_filename(join_pathes(project_directory, journal_file));
+        if (file_exists(journal_filename)) remove_file(journal_filename);
+
+        lmodel->get_journal()->set_checkpoint(get_realpath(join_pathes(project_directory, lmodel_file)));
+    }
+}
+
 void ProjectExporter::export_data(std::string const& filename, const Project_shptr& prj)
 {
+    TRACE_SCOPE_CATEGORY("project/export", "io");
+
     if (prj == nullptr) throw InvalidPointerException("Project pointer is nullptr.");
 
     try
@@ -231,9 +352,14 @@ void ProjectExporter::add_layers(QDomDocument& doc,
         layer_elem.setAttribute("enabled", QString::fromStdString(layer->is_enabled() ? "true" : "false"));
 
         if (layer->has_background_image())
+        {
             layer_elem.setAttribute("image-filename",
                                     QString::fromStdString(
                                         get_relative_path(layer->get_image_filename(), project_dir)));
+            layer_elem.setAttribute("image-format",
+                                    QString::fromStdString(
+                                        Layer::get_image_format_as_string(layer->get_image_format())));
+        }
 
         layers_elem.appendChild(layer_elem);
     }
@@ -80,6 +80,45 @@ namespace degate
                         std::string const& lmodel_file = "lmodel.xml",
                         std::string const& gatelib_file = "gate_library.xml",
                         std::string const& rcbl_file = "rc_blacklist.xml");
+
+        /**
+         * Save a project incrementally.
+         *
+         * Changes recorded in the logic model journal are appended to the journal file, instead
+         * of rewriting the whole logic model. A full checkpoint is written with export_all(), if
+         * there is no checkpoint in this directory yet, if the journal requests it or if the
+         * number of journal entries reached the compaction threshold. Checkpoints are written
+         * without object ID rewriting, because journal entries refer to the checkpoint's IDs.
+         *
+         * @exception InvalidPathException
+         * @exception InvalidPointerException
+         * @exception std::runtime_error
+         * @see LogicModelJournal
+         */
+        void export_incremental(std::string const& project_directory, const Project_shptr& prj,
+                                std::string const& project_file = "project.xml",
+                                std::string const& lmodel_file = "lmodel.xml",
+                                std::string const& journal_file = "lmodel.journal",
+                                std::string const& gatelib_file = "gate_library.xml",
+                                std::string const& rcbl_file = "rc_blacklist.xml");
+
+        /**
+         * Save a project as full checkpoint, without leaving half written files behind.
+         *
+         * All files are written under temporary names first and then renamed over the
+         * existing files. A crash while saving leaves the previous version of each file
+         * in place. The logic model journal is reset to the new checkpoint.
+         *
+         * @exception InvalidPathException
+         * @exception InvalidPointerException
+         * @exception std::runtime_error
+         */
+        void export_atomic(std::string const& project_directory, const Project_shptr& prj,
+                           std::string const& project_file = "project.xml",
+                           std::string const& lmodel_file = "lmodel.xml",
+                           std::string const& journal_file = "lmodel.journal",
+                           std::string const& gatelib_file = "gate_library.xml",
+                           std::string const& rcbl_file = "rc_blacklist.xml");
     };
 }
 
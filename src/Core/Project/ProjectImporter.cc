@@ -24,6 +24,7 @@
 #include "Core/LogicModel/LogicModelImporter.h"
 #include "Core/RuleCheck/RCVBlacklistImporter.h"
 #include "Core/LogicModel/LogicModelHelper.h"
+#include "Core/Utils/Trace.h"
 
 #include <cerrno>
 #include <iostream>
@@ -45,6 +46,8 @@ std::string ProjectImporter::get_project_filename(std::string const& dir)
 
 Project_shptr ProjectImporter::import_all(std::string const& directory)
 {
+    TRACE_SCOPE_CATEGORY("project/import-all", "io");
+
     Project_shptr prj = import(directory);
 
     if (prj != nullptr)
@@ -62,10 +65,22 @@ Project_shptr ProjectImporter::import_all(std::string const& directory)
 
         LogicModelImporter lm_importer(prj->get_width(), prj->get_height(), gate_lib);
 
-        lm_importer.import_into(prj->get_logic_model(),
-                                get_basedir(directory) + "/lmodel.xml");
+        std::string lmodel_file(get_basedir(directory) + "/lmodel.xml");
+        lm_importer.import_into(prj->get_logic_model(), lmodel_file);
 
         LogicModel_shptr lmodel = prj->get_logic_model();
+
+        // Replay changes, that were saved incrementally after the last full checkpoint.
+        bool journal_complete = true;
+        unsigned int journal_entries = lm_importer.replay_journal(lmodel, get_basedir(directory) + "/lmodel.journal",
+                                                                  journal_complete);
+
+        LogicModelJournal_shptr journal = lmodel->get_journal();
+        journal->set_checkpoint(get_realpath(lmodel_file));
+        journal->set_entry_count(journal_entries);
+
+        // A broken journal can't be appended to. The next save writes a full checkpoint instead.
+        if (!journal_complete) journal->require_checkpoint();
         lmodel->set_default_gate_port_diameter(prj->get_default_port_diameter());
 
         if (file_exists(rcbl_file))
@@ -108,6 +123,8 @@ Project_shptr ProjectImporter::import_all(std::string const& directory)
 
 Project_shptr ProjectImporter::import(std::string const& directory)
 {
+    TRACE_SCOPE_CATEGORY("project/import", "io");
+
     string filename = get_project_filename(directory);
     if (RET_IS_NOT_OK(check_file(filename)))
     {
@@ -173,6 +190,7 @@ void ProjectImporter::parse_layers_element(QDomElement const& layers_elem, const
             const std::string layer_description(layer_elem.attribute("description").toStdString());
             auto position = parse_number<unsigned int>(layer_elem, "position");
             const std::string layer_enabled_str = layer_elem.attribute("enabled").toStdString();
+            const std::string image_format_str = layer_elem.attribute("image-format").toStdString();
 
             Layer::LAYER_TYPE layer_type = Layer::get_layer_type_from_string(layer_type_str);
             auto layer_id = parse_number<layer_id_t>(layer_elem, "id", 0);
@@ -193,14 +211,20 @@ void ProjectImporter::parse_layers_element(QDomElement const& layers_elem, const
 
             lmodel->add_layer(position, new_layer);
 
-            load_background_image(new_layer, image_filename, prj);
+            // Projects without an image format have RGBA backgrounds.
+            Layer::IMAGE_FORMAT image_format = Layer::IMAGE_FORMAT_RGBA;
+            if (!image_format_str.empty())
+                image_format = Layer::get_image_format_from_string(image_format_str);
+
+            load_background_image(new_layer, image_filename, prj, image_format);
         }
     }
 }
 
 void ProjectImporter::load_background_image(const Layer_shptr& layer,
                                             std::string const& image_filename,
-                                            const Project_shptr& prj)
+                                            const Project_shptr& prj,
+                                            Layer::IMAGE_FORMAT image_format)
 {
     debug(TM, "try to load image [%s]", image_filename.c_str());
     if (!image_filename.empty())
@@ -217,6 +241,21 @@ void ProjectImporter::load_background_image(const Layer_shptr& layer,
 
             debug(TM, "project importer loads an tile based image from [%s]", image_path_to_load.c_str());
 
+            if (image_format == Layer::IMAGE_FORMAT_GS_BYTE)
+            {
+                GreyscaleBackgroundImage_shptr bg_image =
+                    load_degate_image<GreyscaleBackgroundImage>(prj->get_width(),
+                                                                prj->get_height(),
+                                                                image_path_to_load);
+
+                if (bg_image == nullptr)
+                    throw DegateRuntimeException("Failed to load the background image");
+
+                debug(TM, "Loading done.");
+                layer->set_image(bg_image);
+                return;
+            }
+
             BackgroundImage_shptr bg_image =
                 load_degate_image<BackgroundImage>(prj->get_width(),
                                                    prj->get_height(),
@@ -55,10 +55,12 @@ namespace degate
          * Load a background image and set it to the layer. In case of a conversion
          * from old  single file images to tile based images, the new image is stored
          * in the project directory.
+         * @param image_format The pixel format, the tile based image is stored in.
          */
         void load_background_image(const Layer_shptr& layer,
                                    std::string const& image_filename,
-                                   const Project_shptr& prj);
+                                   const Project_shptr& prj,
+                                   Layer::IMAGE_FORMAT image_format = Layer::IMAGE_FORMAT_RGBA);
 
     public:
         ProjectImporter()
@@ -20,8 +20,10 @@
  */
 
 #include "ERCNet.h"
+#include "Core/RuleCheck/RCExecutor.h"
 
 #include <memory>
+#include <set>
 
 using namespace degate;
 
@@ -33,24 +35,111 @@ ERCNet::ERCNet() :
 void ERCNet::run(LogicModel_shptr lmodel)
 {
     clear_rc_violations();
+    violations_by_net.clear();
 
     if (lmodel == nullptr) return;
 
     // iterate over nets
+    std::vector<Net_shptr> nets;
     for (LogicModel::net_collection::iterator net_iter = lmodel->nets_begin();
          net_iter != lmodel->nets_end(); ++net_iter)
     {
-        check_net(lmodel, (*net_iter).second);
+        nets.push_back((*net_iter).second);
     }
+
+    check_nets(lmodel, nets);
+}
+
+void ERCNet::run_incremental(LogicModel_shptr lmodel, LogicModelJournal const& changes)
+{
+    if (lmodel == nullptr || !changes.get_gate_templates().empty())
+    {
+        run(lmodel);
+        return;
+    }
+
+    std::set<object_id_t> dirty(changes.get_nets());
+
+    for (object_id_t oid : changes.get_objects())
+    {
+        PlacedLogicModelObject_shptr plo;
+        try
+        {
+            plo = lmodel->get_object(oid);
+        }
+        catch (CollectionLookupException const&)
+        {
+            // Removed object, its net was recorded on removal.
+            continue;
+        }
+
+        if (Gate_shptr gate = object_kind_cast<Gate>(plo))
+        {
+            for (Gate::port_const_iterator p_iter = gate->ports_begin();
+                 p_iter != gate->ports_end(); ++p_iter)
+            {
+                if ((*p_iter)->get_net() != nullptr) dirty.insert((*p_iter)->get_net()->get_object_id());
+            }
+        }
+        else if (ConnectedLogicModelObject_shptr clo = object_kind_cast<ConnectedLogicModelObject>(plo))
+        {
+            if (clo->get_net() != nullptr) dirty.insert(clo->get_net()->get_object_id());
+        }
+    }
+
+    std::vector<Net_shptr> nets;
+    for (object_id_t net_id : dirty)
+    {
+        violations_by_net.erase(net_id);
+
+        try
+        {
+            nets.push_back(lmodel->get_net(net_id));
+        }
+        catch (CollectionLookupException const&)
+        {
+            // removed net
+        }
+    }
+
+    check_nets(lmodel, nets);
 }
 
-void ERCNet::check_net(LogicModel_shptr lmodel, Net_shptr net)
+void ERCNet::check_nets(LogicModel_shptr lmodel, std::vector<Net_shptr> const& nets)
+{
+    container_type violations;
+
+    RCExecutor::run(nets.size(), [this, &lmodel, &nets](size_t i, container_type& buffer)
+    {
+        check_net(lmodel, nets[i], buffer);
+    }, violations);
+
+    // All violations refer to a gate port of the checked net.
+    for (auto& violation : violations)
+    {
+        GatePort_shptr gate_port = object_kind_cast<GatePort>(violation->get_object());
+        assert(gate_port != nullptr && gate_port->get_net() != nullptr);
+
+        violations_by_net[gate_port->get_net()->get_object_id()].push_back(violation);
+    }
+
+    clear_rc_violations();
+    for (auto& entry : violations_by_net)
+    {
+        for (auto& violation : entry.second) add_rc_violation(violation);
+    }
+}
+
+void ERCNet::check_net(LogicModel_shptr lmodel, Net_shptr net, container_type& violations) const
 {
     unsigned int
         in_ports = 0,
         out_ports = 0,
         inout_ports = 0;
 
+    // Remember the gate ports, so that the second pass needs no object lookups.
+    std::vector<GatePort_shptr> gate_ports;
+
     // iterate over all objects from a net
     for (Net::connection_iterator c_iter = net->begin();
          c_iter != net->end(); ++c_iter)
@@ -59,12 +148,14 @@ void ERCNet::check_net(LogicModel_shptr lmodel, Net_shptr net)
 
         PlacedLogicModelObject_shptr plo = lmodel->get_object(oid);
 
-        if (GatePort_shptr gate_port = std::dynamic_pointer_cast<GatePort>(plo))
+        if (GatePort_shptr gate_port = object_kind_cast<GatePort>(plo))
         {
             assert(gate_port->has_template_port() == true); // can't happen
 
             if (gate_port->has_template_port())
             {
+                gate_ports.push_back(gate_port);
+
                 GateTemplatePort_shptr tmpl_port = gate_port->get_template_port();
                 // Count in- and out-ports. Inout-ports must be counted first, because is_*port() will return true
                 // for inout-ports.
@@ -73,9 +164,9 @@ void ERCNet::check_net(LogicModel_shptr lmodel, Net_shptr net)
                 else if (tmpl_port->is_outport()) out_ports++;
                 else
                 {
-                    add_rc_violation(std::make_shared<RCViolation>(gate_port,
-                                                                   "net.undefined_port_direction",
-                                                                   get_severity()));
+                    violations.push_back(std::make_shared<RCViolation>(gate_port,
+                                                                       "net.undefined_port_direction",
+                                                                       get_severity()));
                 }
             }
         }
@@ -83,29 +174,23 @@ void ERCNet::check_net(LogicModel_shptr lmodel, Net_shptr net)
 
     if ((in_ports > 0 && out_ports == 0) || (out_ports > 1))
     {
-        for (auto c_iter = net->begin();
-             c_iter != net->end(); ++c_iter)
+        for (auto& gate_port : gate_ports)
         {
-            object_id_t oid = *c_iter;
-            PlacedLogicModelObject_shptr plo = lmodel->get_object(oid);
-            if (GatePort_shptr gate_port = std::dynamic_pointer_cast<GatePort>(plo))
-            {
-                GateTemplatePort_shptr tmpl_port = gate_port->get_template_port();
+            GateTemplatePort_shptr tmpl_port = gate_port->get_template_port();
 
-                if (in_ports > 0 && out_ports == 0)
-                {
-                    add_rc_violation(std::make_shared<RCViolation>(gate_port,
+            if (in_ports > 0 && out_ports == 0)
+            {
+                violations.push_back(std::make_shared<RCViolation>(gate_port,
                                                                    "net.not_feeded",
                                                                    get_severity()));
-                }
-                else if (out_ports > 1)
+            }
+            else if (out_ports > 1)
+            {
+                if (tmpl_port->is_outport())
                 {
-                    if (tmpl_port->is_outport())
-                    {
-                        add_rc_violation(std::make_shared<RCViolation>(gate_port,
+                    violations.push_back(std::make_shared<RCViolation>(gate_port,
                                                                        "net.outputs_connected",
                                                                        get_severity()));
-                    }
                 }
             }
         }
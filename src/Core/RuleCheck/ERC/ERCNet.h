@@ -28,6 +28,9 @@
 #include "Core/LogicModel/LogicModel.h"
 #include "Core/RuleCheck/RCBase.h"
 
+#include <map>
+#include <vector>
+
 namespace degate
 {
     /**
@@ -54,13 +57,26 @@ namespace degate
 
         ERCNet();
 
-        void run(LogicModel_shptr lmodel);
+        void run(LogicModel_shptr lmodel) override;
+
+        /**
+         * Re-check touched nets and the nets of touched objects. If gate templates were
+         * touched, port directions may have changed everywhere and all nets are checked.
+         */
+        void run_incremental(LogicModel_shptr lmodel, LogicModelJournal const& changes) override;
 
         std::string generate_description(const RCViolation& violation) override;
 
     private:
 
-        void check_net(LogicModel_shptr lmodel, Net_shptr net);
+        /**
+         * Violations of the last run, grouped by the net ID.
+         */
+        std::map<object_id_t, container_type> violations_by_net;
+
+        void check_nets(LogicModel_shptr lmodel, std::vector<Net_shptr> const& nets);
+
+        void check_net(LogicModel_shptr lmodel, Net_shptr net, container_type& violations) const;
     };
 }
 
@@ -21,8 +21,10 @@
 
 #include "ERCOpenPorts.h"
 #include "Core/RuleCheck/RCBase.h"
+#include "Core/RuleCheck/RCExecutor.h"
 
 #include <memory>
+#include <set>
 
 
 using namespace degate;
@@ -41,6 +43,8 @@ void ERCOpenPorts::run(LogicModel_shptr lmodel)
     // iterate over Gates
     debug(TM, "\tRC: iterate over gates.");
 
+    std::vector<GatePort_shptr> ports;
+
     for (LogicModel::gate_collection::iterator g_iter = lmodel->gates_begin();
          g_iter != lmodel->gates_end(); ++g_iter)
     {
@@ -49,15 +53,102 @@ void ERCOpenPorts::run(LogicModel_shptr lmodel)
         for (Gate::port_const_iterator p_iter = gate->ports_begin();
              p_iter != gate->ports_end(); ++p_iter)
         {
-            GatePort_shptr port = *p_iter;
-            assert(port != nullptr);
+            assert(*p_iter != nullptr);
+            ports.push_back(*p_iter);
+        }
+    }
+
+    check_ports(ports);
+}
+
+void ERCOpenPorts::run_incremental(LogicModel_shptr lmodel, LogicModelJournal const& changes)
+{
+    if (lmodel == nullptr)
+    {
+        run(lmodel);
+        return;
+    }
 
-            Net_shptr net = port->get_net();
-            if (net == nullptr || net->size() <= 1)
+    // Collect the IDs of all ports, whose state might have changed. Objects removed from a
+    // net are recorded by the logic model, so touched nets only need their current members.
+    std::set<object_id_t> dirty(changes.get_objects());
+
+    for (object_id_t oid : changes.get_objects())
+    {
+        try
+        {
+            if (Gate_shptr gate = std::dynamic_pointer_cast<Gate>(lmodel->get_object(oid)))
             {
-                add_rc_violation(std::make_shared<RCViolation>(port, "open_port", get_severity()));
+                for (Gate::port_const_iterator p_iter = gate->ports_begin();
+                     p_iter != gate->ports_end(); ++p_iter)
+                    dirty.insert((*p_iter)->get_object_id());
             }
         }
+        catch (CollectionLookupException const&)
+        {
+            // removed object
+        }
+    }
+
+    for (object_id_t net_id : changes.get_nets())
+    {
+        try
+        {
+            Net_shptr net = lmodel->get_net(net_id);
+            dirty.insert(net->begin(), net->end());
+        }
+        catch (CollectionLookupException const&)
+        {
+            // removed net
+        }
+    }
+
+    // keep the violations of untouched ports
+    container_type violations = get_rc_violations();
+    clear_rc_violations();
+
+    for (auto& violation : violations)
+    {
+        if (dirty.find(violation->get_object()->get_object_id()) == dirty.end())
+            add_rc_violation(violation);
+    }
+
+    std::vector<GatePort_shptr> ports;
+
+    for (object_id_t oid : dirty)
+    {
+        try
+        {
+            if (GatePort_shptr port = std::dynamic_pointer_cast<GatePort>(lmodel->get_object(oid)))
+                ports.push_back(port);
+        }
+        catch (CollectionLookupException const&)
+        {
+            // removed object
+        }
+    }
+
+    check_ports(ports);
+}
+
+void ERCOpenPorts::check_ports(std::vector<GatePort_shptr> const& ports)
+{
+    container_type violations;
+
+    RCExecutor::run(ports.size(), [this, &ports](size_t i, container_type& buffer)
+    {
+        check_port(ports[i], buffer);
+    }, violations);
+
+    for (auto& violation : violations) add_rc_violation(violation);
+}
+
+void ERCOpenPorts::check_port(GatePort_shptr port, container_type& violations) const
+{
+    Net_shptr net = port->get_net();
+    if (net == nullptr || net->size() <= 1)
+    {
+        violations.push_back(std::make_shared<RCViolation>(port, "open_port", get_severity()));
     }
 }
 
@@ -25,6 +25,8 @@
 #include "Core/RuleCheck/RCBase.h"
 #include "Core/LogicModel/LogicModel.h"
 
+#include <vector>
+
 namespace degate
 {
     /**
@@ -41,7 +43,18 @@ namespace degate
 
         void run(LogicModel_shptr lmodel) override;
 
+        /**
+         * Re-check the ports of touched gates and the ports connected to touched nets.
+         */
+        void run_incremental(LogicModel_shptr lmodel, LogicModelJournal const& changes) override;
+
         std::string generate_description(const RCViolation& violation) override;
+
+    private:
+
+        void check_ports(std::vector<GatePort_shptr> const& ports);
+
+        void check_port(GatePort_shptr port, container_type& violations) const;
     };
 }
 
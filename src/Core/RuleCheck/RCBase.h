@@ -85,6 +85,18 @@ namespace degate
          */
         virtual void run(LogicModel_shptr lmodel) = 0;
 
+        /**
+         * Re-check only what was touched since the last run. The default
+         * implementation just runs the full check.
+         * @param lmodel The logic model, that was checked by the last run().
+         * @param changes The objects, nets and gate templates, that were touched
+         *   since the last run.
+         */
+        virtual void run_incremental(LogicModel_shptr lmodel, LogicModelJournal const& changes)
+        {
+            run(lmodel);
+        }
+
         /**
          * Generate the description for a violation regarding the tuple class + object.
          * A violation needs to be unique for that tuple.
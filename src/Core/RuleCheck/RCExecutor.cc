@@ -0,0 +1,93 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/RuleCheck/RCExecutor.h"
+#include "Core/RuleCheck/RCBase.h"
+
+#include <boost/range/counting_range.hpp>
+#include <QThread>
+#include <QtConcurrent/QtConcurrent>
+
+#include <exception>
+#include <mutex>
+#include <vector>
+
+using namespace degate;
+
+// Below this number of items per shard the thread pool overhead dominates.
+#define RC_MIN_ITEMS_PER_SHARD 256
+
+size_t RCExecutor::get_shard_count(size_t count)
+{
+    // Some more shards than threads, in order to balance nets of different sizes.
+    const size_t max_shards = static_cast<size_t>(std::max(QThread::idealThreadCount(), 1)) * 4;
+
+    size_t shards = count / RC_MIN_ITEMS_PER_SHARD;
+    if (shards > max_shards) shards = max_shards;
+
+    return shards > 0 ? shards : 1;
+}
+
+void RCExecutor::run(size_t count, task_type const& task, RCVContainer& violations)
+{
+    if (count == 0) return;
+
+    const size_t shards = get_shard_count(count);
+
+    if (shards == 1)
+    {
+        for (size_t i = 0; i < count; i++) task(i, violations);
+        return;
+    }
+
+    std::vector<RCVContainer> buffers(shards);
+
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    // Multi-threaded function
+    std::function<void(const size_t& shard)> function = [&](const size_t& shard)
+    {
+        const size_t begin = shard * count / shards;
+        const size_t end = (shard + 1) * count / shards;
+
+        try
+        {
+            for (size_t i = begin; i < end; i++) task(i, buffers[shard]);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error) error = std::current_exception();
+        }
+    };
+
+    // Start multithreading
+    const auto& it = boost::counting_range<size_t>(0, shards);
+    QtConcurrent::blockingMap(it, function);
+
+    if (error) std::rethrow_exception(error);
+
+    for (auto& buffer : buffers)
+    {
+        for (auto& violation : buffer) violations.push_back(violation);
+    }
+}
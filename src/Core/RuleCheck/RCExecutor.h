@@ -0,0 +1,65 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __RCEXECUTOR_H__
+#define __RCEXECUTOR_H__
+
+#include "Core/RuleCheck/RCVContainer.h"
+
+#include <functional>
+#include <cstddef>
+
+namespace degate
+{
+    /**
+     * Runs rule checks on the global thread pool.
+     *
+     * The items to check (e.g. nets or gate ports) are split into contiguous shards.
+     * Each shard writes its violations into its own buffer, so no locking is needed
+     * while checking. The buffers are merged in shard order afterwards, therefore the
+     * order of the result does not depend on the thread scheduling.
+     *
+     * The check task must only read from the logic model.
+     */
+    class RCExecutor
+    {
+    public:
+
+        /**
+         * A check task. It checks the item with index \p index and adds
+         * violations to \p violations.
+         */
+        typedef std::function<void(size_t index, RCVContainer& violations)> task_type;
+
+        /**
+         * Run \p task for each index in [0, count) and append all violations to \p violations.
+         * Exceptions thrown by the task are rethrown in the calling thread.
+         */
+        static void run(size_t count, task_type const& task, RCVContainer& violations);
+
+        /**
+         * Get the number of shards used to check \p count items.
+         */
+        static size_t get_shard_count(size_t count);
+    };
+}
+
+#endif
@@ -27,6 +27,13 @@
 
 namespace degate
 {
+    /**
+     * Runs all registered rule checks.
+     *
+     * After a first full run, the rule checker follows the changes of the logic model
+     * (via an attached LogicModelJournal), so that run_incremental() only needs to
+     * re-check what was touched in between.
+     */
     class RuleChecker
     {
     private:
@@ -34,9 +41,12 @@ namespace degate
         std::list<RCBase_shptr> checks;
         RCVContainer rc_violations;
 
+        LogicModelJournal_shptr changes;
+        std::weak_ptr<LogicModelJournal> observed_journal;
+
     public:
 
-        RuleChecker()
+        RuleChecker() : changes(std::make_shared<LogicModelJournal>())
         {
             for (auto& e : ERC_REGISTER.get_erc_list())
             {
@@ -44,22 +54,52 @@ namespace degate
             }
         }
 
+        ~RuleChecker()
+        {
+            if (LogicModelJournal_shptr journal = observed_journal.lock())
+                journal->detach(changes);
+        }
+
+        /**
+         * Run all rule checks on the whole logic model.
+         */
         void run(LogicModel_shptr lmodel)
         {
             debug(TM, "run RC");
 
-            rc_violations.clear();
-
             BOOST_FOREACH(RCBase_shptr check, checks)
             {
                 check->run(lmodel);
-                BOOST_FOREACH(RCViolation_shptr violation, check->get_rc_violations())
+            }
+
+            observe(lmodel);
+            collect_violations();
+        }
+
+        /**
+         * Re-check only the parts of the logic model, that were touched since the last run.
+         * If \p lmodel was not checked before, a full run is done.
+         */
+        void run_incremental(LogicModel_shptr lmodel)
+        {
+            if (lmodel == nullptr || observed_journal.lock() != lmodel->get_journal())
+            {
+                run(lmodel);
+                return;
+            }
+
+            debug(TM, "run incremental RC");
+
+            if (changes->has_changes())
+            {
+                BOOST_FOREACH(RCBase_shptr check, checks)
                 {
-                    rc_violations.push_back(violation);
+                    check->run_incremental(lmodel, *changes);
                 }
             }
 
-            debug(TM, "found %lu rc violations.", rc_violations.size());
+            changes->clear();
+            collect_violations();
         }
 
         /**
@@ -69,6 +109,40 @@ namespace degate
         {
             return rc_violations;
         }
+
+    private:
+
+        /**
+         * Start following the changes of \p lmodel.
+         */
+        void observe(LogicModel_shptr lmodel)
+        {
+            changes->clear();
+
+            if (LogicModelJournal_shptr journal = observed_journal.lock())
+                journal->detach(changes);
+            observed_journal.reset();
+
+            if (lmodel == nullptr) return;
+
+            lmodel->get_journal()->attach(changes);
+            observed_journal = lmodel->get_journal();
+        }
+
+        void collect_violations()
+        {
+            rc_violations.clear();
+
+            BOOST_FOREACH(RCBase_shptr check, checks)
+            {
+                BOOST_FOREACH(RCViolation_shptr violation, check->get_rc_violations())
+                {
+                    rc_violations.push_back(violation);
+                }
+            }
+
+            debug(TM, "found %lu rc violations.", rc_violations.size());
+        }
     };
 }
 
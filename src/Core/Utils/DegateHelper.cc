@@ -24,6 +24,7 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <iomanip>
 
 using namespace degate;
 using namespace std;
@@ -69,3 +70,28 @@ void degate::write_string_to_file(std::string const& path,
     file << content;
     file.close();
 }
+
+std::string degate::json_string(std::string const& str)
+{
+    std::ostringstream os;
+    os << '"';
+
+    for (char c : str)
+    {
+        switch (c)
+        {
+        case '"': os << "\\\""; break;
+        case '\\': os << "\\\\"; break;
+        case '\n': os << "\\n"; break;
+        case '\r': os << "\\r"; break;
+        case '\t': os << "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+                os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+            else os << c;
+        }
+    }
+
+    os << '"';
+    return os.str();
+}
@@ -56,6 +56,12 @@ namespace degate
     void write_string_to_file(std::string const& path,
                               std::string const& content);
 
+    /**
+     * Quote and escape a string for JSON.
+     * Control characters are written as escape sequences.
+     */
+    std::string json_string(std::string const& str);
+
 }
 
 #endif
@@ -61,6 +61,7 @@ namespace degate
         MAP_STORAGE_TYPE_MEM = 0,
         MAP_STORAGE_TYPE_PERSISTENT_FILE = 1,
         MAP_STORAGE_TYPE_TEMP_FILE = 2,
+        MAP_STORAGE_TYPE_VIEW = 3,
     };
 
 
@@ -90,6 +91,9 @@ namespace degate
         fd file;
         T* mem_view;
 
+        // Keeps the memory of a view alive.
+        std::shared_ptr<void> view_owner;
+
     private:
         ret_t alloc_memory();
         ret_t map_file(std::string const& filename);
@@ -133,6 +137,17 @@ namespace degate
         MemoryMap(unsigned int width, unsigned int height,
                   MAP_STORAGE_TYPE mode, std::string const& file_to_map);
 
+        /**
+         * Create a view on memory, that is owned by another object (e.g. a part
+         * of a larger mapping). Nothing is allocated or mapped.
+         * @param width The width of a 2D map.
+         * @param height The height of a 2D map.
+         * @param view The memory with at least \p width * \p height elements.
+         * @param owner The object that owns \p view. It is kept alive as long as the view exists.
+         */
+        MemoryMap(unsigned int width, unsigned int height,
+                  T* view, std::shared_ptr<void> owner);
+
         /**
          * The destructor.
          */
@@ -235,6 +250,26 @@ namespace degate
     }
 
 
+    template <typename T>
+    MemoryMap<T>::MemoryMap(unsigned int width, unsigned int height,
+                            T* view, std::shared_ptr<void> owner) :
+        width(width), height(height),
+        storage_type(MAP_STORAGE_TYPE_VIEW),
+        filename(),
+        filesize(0),
+        mem_size(width * height * sizeof(T)),
+        file(0),
+#ifdef SYS_WINDOWS
+        mem_file(nullptr),
+#endif
+        mem_view(view),
+        view_owner(owner)
+    {
+        assert(width > 0 && height > 0);
+        assert(view != nullptr);
+    }
+
+
     template <typename T>
     MemoryMap<T>::~MemoryMap()
     {
@@ -257,6 +292,12 @@ namespace degate
 
             remove_file(filename);
 
+            break;
+        case MAP_STORAGE_TYPE_VIEW:
+
+            mem_view = nullptr;
+            view_owner.reset();
+
             break;
         }
     }
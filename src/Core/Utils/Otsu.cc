@@ -39,17 +39,10 @@ double Otsu::get_otsu_threshold()
 
 void Otsu::run(TileImage_GS_DOUBLE_shptr gray)
 {
-    unsigned long hist_data[256] = {0,};
+    RegionStatistics stats = calculate_statistics<TileImage_GS_DOUBLE>(gray);
+    RegionStatistics::histogram_type const& hist_data = stats.get_histogram();
 
-    for (unsigned int y = 0; y < gray->get_height(); y++)
-        for (unsigned int x = 0; x < gray->get_width(); x++)
-        {
-            gs_byte_pixel_t h = gray->get_pixel_as<gs_byte_pixel_t>(x, y);
-            assert((h >= 0) && (h < 256));
-            hist_data[h]++;
-        }
-
-    unsigned long total = static_cast<unsigned long>(gray->get_height()) * static_cast<unsigned long>(gray->get_width());
+    unsigned long total = static_cast<unsigned long>(stats.get_count());
 
     double sum = 0;
     for (int t = 0; t < 256; t++)
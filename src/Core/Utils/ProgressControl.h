@@ -23,137 +23,286 @@
 #define __PROGRESSCONTROL_H__
 
 #include <memory>
+#include <new>
 #include <ctime>
-#include <boost/thread.hpp>
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+
+/**
+ * Size of a cache line in bytes. Step counters of different threads never share one.
+ */
+#define PROGRESS_CONTROL_CACHE_LINE_SIZE 64
 
 namespace degate
 {
+    /**
+     * Progress reporting and cancellation of long running jobs.
+     *
+     * A job reports its progress, while other threads (e.g. a progress dialog) read it
+     * and may cancel the job. Reporting a step and checking for cancellation are lock-free,
+     * so they can be called from many worker threads at once:
+     *
+     * - Finished steps are counted in per-thread slots, each aligned to its own cache
+     *   line. They are summed up on read. Workers therefore never contend on a shared
+     *   counter.
+     * - The cancel flag is a single atomic. Checking it costs a relaxed load, so workers
+     *   can check it often and stop within a bounded latency.
+     *
+     * Parts of a job can report on their own sub progress (@see create_sub_progress()).
+     * The progress of sub progresses is weighted and added on read, and canceling a
+     * progress cancels its sub progresses as well.
+     *
+     * The time left is estimated from the rate of progress, smoothed over the calls
+     * of get_time_left(). This follows changes in speed better than the overall average.
+     */
     class ProgressControl
     {
     private:
 
-        const static int averaging_buf_size = 5;
+        typedef std::chrono::steady_clock clock_type;
+
+        /**
+         * Number of step counters. Threads beyond that share counters.
+         */
+        const static unsigned int slot_count = 64;
+
+        /**
+         * Minimum time between two samples of the progress rate in seconds.
+         */
+        constexpr static double rate_sample_interval = 0.5;
+
+        /**
+         * Smoothing factor of the progress rate (weight of the newest sample).
+         */
+        constexpr static double rate_smoothing = 0.3;
+
+        /**
+         * A step counter, aligned to its own cache line.
+         */
+        struct alignas(PROGRESS_CONTROL_CACHE_LINE_SIZE) ProgressSlot
+        {
+            std::atomic<uint_fast64_t> steps;
+        };
 
-        double progress;
-        bool canceled;
+        struct SubProgress
+        {
+            std::shared_ptr<ProgressControl> progress;
+            double weight;
+        };
 
-        double step_size;
-        time_t time_started;
+        // C++11 new does not align beyond the fundamental alignment, so the step counters
+        // are placed into a buffer with one cache line of slack instead of being a member array.
+        std::unique_ptr<char[]> step_counter_storage;
+        ProgressSlot* step_counters;
 
-        time_t estimated[averaging_buf_size];
-        int estimated_idx;
+        std::atomic<double> base_progress;
+        std::atomic<double> step_size;
+        std::atomic<bool> canceled;
+        std::atomic<clock_type::rep> time_started;
+
+        std::vector<SubProgress> sub_progress;
+        std::mutex sub_progress_mutex;
+
+        double rate;
+        double rate_last_progress;
+        clock_type::time_point rate_last_sample;
+        std::mutex rate_mutex;
 
         std::string log_message;
         bool log_message_set;
-
-        boost::recursive_mutex mtx;
+        std::mutex log_mutex;
 
     private:
 
-        time_t get_time_left_averaged()
+        /**
+         * Get the step counter of the calling thread.
+         */
+        static unsigned int get_slot_index()
+        {
+            static std::atomic<unsigned int> next_slot(0);
+            static thread_local unsigned int slot = next_slot.fetch_add(1, std::memory_order_relaxed) % slot_count;
+            return slot;
+        }
+
+        /**
+         * Fold the counted steps into the base progress.
+         */
+        void fold_steps()
         {
-            estimated[estimated_idx++] = get_time_left();
-            estimated_idx %= averaging_buf_size;
+            uint_fast64_t steps = 0;
+            for (unsigned int i = 0; i < slot_count; i++)
+                steps += step_counters[i].steps.exchange(0, std::memory_order_relaxed);
 
-            unsigned int sum = 0, valid_values = 0;
-            for (int i = 0; i < averaging_buf_size; i++)
-                if (estimated[i] != -1)
-                {
-                    sum += static_cast<unsigned int>(estimated[i]);
-                    valid_values++;
-                }
+            base_progress.store(base_progress.load() + static_cast<double>(steps) * step_size.load());
+        }
 
-            return valid_values > 0 ? sum / valid_values : get_time_left();
+        void reset_rate()
+        {
+            std::lock_guard<std::mutex> lock(rate_mutex);
+            rate = 0;
+            rate_last_progress = 0;
+            rate_last_sample = clock_type::now();
         }
 
-    protected:
+    public:
+
+        /**
+         * The constructor
+         */
+        ProgressControl() :
+            step_counter_storage(new char[(slot_count + 1) * sizeof(ProgressSlot)]),
+            step_size(0),
+            log_message_set(false)
+        {
+            void* storage = step_counter_storage.get();
+            std::size_t space = (slot_count + 1) * sizeof(ProgressSlot);
+            storage = std::align(alignof(ProgressSlot), slot_count * sizeof(ProgressSlot), storage, space);
+
+            step_counters = static_cast<ProgressSlot*>(storage);
+            for (unsigned int i = 0; i < slot_count; i++)
+                new (&step_counters[i]) ProgressSlot();
+
+            reset_progress();
+        }
 
         /**
-         * Set progress.
+         * The destructor for a plugin.
+         */
+        virtual ~ProgressControl()
+        {
+        }
+
+        /**
+         * Set progress. Steps done so far are dropped.
+         * @param progress A value between 0 and 1.
          */
         virtual void set_progress(double progress)
         {
-            boost::recursive_mutex::scoped_lock lock(this->mtx);
-            this->progress = progress;
+            for (unsigned int i = 0; i < slot_count; i++)
+                step_counters[i].steps.store(0, std::memory_order_relaxed);
+
+            base_progress.store(progress);
         }
 
         /**
-         * Set step size.
+         * Set step size. Steps done so far are kept with their old size.
+         * Set the step size before workers start to report steps.
          */
         virtual void set_progress_step_size(double step_size)
         {
-            boost::recursive_mutex::scoped_lock lock(this->mtx);
-            this->step_size = step_size;
+            fold_steps();
+            this->step_size.store(step_size);
         }
 
         /**
-         * Increase progress.
+         * Increase progress by one step. This is lock-free and can be called from
+         * several threads at once.
          */
         virtual void progress_step_done()
         {
-            boost::recursive_mutex::scoped_lock lock(this->mtx);
-            progress += step_size;
+            step_counters[get_slot_index()].steps.fetch_add(1, std::memory_order_relaxed);
         }
 
         /**
-         * Reset progress and cancel state.
+         * Increase progress by several steps at once. Workers with very small steps
+         * can use this to report in batches.
          */
-        virtual void reset_progress()
+        virtual void progress_steps_done(uint_fast64_t steps)
         {
-            boost::recursive_mutex::scoped_lock lock(this->mtx);
-            time_started = time(nullptr);
-            canceled = false;
-            progress = 0;
-
-            for (int i = 0; i < averaging_buf_size; i++) estimated[i] = -1;
-
-            estimated_idx = 0;
+            step_counters[get_slot_index()].steps.fetch_add(steps, std::memory_order_relaxed);
         }
 
-    public:
+        /**
+         * Create a sub progress, that covers a part of this progress. It can be passed to
+         * a part of the job (e.g. one of several workers), that reports on it on its own.
+         * @param weight The share of the sub progress in this progress (between 0 and 1).
+         * @see add_sub_progress()
+         */
+        std::shared_ptr<ProgressControl> create_sub_progress(double weight)
+        {
+            std::shared_ptr<ProgressControl> sub = std::make_shared<ProgressControl>();
+            add_sub_progress(sub, weight);
+            return sub;
+        }
 
         /**
-         * The constructor
+         * Add an existing progress as sub progress. Its progress is weighted with
+         * \p weight and added to this progress. Canceling this progress cancels the
+         * sub progress too. Sub progresses are dropped by reset_progress().
          */
-        ProgressControl() : log_message_set(false)
+        void add_sub_progress(std::shared_ptr<ProgressControl> sub, double weight)
         {
-            reset_progress();
+            if (sub == nullptr || sub.get() == this) return;
+
+            std::lock_guard<std::mutex> lock(sub_progress_mutex);
+            sub_progress.push_back({sub, weight});
+
+            if (is_canceled()) sub->cancel();
         }
 
         /**
-         * The destructor for a plugin.
+         * Reset progress and cancel state. This drops all sub progresses.
          */
-        virtual ~ProgressControl()
+        virtual void reset_progress()
         {
+            time_started.store(clock_type::now().time_since_epoch().count());
+            canceled.store(false);
+            set_progress(0);
+
+            {
+                std::lock_guard<std::mutex> lock(sub_progress_mutex);
+                sub_progress.clear();
+            }
+
+            reset_rate();
         }
 
         /**
-         * Check if the process is canceled.
+         * Check if the process is canceled. This is lock-free and cheap enough to be
+         * called in inner loops.
          */
         virtual bool is_canceled()
         {
-            boost::recursive_mutex::scoped_lock lock(this->mtx);
-            return canceled;
+            return canceled.load(std::memory_order_relaxed);
         }
 
         /**
-         * Stop the processing.
+         * Stop the processing. This cancels all sub progresses too.
          */
         virtual void cancel()
         {
-            boost::recursive_mutex::scoped_lock lock(this->mtx);
-            canceled = true;
+            canceled.store(true);
+
+            std::lock_guard<std::mutex> lock(sub_progress_mutex);
+            for (auto& sub : sub_progress) sub.progress->cancel();
         }
 
 
         /**
-         * Get progress.
-         * @return Returns a value between 0 and 100 percent.
+         * Get progress. This sums up the steps of all threads and the weighted
+         * progress of all sub progresses.
+         * @return Returns a value between 0 and 1.
          */
         virtual double get_progress()
         {
-            boost::recursive_mutex::scoped_lock lock(this->mtx);
-            return progress;
+            uint_fast64_t steps = 0;
+            for (unsigned int i = 0; i < slot_count; i++)
+                steps += step_counters[i].steps.load(std::memory_order_relaxed);
+
+            double progress = base_progress.load() + static_cast<double>(steps) * step_size.load();
+
+            {
+                std::lock_guard<std::mutex> lock(sub_progress_mutex);
+                for (auto& sub : sub_progress) progress += sub.weight * sub.progress->get_progress();
+            }
+
+            return std::max(0.0, std::min(progress, 1.0));
         }
 
         /**
@@ -161,27 +310,58 @@ namespace degate
          */
         virtual time_t get_time_passed()
         {
-            boost::recursive_mutex::scoped_lock lock(this->mtx);
-            return time(nullptr) - time_started;
+            const clock_type::duration passed = clock_type::now().time_since_epoch() -
+                                                clock_type::duration(time_started.load());
+
+            return static_cast<time_t>(std::chrono::duration_cast<std::chrono::seconds>(passed).count());
         }
 
         /**
-         * Get estimated time left in seconds.
+         * Get estimated time left in seconds. The estimation is based on the rate of
+         * progress, smoothed over the calls of this function. Call it regularly (e.g. once
+         * per second) for a stable estimation.
          * @return Returns the time to go in seconds or -1, if
          *   that time cannot be calculated.
          */
         virtual time_t get_time_left()
         {
-            boost::recursive_mutex::scoped_lock lock(this->mtx);
-            if (progress < 1.0)
-                return progress > 0 ? static_cast<time_t>((1.0 - progress) * static_cast<double>(get_time_passed()) / progress) : static_cast<time_t>(-1);
-            return 0;
+            const double progress = get_progress();
+            if (progress >= 1.0) return 0;
+
+            const clock_type::time_point now = clock_type::now();
+
+            std::lock_guard<std::mutex> lock(rate_mutex);
+
+            const double interval = std::chrono::duration<double>(now - rate_last_sample).count();
+
+            // Progress went back (e.g. reset), start over.
+            if (progress < rate_last_progress)
+            {
+                rate = 0;
+                rate_last_progress = progress;
+                rate_last_sample = now;
+            }
+            else if (interval >= rate_sample_interval)
+            {
+                const double sample = (progress - rate_last_progress) / interval;
+
+                rate = rate > 0 ? rate_smoothing * sample + (1.0 - rate_smoothing) * rate : sample;
+                rate_last_progress = progress;
+                rate_last_sample = now;
+            }
+
+            if (rate > 0) return static_cast<time_t>((1.0 - progress) / rate);
+
+            // No rate yet, fall back to the overall average.
+            const double passed = std::chrono::duration<double>(
+                now.time_since_epoch() - clock_type::duration(time_started.load())).count();
+
+            return progress > 0 ? static_cast<time_t>((1.0 - progress) * passed / progress) : static_cast<time_t>(-1);
         }
 
         virtual std::string get_time_left_as_string()
         {
-            boost::recursive_mutex::scoped_lock lock(this->mtx);
-            time_t time_left = get_time_left_averaged();
+            time_t time_left = get_time_left();
             if (time_left == -1) return std::string("-");
             else
             {
@@ -193,7 +373,7 @@ namespace degate
                 else
                 {
                     unsigned int minutes = (int)time_left / 60;
-                    snprintf(buf, sizeof(buf), "%d:%02d h", minutes / 60, (int)time_left % 60);
+                    snprintf(buf, sizeof(buf), "%d:%02d h", minutes / 60, minutes % 60);
                 }
                 return std::string(buf);
             }
@@ -202,20 +382,20 @@ namespace degate
 
         virtual void set_log_message(std::string const& msg)
         {
-            boost::recursive_mutex::scoped_lock lock(this->mtx);
+            std::lock_guard<std::mutex> lock(log_mutex);
             log_message = msg;
             log_message_set = true;
         }
 
         virtual std::string get_log_message()
         {
-            boost::recursive_mutex::scoped_lock lock(this->mtx);
+            std::lock_guard<std::mutex> lock(log_mutex);
             return log_message;
         }
 
         virtual bool has_log_message()
         {
-            boost::recursive_mutex::scoped_lock lock(this->mtx);
+            std::lock_guard<std::mutex> lock(log_mutex);
             return log_message_set;
         }
     };
@@ -0,0 +1,173 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/Utils/Trace.h"
+#include "Core/Utils/DegateExceptions.h"
+#include "Core/Utils/DegateHelper.h"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+using namespace degate;
+
+std::atomic<bool> Trace::enabled(false);
+
+Trace::Trace() :
+    origin(clock_type::now()),
+    max_events(1000000),
+    dropped_events(0)
+{
+}
+
+Trace::~Trace()
+{
+    for (auto& counter : counters) delete counter.second;
+}
+
+void Trace::set_enabled(bool state)
+{
+    enabled.store(state, std::memory_order_relaxed);
+}
+
+void Trace::set_max_events(std::size_t max_events)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    this->max_events = max_events;
+}
+
+TraceCounter& Trace::get_counter(std::string const& name)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    TraceCounter*& counter = counters[name];
+    if (counter == nullptr) counter = new TraceCounter();
+
+    return *counter;
+}
+
+unsigned int Trace::get_thread_number()
+{
+    static std::atomic<unsigned int> next_thread_number(1);
+    thread_local unsigned int thread_number = next_thread_number.fetch_add(1);
+
+    return thread_number;
+}
+
+void Trace::add_span(const char* name, const char* category,
+                     clock_type::time_point start, clock_type::time_point end)
+{
+    const unsigned int thread = get_thread_number();
+    const double ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    TraceSpanStatistics& stats = span_statistics[name];
+    if (stats.count == 0 || ms < stats.min_ms) stats.min_ms = ms;
+    if (stats.count == 0 || ms > stats.max_ms) stats.max_ms = ms;
+    stats.total_ms += ms;
+    stats.count++;
+
+    if (events.size() < max_events) events.push_back({name, category, thread, start, end - start});
+    else dropped_events++;
+}
+
+Trace::span_statistics_type Trace::get_span_statistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return span_statistics;
+}
+
+Trace::counter_values_type Trace::get_counter_values() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    counter_values_type values;
+    for (auto const& counter : counters) values[counter.first] = counter.second->get();
+
+    return values;
+}
+
+uint_fast64_t Trace::get_dropped_events() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return dropped_events;
+}
+
+void Trace::reset()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    events.clear();
+    span_statistics.clear();
+    dropped_events = 0;
+    origin = clock_type::now();
+
+    for (auto& counter : counters) counter.second->reset();
+}
+
+void Trace::export_chrome_trace(std::string const& filename) const
+{
+    std::ofstream file(filename.c_str(), std::ios::trunc | std::ios::out);
+    if (!file.is_open()) throw InvalidPathException("Can't write trace file " + filename + ".");
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto to_us = [](clock_type::duration d)
+    {
+        return std::chrono::duration<double, std::micro>(d).count();
+    };
+
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << std::endl;
+
+    // Complete events ("X") for spans
+    bool first = true;
+    clock_type::time_point last = origin;
+
+    for (auto const& e : events)
+    {
+        file << (first ? "" : ",\n")
+             << "{\"name\": " << json_string(e.name)
+             << ", \"cat\": " << json_string(e.category)
+             << ", \"ph\": \"X\", \"pid\": 1, \"tid\": " << e.thread
+             << ", \"ts\": " << to_us(e.start - origin)
+             << ", \"dur\": " << to_us(e.duration) << "}";
+
+        first = false;
+        if (e.start + e.duration > last) last = e.start + e.duration;
+    }
+
+    // Counter events ("C") with the final values at the end of the trace
+    for (auto const& counter : counters)
+    {
+        file << (first ? "" : ",\n")
+             << "{\"name\": " << json_string(counter.first)
+             << ", \"ph\": \"C\", \"pid\": 1, \"ts\": " << to_us(last - origin)
+             << ", \"args\": {\"value\": " << counter.second->get() << "}}";
+
+        first = false;
+    }
+
+    file << std::endl << "]}" << std::endl;
+
+    if (!file.good()) throw InvalidPathException("Can't write trace file " + filename + ".");
+}
@@ -0,0 +1,267 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include "Core/Primitive/SingletonBase.h"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace degate
+{
+    /**
+     * A named counter, e.g. the number of tile cache hits.
+     * Counters are created once by name and then incremented without any locking.
+     * @see Trace::get_counter()
+     */
+    class TraceCounter
+    {
+    private:
+
+        std::atomic<int_fast64_t> value;
+
+    public:
+
+        TraceCounter() : value(0)
+        {
+        }
+
+        inline void add(int_fast64_t delta)
+        {
+            value.fetch_add(delta, std::memory_order_relaxed);
+        }
+
+        inline int_fast64_t get() const
+        {
+            return value.load(std::memory_order_relaxed);
+        }
+
+        inline void reset()
+        {
+            value.store(0, std::memory_order_relaxed);
+        }
+    };
+
+    /**
+     * Aggregated timings of all spans with the same name.
+     */
+    struct TraceSpanStatistics
+    {
+        uint_fast64_t count = 0;
+        double total_ms = 0;
+        double min_ms = 0;
+        double max_ms = 0;
+
+        double get_mean_ms() const { return count == 0 ? 0 : total_ms / count; }
+    };
+
+    /**
+     * Lightweight tracing of hot paths.
+     *
+     * Code is instrumented with scoped spans (TRACE_SCOPE) and counters (TRACE_COUNT).
+     * Tracing is disabled by default. Then a span or counter costs a single relaxed
+     * atomic load. If DEGATE_DISABLE_TRACING is defined at compile time, the macros
+     * expand to nothing.
+     *
+     * When enabled, every finished span is aggregated per name (see get_span_statistics())
+     * and kept as event, that can be exported in the Chrome trace event format
+     * (load it in chrome://tracing or Perfetto). The number of kept events is limited,
+     * the statistics are always complete.
+     */
+    class Trace : public SingletonBase<Trace>
+    {
+        friend class SingletonBase<Trace>;
+
+    public:
+
+        typedef std::chrono::steady_clock clock_type;
+        typedef std::map<std::string, TraceSpanStatistics> span_statistics_type;
+        typedef std::map<std::string, int_fast64_t> counter_values_type;
+
+    private:
+
+        struct Event
+        {
+            std::string name;
+            const char* category;
+            unsigned int thread;
+            clock_type::time_point start;
+            clock_type::duration duration;
+        };
+
+        static std::atomic<bool> enabled;
+
+        clock_type::time_point origin;
+
+        std::vector<Event> events;
+        std::size_t max_events;
+        uint_fast64_t dropped_events;
+
+        span_statistics_type span_statistics;
+        std::map<std::string, TraceCounter*> counters;
+
+        mutable std::mutex mutex;
+
+        Trace();
+
+    public:
+
+        virtual ~Trace();
+
+        /**
+         * Check if tracing is enabled. This is the only cost of instrumentation when
+         * tracing is disabled.
+         */
+        static inline bool is_enabled()
+        {
+            return enabled.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * Enable or disable tracing. Already recorded data is kept.
+         */
+        void set_enabled(bool state);
+
+        /**
+         * Set the maximum number of span events, that are kept for export.
+         * Default is 1000000.
+         */
+        void set_max_events(std::size_t max_events);
+
+        /**
+         * Get a counter by name. The counter is created, if it does not exist.
+         * The returned reference stays valid for the lifetime of the program.
+         */
+        TraceCounter& get_counter(std::string const& name);
+
+        /**
+         * Record a finished span. Usually called by TraceScope.
+         * @param name The span name. It is copied.
+         * @param category A string literal.
+         */
+        void add_span(const char* name, const char* category,
+                      clock_type::time_point start, clock_type::time_point end);
+
+        /**
+         * Get the aggregated timings per span name.
+         */
+        span_statistics_type get_span_statistics() const;
+
+        /**
+         * Get the current values of all counters.
+         */
+        counter_values_type get_counter_values() const;
+
+        /**
+         * Get the number of span events, that were not kept because of the event limit.
+         */
+        uint_fast64_t get_dropped_events() const;
+
+        /**
+         * Forget all spans and reset all counters.
+         */
+        void reset();
+
+        /**
+         * Write all kept span events and the final counter values in the
+         * Chrome trace event format (JSON).
+         * @exception InvalidPathException This exception is raised if the file can't be written.
+         */
+        void export_chrome_trace(std::string const& filename) const;
+
+    private:
+
+        static unsigned int get_thread_number();
+    };
+
+    /**
+     * Measure the lifetime of a scope as span.
+     * @see TRACE_SCOPE
+     */
+    class TraceScope
+    {
+    private:
+
+        const char* name;
+        const char* category;
+        bool active;
+        Trace::clock_type::time_point start;
+
+    public:
+
+        inline TraceScope(const char* name, const char* category = "degate") :
+            name(name), category(category), active(Trace::is_enabled())
+        {
+            if (active) start = Trace::clock_type::now();
+        }
+
+        inline ~TraceScope()
+        {
+            if (active) Trace::get_instance().add_span(name, category, start, Trace::clock_type::now());
+        }
+    };
+}
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+
+#ifndef DEGATE_DISABLE_TRACING
+
+/**
+ * Trace the enclosing scope as span.
+ */
+#define TRACE_SCOPE(name) degate::TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+
+/**
+ * Trace the enclosing scope as span of a category (e.g. "matching", "io", "render").
+ */
+#define TRACE_SCOPE_CATEGORY(name, category) \
+    degate::TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name, category)
+
+/**
+ * Add \p value to the counter \p name. The name must be a string literal.
+ */
+#define TRACE_COUNT(name, value)                                                                    \
+    do                                                                                              \
+    {                                                                                               \
+        if (degate::Trace::is_enabled())                                                            \
+        {                                                                                           \
+            static degate::TraceCounter& trace_counter = degate::Trace::get_instance().get_counter(name); \
+            trace_counter.add(value);                                                               \
+        }                                                                                           \
+    } while (0)
+
+#else
+
+#define TRACE_SCOPE(name)
+#define TRACE_SCOPE_CATEGORY(name, category)
+#define TRACE_COUNT(name, value) do {} while (0)
+
+#endif
+
+#endif
@@ -793,6 +793,9 @@ namespace degate
 		behaviour_tab.validate();
 		layout_tab.validate();
 
+		// The template is edited in place, journal it for incremental saves and rule checks.
+		project->get_logic_model()->get_journal()->record_gate_template(gate->get_object_id());
+
 		accept();
 	}
 
@@ -0,0 +1,206 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "MetricsDialog.h"
+#include "Core/Utils/Trace.h"
+
+#include <QFileDialog>
+#include <QMessageBox>
+
+namespace degate
+{
+    MetricsDialog::MetricsDialog(QWidget* parent)
+            : QDialog(nullptr) // nullptr to let the window "free" of parent's position constraints
+    {
+        setWindowTitle(tr("Metrics"));
+        setWindowIcon(QIcon(":/degate_logo.png"));
+
+        // Spans
+        spans_table.setColumnCount(6);
+        spans_table.setSelectionBehavior(QAbstractItemView::SelectionBehavior::SelectRows);
+        spans_table.setEditTriggers(QAbstractItemView::NoEditTriggers);
+        spans_table.setSortingEnabled(true);
+        QStringList spans_list;
+        spans_list.append(tr("Stage"));
+        spans_list.append(tr("Calls"));
+        spans_list.append(tr("Total [ms]"));
+        spans_list.append(tr("Mean [ms]"));
+        spans_list.append(tr("Min [ms]"));
+        spans_list.append(tr("Max [ms]"));
+        spans_table.setHorizontalHeaderLabels(spans_list);
+
+        // Counters
+        counters_table.setColumnCount(2);
+        counters_table.setSelectionBehavior(QAbstractItemView::SelectionBehavior::SelectRows);
+        counters_table.setEditTriggers(QAbstractItemView::NoEditTriggers);
+        counters_table.setSortingEnabled(true);
+        QStringList counters_list;
+        counters_list.append(tr("Counter"));
+        counters_list.append(tr("Value"));
+        counters_table.setHorizontalHeaderLabels(counters_list);
+
+        // Tabs
+        tabs.addTab(&spans_table, tr("Timings"));
+        tabs.addTab(&counters_table, tr("Counters"));
+
+        // Controls
+        enable_check_box.setText(tr("Enable tracing"));
+        enable_check_box.setChecked(Trace::is_enabled());
+        QObject::connect(&enable_check_box, SIGNAL(stateChanged(int)), this, SLOT(enable_tracing(int)));
+        control_layout.addWidget(&enable_check_box, 0, 0);
+
+        control_layout.addWidget(&dropped_events_label, 0, 1, 1, 3);
+
+        refresh_button.setText(tr("Refresh"));
+        refresh_button.setFocusPolicy(Qt::NoFocus);
+        QObject::connect(&refresh_button, SIGNAL(clicked()), this, SLOT(refresh()));
+        control_layout.addWidget(&refresh_button, 1, 0);
+
+        reset_button.setText(tr("Reset"));
+        reset_button.setFocusPolicy(Qt::NoFocus);
+        QObject::connect(&reset_button, SIGNAL(clicked()), this, SLOT(reset()));
+        control_layout.addWidget(&reset_button, 1, 1);
+
+        export_button.setText(tr("Export trace"));
+        export_button.setFocusPolicy(Qt::NoFocus);
+        QObject::connect(&export_button, SIGNAL(clicked()), this, SLOT(export_trace()));
+        control_layout.addWidget(&export_button, 1, 2);
+
+        // Refresh while visible
+        refresh_timer.setInterval(1000);
+        QObject::connect(&refresh_timer, SIGNAL(timeout()), this, SLOT(refresh()));
+
+        layout.addWidget(&tabs, 0, 0);
+        layout.addLayout(&control_layout, 1, 0);
+        layout.setRowStretch(0, 1);
+
+        setLayout(&layout);
+
+        if (parent != nullptr)
+            resize(parent->size() * 0.5);
+
+        refresh();
+    }
+
+    void MetricsDialog::refresh()
+    {
+        Trace& trace = Trace::get_instance();
+
+        auto add_item = [](QTableWidget& table, int row, int column, QVariant const& value)
+        {
+            auto item = new QTableWidgetItem();
+            item->setData(Qt::DisplayRole, value);
+            item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
+            table.setItem(row, column, item);
+        };
+
+        // Spans
+        auto spans = trace.get_span_statistics();
+
+        spans_table.setSortingEnabled(false);
+        spans_table.clearContents();
+        spans_table.setRowCount(static_cast<int>(spans.size()));
+
+        int row = 0;
+        for (auto const& span : spans)
+        {
+            add_item(spans_table, row, 0, QString::fromStdString(span.first));
+            add_item(spans_table, row, 1, QVariant::fromValue<qulonglong>(span.second.count));
+            add_item(spans_table, row, 2, span.second.total_ms);
+            add_item(spans_table, row, 3, span.second.get_mean_ms());
+            add_item(spans_table, row, 4, span.second.min_ms);
+            add_item(spans_table, row, 5, span.second.max_ms);
+            row++;
+        }
+
+        spans_table.setSortingEnabled(true);
+        spans_table.resizeColumnsToContents();
+
+        // Counters
+        auto counters = trace.get_counter_values();
+
+        counters_table.setSortingEnabled(false);
+        counters_table.clearContents();
+        counters_table.setRowCount(static_cast<int>(counters.size()));
+
+        row = 0;
+        for (auto const& counter : counters)
+        {
+            add_item(counters_table, row, 0, QString::fromStdString(counter.first));
+            add_item(counters_table, row, 1, QVariant::fromValue<qlonglong>(counter.second));
+            row++;
+        }
+
+        counters_table.setSortingEnabled(true);
+        counters_table.resizeColumnsToContents();
+
+        // Events, that are not kept for the trace export
+        auto dropped_events = trace.get_dropped_events();
+        if (dropped_events > 0)
+            dropped_events_label.setText(tr("%1 events were not kept for export.").arg(dropped_events));
+        else
+            dropped_events_label.clear();
+    }
+
+    void MetricsDialog::reset()
+    {
+        Trace::get_instance().reset();
+
+        refresh();
+    }
+
+    void MetricsDialog::export_trace()
+    {
+        QString filename = QFileDialog::getSaveFileName(this, tr("Export trace"), "trace.json", tr("Chrome trace (*.json)"));
+
+        if (filename.isNull())
+            return;
+
+        try
+        {
+            Trace::get_instance().export_chrome_trace(filename.toStdString());
+        }
+        catch (const std::exception& e)
+        {
+            QMessageBox::critical(this, tr("Error"), tr("Can't export the trace: %1").arg(e.what()));
+        }
+    }
+
+    void MetricsDialog::enable_tracing(int state)
+    {
+        Trace::get_instance().set_enabled(state == Qt::Checked);
+    }
+
+    void MetricsDialog::showEvent(QShowEvent* event)
+    {
+        refresh();
+        refresh_timer.start();
+
+        QDialog::showEvent(event);
+    }
+
+    void MetricsDialog::hideEvent(QHideEvent* event)
+    {
+        refresh_timer.stop();
+
+        QDialog::hideEvent(event);
+    }
+}
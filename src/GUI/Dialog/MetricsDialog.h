@@ -0,0 +1,107 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __METRICSDIALOG_H__
+#define __METRICSDIALOG_H__
+
+#include <QDialog>
+#include <QWidget>
+#include <QTabWidget>
+#include <QTableWidget>
+#include <QGridLayout>
+#include <QCheckBox>
+#include <QPushButton>
+#include <QLabel>
+#include <QTimer>
+
+namespace degate
+{
+    /**
+     * @class MetricsDialog
+     * @brief Dialog that shows the timings and counters recorded by the tracing subsystem.
+     *
+     * It shows what is slow on the current project without attaching a profiler.
+     * Tracing can be enabled and disabled from here, and the recorded spans can be
+     * exported as Chrome trace (JSON).
+     *
+     * The dialog should be open as modeless (QDialog::show), it refreshes itself while visible.
+     *
+     * @see Trace
+     */
+    class MetricsDialog : public QDialog
+    {
+        Q_OBJECT
+
+    public:
+        /**
+         * Create a new metrics dialog.
+         *
+         * @param parent : the parent of the dialog.
+         */
+        explicit MetricsDialog(QWidget* parent);
+        ~MetricsDialog() override = default;
+
+    public slots:
+        /**
+         * Reload all timings and counters.
+         */
+        void refresh();
+
+        /**
+         * Forget all recorded timings and reset counters.
+         */
+        void reset();
+
+        /**
+         * Ask for a filename and export the recorded spans as Chrome trace.
+         */
+        void export_trace();
+
+        /**
+         * Enable or disable tracing.
+         *
+         * @param state : the check box state.
+         */
+        void enable_tracing(int state);
+
+    protected:
+        void showEvent(QShowEvent* event) override;
+        void hideEvent(QHideEvent* event) override;
+
+    private:
+        QGridLayout layout;
+        QTabWidget tabs;
+
+        QTableWidget spans_table;
+        QTableWidget counters_table;
+
+        QGridLayout control_layout;
+        QCheckBox enable_check_box;
+        QLabel dropped_events_label;
+        QPushButton refresh_button;
+        QPushButton reset_button;
+        QPushButton export_button;
+
+        QTimer refresh_timer;
+    };
+}
+
+#endif //__METRICSDIALOG_H__
@@ -23,8 +23,10 @@
 #include "Core/Generator/VerilogModuleGenerator.h"
 #include "Core/Utils/DegateHelper.h"
 
+#include <fstream>
 #include <utility>
 #include <QFileDialog>
+#include <QMessageBox>
 
 namespace degate
 {
@@ -302,8 +304,11 @@ namespace degate
         auto module = modules_map[modules_tree.selectedItems().at(0)].module;
 
         Module_shptr new_module(new Module(tr("Click to edit").toStdString()));
+        new_module->set_object_id(project->get_logic_model()->get_new_object_id());
         module->add_module(new_module);
 
+        project->get_logic_model()->get_journal()->record_module_change();
+
         insert_module(modules_tree.selectedItems().at(0), new_module, module);
     }
 
@@ -319,6 +324,8 @@ namespace degate
 
         module_collection.parent->remove_module(module_collection.module);
 
+        project->get_logic_model()->get_journal()->record_module_change();
+
         inset_modules();
     }
 
@@ -357,9 +364,16 @@ namespace degate
 
         std::string path = join_pathes(dir.toStdString(), filename);
 
+        std::ofstream file(path.c_str(), std::ios::trunc | std::ios::out);
+        if (!file.is_open())
+        {
+            QMessageBox::warning(this, tr("Export module"), tr("Can't write to %1.").arg(QString::fromStdString(path)));
+            return;
+        }
+
+        // Stream the netlist, large hierarchies don't fit into a single string.
         VerilogModuleGenerator code_generator(module);
-        std::string impl = code_generator.generate();
-        write_string_to_file(path, impl);
+        code_generator.generate(file);
     }
 
     void ModulesDialog::move_gate_into_module()
@@ -384,6 +398,8 @@ namespace degate
         old_module->remove_gate(selected_gate);
         selected_module->add_gate(selected_gate);
 
+        project->get_logic_model()->get_journal()->record_module_change();
+
         insert_gates(old_module);
         insert_ports(old_module);
     }
@@ -419,6 +435,8 @@ namespace degate
 
         module->set_name(item->text(0).toStdString());
         module->set_entity_name(item->text(1).toStdString());
+
+        project->get_logic_model()->get_journal()->record_module_change();
     }
 
     void ModulesDialog::on_port_double_clicked(QTreeWidgetItem* item, int column)
@@ -441,5 +459,7 @@ namespace degate
         auto module = modules_map[modules_tree.selectedItems().at(0)].module;
 
         module->set_module_port_name(item->text(0).toStdString(), port);
+
+        project->get_logic_model()->get_journal()->record_module_change();
     }
 }
@@ -185,7 +185,7 @@ namespace degate
         accepted_violations_tab.clear_violations();
         violations_tab.clear_violations();
 
-        rule_checker.run(project->get_logic_model());
+        rule_checker.run_incremental(project->get_logic_model());
         RCVContainer const& violations = rule_checker.get_rc_violations();
 
         for (auto& v : violations)
@@ -64,12 +64,12 @@ namespace degate
 
         // Scale image down by factor
         image_scale_factor_label.setText(tr("Scale image down by factor:"));
-        ScalingManager_shptr scaling_manager = project->get_logic_model()->get_current_layer()->get_scaling_manager();
+        Layer_shptr layer = project->get_logic_model()->get_current_layer();
 
-        if (scaling_manager == nullptr)
+        if (layer == nullptr || !layer->has_background_image())
             return;
 
-        const auto steps = scaling_manager->get_zoom_steps();
+        const auto steps = layer->get_zoom_steps();
         for (auto& step : steps)
         {
             bool is_ok = true;
@@ -176,6 +176,11 @@ namespace degate
         fullscreen_view_action->setShortcut(Qt::Key_F11);
         QObject::connect(fullscreen_view_action, SIGNAL(toggled(bool)), this, SLOT(on_menu_view_fullscreen(bool)));
 
+        view_menu->addSeparator();
+
+        metrics_view_action = view_menu->addAction("");
+        QObject::connect(metrics_view_action, SIGNAL(triggered()), this, SLOT(on_menu_view_metrics()));
+
 
         // Layer menu
         layer_menu = menu_bar.addMenu("");
@@ -508,6 +513,7 @@ namespace degate
         show_grid_view_action->setText(tr("Show grid"));
         snap_to_grid_view_action->setText(tr("Snap to grid"));
         fullscreen_view_action->setText(tr("Fullscreen"));
+        metrics_view_action->setText(tr("Metrics"));
 
         // Layer menu
         layer_menu->setTitle(tr("Layer"));
@@ -621,7 +627,7 @@ namespace degate
         status_bar.showMessage(tr("Saving project..."));
 
         ProjectExporter exporter;
-        exporter.export_all(project->get_project_directory(), project);
+        exporter.export_incremental(project->get_project_directory(), project);
 
         status_bar.showMessage(tr("Project saved."), SECOND(DEFAULT_STATUS_MESSAGE_DURATION));
 
@@ -755,6 +761,18 @@ namespace degate
             showNormal();
     }
 
+    void MainWindow::on_menu_view_metrics()
+    {
+        if (metrics_dialog == nullptr)
+        {
+            metrics_dialog = new MetricsDialog(this);
+            metrics_dialog->setWindowFlags(Qt::Window);
+        }
+
+        metrics_dialog->show();
+        metrics_dialog->raise();
+    }
+
     void MainWindow::on_menu_layer_edit()
     {
         if (project == nullptr)
@@ -815,9 +833,10 @@ namespace degate
             debug(TM, "The background image importation and conversion operation has been canceled.");
 
         // Create reader (to get image size).
-        QImageReader reader(file_name.c_str());
+        ImageReader<BackgroundImage> reader(file_name);
+        reader.read();
 
-        if (!project->update_size(reader.size().width(), reader.size().height()))
+        if (!project->update_size(reader.get_width(), reader.get_height()))
         {
             workspace->update_background();
 
@@ -870,7 +889,7 @@ namespace degate
             project->get_logic_model()->update_ports(new_gate);
 
             workspace->reset_area_selection();
-            workspace->update_gates();
+            workspace->add_object(new_gate);
 
             project_changed();
         }
@@ -916,7 +935,7 @@ namespace degate
             project->get_logic_model()->update_ports(new_gate);
 
             workspace->reset_area_selection();
-            workspace->update_gates();
+            workspace->add_object(new_gate);
 
             project_changed();
         }
@@ -937,11 +956,11 @@ namespace degate
             dialog.exec();
 
             project->get_logic_model()->update_ports(o);
-        }
 
-        workspace->update_gates();
+            workspace->update_object(o);
 
-        project_changed();
+            project_changed();
+        }
     }
 
     void MainWindow::on_menu_gate_library()
@@ -949,6 +968,7 @@ namespace degate
         if (project == nullptr)
             return;
 
+        // Edited templates are journaled by the edit dialogs.
         GateLibraryDialog dialog(this, project);
         dialog.exec();
 
@@ -1053,6 +1073,8 @@ namespace degate
             AnnotationEditDialog dialog(this, o);
             dialog.exec();
 
+            project->get_logic_model()->get_journal()->record_object(o->get_object_id());
+
             workspace->update_annotations();
 
             project_changed();
@@ -1089,7 +1111,9 @@ namespace degate
             EMarkerEditDialog dialog(this, o);
             dialog.exec();
 
-            workspace->update_emarkers();
+            project->get_logic_model()->get_journal()->record_object(o->get_object_id());
+
+            workspace->update_object(o);
 
             project_changed();
         }
@@ -1105,7 +1129,9 @@ namespace degate
             ViaEditDialog dialog(this, o, project);
             dialog.exec();
 
-            workspace->update_vias();
+            project->get_logic_model()->get_journal()->record_object(o->get_object_id());
+
+            workspace->update_object(o);
 
             project_changed();
         }
@@ -1122,10 +1148,12 @@ namespace degate
         for (auto& object : objects)
         {
             if (object != nullptr && !std::dynamic_pointer_cast<GatePort>(object))
+            {
+                workspace->remove_object(object);
                 project->get_logic_model()->remove_object(object);
+            }
         }
 
-        workspace->update_objects();
         workspace->update_annotations();
 
         if (modules_dialog != nullptr)
@@ -1210,6 +1238,8 @@ namespace degate
             }
         }
 
+        project->get_logic_model()->get_journal()->record_module_change();
+
         project_changed();
     }
 
@@ -1725,7 +1755,7 @@ namespace degate
         {
             project->get_logic_model()->add_object(project->get_logic_model()->get_current_layer()->get_layer_pos(), new_emarker);
 
-            workspace->update_emarkers();
+            workspace->add_object(new_emarker);
 
             project_changed();
         }
@@ -1749,7 +1779,7 @@ namespace degate
             project->get_logic_model()->add_object(project->get_logic_model()->get_current_layer()->get_layer_pos(),
                                                    new_via);
 
-            workspace->update_vias();
+            workspace->add_object(new_via);
 
             project_changed();
         }
@@ -1938,6 +1968,15 @@ namespace degate
 
             gate_list_dialog = nullptr;
         }
+
+        if (metrics_dialog != nullptr)
+        {
+            metrics_dialog->close();
+
+            delete metrics_dialog;
+
+            metrics_dialog = nullptr;
+        }
     }
 
     void MainWindow::reload_recent_projects_list()
@@ -46,6 +46,7 @@
 #include "Core/LogicModel/Gate/AutoNameGates.h"
 #include "GUI/Dialog/AnnotationListDialog.h"
 #include "GUI/Dialog/GateListDialog.h"
+#include "GUI/Dialog/MetricsDialog.h"
 #include "GUI/Utils/Updater.h"
 
 #include <QMainWindow>
@@ -157,6 +158,11 @@ namespace degate
          */
         void on_menu_view_fullscreen(bool value);
 
+        /**
+         * Open the metrics dialog (timings and counters of the tracing subsystem).
+         */
+        void on_menu_view_metrics();
+
 
         /* Layer menu */
 
@@ -489,6 +495,7 @@ namespace degate
         QAction* show_grid_view_action;
         QAction* snap_to_grid_view_action;
         QAction* fullscreen_view_action;
+        QAction* metrics_view_action;
 
         // Layer menu
         QMenu* layer_menu;
@@ -564,6 +571,7 @@ namespace degate
         ConnectionInspector* connection_inspector_dialog = nullptr;
         AnnotationListDialog* annotation_list_dialog = nullptr;
         GateListDialog* gate_list_dialog = nullptr;
+        MetricsDialog* metrics_dialog = nullptr;
 
         Updater updater;
     };
@@ -86,6 +86,9 @@ namespace degate
         // Image importer cache size
         preferences.image_importer_cache_size = settings.value("image_importer_cache_size", 256).toUInt();
 
+        // Level of detail zoom threshold
+        preferences.lod_zoom_threshold = settings.value("lod_zoom_threshold", 16).toUInt();
+
 
         load_recent_projects();
     }
@@ -133,6 +136,7 @@ namespace degate
 
         settings.setValue("cache_size", preferences.cache_size);
         settings.setValue("image_importer_cache_size", preferences.image_importer_cache_size);
+        settings.setValue("lod_zoom_threshold", preferences.lod_zoom_threshold);
     }
 
     void PreferencesHandler::update(const Preferences& updated_preferences)
@@ -49,6 +49,15 @@ namespace degate
         image_importer_cache_size_edit.setMinimum(MINIMUM_CACHE_SIZE);
         image_importer_cache_size_edit.setMaximum(std::numeric_limits<int>::max());
         image_importer_cache_size_edit.setValue(PREFERENCES_HANDLER.get_preferences().image_importer_cache_size);
+
+        // Rendering category
+        auto rendering_layout = PreferencesPage::add_category(tr("Rendering"));
+
+        // Level of detail zoom threshold spinbox (0 disables the level of detail rendering)
+        PreferencesPage::add_widget(rendering_layout, tr("Simplified rendering from zoom out level (0 to disable):"), &lod_zoom_threshold_edit);
+        lod_zoom_threshold_edit.setMinimum(0);
+        lod_zoom_threshold_edit.setMaximum(4096);
+        lod_zoom_threshold_edit.setValue(PREFERENCES_HANDLER.get_preferences().lod_zoom_threshold);
     }
 
     void PerformancesPreferencesPage::apply(Preferences& preferences)
@@ -61,5 +70,6 @@ namespace degate
 
         preferences.cache_size = static_cast<unsigned int>(cache_size_edit.value());
         preferences.image_importer_cache_size = static_cast<unsigned int>(image_importer_cache_size_edit.value());
+        preferences.lod_zoom_threshold = static_cast<unsigned int>(lod_zoom_threshold_edit.value());
     }
 }
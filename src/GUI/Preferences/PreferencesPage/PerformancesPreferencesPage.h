@@ -58,6 +58,7 @@ namespace degate
     private:
         QSpinBox cache_size_edit;
         QSpinBox image_importer_cache_size_edit;
+        QSpinBox lod_zoom_threshold_edit;
 
     };
 }
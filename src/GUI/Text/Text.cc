@@ -773,7 +773,7 @@ namespace degate
         this->total_size = total_size;
     }
 
-    QSizeF Text::add_sub_text(unsigned int offset, float x, float y, const std::string& text, const unsigned int text_size, const QVector3D &color, const float alpha, const bool center_x, const bool center_y, float max_width)
+    QSizeF Text::layout_text(float x, float y, const std::string& text, const unsigned int text_size, const bool center_x, const bool center_y, float max_width, std::vector<GlyphQuad>& quads)
     {
         QString string = QString::fromUtf8(text.data(), static_cast<int>(text.size()));
         std::shared_ptr<GlyphData> glyph;
@@ -796,8 +796,8 @@ namespace degate
 
         // Set final size factor
         size_factor *= size_downscale_factor;
-        QVector3D final_color = color / 255.0;
-        float padding = font_context_data.lock()->font_data->padding;
+        auto font_data = font_context_data.lock()->font_data;
+        float padding = font_data->padding;
 
         // Padding adaptation
         x -= padding * size_factor;
@@ -817,71 +817,95 @@ namespace degate
 
         // Center y
         if (center_y == true)
-            y -= ((font_context_data.lock()->font_data->default_glyph_height + padding) * size_factor) / 2.0;
+            y -= ((font_data->default_glyph_height + padding) * size_factor) / 2.0;
         else
             y -= padding * 2.0f * size_factor;
 
-
-        // Fill vbo
-
-        vao.bind();
-        font_context->context->functions()->glBindBuffer(GL_ARRAY_BUFFER, vbo);
-
-        TextVertex2D temp;
-        temp.color = final_color;
-        temp.alpha = alpha;
-
-        float atlas_width = static_cast<float>(font_context_data.lock()->font_data->atlas_width);
-        float atlas_height = static_cast<float>(font_context_data.lock()->font_data->atlas_height);
-        unsigned int glyph_per_line = font_context_data.lock()->font_data->atlas_glyph_per_line;
+        float atlas_width = static_cast<float>(font_data->atlas_width);
+        float atlas_height = static_cast<float>(font_data->atlas_height);
+        unsigned int glyph_per_line = font_data->atlas_glyph_per_line;
 
         float pixel_size = 0;
         for (unsigned int i = 0; i < static_cast<unsigned int>(string.size()); i++)
         {
             glyph = get_glyph(string[i]);
 
-            temp.texture_index = glyph->atlas_index;
-
             auto char_width = glyph->char_advance;
 
-            QVector2D pos_start(x + pixel_size, y);
-            QVector2D pos_end(pos_start.x() + (char_width + padding * 2.0) * size_factor, pos_start.y() + (static_cast<float>(font_context_data.lock()->font_data->default_glyph_height) + padding * 2.0) * size_factor);
+            GlyphQuad quad;
+            quad.texture_index = glyph->atlas_index;
 
-            QVector2D uv_start((glyph->atlas_position % glyph_per_line) * (font_context_data.lock()->font_data->glyph_width) / atlas_width, (static_cast<float>(glyph->atlas_position / glyph_per_line) * (font_context_data.lock()->font_data->glyph_height)) / atlas_height);
-            QVector2D uv_end(uv_start.x() + (char_width + padding * 2.0) / atlas_width, uv_start.y() + (font_context_data.lock()->font_data->glyph_height) / atlas_height);
+            quad.pos_start = QVector2D(x + pixel_size, y);
+            quad.pos_end = QVector2D(quad.pos_start.x() + (char_width + padding * 2.0) * size_factor, quad.pos_start.y() + (static_cast<float>(font_data->default_glyph_height) + padding * 2.0) * size_factor);
 
-            temp.pos = QVector2D(pos_start.x(), pos_start.y());
-            temp.tex_uv = QVector2D(uv_start.x(), uv_start.y());
-            font_context->context->functions()->glBufferSubData(GL_ARRAY_BUFFER, offset * 6 * sizeof(TextVertex2D) + i * 6 * sizeof(TextVertex2D) + 0 * sizeof(TextVertex2D), sizeof(TextVertex2D), &temp);
+            quad.uv_start = QVector2D((glyph->atlas_position % glyph_per_line) * (font_data->glyph_width) / atlas_width, (static_cast<float>(glyph->atlas_position / glyph_per_line) * (font_data->glyph_height)) / atlas_height);
+            quad.uv_end = QVector2D(quad.uv_start.x() + (char_width + padding * 2.0) / atlas_width, quad.uv_start.y() + (font_data->glyph_height) / atlas_height);
 
-            temp.pos = QVector2D(pos_end.x(), pos_start.y());
-            temp.tex_uv = QVector2D(uv_end.x(), uv_start.y());
-            font_context->context->functions()->glBufferSubData(GL_ARRAY_BUFFER, offset * 6 * sizeof(TextVertex2D) + i * 6 * sizeof(TextVertex2D) + 1 * sizeof(TextVertex2D), sizeof(TextVertex2D), &temp);
+            quads.push_back(quad);
 
-            temp.pos = QVector2D(pos_start.x(), pos_end.y());
-            temp.tex_uv = QVector2D(uv_start.x(), uv_end.y());
-            font_context->context->functions()->glBufferSubData(GL_ARRAY_BUFFER, offset * 6 * sizeof(TextVertex2D) + i * 6 * sizeof(TextVertex2D) + 2 * sizeof(TextVertex2D), sizeof(TextVertex2D), &temp);
+            pixel_size += char_width * size_factor;
+        }
 
-            temp.pos = QVector2D(pos_start.x(), pos_end.y());
-            temp.tex_uv = QVector2D(uv_start.x(), uv_end.y());
-            font_context->context->functions()->glBufferSubData(GL_ARRAY_BUFFER, offset * 6 * sizeof(TextVertex2D) + i * 6 * sizeof(TextVertex2D) + 3 * sizeof(TextVertex2D), sizeof(TextVertex2D), &temp);
+        return {pixel_size,
+                static_cast<qreal>(font_data->glyph_height) * static_cast<qreal>(size_factor)};
+    }
 
-            temp.pos = QVector2D(pos_end.x(), pos_start.y());
-            temp.tex_uv = QVector2D(uv_end.x(), uv_start.y());
-            font_context->context->functions()->glBufferSubData(GL_ARRAY_BUFFER, offset * 6 * sizeof(TextVertex2D) + i * 6 * sizeof(TextVertex2D) + 4 * sizeof(TextVertex2D), sizeof(TextVertex2D), &temp);
+    QSizeF Text::add_sub_text(unsigned int offset, float x, float y, const std::string& text, const unsigned int text_size, const QVector3D &color, const float alpha, const bool center_x, const bool center_y, float max_width)
+    {
+        std::vector<GlyphQuad> quads;
+        QSizeF size = layout_text(x, y, text, text_size, center_x, center_y, max_width, quads);
 
-            temp.pos = QVector2D(pos_end.x(), pos_end.y());
-            temp.tex_uv = QVector2D(uv_end.x(), uv_end.y());
-            font_context->context->functions()->glBufferSubData(GL_ARRAY_BUFFER, offset * 6 * sizeof(TextVertex2D) + i * 6 * sizeof(TextVertex2D) + 5 * sizeof(TextVertex2D), sizeof(TextVertex2D), &temp);
+        if (quads.empty())
+            return size;
 
-            pixel_size += char_width * size_factor;
+        // Fill vbo
+
+        std::vector<TextVertex2D> vertices(quads.size() * 6);
+
+        TextVertex2D temp;
+        temp.color = color / 255.0;
+        temp.alpha = alpha;
+
+        for (unsigned int i = 0; i < quads.size(); i++)
+        {
+            const GlyphQuad& quad = quads[i];
+
+            temp.texture_index = quad.texture_index;
+
+            temp.pos = QVector2D(quad.pos_start.x(), quad.pos_start.y());
+            temp.tex_uv = QVector2D(quad.uv_start.x(), quad.uv_start.y());
+            vertices[i * 6 + 0] = temp;
+
+            temp.pos = QVector2D(quad.pos_end.x(), quad.pos_start.y());
+            temp.tex_uv = QVector2D(quad.uv_end.x(), quad.uv_start.y());
+            vertices[i * 6 + 1] = temp;
+
+            temp.pos = QVector2D(quad.pos_start.x(), quad.pos_end.y());
+            temp.tex_uv = QVector2D(quad.uv_start.x(), quad.uv_end.y());
+            vertices[i * 6 + 2] = temp;
+
+            temp.pos = QVector2D(quad.pos_start.x(), quad.pos_end.y());
+            temp.tex_uv = QVector2D(quad.uv_start.x(), quad.uv_end.y());
+            vertices[i * 6 + 3] = temp;
+
+            temp.pos = QVector2D(quad.pos_end.x(), quad.pos_start.y());
+            temp.tex_uv = QVector2D(quad.uv_end.x(), quad.uv_start.y());
+            vertices[i * 6 + 4] = temp;
+
+            temp.pos = QVector2D(quad.pos_end.x(), quad.pos_end.y());
+            temp.tex_uv = QVector2D(quad.uv_end.x(), quad.uv_end.y());
+            vertices[i * 6 + 5] = temp;
         }
 
+        vao.bind();
+        font_context->context->functions()->glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+        font_context->context->functions()->glBufferSubData(GL_ARRAY_BUFFER, offset * 6 * sizeof(TextVertex2D), vertices.size() * sizeof(TextVertex2D), &vertices[0]);
+
         font_context->context->functions()->glBindBuffer(GL_ARRAY_BUFFER, 0);
         vao.release();
 
-        return {pixel_size,
-                static_cast<qreal>(font_context_data.lock()->font_data->glyph_height) * static_cast<qreal>(size_factor)};
+        return size;
     }
 
     void Text::draw(const QMatrix4x4 &projection)
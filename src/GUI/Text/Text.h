@@ -24,6 +24,7 @@
 
 #include <QtOpenGL/QtOpenGL>
 #include <map>
+#include <vector>
 #include <memory>
 
 #define FONT_DFG_SPREAD 4.0
@@ -245,6 +246,28 @@ namespace degate
         void draw(const QMatrix4x4& projection);
 
     protected:
+        /**
+         * @struct GlyphQuad
+         * @brief A laid out glyph: its quad (in world coordinates) and its location in the font atlas.
+         */
+        struct GlyphQuad
+        {
+            QVector2D pos_start;    /**< The bottom left corner of the quad. */
+            QVector2D pos_end;      /**< The top right corner of the quad. */
+            QVector2D uv_start;     /**< The atlas coordinates of the bottom left corner. */
+            QVector2D uv_end;       /**< The atlas coordinates of the top right corner. */
+            float texture_index;    /**< The index of the atlas (layer of the texture array). */
+        };
+
+        /**
+         * Lay out a text: compute the quad of each glyph (@see add_sub_text for parameters).
+         *
+         * @param quads : the glyph quads are appended to it.
+         *
+         * @return Returns the text size (width and height).
+         */
+        QSizeF layout_text(float x, float y, const std::string& text, unsigned int text_size, bool center_x, bool center_y, float max_width, std::vector<GlyphQuad>& quads);
+
         /**
          * Get the font context from an opengl context.
          *
@@ -296,11 +319,13 @@ namespace degate
         // Hold all loaded/generated fonts (a font is described by his font size and font family name).
         static std::vector<std::shared_ptr<FontData>> fonts;
 
-        std::shared_ptr<FontContext> font_context = nullptr;
-        QWidget* parent = nullptr;
         GLuint vbo = 0;
         QOpenGLVertexArrayObject vao;
         unsigned total_size = 0;
+
+    protected:
+        std::shared_ptr<FontContext> font_context = nullptr;
+        QWidget* parent = nullptr;
         Font font;
         std::weak_ptr<FontContextData> font_context_data;
     };
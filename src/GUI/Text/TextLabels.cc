@@ -0,0 +1,385 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "TextLabels.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace degate
+{
+    /**
+     * Get the key of the chunk that contains a position.
+     */
+    static unsigned long long get_chunk_key(float x, float y)
+    {
+        const auto cx = static_cast<int>(std::floor(x / TEXT_LABELS_CHUNK_SIZE));
+        const auto cy = static_cast<int>(std::floor(y / TEXT_LABELS_CHUNK_SIZE));
+
+        return (static_cast<unsigned long long>(static_cast<unsigned int>(cx)) << 32) | static_cast<unsigned int>(cy);
+    }
+
+    /**
+     * Extend a bounding box with another one, or replace it if it is the first one.
+     */
+    static void merge_bounds(BoundingBox& bounds, BoundingBox const& other, bool first)
+    {
+        if (first)
+        {
+            bounds = other;
+            return;
+        }
+
+        bounds.set(std::min(bounds.get_min_x(), other.get_min_x()), std::max(bounds.get_max_x(), other.get_max_x()),
+                   std::min(bounds.get_min_y(), other.get_min_y()), std::max(bounds.get_max_y(), other.get_max_y()));
+    }
+
+    TextLabels::TextLabels(QWidget* parent, const std::string& font_family_name, const unsigned font_size)
+            : Text(parent, font_family_name, font_size)
+    {
+    }
+
+    TextLabels::~TextLabels()
+    {
+        if (font_context == nullptr)
+            return;
+
+        if (font_context->context->functions()->glIsBuffer(quad_vbo) == GL_TRUE)
+            font_context->context->functions()->glDeleteBuffers(1, &quad_vbo);
+
+        if (font_context->context->functions()->glIsBuffer(instance_vbo) == GL_TRUE)
+            font_context->context->functions()->glDeleteBuffers(1, &instance_vbo);
+
+        if (label_vao.isCreated())
+            label_vao.destroy();
+    }
+
+    void TextLabels::init()
+    {
+        font_context = get_font_context();
+        font_context_data = font_context->get_font(font);
+
+        QOpenGLShader* vshader = new QOpenGLShader(QOpenGLShader::Vertex);
+        const char* vsrc =
+                "#version 330 core\n"
+                "in vec2 corner;\n"
+                "in vec4 rect;\n"
+                "in vec4 uv;\n"
+                "in vec4 color;\n"
+                "in float texture_index;\n"
+                "uniform mat4 mvp;\n"
+                "out vec2 TexCoords;\n"
+                "out vec4 out_color;\n"
+                "flat out int texture_layer;\n"
+                "void main()\n"
+                "{\n"
+                "    gl_Position = mvp * vec4(mix(rect.xy, rect.zw, corner), 0.0, 1.0);\n"
+                "    TexCoords = mix(uv.xy, uv.zw, corner);\n"
+                "    out_color = color;\n"
+                "    texture_layer = int(texture_index);\n"
+                "}\n";
+        vshader->compileSourceCode(vsrc);
+
+        QOpenGLShader* fshader = new QOpenGLShader(QOpenGLShader::Fragment);
+        const char* fsrc =
+                "#version 330 core\n"
+                "uniform sampler2DArray texture_array;\n"
+                "in vec2 TexCoords;\n"
+                "in vec4 out_color;\n"
+                "flat in int texture_layer;\n"
+                "const float width = 0.5;\n"
+                "const float edge = 0.03;\n"
+                "out vec4 color;\n"
+                "void main()\n"
+                "{\n"
+                "    float distance = 1.0 - texture(texture_array, vec3(TexCoords.xy, texture_layer)).a;\n"
+                "    float alpha = 1.0 - smoothstep(width, width + edge, distance);\n"
+                "    color = vec4(out_color.rgb, out_color.a * alpha);\n"
+                "}\n";
+        fshader->compileSourceCode(fsrc);
+
+        program.addShader(vshader);
+        program.addShader(fshader);
+
+        program.link();
+
+        delete vshader;
+        delete fshader;
+
+        // The quad shared by all glyphs (as a triangle strip).
+        const QVector2D corners[4] = {QVector2D(0, 0), QVector2D(1, 0), QVector2D(0, 1), QVector2D(1, 1)};
+
+        label_vao.create();
+        label_vao.bind();
+
+        font_context->context->functions()->glGenBuffers(1, &quad_vbo);
+        font_context->context->functions()->glBindBuffer(GL_ARRAY_BUFFER, quad_vbo);
+        font_context->context->functions()->glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+        font_context->context->functions()->glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        font_context->context->functions()->glGenBuffers(1, &instance_vbo);
+
+        label_vao.release();
+    }
+
+    void TextLabels::clear()
+    {
+        chunks.clear();
+        owners.clear();
+        labels_count = 0;
+        visible_glyphs.clear();
+
+        dirty = true;
+    }
+
+    void TextLabels::add_label(float x, float y, const std::string& text, unsigned int text_size, const QVector3D& color, float alpha, bool center_x, bool center_y, float max_width, object_id_t owner)
+    {
+        if (text.empty())
+            return;
+
+        Label label;
+        label.x = x;
+        label.y = y;
+        label.text = text;
+        label.text_size = text_size;
+        label.color = QVector4D(color / 255.0, alpha);
+        label.center_x = center_x;
+        label.center_y = center_y;
+        label.max_width = max_width;
+        label.owner = owner;
+
+        // Conservative estimation of the label area, until it is laid out.
+        const float width = max_width > 0 ? max_width : static_cast<float>(text_size * text.size());
+        const float height = static_cast<float>(text_size) * 2.0f;
+        const float margin = static_cast<float>(text_size);
+
+        const float min_x = center_x ? x - width / 2.0f : x;
+        const float min_y = center_y ? y - height / 2.0f : y;
+        label.bounds = BoundingBox(min_x - margin, min_x + width + margin, min_y - margin, min_y + height + margin);
+        label.height = static_cast<float>(text_size);
+
+        const unsigned long long key = get_chunk_key(x, y);
+        Chunk& chunk = chunks[key];
+
+        merge_bounds(chunk.bounds, label.bounds, chunk.labels.empty());
+        chunk.max_height = std::max(chunk.max_height, label.height);
+        chunk.laid_out = false;
+        chunk.labels.push_back(label);
+
+        if (owner != 0)
+            owners.emplace(owner, key);
+
+        labels_count++;
+        dirty = true;
+    }
+
+    void TextLabels::remove_labels(object_id_t owner)
+    {
+        auto range = owners.equal_range(owner);
+        if (range.first == range.second)
+            return;
+
+        for (auto iter = range.first; iter != range.second; ++iter)
+        {
+            auto chunk_iter = chunks.find(iter->second);
+            if (chunk_iter == chunks.end())
+                continue;
+
+            Chunk& chunk = chunk_iter->second;
+
+            auto end = std::remove_if(chunk.labels.begin(), chunk.labels.end(), [owner](Label const& label)
+            {
+                return label.owner == owner;
+            });
+
+            labels_count -= static_cast<unsigned int>(std::distance(end, chunk.labels.end()));
+            chunk.labels.erase(end, chunk.labels.end());
+
+            if (chunk.labels.empty())
+            {
+                chunks.erase(chunk_iter);
+                continue;
+            }
+
+            // The remaining labels are laid out again on the next draw.
+            chunk.max_height = 0;
+            for (unsigned int i = 0; i < chunk.labels.size(); i++)
+            {
+                merge_bounds(chunk.bounds, chunk.labels[i].bounds, i == 0);
+                chunk.max_height = std::max(chunk.max_height, chunk.labels[i].height);
+            }
+
+            chunk.laid_out = false;
+        }
+
+        owners.erase(range.first, range.second);
+        dirty = true;
+    }
+
+    unsigned int TextLabels::get_labels_count() const
+    {
+        return labels_count;
+    }
+
+    void TextLabels::layout(Chunk& chunk)
+    {
+        std::vector<GlyphQuad> quads;
+
+        chunk.glyphs.clear();
+        chunk.max_height = 0;
+
+        for (unsigned int i = 0; i < chunk.labels.size(); i++)
+        {
+            Label& label = chunk.labels[i];
+
+            quads.clear();
+            const QSizeF size = layout_text(label.x, label.y, label.text, label.text_size, label.center_x, label.center_y, label.max_width, quads);
+
+            label.first_glyph = static_cast<unsigned int>(chunk.glyphs.size());
+            label.glyphs_count = static_cast<unsigned int>(quads.size());
+            label.height = static_cast<float>(size.height());
+
+            for (unsigned int j = 0; j < quads.size(); j++)
+            {
+                const GlyphQuad& quad = quads[j];
+
+                GlyphInstance instance;
+                instance.rect = QVector4D(quad.pos_start.x(), quad.pos_start.y(), quad.pos_end.x(), quad.pos_end.y());
+                instance.uv = QVector4D(quad.uv_start.x(), quad.uv_start.y(), quad.uv_end.x(), quad.uv_end.y());
+                instance.color = label.color;
+                instance.texture_index = quad.texture_index;
+
+                chunk.glyphs.push_back(instance);
+
+                merge_bounds(label.bounds, BoundingBox(quad.pos_start.x(), quad.pos_end.x(), quad.pos_start.y(), quad.pos_end.y()), j == 0);
+            }
+
+            merge_bounds(chunk.bounds, label.bounds, i == 0);
+            chunk.max_height = std::max(chunk.max_height, label.height);
+        }
+
+        chunk.laid_out = true;
+    }
+
+    void TextLabels::draw(const QMatrix4x4& projection)
+    {
+        if (labels_count == 0 || font_context == nullptr)
+            return;
+
+        // For an orthographic projection, the corners of the clip space give the viewport.
+        const QMatrix4x4 inverse = projection.inverted();
+        const QVector3D a = inverse.map(QVector3D(-1, -1, 0));
+        const QVector3D b = inverse.map(QVector3D(1, 1, 0));
+        const BoundingBox viewport(std::min(a.x(), b.x()), std::max(a.x(), b.x()),
+                                   std::min(a.y(), b.y()), std::max(a.y(), b.y()));
+
+        // Size of a screen pixel (in world coordinates).
+        const float pixel_size = parent != nullptr && parent->height() > 0 ? viewport.get_height() / static_cast<float>(parent->height()) : 1.0f;
+
+        // Collect visible glyphs, only if something changed since last frame.
+        if (dirty || projection != last_projection || pixel_size != last_pixel_size)
+        {
+            visible_glyphs.clear();
+
+            for (auto& e : chunks)
+            {
+                Chunk& chunk = e.second;
+
+                if (chunk.max_height < TEXT_LABELS_MIN_READABLE_SIZE * pixel_size || !chunk.bounds.intersects(viewport))
+                    continue;
+
+                if (!chunk.laid_out)
+                {
+                    layout(chunk);
+
+                    if (chunk.max_height < TEXT_LABELS_MIN_READABLE_SIZE * pixel_size || !chunk.bounds.intersects(viewport))
+                        continue;
+                }
+
+                for (auto& label : chunk.labels)
+                {
+                    if (label.height < TEXT_LABELS_MIN_READABLE_SIZE * pixel_size || !label.bounds.intersects(viewport))
+                        continue;
+
+                    visible_glyphs.insert(visible_glyphs.end(),
+                                          chunk.glyphs.begin() + label.first_glyph,
+                                          chunk.glyphs.begin() + label.first_glyph + label.glyphs_count);
+                }
+            }
+
+            font_context->context->functions()->glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+            font_context->context->functions()->glBufferData(GL_ARRAY_BUFFER,
+                                                             visible_glyphs.size() * sizeof(GlyphInstance),
+                                                             visible_glyphs.empty() ? nullptr : &visible_glyphs[0],
+                                                             GL_STREAM_DRAW);
+            font_context->context->functions()->glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+            last_projection = projection;
+            last_pixel_size = pixel_size;
+            dirty = false;
+        }
+
+        if (visible_glyphs.empty())
+            return;
+
+        auto functions = font_context->context->functions();
+        auto extra_functions = font_context->context->extraFunctions();
+
+        program.bind();
+        program.setUniformValue("mvp", projection);
+
+        label_vao.bind();
+
+        functions->glBindBuffer(GL_ARRAY_BUFFER, quad_vbo);
+
+        program.enableAttributeArray("corner");
+        program.setAttributeBuffer("corner", GL_FLOAT, 0, 2, sizeof(QVector2D));
+
+        functions->glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+
+        program.enableAttributeArray("rect");
+        program.setAttributeBuffer("rect", GL_FLOAT, 0, 4, sizeof(GlyphInstance));
+        extra_functions->glVertexAttribDivisor(program.attributeLocation("rect"), 1);
+
+        program.enableAttributeArray("uv");
+        program.setAttributeBuffer("uv", GL_FLOAT, 4 * sizeof(float), 4, sizeof(GlyphInstance));
+        extra_functions->glVertexAttribDivisor(program.attributeLocation("uv"), 1);
+
+        program.enableAttributeArray("color");
+        program.setAttributeBuffer("color", GL_FLOAT, 8 * sizeof(float), 4, sizeof(GlyphInstance));
+        extra_functions->glVertexAttribDivisor(program.attributeLocation("color"), 1);
+
+        program.enableAttributeArray("texture_index");
+        program.setAttributeBuffer("texture_index", GL_FLOAT, 12 * sizeof(float), 1, sizeof(GlyphInstance));
+        extra_functions->glVertexAttribDivisor(program.attributeLocation("texture_index"), 1);
+
+        functions->glBindTexture(GL_TEXTURE_2D_ARRAY, font_context_data.lock()->font_atlas_texture_array);
+
+        extra_functions->glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(visible_glyphs.size()));
+
+        functions->glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        functions->glBindBuffer(GL_ARRAY_BUFFER, 0);
+        label_vao.release();
+
+        program.release();
+    }
+}
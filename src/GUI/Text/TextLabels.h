@@ -0,0 +1,162 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __TEXTLABELS_H__
+#define __TEXTLABELS_H__
+
+#include "Globals.h"
+#include "GUI/Text/Text.h"
+#include "Core/Primitive/BoundingBox.h"
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+
+/**
+ * Size (in pixels) of a label chunk side.
+ */
+#define TEXT_LABELS_CHUNK_SIZE 512
+
+/**
+ * Under this height (in screen pixels) a label is not readable and is not drawn.
+ */
+#define TEXT_LABELS_MIN_READABLE_SIZE 4
+
+namespace degate
+{
+    /**
+     * @class TextLabels
+     * @brief Draw a large number of static labels (e.g. gate and port names).
+     *
+     * Unlike Text, no vbo is sized from the total number of characters. Labels are stored per spatial chunk
+     * (by their position) and are only laid out (glyph quads) when their chunk becomes visible for the first time.
+     *
+     * On draw, labels that are off-screen or too small to be read at the current zoom
+     * (@see TEXT_LABELS_MIN_READABLE_SIZE) are culled. The remaining glyphs are drawn with one instanced draw call
+     * (one instance per glyph, all font atlases are layers of the same texture array). The instance buffer
+     * is only refilled when the view or the labels changed.
+     */
+    class TextLabels : public Text
+    {
+    public:
+
+        /**
+         * Create an empty label set (@see Text for parameters).
+         */
+        explicit TextLabels(QWidget* parent, const std::string& font_family_name = FONT_DEFAULT_FAMILY, unsigned font_size = FONT_DEFAULT_SIZE);
+        ~TextLabels();
+
+        /**
+         * Init OpenGL routine (shader, vbo).
+         */
+        void init();
+
+        /**
+         * Remove all labels.
+         */
+        void clear();
+
+        /**
+         * Add a label (@see Text::add_sub_text for parameters).
+         * Nothing is laid out or uploaded here.
+         *
+         * @param owner : the id of the object the label belongs to, to remove it later (0 for none).
+         */
+        void add_label(float x, float y, const std::string& text, unsigned int text_size, const QVector3D& color = QVector3D(255, 255, 255), float alpha = 1, bool center_x = false, bool center_y = false, float max_width = 0, object_id_t owner = 0);
+
+        /**
+         * Remove all labels of an object. Only the chunks holding them are laid out again.
+         *
+         * @param owner : the id of the object given to add_label().
+         */
+        void remove_labels(object_id_t owner);
+
+        /**
+         * Get the number of labels.
+         */
+        unsigned int get_labels_count() const;
+
+        /**
+         * Draw all visible and readable labels.
+         *
+         * @param projection : the projection matrix to apply.
+         */
+        void draw(const QMatrix4x4& projection);
+
+    private:
+
+        struct GlyphInstance
+        {
+            QVector4D rect;
+            QVector4D uv;
+            QVector4D color;
+            float texture_index;
+        };
+
+        struct Label
+        {
+            float x;
+            float y;
+            std::string text;
+            unsigned int text_size;
+            QVector4D color;
+            bool center_x;
+            bool center_y;
+            float max_width;
+            object_id_t owner;
+
+            BoundingBox bounds;         // Estimated until the label is laid out.
+            float height;               // Text height, estimated until the label is laid out.
+            unsigned int first_glyph = 0;
+            unsigned int glyphs_count = 0;
+        };
+
+        struct Chunk
+        {
+            std::vector<Label> labels;
+            std::vector<GlyphInstance> glyphs;
+            BoundingBox bounds;
+            float max_height = 0;
+            bool laid_out = false;
+        };
+
+        /**
+         * Compute the glyphs of all labels of a chunk.
+         */
+        void layout(Chunk& chunk);
+
+        std::unordered_map<unsigned long long, Chunk> chunks;
+        std::unordered_multimap<object_id_t, unsigned long long> owners;
+        unsigned int labels_count = 0;
+
+        std::vector<GlyphInstance> visible_glyphs;
+        QMatrix4x4 last_projection;
+        float last_pixel_size = 0;
+        bool dirty = true;
+
+        QOpenGLShaderProgram program;
+        QOpenGLVertexArrayObject label_vao;
+        GLuint quad_vbo = 0;
+        GLuint instance_vbo = 0;
+    };
+}
+
+#endif //__TEXTLABELS_H__
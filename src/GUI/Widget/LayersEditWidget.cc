@@ -77,7 +77,7 @@ namespace degate
     {
         QString res = QFileDialog::getOpenFileName(this, tr("Select the background image"));
 
-        if (QImageReader::imageFormat(res).isEmpty())
+        if (QImageReader::imageFormat(res).isEmpty() && !TIFFReader::is_supported(res.toStdString()))
         {
             QMessageBox::warning(this, tr("Invalid image"), tr("Wrong image type."));
             return;
@@ -254,18 +254,15 @@ namespace degate
             if (!is_file(background->get_image_path()))
                 continue;
 
-            if (QImageReader::imageFormat(background->get_image_path().c_str()).isEmpty())
-                continue;
-
-            QImageReader reader(background->get_image_path().c_str());
-            QSize size = reader.size();
-
-            if (!size.isValid())
+            ImageReader<BackgroundImage> reader(background->get_image_path());
+            if (!reader.read())
             {
                 debug(TM, "can't read size of %s\n", background->get_image_path().c_str());
                 continue;
             }
 
+            QSize size(static_cast<int>(reader.get_width()), static_cast<int>(reader.get_height()));
+
             if (size.width() > max.width())
                 max.setWidth(size.width());
 
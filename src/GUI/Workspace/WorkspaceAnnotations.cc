@@ -20,6 +20,7 @@
  */
 
 #include "WorkspaceAnnotations.h"
+#include "Core/Utils/Trace.h"
 
 namespace degate
 {
@@ -89,6 +90,8 @@ namespace degate
 
     void WorkspaceAnnotations::update()
     {
+        TRACE_SCOPE_CATEGORY("render/update-annotations", "render");
+
         if (project == nullptr)
             return;
 
@@ -101,12 +104,11 @@ namespace degate
 
         // Keep only annotations of the active layer.
         std::vector<Annotation_shptr> annotations;
-        for (Layer::object_iterator iter = layer->objects_begin(); iter != layer->objects_end(); ++iter)
+        annotations.reserve(layer->get_object_count(PlacedLogicModelObject::KIND_ANNOTATION));
+        for (Layer::object_iterator iter = layer->objects_begin(PlacedLogicModelObject::KIND_ANNOTATION);
+             iter != layer->objects_end(); ++iter)
         {
-            if (Annotation_shptr a = std::dynamic_pointer_cast<Annotation>(*iter))
-            {
-                annotations.push_back(a);
-            }
+            annotations.push_back(std::static_pointer_cast<Annotation>(*iter));
         }
         annotations_count = static_cast<unsigned int>(annotations.size());
 
@@ -125,29 +127,22 @@ namespace degate
         context->glBindBuffer(GL_ARRAY_BUFFER, 0);
         vao.release();
 
-        unsigned text_size = 0;
-
         unsigned index = 0;
         for (auto& e : annotations)
         {
             create_annotation(e, index);
             e->set_index(index);
 
-            text_size += static_cast<unsigned int>(e->get_name().length());
             index++;
         }
 
-        text.update(text_size);
+        text.clear();
 
-        unsigned text_offset = 0;
         for (auto& e : annotations)
         {
             unsigned x = e->get_min_x() + (e->get_max_x() - e->get_min_x()) / 2.0;
             unsigned y = e->get_min_y() + (e->get_max_y() - e->get_min_y()) / 2.0;
-            text.add_sub_text(text_offset, x, y, e->get_name(), 20, QVector3D(255, 255, 255), 1, true, true, e->get_max_x() - e->get_min_x());
-
-            text_offset += static_cast<unsigned int>(e->get_name().length());
-            index++;
+            text.add_label(x, y, e->get_name(), 20, QVector3D(255, 255, 255), 1, true, true, e->get_max_x() - e->get_min_x());
         }
 
         assert(context->glGetError() == GL_NO_ERROR);
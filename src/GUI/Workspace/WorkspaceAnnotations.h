@@ -23,7 +23,7 @@
 #define __WORKSPACEANNOTATIONS_H__
 
 #include "WorkspaceElement.h"
-#include "GUI/Text/Text.h"
+#include "GUI/Text/TextLabels.h"
 
 namespace degate
 {
@@ -96,7 +96,7 @@ namespace degate
 
         /* Border buffer */
         GLuint line_vbo = 0;
-        Text text;
+        TextLabels text;
         unsigned annotations_count = 0;
 
     };
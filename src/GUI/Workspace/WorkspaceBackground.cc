@@ -20,7 +20,9 @@
  */
 
 #include "WorkspaceBackground.h"
+#include "Core/Utils/Trace.h"
 
+#include <set>
 #include <algorithm>
 
 #include <QtConcurrent/QtConcurrent>
@@ -49,7 +51,25 @@ namespace degate
         return (pos & ~(tile_width - 1)) + (tile_width - 1);
     }
 
-    WorkspaceBackground::WorkspaceBackground(QWidget* parent) : WorkspaceElement(parent)
+    /**
+     * Write the 6 vertices of a tile quad (in real pixel coordinates).
+     */
+    void create_background_tile(WorkspaceTilePool::TileKey const& key, unsigned int tile_size, BackgroundVertex2D* vertices)
+    {
+        const float min_x = static_cast<float>(key.x) * key.scaling;
+        const float min_y = static_cast<float>(key.y) * key.scaling;
+        const float max_x = min_x + static_cast<float>(tile_size) * key.scaling;
+        const float max_y = min_y + static_cast<float>(tile_size) * key.scaling;
+
+        vertices[0] = {QVector2D(min_x, min_y), QVector2D(0, 0)};
+        vertices[1] = {QVector2D(max_x, min_y), QVector2D(1, 0)};
+        vertices[2] = {QVector2D(min_x, max_y), QVector2D(0, 1)};
+        vertices[3] = {QVector2D(max_x, min_y), QVector2D(1, 0)};
+        vertices[4] = {QVector2D(min_x, max_y), QVector2D(0, 1)};
+        vertices[5] = {QVector2D(max_x, max_y), QVector2D(1, 1)};
+    }
+
+    WorkspaceBackground::WorkspaceBackground(QWidget* parent) : WorkspaceElement(parent), tiles(parent)
     {
 
     }
@@ -97,67 +117,94 @@ namespace degate
         delete fshader;
 
         program->link();
+
+        tiles.init();
     }
 
-    void WorkspaceBackground::update() //TODO: this is slow, try to have a thread that do that work
+    void WorkspaceBackground::update()
     {
-        free_textures();
+        visible_tiles.clear();
 
-        if (project == nullptr)
+        if (project == nullptr || project->get_logic_model()->get_current_layer() == nullptr)
+        {
+            tiles.set_source(ScalingManager_shptr());
             return;
+        }
 
-        assert(context->glGetError() == GL_NO_ERROR);
+        auto layer = project->get_logic_model()->get_current_layer();
 
-        auto smgr = project->get_logic_model()->get_current_layer()->get_scaling_manager();
+        if (layer->has_background_image() && layer->get_image_format() == Layer::IMAGE_FORMAT_GS_BYTE)
+        {
+            // Greyscale tiles are streamed as they are stored.
+            auto smgr = layer->get_greyscale_scaling_manager();
+            tiles.set_source(smgr);
 
-        if (smgr == nullptr)
-            return;
+            max_scaling = static_cast<unsigned int>(lrint(smgr->get_images().rbegin()->first));
+        }
+        else
+        {
+            auto smgr = layer->has_background_image() ? layer->get_scaling_manager() : nullptr;
+            tiles.set_source(smgr);
 
-        auto elem = smgr->get_image(scale);
+            if (smgr == nullptr)
+                return;
 
-        background_image = elem.second;
-        assert(background_image != nullptr);
+            max_scaling = static_cast<unsigned int>(lrint(smgr->get_images().rbegin()->first));
+        }
 
-        float pre_scale = static_cast<float>(elem.first);
+        update_visible_tiles();
+    }
 
-        unsigned int // scaled coordinates
-        min_x = to_lower_tile_offset(std::max<int>(std::floor(viewport_min_x / pre_scale), 0), background_image->get_tile_size()),
-        max_x = to_upper_tile_offset(std::min<int>(std::max<int>(std::ceil(viewport_max_x / pre_scale), 0), std::ceil(project->get_logic_model()->get_width() / pre_scale)), background_image->get_tile_size()),
-        min_y = to_lower_tile_offset(std::max<int>(std::floor(viewport_min_y) / pre_scale, 0), background_image->get_tile_size()),
-        max_y = to_upper_tile_offset(std::min<int>(std::max<int>(std::ceil(viewport_max_y / pre_scale), 0), std::ceil(project->get_logic_model()->get_height() / pre_scale)), background_image->get_tile_size());
+    void WorkspaceBackground::update_visible_tiles()
+    {
+        TRACE_SCOPE_CATEGORY("render/update-visible-tiles", "render");
 
-        tile_count = std::ceil((max_x - min_x) / static_cast<float>(background_image->get_tile_size())) *
-                     std::ceil((max_y - min_y) / static_cast<float>(background_image->get_tile_size()));
+        visible_tiles.clear();
 
-        vao.bind();
-        context->glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        if (project == nullptr)
+            return;
 
-        context->glBufferData(GL_ARRAY_BUFFER, tile_count * 6 * sizeof(BackgroundVertex2D), nullptr, GL_STATIC_DRAW);
+        auto layer = project->get_logic_model()->get_current_layer();
+        if (layer == nullptr || !layer->has_background_image())
+            return;
 
-        unsigned index = 0;
-        for (unsigned int x = min_x; x < max_x; x += background_image->get_tile_size())
-        {
-            for (unsigned int y = min_y; y < max_y; y += background_image->get_tile_size())
-            {
-                background_textures.push_back(create_background_tile(x, y, elem.first, index));
+        if (layer->get_image_format() == Layer::IMAGE_FORMAT_GS_BYTE)
+            update_visible_tiles(layer->get_greyscale_scaling_manager());
+        else
+            update_visible_tiles(layer->get_scaling_manager());
+    }
 
-                index++;
-            }
-        }
+    template <typename ImageType>
+    void WorkspaceBackground::update_visible_tiles(std::shared_ptr<ScalingManager<ImageType>> smgr)
+    {
+        auto elem = smgr->get_image(scale);
 
-        assert(index == tile_count);
+        std::shared_ptr<ImageType> background_image = elem.second;
+        assert(background_image != nullptr);
 
-        context->glBindBuffer(GL_ARRAY_BUFFER, 0);
-        vao.release();
+        const float pre_scale = static_cast<float>(elem.first);
+        const unsigned int scaling = static_cast<unsigned int>(lrint(elem.first));
+        const unsigned int tile_size = background_image->get_tile_size();
 
-        assert(context->glGetError() == GL_NO_ERROR);
+        unsigned int // scaled coordinates
+        min_x = to_lower_tile_offset(std::max<int>(std::floor(viewport_min_x / pre_scale), 0), tile_size),
+        max_x = to_upper_tile_offset(std::min<int>(std::max<int>(std::ceil(viewport_max_x / pre_scale), 0), std::ceil(project->get_logic_model()->get_width() / pre_scale)), tile_size),
+        min_y = to_lower_tile_offset(std::max<int>(std::floor(viewport_min_y) / pre_scale, 0), tile_size),
+        max_y = to_upper_tile_offset(std::min<int>(std::max<int>(std::ceil(viewport_max_y / pre_scale), 0), std::ceil(project->get_logic_model()->get_height() / pre_scale)), tile_size);
+
+        for (unsigned int x = min_x; x < max_x; x += tile_size)
+        {
+            for (unsigned int y = min_y; y < max_y; y += tile_size)
+                visible_tiles.push_back({scaling, x, y});
+        }
 
         if (!future.isFinished())
             return;
 
-        future.setFuture(QtConcurrent::run([this, min_x, max_x, min_y, max_y]()
+        auto image = background_image;
+        future.setFuture(QtConcurrent::run([image, min_x, max_x, min_y, max_y]()
         {
-            background_image->cache(min_x, max_x, min_y, max_y, 1);
+            image->cache(min_x, max_x, min_y, max_y, 1);
         }));
     }
 
@@ -166,12 +213,62 @@ namespace degate
         if (project == nullptr)
             return;
 
+        tiles.begin_frame();
+
+        if (visible_tiles.empty())
+            return;
+
+        const unsigned int tile_size = tiles.get_tile_size();
+
+        // Tiles to draw: placeholders (lower resolution) first, so sharp tiles are drawn over them.
+        std::vector<std::pair<WorkspaceTilePool::TileKey, GLuint>> placeholders;
+        std::vector<std::pair<WorkspaceTilePool::TileKey, GLuint>> sharp;
+        std::set<WorkspaceTilePool::TileKey> used_placeholders;
+
+        for (auto& key : visible_tiles)
+        {
+            GLuint texture = tiles.get_texture(key);
+            if (texture != 0)
+            {
+                sharp.push_back({key, texture});
+                continue;
+            }
+
+            // Search for the closest uploaded tile of a lower resolution
+            for (unsigned int scaling = key.scaling * 2; scaling <= max_scaling; scaling *= 2)
+            {
+                const unsigned int factor = scaling / key.scaling;
+                WorkspaceTilePool::TileKey coarse = {scaling,
+                                                     to_lower_tile_offset(key.x / factor, tile_size),
+                                                     to_lower_tile_offset(key.y / factor, tile_size)};
+
+                texture = tiles.get_texture(coarse, false);
+                if (texture == 0)
+                    continue;
+
+                if (used_placeholders.insert(coarse).second)
+                    placeholders.push_back({coarse, texture});
+
+                break;
+            }
+        }
+
+        placeholders.insert(placeholders.end(), sharp.begin(), sharp.end());
+
+        if (placeholders.empty())
+            return;
+
+        std::vector<BackgroundVertex2D> vertices(placeholders.size() * 6);
+        for (unsigned int i = 0; i < placeholders.size(); i++)
+            create_background_tile(placeholders[i].first, tile_size, &vertices[i * 6]);
+
         program->bind();
 
         program->setUniformValue("mvp", projection);
 
         vao.bind();
         context->glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        context->glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(BackgroundVertex2D), &vertices[0], GL_STREAM_DRAW);
 
         program->enableAttributeArray("pos");
         program->setAttributeBuffer("pos", GL_FLOAT, 0, 2, sizeof(BackgroundVertex2D));
@@ -180,9 +277,9 @@ namespace degate
         program->setAttributeBuffer("texCoord", GL_FLOAT, 2 * sizeof(float), 2, sizeof(BackgroundVertex2D));
 
         unsigned index = 0;
-        for (auto& e : background_textures)
+        for (auto& e : placeholders)
         {
-            context->glBindTexture(GL_TEXTURE_2D, e);
+            context->glBindTexture(GL_TEXTURE_2D, e.second);
             context->glDrawArrays(GL_TRIANGLES, index * 6, 6);
 
             index++;
@@ -198,12 +295,7 @@ namespace degate
 
     void WorkspaceBackground::free_textures()
     {
-        if (background_textures.empty())
-            return;
-
-        context->glDeleteTextures(static_cast<GLsizei>(background_textures.size()), &background_textures[0]);
-
-        background_textures.clear();
+        tiles.free_textures();
     }
 
     void WorkspaceBackground::update_viewport(float min_x, float max_x, float min_y, float max_y, float width, float height)
@@ -218,94 +310,6 @@ namespace degate
         virtual_width = width;
         virtual_height = height;
 
-        update();
-    }
-
-    GLuint WorkspaceBackground::create_background_tile(unsigned x, unsigned y, float pre_scaling, unsigned index)
-    {
-        assert(project != nullptr);
-        assert(background_image != nullptr);
-
-        auto data = background_image->data(x, y);
-
-        assert(data != nullptr);
-
-        const unsigned int tile_width = background_image->get_tile_size();
-
-        // Real pixel coordinates
-        float min_x = (static_cast<float>(x)) * pre_scaling;
-        float min_y = (static_cast<float>(y)) * pre_scaling;
-        float max_x = min_x + static_cast<float>(tile_width) * pre_scaling;
-        float max_y = min_y + static_cast<float>(tile_width) * pre_scaling;
-
-
-        // Texture
-
-        GLuint texture = 0;
-
-        context->glGenTextures(1, &texture);
-        assert(context->glGetError() == GL_NO_ERROR);
-
-        context->glBindTexture(GL_TEXTURE_2D, texture);
-        assert(context->glGetError() == GL_NO_ERROR);
-
-        context->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        assert(context->glGetError() == GL_NO_ERROR);
-
-        context->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        assert(context->glGetError() == GL_NO_ERROR);
-
-        context->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        assert(context->glGetError() == GL_NO_ERROR);
-
-        context->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        assert(context->glGetError() == GL_NO_ERROR);
-
-        //context->glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_FALSE);
-        assert(context->glGetError() == GL_NO_ERROR);
-
-        context->glTexImage2D(GL_TEXTURE_2D,
-                     0, // level
-                     GL_RGBA, // BGRA,
-                     tile_width, tile_width,
-                     0, // border
-                     GL_RGBA,
-                     GL_UNSIGNED_BYTE,
-                     data);
-        assert(context->glGetError() == GL_NO_ERROR);
-
-        context->glBindTexture(GL_TEXTURE_2D, 0);
-
-
-        // Vertices
-
-        BackgroundVertex2D temp;
-
-        temp.pos = QVector2D(min_x, min_y);
-        temp.texCoord = QVector2D(0, 0);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 6 * sizeof(BackgroundVertex2D) + 0 * sizeof(BackgroundVertex2D), sizeof(BackgroundVertex2D), &temp);
-
-        temp.pos = QVector2D(max_x, min_y);
-        temp.texCoord = QVector2D(1, 0);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 6 * sizeof(BackgroundVertex2D) + 1 * sizeof(BackgroundVertex2D), sizeof(BackgroundVertex2D), &temp);
-
-        temp.pos = QVector2D(min_x, max_y);
-        temp.texCoord = QVector2D(0, 1);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 6 * sizeof(BackgroundVertex2D) + 2 * sizeof(BackgroundVertex2D), sizeof(BackgroundVertex2D), &temp);
-
-        temp.pos = QVector2D(max_x, min_y);
-        temp.texCoord = QVector2D(1, 0);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 6 * sizeof(BackgroundVertex2D) + 3 * sizeof(BackgroundVertex2D), sizeof(BackgroundVertex2D), &temp);
-
-        temp.pos = QVector2D(min_x, max_y);
-        temp.texCoord = QVector2D(0, 1);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 6 * sizeof(BackgroundVertex2D) + 4 * sizeof(BackgroundVertex2D), sizeof(BackgroundVertex2D), &temp);
-
-        temp.pos = QVector2D(max_x, max_y);
-        temp.texCoord = QVector2D(1, 1);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 6 * sizeof(BackgroundVertex2D) + 5 * sizeof(BackgroundVertex2D), sizeof(BackgroundVertex2D), &temp);
-
-
-        return texture;
+        update_visible_tiles();
     }
 }
@@ -23,6 +23,7 @@
 #define __WORKSPACEBACKGROUND_H__
 
 #include "WorkspaceElement.h"
+#include "WorkspaceTilePool.h"
 
 #include <vector>
 
@@ -34,6 +35,9 @@ namespace degate
     /**
      * @class WorkspaceBackground
      * @brief Draw the current layer image (as background).
+     *
+     * Tiles are streamed through a texture pool (@see WorkspaceTilePool). While a tile is not uploaded yet,
+     * an already uploaded tile of a lower resolution is drawn in its place.
      */
     class WorkspaceBackground : public WorkspaceElement
     {
@@ -54,12 +58,12 @@ namespace degate
         void init() override;
 
         /**
-         * Update the background (all textures are reloaded).
+         * Update the background (tiles are reloaded if the layer image changed).
          */
         void update() override;
 
         /**
-         * Draw the background (all tiles will be draw).
+         * Draw the background (all visible tiles will be drawn, or their placeholders).
          *
          * @param projection : the projection matrix to apply.
          */
@@ -84,26 +88,24 @@ namespace degate
 
     private:
         /**
-         * Create a background tile (OpenGL texture and vertices).
-         *
-         * @param x
-         * @param y
-         * @param pre_scaling : scaling of the image.
-         * @param index : index of the tile.
-         *
-         * @return Returns the OpenGL texture ID of the tile.
+         * Compute the tiles covering the viewport, with the best prescaled image for the current scale.
+         */
+        void update_visible_tiles();
+
+        /**
+         * Compute the visible tiles from the prescaled images of \p smgr (RGBA or greyscale).
          */
-        GLuint create_background_tile(unsigned int x, unsigned int y, float pre_scaling, unsigned index);
+        template <typename ImageType>
+        void update_visible_tiles(std::shared_ptr<ScalingManager<ImageType>> smgr);
 
-        std::vector<GLuint> background_textures;
-        BackgroundImage_shptr background_image = nullptr;
+        WorkspaceTilePool tiles;
+        std::vector<WorkspaceTilePool::TileKey> visible_tiles;
+        unsigned int max_scaling = 1;
 
         float scale = 1;
         float viewport_min_x = 0, viewport_min_y = 0, viewport_max_x = 0, viewport_max_y = 0;
         float virtual_width = 0, virtual_height = 0;
 
-        unsigned int tile_count = 0;
-
         QFutureWatcher<void> future;
     };
 }
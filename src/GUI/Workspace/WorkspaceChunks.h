@@ -0,0 +1,463 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __WORKSPACECHUNKS_H__
+#define __WORKSPACECHUNKS_H__
+
+#include "Core/Primitive/BoundingBox.h"
+
+#include <QtOpenGL/QtOpenGL>
+#include <QtConcurrent/QtConcurrent>
+#include <boost/range/counting_range.hpp>
+
+#include <map>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+
+/**
+ * Minimal size (in pixels) of a chunk side.
+ */
+#define WORKSPACE_CHUNK_MIN_SIZE 512
+
+/**
+ * Maximal depth of the chunk grid (at most 2^depth x 2^depth chunks).
+ */
+#define WORKSPACE_CHUNK_MAX_DEPTH 8
+
+/**
+ * Under this number of objects to rebuild, the geometry is generated on the calling thread.
+ */
+#define WORKSPACE_CHUNK_MIN_PARALLEL_OBJECTS 4096
+
+namespace degate
+{
+
+    /**
+     * @class WorkspaceChunks
+     * @brief Store the geometry of workspace objects in spatial chunks, each with its own vbo.
+     *
+     * The area of the layer is split into a regular grid of chunks. Like the layer quadtree, each level of the
+     * grid halves the area, so a chunk always covers the same area than a quadtree node of the same depth.
+     * An object belongs to the chunk containing the center of its bounding box.
+     *
+     * Only chunks intersecting the viewport are drawn. An inserted, removed or changed object only marks its
+     * chunk(s) as dirty, dirty chunks are rebuilt when they become visible. The geometry of all chunks to rebuild is generated
+     * on worker threads, directly into the mapped vbo of each chunk (one mapped write per chunk).
+     *
+     * @warning Except for the generator function, everything must be called with the OpenGL context of the
+     * element current (@see WorkspaceElement).
+     */
+    template <typename ObjectType, typename VertexType>
+    class WorkspaceChunks
+    {
+    public:
+
+        typedef std::shared_ptr<ObjectType> object_shptr;
+
+        /**
+         * Fill the vertices of an object. This is called from worker threads.
+         * The vertices pointer points to vertices_per_object vertices.
+         */
+        typedef std::function<void(object_shptr const& object, VertexType* vertices)> generator_type;
+
+        /**
+         * Get the area covered by the geometry of an object (used for the viewport culling).
+         */
+        typedef std::function<BoundingBox(object_shptr const& object)> extent_type;
+
+        /**
+         * Create an empty chunk grid.
+         *
+         * @param vertices_per_object : the number of vertices of each object.
+         * @param generator : the function filling the vertices of an object.
+         * @param extent : the function returning the area covered by an object (the bounding box by default).
+         * @param primitive : the OpenGL primitive used to draw the vertices (GL_TRIANGLES or GL_LINES).
+         */
+        WorkspaceChunks(unsigned vertices_per_object, generator_type generator, extent_type extent = nullptr, GLenum primitive = GL_TRIANGLES)
+                : vertices_per_object(vertices_per_object), generator(generator), extent(extent), primitive(primitive)
+        {
+            if (this->extent == nullptr)
+                this->extent = [](object_shptr const& object) { return object->get_bounding_box(); };
+        }
+
+        ~WorkspaceChunks()
+        {
+            clear();
+        }
+
+        /**
+         * Set the OpenGL context, call it from the init function of the element.
+         */
+        void init(QOpenGLContext* gl_context)
+        {
+            context = gl_context->functions();
+            extra_context = gl_context->extraFunctions();
+        }
+
+        /**
+         * Drop all chunks and distribute objects on a new chunk grid.
+         *
+         * @param area : the area of the layer (@see Layer::get_bounding_box).
+         * @param objects : all objects to draw.
+         */
+        void reset(BoundingBox const& area, std::vector<object_shptr> const& objects)
+        {
+            clear();
+
+            origin_x = area.get_min_x();
+            origin_y = area.get_min_y();
+
+            const float width = std::max(area.get_width(), 1.0f);
+            const float height = std::max(area.get_height(), 1.0f);
+
+            unsigned depth = 0;
+            while (depth < WORKSPACE_CHUNK_MAX_DEPTH &&
+                   width / static_cast<float>(2u << depth) >= WORKSPACE_CHUNK_MIN_SIZE &&
+                   height / static_cast<float>(2u << depth) >= WORKSPACE_CHUNK_MIN_SIZE)
+                depth++;
+
+            columns = 1u << depth;
+            chunk_width = width / static_cast<float>(columns);
+            chunk_height = height / static_cast<float>(columns);
+
+            for (auto& object : objects)
+                add(object);
+        }
+
+        /**
+         * Add an object to the chunk containing its center and mark this chunk as dirty.
+         * If the object is already stored, it is updated instead.
+         *
+         * @param object : the new object.
+         */
+        void insert(object_shptr const& object)
+        {
+            if (object == nullptr)
+                return;
+
+            if (placement.find(object.get()) != placement.end())
+            {
+                update(object);
+                return;
+            }
+
+            add(object);
+        }
+
+        /**
+         * Remove an object from its chunk and mark this chunk as dirty. A chunk without objects is dropped.
+         *
+         * @param object : the object to remove.
+         */
+        void remove(object_shptr const& object)
+        {
+            if (object == nullptr)
+                return;
+
+            auto iter = placement.find(object.get());
+            if (iter == placement.end())
+                return;
+
+            auto chunk_iter = chunks.find(iter->second);
+            placement.erase(iter);
+
+            if (chunk_iter == chunks.end())
+                return;
+
+            Chunk& chunk = chunk_iter->second;
+
+            auto object_iter = std::find(chunk.objects.begin(), chunk.objects.end(), object);
+            if (object_iter != chunk.objects.end())
+            {
+                std::swap(*object_iter, chunk.objects.back());
+                chunk.objects.pop_back();
+            }
+
+            chunk.dirty = true;
+
+            if (chunk.objects.empty())
+            {
+                if (chunk.vbo != 0 && context != nullptr)
+                    context->glDeleteBuffers(1, &chunk.vbo);
+
+                chunks.erase(chunk_iter);
+            }
+        }
+
+        /**
+         * Update a specific object. The object is moved to its new chunk if needed and the chunk(s) marked as dirty.
+         *
+         * @param object : the changed object.
+         */
+        void update(object_shptr const& object)
+        {
+            if (object == nullptr)
+                return;
+
+            auto iter = placement.find(object.get());
+            if (iter == placement.end())
+                return;
+
+            const unsigned key = get_chunk_key(object);
+
+            if (key == iter->second)
+            {
+                Chunk& chunk = chunks[key];
+                chunk.dirty = true;
+                chunk.bounds = merge(chunk.bounds, extent(object));
+
+                return;
+            }
+
+            remove(object);
+            add(object);
+        }
+
+        /**
+         * Draw all visible chunks (with the primitive of the chunks), rebuild dirty ones first.
+         * The shader program and the vao must be bound.
+         *
+         * @param projection : the projection matrix, used to get the viewport.
+         * @param set_attributes : set the attribute buffers of the program for the bound vbo.
+         */
+        void draw(const QMatrix4x4& projection, std::function<void()> set_attributes)
+        {
+            if (context == nullptr || chunks.empty())
+                return;
+
+            // For an orthographic projection, the corners of the clip space give the viewport.
+            const QMatrix4x4 inverse = projection.inverted();
+            const QVector3D a = inverse.map(QVector3D(-1, -1, 0));
+            const QVector3D b = inverse.map(QVector3D(1, 1, 0));
+            const BoundingBox viewport(std::min(a.x(), b.x()), std::max(a.x(), b.x()),
+                                       std::min(a.y(), b.y()), std::max(a.y(), b.y()));
+
+            std::vector<Chunk*> visible;
+            for (auto& e : chunks)
+            {
+                if (e.second.bounds.intersects(viewport))
+                    visible.push_back(&e.second);
+            }
+
+            rebuild(visible);
+
+            for (auto& chunk : visible)
+            {
+                if (chunk->vertices_count == 0)
+                    continue;
+
+                context->glBindBuffer(GL_ARRAY_BUFFER, chunk->vbo);
+                set_attributes();
+                context->glDrawArrays(primitive, 0, chunk->vertices_count);
+            }
+
+            context->glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+
+        /**
+         * Get the number of objects in all chunks.
+         */
+        unsigned get_objects_count() const
+        {
+            return static_cast<unsigned>(placement.size());
+        }
+
+        /**
+         * Drop all chunks (and delete their vbo).
+         */
+        void clear()
+        {
+            if (context != nullptr && QOpenGLContext::currentContext() != nullptr)
+            {
+                for (auto& e : chunks)
+                {
+                    if (e.second.vbo != 0)
+                        context->glDeleteBuffers(1, &e.second.vbo);
+                }
+            }
+
+            chunks.clear();
+            placement.clear();
+        }
+
+    private:
+
+        struct Chunk
+        {
+            GLuint vbo = 0;
+            bool dirty = true;
+            unsigned vertices_count = 0;
+            BoundingBox bounds;
+            std::vector<object_shptr> objects;
+        };
+
+        /**
+         * Get the union of two boxes.
+         */
+        static BoundingBox merge(BoundingBox const& a, BoundingBox const& b)
+        {
+            return BoundingBox(std::min(a.get_min_x(), b.get_min_x()), std::max(a.get_max_x(), b.get_max_x()),
+                               std::min(a.get_min_y(), b.get_min_y()), std::max(a.get_max_y(), b.get_max_y()));
+        }
+
+        unsigned get_chunk_key(object_shptr const& object) const
+        {
+            const BoundingBox& box = object->get_bounding_box();
+
+            const float x = (box.get_center_x() - origin_x) / chunk_width;
+            const float y = (box.get_center_y() - origin_y) / chunk_height;
+
+            const unsigned column = static_cast<unsigned>(std::min(std::max(x, 0.0f), static_cast<float>(columns - 1)));
+            const unsigned row = static_cast<unsigned>(std::min(std::max(y, 0.0f), static_cast<float>(columns - 1)));
+
+            return row * columns + column;
+        }
+
+        void add(object_shptr const& object)
+        {
+            const unsigned key = get_chunk_key(object);
+
+            Chunk& chunk = chunks[key];
+            chunk.bounds = chunk.objects.empty() ? extent(object) : merge(chunk.bounds, extent(object));
+            chunk.objects.push_back(object);
+            chunk.dirty = true;
+
+            placement[object.get()] = key;
+        }
+
+        /**
+         * Rebuild the dirty chunks of a list of chunks.
+         */
+        void rebuild(std::vector<Chunk*> const& candidates)
+        {
+            std::vector<Chunk*> dirty;
+            size_t objects_count = 0;
+
+            for (auto& chunk : candidates)
+            {
+                if (!chunk->dirty)
+                    continue;
+
+                dirty.push_back(chunk);
+                objects_count += chunk->objects.size();
+            }
+
+            if (dirty.empty())
+                return;
+
+            // Map the vbo of every dirty chunk (if mapping fails, fill a host buffer instead).
+            std::vector<VertexType*> targets(dirty.size(), nullptr);
+            std::vector<std::vector<VertexType>> fallbacks(dirty.size());
+
+            for (size_t i = 0; i < dirty.size(); i++)
+            {
+                Chunk* chunk = dirty[i];
+
+                if (chunk->vbo == 0)
+                    context->glGenBuffers(1, &chunk->vbo);
+
+                chunk->vertices_count = static_cast<unsigned>(chunk->objects.size()) * vertices_per_object;
+                const GLsizeiptr size = chunk->vertices_count * sizeof(VertexType);
+
+                context->glBindBuffer(GL_ARRAY_BUFFER, chunk->vbo);
+                context->glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STATIC_DRAW);
+
+                targets[i] = static_cast<VertexType*>(extra_context->glMapBufferRange(GL_ARRAY_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+
+                if (targets[i] == nullptr)
+                {
+                    fallbacks[i].resize(chunk->vertices_count);
+                    targets[i] = fallbacks[i].data();
+                }
+            }
+
+            // Multi-threaded function
+            std::function<void(const size_t& index)> fill = [&](const size_t& index)
+            {
+                Chunk* chunk = dirty[index];
+                VertexType* vertices = targets[index];
+
+                BoundingBox bounds = extent(chunk->objects.front());
+                for (auto& object : chunk->objects)
+                {
+                    generator(object, vertices);
+                    vertices += vertices_per_object;
+
+                    bounds = merge(bounds, extent(object));
+                }
+
+                chunk->bounds = bounds;
+            };
+
+            if (objects_count < WORKSPACE_CHUNK_MIN_PARALLEL_OBJECTS || dirty.size() == 1)
+            {
+                for (size_t i = 0; i < dirty.size(); i++)
+                    fill(i);
+            }
+            else
+            {
+                // Start multithreading
+                const auto& it = boost::counting_range<size_t>(0, dirty.size());
+                QtConcurrent::blockingMap(it, fill);
+            }
+
+            for (size_t i = 0; i < dirty.size(); i++)
+            {
+                Chunk* chunk = dirty[i];
+
+                context->glBindBuffer(GL_ARRAY_BUFFER, chunk->vbo);
+
+                if (fallbacks[i].empty())
+                {
+                    // The content of the buffer is undefined if unmapping failed, rebuild it on next draw.
+                    chunk->dirty = extra_context->glUnmapBuffer(GL_ARRAY_BUFFER) == GL_FALSE;
+                }
+                else
+                {
+                    context->glBufferSubData(GL_ARRAY_BUFFER, 0, chunk->vertices_count * sizeof(VertexType), fallbacks[i].data());
+                    chunk->dirty = false;
+                }
+            }
+
+            context->glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+
+        unsigned vertices_per_object;
+        generator_type generator;
+        extent_type extent;
+        GLenum primitive;
+
+        QOpenGLFunctions* context = nullptr;
+        QOpenGLExtraFunctions* extra_context = nullptr;
+
+        float origin_x = 0, origin_y = 0;
+        float chunk_width = 1, chunk_height = 1;
+        unsigned columns = 1;
+
+        std::map<unsigned, Chunk> chunks;
+        std::unordered_map<ObjectType*, unsigned> placement;
+    };
+}
+
+#endif //__WORKSPACECHUNKS_H__
@@ -20,19 +20,16 @@
  */
 
 #include "WorkspaceEMarkers.h"
+#include "Core/Utils/Trace.h"
 
 #define TEXT_PADDING 2
 
 namespace degate
 {
-    struct EMarkersVertex2D
-    {
-        QVector2D pos;
-        QVector3D color;
-        float alpha;
-    };
-
-    WorkspaceEMarkers::WorkspaceEMarkers(QWidget *parent) : WorkspaceElement(parent), text(parent)
+    WorkspaceEMarkers::WorkspaceEMarkers(QWidget *parent)
+            : WorkspaceElement(parent),
+              text(parent),
+              chunks(6, std::bind(&WorkspaceEMarkers::create_emarker, this, std::placeholders::_1, std::placeholders::_2))
     {
 
     }
@@ -48,6 +45,8 @@ namespace degate
 
         text.init();
 
+        chunks.init(QOpenGLContext::currentContext());
+
         QOpenGLShader* vshader = new QOpenGLShader(QOpenGLShader::Vertex);
         const char* vsrc =
                 "#version 330 core\n"
@@ -86,6 +85,8 @@ namespace degate
 
     void WorkspaceEMarkers::update()
     {
+        TRACE_SCOPE_CATEGORY("render/update-emarkers", "render");
+
         if (project == nullptr)
             return;
 
@@ -94,69 +95,63 @@ namespace degate
         Layer_shptr layer = project->get_logic_model()->get_current_layer();
 
         if (layer == nullptr)
+        {
+            chunks.clear();
             return;
+        }
 
         // Keep only emarkers of the active layer.
         std::vector<EMarker_shptr> emarkers;
-        for (Layer::object_iterator iter = layer->objects_begin(); iter != layer->objects_end(); ++iter)
+        emarkers.reserve(layer->get_object_count(PlacedLogicModelObject::KIND_EMARKER));
+        for (Layer::object_iterator iter = layer->objects_begin(PlacedLogicModelObject::KIND_EMARKER);
+             iter != layer->objects_end(); ++iter)
         {
-            if (EMarker_shptr a = std::dynamic_pointer_cast<EMarker>(*iter))
-            {
-                emarkers.push_back(a);
-            }
+            emarkers.push_back(std::static_pointer_cast<EMarker>(*iter));
         }
-        emarkers_count = static_cast<unsigned int>(emarkers.size());
-
-        if (emarkers_count == 0)
-            return;
-
-        vao.bind();
-        context->glBindBuffer(GL_ARRAY_BUFFER, vbo);
 
-        context->glBufferData(GL_ARRAY_BUFFER, emarkers_count * 6 * sizeof(EMarkersVertex2D), nullptr, GL_STATIC_DRAW);
+        // Geometry is generated lazily, when a chunk becomes visible.
+        chunks.reset(layer->get_bounding_box(), emarkers);
 
-        context->glBindBuffer(GL_ARRAY_BUFFER, 0);
-        vao.release();
-
-        unsigned text_size = 0;
+        text.clear();
 
-        unsigned index = 0;
         for (auto& e : emarkers)
-        {
-            create_emarker(e, index);
-            e->set_index(index);
+            add_label(e);
 
-            text_size += static_cast<unsigned int>(e->get_name().length());
-            index++;
-        }
+        assert(context->glGetError() == GL_NO_ERROR);
+    }
+
+    void WorkspaceEMarkers::update(EMarker_shptr &emarker)
+    {
+        if (emarker == nullptr)
+            return;
 
-        text.update(text_size);
+        chunks.update(emarker);
 
-        unsigned text_offset = 0;
-        for (auto& e : emarkers)
-        {
-            unsigned x = e->get_x();
-            unsigned y = e->get_y() + e->get_diameter() / 2.0 + TEXT_PADDING;
-            text.add_sub_text(text_offset, x, y, e->get_name(), 5, QVector3D(255, 255, 255), 1, true, false);
+        text.remove_labels(emarker->get_object_id());
+        add_label(emarker);
+    }
 
-            text_offset += static_cast<unsigned int>(e->get_name().length());
-            index++;
-        }
+    void WorkspaceEMarkers::insert(EMarker_shptr& emarker)
+    {
+        if (emarker == nullptr)
+            return;
 
-        assert(context->glGetError() == GL_NO_ERROR);
+        chunks.insert(emarker);
+        add_label(emarker);
     }
 
-    void WorkspaceEMarkers::update(EMarker_shptr &emarker)
+    void WorkspaceEMarkers::remove(EMarker_shptr& emarker)
     {
         if (emarker == nullptr)
             return;
 
-        create_emarker(emarker, emarker->get_index());
+        chunks.remove(emarker);
+        text.remove_labels(emarker->get_object_id());
     }
 
     void WorkspaceEMarkers::draw(const QMatrix4x4 &projection)
     {
-        if (project == nullptr || emarkers_count == 0)
+        if (project == nullptr || chunks.get_objects_count() == 0)
             return;
 
         program->bind();
@@ -164,20 +159,19 @@ namespace degate
         program->setUniformValue("mvp", projection);
 
         vao.bind();
-        context->glBindBuffer(GL_ARRAY_BUFFER, vbo);
 
-        program->enableAttributeArray("pos");
-        program->setAttributeBuffer("pos", GL_FLOAT, 0, 2, sizeof(EMarkersVertex2D));
-
-        program->enableAttributeArray("color");
-        program->setAttributeBuffer("color", GL_FLOAT, 2 * sizeof(float), 3, sizeof(EMarkersVertex2D));
+        chunks.draw(projection, [this]()
+        {
+            program->enableAttributeArray("pos");
+            program->setAttributeBuffer("pos", GL_FLOAT, 0, 2, sizeof(EMarkersVertex2D));
 
-        program->enableAttributeArray("alpha");
-        program->setAttributeBuffer("alpha", GL_FLOAT, 5 * sizeof(float), 1, sizeof(EMarkersVertex2D));
+            program->enableAttributeArray("color");
+            program->setAttributeBuffer("color", GL_FLOAT, 2 * sizeof(float), 3, sizeof(EMarkersVertex2D));
 
-        context->glDrawArrays(GL_TRIANGLES, 0, emarkers_count * 6);
+            program->enableAttributeArray("alpha");
+            program->setAttributeBuffer("alpha", GL_FLOAT, 5 * sizeof(float), 1, sizeof(EMarkersVertex2D));
+        });
 
-        context->glBindBuffer(GL_ARRAY_BUFFER, 0);
         vao.release();
 
         program->release();
@@ -185,20 +179,14 @@ namespace degate
 
     void WorkspaceEMarkers::draw_name(const QMatrix4x4 &projection)
     {
-        if (project == nullptr || emarkers_count == 0)
+        if (project == nullptr || chunks.get_objects_count() == 0)
             return;
 
         text.draw(projection);
     }
 
-    void WorkspaceEMarkers::create_emarker(EMarker_shptr &emarker, unsigned int index)
+    void WorkspaceEMarkers::create_emarker(const EMarker_shptr &emarker, EMarkersVertex2D* vertices) const
     {
-        if (emarker == nullptr)
-            return;
-
-        vao.bind();
-        context->glBindBuffer(GL_ARRAY_BUFFER, vbo);
-
         // Vertices and colors
 
         color_t color = emarker->get_fill_color() == 0 ? project->get_default_color(DEFAULT_COLOR_EMARKER) : emarker->get_fill_color();
@@ -210,24 +198,28 @@ namespace degate
         temp.alpha = MASK_A(color) / 255.0;
 
         temp.pos = QVector2D(emarker->get_x() - emarker->get_diameter() / 2.0, emarker->get_y() - emarker->get_diameter() / 2.0);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 6 * sizeof(EMarkersVertex2D) + 0 * sizeof(EMarkersVertex2D), sizeof(EMarkersVertex2D), &temp);
+        vertices[0] = temp;
 
         temp.pos = QVector2D(emarker->get_x() + emarker->get_diameter() / 2.0, emarker->get_y() - emarker->get_diameter() / 2.0);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 6 * sizeof(EMarkersVertex2D) + 1 * sizeof(EMarkersVertex2D), sizeof(EMarkersVertex2D), &temp);
+        vertices[1] = temp;
 
         temp.pos = QVector2D(emarker->get_x() + emarker->get_diameter() / 2.0, emarker->get_y() + emarker->get_diameter() / 2.0);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 6 * sizeof(EMarkersVertex2D) + 2 * sizeof(EMarkersVertex2D), sizeof(EMarkersVertex2D), &temp);
+        vertices[2] = temp;
 
         temp.pos = QVector2D(emarker->get_x() - emarker->get_diameter() / 2.0, emarker->get_y() - emarker->get_diameter() / 2.0);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 6 * sizeof(EMarkersVertex2D) + 4 * sizeof(EMarkersVertex2D), sizeof(EMarkersVertex2D), &temp);
+        vertices[4] = temp;
 
         temp.pos = QVector2D(emarker->get_x() - emarker->get_diameter() / 2.0, emarker->get_y() + emarker->get_diameter() / 2.0);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 6 * sizeof(EMarkersVertex2D) + 3 * sizeof(EMarkersVertex2D), sizeof(EMarkersVertex2D), &temp);
+        vertices[3] = temp;
 
         temp.pos = QVector2D(emarker->get_x() + emarker->get_diameter() / 2.0, emarker->get_y() + emarker->get_diameter() / 2.0);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 6 * sizeof(EMarkersVertex2D) + 5 * sizeof(EMarkersVertex2D), sizeof(EMarkersVertex2D), &temp);
+        vertices[5] = temp;
+    }
 
-        context->glBindBuffer(GL_ARRAY_BUFFER, 0);
-        vao.release();
+    void WorkspaceEMarkers::add_label(const EMarker_shptr& emarker)
+    {
+        unsigned x = emarker->get_x();
+        unsigned y = emarker->get_y() + emarker->get_diameter() / 2.0 + TEXT_PADDING;
+        text.add_label(x, y, emarker->get_name(), 5, QVector3D(255, 255, 255), 1, true, false, 0, emarker->get_object_id());
     }
 }
\ No newline at end of file
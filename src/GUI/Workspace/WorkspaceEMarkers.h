@@ -23,17 +23,24 @@
 #define __WORKSPACEEMARKERS_H__
 
 #include "GUI/Workspace/WorkspaceElement.h"
+#include "GUI/Workspace/WorkspaceChunks.h"
 #include "Core/LogicModel/EMarker/EMarker.h"
-#include "GUI/Text/Text.h"
+#include "GUI/Text/TextLabels.h"
 
 namespace degate
 {
+    struct EMarkersVertex2D
+    {
+        QVector2D pos;
+        QVector3D color;
+        float alpha;
+    };
 
     /**
      * @class WorkspaceEMarkers
      * @brief Prepare and draw all emarkers of the active layer on the workspace.
      *
-     * The parent vbo buffer will store all squares.
+     * Emarkers are stored in spatial chunks, each chunk has its own vbo (@see WorkspaceChunks).
      *
      * @see WorkspaceElement
      */
@@ -61,7 +68,7 @@ namespace degate
         void update() override;
 
         /**
-         * Update a specific emarker (update buffers).
+         * Update a specific emarker (mark its chunk as dirty and replace its name label).
          *
          * @warning Call the update() function before.
          *
@@ -70,7 +77,21 @@ namespace degate
         void update(EMarker_shptr& emarker);
 
         /**
-         * Draw all emarkers (draw the square and outline buffers).
+         * Add a new emarker of the active layer (only its chunk is rebuilt).
+         *
+         * @param emarker : the new emarker.
+         */
+        void insert(EMarker_shptr& emarker);
+
+        /**
+         * Remove a emarker (only its chunk is rebuilt).
+         *
+         * @param emarker : the removed emarker.
+         */
+        void remove(EMarker_shptr& emarker);
+
+        /**
+         * Draw all emarkers of the chunks intersecting the viewport.
          *
          * @param projection : the projection matrix to apply.
          */
@@ -85,15 +106,22 @@ namespace degate
 
     private:
         /**
-         * Create an emarker in OpenGL buffers.
+         * Create the vertices of an emarker (called from worker threads).
+         *
+         * @param emarker : the emarker object.
+         * @param vertices : the 6 vertices to fill.
+         */
+        void create_emarker(const EMarker_shptr& emarker, EMarkersVertex2D* vertices) const;
+
+        /**
+         * Add the name label of a emarker.
          *
          * @param emarker : the emarker object.
-         * @param index : the index of the annotation for OpenGL buffers.
          */
-        void create_emarker(EMarker_shptr& emarker, unsigned index);
+        void add_label(const EMarker_shptr& emarker);
 
-        Text text;
-        unsigned emarkers_count = 0;
+        TextLabels text;
+        WorkspaceChunks<EMarker, EMarkersVertex2D> chunks;
 
     };
 }
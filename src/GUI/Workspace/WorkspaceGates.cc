@@ -20,32 +20,27 @@
  */
 
 #include "WorkspaceGates.h"
+#include "Core/Utils/Trace.h"
 
 #define TEXT_PADDING 2
 
 namespace degate
 {
-    struct GatesVertex2D
-    {
-        QVector2D pos;
-        QVector3D color;
-        float alpha;
-    };
-
     WorkspaceGates::WorkspaceGates(QWidget* parent)
             : WorkspaceElement(parent),
               gate_template_name_text(parent),
-              port_name_text(parent)
+              port_name_text(parent),
+              gate_chunks(6, std::bind(&WorkspaceGates::create_gate, this, std::placeholders::_1, std::placeholders::_2)),
+              outline_chunks(8,
+                             std::bind(&WorkspaceGates::create_gate_outline, this, std::placeholders::_1, std::placeholders::_2),
+                             nullptr,
+                             GL_LINES),
+              port_chunks(9, std::bind(&WorkspaceGates::create_port, this, std::placeholders::_1, std::placeholders::_2))
     {
     }
 
     WorkspaceGates::~WorkspaceGates()
     {
-        if (context->glIsBuffer(line_vbo) == GL_TRUE)
-            context->glDeleteBuffers(1, &line_vbo);
-
-        if (context->glIsBuffer(port_vbo) == GL_TRUE)
-            context->glDeleteBuffers(1, &port_vbo);
     }
 
     void WorkspaceGates::init()
@@ -55,6 +50,10 @@ namespace degate
         gate_template_name_text.init();
         port_name_text.init();
 
+        gate_chunks.init(QOpenGLContext::currentContext());
+        outline_chunks.init(QOpenGLContext::currentContext());
+        port_chunks.init(QOpenGLContext::currentContext());
+
         QOpenGLShader* vshader = new QOpenGLShader(QOpenGLShader::Vertex);
         const char* vsrc =
             "#version 330 core\n"
@@ -90,128 +89,93 @@ namespace degate
         delete vshader;
         delete fshader;
 
-        context->glGenBuffers(1, &line_vbo);
-        context->glGenBuffers(1, &port_vbo);
-
         context->glEnable(GL_LINE_SMOOTH);
     }
 
     void WorkspaceGates::update()
     {
-        if (project == nullptr || project->get_logic_model()->get_gates_count() == 0)
+        TRACE_SCOPE_CATEGORY("render/update-gates", "render");
+
+        if (project == nullptr)
             return;
 
         assert(context->glGetError() == GL_NO_ERROR);
 
-        vao.bind();
-        context->glBindBuffer(GL_ARRAY_BUFFER, vbo);
-
-        context->glBufferData(GL_ARRAY_BUFFER, project->get_logic_model()->get_gates_count() * 6 * sizeof(GatesVertex2D), nullptr, GL_STATIC_DRAW);
-
-        context->glBindBuffer(GL_ARRAY_BUFFER, line_vbo);
+        LogicModel_shptr lmodel = project->get_logic_model();
 
-        context->glBufferData(GL_ARRAY_BUFFER, project->get_logic_model()->get_gates_count() * 8 * sizeof(GatesVertex2D), nullptr, GL_STATIC_DRAW);
+        std::vector<Gate_shptr> gates;
+        std::vector<GatePort_shptr> ports;
 
-        context->glBindBuffer(GL_ARRAY_BUFFER, 0);
+        gates.reserve(lmodel->get_gates_count());
+        gate_ports.clear();
 
-        unsigned gate_template_name_text_size = 0;
-        unsigned port_name_text_size = 0;
-        ports_count = 0;
-
-        unsigned index = 0;
-        for (LogicModel::gate_collection::iterator iter = project->get_logic_model()->gates_begin(); iter != project->get_logic_model()->gates_end(); ++iter)
+        for (LogicModel::gate_collection::iterator iter = lmodel->gates_begin(); iter != lmodel->gates_end(); ++iter)
         {
-            create_gate(iter->second, index);
-            iter->second->set_index(index);
-
-            gate_template_name_text_size += static_cast<unsigned int>(iter->second->get_gate_template()->get_name().length());
+            gates.push_back(iter->second);
 
-            if (!iter->second->get_name().empty())
-                gate_template_name_text_size += static_cast<unsigned int>(iter->second->get_name().length()) + 3;
-
-            ports_count += iter->second->get_ports_number();
-
-            for (Gate::port_iterator port_iter = iter->second->ports_begin(); port_iter != iter->second->ports_end(); ++port_iter)
+            std::vector<GatePort_shptr>& current_ports = gate_ports[iter->second->get_object_id()];
+            for (auto port_iter = iter->second->ports_begin(); port_iter != iter->second->ports_end(); ++port_iter)
             {
-                port_name_text_size += static_cast<unsigned int>((*port_iter)->get_name().length());
+                current_ports.push_back(*port_iter);
+                ports.push_back(*port_iter);
             }
-
-            index++;
         }
 
-        gate_template_name_text.update(gate_template_name_text_size);
-        port_name_text.update(port_name_text_size);
-
-        context->glBindBuffer(GL_ARRAY_BUFFER, port_vbo);
+        // Geometry is generated lazily, when a chunk becomes visible.
+        gate_chunks.reset(project->get_bounding_box(), gates);
+        outline_chunks.reset(project->get_bounding_box(), gates);
+        port_chunks.reset(project->get_bounding_box(), ports);
 
-        context->glBufferData(GL_ARRAY_BUFFER, ports_count * 9 * sizeof(GatesVertex2D), nullptr, GL_STATIC_DRAW);
-
-        context->glBindBuffer(GL_ARRAY_BUFFER, 0);
-        vao.release();
+        // Labels are only laid out when they become visible.
+        gate_template_name_text.clear();
+        port_name_text.clear();
 
-        unsigned gate_template_name_text_offset = 0;
-        unsigned port_name_text_offset = 0;
-        unsigned ports_index = 0;
-
-        for (auto iter = project->get_logic_model()->gates_begin(); iter != project->get_logic_model()->gates_end(); ++iter)
+        for (auto& gate : gates)
         {
-            std::string text = iter->second->get_gate_template()->get_name();
+            add_gate_label(gate);
 
-            if (!iter->second->get_name().empty())
-                text += " [" + iter->second->get_name() + "]";
+            for (auto& port : gate_ports[gate->get_object_id()])
+                add_port_label(port);
+        }
 
-            gate_template_name_text.add_sub_text(gate_template_name_text_offset,
-                                                 iter->second->get_min_x() + TEXT_PADDING,
-                                                 iter->second->get_min_y() + TEXT_PADDING,
-                                                 text.c_str(),
-                                                 10,
-                                                 QVector3D(255, 255, 255),
-                                                 1,
-                                                 false,
-                                                 false,
-                                                 iter->second->get_max_x() - iter->second->get_min_x() - TEXT_PADDING * 2);
+        assert(context->glGetError() == GL_NO_ERROR);
+    }
 
-            create_ports(iter->second, ports_index);
+    void WorkspaceGates::update(Gate_shptr& gate)
+    {
+        if (gate == nullptr)
+            return;
 
-            gate_template_name_text_offset += static_cast<unsigned int>(iter->second->get_gate_template()->get_name().length());
+        add(gate);
+    }
 
-            if (!iter->second->get_name().empty())
-                gate_template_name_text_offset += static_cast<unsigned int>(iter->second->get_name().length()) + 3;
+    void WorkspaceGates::update(GatePort_shptr& port)
+    {
+        if (port == nullptr)
+            return;
 
-            ports_index += iter->second->get_ports_number();
+        port_chunks.update(port);
+    }
 
-            for (auto port_iter = iter->second->ports_begin(); port_iter != iter->second->ports_end(); ++port_iter)
-            {
-                unsigned x = (*port_iter)->get_x();
-                unsigned y = (*port_iter)->get_y() + (*port_iter)->get_diameter() / 2.0 + TEXT_PADDING;
-                port_name_text.add_sub_text(port_name_text_offset,
-                                            x,
-                                            y,
-                                            (*port_iter)->get_name(),
-                                            5,
-                                            QVector3D(255, 255, 255),
-                                            1,
-                                            true,
-                                            false);
-
-                port_name_text_offset += static_cast<unsigned int>((*port_iter)->get_name().length());
-            }
-        }
+    void WorkspaceGates::insert(Gate_shptr& gate)
+    {
+        if (gate == nullptr)
+            return;
 
-        assert(context->glGetError() == GL_NO_ERROR);
+        add(gate);
     }
 
-    void WorkspaceGates::update(Gate_shptr& gate)
+    void WorkspaceGates::remove(Gate_shptr& gate)
     {
         if (gate == nullptr)
             return;
 
-        create_gate(gate, gate->get_index());
+        drop(gate);
     }
 
     void WorkspaceGates::draw(const QMatrix4x4& projection)
     {
-        if (project == nullptr || project->get_logic_model()->get_gates_count() == 0)
+        if (project == nullptr || gate_chunks.get_objects_count() == 0)
             return;
 
         program->bind();
@@ -219,33 +183,22 @@ namespace degate
         program->setUniformValue("mvp", projection);
 
         vao.bind();
-        context->glBindBuffer(GL_ARRAY_BUFFER, vbo);
-
-        program->enableAttributeArray("pos");
-        program->setAttributeBuffer("pos", GL_FLOAT, 0, 2, sizeof(GatesVertex2D));
-
-        program->enableAttributeArray("color");
-        program->setAttributeBuffer("color", GL_FLOAT, 2 * sizeof(float), 3, sizeof(GatesVertex2D));
-
-        program->enableAttributeArray("alpha");
-        program->setAttributeBuffer("alpha", GL_FLOAT, 5 * sizeof(float), 1, sizeof(GatesVertex2D));
 
-        context->glDrawArrays(GL_TRIANGLES, 0, project->get_logic_model()->get_gates_count() * 6);
-
-        context->glBindBuffer(GL_ARRAY_BUFFER, line_vbo);
-
-        program->enableAttributeArray("pos");
-        program->setAttributeBuffer("pos", GL_FLOAT, 0, 2, sizeof(GatesVertex2D));
+        auto set_attributes = [this]()
+        {
+            program->enableAttributeArray("pos");
+            program->setAttributeBuffer("pos", GL_FLOAT, 0, 2, sizeof(GatesVertex2D));
 
-        program->enableAttributeArray("color");
-        program->setAttributeBuffer("color", GL_FLOAT, 2 * sizeof(float), 3, sizeof(GatesVertex2D));
+            program->enableAttributeArray("color");
+            program->setAttributeBuffer("color", GL_FLOAT, 2 * sizeof(float), 3, sizeof(GatesVertex2D));
 
-        program->enableAttributeArray("alpha");
-        program->setAttributeBuffer("alpha", GL_FLOAT, 5 * sizeof(float), 1, sizeof(GatesVertex2D));
+            program->enableAttributeArray("alpha");
+            program->setAttributeBuffer("alpha", GL_FLOAT, 5 * sizeof(float), 1, sizeof(GatesVertex2D));
+        };
 
-        context->glDrawArrays(GL_LINES, 0, project->get_logic_model()->get_gates_count() * 8);
+        gate_chunks.draw(projection, set_attributes);
+        outline_chunks.draw(projection, set_attributes);
 
-        context->glBindBuffer(GL_ARRAY_BUFFER, 0);
         vao.release();
 
         program->release();
@@ -253,7 +206,7 @@ namespace degate
 
     void WorkspaceGates::draw_gates_name(const QMatrix4x4& projection)
     {
-        if (project == nullptr || project->get_logic_model()->get_gates_count() == 0)
+        if (project == nullptr || gate_chunks.get_objects_count() == 0)
             return;
 
         gate_template_name_text.draw(projection);
@@ -261,7 +214,7 @@ namespace degate
 
     void WorkspaceGates::draw_ports(const QMatrix4x4& projection)
     {
-        if (project == nullptr || project->get_logic_model()->get_gates_count() == 0)
+        if (project == nullptr || port_chunks.get_objects_count() == 0)
             return;
 
         program->bind();
@@ -269,20 +222,19 @@ namespace degate
         program->setUniformValue("mvp", projection);
 
         vao.bind();
-        context->glBindBuffer(GL_ARRAY_BUFFER, port_vbo);
 
-        program->enableAttributeArray("pos");
-        program->setAttributeBuffer("pos", GL_FLOAT, 0, 2, sizeof(GatesVertex2D));
-
-        program->enableAttributeArray("color");
-        program->setAttributeBuffer("color", GL_FLOAT, 2 * sizeof(float), 3, sizeof(GatesVertex2D));
+        port_chunks.draw(projection, [this]()
+        {
+            program->enableAttributeArray("pos");
+            program->setAttributeBuffer("pos", GL_FLOAT, 0, 2, sizeof(GatesVertex2D));
 
-        program->enableAttributeArray("alpha");
-        program->setAttributeBuffer("alpha", GL_FLOAT, 5 * sizeof(float), 1, sizeof(GatesVertex2D));
+            program->enableAttributeArray("color");
+            program->setAttributeBuffer("color", GL_FLOAT, 2 * sizeof(float), 3, sizeof(GatesVertex2D));
 
-        context->glDrawArrays(GL_TRIANGLES, 0, ports_count * 9);
+            program->enableAttributeArray("alpha");
+            program->setAttributeBuffer("alpha", GL_FLOAT, 5 * sizeof(float), 1, sizeof(GatesVertex2D));
+        });
 
-        context->glBindBuffer(GL_ARRAY_BUFFER, 0);
         vao.release();
 
         program->release();
@@ -290,21 +242,100 @@ namespace degate
 
     void WorkspaceGates::draw_ports_name(const QMatrix4x4& projection)
     {
-        if (project == nullptr || project->get_logic_model()->get_gates_count() == 0)
+        if (project == nullptr || port_chunks.get_objects_count() == 0)
             return;
 
         port_name_text.draw(projection);
     }
 
-    void WorkspaceGates::create_gate(Gate_shptr& gate, unsigned index)
+    void WorkspaceGates::add(const Gate_shptr& gate)
     {
-        if (gate == nullptr)
+        gate_chunks.insert(gate);
+        outline_chunks.insert(gate);
+
+        gate_template_name_text.remove_labels(gate->get_object_id());
+        add_gate_label(gate);
+
+        // The ports may have changed with the gate template.
+        std::vector<GatePort_shptr> current_ports(gate->ports_begin(), gate->ports_end());
+        std::vector<GatePort_shptr>& ports = gate_ports[gate->get_object_id()];
+
+        for (auto& port : ports)
+        {
+            if (std::find(current_ports.begin(), current_ports.end(), port) != current_ports.end())
+                continue;
+
+            port_chunks.remove(port);
+            port_name_text.remove_labels(port->get_object_id());
+        }
+
+        for (auto& port : current_ports)
+        {
+            port_chunks.insert(port);
+
+            port_name_text.remove_labels(port->get_object_id());
+            add_port_label(port);
+        }
+
+        ports = current_ports;
+    }
+
+    void WorkspaceGates::drop(const Gate_shptr& gate)
+    {
+        gate_chunks.remove(gate);
+        outline_chunks.remove(gate);
+        gate_template_name_text.remove_labels(gate->get_object_id());
+
+        auto iter = gate_ports.find(gate->get_object_id());
+        if (iter == gate_ports.end())
             return;
 
-        vao.bind();
-        context->glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        for (auto& port : iter->second)
+        {
+            port_chunks.remove(port);
+            port_name_text.remove_labels(port->get_object_id());
+        }
 
+        gate_ports.erase(iter);
+    }
 
+    void WorkspaceGates::add_gate_label(const Gate_shptr& gate)
+    {
+        std::string text = gate->get_gate_template()->get_name();
+
+        if (!gate->get_name().empty())
+            text += " [" + gate->get_name() + "]";
+
+        gate_template_name_text.add_label(gate->get_min_x() + TEXT_PADDING,
+                                          gate->get_min_y() + TEXT_PADDING,
+                                          text,
+                                          10,
+                                          QVector3D(255, 255, 255),
+                                          1,
+                                          false,
+                                          false,
+                                          gate->get_max_x() - gate->get_min_x() - TEXT_PADDING * 2,
+                                          gate->get_object_id());
+    }
+
+    void WorkspaceGates::add_port_label(const GatePort_shptr& port)
+    {
+        unsigned x = port->get_x();
+        unsigned y = port->get_y() + port->get_diameter() / 2.0 + TEXT_PADDING;
+        port_name_text.add_label(x,
+                                 y,
+                                 port->get_name(),
+                                 5,
+                                 QVector3D(255, 255, 255),
+                                 1,
+                                 true,
+                                 false,
+                                 0,
+                                 port->get_object_id());
+    }
+
+    void WorkspaceGates::create_gate(const Gate_shptr& gate, GatesVertex2D* vertices) const
+    {
         // Vertices and colors
 
         color_t color = gate->get_gate_template()->get_fill_color() == 0 ? project->get_default_color(DEFAULT_COLOR_GATE) : gate->get_gate_template()->get_fill_color();
@@ -316,64 +347,62 @@ namespace degate
         temp.alpha = MASK_A(color) / 255.0;
 
         temp.pos = QVector2D(gate->get_min_x(), gate->get_min_y());
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 6 * sizeof(GatesVertex2D) + 0 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[0] = temp;
 
         temp.pos = QVector2D(gate->get_max_x(), gate->get_min_y());
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 6 * sizeof(GatesVertex2D) + 1 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[1] = temp;
 
         temp.pos = QVector2D(gate->get_min_x(), gate->get_max_y());
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 6 * sizeof(GatesVertex2D) + 2 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[2] = temp;
 
         temp.pos = QVector2D(gate->get_max_x(), gate->get_min_y());
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 6 * sizeof(GatesVertex2D) + 4 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[4] = temp;
 
         temp.pos = QVector2D(gate->get_min_x(), gate->get_max_y());
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 6 * sizeof(GatesVertex2D) + 3 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[3] = temp;
 
         temp.pos = QVector2D(gate->get_max_x(), gate->get_max_y());
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 6 * sizeof(GatesVertex2D) + 5 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
-
+        vertices[5] = temp;
+    }
 
+    void WorkspaceGates::create_gate_outline(const Gate_shptr& gate, GatesVertex2D* vertices) const
+    {
         // Lines
 
-        color = gate->get_gate_template()->get_frame_color() == 0 ? project->get_default_color(DEFAULT_COLOR_GATE_FRAME) : gate->get_gate_template()->get_frame_color();
+        color_t color = gate->get_gate_template()->get_frame_color() == 0 ? project->get_default_color(DEFAULT_COLOR_GATE_FRAME) : gate->get_gate_template()->get_frame_color();
 
         color = highlight_color_by_state(color, gate->get_highlighted());
 
-        context->glBindBuffer(GL_ARRAY_BUFFER, line_vbo);
-
+        GatesVertex2D temp;
         temp.color = QVector3D(MASK_R(color) / 255.0, MASK_G(color) / 255.0, MASK_B(color) / 255.0);
         temp.alpha = MASK_A(color) / 255.0;
 
         temp.pos = QVector2D(gate->get_min_x(), gate->get_min_y());
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 8 * sizeof(GatesVertex2D) + 0 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[0] = temp;
 
         temp.pos = QVector2D(gate->get_max_x(), gate->get_min_y());
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 8 * sizeof(GatesVertex2D) + 1 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[1] = temp;
 
         temp.pos = QVector2D(gate->get_min_x(), gate->get_min_y());
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 8 * sizeof(GatesVertex2D) + 2 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[2] = temp;
 
         temp.pos = QVector2D(gate->get_min_x(), gate->get_max_y());
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 8 * sizeof(GatesVertex2D) + 3 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[3] = temp;
 
         temp.pos = QVector2D(gate->get_max_x(), gate->get_min_y());
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 8 * sizeof(GatesVertex2D) + 4 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[4] = temp;
 
         temp.pos = QVector2D(gate->get_max_x(), gate->get_max_y());
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 8 * sizeof(GatesVertex2D) + 5 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[5] = temp;
 
         temp.pos = QVector2D(gate->get_min_x(), gate->get_max_y());
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 8 * sizeof(GatesVertex2D) + 6 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[6] = temp;
 
         temp.pos = QVector2D(gate->get_max_x(), gate->get_max_y());
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 8 * sizeof(GatesVertex2D) + 7 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
-
-        context->glBindBuffer(GL_ARRAY_BUFFER, 0);
-        vao.release();
+        vertices[7] = temp;
     }
 
-    void draw_port_in_out(QOpenGLFunctions* context, float x, float y, unsigned size, QVector3D color, float alpha, unsigned offset)
+    static void create_port_in_out(GatesVertex2D* vertices, float x, float y, unsigned size, QVector3D color, float alpha)
     {
         GatesVertex2D temp;
 
@@ -383,34 +412,34 @@ namespace degate
         int mid = size / 2.0;
 
         temp.pos = QVector2D(x - mid, y - mid);
-        context->glBufferSubData(GL_ARRAY_BUFFER, offset * 9 * sizeof(GatesVertex2D) + 0 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[0] = temp;
 
         temp.pos = QVector2D(x - mid, y + mid);
-        context->glBufferSubData(GL_ARRAY_BUFFER, offset * 9 * sizeof(GatesVertex2D) + 1 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[1] = temp;
 
         temp.pos = QVector2D(x + mid, y - mid);
-        context->glBufferSubData(GL_ARRAY_BUFFER, offset * 9 * sizeof(GatesVertex2D) + 2 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[2] = temp;
 
         temp.pos = QVector2D(x + mid, y - mid);
-        context->glBufferSubData(GL_ARRAY_BUFFER, offset * 9 * sizeof(GatesVertex2D) + 3 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[3] = temp;
 
         temp.pos = QVector2D(x, y);
-        context->glBufferSubData(GL_ARRAY_BUFFER, offset * 9 * sizeof(GatesVertex2D) + 4 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[4] = temp;
 
         temp.pos = QVector2D(x + mid, y + mid);
-        context->glBufferSubData(GL_ARRAY_BUFFER, offset * 9 * sizeof(GatesVertex2D) + 5 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[5] = temp;
 
         temp.pos = QVector2D(x, y);
-        context->glBufferSubData(GL_ARRAY_BUFFER, offset * 9 * sizeof(GatesVertex2D) + 6 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[6] = temp;
 
         temp.pos = QVector2D(x + mid, y + mid);
-        context->glBufferSubData(GL_ARRAY_BUFFER, offset * 9 * sizeof(GatesVertex2D) + 7 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[7] = temp;
 
         temp.pos = QVector2D(x - mid, y + mid);
-        context->glBufferSubData(GL_ARRAY_BUFFER, offset * 9 * sizeof(GatesVertex2D) + 8 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[8] = temp;
     }
 
-    void draw_port_in(QOpenGLFunctions* context, float x, float y, unsigned size, QVector3D color, float alpha, unsigned offset)
+    static void create_port_in(GatesVertex2D* vertices, float x, float y, unsigned size, QVector3D color, float alpha)
     {
         GatesVertex2D temp;
 
@@ -420,34 +449,34 @@ namespace degate
         int mid = size / 2.0;
 
         temp.pos = QVector2D(x - mid, y - mid);
-        context->glBufferSubData(GL_ARRAY_BUFFER, offset * 9 * sizeof(GatesVertex2D) + 0 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[0] = temp;
 
         temp.pos = QVector2D(x + mid, y - mid);
-        context->glBufferSubData(GL_ARRAY_BUFFER, offset * 9 * sizeof(GatesVertex2D) + 1 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[1] = temp;
 
         temp.pos = QVector2D(x, y);
-        context->glBufferSubData(GL_ARRAY_BUFFER, offset * 9 * sizeof(GatesVertex2D) + 2 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[2] = temp;
 
         temp.pos = QVector2D(x + mid, y - mid);
-        context->glBufferSubData(GL_ARRAY_BUFFER, offset * 9 * sizeof(GatesVertex2D) + 3 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[3] = temp;
 
         temp.pos = QVector2D(x + mid, y + mid);
-        context->glBufferSubData(GL_ARRAY_BUFFER, offset * 9 * sizeof(GatesVertex2D) + 4 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[4] = temp;
 
         temp.pos = QVector2D(x, y);
-        context->glBufferSubData(GL_ARRAY_BUFFER, offset * 9 * sizeof(GatesVertex2D) + 5 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[5] = temp;
 
         temp.pos = QVector2D(x + mid, y + mid);
-        context->glBufferSubData(GL_ARRAY_BUFFER, offset * 9 * sizeof(GatesVertex2D) + 6 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[6] = temp;
 
         temp.pos = QVector2D(x - mid, y + mid);
-        context->glBufferSubData(GL_ARRAY_BUFFER, offset * 9 * sizeof(GatesVertex2D) + 7 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[7] = temp;
 
         temp.pos = QVector2D(x, y);
-        context->glBufferSubData(GL_ARRAY_BUFFER, offset * 9 * sizeof(GatesVertex2D) + 8 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[8] = temp;
     }
 
-    void draw_port_out(QOpenGLFunctions* context, float x, float y, unsigned size, QVector3D color, float alpha, unsigned offset)
+    static void create_port_out(GatesVertex2D* vertices, float x, float y, unsigned size, QVector3D color, float alpha)
     {
         GatesVertex2D temp;
 
@@ -457,41 +486,35 @@ namespace degate
         int mid = size / 2.0;
 
         temp.pos = QVector2D(x - mid, y - mid);
-        context->glBufferSubData(GL_ARRAY_BUFFER, offset * 9 * sizeof(GatesVertex2D) + 0 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[0] = temp;
 
         temp.pos = QVector2D(x, y - mid);
-        context->glBufferSubData(GL_ARRAY_BUFFER, offset * 9 * sizeof(GatesVertex2D) + 1 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[1] = temp;
 
         temp.pos = QVector2D(x, y + mid);
-        context->glBufferSubData(GL_ARRAY_BUFFER, offset * 9 * sizeof(GatesVertex2D) + 2 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[2] = temp;
 
         temp.pos = QVector2D(x - mid, y - mid);
-        context->glBufferSubData(GL_ARRAY_BUFFER, offset * 9 * sizeof(GatesVertex2D) + 3 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[3] = temp;
 
         temp.pos = QVector2D(x - mid, y + mid);
-        context->glBufferSubData(GL_ARRAY_BUFFER, offset * 9 * sizeof(GatesVertex2D) + 4 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[4] = temp;
 
         temp.pos = QVector2D(x, y + mid);
-        context->glBufferSubData(GL_ARRAY_BUFFER, offset * 9 * sizeof(GatesVertex2D) + 5 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[5] = temp;
 
         temp.pos = QVector2D(x, y - mid);
-        context->glBufferSubData(GL_ARRAY_BUFFER, offset * 9 * sizeof(GatesVertex2D) + 6 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[6] = temp;
 
         temp.pos = QVector2D(x + mid, y);
-        context->glBufferSubData(GL_ARRAY_BUFFER, offset * 9 * sizeof(GatesVertex2D) + 7 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[7] = temp;
 
         temp.pos = QVector2D(x, y + mid);
-        context->glBufferSubData(GL_ARRAY_BUFFER, offset * 9 * sizeof(GatesVertex2D) + 8 * sizeof(GatesVertex2D), sizeof(GatesVertex2D), &temp);
+        vertices[8] = temp;
     }
 
-    void WorkspaceGates::update(GatePort_shptr& port)
+    void WorkspaceGates::create_port(const GatePort_shptr& port, GatesVertex2D* vertices) const
     {
-        if (port == nullptr)
-            return;
-
-        vao.bind();
-        context->glBindBuffer(GL_ARRAY_BUFFER, port_vbo);
-
         GateTemplatePort_shptr tmpl_port = port->get_template_port();
         color_t color = tmpl_port->get_fill_color() == 0 ? project->get_default_color(DEFAULT_COLOR_GATE_PORT) : tmpl_port->get_fill_color();
 
@@ -500,64 +523,20 @@ namespace degate
         switch (tmpl_port->get_port_type())
         {
             case GateTemplatePort::PORT_TYPE_UNDEFINED:
-                draw_port_in_out(context, port->get_x(), port->get_y(), port->get_diameter(), QVector3D(MASK_R(color) / 255.0, MASK_G(color) / 255.0, MASK_B(color) / 255.0), MASK_A(color) / 255.0, port->get_index());
+                create_port_in_out(vertices, port->get_x(), port->get_y(), port->get_diameter(), QVector3D(MASK_R(color) / 255.0, MASK_G(color) / 255.0, MASK_B(color) / 255.0), MASK_A(color) / 255.0);
                 break;
             case GateTemplatePort::PORT_TYPE_IN:
-                draw_port_in(context, port->get_x(), port->get_y(), port->get_diameter(), QVector3D(MASK_R(color) / 255.0, MASK_G(color) / 255.0, MASK_B(color) / 255.0), MASK_A(color) / 255.0, port->get_index());
+                create_port_in(vertices, port->get_x(), port->get_y(), port->get_diameter(), QVector3D(MASK_R(color) / 255.0, MASK_G(color) / 255.0, MASK_B(color) / 255.0), MASK_A(color) / 255.0);
                 break;
             case GateTemplatePort::PORT_TYPE_OUT:
-                draw_port_out(context, port->get_x(), port->get_y(), port->get_diameter(), QVector3D(MASK_R(color) / 255.0, MASK_G(color) / 255.0, MASK_B(color) / 255.0), MASK_A(color) / 255.0, port->get_index());
+                create_port_out(vertices, port->get_x(), port->get_y(), port->get_diameter(), QVector3D(MASK_R(color) / 255.0, MASK_G(color) / 255.0, MASK_B(color) / 255.0), MASK_A(color) / 255.0);
                 break;
             case GateTemplatePort::PORT_TYPE_INOUT:
-                draw_port_in_out(context, port->get_x(), port->get_y(), port->get_diameter(), QVector3D(MASK_R(color) / 255.0, MASK_G(color) / 255.0, MASK_B(color) / 255.0), MASK_A(color) / 255.0, port->get_index());
+                create_port_in_out(vertices, port->get_x(), port->get_y(), port->get_diameter(), QVector3D(MASK_R(color) / 255.0, MASK_G(color) / 255.0, MASK_B(color) / 255.0), MASK_A(color) / 255.0);
                 break;
             default:
-                draw_port_in_out(context, port->get_x(), port->get_y(), port->get_diameter(), QVector3D(MASK_R(color) / 255.0, MASK_G(color) / 255.0, MASK_B(color) / 255.0), MASK_A(color) / 255.0, port->get_index());
+                create_port_in_out(vertices, port->get_x(), port->get_y(), port->get_diameter(), QVector3D(MASK_R(color) / 255.0, MASK_G(color) / 255.0, MASK_B(color) / 255.0), MASK_A(color) / 255.0);
                 break;
         }
-
-        context->glBindBuffer(GL_ARRAY_BUFFER, 0);
-        vao.release();
-    }
-
-    void WorkspaceGates::create_ports(Gate_shptr& gate, unsigned index)
-    {
-        vao.bind();
-        context->glBindBuffer(GL_ARRAY_BUFFER, port_vbo);
-
-        for (Gate::port_iterator iter = gate->ports_begin(); iter != gate->ports_end(); ++iter)
-        {
-            GatePort_shptr port = *iter;
-            GateTemplatePort_shptr tmpl_port = port->get_template_port();
-            color_t color = tmpl_port->get_fill_color() == 0 ? project->get_default_color(DEFAULT_COLOR_GATE_PORT) : tmpl_port->get_fill_color();
-
-            color = highlight_color_by_state(color, port->get_highlighted());
-
-            switch (tmpl_port->get_port_type())
-            {
-                case GateTemplatePort::PORT_TYPE_UNDEFINED:
-                    draw_port_in_out(context, port->get_x(), port->get_y(), port->get_diameter(), QVector3D(MASK_R(color) / 255.0, MASK_G(color) / 255.0, MASK_B(color) / 255.0), MASK_A(color) / 255.0, index);
-                    break;
-                case GateTemplatePort::PORT_TYPE_IN:
-                    draw_port_in(context, port->get_x(), port->get_y(), port->get_diameter(), QVector3D(MASK_R(color) / 255.0, MASK_G(color) / 255.0, MASK_B(color) / 255.0), MASK_A(color) / 255.0, index);
-                    break;
-                case GateTemplatePort::PORT_TYPE_OUT:
-                    draw_port_out(context, port->get_x(), port->get_y(), port->get_diameter(), QVector3D(MASK_R(color) / 255.0, MASK_G(color) / 255.0, MASK_B(color) / 255.0), MASK_A(color) / 255.0, index);
-                    break;
-                case GateTemplatePort::PORT_TYPE_INOUT:
-                    draw_port_in_out(context, port->get_x(), port->get_y(), port->get_diameter(), QVector3D(MASK_R(color) / 255.0, MASK_G(color) / 255.0, MASK_B(color) / 255.0), MASK_A(color) / 255.0, index);
-                    break;
-                default:
-                    draw_port_in_out(context, port->get_x(), port->get_y(), port->get_diameter(), QVector3D(MASK_R(color) / 255.0, MASK_G(color) / 255.0, MASK_B(color) / 255.0), MASK_A(color) / 255.0, index);
-                    break;
-            }
-
-            port->set_index(index);
-
-            index++;
-        }
-
-        context->glBindBuffer(GL_ARRAY_BUFFER, 0);
-        vao.release();
     }
-}
+}
\ No newline at end of file
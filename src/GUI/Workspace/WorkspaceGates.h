@@ -23,10 +23,20 @@
 #define __WORKSPACEGATES_H__
 
 #include "WorkspaceElement.h"
-#include "GUI/Text/Text.h"
+#include "GUI/Workspace/WorkspaceChunks.h"
+#include "GUI/Text/TextLabels.h"
+
+#include <vector>
+#include <unordered_map>
 
 namespace degate
 {
+    struct GatesVertex2D
+    {
+        QVector2D pos;
+        QVector3D color;
+        float alpha;
+    };
 
     /**
      * @class WorkspaceGates
@@ -35,7 +45,8 @@ namespace degate
      * This will prepare all OpenGL things (buffers, shaders...) to draw all gates on the workspace.
      * One gate is composed of a square, an outline, a top-left aligned text, ports and ports name.
      *
-     * The parent vbo buffer will store all squares, the line_vbo buffer will store all outlines and the port_vbo buffer will store all ports.
+     * Squares, outlines and ports are stored in three sets of spatial chunks, each chunk has its own vbo
+     * (@see WorkspaceChunks). Gates are drawn on every layer, so the chunks cover the whole project.
      *
      * @see WorkspaceElement
      */
@@ -63,7 +74,9 @@ namespace degate
         void update() override;
 
         /**
-         * Update a specific gate.
+         * Update a specific gate, its ports and their names (only their chunks are rebuilt).
+         *
+         * @warning Call the update() function before.
          *
          * @param gate : the gate object.
          */
@@ -76,6 +89,20 @@ namespace degate
          */
         void update(GatePort_shptr& port);
 
+        /**
+         * Add a new gate and its ports (only their chunks are rebuilt).
+         *
+         * @param gate : the new gate.
+         */
+        void insert(Gate_shptr& gate);
+
+        /**
+         * Remove a gate and its ports (only their chunks are rebuilt).
+         *
+         * @param gate : the removed gate.
+         */
+        void remove(Gate_shptr& gate);
+
         /**
          * Draw all gates.
          *
@@ -106,26 +133,67 @@ namespace degate
 
     private:
         /**
-         * Create a gate in OpenGL buffers.
+         * Create the vertices of a gate square (called from worker threads).
          *
          * @param gate : the gate object.
-         * @param index : the index of the gate for OpenGL buffers.
+         * @param vertices : the 6 vertices to fill.
          */
-        void create_gate(Gate_shptr& gate, unsigned index);
+        void create_gate(const Gate_shptr& gate, GatesVertex2D* vertices) const;
 
         /**
-         * Create all ports of a specific gate in OpenGL buffers.
+         * Create the vertices of a gate outline (called from worker threads).
          *
          * @param gate : the gate object.
-         * @param index : the index of the gate for OpenGL buffers.
+         * @param vertices : the 8 vertices (4 lines) to fill.
+         */
+        void create_gate_outline(const Gate_shptr& gate, GatesVertex2D* vertices) const;
+
+        /**
+         * Create the vertices of a port (called from worker threads).
+         *
+         * @param port : the port object.
+         * @param vertices : the 9 vertices to fill.
          */
-        void create_ports(Gate_shptr& gate, unsigned index);
+        void create_port(const GatePort_shptr& port, GatesVertex2D* vertices) const;
+
+        /**
+         * Add or update a gate and its ports in the chunks, and replace their names.
+         * Ports that no longer belong to the gate are removed.
+         *
+         * @param gate : the gate object.
+         */
+        void add(const Gate_shptr& gate);
+
+        /**
+         * Remove a gate and the ports it had when it was added from the chunks, and remove their names.
+         *
+         * @param gate : the gate object.
+         */
+        void drop(const Gate_shptr& gate);
+
+        /**
+         * Add the name label of a gate (template name and instance name).
+         *
+         * @param gate : the gate object.
+         */
+        void add_gate_label(const Gate_shptr& gate);
+
+        /**
+         * Add the name label of a port.
+         *
+         * @param port : the port object.
+         */
+        void add_port_label(const GatePort_shptr& port);
+
+        TextLabels gate_template_name_text;
+        TextLabels port_name_text;
+
+        WorkspaceChunks<Gate, GatesVertex2D> gate_chunks;
+        WorkspaceChunks<Gate, GatesVertex2D> outline_chunks;
+        WorkspaceChunks<GatePort, GatesVertex2D> port_chunks;
 
-        Text gate_template_name_text;
-        Text port_name_text;
-        GLuint line_vbo = 0;
-        GLuint port_vbo = 0;
-        unsigned ports_count = 0;
+        // Ports of each gate, as they were added (they can change with the gate template).
+        std::unordered_map<object_id_t, std::vector<GatePort_shptr>> gate_ports;
 
     };
 }
@@ -0,0 +1,361 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "WorkspaceLOD.h"
+#include "Core/LogicModel/Gate/Gate.h"
+#include "Core/LogicModel/Wire/Wire.h"
+#include "Core/LogicModel/Via/Via.h"
+#include "Core/LogicModel/EMarker/EMarker.h"
+#include "GUI/Preferences/PreferencesHandler.h"
+
+namespace degate
+{
+    struct LODVertex2D
+    {
+        QVector2D pos;
+        QVector2D texCoord;
+    };
+
+    WorkspaceLOD::WorkspaceLOD(QWidget* parent) : WorkspaceElement(parent)
+    {
+
+    }
+
+    WorkspaceLOD::~WorkspaceLOD()
+    {
+        if (QOpenGLContext::currentContext() != nullptr && context != nullptr)
+            free_textures();
+    }
+
+    void WorkspaceLOD::init()
+    {
+        WorkspaceElement::init();
+
+        QOpenGLShader* vshader = new QOpenGLShader(QOpenGLShader::Vertex);
+        const char* vsrc =
+            "#version 330 core\n"
+            "in vec2 pos;\n"
+            "in vec2 texCoord;\n"
+            "uniform mat4 mvp;\n"
+            "out vec2 texCoord0;\n"
+            "void main(void)\n"
+            "{\n"
+            "    gl_Position = mvp * vec4(pos, 0.0, 1.0);\n"
+            "    texCoord0 = texCoord;\n"
+            "}\n";
+        vshader->compileSourceCode(vsrc);
+
+        QOpenGLShader* fshader = new QOpenGLShader(QOpenGLShader::Fragment);
+        const char* fsrc =
+            "#version 330 core\n"
+            "uniform sampler2D u_texture;\n"
+            "in vec2 texCoord0;\n"
+            "out vec4 color;\n"
+            "void main(void)\n"
+            "{\n"
+            "    color = texture(u_texture, texCoord0);\n"
+            "}\n";
+        fshader->compileSourceCode(fsrc);
+
+        program = new QOpenGLShaderProgram;
+        program->addShader(vshader);
+        program->addShader(fshader);
+
+        delete vshader;
+        delete fshader;
+
+        program->link();
+    }
+
+    void WorkspaceLOD::update()
+    {
+        rebuild_required = true;
+    }
+
+    void WorkspaceLOD::update(const PlacedLogicModelObject_shptr& object)
+    {
+        if (object == nullptr || coverage_map == nullptr || rebuild_required)
+            return;
+
+        insert(object);
+    }
+
+    void WorkspaceLOD::update(PlacedLogicModelObject::OBJECT_KIND kind)
+    {
+        if (project == nullptr || coverage_map == nullptr || rebuild_required)
+            return;
+
+        LogicModel_shptr lmodel = project->get_logic_model();
+
+        if (coverage_map->get_width() != std::max(lmodel->get_width(), 1u) ||
+            coverage_map->get_height() != std::max(lmodel->get_height(), 1u))
+        {
+            rebuild_required = true;
+            return;
+        }
+
+        std::set<object_id_t> previous;
+        previous.swap(kind_ids[kind]);
+
+        if (kind == PlacedLogicModelObject::KIND_GATE)
+        {
+            for (auto iter = lmodel->gates_begin(); iter != lmodel->gates_end(); ++iter)
+                insert(iter->second);
+        }
+        else if (Layer_shptr layer = lmodel->get_current_layer())
+        {
+            for (Layer::object_iterator iter = layer->objects_begin(kind); iter != layer->objects_end(); ++iter)
+                insert(*iter);
+        }
+
+        for (auto& id : previous)
+        {
+            if (kind_ids[kind].find(id) == kind_ids[kind].end())
+                coverage_map->remove(id);
+        }
+    }
+
+    void WorkspaceLOD::remove(const PlacedLogicModelObject_shptr& object)
+    {
+        if (object == nullptr || coverage_map == nullptr || rebuild_required)
+            return;
+
+        coverage_map->remove(object->get_object_id());
+        kind_ids[object->get_object_kind()].erase(object->get_object_id());
+    }
+
+    void WorkspaceLOD::draw(const QMatrix4x4& projection)
+    {
+        if (project == nullptr)
+            return;
+
+        if (rebuild_required)
+            rebuild();
+
+        if (coverage_map == nullptr || coverage_map->get_objects_count() == 0)
+            return;
+
+        const unsigned int index = coverage_map->get_level_index(scale);
+        upload(index);
+
+        const CoverageMap::Level& level = coverage_map->get_level(index);
+        const float max_x = static_cast<float>(level.width * level.cell_size);
+        const float max_y = static_cast<float>(level.height * level.cell_size);
+
+        LODVertex2D vertices[6];
+        vertices[0] = {QVector2D(0, 0), QVector2D(0, 0)};
+        vertices[1] = {QVector2D(max_x, 0), QVector2D(1, 0)};
+        vertices[2] = {QVector2D(0, max_y), QVector2D(0, 1)};
+        vertices[3] = {QVector2D(max_x, 0), QVector2D(1, 0)};
+        vertices[4] = {QVector2D(0, max_y), QVector2D(0, 1)};
+        vertices[5] = {QVector2D(max_x, max_y), QVector2D(1, 1)};
+
+        program->bind();
+
+        program->setUniformValue("mvp", projection);
+
+        vao.bind();
+        context->glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+        context->glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_DYNAMIC_DRAW);
+
+        program->enableAttributeArray("pos");
+        program->setAttributeBuffer("pos", GL_FLOAT, 0, 2, sizeof(LODVertex2D));
+
+        program->enableAttributeArray("texCoord");
+        program->setAttributeBuffer("texCoord", GL_FLOAT, 2 * sizeof(float), 2, sizeof(LODVertex2D));
+
+        context->glBindTexture(GL_TEXTURE_2D, textures[index]);
+        context->glDrawArrays(GL_TRIANGLES, 0, 6);
+
+        context->glBindBuffer(GL_ARRAY_BUFFER, 0);
+        vao.release();
+
+        context->glBindTexture(GL_TEXTURE_2D, 0);
+
+        program->release();
+    }
+
+    void WorkspaceLOD::set_scale(float scale)
+    {
+        this->scale = scale;
+    }
+
+    bool WorkspaceLOD::is_active() const
+    {
+        const unsigned int threshold = PREFERENCES_HANDLER.get_preferences().lod_zoom_threshold;
+
+        return project != nullptr && threshold != 0 && scale >= static_cast<float>(threshold);
+    }
+
+    void WorkspaceLOD::free_textures()
+    {
+        for (auto& texture : textures)
+        {
+            if (texture != 0)
+                context->glDeleteTextures(1, &texture);
+        }
+
+        textures.clear();
+    }
+
+    void WorkspaceLOD::rebuild()
+    {
+        rebuild_required = false;
+
+        free_textures();
+        coverage_map = nullptr;
+
+        kind_ids.clear();
+        kind_ids.resize(PlacedLogicModelObject::KIND_COUNT);
+
+        if (project == nullptr)
+            return;
+
+        LogicModel_shptr lmodel = project->get_logic_model();
+
+        coverage_map = std::make_shared<CoverageMap>(lmodel->get_width(), lmodel->get_height());
+        textures.resize(coverage_map->get_levels_count(), 0);
+
+        for (auto iter = lmodel->gates_begin(); iter != lmodel->gates_end(); ++iter)
+            insert(iter->second);
+
+        Layer_shptr layer = lmodel->get_current_layer();
+
+        if (layer == nullptr)
+            return;
+
+        for (Layer::object_iterator iter = layer->objects_begin(); iter != layer->objects_end(); ++iter)
+        {
+            if (!(*iter)->is_of_kind(PlacedLogicModelObject::KIND_GATE))
+                insert(*iter);
+        }
+    }
+
+    void WorkspaceLOD::insert(const PlacedLogicModelObject_shptr& object)
+    {
+        const object_id_t id = object->get_object_id();
+        const PlacedLogicModelObject::OBJECT_KIND kind = object->get_object_kind();
+
+        color_t color;
+        Wire_shptr wire = nullptr;
+
+        if (Gate_shptr gate = object_kind_cast<Gate>(object))
+        {
+            color = gate->get_gate_template()->get_fill_color() == 0 ? project->get_default_color(DEFAULT_COLOR_GATE) : gate->get_gate_template()->get_fill_color();
+        }
+        else
+        {
+            // Other objects are only drawn for the current layer.
+            if (object->get_layer() != project->get_logic_model()->get_current_layer())
+            {
+                coverage_map->remove(id);
+                kind_ids[kind].erase(id);
+                return;
+            }
+
+            if ((wire = object_kind_cast<Wire>(object)) != nullptr)
+            {
+                color = wire->get_fill_color() == 0 ? project->get_default_color(DEFAULT_COLOR_EMARKER) : wire->get_fill_color();
+            }
+            else if (Via_shptr via = object_kind_cast<Via>(object))
+            {
+                if (via->get_direction() == Via::DIRECTION_UP)
+                    color = via->get_fill_color() == 0 ? project->get_default_color(DEFAULT_COLOR_VIA_UP) : via->get_fill_color();
+                else if (via->get_direction() == Via::DIRECTION_DOWN)
+                    color = via->get_fill_color() == 0 ? project->get_default_color(DEFAULT_COLOR_VIA_DOWN) : via->get_fill_color();
+                else
+                    color = via->get_fill_color() == 0 ? project->get_default_color(DEFAULT_COLOR_EMARKER) : via->get_fill_color();
+            }
+            else if (EMarker_shptr emarker = object_kind_cast<EMarker>(object))
+            {
+                color = emarker->get_fill_color() == 0 ? project->get_default_color(DEFAULT_COLOR_EMARKER) : emarker->get_fill_color();
+            }
+            else
+            {
+                return;
+            }
+        }
+
+        color = highlight_color_by_state(color, object->get_highlighted());
+
+        // Diagonal wires only cover the cells along their path.
+        if (wire != nullptr)
+            coverage_map->insert_segment(id, wire->get_from_x(), wire->get_from_y(), wire->get_to_x(), wire->get_to_y(),
+                                         static_cast<float>(wire->get_diameter()), color);
+        else
+            coverage_map->insert(id, object->get_bounding_box(), color);
+
+        kind_ids[kind].insert(id);
+    }
+
+    void WorkspaceLOD::upload(unsigned int index)
+    {
+        const CoverageMap::Level& level = coverage_map->get_level(index);
+
+        bool full = false;
+
+        if (textures[index] == 0)
+        {
+            context->glGenTextures(1, &textures[index]);
+            context->glBindTexture(GL_TEXTURE_2D, textures[index]);
+
+            context->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            context->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            context->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            context->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+            context->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+            full = true;
+        }
+        else if (!level.dirty)
+        {
+            return;
+        }
+        else
+        {
+            context->glBindTexture(GL_TEXTURE_2D, textures[index]);
+        }
+
+        const unsigned int min_x = full ? 0 : level.dirty_min_x;
+        const unsigned int max_x = full ? level.width - 1 : level.dirty_max_x;
+        const unsigned int min_y = full ? 0 : level.dirty_min_y;
+        const unsigned int max_y = full ? level.height - 1 : level.dirty_max_y;
+
+        const unsigned int width = max_x - min_x + 1;
+        const unsigned int height = max_y - min_y + 1;
+
+        std::vector<color_t> data(width * height);
+        for (unsigned int y = 0; y < height; y++)
+        {
+            for (unsigned int x = 0; x < width; x++)
+                data[y * width + x] = coverage_map->get_cell_color(index, min_x + x, min_y + y);
+        }
+
+        context->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        context->glTexSubImage2D(GL_TEXTURE_2D, 0, min_x, min_y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
+
+        context->glBindTexture(GL_TEXTURE_2D, 0);
+
+        coverage_map->clear_dirty(index);
+    }
+}
@@ -0,0 +1,144 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __WORKSPACELOD_H__
+#define __WORKSPACELOD_H__
+
+#include "GUI/Workspace/WorkspaceElement.h"
+#include "Core/LogicModel/CoverageMap.h"
+
+#include <set>
+#include <vector>
+
+namespace degate
+{
+
+    /**
+     * @class WorkspaceLOD
+     * @brief Draw a simplified (level of detail) view of gates, wires, vias and emarkers when zoomed out.
+     *
+     * Objects are aggregated in a coverage map (@see CoverageMap), each level of the map is drawn as one texture.
+     * The level is chosen so that a cell is about one screen pixel, so the cost of drawing does not depend on
+     * the number of objects. Textures are created when a level is first used, and then only the changed area
+     * is uploaded again.
+     *
+     * The workspace switches to this view when a screen pixel covers at least
+     * Preferences::lod_zoom_threshold image pixels.
+     *
+     * @see WorkspaceElement
+     */
+    class WorkspaceLOD : public WorkspaceElement
+    {
+    public:
+
+        /**
+         * Create a workspace level of detail element.
+         * This will only set the parent, real creation will start with init and update functions.
+         *
+         * @param parent : the parent widget pointer.
+         */
+        explicit WorkspaceLOD(QWidget* parent);
+        ~WorkspaceLOD();
+
+        /**
+         * Init all OpenGL routine (buffers, shaders...).
+         */
+        void init() override;
+
+        /**
+         * Update all objects. The coverage map is rebuilt the next time it is drawn.
+         */
+        void update() override;
+
+        /**
+         * Update a specific object (only the cells it covers, before and after the change, are updated).
+         *
+         * @param object : the object to update.
+         */
+        void update(const PlacedLogicModelObject_shptr& object);
+
+        /**
+         * Update all objects of a kind: they are inserted again (e.g. after a color or layer change) and the ones
+         * that are no longer drawn are removed. Only the cells they cover are updated, other kinds are kept.
+         *
+         * @param kind : the kind of the objects to update.
+         */
+        void update(PlacedLogicModelObject::OBJECT_KIND kind);
+
+        /**
+         * Remove a specific object (only the cells it covers are updated).
+         *
+         * @param object : the object to remove.
+         */
+        void remove(const PlacedLogicModelObject_shptr& object);
+
+        /**
+         * Draw the level of the coverage map matching the current scale.
+         *
+         * @param projection : the projection matrix to apply.
+         */
+        void draw(const QMatrix4x4& projection) override;
+
+        /**
+         * Set the current scale (image pixels per screen pixel).
+         */
+        void set_scale(float scale);
+
+        /**
+         * Check if the simplified view must be drawn instead of the objects, for the current scale.
+         */
+        bool is_active() const;
+
+        /**
+         * Destroy all OpenGL textures.
+         */
+        void free_textures();
+
+    private:
+
+        /**
+         * Recreate the coverage map from all objects.
+         */
+        void rebuild();
+
+        /**
+         * Add or update an object in the coverage map, if it is drawn by this element (otherwise it is removed).
+         * Wires are stored as segments.
+         */
+        void insert(const PlacedLogicModelObject_shptr& object);
+
+        /**
+         * Upload the changed area of a level to its texture (create the texture if needed).
+         */
+        void upload(unsigned int index);
+
+        CoverageMap_shptr coverage_map = nullptr;
+        bool rebuild_required = true;
+
+        // Stored object IDs, by kind.
+        std::vector<std::set<object_id_t>> kind_ids;
+        float scale = 1;
+
+        std::vector<GLuint> textures;
+    };
+}
+
+#endif //__WORKSPACELOD_H__
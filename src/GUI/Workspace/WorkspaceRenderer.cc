@@ -23,6 +23,7 @@
 #include "GUI/Dialog/GateEditDialog.h"
 #include "GUI/Dialog/AnnotationEditDialog.h"
 #include "GUI/Preferences/PreferencesHandler.h"
+#include "Core/Utils/Trace.h"
 
 namespace degate
 {
@@ -35,6 +36,7 @@ namespace degate
               emarkers(this),
               vias(this),
               wires(this),
+              lod(this),
               selection_tool(this),
               wire_tool(this),
               regular_grid(this)
@@ -72,12 +74,18 @@ namespace degate
         emarkers.update();
         vias.update();
         wires.update();
+        lod.update(PlacedLogicModelObject::KIND_GATE);
+        lod.update(PlacedLogicModelObject::KIND_EMARKER);
+        lod.update(PlacedLogicModelObject::KIND_VIA);
+        lod.update(PlacedLogicModelObject::KIND_WIRE);
 
 		update();
 	}
 
     void WorkspaceRenderer::update_objects()
     {
+        TRACE_SCOPE_CATEGORY("render/update-objects", "render");
+
         makeCurrent();
 
         if (project == nullptr)
@@ -87,6 +95,10 @@ namespace degate
         emarkers.update();
         vias.update();
         wires.update();
+        lod.update(PlacedLogicModelObject::KIND_GATE);
+        lod.update(PlacedLogicModelObject::KIND_EMARKER);
+        lod.update(PlacedLogicModelObject::KIND_VIA);
+        lod.update(PlacedLogicModelObject::KIND_WIRE);
 
         update();
     }
@@ -101,6 +113,7 @@ namespace degate
         if (std::dynamic_pointer_cast<Gate>(object) || std::dynamic_pointer_cast<GatePort>(object))
         {
             gates.update();
+            lod.update(PlacedLogicModelObject::KIND_GATE);
         }
         else if (std::dynamic_pointer_cast<Annotation>(object))
         {
@@ -109,14 +122,17 @@ namespace degate
         else if (std::dynamic_pointer_cast<EMarker>(object))
         {
             emarkers.update();
+            lod.update(PlacedLogicModelObject::KIND_EMARKER);
         }
         else if (std::dynamic_pointer_cast<Via>(object))
         {
             vias.update();
+            lod.update(PlacedLogicModelObject::KIND_VIA);
         }
         else if (std::dynamic_pointer_cast<Wire>(object))
         {
             wires.update();
+            lod.update(PlacedLogicModelObject::KIND_WIRE);
         }
 
         update();
@@ -142,6 +158,7 @@ namespace degate
             return;
 
         gates.update();
+        lod.update(PlacedLogicModelObject::KIND_GATE);
 
         update();
     }
@@ -166,6 +183,7 @@ namespace degate
             return;
 
         emarkers.update();
+        lod.update(PlacedLogicModelObject::KIND_EMARKER);
 
         update();
     }
@@ -178,6 +196,7 @@ namespace degate
             return;
 
         vias.update();
+        lod.update(PlacedLogicModelObject::KIND_VIA);
 
         update();
     }
@@ -190,6 +209,7 @@ namespace degate
             return;
 
         wires.update();
+        lod.update(PlacedLogicModelObject::KIND_WIRE);
 
         update();
     }
@@ -220,6 +240,8 @@ namespace degate
         emarkers.set_project(new_project);
         vias.set_project(new_project);
         wires.set_project(new_project);
+        lod.set_project(new_project);
+        lod.update();
         selection_tool.set_project(new_project);
         wire_tool.set_project(new_project);
         regular_grid.set_project(new_project);
@@ -443,6 +465,7 @@ namespace degate
         vias.init();
 		selection_tool.init();
 		wires.init();
+        lod.init();
         wire_tool.init();
         regular_grid.init();
 
@@ -460,13 +483,18 @@ namespace degate
 
 	void WorkspaceRenderer::paintGL()
 	{
+		TRACE_SCOPE_CATEGORY("render/paint", "render");
+
 		makeCurrent();
 
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		background.draw(projection);
 
-		if (draw_wires)
+		// When zoomed out, replace objects by their aggregated view.
+		const bool draw_lod = lod.is_active();
+
+		if (draw_wires && !draw_lod)
 		    wires.draw(projection);
 
 		if (draw_annotations)
@@ -475,28 +503,31 @@ namespace degate
 		if (draw_annotations_name)
 			annotations.draw_name(projection);
 
-		if (draw_gates)
+		if (draw_lod)
+		    lod.draw(projection);
+
+		if (draw_gates && !draw_lod)
 			gates.draw(projection);
 
-		if (draw_gates_name)
+		if (draw_gates_name && !draw_lod)
 			gates.draw_gates_name(projection);
 
-		if (draw_ports)
+		if (draw_ports && !draw_lod)
 			gates.draw_ports(projection);
 
-		if (draw_ports_name)
+		if (draw_ports_name && !draw_lod)
 			gates.draw_ports_name(projection);
 
-        if (draw_emarkers)
+        if (draw_emarkers && !draw_lod)
             emarkers.draw(projection);
 
-        if (draw_emarkers_name)
+        if (draw_emarkers_name && !draw_lod)
             emarkers.draw_name(projection);
 
-        if (draw_vias)
+        if (draw_vias && !draw_lod)
             vias.draw(projection);
 
-        if (draw_vias_name)
+        if (draw_vias_name && !draw_lod)
             vias.draw_name(projection);
 
         if (current_tool == WorkspaceTool::AREA_SELECTION)
@@ -543,9 +574,11 @@ namespace degate
 
     void WorkspaceRenderer::update_object(PlacedLogicModelObject_shptr object)
     {
-        if (object == nullptr)
+        if (object == nullptr || project == nullptr)
             return;
 
+        makeCurrent();
+
         if (Gate_shptr gate = std::dynamic_pointer_cast<Gate>(object))
         {
             gates.update(gate);
@@ -575,6 +608,76 @@ namespace degate
             }
         }
 
+        lod.update(object);
+
+        update();
+    }
+
+    void WorkspaceRenderer::add_object(PlacedLogicModelObject_shptr object)
+    {
+        if (object == nullptr || project == nullptr)
+            return;
+
+        makeCurrent();
+
+        if (Gate_shptr gate = std::dynamic_pointer_cast<Gate>(object))
+        {
+            gates.insert(gate);
+        }
+        else if (object->get_layer() == project->get_logic_model()->get_current_layer())
+        {
+            if (std::dynamic_pointer_cast<Annotation>(object))
+            {
+                annotations.update();
+            }
+            else if (EMarker_shptr emarker = std::dynamic_pointer_cast<EMarker>(object))
+            {
+                emarkers.insert(emarker);
+            }
+            else if (Via_shptr via = std::dynamic_pointer_cast<Via>(object))
+            {
+                vias.insert(via);
+            }
+            else if (Wire_shptr wire = std::dynamic_pointer_cast<Wire>(object))
+            {
+                wires.insert(wire);
+            }
+        }
+
+        lod.update(object);
+
+        update();
+    }
+
+    void WorkspaceRenderer::remove_object(PlacedLogicModelObject_shptr object)
+    {
+        if (object == nullptr || project == nullptr)
+            return;
+
+        makeCurrent();
+
+        if (Gate_shptr gate = std::dynamic_pointer_cast<Gate>(object))
+        {
+            gates.remove(gate);
+        }
+        else if (object->get_layer() == project->get_logic_model()->get_current_layer())
+        {
+            if (EMarker_shptr emarker = std::dynamic_pointer_cast<EMarker>(object))
+            {
+                emarkers.remove(emarker);
+            }
+            else if (Via_shptr via = std::dynamic_pointer_cast<Via>(object))
+            {
+                vias.remove(via);
+            }
+            else if (Wire_shptr wire = std::dynamic_pointer_cast<Wire>(object))
+            {
+                wires.remove(wire);
+            }
+        }
+
+        lod.remove(object);
+
         update();
     }
 
@@ -602,6 +705,8 @@ namespace degate
         if (draw_grid)
             regular_grid.update();
 
+        lod.set_scale(scale);
+
 		projection.setToIdentity();
 		projection.ortho(viewport_min_x, viewport_max_x, viewport_max_y, viewport_min_y, -1, 1);
 	}
@@ -734,7 +839,7 @@ namespace degate
 
             emit project_changed();
 
-            update_wires();
+            add_object(new_wire);
         }
 
         // Area selection + CTRL
@@ -773,8 +878,8 @@ namespace degate
                 PlacedLogicModelObject_shptr plo = *iter;
                 assert(plo != nullptr);
 
-                if (std::dynamic_pointer_cast<GatePort>(plo) != nullptr ||
-                    std::dynamic_pointer_cast<Gate>(plo) != nullptr)
+                if (plo->is_of_kind(PlacedLogicModelObject::KIND_GATE_PORT) ||
+                    plo->is_of_kind(PlacedLogicModelObject::KIND_GATE))
                 {
                     selected_objects.add(plo);
                 }
@@ -967,6 +1072,8 @@ namespace degate
 					AnnotationEditDialog dialog(this, annotation);
 					dialog.exec();
 
+					project->get_logic_model()->get_journal()->record_object(annotation->get_object_id());
+
                     makeCurrent();
 					annotations.update();
 					update();
@@ -978,6 +1085,8 @@ namespace degate
                     EMarkerEditDialog dialog(this, emarker);
                     dialog.exec();
 
+                    project->get_logic_model()->get_journal()->record_object(emarker->get_object_id());
+
                     makeCurrent();
                     emarkers.update();
                     update();
@@ -989,6 +1098,8 @@ namespace degate
                     ViaEditDialog dialog(this, via, project);
                     dialog.exec();
 
+                    project->get_logic_model()->get_journal()->record_object(via->get_object_id());
+
                     makeCurrent();
                     vias.update();
                     update();
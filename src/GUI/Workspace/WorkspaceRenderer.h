@@ -38,6 +38,7 @@
 #include "GUI/Workspace/WorkspaceWires.h"
 #include "GUI/Workspace/WorkspaceWireTool.h"
 #include "GUI/Workspace/WorkspaceRegularGrid.h"
+#include "GUI/Workspace/WorkspaceLOD.h"
 
 #include <QtOpenGL/QtOpenGL>
 #include <list>
@@ -229,10 +230,22 @@ namespace degate
         WorkspaceTool get_current_tool() const;
 
         /**
-         * Update an object of the workspace.
+         * Update an object of the workspace (only the chunks it lies in are rebuilt).
          */
         void update_object(PlacedLogicModelObject_shptr object);
 
+        /**
+         * Add a new object to the workspace (only the chunks it lies in are rebuilt).
+         * Call it after adding the object to the logic model.
+         */
+        void add_object(PlacedLogicModelObject_shptr object);
+
+        /**
+         * Remove an object from the workspace (only the chunks it lies in are rebuilt).
+         * Call it before removing the object from the logic model.
+         */
+        void remove_object(PlacedLogicModelObject_shptr object);
+
         /**
          * Center the viewport on a specific point.
          *
@@ -481,6 +494,9 @@ namespace degate
         // Wires
         WorkspaceWires wires;
 
+        // Level of detail (simplified view when zoomed out)
+        WorkspaceLOD lod;
+
         // Selection tool
         WorkspaceSelectionTool selection_tool;
 
@@ -0,0 +1,368 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "WorkspaceTilePool.h"
+#include "Core/Utils/Trace.h"
+
+#include <QtConcurrent/QtConcurrent>
+#include <QCoreApplication>
+#include <QPointer>
+
+#include <cstring>
+
+namespace degate
+{
+    WorkspaceTilePool::WorkspaceTilePool(QWidget* parent)
+            : parent(parent),
+              read_mutex(std::make_shared<std::mutex>()),
+              read_tiles(std::make_shared<std::deque<ReadTile>>())
+    {
+
+    }
+
+    WorkspaceTilePool::~WorkspaceTilePool()
+    {
+        if (QOpenGLContext::currentContext() == nullptr || context == nullptr)
+            return;
+
+        free_textures();
+
+        context->glDeleteBuffers(BACKGROUND_TILE_PBO_COUNT, pbos);
+    }
+
+    void WorkspaceTilePool::init()
+    {
+        context = QOpenGLContext::currentContext()->functions();
+        extra_context = QOpenGLContext::currentContext()->extraFunctions();
+
+        context->glGenBuffers(BACKGROUND_TILE_PBO_COUNT, pbos);
+    }
+
+    void WorkspaceTilePool::set_source(ScalingManager_shptr scaling_manager)
+    {
+        if (scaling_manager == this->scaling_manager && gs_scaling_manager == nullptr)
+            return;
+
+        this->scaling_manager = scaling_manager;
+        gs_scaling_manager = nullptr;
+
+        reset(scaling_manager == nullptr ? 0 : scaling_manager->get_image(1).second->get_tile_size(), sizeof(rgba_pixel_t));
+    }
+
+    void WorkspaceTilePool::set_source(GreyscaleScalingManager_shptr scaling_manager)
+    {
+        if (scaling_manager == gs_scaling_manager && this->scaling_manager == nullptr)
+            return;
+
+        this->scaling_manager = nullptr;
+        gs_scaling_manager = scaling_manager;
+
+        reset(scaling_manager == nullptr ? 0 : scaling_manager->get_image(1).second->get_tile_size(), sizeof(gs_byte_pixel_t));
+    }
+
+    void WorkspaceTilePool::reset(unsigned int new_tile_size, unsigned int new_pixel_size)
+    {
+        // Drop all tiles, but keep textures if they still have the right size and format.
+        if (new_tile_size != tile_size || new_pixel_size != pixel_size)
+        {
+            free_textures();
+
+            tile_size = new_tile_size;
+            pixel_size = new_pixel_size;
+
+            if (tile_size != 0)
+            {
+                const unsigned int tile_memory = tile_size * tile_size * pixel_size;
+                capacity = std::max<unsigned int>(BACKGROUND_TILE_POOL_MEMORY / tile_memory, BACKGROUND_TILE_POOL_MIN_SIZE);
+            }
+        }
+        else
+        {
+            for (auto& e : entries)
+                free_list.push_back(e.second.texture);
+
+            entries.clear();
+            lru.clear();
+        }
+
+        // Tiles being read for the old images are dropped when they arrive.
+        generation++;
+        pending.clear();
+
+        std::lock_guard<std::mutex> lock(*read_mutex);
+        read_tiles->clear();
+    }
+
+    void WorkspaceTilePool::begin_frame()
+    {
+        TRACE_SCOPE_CATEGORY("render/upload-tiles", "render");
+
+        frame++;
+
+        if (context == nullptr)
+            return;
+
+        std::deque<ReadTile> tiles;
+        {
+            std::lock_guard<std::mutex> lock(*read_mutex);
+
+            while (!read_tiles->empty() && tiles.size() < BACKGROUND_TILE_UPLOADS_PER_FRAME)
+            {
+                tiles.push_back(std::move(read_tiles->front()));
+                read_tiles->pop_front();
+            }
+        }
+
+        for (auto& tile : tiles)
+        {
+            if (tile.generation != generation)
+                continue;
+
+            if (!upload(tile))
+            {
+                // The pool is full of tiles needed by this frame, retry later.
+                std::lock_guard<std::mutex> lock(*read_mutex);
+                read_tiles->push_back(std::move(tile));
+
+                continue;
+            }
+
+            pending.erase(tile.key);
+        }
+
+        // Some tiles are still waiting for upload, ask for another frame.
+        bool remaining;
+        {
+            std::lock_guard<std::mutex> lock(*read_mutex);
+            remaining = !read_tiles->empty();
+        }
+
+        if (remaining && parent != nullptr)
+            parent->update();
+    }
+
+    GLuint WorkspaceTilePool::get_texture(TileKey const& key, bool request)
+    {
+        auto iter = entries.find(key);
+
+        if (iter == entries.end())
+        {
+            if (request)
+                this->request(key);
+
+            return 0;
+        }
+
+        // Move to the front of the LRU list.
+        lru.splice(lru.begin(), lru, iter->second.lru);
+        iter->second.last_frame = frame;
+
+        return iter->second.texture;
+    }
+
+    unsigned int WorkspaceTilePool::get_tile_size() const
+    {
+        return tile_size;
+    }
+
+    void WorkspaceTilePool::free_textures()
+    {
+        if (context == nullptr)
+            return;
+
+        for (auto& e : entries)
+            free_list.push_back(e.second.texture);
+
+        if (!free_list.empty())
+            context->glDeleteTextures(static_cast<GLsizei>(free_list.size()), &free_list[0]);
+
+        entries.clear();
+        lru.clear();
+        free_list.clear();
+        textures_count = 0;
+    }
+
+    void WorkspaceTilePool::request(TileKey const& key)
+    {
+        if (gs_scaling_manager != nullptr)
+            request(key, gs_scaling_manager);
+        else
+            request(key, scaling_manager);
+    }
+
+    template <typename ImageType>
+    void WorkspaceTilePool::request(TileKey const& key, std::shared_ptr<ScalingManager<ImageType>> manager)
+    {
+        if (manager == nullptr || pending.find(key) != pending.end())
+            return;
+
+        // Bound the number of tiles being read. Tiles still visible are requested again by the next frames.
+        if (pending.size() >= static_cast<size_t>(std::max(QThread::idealThreadCount(), 1)) * 2)
+            return;
+
+        auto images = manager->get_images();
+        auto image = images.find(key.scaling);
+
+        if (image == images.end())
+            return;
+
+        pending[key] = frame;
+
+        std::shared_ptr<ImageType> source = image->second;
+        const unsigned long long tile_generation = generation;
+        auto mutex = read_mutex;
+        auto tiles = read_tiles;
+        QPointer<QWidget> widget(parent);
+
+        QtConcurrent::run([=]()
+        {
+            ReadTile tile;
+            tile.key = key;
+            tile.generation = tile_generation;
+            tile.pixels.resize(source->get_tile_size() * source->get_tile_size() * sizeof(typename ImageType::pixel_type));
+
+            // Read the tile here, so the upload does not wait for the disk.
+            source->fetch_tile(key.x, key.y)->raw_copy(tile.pixels.data());
+
+            {
+                std::lock_guard<std::mutex> lock(*mutex);
+                tiles->push_back(std::move(tile));
+            }
+
+            // Repaint from the GUI thread.
+            QMetaObject::invokeMethod(qApp, [widget]()
+            {
+                if (widget != nullptr)
+                    widget->update();
+            }, Qt::QueuedConnection);
+        });
+    }
+
+    bool WorkspaceTilePool::upload(ReadTile const& tile)
+    {
+        if (tile.pixels.size() != tile_size * tile_size * pixel_size || entries.find(tile.key) != entries.end())
+            return true;
+
+        GLuint texture = acquire_texture();
+
+        if (texture == 0)
+            return false;
+
+        const GLsizeiptr size = static_cast<GLsizeiptr>(tile.pixels.size());
+
+        // Stream the pixels through a pixel buffer object, so the texture upload does not block.
+        const GLuint pbo = pbos[next_pbo];
+        next_pbo = (next_pbo + 1) % BACKGROUND_TILE_PBO_COUNT;
+
+        context->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+        context->glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+
+        void* data = extra_context->glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+        const void* source = nullptr;
+
+        if (data != nullptr)
+        {
+            std::memcpy(data, tile.pixels.data(), size);
+            extra_context->glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        }
+        else
+        {
+            // Mapping failed, upload directly from the read tile.
+            context->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            source = tile.pixels.data();
+        }
+
+        context->glBindTexture(GL_TEXTURE_2D, texture);
+        context->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, tile_size, tile_size,
+                                 pixel_size == sizeof(gs_byte_pixel_t) ? GL_RED : GL_RGBA, GL_UNSIGNED_BYTE, source);
+        context->glBindTexture(GL_TEXTURE_2D, 0);
+
+        context->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        lru.push_front(tile.key);
+
+        Entry& entry = entries[tile.key];
+        entry.texture = texture;
+        entry.last_frame = 0;
+        entry.lru = lru.begin();
+
+        return true;
+    }
+
+    GLuint WorkspaceTilePool::acquire_texture()
+    {
+        if (!free_list.empty())
+        {
+            GLuint texture = free_list.back();
+            free_list.pop_back();
+
+            return texture;
+        }
+
+        if (textures_count < capacity)
+        {
+            GLuint texture = 0;
+
+            context->glGenTextures(1, &texture);
+            context->glBindTexture(GL_TEXTURE_2D, texture);
+
+            context->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            context->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            context->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            context->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+            if (pixel_size == sizeof(gs_byte_pixel_t))
+            {
+                // Greyscale tiles are stored in a single channel and sampled as grey.
+                const GLint swizzle[] = {GL_RED, GL_RED, GL_RED, GL_ONE};
+                context->glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+
+                context->glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, tile_size, tile_size, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+            }
+            else
+                context->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, tile_size, tile_size, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+            context->glBindTexture(GL_TEXTURE_2D, 0);
+
+            textures_count++;
+
+            return texture;
+        }
+
+        // Replace the least recently used tile, if it is not used by the current frame.
+        if (lru.empty())
+            return 0;
+
+        auto iter = entries.find(lru.back());
+        assert(iter != entries.end());
+
+        if (iter->second.last_frame == frame)
+            return 0;
+
+        GLuint texture = iter->second.texture;
+
+        entries.erase(iter);
+        lru.pop_back();
+
+        return texture;
+    }
+}
@@ -0,0 +1,222 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __WORKSPACETILEPOOL_H__
+#define __WORKSPACETILEPOOL_H__
+
+#include "Core/Image/Manipulation/ScalingManager.h"
+
+#include <QtOpenGL/QtOpenGL>
+
+#include <map>
+#include <list>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include <memory>
+
+/**
+ * GPU memory used by the background tiles pool (in bytes).
+ */
+#define BACKGROUND_TILE_POOL_MEMORY (256u * 1024u * 1024u)
+
+/**
+ * Minimal number of textures in the background tiles pool.
+ */
+#define BACKGROUND_TILE_POOL_MIN_SIZE 16
+
+/**
+ * Maximal number of tiles uploaded to the GPU per frame.
+ */
+#define BACKGROUND_TILE_UPLOADS_PER_FRAME 4
+
+/**
+ * Number of pixel buffer objects used for the uploads.
+ */
+#define BACKGROUND_TILE_PBO_COUNT 2
+
+namespace degate
+{
+    /**
+     * @class WorkspaceTilePool
+     * @brief Fixed size pool of background tile textures, streamed from the prescaled layer images.
+     *
+     * Tiles are identified by their scaling (@see ScalingManager) and the scaled coordinates of their upper
+     * left corner. When a tile is requested, it is read from the image on a worker thread. Read tiles are
+     * uploaded through pixel buffer objects, at most BACKGROUND_TILE_UPLOADS_PER_FRAME per frame, into one of
+     * the pool textures. When the pool is full, the least recently used tile (that is not used by the current
+     * frame) is replaced.
+     *
+     * The parent widget is repainted each time a tile has been read, so it can be uploaded and drawn.
+     *
+     * @warning Except for the reading, everything is done on the thread of the OpenGL context.
+     */
+    class WorkspaceTilePool
+    {
+    public:
+
+        /**
+         * Identify a tile.
+         */
+        struct TileKey
+        {
+            unsigned int scaling;
+            unsigned int x;
+            unsigned int y;
+
+            bool operator<(TileKey const& other) const
+            {
+                if (scaling != other.scaling) return scaling < other.scaling;
+                if (x != other.x) return x < other.x;
+                return y < other.y;
+            }
+        };
+
+        /**
+         * Create an empty pool.
+         *
+         * @param parent : the widget to repaint when a tile is ready for upload.
+         */
+        explicit WorkspaceTilePool(QWidget* parent);
+        ~WorkspaceTilePool();
+
+        /**
+         * Init OpenGL routine (the current context is used).
+         */
+        void init();
+
+        /**
+         * Set the images to stream tiles from. If they changed, all tiles are dropped.
+         *
+         * @param scaling_manager : the scaling manager of the layer.
+         */
+        void set_source(ScalingManager_shptr scaling_manager);
+
+        /**
+         * Set greyscale images to stream tiles from. The tiles are uploaded as single channel
+         * textures, that are sampled as grey.
+         *
+         * @param scaling_manager : the greyscale scaling manager of the layer.
+         */
+        void set_source(GreyscaleScalingManager_shptr scaling_manager);
+
+        /**
+         * Start a new frame: upload some of the read tiles. Tiles used by a frame are never replaced
+         * during this frame.
+         */
+        void begin_frame();
+
+        /**
+         * Get the texture of a tile, if the tile is uploaded.
+         *
+         * @param key : the tile.
+         * @param request : if true and the tile is not uploaded, start reading it.
+         *
+         * @return Returns the OpenGL texture, 0 if the tile is not uploaded yet.
+         */
+        GLuint get_texture(TileKey const& key, bool request = true);
+
+        /**
+         * Get the tile size (edge length in pixels) of the current images.
+         */
+        unsigned int get_tile_size() const;
+
+        /**
+         * Drop all tiles and destroy all OpenGL objects.
+         */
+        void free_textures();
+
+    private:
+
+        struct Entry
+        {
+            GLuint texture = 0;
+            unsigned long long last_frame = 0;
+            std::list<TileKey>::iterator lru;
+        };
+
+        struct ReadTile
+        {
+            TileKey key;
+            unsigned long long generation;
+            std::vector<uint8_t> pixels;
+        };
+
+        /**
+         * Drop all tiles after the images changed, textures are kept if they still fit.
+         *
+         * @param new_tile_size : the tile size of the new images, 0 if there are none.
+         * @param new_pixel_size : the bytes per pixel of the new images.
+         */
+        void reset(unsigned int new_tile_size, unsigned int new_pixel_size);
+
+        /**
+         * Start reading a tile on a worker thread.
+         */
+        void request(TileKey const& key);
+
+        /**
+         * Start reading a tile of one of the images of \p manager on a worker thread.
+         */
+        template <typename ImageType>
+        void request(TileKey const& key, std::shared_ptr<ScalingManager<ImageType>> manager);
+
+        /**
+         * Upload a read tile, returns false if there is no free texture.
+         */
+        bool upload(ReadTile const& tile);
+
+        /**
+         * Get a texture for a new tile, by creating one or by replacing the least recently used tile.
+         */
+        GLuint acquire_texture();
+
+        QWidget* parent;
+        QOpenGLFunctions* context = nullptr;
+        QOpenGLExtraFunctions* extra_context = nullptr;
+
+        ScalingManager_shptr scaling_manager = nullptr;
+        GreyscaleScalingManager_shptr gs_scaling_manager = nullptr;
+        unsigned int tile_size = 0;
+        unsigned int pixel_size = sizeof(uint32_t);
+        unsigned int capacity = BACKGROUND_TILE_POOL_MIN_SIZE;
+
+        std::map<TileKey, Entry> entries;
+        std::list<TileKey> lru;
+        std::vector<GLuint> free_list;
+        unsigned int textures_count = 0;
+
+        GLuint pbos[BACKGROUND_TILE_PBO_COUNT] = {};
+        unsigned int next_pbo = 0;
+
+        unsigned long long frame = 0;
+        unsigned long long generation = 0;
+
+        // Tiles being read (only accessed from the OpenGL thread).
+        std::map<TileKey, unsigned long long> pending;
+
+        // Read tiles, filled by worker threads.
+        std::shared_ptr<std::mutex> read_mutex;
+        std::shared_ptr<std::deque<ReadTile>> read_tiles;
+    };
+}
+
+#endif //__WORKSPACETILEPOOL_H__
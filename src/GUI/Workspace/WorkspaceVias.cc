@@ -20,19 +20,16 @@
  */
 
 #include "WorkspaceVias.h"
+#include "Core/Utils/Trace.h"
 
 #define TEXT_PADDING 2
 
 namespace degate
 {
-    struct ViasVertex2D
-    {
-        QVector2D pos;
-        QVector3D color;
-        float alpha;
-    };
-
-    WorkspaceVias::WorkspaceVias(QWidget *parent) : WorkspaceElement(parent), text(parent)
+    WorkspaceVias::WorkspaceVias(QWidget *parent)
+            : WorkspaceElement(parent),
+              text(parent),
+              chunks(24, std::bind(&WorkspaceVias::create_via, this, std::placeholders::_1, std::placeholders::_2))
     {
 
     }
@@ -48,6 +45,8 @@ namespace degate
 
         text.init();
 
+        chunks.init(QOpenGLContext::currentContext());
+
         QOpenGLShader* vshader = new QOpenGLShader(QOpenGLShader::Vertex);
         const char* vsrc =
                 "#version 330 core\n"
@@ -86,6 +85,8 @@ namespace degate
 
     void WorkspaceVias::update()
     {
+        TRACE_SCOPE_CATEGORY("render/update-vias", "render");
+
         if (project == nullptr)
             return;
 
@@ -94,69 +95,63 @@ namespace degate
         Layer_shptr layer = project->get_logic_model()->get_current_layer();
 
         if (layer == nullptr)
+        {
+            chunks.clear();
             return;
+        }
 
         // Keep only emarkers of the active layer.
         std::vector<Via_shptr> vias;
-        for (Layer::object_iterator iter = layer->objects_begin(); iter != layer->objects_end(); ++iter)
+        vias.reserve(layer->get_object_count(PlacedLogicModelObject::KIND_VIA));
+        for (Layer::object_iterator iter = layer->objects_begin(PlacedLogicModelObject::KIND_VIA);
+             iter != layer->objects_end(); ++iter)
         {
-            if (Via_shptr a = std::dynamic_pointer_cast<Via>(*iter))
-            {
-                vias.push_back(a);
-            }
+            vias.push_back(std::static_pointer_cast<Via>(*iter));
         }
-        vias_count = static_cast<unsigned int>(vias.size());
-
-        if (vias_count == 0)
-            return;
-
-        vao.bind();
-        context->glBindBuffer(GL_ARRAY_BUFFER, vbo);
 
-        context->glBufferData(GL_ARRAY_BUFFER, vias_count * 24 * sizeof(ViasVertex2D), nullptr, GL_STATIC_DRAW);
+        // Geometry is generated lazily, when a chunk becomes visible.
+        chunks.reset(layer->get_bounding_box(), vias);
 
-        context->glBindBuffer(GL_ARRAY_BUFFER, 0);
-        vao.release();
-
-        unsigned text_size = 0;
+        text.clear();
 
-        unsigned index = 0;
         for (auto& e : vias)
-        {
-            create_via(e, index);
-            e->set_index(index);
+            add_label(e);
 
-            text_size += static_cast<unsigned int>(e->get_name().length());
-            index++;
-        }
+        assert(context->glGetError() == GL_NO_ERROR);
+    }
+
+    void WorkspaceVias::update(Via_shptr &via)
+    {
+        if (via == nullptr)
+            return;
 
-        text.update(text_size);
+        chunks.update(via);
 
-        unsigned text_offset = 0;
-        for (auto& e : vias)
-        {
-            unsigned x = e->get_x();
-            unsigned y = e->get_y() + e->get_diameter() / 2.0 + TEXT_PADDING;
-            text.add_sub_text(text_offset, x, y, e->get_name(), 5, QVector3D(255, 255, 255), 1, true, false);
+        text.remove_labels(via->get_object_id());
+        add_label(via);
+    }
 
-            text_offset += static_cast<unsigned int>(e->get_name().length());
-            index++;
-        }
+    void WorkspaceVias::insert(Via_shptr& via)
+    {
+        if (via == nullptr)
+            return;
 
-        assert(context->glGetError() == GL_NO_ERROR);
+        chunks.insert(via);
+        add_label(via);
     }
 
-    void WorkspaceVias::update(Via_shptr &via)
+    void WorkspaceVias::remove(Via_shptr& via)
     {
         if (via == nullptr)
             return;
 
-        create_via(via, via->get_index());
+        chunks.remove(via);
+        text.remove_labels(via->get_object_id());
     }
 
     void WorkspaceVias::draw(const QMatrix4x4& projection)
     {
-        if (project == nullptr || vias_count == 0)
+        if (project == nullptr || chunks.get_objects_count() == 0)
             return;
 
         program->bind();
@@ -164,20 +159,19 @@ namespace degate
         program->setUniformValue("mvp", projection);
 
         vao.bind();
-        context->glBindBuffer(GL_ARRAY_BUFFER, vbo);
 
-        program->enableAttributeArray("pos");
-        program->setAttributeBuffer("pos", GL_FLOAT, 0, 2, sizeof(ViasVertex2D));
-
-        program->enableAttributeArray("color");
-        program->setAttributeBuffer("color", GL_FLOAT, 2 * sizeof(float), 3, sizeof(ViasVertex2D));
+        chunks.draw(projection, [this]()
+        {
+            program->enableAttributeArray("pos");
+            program->setAttributeBuffer("pos", GL_FLOAT, 0, 2, sizeof(ViasVertex2D));
 
-        program->enableAttributeArray("alpha");
-        program->setAttributeBuffer("alpha", GL_FLOAT, 5 * sizeof(float), 1, sizeof(ViasVertex2D));
+            program->enableAttributeArray("color");
+            program->setAttributeBuffer("color", GL_FLOAT, 2 * sizeof(float), 3, sizeof(ViasVertex2D));
 
-        context->glDrawArrays(GL_TRIANGLES, 0, vias_count * 24);
+            program->enableAttributeArray("alpha");
+            program->setAttributeBuffer("alpha", GL_FLOAT, 5 * sizeof(float), 1, sizeof(ViasVertex2D));
+        });
 
-        context->glBindBuffer(GL_ARRAY_BUFFER, 0);
         vao.release();
 
         program->release();
@@ -185,20 +179,14 @@ namespace degate
 
     void WorkspaceVias::draw_name(const QMatrix4x4 &projection)
     {
-        if (project == nullptr || vias_count == 0)
+        if (project == nullptr || chunks.get_objects_count() == 0)
             return;
 
         text.draw(projection);
     }
 
-    void WorkspaceVias::create_via(Via_shptr &via, unsigned int index)
+    void WorkspaceVias::create_via(const Via_shptr &via, ViasVertex2D* vertices) const
     {
-        if (via == nullptr)
-            return;
-
-        vao.bind();
-        context->glBindBuffer(GL_ARRAY_BUFFER, vbo);
-
         const float hole_radius = via->get_diameter() / 4.0;
 
         // Vertices and colors
@@ -222,89 +210,93 @@ namespace degate
         // Rect 1
 
         temp.pos = QVector2D(via->get_x() - via->get_diameter() / 2.0, via->get_y() - via->get_diameter() / 2.0);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 24 * sizeof(ViasVertex2D) + 0 * sizeof(ViasVertex2D), sizeof(ViasVertex2D), &temp);
+        vertices[0] = temp;
 
         temp.pos = QVector2D(via->get_x() - hole_radius, via->get_y() - via->get_diameter() / 2.0);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 24 * sizeof(ViasVertex2D) + 1 * sizeof(ViasVertex2D), sizeof(ViasVertex2D), &temp);
+        vertices[1] = temp;
 
         temp.pos = QVector2D(via->get_x() - via->get_diameter() / 2.0, via->get_y() + via->get_diameter() / 2.0);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 24 * sizeof(ViasVertex2D) + 2 * sizeof(ViasVertex2D), sizeof(ViasVertex2D), &temp);
+        vertices[2] = temp;
 
         temp.pos = QVector2D(via->get_x() - hole_radius, via->get_y() + via->get_diameter() / 2.0);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 24 * sizeof(ViasVertex2D) + 3 * sizeof(ViasVertex2D), sizeof(ViasVertex2D), &temp);
+        vertices[3] = temp;
 
         temp.pos = QVector2D(via->get_x() - via->get_diameter() / 2.0, via->get_y() + via->get_diameter() / 2.0);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 24 * sizeof(ViasVertex2D) + 4 * sizeof(ViasVertex2D), sizeof(ViasVertex2D), &temp);
+        vertices[4] = temp;
 
         temp.pos = QVector2D(via->get_x() - hole_radius, via->get_y() - via->get_diameter() / 2.0);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 24 * sizeof(ViasVertex2D) + 5 * sizeof(ViasVertex2D), sizeof(ViasVertex2D), &temp);
+        vertices[5] = temp;
 
 
         // Rect 2
 
         temp.pos = QVector2D(via->get_x() - hole_radius, via->get_y() - via->get_diameter() / 2.0);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 24 * sizeof(ViasVertex2D) + 6 * sizeof(ViasVertex2D), sizeof(ViasVertex2D), &temp);
+        vertices[6] = temp;
 
         temp.pos = QVector2D(via->get_x() + hole_radius, via->get_y() - via->get_diameter() / 2.0);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 24 * sizeof(ViasVertex2D) + 7 * sizeof(ViasVertex2D), sizeof(ViasVertex2D), &temp);
+        vertices[7] = temp;
 
         temp.pos = QVector2D(via->get_x() - hole_radius, via->get_y() - hole_radius);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 24 * sizeof(ViasVertex2D) + 8 * sizeof(ViasVertex2D), sizeof(ViasVertex2D), &temp);
+        vertices[8] = temp;
 
         temp.pos = QVector2D(via->get_x() - hole_radius, via->get_y() - hole_radius);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 24 * sizeof(ViasVertex2D) + 9 * sizeof(ViasVertex2D), sizeof(ViasVertex2D), &temp);
+        vertices[9] = temp;
 
         temp.pos = QVector2D(via->get_x() + hole_radius, via->get_y() - via->get_diameter() / 2.0);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 24 * sizeof(ViasVertex2D) + 10 * sizeof(ViasVertex2D), sizeof(ViasVertex2D), &temp);
+        vertices[10] = temp;
 
         temp.pos = QVector2D(via->get_x() + hole_radius, via->get_y() - hole_radius);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 24 * sizeof(ViasVertex2D) + 11 * sizeof(ViasVertex2D), sizeof(ViasVertex2D), &temp);
+        vertices[11] = temp;
 
 
 
         // Rect 3
 
         temp.pos = QVector2D(via->get_x() + hole_radius, via->get_y() - via->get_diameter() / 2.0);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 24 * sizeof(ViasVertex2D) + 12 * sizeof(ViasVertex2D), sizeof(ViasVertex2D), &temp);
+        vertices[12] = temp;
 
         temp.pos = QVector2D(via->get_x() + via->get_diameter() / 2.0, via->get_y() - via->get_diameter() / 2.0);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 24 * sizeof(ViasVertex2D) + 13 * sizeof(ViasVertex2D), sizeof(ViasVertex2D), &temp);
+        vertices[13] = temp;
 
         temp.pos = QVector2D(via->get_x() + hole_radius, via->get_y() + via->get_diameter() / 2.0);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 24 * sizeof(ViasVertex2D) + 14 * sizeof(ViasVertex2D), sizeof(ViasVertex2D), &temp);
+        vertices[14] = temp;
 
         temp.pos = QVector2D(via->get_x() + via->get_diameter() / 2.0, via->get_y() - via->get_diameter() / 2.0);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 24 * sizeof(ViasVertex2D) + 15 * sizeof(ViasVertex2D), sizeof(ViasVertex2D), &temp);
+        vertices[15] = temp;
 
         temp.pos = QVector2D(via->get_x() + via->get_diameter() / 2.0, via->get_y() + via->get_diameter() / 2.0);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 24 * sizeof(ViasVertex2D) + 16 * sizeof(ViasVertex2D), sizeof(ViasVertex2D), &temp);
+        vertices[16] = temp;
 
         temp.pos = QVector2D(via->get_x() + hole_radius, via->get_y() + via->get_diameter() / 2.0);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 24 * sizeof(ViasVertex2D) + 17 * sizeof(ViasVertex2D), sizeof(ViasVertex2D), &temp);
+        vertices[17] = temp;
 
 
 
         // Rect 4
 
         temp.pos = QVector2D(via->get_x() - hole_radius, via->get_y() + hole_radius);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 24 * sizeof(ViasVertex2D) + 18 * sizeof(ViasVertex2D), sizeof(ViasVertex2D), &temp);
+        vertices[18] = temp;
 
         temp.pos = QVector2D(via->get_x() - hole_radius, via->get_y() + via->get_diameter() / 2.0);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 24 * sizeof(ViasVertex2D) + 19 * sizeof(ViasVertex2D), sizeof(ViasVertex2D), &temp);
+        vertices[19] = temp;
 
         temp.pos = QVector2D(via->get_x() + hole_radius, via->get_y() + hole_radius);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 24 * sizeof(ViasVertex2D) + 20 * sizeof(ViasVertex2D), sizeof(ViasVertex2D), &temp);
+        vertices[20] = temp;
 
         temp.pos = QVector2D(via->get_x() + hole_radius, via->get_y() + hole_radius);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 24 * sizeof(ViasVertex2D) + 21 * sizeof(ViasVertex2D), sizeof(ViasVertex2D), &temp);
+        vertices[21] = temp;
 
         temp.pos = QVector2D(via->get_x() + hole_radius, via->get_y() + via->get_diameter() / 2.0);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 24 * sizeof(ViasVertex2D) + 22 * sizeof(ViasVertex2D), sizeof(ViasVertex2D), &temp);
+        vertices[22] = temp;
 
         temp.pos = QVector2D(via->get_x() - hole_radius, via->get_y() + via->get_diameter() / 2.0);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 24 * sizeof(ViasVertex2D) + 23 * sizeof(ViasVertex2D), sizeof(ViasVertex2D), &temp);
+        vertices[23] = temp;
+    }
 
-        context->glBindBuffer(GL_ARRAY_BUFFER, 0);
-        vao.release();
+    void WorkspaceVias::add_label(const Via_shptr& via)
+    {
+        unsigned x = via->get_x();
+        unsigned y = via->get_y() + via->get_diameter() / 2.0 + TEXT_PADDING;
+        text.add_label(x, y, via->get_name(), 5, QVector3D(255, 255, 255), 1, true, false, 0, via->get_object_id());
     }
 }
\ No newline at end of file
@@ -23,16 +23,24 @@
 #define __WORKSPACEVIAS_H__
 
 #include "GUI/Workspace/WorkspaceElement.h"
+#include "GUI/Workspace/WorkspaceChunks.h"
 #include "Core/LogicModel/Via/Via.h"
-#include "GUI/Text/Text.h"
+#include "GUI/Text/TextLabels.h"
 
 namespace degate
 {
+    struct ViasVertex2D
+    {
+        QVector2D pos;
+        QVector3D color;
+        float alpha;
+    };
+
     /**
      * @class WorkspaceVias
      * @brief Prepare and draw all vias of the active layer on the workspace.
      *
-     * The parent vbo buffer will store all squares.
+     * Vias are stored in spatial chunks, each chunk has its own vbo (@see WorkspaceChunks).
      *
      * @see WorkspaceElement
      */
@@ -60,7 +68,7 @@ namespace degate
         void update() override;
 
         /**
-         * Update a specific via (update buffers).
+         * Update a specific via (mark its chunk as dirty and replace its name label).
          *
          * @warning Call the update() function before.
          *
@@ -69,7 +77,21 @@ namespace degate
         void update(Via_shptr& via);
 
         /**
-         * Draw all vias (draw the square and outline buffers).
+         * Add a new via of the active layer (only its chunk is rebuilt).
+         *
+         * @param via : the new via.
+         */
+        void insert(Via_shptr& via);
+
+        /**
+         * Remove a via (only its chunk is rebuilt).
+         *
+         * @param via : the removed via.
+         */
+        void remove(Via_shptr& via);
+
+        /**
+         * Draw all vias of the chunks intersecting the viewport.
          *
          * @param projection : the projection matrix to apply.
          */
@@ -84,15 +106,22 @@ namespace degate
 
     private:
         /**
-         * Create an via in OpenGL buffers.
+         * Create the vertices of a via (called from worker threads).
+         *
+         * @param via : the via object.
+         * @param vertices : the 24 vertices to fill.
+         */
+        void create_via(const Via_shptr& via, ViasVertex2D* vertices) const;
+
+        /**
+         * Add the name label of a via.
          *
          * @param via : the via object.
-         * @param index : the index of the annotation for OpenGL buffers.
          */
-        void create_via(Via_shptr& via, unsigned index);
+        void add_label(const Via_shptr& via);
 
-        Text text;
-        unsigned vias_count = 0;
+        TextLabels text;
+        WorkspaceChunks<Via, ViasVertex2D> chunks;
 
     };
 }
@@ -20,17 +20,15 @@
  */
 
 #include "WorkspaceWires.h"
+#include "Core/Utils/Trace.h"
 
 namespace degate
 {
-    struct WiresVertex2D
-    {
-        QVector2D pos;
-        QVector3D color;
-        float alpha;
-    };
-
-    WorkspaceWires::WorkspaceWires(QWidget *parent) : WorkspaceElement(parent)
+    WorkspaceWires::WorkspaceWires(QWidget *parent)
+            : WorkspaceElement(parent),
+              chunks(6,
+                     std::bind(&WorkspaceWires::create_wire, this, std::placeholders::_1, std::placeholders::_2),
+                     &WorkspaceWires::get_wire_extent)
     {
 
     }
@@ -44,6 +42,8 @@ namespace degate
     {
         WorkspaceElement::init();
 
+        chunks.init(QOpenGLContext::currentContext());
+
         QOpenGLShader* vshader = new QOpenGLShader(QOpenGLShader::Vertex);
         const char* vsrc =
                 "#version 330 core\n"
@@ -82,6 +82,8 @@ namespace degate
 
     void WorkspaceWires::update()
     {
+        TRACE_SCOPE_CATEGORY("render/update-wires", "render");
+
         if (project == nullptr)
             return;
 
@@ -90,52 +92,53 @@ namespace degate
         Layer_shptr layer = project->get_logic_model()->get_current_layer();
 
         if (layer == nullptr)
+        {
+            chunks.clear();
             return;
+        }
 
         // Keep only wires of the active layer.
         std::vector<Wire_shptr> wires;
-        for (Layer::object_iterator iter = layer->objects_begin(); iter != layer->objects_end(); ++iter)
+        wires.reserve(layer->get_object_count(PlacedLogicModelObject::KIND_WIRE));
+        for (Layer::object_iterator iter = layer->objects_begin(PlacedLogicModelObject::KIND_WIRE);
+             iter != layer->objects_end(); ++iter)
         {
-            if (Wire_shptr a = std::dynamic_pointer_cast<Wire>(*iter))
-            {
-                wires.push_back(a);
-            }
+            wires.push_back(std::static_pointer_cast<Wire>(*iter));
         }
-        wires_count = static_cast<unsigned int>(wires.size());
 
-        if (wires_count == 0)
-            return;
+        // Geometry is generated lazily, when a chunk becomes visible.
+        chunks.reset(layer->get_bounding_box(), wires);
 
-        vao.bind();
-        context->glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        assert(context->glGetError() == GL_NO_ERROR);
+    }
 
-        context->glBufferData(GL_ARRAY_BUFFER, wires_count * 6 * sizeof(WiresVertex2D), nullptr, GL_STATIC_DRAW);
+    void WorkspaceWires::update(Wire_shptr &wire)
+    {
+        if (wire == nullptr)
+            return;
 
-        context->glBindBuffer(GL_ARRAY_BUFFER, 0);
-        vao.release();
+        chunks.update(wire);
+    }
 
-        unsigned index = 0;
-        for (auto& e : wires)
-        {
-            create_wire(e, index);
-            e->set_index(index);
-            index++;
-        }
+    void WorkspaceWires::insert(Wire_shptr& wire)
+    {
+        if (wire == nullptr)
+            return;
 
-        assert(context->glGetError() == GL_NO_ERROR);
+        chunks.insert(wire);
     }
 
-    void WorkspaceWires::update(Wire_shptr &wire)
+    void WorkspaceWires::remove(Wire_shptr& wire)
     {
         if (wire == nullptr)
             return;
 
-        create_wire(wire, wire->get_index());
+        chunks.remove(wire);
     }
 
     void WorkspaceWires::draw(const QMatrix4x4 &projection)
     {
-        if (project == nullptr || wires_count == 0)
+        if (project == nullptr || chunks.get_objects_count() == 0)
             return;
 
         program->bind();
@@ -143,33 +146,34 @@ namespace degate
         program->setUniformValue("mvp", projection);
 
         vao.bind();
-        context->glBindBuffer(GL_ARRAY_BUFFER, vbo);
-
-        program->enableAttributeArray("pos");
-        program->setAttributeBuffer("pos", GL_FLOAT, 0, 2, sizeof(WiresVertex2D));
 
-        program->enableAttributeArray("color");
-        program->setAttributeBuffer("color", GL_FLOAT, 2 * sizeof(float), 3, sizeof(WiresVertex2D));
+        chunks.draw(projection, [this]()
+        {
+            program->enableAttributeArray("pos");
+            program->setAttributeBuffer("pos", GL_FLOAT, 0, 2, sizeof(WiresVertex2D));
 
-        program->enableAttributeArray("alpha");
-        program->setAttributeBuffer("alpha", GL_FLOAT, 5 * sizeof(float), 1, sizeof(WiresVertex2D));
+            program->enableAttributeArray("color");
+            program->setAttributeBuffer("color", GL_FLOAT, 2 * sizeof(float), 3, sizeof(WiresVertex2D));
 
-        context->glDrawArrays(GL_TRIANGLES, 0, wires_count * 6);
+            program->enableAttributeArray("alpha");
+            program->setAttributeBuffer("alpha", GL_FLOAT, 5 * sizeof(float), 1, sizeof(WiresVertex2D));
+        });
 
-        context->glBindBuffer(GL_ARRAY_BUFFER, 0);
         vao.release();
 
         program->release();
     }
 
-    void WorkspaceWires::create_wire(Wire_shptr &wire, unsigned int index)
+    BoundingBox WorkspaceWires::get_wire_extent(const Wire_shptr& wire)
     {
-        if (wire == nullptr)
-            return;
+        const BoundingBox& box = wire->get_bounding_box();
+        const float radius = static_cast<float>(wire->get_diameter()) / 2.0f;
 
-        vao.bind();
-        context->glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        return BoundingBox(box.get_min_x() - radius, box.get_max_x() + radius, box.get_min_y() - radius, box.get_max_y() + radius);
+    }
 
+    void WorkspaceWires::create_wire(const Wire_shptr &wire, WiresVertex2D* vertices) const
+    {
         // Vertices and colors
 
         color_t color = wire->get_fill_color() == 0 ? project->get_default_color(DEFAULT_COLOR_EMARKER) : wire->get_fill_color();
@@ -192,24 +196,21 @@ namespace degate
         perpendicular_vector.normalize();
 
         temp.pos = QVector2D(from_x + perpendicular_vector.x() * radius, from_y + perpendicular_vector.y() * radius);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 6 * sizeof(WiresVertex2D) + 0 * sizeof(WiresVertex2D), sizeof(WiresVertex2D), &temp);
+        vertices[0] = temp;
 
         temp.pos = QVector2D(from_x - perpendicular_vector.x() * radius, from_y - perpendicular_vector.y() * radius);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 6 * sizeof(WiresVertex2D) + 1 * sizeof(WiresVertex2D), sizeof(WiresVertex2D), &temp);
+        vertices[1] = temp;
 
         temp.pos = QVector2D(to_x + perpendicular_vector.x() * radius, to_y + perpendicular_vector.y() * radius);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 6 * sizeof(WiresVertex2D) + 2 * sizeof(WiresVertex2D), sizeof(WiresVertex2D), &temp);
+        vertices[2] = temp;
 
         temp.pos = QVector2D(to_x + perpendicular_vector.x() * radius, to_y + perpendicular_vector.y() * radius);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 6 * sizeof(WiresVertex2D) + 4 * sizeof(WiresVertex2D), sizeof(WiresVertex2D), &temp);
+        vertices[4] = temp;
 
         temp.pos = QVector2D(to_x - perpendicular_vector.x() * radius, to_y - perpendicular_vector.y() * radius);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 6 * sizeof(WiresVertex2D) + 3 * sizeof(WiresVertex2D), sizeof(WiresVertex2D), &temp);
+        vertices[3] = temp;
 
         temp.pos = QVector2D(from_x - perpendicular_vector.x() * radius, from_y - perpendicular_vector.y() * radius);
-        context->glBufferSubData(GL_ARRAY_BUFFER, index * 6 * sizeof(WiresVertex2D) + 5 * sizeof(WiresVertex2D), sizeof(WiresVertex2D), &temp);
-
-        context->glBindBuffer(GL_ARRAY_BUFFER, 0);
-        vao.release();
+        vertices[5] = temp;
     }
 }
\ No newline at end of file
@@ -23,17 +23,24 @@
 #define __WORKSPACEWIRES_H__
 
 #include "GUI/Workspace/WorkspaceElement.h"
+#include "GUI/Workspace/WorkspaceChunks.h"
 #include "Core/LogicModel/Wire/Wire.h"
 #include "GUI/Text/Text.h"
 
 namespace degate
 {
+    struct WiresVertex2D
+    {
+        QVector2D pos;
+        QVector3D color;
+        float alpha;
+    };
 
     /**
      * @class WorkspaceEMarkers
      * @brief Prepare and draw all wires of the active layer on the workspace.
      *
-     * The parent vbo buffer will store all squares.
+     * Wires are stored in spatial chunks, each chunk has its own vbo (@see WorkspaceChunks).
      *
      * @see WorkspaceElement
      */
@@ -61,7 +68,7 @@ namespace degate
         void update() override;
 
         /**
-         * Update a specific wire (update buffers).
+         * Update a specific wire (mark its chunk as dirty).
          *
          * @warning Call the update() function before.
          *
@@ -70,7 +77,21 @@ namespace degate
         void update(Wire_shptr& wire);
 
         /**
-         * Draw all wires (draw the square and outline buffers).
+         * Add a new wire of the active layer (only its chunk is rebuilt).
+         *
+         * @param wire : the new wire.
+         */
+        void insert(Wire_shptr& wire);
+
+        /**
+         * Remove a wire (only its chunk is rebuilt).
+         *
+         * @param wire : the removed wire.
+         */
+        void remove(Wire_shptr& wire);
+
+        /**
+         * Draw all wires of the chunks intersecting the viewport.
          *
          * @param projection : the projection matrix to apply.
          */
@@ -79,14 +100,21 @@ namespace degate
 
     private:
         /**
-         * Create an wire in OpenGL buffers.
+         * Create the vertices of a wire (called from worker threads).
+         *
+         * @param wire : the wire object.
+         * @param vertices : the 6 vertices to fill.
+         */
+        void create_wire(const Wire_shptr& wire, WiresVertex2D* vertices) const;
+
+        /**
+         * Get the area covered by a wire (the line bounding box extended by the wire radius).
          *
          * @param wire : the wire object.
-         * @param index : the index of the annotation for OpenGL buffers.
          */
-        void create_wire(Wire_shptr& wire, unsigned index);
+        static BoundingBox get_wire_extent(const Wire_shptr& wire);
 
-        unsigned wires_count = 0;
+        WorkspaceChunks<Wire, WiresVertex2D> chunks;
 
     };
 }
@@ -131,6 +131,9 @@ namespace degate
     class GateLibrary;
     typedef std::shared_ptr<GateLibrary> GateLibrary_shptr;
 
+    class PreparedTemplateCache;
+    typedef std::shared_ptr<PreparedTemplateCache> PreparedTemplateCache_shptr;
+
     class Layer;
     typedef std::shared_ptr<Layer> Layer_shptr;
 
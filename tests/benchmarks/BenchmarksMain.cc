@@ -0,0 +1,149 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/Utils/DegateHelper.h"
+
+#define CATCH_CONFIG_RUNNER
+#include "catch.hpp"
+
+#include <QCoreApplication>
+#include <QThreadPool>
+
+#include <iomanip>
+#include <sstream>
+
+using namespace degate;
+
+namespace
+{
+    /**
+     * Catch2 reporter, that writes all benchmark results as one JSON document when the
+     * run ends. Select it with "-r json". All durations are in nanoseconds.
+     */
+    class JSONReporter : public Catch::StreamingReporterBase<JSONReporter>
+    {
+    private:
+
+        struct BenchmarkResult
+        {
+            std::string test_case;
+            Catch::BenchmarkStats<> stats;
+        };
+
+        std::vector<BenchmarkResult> results;
+        std::vector<std::pair<std::string, std::string>> failures;
+        std::string current_benchmark;
+
+    public:
+
+        JSONReporter(Catch::ReporterConfig const& config) : StreamingReporterBase(config)
+        {
+        }
+
+        static std::string getDescription()
+        {
+            return "Reports benchmark results as JSON document";
+        }
+
+        void assertionStarting(Catch::AssertionInfo const&) override
+        {
+        }
+
+        bool assertionEnded(Catch::AssertionStats const& stats) override
+        {
+            if (!stats.assertionResult.isOk())
+                failures.emplace_back(currentTestCaseInfo->name, stats.assertionResult.getExpression());
+
+            return true;
+        }
+
+        void benchmarkPreparing(std::string const& name) override
+        {
+            current_benchmark = name;
+        }
+
+        void benchmarkEnded(Catch::BenchmarkStats<> const& stats) override
+        {
+            results.push_back({currentTestCaseInfo->name, stats});
+        }
+
+        void benchmarkFailed(std::string const& error) override
+        {
+            failures.emplace_back(current_benchmark, error);
+        }
+
+        void testRunEnded(Catch::TestRunStats const& stats) override
+        {
+            stream << "{" << std::endl;
+#ifdef DEGATE_VERSION
+            stream << "  \"degate-version\": " << json_string(DEGATE_VERSION) << "," << std::endl;
+#endif
+            stream << "  \"threads\": " << QThreadPool::globalInstance()->maxThreadCount() << "," << std::endl;
+            stream << "  \"benchmarks\": [";
+
+            stream << std::setprecision(12);
+
+            for (unsigned int i = 0; i < results.size(); i++)
+            {
+                Catch::BenchmarkStats<> const& s = results[i].stats;
+
+                stream << (i == 0 ? "" : ",") << std::endl
+                       << "    {\"name\": " << json_string(s.info.name)
+                       << ", \"test-case\": " << json_string(results[i].test_case)
+                       << ", \"samples\": " << s.info.samples
+                       << ", \"iterations\": " << s.info.iterations
+                       << ", \"mean\": " << s.mean.point.count()
+                       << ", \"mean-lower-bound\": " << s.mean.lower_bound.count()
+                       << ", \"mean-upper-bound\": " << s.mean.upper_bound.count()
+                       << ", \"standard-deviation\": " << s.standardDeviation.point.count()
+                       << ", \"outlier-variance\": " << s.outlierVariance
+                       << "}";
+            }
+
+            stream << std::endl << "  ]," << std::endl;
+            stream << "  \"failures\": [";
+
+            for (unsigned int i = 0; i < failures.size(); i++)
+            {
+                stream << (i == 0 ? "" : ",") << std::endl
+                       << "    {\"name\": " << json_string(failures[i].first)
+                       << ", \"error\": " << json_string(failures[i].second) << "}";
+            }
+
+            stream << std::endl << "  ]," << std::endl;
+            stream << "  \"success\": " << (stats.totals.assertions.failed == 0 && failures.empty() ? "true" : "false")
+                   << std::endl << "}" << std::endl;
+
+            StreamingReporterBase::testRunEnded(stats);
+        }
+    };
+}
+
+CATCH_REGISTER_REPORTER("json", JSONReporter)
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    int result = Catch::Session().run(argc, argv);
+
+    return result;
+}
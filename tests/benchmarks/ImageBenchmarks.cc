@@ -0,0 +1,132 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "SyntheticData.h"
+
+#include "Core/Image/Image.h"
+#include "Core/Image/Manipulation/ImageManipulation.h"
+#include "Core/Image/Manipulation/MedianFilter.h"
+#include "Core/Utils/FilterKernel.h"
+
+#include "catch.hpp"
+
+using namespace degate;
+
+TEST_CASE("Tile cache throughput", "[Benchmark][Image]")
+{
+    // 16 x 16 tiles of 256 x 256 pixels
+    const unsigned int size = 4096, tile_width_exp = 8, tile_size = 1 << tile_width_exp;
+    const unsigned int tiles = size / tile_size;
+
+    BackgroundImage_shptr img = std::make_shared<BackgroundImage>(size, size, tile_width_exp);
+
+    // touch all tiles once, so that the benchmarks do not measure tile creation
+    for (unsigned int y = 0; y < size; y += tile_size)
+        for (unsigned int x = 0; x < size; x += tile_size)
+            img->set_pixel(x, y, 0);
+
+    std::vector<std::pair<unsigned int, unsigned int>> random_tiles(4096);
+    std::mt19937 rng(BENCHMARK_SEED);
+    for (auto& t : random_tiles) t = std::make_pair(rng() % tiles * tile_size, rng() % tiles * tile_size);
+
+    BENCHMARK("fetch_tile sequential")
+    {
+        std::size_t sum = 0;
+        for (unsigned int y = 0; y < size; y += tile_size)
+            for (unsigned int x = 0; x < size; x += tile_size)
+                sum += img->fetch_tile(x, y)->get(0, 0);
+        return sum;
+    };
+
+    BENCHMARK("fetch_tile random")
+    {
+        std::size_t sum = 0;
+        for (auto const& t : random_tiles)
+            sum += img->fetch_tile(t.first, t.second)->get(0, 0);
+        return sum;
+    };
+}
+
+TEST_CASE("Tile image pixel access", "[Benchmark][Image]")
+{
+    const unsigned int size = 2048;
+
+    TileImage_GS_BYTE_shptr img = std::make_shared<TileImage_GS_BYTE>(size, size);
+
+    BENCHMARK("TileImage set_pixel")
+    {
+        for (unsigned int y = 0; y < size; y++)
+            for (unsigned int x = 0; x < size; x++)
+                img->set_pixel(x, y, static_cast<uint8_t>(x ^ y));
+    };
+
+    BENCHMARK("TileImage get_pixel")
+    {
+        std::size_t sum = 0;
+        for (unsigned int y = 0; y < size; y++)
+            for (unsigned int x = 0; x < size; x++)
+                sum += img->get_pixel(x, y);
+        return sum;
+    };
+
+    BENCHMARK("TileImage get_pixel column-wise")
+    {
+        std::size_t sum = 0;
+        for (unsigned int x = 0; x < size; x++)
+            for (unsigned int y = 0; y < size; y++)
+                sum += img->get_pixel(x, y);
+        return sum;
+    };
+}
+
+TEST_CASE("Image filters", "[Benchmark][Image]")
+{
+    const unsigned int size = 1024;
+
+    BackgroundImage_shptr bg = create_synthetic_image(size, size);
+
+    TileImage_GS_DOUBLE_shptr src = std::make_shared<TileImage_GS_DOUBLE>(size, size);
+    TileImage_GS_DOUBLE_shptr dst = std::make_shared<TileImage_GS_DOUBLE>(size, size);
+    copy_image<TileImage_GS_DOUBLE, BackgroundImage>(src, bg);
+
+    FilterKernel_shptr gauss = std::make_shared<GaussianBlur>(5, 5, 1.4);
+    FilterKernel_shptr sobel = std::make_shared<SobelXOperator>();
+
+    BENCHMARK("convolve gaussian 5x5")
+    {
+        convolve<TileImage_GS_DOUBLE, TileImage_GS_DOUBLE>(dst, src, gauss);
+    };
+
+    BENCHMARK("convolve sobel 3x3")
+    {
+        convolve<TileImage_GS_DOUBLE, TileImage_GS_DOUBLE>(dst, src, sobel);
+    };
+
+    BENCHMARK("median_filter 3x3")
+    {
+        median_filter<TileImage_GS_DOUBLE, TileImage_GS_DOUBLE>(dst, src, 3);
+    };
+
+    BENCHMARK("median_filter 7x7")
+    {
+        median_filter<TileImage_GS_DOUBLE, TileImage_GS_DOUBLE>(dst, src, 7);
+    };
+}
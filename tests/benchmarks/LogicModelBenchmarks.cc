@@ -0,0 +1,186 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "SyntheticData.h"
+
+#include "Core/Primitive/QuadTree.h"
+#include "Core/Primitive/QuadTreeRegionIterator.h"
+#include "Core/LogicModel/LogicModelImporter.h"
+#include "Core/LogicModel/LogicModelExporter.h"
+#include "Core/LogicModel/Module.h"
+#include "Core/Utils/FileSystem.h"
+
+#include "catch.hpp"
+
+#include <cmath>
+
+using namespace degate;
+
+TEST_CASE("Quad tree", "[Benchmark][LogicModel]")
+{
+    const unsigned int size = 20000, objects = 100000;
+    const BoundingBox bbox(0, size, 0, size);
+
+    std::vector<PlacedLogicModelObject_shptr> gates;
+    std::mt19937 rng(BENCHMARK_SEED);
+    for (unsigned int i = 0; i < objects; i++)
+    {
+        const float x = static_cast<float>(rng() % (size - 30)), y = static_cast<float>(rng() % (size - 30));
+        gates.push_back(std::make_shared<Gate>(x, x + 10 + rng() % 20, y, y + 10 + rng() % 20));
+    }
+
+    std::vector<BoundingBox> queries;
+    for (unsigned int i = 0; i < 10000; i++)
+    {
+        const int x = static_cast<int>(rng() % (size - 200)), y = static_cast<int>(rng() % (size - 200));
+        queries.emplace_back(x, x + 200, y, y + 200);
+    }
+
+    BENCHMARK("QuadTree insert 100000 objects")
+    {
+        QuadTree<PlacedLogicModelObject_shptr> qt(bbox);
+        for (auto& gate : gates) qt.insert(gate);
+        return qt.total_size();
+    };
+
+    QuadTree<PlacedLogicModelObject_shptr> qt(bbox);
+    for (auto& gate : gates) qt.insert(gate);
+
+    BENCHMARK("QuadTree query 10000 regions")
+    {
+        std::size_t found = 0;
+        for (auto const& query : queries)
+            for (auto iter = qt.region_iter_begin(query); iter != qt.region_iter_end(); ++iter)
+                found++;
+        return found;
+    };
+
+    BENCHMARK_ADVANCED("QuadTree remove 100000 objects")(Catch::Benchmark::Chronometer meter)
+    {
+        std::vector<std::unique_ptr<QuadTree<PlacedLogicModelObject_shptr>>> trees;
+        for (int i = 0; i < meter.runs(); i++)
+        {
+            trees.emplace_back(new QuadTree<PlacedLogicModelObject_shptr>(bbox));
+            for (auto& gate : gates) trees.back()->insert(gate);
+        }
+
+        meter.measure([&](int i)
+        {
+            for (auto& gate : gates) trees[i]->remove(gate);
+            return trees[i]->total_size();
+        });
+    };
+}
+
+TEST_CASE("Autoconnect", "[Benchmark][LogicModel]")
+{
+    const unsigned int objects = 100000, size = 40 * static_cast<unsigned int>(std::ceil(std::sqrt(objects / 3.0)));
+
+    LogicModel_shptr lmodel = std::make_shared<LogicModel>(size, size, 1);
+    fill_synthetic_logic_model(lmodel, objects);
+    Layer_shptr layer = lmodel->get_layer(0);
+
+    // The first run connects the objects. Later runs find the same connections.
+    autoconnect_objects(lmodel, layer, layer->get_bounding_box());
+
+    BENCHMARK("autoconnect_objects 100000 objects")
+    {
+        autoconnect_objects(lmodel, layer, layer->get_bounding_box());
+    };
+}
+
+TEST_CASE("Logic model import and export", "[Benchmark][LogicModel]")
+{
+    const unsigned int objects = get_benchmark_object_count();
+    const unsigned int size = 40 * static_cast<unsigned int>(std::ceil(std::sqrt(objects / 3.0)));
+
+    LogicModel_shptr lmodel = std::make_shared<LogicModel>(size, size, 1);
+    fill_synthetic_logic_model(lmodel, objects);
+
+    const std::string dir = create_temp_directory();
+    const std::string filename = join_pathes(dir, "lmodel.xml");
+
+    LogicModelExporter exporter(std::make_shared<ObjectIDRewriter>(false));
+    exporter.export_data(filename, lmodel);
+
+    BENCHMARK("LogicModelExporter export_data")
+    {
+        LogicModelExporter exporter(std::make_shared<ObjectIDRewriter>(false));
+        exporter.export_data(filename, lmodel);
+    };
+
+    BENCHMARK("LogicModelImporter import")
+    {
+        LogicModelImporter importer(size, size, lmodel->get_gate_library());
+        return importer.import(filename);
+    };
+
+    remove_directory(dir);
+}
+
+TEST_CASE("Module ports", "[Benchmark][LogicModel]")
+{
+    const unsigned int modules = 50, gates_per_module = 200;
+    const unsigned int size = 40 * static_cast<unsigned int>(std::ceil(std::sqrt(modules * gates_per_module)));
+
+    LogicModel_shptr lmodel = std::make_shared<LogicModel>(size, size, 1);
+    fill_synthetic_logic_model(lmodel, 3 * modules * gates_per_module);
+
+    Module_shptr main_module = lmodel->get_main_module();
+    std::vector<Module_shptr> sub_modules;
+    std::vector<Gate_shptr> gates(main_module->gates_begin(), main_module->gates_end());
+    std::sort(gates.begin(), gates.end(), [](Gate_shptr const& a, Gate_shptr const& b)
+    {
+        return a->get_object_id() < b->get_object_id();
+    });
+
+    // Gates are chained from out-port to in-port across all modules.
+    auto get_port = [](Gate_shptr const& gate, GateTemplatePort::PORT_TYPE type)
+    {
+        for (auto iter = gate->ports_begin(); iter != gate->ports_end(); ++iter)
+            if ((*iter)->get_template_port()->get_port_type() == type)
+                return *iter;
+        return GatePort_shptr();
+    };
+
+    for (unsigned int i = 0; i + 1 < gates.size(); i++)
+        connect_objects(lmodel,
+                        ConnectedLogicModelObject_shptr(get_port(gates[i], GateTemplatePort::PORT_TYPE_OUT)),
+                        ConnectedLogicModelObject_shptr(get_port(gates[i + 1], GateTemplatePort::PORT_TYPE_IN)));
+
+    for (unsigned int m = 0; m < modules; m++)
+    {
+        Module_shptr module = std::make_shared<Module>("m" + std::to_string(m));
+        main_module->add_module(module);
+        sub_modules.push_back(module);
+
+        for (unsigned int i = m * gates_per_module; i < (m + 1) * gates_per_module && i < gates.size(); i++)
+        {
+            main_module->remove_gate(gates[i]);
+            module->add_gate(gates[i], false);
+        }
+    }
+
+    BENCHMARK("determine_module_ports 50 modules")
+    {
+        for (auto& module : sub_modules) module->determine_module_ports();
+    };
+}
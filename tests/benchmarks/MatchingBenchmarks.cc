@@ -0,0 +1,110 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "SyntheticData.h"
+
+#include "Core/Matching/TemplateMatching.h"
+#include "Core/Matching/ViaMatching.h"
+
+#include "catch.hpp"
+
+using namespace degate;
+
+namespace
+{
+    const unsigned int image_size = 1024, cell_size = 32, via_radius = 4;
+}
+
+TEST_CASE("Template matching", "[Benchmark][Matching]")
+{
+    Project_shptr prj = create_synthetic_project(create_synthetic_image(image_size, image_size, cell_size, via_radius));
+    LogicModel_shptr lmodel = prj->get_logic_model();
+    Layer_shptr layer = lmodel->get_layer(0);
+
+    GateTemplate_shptr tmpl = create_synthetic_gate_template(cell_size);
+    lmodel->add_gate_template(tmpl);
+
+    auto run_matching = [&](TemplateMatching& matching, BoundingBox const& bbox)
+    {
+        matching.set_templates({tmpl});
+        matching.set_orientations({Gate::ORIENTATION_NORMAL});
+        matching.set_layers(layer, layer);
+        matching.init(bbox, prj);
+        matching.run();
+        return matching.get_number_of_hits();
+    };
+
+    // The first run places the gates. Later runs find the same matches, but skip
+    // inserting them, so that every measured run does the same work.
+    TemplateMatchingNormal warm_up;
+    warm_up.set_max_step_size(cell_size / 4);
+    REQUIRE(run_matching(warm_up, prj->get_bounding_box()) > 0);
+
+    BENCHMARK("TemplateMatching full run")
+    {
+        TemplateMatchingNormal matching;
+        matching.set_max_step_size(cell_size / 4);
+        return run_matching(matching, prj->get_bounding_box());
+    };
+
+    // calc_single_xcorr() is not accessible from outside, it is measured through an
+    // exhaustive scan: the step size is fixed to one pixel and hill climbing never
+    // starts, so every position of the area costs exactly one correlation.
+    BENCHMARK("calc_single_xcorr exhaustive scan 256x256")
+    {
+        TemplateMatchingNormal matching;
+        matching.set_max_step_size(1);
+        matching.set_threshold_hc(2.0);
+        return run_matching(matching, BoundingBox(0, 256 + cell_size, 0, 256 + cell_size));
+    };
+}
+
+TEST_CASE("Via matching", "[Benchmark][Matching]")
+{
+    Project_shptr prj = create_synthetic_project(create_synthetic_image(image_size, image_size, cell_size, via_radius));
+    LogicModel_shptr lmodel = prj->get_logic_model();
+
+    // Seed vias, that are used as reference image. Vias are placed between the cells.
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        const unsigned int x = cell_size / 2 + i * 2 * cell_size + cell_size + cell_size / 2;
+        lmodel->add_object(0, std::make_shared<Via>(x, cell_size, 2 * via_radius + 1, Via::DIRECTION_UP));
+    }
+
+    auto run_matching = [&]()
+    {
+        ViaMatching matching;
+        matching.set_diameter(2 * via_radius + 1);
+        matching.set_merge_n_vias(4);
+        matching.set_threshold_match(0.9);
+        matching.init(prj->get_bounding_box(), prj);
+        matching.run();
+        return std::distance(lmodel->vias_begin(), lmodel->vias_end());
+    };
+
+    // Like the template matching, the first run places the vias.
+    REQUIRE(run_matching() > 4);
+
+    BENCHMARK("ViaMatching full run")
+    {
+        return run_matching();
+    };
+}
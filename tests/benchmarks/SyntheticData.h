@@ -0,0 +1,232 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __SYNTHETICDATA_H__
+#define __SYNTHETICDATA_H__
+
+#include "Core/Image/Image.h"
+#include "Core/Image/ImageHelper.h"
+#include "Core/LogicModel/LogicModel.h"
+#include "Core/LogicModel/LogicModelHelper.h"
+#include "Core/LogicModel/Gate/Gate.h"
+#include "Core/LogicModel/Gate/GateTemplate.h"
+#include "Core/LogicModel/Gate/GateTemplatePort.h"
+#include "Core/LogicModel/Via/Via.h"
+#include "Core/LogicModel/Wire/Wire.h"
+#include "Core/Project/Project.h"
+
+#include <random>
+#include <cstdlib>
+#include <string>
+
+namespace degate
+{
+    /**
+     * Seed for all synthetic benchmark data. Only raw std::mt19937 output is used,
+     * because its sequence is defined by the standard. The distributions are not,
+     * so the data would differ between standard library implementations.
+     */
+    static const unsigned int BENCHMARK_SEED = 0x44474154;
+
+    /**
+     * Number of objects for the large logic model benchmarks (import, export).
+     * It can be changed with the environment variable DEGATE_BENCHMARK_OBJECTS.
+     */
+    inline unsigned int get_benchmark_object_count()
+    {
+        const char* count = std::getenv("DEGATE_BENCHMARK_OBJECTS");
+        if (count != nullptr && std::atoi(count) > 0) return static_cast<unsigned int>(std::atoi(count));
+
+        return 1000000;
+    }
+
+    /**
+     * Draw a filled rectangle with a given grey value.
+     */
+    template <typename ImageType>
+    void draw_box(std::shared_ptr<ImageType> img,
+                  unsigned int min_x, unsigned int max_x,
+                  unsigned int min_y, unsigned int max_y,
+                  uint8_t grey)
+    {
+        for (unsigned int y = min_y; y <= max_y && y < img->get_height(); y++)
+            for (unsigned int x = min_x; x <= max_x && x < img->get_width(); x++)
+                img->template set_pixel_as<rgba_pixel_t>(x, y, MERGE_CHANNELS(grey, grey, grey, 255));
+    }
+
+    /**
+     * Draw a filled circle with a given grey value.
+     */
+    template <typename ImageType>
+    void draw_disc(std::shared_ptr<ImageType> img,
+                   unsigned int center_x, unsigned int center_y, unsigned int radius,
+                   uint8_t grey)
+    {
+        const int r = static_cast<int>(radius);
+
+        for (int dy = -r; dy <= r; dy++)
+            for (int dx = -r; dx <= r; dx++)
+            {
+                const int x = static_cast<int>(center_x) + dx, y = static_cast<int>(center_y) + dy;
+
+                if (dx * dx + dy * dy <= r * r && x >= 0 && y >= 0 &&
+                    x < static_cast<int>(img->get_width()) && y < static_cast<int>(img->get_height()))
+                    img->template set_pixel_as<rgba_pixel_t>(x, y, MERGE_CHANNELS(grey, grey, grey, 255));
+            }
+    }
+
+    /**
+     * Fill an image with uniform noise around a dark background level.
+     */
+    template <typename ImageType>
+    void fill_noise(std::shared_ptr<ImageType> img, std::mt19937& rng)
+    {
+        for (unsigned int y = 0; y < img->get_height(); y++)
+            for (unsigned int x = 0; x < img->get_width(); x++)
+            {
+                const uint8_t grey = 40 + (rng() & 0x1f);
+                img->template set_pixel_as<rgba_pixel_t>(x, y, MERGE_CHANNELS(grey, grey, grey, 255));
+            }
+    }
+
+    /**
+     * Draw the synthetic standard cell, that is used for the template matching benchmarks.
+     * It is a frame with two inner structures, so that it is not symmetric.
+     */
+    template <typename ImageType>
+    void draw_synthetic_cell(std::shared_ptr<ImageType> img, unsigned int x, unsigned int y,
+                             unsigned int size)
+    {
+        draw_box<ImageType>(img, x, x + size - 1, y, y + 2, 200);
+        draw_box<ImageType>(img, x, x + size - 1, y + size - 3, y + size - 1, 200);
+        draw_box<ImageType>(img, x + size / 4, x + size / 4 + 2, y, y + size - 1, 160);
+        draw_box<ImageType>(img, x + size / 2, x + size - 4, y + size / 3, y + size / 3 + 4, 230);
+    }
+
+    /**
+     * Create a synthetic background image with a regular grid of cells and vias.
+     * @param cell_size The size of a cell. The cells are placed on a grid of twice this size.
+     * @param via_radius The radius of the vias, that are placed between the cells.
+     */
+    inline BackgroundImage_shptr create_synthetic_image(unsigned int width, unsigned int height,
+                                                        unsigned int cell_size = 32,
+                                                        unsigned int via_radius = 4)
+    {
+        BackgroundImage_shptr img = std::make_shared<BackgroundImage>(width, height);
+
+        std::mt19937 rng(BENCHMARK_SEED);
+        fill_noise<BackgroundImage>(img, rng);
+
+        const unsigned int pitch = 2 * cell_size;
+
+        for (unsigned int y = cell_size / 2; y + pitch <= height; y += pitch)
+            for (unsigned int x = cell_size / 2; x + pitch <= width; x += pitch)
+            {
+                draw_synthetic_cell<BackgroundImage>(img, x, y, cell_size);
+                draw_disc<BackgroundImage>(img, x + cell_size + cell_size / 2, y + cell_size / 2, via_radius, 250);
+            }
+
+        return img;
+    }
+
+    /**
+     * Create a gate template, whose image is the synthetic cell.
+     */
+    inline GateTemplate_shptr create_synthetic_gate_template(unsigned int cell_size = 32)
+    {
+        GateTemplate_shptr tmpl = std::make_shared<GateTemplate>(cell_size, cell_size);
+        tmpl->set_name("cell");
+
+        GateTemplateImage_shptr img = std::make_shared<GateTemplateImage>(cell_size, cell_size);
+        for (unsigned int y = 0; y < cell_size; y++)
+            for (unsigned int x = 0; x < cell_size; x++)
+                img->set_pixel_as<rgba_pixel_t>(x, y, MERGE_CHANNELS(48, 48, 48, 255));
+
+        draw_synthetic_cell<GateTemplateImage>(img, 0, 0, cell_size);
+        tmpl->set_image(Layer::LOGIC, img);
+
+        return tmpl;
+    }
+
+    /**
+     * Create a project with a single logic layer, that shows the image \p img.
+     */
+    inline Project_shptr create_synthetic_project(BackgroundImage_shptr img)
+    {
+        Project_shptr prj = std::make_shared<Project>(img->get_width(), img->get_height(),
+                                                      create_temp_directory(), 1);
+
+        LogicModel_shptr lmodel = prj->get_logic_model();
+        Layer_shptr layer = lmodel->get_layer(0);
+        layer->set_layer_type(Layer::LOGIC);
+        layer->set_enabled(true);
+        layer->set_image(img);
+        lmodel->set_current_layer(0);
+
+        return prj;
+    }
+
+    /**
+     * Fill a logic model with a synthetic design. The objects are placed on a grid of
+     * cells. Each cell holds a gate, a wire leaving the gate and a via at the end of
+     * the wire, that tangents the next cell's wire. About a third of all objects are gates,
+     * wires and vias each.
+     * @param objects The approximate number of objects to create.
+     * @return Returns the gate template of all gates.
+     */
+    inline GateTemplate_shptr fill_synthetic_logic_model(LogicModel_shptr lmodel, unsigned int objects)
+    {
+        GateTemplate_shptr tmpl = std::make_shared<GateTemplate>(20, 20);
+        tmpl->set_name("inv");
+        lmodel->add_gate_template(tmpl);
+
+        GateTemplatePort_shptr in = std::make_shared<GateTemplatePort>(2, 10, GateTemplatePort::PORT_TYPE_IN);
+        GateTemplatePort_shptr out = std::make_shared<GateTemplatePort>(18, 10, GateTemplatePort::PORT_TYPE_OUT);
+        in->set_object_id(lmodel->get_new_object_id());
+        out->set_object_id(lmodel->get_new_object_id());
+        lmodel->add_template_port_to_gate_template(tmpl, in);
+        lmodel->add_template_port_to_gate_template(tmpl, out);
+
+        const unsigned int cell = 40;
+        const unsigned int columns = std::max(1u, lmodel->get_width() / cell);
+        const unsigned int cells = std::max(1u, objects / 3);
+
+        std::mt19937 rng(BENCHMARK_SEED);
+
+        for (unsigned int i = 0; i < cells; i++)
+        {
+            const unsigned int x = (i % columns) * cell, y = (i / columns) * cell;
+            const unsigned int wire_y = y + 10 + (rng() % 8);
+
+            Gate_shptr gate = std::make_shared<Gate>(x, x + 20, y, y + 20, Gate::ORIENTATION_NORMAL);
+            lmodel->add_object(0, gate);
+            gate->set_gate_template(tmpl);
+            lmodel->update_ports(gate);
+
+            lmodel->add_object(0, std::make_shared<Wire>(x + 20, wire_y, x + cell, wire_y, 3));
+            lmodel->add_object(0, std::make_shared<Via>(x + cell, wire_y, 5, Via::DIRECTION_UP));
+        }
+
+        return tmpl;
+    }
+}
+
+#endif
@@ -0,0 +1,83 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/Batch/BatchJob.h"
+#include "Core/Batch/BatchJobImporter.h"
+#include "Core/Project/Project.h"
+#include "Core/Utils/FileSystem.h"
+#include "Core/Utils/DegateExceptions.h"
+
+#include "catch.hpp"
+
+#include <sstream>
+
+using namespace degate;
+
+TEST_CASE("Test batch job stages", "[BatchJob]")
+{
+    BatchJob job;
+
+    REQUIRE(BatchJob::is_valid_stage_type("via-matching"));
+    REQUIRE(BatchJob::is_valid_stage_type("save"));
+    REQUIRE_FALSE(BatchJob::is_valid_stage_type("unknown"));
+
+    REQUIRE_THROWS_AS(job.add_stage(BatchStage("unknown")), DegateRuntimeException);
+    REQUIRE(job.get_stages().empty());
+
+    BatchStage::parameter_map parameters;
+    parameters["threshold"] = "0.9";
+    REQUIRE_NOTHROW(job.add_stage(BatchStage("via-matching", parameters)));
+
+    BatchStage const& stage = job.get_stages().front();
+    REQUIRE(stage.has_parameter("threshold"));
+    REQUIRE(stage.get_parameter("threshold") == "0.9");
+    REQUIRE(stage.get_parameter("diameter", "10") == "10");
+}
+
+TEST_CASE("Test batch job run", "[BatchJob]")
+{
+    std::string dir = create_temp_directory();
+    Project_shptr prj = std::make_shared<Project>(100, 100, dir, 1);
+
+    BatchJob job;
+    job.add_stage(BatchStage("rule-check"));
+
+    BatchStage::parameter_map parameters;
+    parameters["output"] = "netlist.v";
+    job.add_stage(BatchStage("verilog-export", parameters));
+    job.add_stage(BatchStage("save"));
+
+    std::ostringstream out;
+    REQUIRE(job.run(prj, out));
+
+    std::string const& events = out.str();
+    REQUIRE(events.find("\"event\": \"job-start\"") != std::string::npos);
+    REQUIRE(events.find("\"event\": \"stage-end\"") != std::string::npos);
+    REQUIRE(events.find("\"event\": \"job-end\"") != std::string::npos);
+    REQUIRE(events.find("\"success\": true") != std::string::npos);
+
+    REQUIRE(file_exists(join_pathes(dir, "netlist.v")));
+    REQUIRE(file_exists(join_pathes(dir, "project.xml")));
+    REQUIRE(file_exists(join_pathes(dir, "lmodel.xml")));
+    REQUIRE_FALSE(file_exists(join_pathes(dir, "lmodel.xml.tmp")));
+
+    remove_directory(dir);
+}
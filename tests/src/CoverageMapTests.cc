@@ -0,0 +1,150 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/LogicModel/CoverageMap.h"
+#include "Core/Image/Image.h"
+
+#include "catch.hpp"
+
+#include <cmath>
+
+using namespace degate;
+
+TEST_CASE("Test coverage map levels", "[CoverageMap]")
+{
+    CoverageMap map(1000, 500, 8, 64);
+
+    // 1000 / 16 = 63 cells, so the first level uses 16 pixels cells.
+    REQUIRE(map.get_base_cell_size() == 16);
+    REQUIRE(map.get_level(0).width == 63);
+    REQUIRE(map.get_level(0).height == 32);
+
+    const unsigned int last = map.get_levels_count() - 1;
+    REQUIRE(map.get_level(last).width == 1);
+    REQUIRE(map.get_level(last).height == 1);
+
+    for (unsigned int i = 1; i < map.get_levels_count(); i++)
+        REQUIRE(map.get_level(i).cell_size == map.get_level(i - 1).cell_size * 2);
+
+    REQUIRE(map.get_level_index(1) == 0);
+    REQUIRE(map.get_level_index(32) == 1);
+    REQUIRE(map.get_level_index(40) == 1);
+    REQUIRE(map.get_level_index(1e9) == last);
+}
+
+TEST_CASE("Test coverage map update", "[CoverageMap]")
+{
+    CoverageMap map(256, 256, 16, 16);
+
+    const color_t color = MERGE_CHANNELS(200u, 100u, 50u, 255u);
+
+    // Covers a quarter of the cell (0, 0) of the first level.
+    map.insert(1, BoundingBox(0, 8, 0, 8), color);
+
+    auto const& cell = map.get_level(0).cells[0];
+    REQUIRE(cell.coverage == Approx(64));
+    REQUIRE(cell.count == 1);
+    REQUIRE(MASK_R(map.get_cell_color(0, 0, 0)) == 200);
+    REQUIRE(MASK_A(map.get_cell_color(0, 0, 0)) == 64);
+
+    // Every level is updated.
+    auto const& top = map.get_level(map.get_levels_count() - 1).cells[0];
+    REQUIRE(top.coverage == Approx(64));
+    REQUIRE(top.count == 1);
+
+    // Moving the object only changes the touched cells.
+    for (unsigned int i = 0; i < map.get_levels_count(); i++)
+        map.clear_dirty(i);
+
+    map.insert(1, BoundingBox(32, 48, 32, 48), color);
+
+    REQUIRE(map.get_objects_count() == 1);
+    REQUIRE(map.get_level(0).cells[0].coverage == Approx(0));
+    REQUIRE(map.get_level(0).cells[0].count == 0);
+    REQUIRE(map.get_level(0).cells[2 * 16 + 2].coverage == Approx(256));
+    REQUIRE(map.get_cell_color(0, 0, 0) == 0);
+
+    auto const& level = map.get_level(0);
+    REQUIRE(level.dirty);
+    REQUIRE(level.dirty_min_x == 0);
+    REQUIRE(level.dirty_max_x == 2);
+    REQUIRE(level.dirty_min_y == 0);
+    REQUIRE(level.dirty_max_y == 2);
+
+    map.remove(1);
+    REQUIRE(map.contains(1) == false);
+    REQUIRE(map.get_level(0).cells[2 * 16 + 2].coverage == Approx(0));
+    REQUIRE(top.coverage == Approx(0));
+}
+
+TEST_CASE("Test coverage map segments", "[CoverageMap]")
+{
+    CoverageMap map(256, 256, 16, 16);
+
+    const color_t color = MERGE_CHANNELS(200u, 100u, 50u, 255u);
+
+    auto total_coverage = [&](unsigned int index)
+    {
+        float sum = 0;
+        for (auto const& cell : map.get_level(index).cells)
+            sum += cell.coverage;
+        return sum;
+    };
+
+    // A horizontal segment covers the same cells than its box (ends extended by the radius).
+    map.insert_segment(1, 16, 40, 80, 40, 8, color);
+    REQUIRE(map.get_level(0).cells[2 * 16 + 0].coverage == Approx(4 * 8));
+    REQUIRE(map.get_level(0).cells[2 * 16 + 1].coverage == Approx(16 * 8));
+    REQUIRE(map.get_level(0).cells[2 * 16 + 5].coverage == Approx(4 * 8));
+    REQUIRE(map.get_level(0).cells[3 * 16 + 1].coverage == 0);
+    REQUIRE(total_coverage(0) == Approx(72 * 8));
+    map.remove(1);
+
+    // A diagonal segment only covers the cells along its path.
+    map.insert_segment(2, 32, 32, 224, 224, 4, color);
+
+    const float length = 192 * std::sqrt(2.0f);
+    const float area = 4 * (length + 4);
+
+    REQUIRE(total_coverage(0) == Approx(area).epsilon(0.001));
+    REQUIRE(total_coverage(map.get_levels_count() - 1) == Approx(area).epsilon(0.001));
+
+    for (unsigned int i = 2; i < 14; i++)
+    {
+        REQUIRE(map.get_level(0).cells[i * 16 + i].coverage > 0);
+        REQUIRE(map.get_level(0).cells[i * 16 + (15 - i)].coverage == 0);
+    }
+
+    REQUIRE(map.get_level(0).cells[13 * 16 + 2].coverage == 0);
+    REQUIRE(map.get_level(0).cells[2 * 16 + 13].coverage == 0);
+
+    // The same for a steep segment.
+    map.insert_segment(2, 100, 20, 120, 220, 2, color);
+    REQUIRE(total_coverage(0) == Approx(2 * (std::sqrt(20.0f * 20 + 200 * 200) + 2)).epsilon(0.001));
+    REQUIRE(map.get_level(0).cells[1 * 16 + 6].coverage > 0);
+    REQUIRE(map.get_level(0).cells[1 * 16 + 7].coverage == 0);
+    REQUIRE(map.get_level(0).cells[13 * 16 + 6].coverage == 0);
+    REQUIRE(map.get_level(0).cells[13 * 16 + 7].coverage > 0);
+
+    map.remove(2);
+    REQUIRE(total_coverage(0) == Approx(0).margin(0.01));
+    REQUIRE(map.get_level(0).cells[8 * 16 + 8].count == 0);
+}
@@ -0,0 +1,175 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+
+#include "Core/Matching/ExternalMatching.h"
+#include "Core/Project/Project.h"
+#include "Core/Utils/FileSystem.h"
+
+#include "catch.hpp"
+
+#include <cstdint>
+#include <fstream>
+
+using namespace degate;
+
+static void encode(char* data, uint32_t type, int32_t a, int32_t b, int32_t c, int32_t d, int32_t e)
+{
+    const uint32_t words[6] = {type,
+                               static_cast<uint32_t>(a), static_cast<uint32_t>(b), static_cast<uint32_t>(c),
+                               static_cast<uint32_t>(d), static_cast<uint32_t>(e)};
+
+    for (unsigned int i = 0; i < 6; i++)
+        for (unsigned int j = 0; j < 4; j++)
+            data[4 * i + j] = static_cast<char>((words[i] >> (8 * j)) & 0xff);
+}
+
+TEST_CASE("Test external matching record decoding", "[ExternalMatching]")
+{
+    char data[ExternalMatching::RECORD_SIZE];
+
+    encode(data, ExternalMatching::RECORD_WIRE, 10, 23, 100, -5, 5);
+    ExternalMatching::stream_record record = ExternalMatching::decode_record(data);
+
+    REQUIRE(record.type == ExternalMatching::RECORD_WIRE);
+    REQUIRE(record.values[0] == 10);
+    REQUIRE(record.values[3] == -5);
+
+    PlacedLogicModelObject_shptr plo = ExternalMatching::create_object(record);
+    REQUIRE(plo != nullptr);
+    REQUIRE(plo->is_of_kind(PlacedLogicModelObject::KIND_WIRE));
+
+    encode(data, ExternalMatching::RECORD_VIA, 42, 23, 5, 1, 0);
+    plo = ExternalMatching::create_object(ExternalMatching::decode_record(data));
+    REQUIRE(plo->is_of_kind(PlacedLogicModelObject::KIND_VIA));
+
+    Via_shptr via = std::dynamic_pointer_cast<Via>(plo);
+    REQUIRE(via != nullptr);
+    REQUIRE(via->get_direction() == Via::DIRECTION_UP);
+    REQUIRE(via->get_x() == 42);
+
+    encode(data, ExternalMatching::RECORD_PROGRESS, 500000, 0, 0, 0, 0);
+    REQUIRE_THROWS_AS(ExternalMatching::create_object(ExternalMatching::decode_record(data)), DegateRuntimeException);
+}
+
+TEST_CASE("Test external matching region partitioning", "[ExternalMatching]")
+{
+    BoundingBox region(10, 110, 20, 123);
+
+    std::vector<BoundingBox> partitions = ExternalMatching::partition_region(region, 4);
+    REQUIRE(partitions.size() == 4);
+
+    float min_y = region.get_min_y();
+    for (auto const& p : partitions)
+    {
+        REQUIRE(p.get_min_x() == region.get_min_x());
+        REQUIRE(p.get_max_x() == region.get_max_x());
+        REQUIRE(p.get_min_y() == min_y);
+        REQUIRE(p.get_height() >= 25);
+        REQUIRE(p.get_height() <= 26);
+        min_y = p.get_max_y();
+    }
+    REQUIRE(min_y == region.get_max_y());
+
+    // Never more stripes than rows.
+    REQUIRE(ExternalMatching::partition_region(BoundingBox(0, 10, 0, 2), 8).size() == 2);
+    REQUIRE(ExternalMatching::partition_region(region, 0).size() == 1);
+}
+
+TEST_CASE("Test external matching stream protocol", "[ExternalMatching]")
+{
+    const unsigned int size = 64;
+
+    std::string project_dir = create_temp_directory();
+    Project_shptr prj = std::make_shared<Project>(size, size, project_dir, 1);
+    LogicModel_shptr lmodel = prj->get_logic_model();
+    lmodel->set_current_layer(0);
+
+    // Each pixel holds its row number plus one.
+    std::string image_dir = create_temp_directory();
+    GreyscaleBackgroundImage_shptr img = std::make_shared<GreyscaleBackgroundImage>(size, size, image_dir, false, 4);
+    for (unsigned int y = 0; y < size; y++)
+        for (unsigned int x = 0; x < size; x++)
+            img->set_pixel(x, y, static_cast<gs_byte_pixel_t>(y + 1));
+    lmodel->get_layer(0)->set_image(img);
+
+    // The worker reads its meta data and reports:
+    // - two vias in the overlap of the stripes (both workers see them);
+    // - a record of an unknown type and a progress record;
+    // - a via built from the first and the last pixel of its mapped region.
+    std::string script = join_pathes(project_dir, "worker.sh");
+    {
+        std::ofstream file(script.c_str());
+        file << "while read key a b c d; do\n"
+                "    case \"$key\" in\n"
+                "        worker) worker=$a ;;\n"
+                "        region) rw=$c; rh=$d ;;\n"
+                "        image-file) image=$a ;;\n"
+                "        end) break ;;\n"
+                "    esac\n"
+                "done\n"
+                "first=$(od -An -tu1 -N1 \"$image\" | tr -d ' ')\n"
+                "last=$(od -An -tu1 -j$((rw * rh - 1)) -N1 \"$image\" | tr -d ' ')\n"
+                "word() { printf \"$(printf '\\\\%03o\\\\%03o\\\\%03o\\\\%03o' "
+                "$(($1 & 255)) $(($1 >> 8 & 255)) $(($1 >> 16 & 255)) $(($1 >> 24 & 255)))\"; }\n"
+                "record() { for v in \"$@\"; do word $v; done; }\n"
+                "record 2 20 30 3 1 0\n"
+                "record 2 20 36 3 1 0\n"
+                "record 99 1 2 3 4 5\n"
+                "record 3 500000 0 0 0 0\n"
+                "record 2 $last $((10 + worker * 40)) $first 2 0\n";
+    }
+
+    ExternalMatching matching;
+    matching.set_command("sh " + script);
+    matching.set_protocol(ExternalMatching::PROTOCOL_STREAM);
+    matching.set_image_transfer(ExternalMatching::IMAGE_MAPPED_REGION);
+    matching.set_worker_count(2);
+    matching.set_partition_overlap(8);
+    matching.init(BoundingBox(0, size, 0, size), prj);
+    matching.run();
+
+    REQUIRE(matching.get_exit_code() == 0);
+
+    // Stripes are [0, 32) and [32, 64], the workers see [0, 40) and [24, 64).
+    std::map<std::pair<int, int>, unsigned int> vias;
+    for (auto iter = lmodel->vias_begin(); iter != lmodel->vias_end(); ++iter)
+    {
+        Via_shptr via = iter->second;
+        REQUIRE(vias.count(std::make_pair(via->get_x(), via->get_y())) == 0);
+        vias[std::make_pair(via->get_x(), via->get_y())] = via->get_diameter();
+    }
+
+    // Objects in the overlap are kept once, from the worker whose stripe holds their center.
+    REQUIRE(vias.size() == 4);
+    REQUIRE(vias.count(std::make_pair(20, 30)) == 1);
+    REQUIRE(vias.count(std::make_pair(20, 36)) == 1);
+
+    // The mapped regions start and end at the rows of the workers.
+    REQUIRE(vias.count(std::make_pair(40, 10)) == 1);
+    REQUIRE(vias[std::make_pair(40, 10)] == 1);
+    REQUIRE(vias.count(std::make_pair(64, 50)) == 1);
+    REQUIRE(vias[std::make_pair(64, 50)] == 25);
+
+    remove_directory(image_dir);
+    remove_directory(project_dir);
+}
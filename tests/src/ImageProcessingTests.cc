@@ -62,4 +62,5 @@ TEST_CASE("Test pipe", "[ImageProcessingTests]")
     REQUIRE(pipe.size() == 2);
 
     REQUIRE_NOTHROW(pipe.run(in));
+    REQUIRE(pipe.get_progress() == Approx(1.0));
 }
\ No newline at end of file
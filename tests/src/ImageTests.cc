@@ -23,9 +23,17 @@
 #include "Core/Image/TileImage.h"
 #include "Core/Image/TIFFWriter.h"
 #include "Core/Image/ImageReader.h"
+#include "Core/Image/ImageAccumulator.h"
+#include "Core/Image/ImageStatistics.h"
+#include "Core/Image/Manipulation/MorphologicalFilter.h"
+#include "Core/LogicModel/LogicModelHelper.h"
+
+#include <QImage>
 
 #include "catch.hpp"
 
+#include <fstream>
+
 using namespace degate;
 
 TEST_CASE("Test rgba in memory", "[ImageTests]")
@@ -151,4 +159,347 @@ TEST_CASE("Test pixel conversion", "[ImageTests]")
 
     rgba_pixel_t rd = convert_pixel<rgba_pixel_t, gs_double_pixel_t>(4.0);
     REQUIRE((unsigned)MERGE_CHANNELS(4, 4, 4, 255) == rd);
-}
\ No newline at end of file
+}
+
+TEST_CASE("Test image accumulator", "[ImageTests]")
+{
+    // Nine uniform images with value 100 and one outlier with value 250.
+    GateTemplateImageAccumulator mean(8, 8);
+    GateTemplateImageAccumulator median(8, 8, GateTemplateImageAccumulator::MERGE_MEDIAN);
+    GateTemplateImageAccumulator trimmed(8, 8, GateTemplateImageAccumulator::MERGE_TRIMMED_MEAN, 0.2);
+
+    for (unsigned int i = 0; i < 10; i++)
+    {
+        GateTemplateImage_shptr img = std::make_shared<GateTemplateImage>(8, 8);
+        unsigned int v = i == 0 ? 250 : 100;
+        for (unsigned int y = 0; y < 8; y++)
+            for (unsigned int x = 0; x < 8; x++)
+                img->set_pixel(x, y, MERGE_CHANNELS(v, v, v, 255));
+
+        mean.add(img);
+        median.add(img);
+        trimmed.add(img);
+    }
+
+    REQUIRE(mean.get_count() == 10);
+    REQUIRE(MASK_R(mean.get_image()->get_pixel(3, 3)) == 115);
+    REQUIRE(MASK_A(mean.get_image()->get_pixel(3, 3)) == 255);
+
+    // Robust results are only exact up to the bin width.
+    REQUIRE(std::abs((int)MASK_G(median.get_image()->get_pixel(3, 3)) - 100) <= 4);
+    REQUIRE(std::abs((int)MASK_B(trimmed.get_image()->get_pixel(3, 3)) - 100) <= 4);
+
+    REQUIRE_THROWS(mean.add(std::make_shared<GateTemplateImage>(4, 8)));
+    REQUIRE(GateTemplateImageAccumulator(8, 8).get_image() == nullptr);
+}
+
+TEST_CASE("Test image shift estimation", "[ImageTests]")
+{
+    GateTemplateImage_shptr reference = std::make_shared<GateTemplateImage>(32, 32);
+    GateTemplateImage_shptr shifted = std::make_shared<GateTemplateImage>(32, 32);
+
+    // A smooth blob, and the same blob moved by (1.5, -1).
+    for (unsigned int y = 0; y < 32; y++)
+        for (unsigned int x = 0; x < 32; x++)
+        {
+            double d0 = std::pow(x - 16.0, 2) + std::pow(y - 16.0, 2);
+            double d1 = std::pow(x - 17.5, 2) + std::pow(y - 15.0, 2);
+            auto v0 = static_cast<unsigned int>(255 * std::exp(-d0 / 40));
+            auto v1 = static_cast<unsigned int>(255 * std::exp(-d1 / 40));
+            reference->set_pixel(x, y, MERGE_CHANNELS(v0, v0, v0, 255));
+            shifted->set_pixel(x, y, MERGE_CHANNELS(v1, v1, v1, 255));
+        }
+
+    double dx, dy;
+    estimate_image_shift<GateTemplateImage>(reference, shifted, 3, dx, dy);
+
+    REQUIRE(std::abs(dx - 1.5) < 0.25);
+    REQUIRE(std::abs(dy + 1.0) < 0.25);
+
+    // Aligned accumulation moves the blob back onto the reference.
+    GateTemplateImageAccumulator aligned(32, 32);
+    aligned.add(shifted, dx, dy);
+    REQUIRE(std::abs((int)MASK_R(aligned.get_image()->get_pixel(16, 16)) - (int)MASK_R(reference->get_pixel(16, 16))) <= 8);
+}
+
+TEST_CASE("Test image statistics", "[ImageTests]")
+{
+    // Several tiles of 64x64 pixels, the last ones partially used.
+    auto img = std::make_shared<TileImage_GS_DOUBLE>(150, 100, 6);
+    auto mem_img = std::make_shared<MemoryImage_GS_DOUBLE>(150, 100);
+
+    double sum = 0, sum_sq = 0;
+    for (unsigned int y = 0; y < 100; y++)
+        for (unsigned int x = 0; x < 150; x++)
+        {
+            double v = 1e6 + (x * 7 + y * 13) % 50;
+            img->set_pixel(x, y, v);
+            mem_img->set_pixel(x, y, v);
+            sum += v;
+        }
+
+    double mean = sum / (150 * 100);
+    for (unsigned int y = 0; y < 100; y++)
+        for (unsigned int x = 0; x < 150; x++)
+            sum_sq += (img->get_pixel(x, y) - mean) * (img->get_pixel(x, y) - mean);
+
+    RegionStatistics stats = calculate_statistics<TileImage_GS_DOUBLE>(img);
+    REQUIRE(stats.get_count() == 150 * 100);
+    REQUIRE(std::abs(stats.get_mean() - mean) < 1e-6);
+    REQUIRE(std::abs(stats.get_variance() - sum_sq / (150 * 100)) < 1e-6);
+    REQUIRE(stats.get_minimum() == 1e6);
+    REQUIRE(stats.get_maximum() == 1e6 + 49);
+
+    RegionStatistics mem_stats = calculate_statistics<MemoryImage_GS_DOUBLE>(mem_img);
+    REQUIRE(std::abs(mem_stats.get_mean() - mean) < 1e-6);
+
+    // A region and the matching bounding box.
+    double region_sum = 0;
+    for (unsigned int y = 10; y < 90; y++)
+        for (unsigned int x = 30; x < 140; x++)
+            region_sum += img->get_pixel(x, y);
+
+    RegionStatistics region = calculate_statistics<TileImage_GS_DOUBLE>(img, 30, 10, 110, 80);
+    REQUIRE(region.get_count() == 110 * 80);
+    REQUIRE(std::abs(region.get_mean() - region_sum / (110 * 80)) < 1e-6);
+
+    RegionStatistics bb_region = calculate_statistics<TileImage_GS_DOUBLE>(img, BoundingBox(30, 140, 10, 90));
+    REQUIRE(bb_region.get_count() == region.get_count());
+
+    // Cached blocks are reused until they are invalidated.
+    ImageStatisticsCache<TileImage_GS_DOUBLE> cache(img);
+    REQUIRE(std::abs(cache.get_statistics().get_mean() - mean) < 1e-6);
+
+    RegionStatistics block;
+    REQUIRE(cache.lookup(0, 0, block));
+    REQUIRE(block.get_count() == 64 * 64);
+    REQUIRE(cache.lookup(2, 1, block)); // clipped at the image border
+
+    cache.invalidate(BoundingBox(0, 10, 0, 10));
+    REQUIRE(cache.lookup(0, 0, block) == false);
+    REQUIRE(cache.lookup(1, 0, block));
+
+    REQUIRE_THROWS(calculate_statistics<TileImage_GS_DOUBLE>(img, 150, 0, 10, 10));
+
+    // Big regions are processed in parallel, small ones serially. Both give the same result.
+    auto big_img = std::make_shared<TileImage_GS_DOUBLE>(300, 200, 6);
+    for (unsigned int y = 0; y < 200; y++)
+        for (unsigned int x = 0; x < 300; x++)
+            big_img->set_pixel(x, y, (x * 7 + y * 13) % 50);
+
+    REQUIRE(300 * 200 >= STATISTICS_MIN_PARALLEL_PIXELS);
+    RegionStatistics parallel = calculate_statistics<TileImage_GS_DOUBLE>(big_img);
+
+    RegionStatistics serial;
+    for (unsigned int y = 0; y < 200; y += 50)
+        serial.merge(calculate_statistics<TileImage_GS_DOUBLE>(big_img, 0, y, 300, 50));
+
+    REQUIRE(parallel.get_count() == serial.get_count());
+    REQUIRE(std::abs(parallel.get_mean() - serial.get_mean()) < 1e-9);
+    REQUIRE(std::abs(parallel.get_variance() - serial.get_variance()) < 1e-9);
+    REQUIRE(parallel.get_histogram() == serial.get_histogram());
+}
+
+TEST_CASE("Test morphological filters", "[ImageTests]")
+{
+    // Several tiles of 64x64 pixels with a random binary pattern.
+    auto img = std::make_shared<TileImage_GS_DOUBLE>(150, 100, 6);
+    auto mem_img = std::make_shared<MemoryImage_GS_DOUBLE>(150, 100);
+
+    unsigned int seed = 42;
+    for (unsigned int y = 0; y < 100; y++)
+        for (unsigned int x = 0; x < 150; x++)
+        {
+            seed = seed * 1103515245 + 12345;
+            double v = ((seed >> 16) % 3) == 0 ? 0 : (seed >> 16) % 7;
+            img->set_pixel(x, y, v);
+            mem_img->set_pixel(x, y, v);
+        }
+
+    // The count filters calculate the same as the generic filter.
+    for (unsigned int kernel_width : {3, 4, 5})
+    {
+        auto expected = std::make_shared<MemoryImage_GS_DOUBLE>(150, 100);
+        auto result = std::make_shared<TileImage_GS_DOUBLE>(150, 100, 6);
+
+        filter_image<MemoryImage_GS_DOUBLE, MemoryImage_GS_DOUBLE,
+                     ErodeImagePolicy<MemoryImage_GS_DOUBLE, double>>(expected, mem_img, kernel_width, 8);
+        erode_image<TileImage_GS_DOUBLE, TileImage_GS_DOUBLE>(result, img, kernel_width, 8);
+
+        for (unsigned int y = 0; y < 100; y++)
+            for (unsigned int x = 0; x < 150; x++)
+                REQUIRE(result->get_pixel(x, y) == expected->get_pixel(x, y));
+
+        filter_image<MemoryImage_GS_DOUBLE, MemoryImage_GS_DOUBLE,
+                     DilateImagePolicy<MemoryImage_GS_DOUBLE, double>>(expected, mem_img, kernel_width, 12);
+        dilate_image<TileImage_GS_DOUBLE, TileImage_GS_DOUBLE>(result, img, kernel_width, 12);
+
+        for (unsigned int y = 0; y < 100; y++)
+            for (unsigned int x = 0; x < 150; x++)
+                REQUIRE(result->get_pixel(x, y) == expected->get_pixel(x, y));
+    }
+
+    REQUIRE_THROWS(erode_image<TileImage_GS_DOUBLE, TileImage_GS_DOUBLE>(img, img));
+
+    // Rectangular erosion and dilation against the minimum and maximum of the clipped element.
+    auto eroded = std::make_shared<TileImage_GS_DOUBLE>(150, 100, 6);
+    auto dilated = std::make_shared<MemoryImage_GS_DOUBLE>(150, 100);
+    erode_image_rect<TileImage_GS_DOUBLE, TileImage_GS_DOUBLE>(eroded, img, 5, 2);
+    dilate_image_rect<MemoryImage_GS_DOUBLE, TileImage_GS_DOUBLE>(dilated, img, 5, 2);
+
+    for (unsigned int y = 0; y < 100; y++)
+        for (unsigned int x = 0; x < 150; x++)
+        {
+            double min = 1000, max = -1000;
+            for (unsigned int _y = y > 1 ? y - 1 : 0; _y < std::min(y + 1, 100u); _y++)
+                for (unsigned int _x = x > 2 ? x - 2 : 0; _x < std::min(x + 3, 150u); _x++)
+                {
+                    min = std::min(min, img->get_pixel(_x, _y));
+                    max = std::max(max, img->get_pixel(_x, _y));
+                }
+
+            REQUIRE(eroded->get_pixel(x, y) == min);
+            REQUIRE(dilated->get_pixel(x, y) == max);
+        }
+
+    // Thinning against the sequential Zhang-Suen algorithm.
+    std::vector<unsigned char> binary(150 * 100);
+    for (unsigned int y = 0; y < 100; y++)
+        for (unsigned int x = 0; x < 150; x++)
+            binary[y * 150 + x] = img->get_pixel(x, y) > 0 ? 1 : 0;
+
+    for (bool changed = true; changed;)
+    {
+        changed = false;
+        for (bool condition_switch : {true, false})
+        {
+            std::vector<unsigned int> deletions;
+            for (unsigned int y = 1; y < 99; y++)
+                for (unsigned int x = 1; x < 149; x++)
+                    if (binary[y * 150 + x] && zhang_suen_deletable(binary.data(), 150, x, y, condition_switch))
+                        deletions.push_back(y * 150 + x);
+
+            for (unsigned int i : deletions) binary[i] = 0;
+            changed = changed || !deletions.empty();
+        }
+    }
+
+    thinning<TileImage_GS_DOUBLE>(img);
+
+    for (unsigned int y = 0; y < 100; y++)
+        for (unsigned int x = 0; x < 150; x++)
+            REQUIRE((img->get_pixel(x, y) > 0) == (binary[y * 150 + x] == 1));
+}
+
+TEST_CASE("Test tile container", "[ImageTests]")
+{
+    std::string dir = create_temp_directory();
+
+    // A new image stores all tiles in a single container file.
+    {
+        TileImage_RGBA img(100, 70, dir, true, 5);
+        REQUIRE(file_exists(join_pathes(dir, TILE_CONTAINER_FILENAME)));
+
+        for (unsigned int y = 0; y < 70; y++)
+            for (unsigned int x = 0; x < 100; x++)
+                img.set_pixel(x, y, x * 1000 + y);
+
+        auto tile = img.fetch_tile(64, 32);
+        REQUIRE(tile->get(0, 0) == 64 * 1000 + 32);
+    }
+
+    REQUIRE(TileContainer::has_tile_files(dir) == false);
+
+    // Reopen it.
+    {
+        TileImage_RGBA img(100, 70, dir, true, 5);
+        img.set_access_pattern(TileContainer::ACCESS_SEQUENTIAL);
+
+        for (unsigned int y = 0; y < 70; y++)
+            for (unsigned int x = 0; x < 100; x++)
+                REQUIRE(img.get_pixel(x, y) == x * 1000 + y);
+    }
+
+    // A container with another layout is rejected.
+    REQUIRE_THROWS_AS(TileImage_RGBA(200, 70, dir, true, 5), DegateRuntimeException);
+
+    // A crash before the header was written leaves a container without magic. It is initialized again.
+    {
+        std::fstream file(join_pathes(dir, TILE_CONTAINER_FILENAME).c_str(),
+                          std::ios::in | std::ios::out | std::ios::binary);
+        file.write("\0\0\0\0", 4);
+    }
+
+    {
+        TileImage_RGBA img(100, 70, dir, true, 5);
+        img.set_pixel(10, 20, 42);
+        REQUIRE(img.get_pixel(10, 20) == 42);
+    }
+
+    // So is an empty container file, that was never resized.
+    remove_file(join_pathes(dir, TILE_CONTAINER_FILENAME));
+    std::ofstream(join_pathes(dir, TILE_CONTAINER_FILENAME).c_str()).close();
+
+    {
+        TileImage_RGBA img(100, 70, dir, true, 5);
+        img.set_pixel(10, 20, 42);
+        REQUIRE(img.get_pixel(10, 20) == 42);
+    }
+
+    remove_directory(dir);
+
+    // Images with one file per tile are still supported.
+    std::string legacy_dir = create_temp_directory();
+    {
+        MemoryMap<rgba_pixel_t> tile(32, 32, MAP_STORAGE_TYPE_PERSISTENT_FILE, join_pathes(legacy_dir, "1_0.dat"));
+        tile.set(3, 4, 42);
+    }
+
+    {
+        TileImage_RGBA img(64, 32, legacy_dir, true, 5);
+        REQUIRE(file_exists(join_pathes(legacy_dir, TILE_CONTAINER_FILENAME)) == false);
+        REQUIRE(img.get_pixel(32 + 3, 4) == 42);
+    }
+
+    remove_directory(legacy_dir);
+}
+
+TEST_CASE("Test background image import", "[ImageTests]")
+{
+    std::string project_dir = create_temp_directory();
+    std::string image_file = join_pathes(project_dir, "import.png");
+
+    // Wider than a tile, so the image is imported in several tiles and has a prescaled image.
+    const unsigned int width = 1100, height = 300;
+
+    QImage image(width, height, QImage::Format_ARGB32);
+    for (unsigned int y = 0; y < height; y++)
+        for (unsigned int x = 0; x < width; x++)
+            image.setPixel(x, y, qRgba(x & 0xff, y & 0xff, (x + y) & 0xff, 255));
+
+    REQUIRE(image.save(QString::fromStdString(image_file)));
+
+    Layer_shptr layer = std::make_shared<Layer>(BoundingBox(width, height));
+    load_new_background_image(layer, project_dir, image_file);
+
+    BackgroundImage_shptr bg_image = layer->get_image();
+    REQUIRE(bg_image != nullptr);
+
+    // The tiles are written into the tile container of the image, not into tile files.
+    REQUIRE(file_exists(join_pathes(bg_image->get_directory(), TILE_CONTAINER_FILENAME)));
+    REQUIRE(TileContainer::has_tile_files(bg_image->get_directory()) == false);
+
+    for (unsigned int y = 0; y < height; y += 7)
+        for (unsigned int x = 0; x < width; x += 7)
+            REQUIRE(bg_image->get_pixel(x, y) == MERGE_CHANNELS(x & 0xff, y & 0xff, (x + y) & 0xff, 255));
+
+    // The prescaled image is built from the imported master image.
+    REQUIRE(layer->get_zoom_steps().size() == 2);
+    BackgroundImage_shptr scaled = layer->get_scaling_manager()->get_image(2).second;
+    REQUIRE(TileContainer::has_tile_files(scaled->get_directory()) == false);
+    REQUIRE(MASK_G(scaled->get_pixel(10, 10)) >= 20);
+    REQUIRE(MASK_G(scaled->get_pixel(10, 10)) <= 21);
+
+    layer->unset_image();
+    remove_directory(project_dir);
+}
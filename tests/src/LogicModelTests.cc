@@ -20,7 +20,11 @@
  */
 
 #include "Core/LogicModel/Wire/Wire.h"
+#include "Core/LogicModel/Via/Via.h"
+#include "Core/LogicModel/Annotation/Annotation.h"
 #include "Core/LogicModel/LogicModel.h"
+#include "Core/LogicModel/LogicModelHelper.h"
+#include "Core/Matching/PreparedTemplateCache.h"
 
 #include "catch.hpp"
 
@@ -125,4 +129,293 @@ TEST_CASE("Test add and retrieve wire", "[LogicModel]")
     }
 
     REQUIRE(i > 0);
-}
\ No newline at end of file
+}
+
+TEST_CASE("Test object kinds", "[LogicModel]")
+{
+    LogicModel_shptr lmodel(new LogicModel(100, 100));
+
+    Gate_shptr gate(new Gate(0, 10, 0, 10));
+    Via_shptr via(new Via(50, 50, 5));
+    Wire_shptr wire(new Wire(20, 21, 30, 31, 5));
+    Annotation_shptr annotation(new Annotation(60, 70, 60, 70));
+
+    REQUIRE(gate->get_object_kind() == PlacedLogicModelObject::KIND_GATE);
+    REQUIRE(via->get_object_kind() == PlacedLogicModelObject::KIND_VIA);
+    REQUIRE(wire->get_object_kind() == PlacedLogicModelObject::KIND_WIRE);
+    REQUIRE(annotation->get_object_kind() == PlacedLogicModelObject::KIND_ANNOTATION);
+
+    // Clones keep their kind.
+    REQUIRE(std::dynamic_pointer_cast<Via>(via->clone_shallow())->is_of_kind(PlacedLogicModelObject::KIND_VIA));
+
+    PlacedLogicModelObject_shptr plo = via;
+    REQUIRE(object_kind_cast<Via>(plo) == via);
+    REQUIRE(object_kind_cast<Gate>(plo) == nullptr);
+    REQUIRE(object_kind_cast<ConnectedLogicModelObject>(plo) != nullptr);
+    REQUIRE(object_kind_cast<ConnectedLogicModelObject>(PlacedLogicModelObject_shptr(gate)) == nullptr);
+
+    lmodel->add_object(0, gate);
+    lmodel->add_object(0, via);
+    lmodel->add_object(0, wire);
+    lmodel->add_object(0, annotation);
+
+    Layer_shptr layer = lmodel->get_layer(0);
+
+    REQUIRE(layer->get_object_count(PlacedLogicModelObject::KIND_VIA) == 1);
+    REQUIRE(layer->get_object_count(PlacedLogicModelObject::KIND_GATE_PORT) == 0);
+
+    // Per-kind region queries skip other kinds.
+    REQUIRE(layer->exists_type_in_region<Via>(40, 60, 40, 60));
+    REQUIRE_FALSE(layer->exists_type_in_region<Gate>(40, 60, 40, 60));
+    REQUIRE(layer->exists_type_in_region<Gate>(0, 5, 0, 5));
+
+    unsigned int count = 0;
+    for (Layer::qt_region_iterator iter = layer->region_begin(PlacedLogicModelObject::KIND_WIRE, 0, 100, 0, 100);
+         iter != layer->region_end(); ++iter, count++)
+    {
+        REQUIRE(*iter == wire);
+    }
+    REQUIRE(count == 1);
+
+    // Picking prefers vias over annotations and gates.
+    REQUIRE(layer->get_object_at_position(50, 50) == via);
+    REQUIRE(layer->get_object_at_position(5, 5) == gate);
+    REQUIRE(layer->get_object_at_position(5, 5, 0, false, true) == nullptr);
+
+    // Moving an object updates the per-kind index.
+    via->set_x(80);
+    REQUIRE_FALSE(layer->exists_type_in_region<Via>(40, 60, 40, 60));
+    REQUIRE(layer->exists_type_in_region<Via>(75, 85, 45, 55));
+
+    lmodel->remove_object(via);
+    REQUIRE(layer->get_object_count(PlacedLogicModelObject::KIND_VIA) == 0);
+}
+
+TEST_CASE("Test connect objects", "[LogicModel]")
+{
+    LogicModel_shptr lmodel(new LogicModel(100, 100));
+
+    std::vector<ConnectedLogicModelObject_shptr> wires;
+    for (int i = 0; i < 5; i++)
+    {
+        Wire_shptr w(new Wire(20, 21, 30, 31, 5));
+        lmodel->add_object(0, w);
+        wires.push_back(w);
+    }
+
+    // a new net is only created for unconnected objects
+    connect_objects(lmodel, wires[0], wires[1]);
+    Net_shptr big_net = wires[0]->get_net();
+    REQUIRE(big_net != nullptr);
+    REQUIRE(wires[1]->get_net() == big_net);
+
+    connect_objects(lmodel, wires[2], wires[0]);
+    REQUIRE(wires[2]->get_net() == big_net);
+    REQUIRE(big_net->size() == 3);
+
+    connect_objects(lmodel, wires[3], wires[4]);
+    Net_shptr small_net = wires[3]->get_net();
+    REQUIRE(small_net != big_net);
+    REQUIRE(std::distance(lmodel->nets_begin(), lmodel->nets_end()) == 2);
+
+    // the larger net survives the union
+    connect_objects(lmodel, wires[4], wires[1]);
+    for (auto& w : wires) REQUIRE(w->get_net() == big_net);
+    REQUIRE(big_net->size() == 5);
+    REQUIRE(small_net->size() == 0);
+    REQUIRE(std::distance(lmodel->nets_begin(), lmodel->nets_end()) == 1);
+    REQUIRE(lmodel->get_net(big_net->get_object_id()) == big_net);
+
+    // isolating an object keeps the rest of the net
+    std::list<ConnectedLogicModelObject_shptr> isolated = { wires[2] };
+    isolate_objects(lmodel, isolated.begin(), isolated.end());
+    REQUIRE(wires[2]->get_net() == nullptr);
+    REQUIRE(big_net->size() == 4);
+}
+
+TEST_CASE("Test module ports", "[LogicModel]")
+{
+    LogicModel_shptr lmodel(new LogicModel(100, 100));
+
+    GateTemplate_shptr tmpl(new GateTemplate(10, 10));
+    tmpl->set_name("inv");
+    lmodel->add_gate_template(tmpl);
+
+    // g1 is in the main module, g2 and g3 in the sub-module m
+    Module_shptr main_module = lmodel->get_main_module();
+    Module_shptr m(new Module("m"));
+    main_module->add_module(m);
+
+    std::vector<Gate_shptr> gates;
+    for (int i = 0; i < 3; i++)
+    {
+        Gate_shptr gate(new Gate(0, 10, 0, 10, Gate::ORIENTATION_NORMAL));
+        lmodel->add_object(0, gate);
+        gate->set_gate_template(tmpl);
+        gates.push_back(gate);
+
+        if (i > 0)
+        {
+            main_module->remove_gate(gate);
+            m->add_gate(gate, false);
+        }
+    }
+
+    // Ports are created after the gates were placed in modules
+    GateTemplatePort_shptr in(new GateTemplatePort(2, 5, GateTemplatePort::PORT_TYPE_IN));
+    GateTemplatePort_shptr out(new GateTemplatePort(8, 5, GateTemplatePort::PORT_TYPE_OUT));
+    in->set_object_id(lmodel->get_new_object_id());
+    out->set_object_id(lmodel->get_new_object_id());
+    lmodel->add_template_port_to_gate_template(tmpl, in);
+    lmodel->add_template_port_to_gate_template(tmpl, out);
+
+    auto get_port = [](Gate_shptr const& gate, GateTemplatePort_shptr const& tmpl_port)
+    {
+        for (auto iter = gate->ports_begin(); iter != gate->ports_end(); ++iter)
+        {
+            if ((*iter)->get_template_port() == tmpl_port)
+                return *iter;
+        }
+        return GatePort_shptr();
+    };
+
+    auto has_port = [](Module_shptr const& module, GatePort_shptr const& gate_port)
+    {
+        return module->lookup_module_port_name(gate_port) != boost::none;
+    };
+
+    auto connect = [&](GatePort_shptr const& a, GatePort_shptr const& b)
+    {
+        connect_objects(lmodel, ConnectedLogicModelObject_shptr(a), ConnectedLogicModelObject_shptr(b));
+    };
+
+    // g1 -> g2 -> g3 -> g1
+    connect(get_port(gates[0], out), get_port(gates[1], in));
+    connect(get_port(gates[1], out), get_port(gates[2], in));
+    connect(get_port(gates[2], out), get_port(gates[0], in));
+
+    m->determine_module_ports();
+    REQUIRE(std::distance(m->ports_begin(), m->ports_end()) == 2);
+    REQUIRE(has_port(m, get_port(gates[1], in)));
+    REQUIRE(has_port(m, get_port(gates[2], out)));
+
+    // all nets are internal once g1 is in m
+    main_module->remove_gate(gates[0]);
+    m->add_gate(gates[0]);
+    REQUIRE(std::distance(m->ports_begin(), m->ports_end()) == 0);
+
+    // removing g3 opens the loop again
+    m->remove_gate(gates[2]);
+    main_module->add_gate(gates[2]);
+    REQUIRE(std::distance(m->ports_begin(), m->ports_end()) == 2);
+    REQUIRE(has_port(m, get_port(gates[1], out)));
+    REQUIRE(has_port(m, get_port(gates[0], in)));
+}
+
+TEST_CASE("Test prepared template cache", "[LogicModel]")
+{
+    auto tmpl = std::make_shared<GateTemplate>(4, 4);
+
+    auto img = std::make_shared<GateTemplateImage>(4, 4);
+    for (unsigned int y = 0; y < 4; y++)
+        for (unsigned int x = 0; x < 4; x++)
+            img->set_pixel(x, y, MERGE_CHANNELS(x * 10, y * 10, 0, 255));
+
+    tmpl->set_image(Layer::LOGIC, img);
+    PreparedTemplateCache::image_version_t version = tmpl->get_image_version(Layer::LOGIC);
+
+    auto prep = std::make_shared<PreparedTemplate>();
+    prep->tmpl_img_normal = std::make_shared<TempImage_GS_BYTE>(4, 4);
+    prep->tmpl_img_scaled = std::make_shared<TempImage_GS_BYTE>(2, 2);
+    prep->zero_mean_template_normal = std::make_shared<TempImage_GS_DOUBLE>(4, 4);
+    prep->zero_mean_template_scaled = std::make_shared<TempImage_GS_DOUBLE>(2, 2);
+    prep->zero_mean_template_scaled->set_pixel(1, 1, -2.5);
+    prep->sum_over_zero_mean_template_normal = 42;
+
+    PreparedTemplateCache_shptr cache = tmpl->get_prepared_templates();
+    cache->insert(version, Gate::ORIENTATION_NORMAL, 2, prep);
+
+    REQUIRE(cache->get(version, Gate::ORIENTATION_NORMAL, 2) == prep);
+    REQUIRE(cache->get(version, Gate::ORIENTATION_FLIPPED_BOTH, 2) == nullptr);
+    REQUIRE(cache->get(version, Gate::ORIENTATION_NORMAL, 4) == nullptr);
+    REQUIRE(cache->is_modified());
+
+    // Persist and reload.
+    std::string dir = create_temp_directory();
+    std::string file = join_pathes(dir, "prepared.dat");
+    cache->save(file);
+    REQUIRE_FALSE(cache->is_modified());
+
+    PreparedTemplateCache loaded;
+    REQUIRE(loaded.load(file));
+    REQUIRE(loaded.size() == 1);
+    PreparedTemplate_shptr loaded_prep = loaded.get(version, Gate::ORIENTATION_NORMAL, 2);
+    REQUIRE(loaded_prep != nullptr);
+    REQUIRE(loaded_prep->sum_over_zero_mean_template_normal == 42);
+    REQUIRE(loaded_prep->tmpl_img_scaled->get_width() == 2);
+    REQUIRE(loaded_prep->zero_mean_template_scaled->get_pixel(1, 1) == -2.5);
+
+    REQUIRE(loaded.load(join_pathes(dir, "missing.dat")) == false);
+    remove_directory(dir);
+
+    // Setting the same content keeps the version, another image drops the entry.
+    auto same = std::make_shared<GateTemplateImage>(4, 4);
+    copy_image(same, img);
+    tmpl->set_image(Layer::LOGIC, same);
+    REQUIRE(tmpl->get_image_version(Layer::LOGIC) == version);
+    REQUIRE(cache->size() == 1);
+    REQUIRE_FALSE(cache->is_modified());
+
+    same->set_pixel(0, 0, MERGE_CHANNELS(255, 255, 255, 255));
+    tmpl->set_image(Layer::LOGIC, same);
+    REQUIRE(tmpl->get_image_version(Layer::LOGIC) != version);
+    REQUIRE(cache->size() == 0);
+    REQUIRE(cache->is_modified());
+}
+
+TEST_CASE("Test merge gate images errors", "[LogicModel]")
+{
+    LogicModel_shptr lmodel(new LogicModel(100, 100));
+    Layer_shptr layer = std::make_shared<Layer>(BoundingBox(100, 100));
+
+    std::string dir = create_temp_directory();
+    layer->set_image(std::make_shared<BackgroundImage>(100, 100, join_pathes(dir, "layer.dimg")));
+
+    auto tmpl = std::make_shared<GateTemplate>(10, 10);
+    lmodel->add_gate_template(tmpl);
+
+    // The instances of a template must have the same size.
+    std::list<Gate_shptr> gates;
+    gates.push_back(std::make_shared<Gate>(0, 9, 0, 9, Gate::ORIENTATION_NORMAL));
+    gates.push_back(std::make_shared<Gate>(20, 31, 20, 31, Gate::ORIENTATION_NORMAL));
+
+    // Errors of the workers are rethrown in the calling thread.
+    REQUIRE_THROWS_AS(merge_gate_images(lmodel, layer, tmpl, gates), DegateRuntimeException);
+    REQUIRE_THROWS_AS(merge_gate_images(lmodel, layer, tmpl, gates, GateTemplateImageAccumulator::MERGE_MEAN, 2),
+                      DegateRuntimeException);
+
+    layer->unset_image();
+    remove_directory(dir);
+}
+
+TEST_CASE("Test gate template journaling", "[LogicModel]")
+{
+    LogicModel_shptr lmodel(new LogicModel(100, 100));
+
+    auto tmpl = std::make_shared<GateTemplate>(10, 10);
+    lmodel->add_gate_template(tmpl);
+    REQUIRE(lmodel->get_journal()->get_gate_templates().count(tmpl->get_object_id()) == 1);
+
+    auto other = std::make_shared<GateTemplate>(10, 10);
+    lmodel->add_gate_template(other);
+    lmodel->get_journal()->clear();
+
+    // Editing a template is followed by a port update, that journals only this template.
+    auto port = std::make_shared<GateTemplatePort>(2, 2, GateTemplatePort::PORT_TYPE_IN);
+    port->set_object_id(lmodel->get_new_object_id());
+    tmpl->add_template_port(port);
+    lmodel->update_ports(tmpl);
+
+    REQUIRE(lmodel->get_journal()->get_gate_templates().size() == 1);
+    REQUIRE(lmodel->get_journal()->get_gate_templates().count(tmpl->get_object_id()) == 1);
+}
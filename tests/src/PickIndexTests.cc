@@ -0,0 +1,171 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/LogicModel/PickIndex.h"
+#include "Core/LogicModel/Gate/Gate.h"
+#include "Core/LogicModel/Via/Via.h"
+#include "Core/LogicModel/Wire/Wire.h"
+#include "Core/LogicModel/Annotation/Annotation.h"
+
+#include "catch.hpp"
+
+#include <cstdlib>
+
+using namespace degate;
+
+TEST_CASE("Test pick index priorities", "[PickIndex]")
+{
+    PickIndex index(16);
+
+    Annotation_shptr annotation(new Annotation(200, 1000, 200, 1000));
+    annotation->set_object_id(1);
+    Gate_shptr gate(new Gate(10, 50, 10, 50));
+    gate->set_object_id(2);
+    Via_shptr via(new Via(30, 30, 6));
+    via->set_object_id(3);
+    Wire_shptr wire(new Wire(0, 30, 100, 30, 4));
+    wire->set_object_id(4);
+
+    index.insert(annotation);
+    index.insert(gate);
+    index.insert(via);
+    index.insert(wire);
+
+    REQUIRE(index.get_objects_count() == 4);
+    REQUIRE(index.get_levels_count() > 1);
+
+    // The via beats the gate, the wire and the annotation.
+    REQUIRE(index.pick(30, 30) == via);
+    REQUIRE(index.pick(45, 45) == gate);
+    REQUIRE(index.pick(70, 30) == wire);
+    REQUIRE(index.pick(500, 500) == annotation);
+    REQUIRE(index.pick(2000, 2000) == nullptr);
+
+    PickIndex::kind_mask ignored;
+    ignored[PlacedLogicModelObject::KIND_VIA] = true;
+    REQUIRE(index.pick(30, 30, 0, ignored) == gate);
+
+    ignored[PlacedLogicModelObject::KIND_GATE] = true;
+    ignored[PlacedLogicModelObject::KIND_ANNOTATION] = true;
+    REQUIRE(index.pick(30, 30, 0, ignored) == wire);
+
+    // The distance allows to pick objects next to the position.
+    REQUIRE(index.pick(30, 40) == gate);
+    REQUIRE(index.pick(30, 40, 8) == via);
+
+    // On equal priority the most recently inserted object wins.
+    Gate_shptr gate2(new Gate(40, 60, 40, 60));
+    gate2->set_object_id(5);
+    index.insert(gate2);
+    REQUIRE(index.pick(45, 45) == gate2);
+    index.insert(gate);
+    REQUIRE(index.pick(45, 45) == gate);
+}
+
+TEST_CASE("Test pick index update", "[PickIndex]")
+{
+    PickIndex index(16);
+
+    Gate_shptr gate(new Gate(10, 20, 10, 20));
+    gate->set_object_id(1);
+    index.insert(gate);
+
+    REQUIRE(index.contains(1));
+    REQUIRE(index.pick(15, 15) == gate);
+
+    // Move the gate far away and make it big.
+    gate->set_position(500, 900, 500, 900);
+    index.insert(gate);
+
+    REQUIRE(index.get_objects_count() == 1);
+    REQUIRE(index.pick(15, 15) == nullptr);
+    REQUIRE(index.pick(700, 700) == gate);
+
+    index.remove(1);
+    REQUIRE_FALSE(index.contains(1));
+    REQUIRE(index.get_objects_count() == 0);
+    REQUIRE(index.pick(700, 700) == nullptr);
+
+    // Removing an unknown object does nothing.
+    index.remove(42);
+
+    index.insert(gate);
+    index.clear();
+    REQUIRE(index.get_objects_count() == 0);
+    REQUIRE(index.pick(700, 700) == nullptr);
+}
+
+TEST_CASE("Test pick index against linear search", "[PickIndex]")
+{
+    PickIndex index(16);
+    std::vector<PlacedLogicModelObject_shptr> objects;
+
+    srand(42);
+
+    for (object_id_t id = 1; id <= 500; id++)
+    {
+        const float x = static_cast<float>(rand() % 1000);
+        const float y = static_cast<float>(rand() % 1000);
+
+        PlacedLogicModelObject_shptr object;
+
+        switch (id % 3)
+        {
+        case 0:
+            object = std::make_shared<Gate>(x, x + rand() % 200, y, y + rand() % 200);
+            break;
+        case 1:
+            object = std::make_shared<Via>(x, y, 2 + rand() % 10);
+            break;
+        default:
+            object = std::make_shared<Wire>(x, y, static_cast<float>(rand() % 1000), static_cast<float>(rand() % 1000), 3);
+            break;
+        }
+
+        object->set_object_id(id);
+        objects.push_back(object);
+        index.insert(object);
+    }
+
+    for (unsigned int i = 0; i < 1000; i++)
+    {
+        const float x = static_cast<float>(rand() % 1200) - 100;
+        const float y = static_cast<float>(rand() % 1200) - 100;
+        const float distance = static_cast<float>(rand() % 4);
+
+        // Like a region query, only objects whose bounding box is near the position are
+        // considered. The last inserted object wins on equal priority.
+        const BoundingBox region(x - distance, x + distance, y - distance, y + distance);
+
+        PlacedLogicModelObject_shptr expected = nullptr;
+        for (auto const& object : objects)
+        {
+            if (object->get_bounding_box().intersects(region) &&
+                object->in_shape(x, y, distance) &&
+                (expected == nullptr ||
+                 PickIndex::get_pick_priority(object->get_object_kind()) <=
+                 PickIndex::get_pick_priority(expected->get_object_kind())))
+                expected = object;
+        }
+
+        REQUIRE(index.pick(x, y, distance) == expected);
+    }
+}
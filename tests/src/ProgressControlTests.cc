@@ -0,0 +1,115 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "Core/Utils/ProgressControl.h"
+
+#include "catch.hpp"
+
+#include <thread>
+#include <vector>
+
+using namespace degate;
+
+TEST_CASE("Test progress steps", "[ProgressControl]")
+{
+    ProgressControl progress;
+
+    REQUIRE(progress.get_progress() == 0);
+    REQUIRE(progress.get_time_left() == -1);
+
+    progress.set_progress_step_size(0.25);
+    progress.progress_step_done();
+    REQUIRE(progress.get_progress() == Approx(0.25));
+
+    progress.progress_steps_done(2);
+    REQUIRE(progress.get_progress() == Approx(0.75));
+
+    // Steps already done keep their size.
+    progress.set_progress_step_size(0.125);
+    progress.progress_step_done();
+    REQUIRE(progress.get_progress() == Approx(0.875));
+
+    progress.set_progress(0.5);
+    REQUIRE(progress.get_progress() == Approx(0.5));
+
+    // The progress is clamped.
+    progress.progress_steps_done(100);
+    REQUIRE(progress.get_progress() == 1.0);
+    REQUIRE(progress.get_time_left() == 0);
+
+    progress.reset_progress();
+    REQUIRE(progress.get_progress() == 0);
+}
+
+TEST_CASE("Test progress steps from several threads", "[ProgressControl]")
+{
+    const unsigned int thread_count = 8;
+    const unsigned int steps_per_thread = 10000;
+
+    ProgressControl progress;
+    progress.set_progress_step_size(1.0 / (thread_count * steps_per_thread));
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < thread_count; i++)
+    {
+        threads.push_back(std::thread([&progress]()
+        {
+            for (unsigned int step = 0; step < steps_per_thread; step++)
+                progress.progress_step_done();
+        }));
+    }
+
+    for (auto& thread : threads) thread.join();
+
+    REQUIRE(progress.get_progress() == Approx(1.0));
+}
+
+TEST_CASE("Test sub progress", "[ProgressControl]")
+{
+    ProgressControl progress;
+
+    ProgressControl_shptr first = progress.create_sub_progress(0.5);
+    ProgressControl_shptr second = progress.create_sub_progress(0.5);
+
+    first->set_progress(1.0);
+    REQUIRE(progress.get_progress() == Approx(0.5));
+
+    second->set_progress_step_size(0.5);
+    second->progress_step_done();
+    REQUIRE(progress.get_progress() == Approx(0.75));
+
+    // Canceling propagates to all sub progresses.
+    REQUIRE_FALSE(second->is_canceled());
+    progress.cancel();
+    REQUIRE(progress.is_canceled());
+    REQUIRE(first->is_canceled());
+    REQUIRE(second->is_canceled());
+
+    // A sub progress added after canceling is canceled too.
+    ProgressControl_shptr third = progress.create_sub_progress(0);
+    REQUIRE(third->is_canceled());
+
+    // Reset drops the sub progresses.
+    progress.reset_progress();
+    REQUIRE_FALSE(progress.is_canceled());
+    REQUIRE(progress.get_progress() == 0);
+}
@@ -22,9 +22,14 @@
 #include "Core/Project/ProjectImporter.h"
 #include "Core/Project/ProjectExporter.h"
 #include "Core/Project/Project.h"
+#include "Core/LogicModel/Via/Via.h"
+#include "Core/LogicModel/LogicModelHelper.h"
+#include "Core/Utils/FileSystem.h"
 
 #include "catch.hpp"
 
+#include <fstream>
+
 using namespace degate;
 
 TEST_CASE("Test project export", "[ProjectExporter]")
@@ -44,4 +49,201 @@ TEST_CASE("Test project export", "[ProjectExporter]")
      */
     ProjectExporter exporter;
     REQUIRE_NOTHROW(exporter.export_all("tests_files/test_project", prj));
-}
\ No newline at end of file
+}
+
+TEST_CASE("Test incremental project export", "[ProjectExporter]")
+{
+    ProjectImporter importer;
+
+    std::string filename("tests_files/test_project/project.xml");
+    Project_shptr prj(importer.import_all(filename));
+
+    REQUIRE(prj != nullptr);
+
+    LogicModel_shptr lmodel = prj->get_logic_model();
+
+    /*
+     * The first save writes a full checkpoint.
+     */
+    ProjectExporter exporter;
+    REQUIRE_NOTHROW(exporter.export_incremental("tests_files/test_project", prj));
+    REQUIRE(lmodel->get_journal()->get_entry_count() == 0);
+    REQUIRE(!file_exists("tests_files/test_project/lmodel.journal"));
+
+    /*
+     * The second save only appends the new via to the journal.
+     */
+    Via_shptr via(new Via(10, 20, 5));
+    lmodel->add_object(0, via);
+    object_id_t via_id = via->get_object_id();
+
+    REQUIRE(lmodel->get_journal()->has_changes());
+    REQUIRE_NOTHROW(exporter.export_incremental("tests_files/test_project", prj));
+    REQUIRE(lmodel->get_journal()->get_entry_count() == 1);
+    REQUIRE(!lmodel->get_journal()->has_changes());
+    REQUIRE(file_exists("tests_files/test_project/lmodel.journal"));
+
+    /*
+     * Reimport: the journal is replayed on top of the checkpoint.
+     */
+    Project_shptr reimported(importer.import_all(filename));
+    REQUIRE(reimported != nullptr);
+    REQUIRE(reimported->get_logic_model()->get_journal()->get_entry_count() == 1);
+
+    Via_shptr restored = std::dynamic_pointer_cast<Via>(reimported->get_logic_model()->get_object(via_id));
+    REQUIRE(restored != nullptr);
+    REQUIRE(restored->get_x() == via->get_x());
+    REQUIRE(restored->get_y() == via->get_y());
+
+    /*
+     * Leave the test project as it was.
+     */
+    reimported->get_logic_model()->remove_object(restored);
+    REQUIRE_NOTHROW(exporter.export_all("tests_files/test_project", reimported));
+    remove_file("tests_files/test_project/lmodel.journal");
+}
+
+TEST_CASE("Test journal replay of removed objects, nets and modules", "[ProjectExporter]")
+{
+    ProjectImporter importer;
+
+    std::string filename("tests_files/test_project/project.xml");
+    Project_shptr prj(importer.import_all(filename));
+
+    REQUIRE(prj != nullptr);
+
+    LogicModel_shptr lmodel = prj->get_logic_model();
+
+    ProjectExporter exporter;
+    REQUIRE_NOTHROW(exporter.export_incremental("tests_files/test_project", prj));
+
+    /*
+     * Each change is saved in its own journal entry.
+     */
+    Via_shptr v1(new Via(10, 20, 5));
+    Via_shptr v2(new Via(30, 40, 5));
+    Via_shptr v3(new Via(50, 60, 5));
+    lmodel->add_object(0, v1);
+    lmodel->add_object(0, v2);
+    lmodel->add_object(0, v3);
+    REQUIRE_NOTHROW(exporter.export_incremental("tests_files/test_project", prj));
+
+    // removed object
+    object_id_t v3_id = v3->get_object_id();
+    lmodel->remove_object(v3);
+    REQUIRE_NOTHROW(exporter.export_incremental("tests_files/test_project", prj));
+
+    // changed net
+    connect_objects(lmodel, ConnectedLogicModelObject_shptr(v1), ConnectedLogicModelObject_shptr(v2));
+    REQUIRE_NOTHROW(exporter.export_incremental("tests_files/test_project", prj));
+
+    // changed module hierarchy
+    Module_shptr module(new Module("journal_test"));
+    lmodel->get_main_module()->add_module(module);
+    lmodel->get_journal()->record_module_change();
+    REQUIRE_NOTHROW(exporter.export_incremental("tests_files/test_project", prj));
+
+    REQUIRE(lmodel->get_journal()->get_entry_count() == 4);
+
+    /*
+     * Reimport: all entries are replayed on top of the checkpoint.
+     */
+    Project_shptr reimported(importer.import_all(filename));
+    REQUIRE(reimported != nullptr);
+
+    LogicModel_shptr reimported_lmodel = reimported->get_logic_model();
+    REQUIRE(reimported_lmodel->get_journal()->get_entry_count() == 4);
+    REQUIRE(!reimported_lmodel->get_journal()->is_checkpoint_required());
+
+    REQUIRE_THROWS_AS(reimported_lmodel->get_object(v3_id), CollectionLookupException);
+
+    Via_shptr restored_v1 = std::dynamic_pointer_cast<Via>(reimported_lmodel->get_object(v1->get_object_id()));
+    Via_shptr restored_v2 = std::dynamic_pointer_cast<Via>(reimported_lmodel->get_object(v2->get_object_id()));
+    REQUIRE(restored_v1 != nullptr);
+    REQUIRE(restored_v2 != nullptr);
+    REQUIRE(restored_v1->get_net() != nullptr);
+    REQUIRE(restored_v1->get_net() == restored_v2->get_net());
+    REQUIRE(restored_v1->get_net()->size() == 2);
+
+    Module_shptr main_module = reimported_lmodel->get_main_module();
+    Module_shptr restored_module;
+    for (Module::module_collection::const_iterator iter = main_module->modules_begin();
+         iter != main_module->modules_end(); ++iter)
+    {
+        if ((*iter)->get_name() == "journal_test") restored_module = *iter;
+    }
+    REQUIRE(restored_module != nullptr);
+
+    /*
+     * Leave the test project as it was.
+     */
+    main_module->remove_module(restored_module);
+    reimported_lmodel->remove_object(restored_v1);
+    reimported_lmodel->remove_object(restored_v2);
+    REQUIRE_NOTHROW(exporter.export_all("tests_files/test_project", reimported));
+    remove_file("tests_files/test_project/lmodel.journal");
+}
+
+TEST_CASE("Test journal replay after an interrupted save", "[ProjectExporter]")
+{
+    ProjectImporter importer;
+
+    std::string filename("tests_files/test_project/project.xml");
+    Project_shptr prj(importer.import_all(filename));
+
+    REQUIRE(prj != nullptr);
+
+    LogicModel_shptr lmodel = prj->get_logic_model();
+
+    ProjectExporter exporter;
+    REQUIRE_NOTHROW(exporter.export_incremental("tests_files/test_project", prj));
+
+    Via_shptr v1(new Via(10, 20, 5));
+    lmodel->add_object(0, v1);
+    REQUIRE_NOTHROW(exporter.export_incremental("tests_files/test_project", prj));
+
+    /*
+     * Simulate a crash while the next entry was written.
+     */
+    {
+        std::ofstream journal("tests_files/test_project/lmodel.journal", std::ios::out | std::ios::app);
+        journal << "<journal-entry generation=\"";
+    }
+
+    Project_shptr reimported(importer.import_all(filename));
+    REQUIRE(reimported != nullptr);
+
+    LogicModel_shptr reimported_lmodel = reimported->get_logic_model();
+    REQUIRE(reimported_lmodel->get_journal()->get_entry_count() == 1);
+    REQUIRE(reimported_lmodel->get_journal()->is_checkpoint_required());
+
+    Via_shptr restored_v1 = std::dynamic_pointer_cast<Via>(reimported_lmodel->get_object(v1->get_object_id()));
+    REQUIRE(restored_v1 != nullptr);
+
+    /*
+     * The next save must not append to the broken entry, but write a full checkpoint.
+     */
+    Via_shptr v2(new Via(30, 40, 5));
+    reimported_lmodel->add_object(0, v2);
+    REQUIRE_NOTHROW(exporter.export_incremental("tests_files/test_project", reimported));
+    REQUIRE(!file_exists("tests_files/test_project/lmodel.journal"));
+
+    Project_shptr recovered(importer.import_all(filename));
+    REQUIRE(recovered != nullptr);
+
+    LogicModel_shptr recovered_lmodel = recovered->get_logic_model();
+    REQUIRE(!recovered_lmodel->get_journal()->is_checkpoint_required());
+
+    PlacedLogicModelObject_shptr recovered_v1 = recovered_lmodel->get_object(v1->get_object_id());
+    PlacedLogicModelObject_shptr recovered_v2 = recovered_lmodel->get_object(v2->get_object_id());
+    REQUIRE(recovered_v1 != nullptr);
+    REQUIRE(recovered_v2 != nullptr);
+
+    /*
+     * Leave the test project as it was.
+     */
+    recovered_lmodel->remove_object(recovered_v1);
+    recovered_lmodel->remove_object(recovered_v2);
+    REQUIRE_NOTHROW(exporter.export_all("tests_files/test_project", recovered));
+    remove_file("tests_files/test_project/lmodel.journal");
+}
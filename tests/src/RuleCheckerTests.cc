@@ -0,0 +1,197 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/RuleCheck/RuleChecker.h"
+#include "Core/RuleCheck/RCExecutor.h"
+#include "Core/LogicModel/LogicModelHelper.h"
+
+#include "catch.hpp"
+
+using namespace degate;
+
+static size_t count_violations(RCVContainer const& violations, std::string const& violation_class)
+{
+    size_t count = 0;
+    for (auto& v : violations)
+        if (v->get_rc_violation_class() == violation_class) count++;
+    return count;
+}
+
+static ConnectedLogicModelObject_shptr get_port(Gate_shptr gate, GateTemplatePort_shptr tmpl_port)
+{
+    return gate->get_port_by_template_port(tmpl_port);
+}
+
+static bool same_violations(RCVContainer const& a, RCVContainer const& b)
+{
+    if (a.size() != b.size()) return false;
+
+    auto b_iter = b.begin();
+    for (auto& v : a)
+    {
+        if (v->get_object() != (*b_iter)->get_object() ||
+            v->get_rc_violation_class() != (*b_iter)->get_rc_violation_class())
+            return false;
+        ++b_iter;
+    }
+
+    return true;
+}
+
+TEST_CASE("Test incremental rule checks", "[RuleChecker]")
+{
+    LogicModel_shptr lmodel(new LogicModel(100, 100));
+
+    GateTemplate_shptr tmpl(new GateTemplate(10, 10));
+    lmodel->add_gate_template(tmpl);
+
+    GateTemplatePort_shptr in_port(new GateTemplatePort(2, 2, GateTemplatePort::PORT_TYPE_IN));
+    GateTemplatePort_shptr out_port(new GateTemplatePort(8, 8, GateTemplatePort::PORT_TYPE_OUT));
+    in_port->set_object_id(lmodel->get_new_object_id());
+    out_port->set_object_id(lmodel->get_new_object_id());
+    lmodel->add_template_port_to_gate_template(tmpl, in_port);
+    lmodel->add_template_port_to_gate_template(tmpl, out_port);
+
+    std::vector<Gate_shptr> gates;
+    for (int i = 0; i < 3; i++)
+    {
+        Gate_shptr gate(new Gate(i * 20, i * 20 + 10, 0, 10, Gate::ORIENTATION_NORMAL));
+        lmodel->add_object(0, gate);
+        gate->set_gate_template(tmpl);
+        lmodel->update_ports(gate);
+        gates.push_back(gate);
+    }
+
+    RuleChecker checker;
+    checker.run(lmodel);
+    REQUIRE(count_violations(checker.get_rc_violations(), "open_port") == 6);
+
+    // feed gate 1 from gate 0
+    connect_objects(lmodel,
+                    get_port(gates[0], out_port),
+                    get_port(gates[1], in_port));
+
+    checker.run_incremental(lmodel);
+    REQUIRE(count_violations(checker.get_rc_violations(), "open_port") == 4);
+    REQUIRE(count_violations(checker.get_rc_violations(), "net.outputs_connected") == 0);
+
+    // connect a second output into the same net
+    connect_objects(lmodel,
+                    get_port(gates[2], out_port),
+                    get_port(gates[1], in_port));
+
+    checker.run_incremental(lmodel);
+    REQUIRE(count_violations(checker.get_rc_violations(), "open_port") == 3);
+    REQUIRE(count_violations(checker.get_rc_violations(), "net.outputs_connected") == 2);
+
+    // the incremental result matches a full run
+    RuleChecker full_checker;
+    full_checker.run(lmodel);
+    REQUIRE(full_checker.get_rc_violations().size() == checker.get_rc_violations().size());
+
+    // removing a gate drops its violations
+    lmodel->remove_object(gates[2]);
+    checker.run_incremental(lmodel);
+    REQUIRE(count_violations(checker.get_rc_violations(), "open_port") == 2);
+    REQUIRE(count_violations(checker.get_rc_violations(), "net.outputs_connected") == 0);
+}
+
+TEST_CASE("Test parallel rule checks", "[RuleChecker]")
+{
+    // Sharded executor against a serial loop.
+    const size_t count = 5000;
+    REQUIRE(RCExecutor::get_shard_count(count) > 1);
+
+    std::vector<Via_shptr> vias;
+    for (size_t i = 0; i < count; i++)
+    {
+        Via_shptr via(new Via(i, 0, 2));
+        via->set_object_id(i + 1);
+        vias.push_back(via);
+    }
+
+    auto task = [&vias](size_t i, RCVContainer& violations)
+    {
+        if (i % 7 == 0) violations.push_back(std::make_shared<RCViolation>(vias[i], "test"));
+        if (i % 11 == 0) violations.push_back(std::make_shared<RCViolation>(vias[i], "test2"));
+    };
+
+    RCVContainer parallel, serial;
+    RCExecutor::run(count, task, parallel);
+    for (size_t i = 0; i < count; i++) task(i, serial);
+
+    REQUIRE(parallel.size() == 715 + 455);
+    REQUIRE(same_violations(parallel, serial));
+
+    // Thousands of gates: triples of gates, where the first gate feeds the second one.
+    // In every other triple the third gate drives the same net.
+    LogicModel_shptr lmodel(new LogicModel(2000, 1000));
+
+    GateTemplate_shptr tmpl(new GateTemplate(10, 10));
+    lmodel->add_gate_template(tmpl);
+
+    GateTemplatePort_shptr in_port(new GateTemplatePort(2, 2, GateTemplatePort::PORT_TYPE_IN));
+    GateTemplatePort_shptr out_port(new GateTemplatePort(8, 8, GateTemplatePort::PORT_TYPE_OUT));
+    in_port->set_object_id(lmodel->get_new_object_id());
+    out_port->set_object_id(lmodel->get_new_object_id());
+    lmodel->add_template_port_to_gate_template(tmpl, in_port);
+    lmodel->add_template_port_to_gate_template(tmpl, out_port);
+
+    const int gate_count = 3000;
+
+    std::vector<Gate_shptr> gates;
+    for (int i = 0; i < gate_count; i++)
+    {
+        const int x = (i % 100) * 20;
+        const int y = (i / 100) * 20;
+
+        Gate_shptr gate(new Gate(x, x + 10, y, y + 10, Gate::ORIENTATION_NORMAL));
+        lmodel->add_object(0, gate);
+        gate->set_gate_template(tmpl);
+        lmodel->update_ports(gate);
+        gates.push_back(gate);
+    }
+
+    for (int i = 0; i < gate_count; i += 3)
+    {
+        connect_objects(lmodel,
+                        get_port(gates[i], out_port),
+                        get_port(gates[i + 1], in_port));
+
+        if (i % 6 == 0)
+        {
+            connect_objects(lmodel,
+                            get_port(gates[i + 2], out_port),
+                            get_port(gates[i + 1], in_port));
+        }
+    }
+
+    RuleChecker checker;
+    checker.run(lmodel);
+
+    REQUIRE(count_violations(checker.get_rc_violations(), "open_port") == 500 * 3 + 500 * 4);
+    REQUIRE(count_violations(checker.get_rc_violations(), "net.outputs_connected") == 500 * 2);
+
+    // The order of the violations does not depend on the thread scheduling.
+    RuleChecker second_checker;
+    second_checker.run(lmodel);
+    REQUIRE(same_violations(checker.get_rc_violations(), second_checker.get_rc_violations()));
+}
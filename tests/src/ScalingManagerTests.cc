@@ -48,4 +48,68 @@ TEST_CASE("Test scaling manager", "[ScalingManager]")
 
     ScalingManager<BackgroundImage> sm(img, img->get_directory(), 256);
     sm.create_scalings();
-}
\ No newline at end of file
+}
+
+TEST_CASE("Test image pyramid", "[ScalingManager]")
+{
+    // Tiles of 16x16 pixels and odd image sizes.
+    std::vector<TileImage_RGBA_shptr> levels;
+    levels.push_back(std::make_shared<TileImage_RGBA>(301, 203, 4));
+    for (unsigned int i = 1; i < 6; i++)
+        levels.push_back(std::make_shared<TileImage_RGBA>(levels[i - 1]->get_width() / 2,
+                                                          levels[i - 1]->get_height() / 2, 4));
+
+    for (unsigned int y = 0; y < 203; y++)
+        for (unsigned int x = 0; x < 301; x++)
+            levels[0]->set_pixel(x, y, MERGE_CHANNELS((x * 7 + y) & 0xff, (x ^ y) & 0xff, (x * y) & 0xff, 255));
+
+    auto check_levels = [&]()
+    {
+        for (unsigned int i = 1; i < levels.size(); i++)
+        {
+            auto expected = std::make_shared<MemoryImage_RGBA>(levels[i]->get_width(), levels[i]->get_height());
+            scale_down_by_2<MemoryImage_RGBA, TileImage_RGBA>(expected, levels[i - 1]);
+
+            for (unsigned int y = 0; y < expected->get_height(); y++)
+                for (unsigned int x = 0; x < expected->get_width(); x++)
+                    REQUIRE(levels[i]->get_pixel(x, y) == expected->get_pixel(x, y));
+        }
+    };
+
+    build_image_pyramid<TileImage_RGBA>(levels);
+    check_levels();
+
+    // Only the changed region is updated.
+    for (unsigned int y = 50; y < 70; y++)
+        for (unsigned int x = 100; x < 180; x++)
+            levels[0]->set_pixel(x, y, MERGE_CHANNELS(255, 0, 0, 255));
+
+    build_image_pyramid<TileImage_RGBA>(levels, 100, 180, 50, 70);
+    check_levels();
+}
+
+TEST_CASE("Test greyscale image pyramid", "[ScalingManager]")
+{
+    std::vector<TileImage_GS_BYTE_shptr> levels;
+    levels.push_back(std::make_shared<TileImage_GS_BYTE>(301, 203, 4));
+    for (unsigned int i = 1; i < 6; i++)
+        levels.push_back(std::make_shared<TileImage_GS_BYTE>(levels[i - 1]->get_width() / 2,
+                                                             levels[i - 1]->get_height() / 2, 4));
+
+    for (unsigned int y = 0; y < 203; y++)
+        for (unsigned int x = 0; x < 301; x++)
+            levels[0]->set_pixel(x, y, static_cast<gs_byte_pixel_t>((x * 7 + y * 3) & 0xff));
+
+    build_image_pyramid<TileImage_GS_BYTE>(levels);
+
+    // The greyscale pixels are averaged like the channels of RGBA pixels.
+    for (unsigned int i = 1; i < levels.size(); i++)
+    {
+        auto expected = std::make_shared<MemoryImage_GS_BYTE>(levels[i]->get_width(), levels[i]->get_height());
+        scale_down_by_2<MemoryImage_GS_BYTE, TileImage_GS_BYTE>(expected, levels[i - 1]);
+
+        for (unsigned int y = 0; y < expected->get_height(); y++)
+            for (unsigned int x = 0; x < expected->get_width(); x++)
+                REQUIRE(levels[i]->get_pixel(x, y) == expected->get_pixel(x, y));
+    }
+}
@@ -0,0 +1,650 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "Core/Image/Image.h"
+#include "Core/Image/TIFFReader.h"
+#include "Core/Image/ImageReader.h"
+#include "Core/Utils/FileSystem.h"
+
+#include "catch.hpp"
+
+#include <map>
+#include <fstream>
+
+#include <QByteArray>
+
+using namespace degate;
+
+/**
+ * Layout of a test image.
+ */
+struct test_tiff
+{
+    bool big_tiff = false;
+    bool big_endian = false;
+    unsigned int tile_size = 0; // 0 = strips
+    unsigned int rows_per_strip = 1;
+    unsigned int bits = 8;
+    unsigned int samples = 3;
+    unsigned int photometric = 2;
+    unsigned int compression = 1;
+    unsigned int predictor = 1;
+    unsigned int width = 37;
+    unsigned int height = 29;
+    bool write_samples = true; // false: empty chunks, only the directory is of interest
+};
+
+/**
+ * Get the value of a sample of the test pattern.
+ */
+static unsigned int test_sample(unsigned int x, unsigned int y, unsigned int s, unsigned int bits)
+{
+    const unsigned int v = (x * 7 + y * 13 + s * 50) & 0xff;
+    return bits == 16 ? (v << 8) | (x & 0xff) : v;
+}
+
+static void put(std::vector<uint8_t>& buf, uint64_t v, unsigned int size, bool big_endian)
+{
+    for (unsigned int i = 0; i < size; i++)
+        buf.push_back(static_cast<uint8_t>(v >> (8 * (big_endian ? size - 1 - i : i))));
+}
+
+/**
+ * Codes, that the LZW encoder has written.
+ */
+struct lzw_stats
+{
+    unsigned int clears = 0; // clear codes after the first one
+    unsigned int max_width = 0;
+};
+
+/**
+ * Encode data with TIFF LZW, like libtiff does: the code width grows one code early and
+ * the table is cleared when it is full.
+ */
+static std::vector<uint8_t> encode_lzw(std::vector<uint8_t> const& in, lzw_stats& stats)
+{
+    const unsigned int clear_code = 256, eoi_code = 257, first_code = 258, max_code = 4095;
+
+    std::vector<uint8_t> out;
+    uint32_t bit_buffer = 0;
+    unsigned int bit_count = 0, width = 9, next = first_code;
+
+    auto write_code = [&](unsigned int code)
+    {
+        bit_buffer = (bit_buffer << width) | code;
+        bit_count += width;
+        stats.max_width = std::max(stats.max_width, width);
+
+        while (bit_count >= 8)
+        {
+            out.push_back(static_cast<uint8_t>(bit_buffer >> (bit_count - 8)));
+            bit_count -= 8;
+        }
+    };
+
+    std::map<uint32_t, unsigned int> table;
+
+    auto add_code = [&]()
+    {
+        if (++next == max_code - 1)
+        {
+            write_code(clear_code);
+            stats.clears++;
+            table.clear();
+            next = first_code;
+            width = 9;
+        }
+        else if (next > (1u << width) - 1) width++;
+    };
+
+    write_code(clear_code);
+
+    int prefix = -1;
+    for (uint8_t c : in)
+    {
+        if (prefix < 0)
+        {
+            prefix = c;
+            continue;
+        }
+
+        const uint32_t key = (static_cast<uint32_t>(prefix) << 8) | c;
+        auto found = table.find(key);
+        if (found != table.end())
+        {
+            prefix = static_cast<int>(found->second);
+            continue;
+        }
+
+        write_code(static_cast<unsigned int>(prefix));
+        table[key] = next;
+        add_code();
+        prefix = c;
+    }
+
+    if (prefix >= 0)
+    {
+        write_code(static_cast<unsigned int>(prefix));
+        add_code();
+    }
+
+    write_code(eoi_code);
+    if (bit_count > 0) out.push_back(static_cast<uint8_t>(bit_buffer << (8 - bit_count)));
+
+    return out;
+}
+
+/**
+ * Encode data with PackBits. Runs of three or more bytes are repeated, the rest is copied.
+ */
+static std::vector<uint8_t> encode_packbits(std::vector<uint8_t> const& in)
+{
+    std::vector<uint8_t> out;
+
+    // A no-op code, decoders have to skip it.
+    out.push_back(0x80);
+
+    for (std::size_t pos = 0; pos < in.size();)
+    {
+        std::size_t run = 1;
+        while (pos + run < in.size() && run < 128 && in[pos + run] == in[pos]) run++;
+
+        if (run >= 3)
+        {
+            out.push_back(static_cast<uint8_t>(1 - static_cast<int>(run)));
+            out.push_back(in[pos]);
+            pos += run;
+            continue;
+        }
+
+        std::size_t literal = 0;
+        while (pos + literal < in.size() && literal < 128 &&
+               !(pos + literal + 2 < in.size() && in[pos + literal] == in[pos + literal + 1] &&
+                 in[pos + literal] == in[pos + literal + 2]))
+            literal++;
+
+        out.push_back(static_cast<uint8_t>(literal - 1));
+        out.insert(out.end(), in.begin() + pos, in.begin() + pos + literal);
+        pos += literal;
+    }
+
+    return out;
+}
+
+/**
+ * Encode data with Deflate (a zlib stream).
+ */
+static std::vector<uint8_t> encode_deflate(std::vector<uint8_t> const& in)
+{
+    // qCompress() puts the uncompressed size in front of the zlib stream.
+    QByteArray data = qCompress(in.data(), static_cast<int>(in.size()));
+    REQUIRE(data.size() > 4);
+
+    return std::vector<uint8_t>(data.constData() + 4, data.constData() + data.size());
+}
+
+/**
+ * Write a TIFF file with the test pattern.
+ */
+static void write_test_tiff(std::string const& filename, test_tiff const& t, lzw_stats* stats = nullptr)
+{
+    const unsigned int offset_size = t.big_tiff ? 8 : 4;
+    const unsigned int sample_size = t.bits / 8;
+
+    std::vector<uint8_t> buf;
+    buf.push_back(t.big_endian ? 'M' : 'I');
+    buf.push_back(t.big_endian ? 'M' : 'I');
+    put(buf, t.big_tiff ? 43 : 42, 2, t.big_endian);
+    if (t.big_tiff)
+    {
+        put(buf, 8, 2, t.big_endian);
+        put(buf, 0, 2, t.big_endian);
+    }
+    const std::size_t ifd_offset_pos = buf.size();
+    put(buf, 0, offset_size, t.big_endian);
+
+    // Chunk data.
+    const unsigned int chunk_w = t.tile_size ? t.tile_size : t.width;
+    const unsigned int chunk_h = t.tile_size ? t.tile_size : t.rows_per_strip;
+    const unsigned int chunks_x = (t.width + chunk_w - 1) / chunk_w;
+    const unsigned int chunks_y = (t.height + chunk_h - 1) / chunk_h;
+
+    lzw_stats lzw;
+
+    std::vector<uint64_t> offsets, byte_counts;
+    for (unsigned int cy = 0; cy < chunks_y && t.write_samples; cy++)
+        for (unsigned int cx = 0; cx < chunks_x; cx++)
+        {
+            // The last strip only has the remaining rows.
+            const unsigned int rows = t.tile_size ? chunk_h : std::min(chunk_h, t.height - cy * chunk_h);
+
+            std::vector<uint8_t> chunk;
+            for (unsigned int y = cy * chunk_h; y < cy * chunk_h + rows; y++)
+            {
+                std::vector<unsigned int> row;
+                for (unsigned int x = cx * chunk_w; x < cx * chunk_w + chunk_w; x++)
+                    for (unsigned int s = 0; s < t.samples; s++)
+                        row.push_back(x < t.width && y < t.height ? test_sample(x, y, s, t.bits) : 0);
+
+                // The horizontal predictor stores differences to the previous pixel of the row.
+                if (t.predictor == 2)
+                    for (std::size_t i = row.size() - 1; i >= t.samples; i--)
+                        row[i] = (row[i] - row[i - t.samples]) & ((1u << t.bits) - 1);
+
+                for (unsigned int v : row) put(chunk, v, sample_size, t.big_endian);
+            }
+
+            switch (t.compression)
+            {
+            case 5: chunk = encode_lzw(chunk, lzw); break;
+            case 8: chunk = encode_deflate(chunk); break;
+            case 32773: chunk = encode_packbits(chunk); break;
+            }
+
+            offsets.push_back(buf.size());
+            buf.insert(buf.end(), chunk.begin(), chunk.end());
+            byte_counts.push_back(chunk.size());
+        }
+
+    if (!t.write_samples)
+    {
+        offsets.assign(static_cast<std::size_t>(chunks_x) * chunks_y, buf.size());
+        byte_counts.assign(offsets.size(), 0);
+    }
+
+    if (stats != nullptr) *stats = lzw;
+
+    // Out of line arrays.
+    const std::size_t offsets_pos = buf.size();
+    for (uint64_t o : offsets) put(buf, o, offset_size, t.big_endian);
+    const std::size_t byte_counts_pos = buf.size();
+    for (uint64_t c : byte_counts) put(buf, c, offset_size, t.big_endian);
+    const std::size_t bits_pos = buf.size();
+    for (unsigned int s = 0; s < t.samples; s++) put(buf, t.bits, 2, t.big_endian);
+
+    const uint16_t long_type = t.big_tiff ? 16 : 4;
+
+    // Arrays with a single value are stored in the entry.
+    const uint64_t offsets_value = offsets.size() == 1 ? offsets[0] : offsets_pos;
+    const uint64_t byte_counts_value = byte_counts.size() == 1 ? byte_counts[0] : byte_counts_pos;
+
+    struct entry { uint16_t tag, type; uint64_t count, value; };
+    std::vector<entry> entries = {
+        {256, 4, 1, t.width},
+        {257, 4, 1, t.height},
+        {258, 3, t.samples, t.samples == 1 ? t.bits : bits_pos},
+        {259, 3, 1, t.compression},
+        {262, 3, 1, t.photometric},
+        {277, 3, 1, t.samples},
+    };
+
+    if (t.samples == 2 || t.samples == 4) entries.push_back({338, 3, 1, 2});
+    if (t.predictor != 1) entries.push_back({317, 3, 1, t.predictor});
+
+    if (t.tile_size)
+    {
+        entries.push_back({322, 3, 1, t.tile_size});
+        entries.push_back({323, 3, 1, t.tile_size});
+        entries.push_back({324, long_type, offsets.size(), offsets_value});
+        entries.push_back({325, long_type, byte_counts.size(), byte_counts_value});
+    }
+    else
+    {
+        entries.push_back({273, long_type, offsets.size(), offsets_value});
+        entries.push_back({278, 4, 1, t.rows_per_strip});
+        entries.push_back({279, long_type, byte_counts.size(), byte_counts_value});
+    }
+
+    std::sort(entries.begin(), entries.end(), [](entry const& a, entry const& b) { return a.tag < b.tag; });
+
+    // Directory.
+    const uint64_t ifd_offset = buf.size();
+    for (unsigned int i = 0; i < offset_size; i++)
+        buf[ifd_offset_pos + i] = static_cast<uint8_t>(ifd_offset >> (8 * (t.big_endian ? offset_size - 1 - i : i)));
+
+    put(buf, entries.size(), t.big_tiff ? 8 : 2, t.big_endian);
+    for (entry const& e : entries)
+    {
+        put(buf, e.tag, 2, t.big_endian);
+        put(buf, e.type, 2, t.big_endian);
+        put(buf, e.count, offset_size, t.big_endian);
+
+        // Values, that fit into the entry, are stored left aligned.
+        const unsigned int type_size = e.type == 3 ? 2 : (e.type == 4 ? 4 : 8);
+        if (e.tag == 258 && t.samples * 2 <= offset_size)
+        {
+            for (unsigned int i = 0; i < t.samples; i++) put(buf, t.bits, 2, t.big_endian);
+            put(buf, 0, offset_size - t.samples * 2, t.big_endian);
+        }
+        else if (e.count == 1)
+        {
+            put(buf, e.value, type_size, t.big_endian);
+            put(buf, 0, offset_size - type_size, t.big_endian);
+        }
+        else put(buf, e.value, offset_size, t.big_endian);
+    }
+    put(buf, 0, offset_size, t.big_endian);
+
+    std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary);
+    file.write(reinterpret_cast<const char*>(buf.data()), static_cast<std::streamsize>(buf.size()));
+}
+
+/**
+ * Remove a temporary file or directory at the end of a scope.
+ */
+struct temp_path
+{
+    std::string path;
+
+    explicit temp_path(std::string const& path) : path(path) {}
+
+    ~temp_path()
+    {
+        if (is_directory(path)) remove_directory(path);
+        else if (file_exists(path)) remove_file(path);
+    }
+};
+
+static void check_test_image(BackgroundImage_shptr img, test_tiff const& t)
+{
+    for (unsigned int y = 0; y < t.height; y++)
+        for (unsigned int x = 0; x < t.width; x++)
+        {
+            rgba_pixel_t p = img->get_pixel(x, y);
+            const unsigned int shift = t.bits == 16 ? 8 : 0;
+
+            if (t.photometric == 2)
+            {
+                REQUIRE(MASK_R(p) == test_sample(x, y, 0, t.bits) >> shift);
+                REQUIRE(MASK_G(p) == test_sample(x, y, 1, t.bits) >> shift);
+                REQUIRE(MASK_B(p) == test_sample(x, y, 2, t.bits) >> shift);
+                REQUIRE(MASK_A(p) == (t.samples == 4 ? test_sample(x, y, 3, t.bits) >> shift : 255));
+            }
+            else
+            {
+                unsigned int v = test_sample(x, y, 0, t.bits) >> shift;
+                if (t.photometric == 0) v = 255 - v;
+
+                REQUIRE(MASK_R(p) == v);
+                REQUIRE(MASK_G(p) == v);
+                REQUIRE(MASK_B(p) == v);
+                REQUIRE(MASK_A(p) == (t.samples == 2 ? test_sample(x, y, 1, t.bits) >> shift : 255));
+            }
+        }
+}
+
+static void read_and_check(test_tiff const& t, lzw_stats* stats = nullptr)
+{
+    temp_path filename(get_temp_file_path() + ".tif");
+    write_test_tiff(filename.path, t, stats);
+
+    REQUIRE(TIFFReader::is_tiff(filename.path));
+    REQUIRE(TIFFReader::is_supported(filename.path));
+
+    TIFFReader reader(filename.path);
+    REQUIRE(reader.get_width() == t.width);
+    REQUIRE(reader.get_height() == t.height);
+    REQUIRE(reader.is_tiled() == (t.tile_size > 0));
+
+    temp_path dir(create_temp_directory()), dir2(create_temp_directory());
+    BackgroundImage_shptr img = std::make_shared<BackgroundImage>(t.width, t.height, dir.path, false, 4);
+
+    // A tiny memory limit forces a single worker.
+    read_tiff<BackgroundImage>(reader, img, 1);
+    check_test_image(img, t);
+
+    BackgroundImage_shptr img2 = std::make_shared<BackgroundImage>(t.width, t.height, dir2.path, false, 4);
+    read_tiff<BackgroundImage>(reader, img2);
+    check_test_image(img2, t);
+}
+
+TEST_CASE("Test native TIFF reader", "[TIFFReader]")
+{
+    test_tiff t;
+
+    SECTION("RGB strips") { read_and_check(t); }
+
+    SECTION("RGB tiles")
+    {
+        t.tile_size = 16;
+        read_and_check(t);
+    }
+
+    SECTION("RGBA 16 bit big endian BigTIFF tiles")
+    {
+        t.big_tiff = true;
+        t.big_endian = true;
+        t.tile_size = 16;
+        t.bits = 16;
+        t.samples = 4;
+        read_and_check(t);
+    }
+
+    SECTION("Greyscale 16 bit BigTIFF strips")
+    {
+        t.big_tiff = true;
+        t.bits = 16;
+        t.samples = 1;
+        t.photometric = 1;
+        read_and_check(t);
+    }
+
+    SECTION("Greyscale with alpha, big endian")
+    {
+        t.big_endian = true;
+        t.samples = 2;
+        t.photometric = 1;
+        read_and_check(t);
+    }
+
+    SECTION("Inverted greyscale")
+    {
+        t.samples = 1;
+        t.photometric = 0;
+        read_and_check(t);
+    }
+}
+
+TEST_CASE("Test native TIFF reader with compression", "[TIFFReader]")
+{
+    test_tiff t;
+    t.rows_per_strip = 8; // the last strip is shorter
+
+    SECTION("LZW")
+    {
+        // Enough data in a strip to grow the codes to 12 bit and to fill the code table.
+        t.compression = 5;
+        t.width = 256;
+        t.height = 64;
+        t.rows_per_strip = 48;
+
+        lzw_stats stats;
+        read_and_check(t, &stats);
+        REQUIRE(stats.max_width == 12);
+        REQUIRE(stats.clears > 0);
+    }
+
+    SECTION("LZW tiles, 16 bit greyscale")
+    {
+        t.compression = 5;
+        t.tile_size = 16;
+        t.bits = 16;
+        t.samples = 1;
+        t.photometric = 1;
+        read_and_check(t);
+    }
+
+    SECTION("PackBits")
+    {
+        t.compression = 32773;
+        read_and_check(t);
+    }
+
+    SECTION("PackBits with predictor")
+    {
+        // The differences are constant, so there are long runs.
+        t.compression = 32773;
+        t.predictor = 2;
+        t.samples = 1;
+        t.photometric = 1;
+        read_and_check(t);
+    }
+
+    SECTION("Deflate tiles")
+    {
+        t.compression = 8;
+        t.tile_size = 16;
+        read_and_check(t);
+    }
+
+    SECTION("Deflate with predictor, 8 bit")
+    {
+        t.compression = 8;
+        t.predictor = 2;
+        read_and_check(t);
+    }
+
+    SECTION("LZW with predictor, 16 bit big endian")
+    {
+        t.compression = 5;
+        t.predictor = 2;
+        t.bits = 16;
+        t.samples = 4;
+        t.big_endian = true;
+        read_and_check(t);
+    }
+
+    SECTION("Uncompressed single strip with predictor, 16 bit")
+    {
+        t.predictor = 2;
+        t.bits = 16;
+        t.rows_per_strip = t.height;
+        read_and_check(t);
+    }
+}
+
+TEST_CASE("Test native TIFF reader into greyscale images", "[TIFFReader]")
+{
+    test_tiff t;
+    t.samples = 1;
+    t.photometric = 1;
+
+    SECTION("8 bit strips") {}
+    SECTION("16 bit tiles")
+    {
+        t.tile_size = 16;
+        t.bits = 16;
+    }
+    SECTION("Inverted") { t.photometric = 0; }
+
+    temp_path filename(get_temp_file_path() + ".tif"), dir(create_temp_directory());
+    write_test_tiff(filename.path, t);
+
+    TIFFReader reader(filename.path);
+    REQUIRE(reader.is_greyscale());
+
+    GreyscaleBackgroundImage_shptr img =
+        std::make_shared<GreyscaleBackgroundImage>(t.width, t.height, dir.path, false, 4);
+    read_tiff<GreyscaleBackgroundImage>(reader, img);
+
+    const unsigned int shift = t.bits == 16 ? 8 : 0;
+    for (unsigned int y = 0; y < t.height; y++)
+        for (unsigned int x = 0; x < t.width; x++)
+        {
+            unsigned int v = test_sample(x, y, 0, t.bits) >> shift;
+            if (t.photometric == 0) v = 255 - v;
+
+            REQUIRE(img->get_pixel(x, y) == v);
+        }
+
+    // Colour images have no greyscale chunks.
+    test_tiff rgb;
+    write_test_tiff(filename.path, rgb);
+
+    TIFFReader rgb_reader(filename.path);
+    REQUIRE(rgb_reader.is_greyscale() == false);
+
+    std::vector<gs_byte_pixel_t> pixels;
+    REQUIRE_THROWS_AS(rgb_reader.read_chunk(0, pixels), DegateLogicException);
+}
+
+TEST_CASE("Test native TIFF reader with image reader", "[TIFFReader]")
+{
+    test_tiff t;
+    t.tile_size = 16;
+
+    temp_path filename(get_temp_file_path() + ".tif"), dir(create_temp_directory());
+    write_test_tiff(filename.path, t);
+
+    ImageReader<BackgroundImage> reader(filename.path);
+    REQUIRE(reader.read());
+    REQUIRE(reader.get_width() == t.width);
+    REQUIRE(reader.get_height() == t.height);
+
+    BackgroundImage_shptr img = std::make_shared<BackgroundImage>(t.width, t.height, dir.path, false, 4);
+    REQUIRE(reader.get_image(img));
+    check_test_image(img, t);
+}
+
+TEST_CASE("Test native TIFF reader rejects unsupported files", "[TIFFReader]")
+{
+    temp_path temp(get_temp_file_path() + ".tif");
+    std::string const& filename = temp.path;
+
+    {
+        std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary);
+        file << "P6 1 1 255 abc";
+    }
+
+    REQUIRE(TIFFReader::is_tiff(filename) == false);
+    REQUIRE(TIFFReader::is_supported(filename) == false);
+    REQUIRE_THROWS_AS(TIFFReader(filename), DegateRuntimeException);
+
+    // 32 bit samples are not supported.
+    test_tiff t;
+    t.samples = 1;
+    t.photometric = 1;
+    t.bits = 32;
+    write_test_tiff(filename, t);
+    REQUIRE(TIFFReader::is_tiff(filename) == true);
+    REQUIRE(TIFFReader::is_supported(filename) == false);
+
+    // Compressed strips can't be split, very large ones are rejected.
+    test_tiff huge;
+    huge.samples = 1;
+    huge.photometric = 1;
+    huge.compression = 5;
+    huge.width = 16384;
+    huge.height = TIFF_MAX_COMPRESSED_CHUNK_PIXELS / huge.width + 1;
+    huge.rows_per_strip = huge.height;
+    huge.write_samples = false;
+    write_test_tiff(filename, huge);
+    REQUIRE(TIFFReader::is_supported(filename) == false);
+    REQUIRE_THROWS_AS(TIFFReader(filename), DegateRuntimeException);
+
+    // Uncompressed strips of the same size are split into chunks.
+    huge.compression = 1;
+    write_test_tiff(filename, huge);
+    TIFFReader reader(filename);
+    REQUIRE(reader.get_chunks().size() > 1);
+}
@@ -0,0 +1,125 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "Core/Utils/Trace.h"
+#include "Core/Utils/FileSystem.h"
+
+#include "catch.hpp"
+
+#include <fstream>
+#include <sstream>
+
+using namespace degate;
+
+static void traced_function()
+{
+    TRACE_SCOPE("test/traced-function");
+    TRACE_COUNT("test/calls", 1);
+}
+
+TEST_CASE("Test disabled tracing", "[Trace]")
+{
+    Trace& trace = Trace::get_instance();
+    trace.set_enabled(false);
+    trace.reset();
+
+    traced_function();
+
+    REQUIRE(trace.get_span_statistics().empty());
+    REQUIRE(trace.get_counter_values()["test/calls"] == 0);
+}
+
+TEST_CASE("Test enabled tracing", "[Trace]")
+{
+    Trace& trace = Trace::get_instance();
+    trace.reset();
+    trace.set_enabled(true);
+
+    for (unsigned int i = 0; i < 3; i++)
+        traced_function();
+
+    trace.set_enabled(false);
+
+    Trace::span_statistics_type statistics = trace.get_span_statistics();
+    REQUIRE(statistics.count("test/traced-function") == 1);
+
+    TraceSpanStatistics const& function_statistics = statistics["test/traced-function"];
+    REQUIRE(function_statistics.count == 3);
+    REQUIRE(function_statistics.min_ms <= function_statistics.max_ms);
+    REQUIRE(function_statistics.get_mean_ms() <= function_statistics.max_ms);
+
+    REQUIRE(trace.get_counter_values()["test/calls"] == 3);
+
+    trace.reset();
+
+    REQUIRE(trace.get_span_statistics().empty());
+    REQUIRE(trace.get_counter_values()["test/calls"] == 0);
+}
+
+TEST_CASE("Test trace event limit", "[Trace]")
+{
+    Trace& trace = Trace::get_instance();
+    trace.reset();
+    trace.set_max_events(2);
+    trace.set_enabled(true);
+
+    for (unsigned int i = 0; i < 5; i++)
+        traced_function();
+
+    trace.set_enabled(false);
+
+    // Aggregated timings are not limited.
+    REQUIRE(trace.get_span_statistics()["test/traced-function"].count == 5);
+    REQUIRE(trace.get_dropped_events() == 3);
+
+    trace.set_max_events(1000000);
+    trace.reset();
+}
+
+TEST_CASE("Test chrome trace export", "[Trace]")
+{
+    Trace& trace = Trace::get_instance();
+    trace.reset();
+    trace.set_enabled(true);
+
+    traced_function();
+
+    trace.set_enabled(false);
+
+    std::string filename = get_temp_file_path() + ".json";
+    trace.export_chrome_trace(filename);
+
+    REQUIRE(file_exists(filename));
+
+    std::ifstream file(filename);
+    std::stringstream content;
+    content << file.rdbuf();
+
+    REQUIRE(content.str().find("\"traceEvents\"") != std::string::npos);
+    REQUIRE(content.str().find("test/traced-function") != std::string::npos);
+    REQUIRE(content.str().find("test/calls") != std::string::npos);
+
+    remove_file(filename);
+    trace.reset();
+
+    REQUIRE_THROWS_AS(trace.export_chrome_trace("/nonexistent/directory/trace.json"), InvalidPathException);
+}
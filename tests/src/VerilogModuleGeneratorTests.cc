@@ -0,0 +1,128 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/Generator/VerilogModuleGenerator.h"
+#include "Core/LogicModel/LogicModel.h"
+
+#include "catch.hpp"
+
+#include <sstream>
+
+using namespace degate;
+
+static size_t count_occurrences(std::string const& str, std::string const& pattern)
+{
+    size_t count = 0;
+    for (size_t pos = str.find(pattern); pos != std::string::npos; pos = str.find(pattern, pos + 1))
+        count++;
+    return count;
+}
+
+/**
+ * Get the names of all module definitions in the order of the netlist.
+ */
+static std::vector<std::string> get_module_definitions(std::string const& netlist)
+{
+    std::vector<std::string> names;
+    std::istringstream is(netlist);
+
+    for (std::string line; std::getline(is, line);)
+    {
+        if (line.compare(0, 7, "module ") == 0)
+            names.push_back(line.substr(7, line.find(' ', 7) - 7));
+    }
+
+    return names;
+}
+
+TEST_CASE("Test Verilog netlist generation", "[VerilogModuleGenerator]")
+{
+    LogicModel_shptr lmodel(new LogicModel(100, 100));
+
+    GateTemplate_shptr tmpl(new GateTemplate(10, 10));
+    tmpl->set_name("inv");
+    lmodel->add_gate_template(tmpl);
+
+    // main module -> a -> b, each with a gate
+    Module_shptr main_module = lmodel->get_main_module();
+    Module_shptr a(new Module("a"));
+    Module_shptr b(new Module("b"));
+    main_module->add_module(a);
+    a->add_module(b);
+
+    for (auto& module : { main_module, a, b })
+    {
+        Gate_shptr gate(new Gate(0, 10, 0, 10, Gate::ORIENTATION_NORMAL));
+        lmodel->add_object(0, gate);
+        gate->set_gate_template(tmpl);
+        gate->set_name("g_" + module->get_name());
+
+        main_module->remove_gate(gate);
+        module->add_gate(gate, false);
+    }
+
+    VerilogModuleGenerator codegen(main_module);
+
+    std::ostringstream os;
+    codegen.generate(os);
+    const std::string netlist = os.str();
+
+    // the streamed netlist equals the string version
+    REQUIRE(netlist == codegen.generate());
+
+    // every module is defined once, sub-modules before their parents
+    REQUIRE(count_occurrences(netlist, "module dg_b (") == 1);
+    REQUIRE(count_occurrences(netlist, "module dg_a (") == 1);
+    REQUIRE(netlist.find("module dg_b (") < netlist.find("module dg_a ("));
+
+    // and each sub-module is placed in its parent
+    REQUIRE(count_occurrences(netlist, "  dg_b b (") == 1);
+    REQUIRE(count_occurrences(netlist, "  dg_a a (") == 1);
+}
+
+TEST_CASE("Test Verilog sub-module definitions", "[VerilogModuleGenerator]")
+{
+    LogicModel_shptr lmodel(new LogicModel(100, 100));
+
+    // main module -> a -> b -> c and main module -> d
+    Module_shptr main_module = lmodel->get_main_module();
+    Module_shptr a(new Module("a"));
+    Module_shptr b(new Module("b"));
+    Module_shptr c(new Module("c"));
+    Module_shptr d(new Module("d"));
+    main_module->add_module(a);
+    a->add_module(b);
+    b->add_module(c);
+    main_module->add_module(d);
+
+    VerilogModuleGenerator codegen(main_module);
+    const std::string netlist = codegen.generate();
+
+    // Each sub-module is defined exactly once, children first, followed by the main module.
+    // Before, a sub-module definition was repeated by every ancestor (here c four times and b twice).
+    std::vector<std::string> definitions = get_module_definitions(netlist);
+    REQUIRE(definitions.size() == 5);
+    REQUIRE(definitions[0] == "dg_c");
+    REQUIRE(definitions[1] == "dg_b");
+    REQUIRE(definitions[2] == "dg_a");
+    REQUIRE(definitions[3] == "dg_d");
+    REQUIRE(count_occurrences(netlist, "module " + definitions[4] + " (") == 1);
+}